@@ -0,0 +1,1160 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <ujson.hpp>
+#include "../utils/option-parser.hpp"
+
+
+using namespace std;
+namespace fs = filesystem;
+namespace uj = ujson;
+
+static constexpr const char* prog_name = "ujson-bench";
+
+
+//------------------------------------------------------------------------------
+// Count all allocations made by the global operator new.
+//------------------------------------------------------------------------------
+static atomic<size_t> alloc_count {0};
+static atomic<size_t> alloc_bytes {0};
+
+static void* counted_alloc (size_t size)
+{
+    alloc_count.fetch_add (1, memory_order_relaxed);
+    alloc_bytes.fetch_add (size, memory_order_relaxed);
+    void* ptr = malloc (size ? size : 1);
+    if (ptr == nullptr)
+        throw bad_alloc ();
+    return ptr;
+}
+
+void* operator new (size_t size) {return counted_alloc (size);}
+void* operator new[] (size_t size) {return counted_alloc (size);}
+void* operator new (size_t size, const nothrow_t&) noexcept
+{
+    try {return counted_alloc (size);} catch (...) {return nullptr;}
+}
+void* operator new[] (size_t size, const nothrow_t&) noexcept
+{
+    try {return counted_alloc (size);} catch (...) {return nullptr;}
+}
+void operator delete (void* ptr) noexcept {free (ptr);}
+void operator delete[] (void* ptr) noexcept {free (ptr);}
+void operator delete (void* ptr, size_t) noexcept {free (ptr);}
+void operator delete[] (void* ptr, size_t) noexcept {free (ptr);}
+void operator delete (void* ptr, const nothrow_t&) noexcept {free (ptr);}
+void operator delete[] (void* ptr, const nothrow_t&) noexcept {free (ptr);}
+
+
+struct appargs_t {
+    unsigned iterations;
+    double scale;
+    string corpus_dir;
+    vector<string> files;
+
+    appargs_t () {
+        iterations = 5;
+        scale = 1.0;
+    }
+};
+
+
+// A document to benchmark
+struct document_t {
+    string name;
+    string text;
+    bool ndjson;
+};
+
+
+// The result of one benchmark
+struct measurement_t {
+    double seconds {0};     // Best time of all iterations
+    size_t allocations {0}; // Allocations in one iteration
+    size_t allocated {0};   // Allocated bytes in one iteration
+    long peak_rss {0};      // Peak RSS in KiB while running the benchmark
+};
+
+
+// A record of the generated 'logs' document, read by ujson::from_json
+struct log_record_t {
+    long ts {0};
+    string level;
+    string host;
+    double latency {0};
+    bool ok {false};
+    string msg;
+    optional<vector<string>> tags;
+};
+template<> struct uj::jbind<log_record_t> {
+    static constexpr auto fields = std::make_tuple (
+        uj::jfield ("ts",      &log_record_t::ts),
+        uj::jfield ("level",   &log_record_t::level),
+        uj::jfield ("host",    &log_record_t::host),
+        uj::jfield ("latency", &log_record_t::latency),
+        uj::jfield ("ok",      &log_record_t::ok),
+        uj::jfield ("msg",     &log_record_t::msg),
+        uj::jfield ("tags",    &log_record_t::tags));
+};
+
+
+static void print_usage_and_exit (ostream& out, int exit_code);
+static void parse_args (int argc, char* argv[], appargs_t& args);
+static void generate_corpus (vector<document_t>& corpus, double scale);
+static bool load_file (const string& filename, document_t& doc);
+static uj::jvalue run_benchmarks (const document_t& doc, const appargs_t& args);
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int main (int argc, char* argv[])
+{
+    appargs_t args;
+    parse_args (argc, argv, args);
+
+    vector<document_t> corpus;
+    if (args.files.empty()) {
+        generate_corpus (corpus, args.scale);
+    }else{
+        for (auto& filename : args.files) {
+            document_t doc;
+            if (!load_file(filename, doc)) {
+                cerr << "Error: Unable to read file '" << filename << "'" << endl;
+                return 1;
+            }
+            corpus.emplace_back (std::move(doc));
+        }
+    }
+
+    // Only write the corpus to files
+    //
+    if (!args.corpus_dir.empty()) {
+        for (auto& doc : corpus) {
+            auto filename = fs::path(args.corpus_dir) / (doc.name + (doc.ndjson ? ".ndjson" : ".json"));
+            ofstream out (filename, ios_base::out|ios_base::trunc);
+            out << doc.text;
+            if (out.fail()) {
+                cerr << "Error writing file '" << filename.string() << "'" << endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    uj::jvalue result (uj::j_object);
+    result["version"] = UJSON_VERSION_STRING;
+    result["gmpxx"] = UJSON_HAVE_GMPXX ? true : false;
+    result["iterations"] = (long) args.iterations;
+    auto& documents = result["documents"];
+    documents.type (uj::j_array);
+    for (auto& doc : corpus) {
+        cerr << prog_name << ": " << doc.name << endl;
+        documents.append (run_benchmarks(doc, args));
+    }
+
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    result["peak_rss_kb"] = (long) usage.ru_maxrss;
+
+    result.write (cout, uj::fmt_pretty);
+    cout << endl;
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// A deterministic pseudo random number generator (xorshift64*),
+// the generated corpus is the same on all platforms.
+//------------------------------------------------------------------------------
+class random_t {
+public:
+    random_t (uint64_t seed) : state {seed} {}
+
+    uint64_t next () {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+    long range (long min, long max) {
+        return min + (long)(next() % (uint64_t)(max - min + 1));
+    }
+    double real (double min, double max) {
+        return min + (max - min) * ((next() >> 11) * (1.0 / 9007199254740992.0));
+    }
+    bool chance (unsigned percent) {
+        return next() % 100 < percent;
+    }
+    std::string word () {
+        static const char* const words[] = {
+            "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+            "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+            "et", "dolore", "magna", "aliqua", "\xc3\xa5r", "\xe6\x97\xa5\xe6\x9c\xac",
+            "caf\xc3\xa9", "\"quoted\"", "back\\slash", "http://example.com/a/b",
+        };
+        return words[next() % (sizeof(words)/sizeof(words[0]))];
+    }
+    std::string text (unsigned min_words, unsigned max_words) {
+        std::string str;
+        for (long n=range(min_words, max_words); n>0; --n) {
+            if (!str.empty())
+                str.push_back (chance(5) ? '\n' : ' ');
+            str.append (word());
+        }
+        return str;
+    }
+
+private:
+    uint64_t state;
+};
+
+
+//------------------------------------------------------------------------------
+// Status messages from a social network search API.
+//------------------------------------------------------------------------------
+static string make_twitter (double scale)
+{
+    random_t rnd (1);
+    uj::jvalue statuses (uj::j_array);
+    for (long i=0, count=max(1L, lround(100*scale)); i<count; ++i) {
+        long id = 505874924095815681L + rnd.range (0, 1000000);
+        uj::jvalue user (uj::j_object);
+        user["id"] = rnd.range (1000000, 3000000000L);
+        user["name"] = rnd.text (1, 3);
+        user["screen_name"] = rnd.word ();
+        user["location"] = rnd.chance(50) ? uj::jvalue(rnd.text(1, 2)) : uj::jvalue("");
+        user["description"] = rnd.text (5, 25);
+        user["url"] = rnd.chance(30) ? uj::jvalue("http://t.co/" + to_string(rnd.next() % 100000)) : uj::jvalue(uj::j_null);
+        user["protected"] = false;
+        user["followers_count"] = rnd.range (0, 100000);
+        user["friends_count"] = rnd.range (0, 5000);
+        user["created_at"] = "Sun Jun 22 04:58:02 +0000 2014";
+        user["verified"] = rnd.chance (5);
+        user["profile_image_url"] = "http://pbs.twimg.com/profile_images/" + to_string(rnd.next() % 1000000) + "/normal.jpeg";
+        user["entities"] = uj::jvalue (uj::j_object);
+        user["entities"]["description"] = uj::jvalue (uj::j_object);
+        user["entities"]["description"]["urls"] = uj::jvalue (uj::j_array);
+
+        uj::jvalue mentions (uj::j_array);
+        for (long n=rnd.range(0, 3); n>0; --n) {
+            uj::jvalue m (uj::j_object);
+            m["screen_name"] = rnd.word ();
+            m["name"] = rnd.text (1, 2);
+            m["id"] = rnd.range (1000000, 3000000000L);
+            m["indices"] = uj::json_array {uj::jvalue(rnd.range(0, 20)), uj::jvalue(rnd.range(20, 40))};
+            mentions.append (std::move(m));
+        }
+
+        uj::jvalue status (uj::j_object);
+        status["metadata"] = uj::jvalue (uj::j_object);
+        status["metadata"]["result_type"] = "recent";
+        status["metadata"]["iso_language_code"] = "ja";
+        status["created_at"] = "Sun Aug 31 00:29:15 +0000 2014";
+        status["id"] = id;
+        status["id_str"] = to_string (id);
+        status["text"] = rnd.text (3, 30);
+        status["source"] = "<a href=\"http://twitter.com/download/iphone\" rel=\"nofollow\">Twitter for iPhone</a>";
+        status["truncated"] = false;
+        status["in_reply_to_status_id"] = uj::jvalue (uj::j_null);
+        status["user"] = std::move (user);
+        status["geo"] = uj::jvalue (uj::j_null);
+        status["coordinates"] = uj::jvalue (uj::j_null);
+        status["retweet_count"] = rnd.range (0, 500);
+        status["favorite_count"] = rnd.range (0, 500);
+        status["entities"] = uj::jvalue (uj::j_object);
+        status["entities"]["hashtags"] = uj::jvalue (uj::j_array);
+        status["entities"]["symbols"] = uj::jvalue (uj::j_array);
+        status["entities"]["urls"] = uj::jvalue (uj::j_array);
+        status["entities"]["user_mentions"] = std::move (mentions);
+        status["favorited"] = false;
+        status["retweeted"] = false;
+        status["lang"] = "ja";
+        statuses.append (std::move(status));
+    }
+    uj::jvalue root (uj::j_object);
+    root["statuses"] = std::move (statuses);
+    root["search_metadata"] = uj::jvalue (uj::j_object);
+    root["search_metadata"]["completed_in"] = 0.087;
+    root["search_metadata"]["max_id"] = 505874924095815681L;
+    root["search_metadata"]["query"] = "%E4%B8%80";
+    root["search_metadata"]["count"] = 100;
+    return root.describe ();
+}
+
+
+//------------------------------------------------------------------------------
+// A GeoJSON polygon with many coordinates given with full precision.
+//------------------------------------------------------------------------------
+static string make_canada (double scale)
+{
+    random_t rnd (2);
+    uj::jvalue coordinates (uj::j_array);
+    for (long ring=0, rings=max(1L, lround(480*scale)); ring<rings; ++ring) {
+        uj::jvalue points (uj::j_array);
+        for (long n=rnd.range(20, 220); n>0; --n)
+            points.append (uj::json_array {rnd.real(-141.0, -52.0), rnd.real(41.0, 83.0)});
+        coordinates.append (std::move(points));
+    }
+    uj::jvalue feature (uj::j_object);
+    feature["type"] = "Feature";
+    feature["properties"] = uj::jvalue (uj::j_object);
+    feature["properties"]["name"] = "Canada";
+    feature["geometry"] = uj::jvalue (uj::j_object);
+    feature["geometry"]["type"] = "Polygon";
+    feature["geometry"]["coordinates"] = std::move (coordinates);
+
+    uj::jvalue root (uj::j_object);
+    root["type"] = "FeatureCollection";
+    root["features"] = uj::json_array {std::move(feature)};
+    return root.describe ();
+}
+
+
+//------------------------------------------------------------------------------
+// A catalog of events, with many objects using numbers as member names.
+//------------------------------------------------------------------------------
+static string make_citm_catalog (double scale)
+{
+    random_t rnd (3);
+
+    uj::jvalue area_names (uj::j_object);
+    for (long n=0; n<17; ++n)
+        area_names[to_string(205705993 + n)] = rnd.text (1, 3);
+
+    uj::jvalue events (uj::j_object);
+    vector<long> event_ids;
+    for (long i=0, count=max(1L, lround(184*scale)); i<count; ++i) {
+        long id = 138586341 + i * 7;
+        event_ids.push_back (id);
+        uj::jvalue event (uj::j_object);
+        event["description"] = uj::jvalue (uj::j_null);
+        event["id"] = id;
+        event["logo"] = rnd.chance(50) ? uj::jvalue("/images/UE0AAAAACEKo6QAAAAZDSVRN") : uj::jvalue(uj::j_null);
+        event["name"] = rnd.text (1, 5);
+        event["subTopicIds"] = uj::json_array {uj::jvalue(337184269L), uj::jvalue(337184283L + rnd.range(0, 100))};
+        event["subjectCode"] = uj::jvalue (uj::j_null);
+        event["subtitle"] = uj::jvalue (uj::j_null);
+        event["topicIds"] = uj::json_array {uj::jvalue(324846099L), uj::jvalue(107888604L)};
+        events[to_string(id)] = std::move (event);
+    }
+
+    uj::jvalue performances (uj::j_array);
+    for (long i=0, count=max(1L, lround(243*scale)); i<count; ++i) {
+        uj::jvalue prices (uj::j_array);
+        uj::jvalue seat_categories (uj::j_array);
+        for (long n=rnd.range(1, 6); n>0; --n) {
+            long seat_category = 338937295L + rnd.range (0, 1000);
+            uj::jvalue price (uj::j_object);
+            price["amount"] = rnd.range (10000, 200000);
+            price["audienceSubCategoryId"] = 337100890L;
+            price["seatCategoryId"] = seat_category;
+            prices.append (std::move(price));
+
+            uj::jvalue areas (uj::j_array);
+            for (long a=rnd.range(1, 10); a>0; --a) {
+                uj::jvalue area (uj::j_object);
+                area["areaId"] = 205705993L + rnd.range (0, 16);
+                area["blockIds"] = uj::jvalue (uj::j_array);
+                areas.append (std::move(area));
+            }
+            uj::jvalue category (uj::j_object);
+            category["areas"] = std::move (areas);
+            category["seatCategoryId"] = seat_category;
+            seat_categories.append (std::move(category));
+        }
+        uj::jvalue performance (uj::j_object);
+        performance["eventId"] = event_ids[rnd.next() % event_ids.size()];
+        performance["id"] = 339887544L + i;
+        performance["logo"] = uj::jvalue (uj::j_null);
+        performance["name"] = uj::jvalue (uj::j_null);
+        performance["prices"] = std::move (prices);
+        performance["seatCategories"] = std::move (seat_categories);
+        performance["seatMapImage"] = uj::jvalue (uj::j_null);
+        performance["start"] = 1372701600000L + rnd.range (0, 100000000);
+        performance["venueCode"] = "PLEYEL_PLEYEL";
+        performances.append (std::move(performance));
+    }
+
+    uj::jvalue root (uj::j_object);
+    root["areaNames"] = std::move (area_names);
+    root["events"] = std::move (events);
+    root["performances"] = std::move (performances);
+    return root.describe ();
+}
+
+
+//------------------------------------------------------------------------------
+// Deeply nested arrays and objects.
+//------------------------------------------------------------------------------
+static string make_deep (double scale)
+{
+    static constexpr unsigned depth = 100;
+    random_t rnd (4);
+    string text = "[";
+    for (long i=0, count=max(1L, lround(1000*scale)); i<count; ++i) {
+        if (i)
+            text.push_back (',');
+        for (unsigned d=0; d<depth; ++d)
+            text.append ((d & 1) ? "{\"a\":" : "[");
+        text.append (to_string(rnd.range(0, 1000000)));
+        for (unsigned d=depth; d>0; --d)
+            text.append (((d-1) & 1) ? "}" : "]");
+    }
+    text.append ("]");
+    return text;
+}
+
+
+//------------------------------------------------------------------------------
+// Newline delimited log records.
+//------------------------------------------------------------------------------
+static string make_logs (double scale)
+{
+    static const char* const levels[] = {"debug", "info", "warning", "error"};
+    random_t rnd (5);
+    string text;
+    for (long i=0, count=max(1L, lround(100000*scale)); i<count; ++i) {
+        uj::jvalue record (uj::j_object);
+        record["ts"] = 1700000000000L + i;
+        record["level"] = levels[rnd.next() % 4];
+        record["host"] = "node-" + to_string (rnd.range(1, 64));
+        record["latency"] = rnd.real (0.0, 250.0);
+        record["ok"] = rnd.chance (95);
+        record["msg"] = rnd.text (2, 12);
+        if (rnd.chance(20))
+            record["tags"] = uj::json_array {rnd.word(), rnd.word()};
+        record.write (text);
+        text.push_back ('\n');
+    }
+    return text;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void generate_corpus (vector<document_t>& corpus, double scale)
+{
+    corpus.push_back ({"twitter",      make_twitter(scale),      false});
+    corpus.push_back ({"canada",       make_canada(scale),       false});
+    corpus.push_back ({"citm_catalog", make_citm_catalog(scale), false});
+    corpus.push_back ({"deep",         make_deep(scale),         false});
+    corpus.push_back ({"logs",         make_logs(scale),         true});
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static bool load_file (const string& filename, document_t& doc)
+{
+    ifstream in (filename);
+    if (!in)
+        return false;
+    stringstream ss;
+    ss << in.rdbuf ();
+    if (in.bad())
+        return false;
+
+    auto path = fs::path (filename);
+    auto ext = path.extension().string ();
+    doc.name = path.stem().string ();
+    doc.text = ss.str ();
+    doc.ndjson = ext==".ndjson" || ext==".jsonl";
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Reset the peak RSS of the process, if supported (Linux).
+//------------------------------------------------------------------------------
+static void reset_peak_rss ()
+{
+    ofstream clear_refs ("/proc/self/clear_refs");
+    if (clear_refs)
+        clear_refs << "5" << flush;
+}
+
+
+//------------------------------------------------------------------------------
+// Get the peak RSS in KiB.
+//------------------------------------------------------------------------------
+static long peak_rss ()
+{
+    ifstream status ("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return atol (line.c_str() + 6);
+    }
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+
+//------------------------------------------------------------------------------
+// Run a benchmark a number of times. 'setup' is called before
+// each run and is not part of the measured time.
+//------------------------------------------------------------------------------
+static measurement_t measure (unsigned iterations,
+                              const function<void()>& setup,
+                              const function<void()>& run)
+{
+    measurement_t m;
+    reset_peak_rss ();
+    for (unsigned i=0; i<iterations; ++i) {
+        if (setup)
+            setup ();
+        size_t count = alloc_count;
+        size_t bytes = alloc_bytes;
+        auto start = chrono::steady_clock::now ();
+        run ();
+        double seconds = chrono::duration<double> (chrono::steady_clock::now() - start).count ();
+        if (i == 0) {
+            m.seconds = seconds;
+            m.allocations = alloc_count - count;
+            m.allocated = alloc_bytes - bytes;
+        }else{
+            m.seconds = min (m.seconds, seconds);
+        }
+    }
+    m.peak_rss = peak_rss ();
+    return m;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static double round3 (double value)
+{
+    return round (value * 1000.0) / 1000.0;
+}
+
+
+//------------------------------------------------------------------------------
+// Build a copy of a value item by item, with jvalue::append() and
+// jvalue::add(), or with reserved arrays and ujson::jobject_builder.
+//------------------------------------------------------------------------------
+static uj::jvalue build_copy (const uj::jvalue& value, bool reserved)
+{
+    if (value.type() == uj::j_array) {
+        uj::jvalue array (uj::j_array);
+        if (reserved)
+            array.reserve (value.size());
+        for (auto& item : value.array()) {
+            if (reserved)
+                array.emplace_back (build_copy(item, reserved));
+            else
+                array.append (build_copy(item, reserved));
+        }
+        return array;
+    }
+    if (value.type() == uj::j_object) {
+        if (reserved) {
+            uj::jobject_builder builder (value.size());
+            for (auto& member : value.obj())
+                builder.add (member.first, build_copy(member.second, reserved));
+            return builder.build ();
+        }
+        uj::jvalue object (uj::j_object);
+        for (auto& member : value.obj())
+            object.add (member.first, build_copy(member.second, reserved));
+        return object;
+    }
+    return value;
+}
+
+
+//------------------------------------------------------------------------------
+// Describe a measurement. Throughput is given in MB/s of 'bytes',
+// or in operations per second if 'ops' is not 0.
+//------------------------------------------------------------------------------
+static uj::jvalue to_jvalue (const measurement_t& m, size_t bytes, size_t ops=0)
+{
+    uj::jvalue result (uj::j_object);
+    result["seconds"] = m.seconds;
+    if (ops)
+        result["ops_per_sec"] = round3 (m.seconds>0 ? ops/m.seconds : 0);
+    else
+        result["mb_per_sec"] = round3 (m.seconds>0 ? bytes/m.seconds/1e6 : 0);
+    result["allocations"] = (long) m.allocations;
+    result["allocated_bytes"] = (long) m.allocated;
+    result["peak_rss_kb"] = m.peak_rss;
+    return result;
+}
+
+
+//------------------------------------------------------------------------------
+// Collect pointers to all values that are not containers.
+//------------------------------------------------------------------------------
+static void collect_pointers (uj::jvalue& value,
+                              uj::jpointer& pointer,
+                              vector<uj::jpointer>& pointers,
+                              size_t max_pointers)
+{
+    if (pointers.size() >= max_pointers)
+        return;
+    if (value.type() == uj::j_object) {
+        for (auto& member : value.obj()) {
+            pointer.push_back (member.first);
+            collect_pointers (member.second, pointer, pointers, max_pointers);
+            pointer.pop_back ();
+        }
+    }
+    else if (value.type() == uj::j_array) {
+        auto& elements = value.array ();
+        for (size_t i=0; i<elements.size(); ++i) {
+            pointer.push_back (to_string(i));
+            collect_pointers (elements[i], pointer, pointers, max_pointers);
+            pointer.pop_back ();
+        }
+    }
+    else {
+        pointers.push_back (pointer);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Merge two inferred schemas into one that both instances are valid against.
+//------------------------------------------------------------------------------
+static void merge_schema (uj::jvalue& schema, uj::jvalue& other)
+{
+    auto& types = schema["type"];
+    for (auto& type : other["type"].array()) {
+        auto& a = types.array ();
+        if (find(a.begin(), a.end(), type) == a.end())
+            types.append (type);
+    }
+
+    for (auto name : {"items", "additionalProperties"}) {
+        if (!other.has(name))
+            continue;
+        if (schema.has(name))
+            merge_schema (schema[name], other[name]);
+        else
+            schema[name] = other[name];
+    }
+
+    if (!other.has("properties"))
+        return;
+    if (!schema.has("properties")) {
+        schema["properties"] = other["properties"];
+        schema["required"] = other["required"];
+        return;
+    }
+    auto& properties = schema["properties"];
+    for (auto& property : other["properties"].obj()) {
+        const std::string& name = property.first;
+        if (properties.has(name))
+            merge_schema (properties[name], property.second);
+        else
+            properties[name] = property.second;
+    }
+    // Only members present in both are required
+    uj::jvalue required (uj::j_array);
+    for (auto& name : schema["required"].array()) {
+        auto& other_required = other["required"].array ();
+        if (find(other_required.begin(), other_required.end(), name) != other_required.end())
+            required.append (name);
+    }
+    schema["required"] = std::move (required);
+}
+
+
+//------------------------------------------------------------------------------
+// Create a schema that a JSON instance is valid against.
+//------------------------------------------------------------------------------
+static uj::jvalue infer_schema (uj::jvalue& value)
+{
+    // Members of 'schema' are built as separate values and moved in,
+    // a reference to a member is invalidated when another member is
+    // added if objects are stored in a ujson::flat_multimap_list.
+    static constexpr size_t max_properties = 32;
+    uj::jvalue schema (uj::j_object);
+    schema["type"] = uj::jvalue (uj::j_array);
+    switch (value.type()) {
+    case uj::j_object: {
+        schema["type"].append ("object");
+        auto& members = value.obj ();
+        if (members.size() > max_properties) {
+            // Many members, assume they are of the same kind
+            uj::jvalue additional;
+            for (auto& member : members) {
+                auto member_schema = infer_schema (member.second);
+                if (additional.type() == uj::j_object)
+                    merge_schema (additional, member_schema);
+                else
+                    additional = std::move (member_schema);
+            }
+            schema["additionalProperties"] = std::move (additional);
+            break;
+        }
+        uj::jvalue properties (uj::j_object);
+        uj::jvalue required (uj::j_array);
+        for (auto& member : members) {
+            const std::string& name = member.first;
+            if (!properties.has(name)) {
+                properties[name] = infer_schema (member.second);
+                required.append (name);
+            }
+        }
+        schema["properties"] = std::move (properties);
+        schema["required"] = std::move (required);
+        break;
+    }
+    case uj::j_array: {
+        schema["type"].append ("array");
+        uj::jvalue items;
+        for (auto& element : value.array()) {
+            auto element_schema = infer_schema (element);
+            if (items.type() == uj::j_object)
+                merge_schema (items, element_schema);
+            else
+                items = std::move (element_schema);
+        }
+        if (items.type() == uj::j_object)
+            schema["items"] = std::move (items);
+        break;
+    }
+    case uj::j_string:
+        schema["type"].append ("string");
+        break;
+    case uj::j_number:
+        schema["type"].append ("number");
+        break;
+    case uj::j_bool:
+        schema["type"].append ("boolean");
+        break;
+    default:
+        schema["type"].append ("null");
+        break;
+    }
+    return schema;
+}
+
+
+//------------------------------------------------------------------------------
+// Create a patch replacing, adding, testing and removing values.
+//------------------------------------------------------------------------------
+static uj::jvalue make_patch (uj::jvalue& instance,
+                              const vector<uj::jpointer>& pointers,
+                              size_t max_ops)
+{
+    uj::jvalue patch (uj::j_array);
+    size_t step = max ((size_t)1, pointers.size() / max_ops);
+    for (size_t i=0; i<pointers.size() && patch.size()<max_ops; i+=step) {
+        auto path = pointers[i].str ();
+        uj::jvalue op (uj::j_object);
+        switch (i % 3) {
+        case 0:
+            op["op"] = "replace";
+            op["path"] = path;
+            op["value"] = "replaced";
+            patch.append (std::move(op));
+            break;
+        case 1:
+            op["op"] = "copy";
+            op["from"] = path;
+            op["path"] = path;
+            patch.append (std::move(op));
+            break;
+        default:
+            op["op"] = "test";
+            op["path"] = path;
+            op["value"] = uj::find_jvalue (instance, pointers[i]);
+            patch.append (std::move(op));
+        }
+    }
+    return patch;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static uj::jvalue run_line_benchmarks (const document_t& doc,
+                                       const appargs_t& args,
+                                       uj::jvalue& benchmarks,
+                                       const string& filename)
+{
+    uj::jparser parser;
+    size_t lines = 0;
+    auto handler = [&lines](unsigned, uj::jvalue&, const uj::jparser::error_t&) {
+        ++lines;
+        return true;
+    };
+
+    auto m = measure (args.iterations, nullptr, [&]() {
+            parser.parse_lines (doc.text.data(), doc.text.size(), handler, true, true, 1);
+        });
+    benchmarks["parse_buffer"] = to_jvalue (m, doc.text.size());
+
+    m = measure (args.iterations, nullptr, [&]() {
+            parser.parse_lines_file (filename, handler, true, true, 1);
+        });
+    benchmarks["parse_file"] = to_jvalue (m, doc.text.size());
+
+    m = measure (args.iterations, nullptr, [&]() {
+            parser.parse_lines (doc.text.data(), doc.text.size(), handler, true, true, 0);
+        });
+    benchmarks["parse_parallel"] = to_jvalue (m, doc.text.size());
+
+    // Parse each line as a separate message, with a new
+    // parser for each message, and with a pooled parser
+    //
+    vector<std::string_view> messages;
+    for (size_t pos=0, end; pos < doc.text.size(); pos=end+1) {
+        end = doc.text.find ('\n', pos);
+        if (end == string::npos)
+            end = doc.text.size ();
+        if (end > pos)
+            messages.emplace_back (doc.text.data()+pos, end-pos);
+    }
+    m = measure (args.iterations, nullptr, [&]() {
+            for (auto& msg : messages) {
+                uj::jparser message_parser;
+                message_parser.parse_buffer (msg.data(), msg.size());
+            }
+        });
+    benchmarks["parse_messages"] = to_jvalue (m, doc.text.size(), messages.size());
+
+    uj::jparser_pool pool;
+    m = measure (args.iterations, nullptr, [&]() {
+            for (auto& msg : messages) {
+                auto message_parser = pool.acquire ();
+                message_parser->parse_buffer (msg.data(), msg.size());
+            }
+        });
+    benchmarks["parse_messages_pooled"] = to_jvalue (m, doc.text.size(), messages.size());
+
+    // Read the records of the generated logs into structs, by
+    // extracting the members of parsed values, and directly
+    //
+    if (doc.name == "logs") {
+        vector<log_record_t> log_records (messages.size());
+        m = measure (args.iterations, nullptr, [&]() {
+                auto message_parser = pool.acquire ();
+                for (size_t i=0; i<messages.size(); ++i) {
+                    auto value = message_parser->parse_buffer (messages[i].data(), messages[i].size());
+                    auto& r = log_records[i];
+                    r.ts = (long) value.get("ts").num ();
+                    r.level = value.get("level").str ();
+                    r.host = value.get("host").str ();
+                    r.latency = value.get("latency").num ();
+                    r.ok = value.get("ok").boolean ();
+                    r.msg = value.get("msg").str ();
+                    auto& tags = value.get ("tags");
+                    if (tags.type() == uj::j_array) {
+                        r.tags.emplace ();
+                        for (auto& tag : tags.array())
+                            r.tags->emplace_back (tag.str());
+                    }else{
+                        r.tags.reset ();
+                    }
+                }
+            });
+        benchmarks["parse_messages_extract"] = to_jvalue (m, doc.text.size(), messages.size());
+
+        m = measure (args.iterations, nullptr, [&]() {
+                for (size_t i=0; i<messages.size(); ++i)
+                    uj::from_json (messages[i], log_records[i]);
+            });
+        benchmarks["from_json"] = to_jvalue (m, doc.text.size(), messages.size());
+
+        size_t bytes = 0;
+        string out;
+        m = measure (args.iterations, nullptr, [&]() {
+                bytes = 0;
+                for (auto& r : log_records) {
+                    out.clear ();
+                    uj::to_json (r, out);
+                    bytes += out.size ();
+                }
+            });
+        benchmarks["to_json"] = to_jvalue (m, bytes, log_records.size());
+    }
+
+    // Serialize all records
+    //
+    vector<uj::jvalue> records;
+    parser.parse_lines (doc.text.data(), doc.text.size(),
+                        [&records](unsigned, uj::jvalue& value, const uj::jparser::error_t&) {
+                            records.emplace_back (std::move(value));
+                            return true;
+                        });
+    for (auto fmt : {uj::fmt_none, uj::fmt_pretty}) {
+        size_t bytes = 0;
+        string out;
+        m = measure (args.iterations, nullptr, [&]() {
+                bytes = 0;
+                for (auto& record : records) {
+                    out.clear ();
+                    record.write (out, fmt);
+                    bytes += out.size ();
+                }
+            });
+        benchmarks[fmt==uj::fmt_none ? "describe_compact" : "describe_pretty"] = to_jvalue (m, bytes);
+    }
+
+    uj::jvalue result (uj::j_object);
+    result["lines"] = (long) records.size ();
+    return result;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static uj::jvalue run_benchmarks (const document_t& doc, const appargs_t& args)
+{
+    static constexpr size_t max_pointers = 10000;
+    static constexpr size_t max_patch_ops = 100;
+
+    uj::jvalue result (uj::j_object);
+    result["name"] = doc.name;
+    result["size"] = (long) doc.text.size ();
+    auto& benchmarks = result["benchmarks"];
+    benchmarks.type (uj::j_object);
+
+    // parse_file needs the document in a file
+    //
+    auto filename = (fs::temp_directory_path() / (string(prog_name) + "-" + to_string(getpid()) + ".json")).string ();
+    {
+        ofstream out (filename, ios_base::out|ios_base::trunc);
+        out << doc.text;
+    }
+
+    if (doc.ndjson) {
+        auto info = run_line_benchmarks (doc, args, benchmarks, filename);
+        result["lines"] = info["lines"];
+        fs::remove (filename);
+        return result;
+    }
+
+    // Parse
+    //
+    uj::jparser parser;
+    uj::jvalue instance;
+    auto m = measure (args.iterations, nullptr, [&]() {
+            instance = parser.parse_buffer (doc.text.data(), doc.text.size());
+        });
+    if (!instance.valid()) {
+        cerr << prog_name << ": Unable to parse " << doc.name << ": " << parser.error() << endl;
+        fs::remove (filename);
+        result["error"] = parser.error ();
+        return result;
+    }
+    benchmarks["parse_buffer"] = to_jvalue (m, doc.text.size());
+
+    m = measure (args.iterations, nullptr, [&]() {
+            instance = parser.parse_file (filename);
+        });
+    benchmarks["parse_file"] = to_jvalue (m, doc.text.size());
+    fs::remove (filename);
+
+    // Serialize
+    //
+    for (auto fmt : {uj::fmt_none, uj::fmt_pretty}) {
+        size_t bytes = 0;
+        m = measure (args.iterations, nullptr, [&]() {
+                bytes = instance.describe(fmt).size ();
+            });
+        benchmarks[fmt==uj::fmt_none ? "describe_compact" : "describe_pretty"] = to_jvalue (m, bytes);
+    }
+    {
+        size_t bytes = 0;
+        m = measure (args.iterations, nullptr, [&]() {
+                bytes = instance.describe(uj::fmt_pretty, 0, 0).size ();
+            });
+        benchmarks["describe_pretty_parallel"] = to_jvalue (m, bytes);
+    }
+
+    // Build a copy of the document
+    //
+    for (bool reserved : {false, true}) {
+        m = measure (args.iterations, nullptr, [&]() {
+                build_copy (instance, reserved);
+            });
+        benchmarks[reserved ? "build_reserved" : "build_add"] = to_jvalue (m, doc.text.size());
+    }
+
+    // CBOR encoding and decoding
+    //
+    string cbor;
+    m = measure (args.iterations, nullptr, [&]() {
+            cbor.clear ();
+            uj::to_cbor (instance, cbor);
+        });
+    benchmarks["to_cbor"] = to_jvalue (m, cbor.size());
+
+    uj::jvalue decoded;
+    m = measure (args.iterations, nullptr, [&]() {
+            decoded = uj::from_cbor (cbor.data(), cbor.size());
+        });
+    benchmarks["from_cbor"] = to_jvalue (m, cbor.size());
+
+    // JSON pointer lookup
+    //
+    vector<uj::jpointer> pointers;
+    uj::jpointer pointer;
+    collect_pointers (instance, pointer, pointers, max_pointers);
+    size_t found = 0;
+    m = measure (args.iterations, nullptr, [&]() {
+            found = 0;
+            for (auto& p : pointers)
+                found += uj::find_jvalue(instance, p).valid() ? 1 : 0;
+        });
+    benchmarks["jpointer_lookup"] = to_jvalue (m, 0, max(found, (size_t)1));
+
+    // Tape format, and JSON pointer lookup in a tape
+    //
+    string tape_data;
+    m = measure (args.iterations, nullptr, [&]() {
+            tape_data.clear ();
+            uj::to_tape (instance, tape_data);
+        });
+    benchmarks["to_tape"] = to_jvalue (m, tape_data.size());
+
+    uj::jtape tape (tape_data.data(), tape_data.size());
+    m = measure (args.iterations, nullptr, [&]() {
+            found = 0;
+            for (auto& p : pointers)
+                found += tape.find(p).valid() ? 1 : 0;
+        });
+    benchmarks["tape_lookup"] = to_jvalue (m, 0, max(found, (size_t)1));
+
+    // Patch, on a copy of the instance that is made before each run
+    //
+    auto patch = make_patch (instance, pointers, max_patch_ops);
+    if (patch.size()) {
+        uj::jvalue copy;
+        m = measure (args.iterations,
+                     [&]() {copy = instance;},
+                     [&]() {uj::patch (copy, patch);});
+        benchmarks["patch"] = to_jvalue (m, 0, patch.size());
+    }
+
+    // Schema validation
+    //
+    uj::jschema schema (infer_schema(instance));
+    bool valid = false;
+    m = measure (args.iterations, nullptr, [&]() {
+            valid = schema.validate(instance, true)["valid"].boolean ();
+        });
+    benchmarks["jschema_validate"] = to_jvalue (m, doc.text.size());
+    benchmarks["jschema_validate"]["valid"] = valid;
+
+    m = measure (args.iterations, nullptr, [&]() {
+            valid = schema.is_valid (instance);
+        });
+    benchmarks["jschema_is_valid"] = to_jvalue (m, doc.text.size());
+    benchmarks["jschema_is_valid"]["valid"] = valid;
+
+    return result;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void print_usage_and_exit (ostream& out, int exit_code)
+{
+    out << endl;
+    out << "Usage: " << prog_name << " [OPTIONS] [FILE ...]" << endl;
+    out << endl;
+    out << "Benchmark parsing, serialization, CBOR encoding and decoding, JSON pointer" << endl;
+    out << "lookup in JSON instances and tapes, JSON patch and JSON schema validation," << endl;
+    out << "and print the results as a JSON document." << endl;
+    out << "If no files are given, a built-in corpus of generated documents is used." << endl;
+    out << "Files ending in .ndjson or .jsonl are parsed as newline delimited JSON." << endl;
+    out << endl;
+    out << "Options:" << endl;
+    out << "  -n, --iterations=N   Run each benchmark N times and report the best time." << endl;
+    out << "                       Default is 5." << endl;
+    out << "  -s, --scale=FACTOR   Scale the size of the generated documents. Default is 1." << endl;
+    out << "  -w, --write-corpus=DIR" << endl;
+    out << "                       Write the documents to directory DIR and exit." << endl;
+    out << "  -h, --help           Print this help message and exit." << endl;
+    out << endl;
+    exit (exit_code);
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void parse_args (int argc, char* argv[], appargs_t& args)
+{
+    optlist_t options = {
+        { 'n', "iterations",   opt_t::required, 0},
+        { 's', "scale",        opt_t::required, 0},
+        { 'w', "write-corpus", opt_t::required, 0},
+        { 'h', "help",         opt_t::none,     0},
+    };
+
+    option_parser opt (argc, argv);
+    while (int id = opt(options)) {
+        try {
+            switch (id) {
+            case 'n':
+                args.iterations = (unsigned) stoul (opt.optarg());
+                if (args.iterations == 0)
+                    throw invalid_argument ("iterations");
+                break;
+            case 's':
+                args.scale = stod (opt.optarg());
+                if (!(args.scale > 0))
+                    throw invalid_argument ("scale");
+                break;
+            case 'w':
+                args.corpus_dir = opt.optarg ();
+                break;
+            case 'h':
+                print_usage_and_exit (cout, 0);
+                break;
+            case -1:
+                cerr << "Error: Unknown option: '" << opt.opt() << "'" << endl;
+                exit (1);
+                break;
+            case -2:
+                cerr << "Error: Missing argument to option '" << opt.opt() << "'" << endl;
+                exit (1);
+                break;
+            }
+        }
+        catch (...) {
+            cerr << "Error: Invalid argument to option '" << opt.opt() << "'" << endl;
+            exit (1);
+        }
+    }
+    args.files = opt.arguments ();
+}
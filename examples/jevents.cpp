@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson.hpp>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+
+using namespace std;
+
+
+//
+// Print each parser event with an indentation
+// reflecting the nesting level of the JSON document.
+//
+class event_printer : public ujson::jreader::handler {
+public:
+    bool on_begin_object () override {
+        print ("begin object");
+        ++depth;
+        return true;
+    }
+    bool on_key (std::string_view name) override {
+        print ("key", name);
+        return true;
+    }
+    bool on_end_object () override {
+        --depth;
+        print ("end object");
+        return true;
+    }
+    bool on_begin_array () override {
+        print ("begin array");
+        ++depth;
+        return true;
+    }
+    bool on_end_array () override {
+        --depth;
+        print ("end array");
+        return true;
+    }
+    bool on_string (std::string_view str) override {
+        print ("string", str);
+        return true;
+    }
+    bool on_number (std::string_view num) override {
+        print ("number", num);
+        return true;
+    }
+    bool on_bool (bool value) override {
+        print ("boolean", value ? "true" : "false");
+        return true;
+    }
+    bool on_null () override {
+        print ("null");
+        return true;
+    }
+
+private:
+    void print (std::string_view event, std::string_view data="") {
+        cout << string(depth*4, ' ') << event;
+        if (!data.empty())
+            cout << ": ==>" << data << "<==";
+        cout << endl;
+    }
+    unsigned depth {0};
+};
+
+
+
+int main (int argc, char* argv[])
+{
+    if (argc < 2) {
+        cerr << "Usage: jevents [-s,--strict] <json-file>" << endl;
+        return 1;
+    }
+
+    bool strict = false;
+    std::string file_name = argv[1];
+    if (argc > 2) {
+        std::string option = std::string (argv[1]);
+        if (option=="-s" || option=="--strict") {
+            strict = true;
+        }else{
+            cerr << "Usage: jevents [-s,--strict] <json-file>" << endl;
+            return 1;
+        }
+        file_name = argv[2];
+    }
+
+    ujson::jreader reader;
+    event_printer printer;
+    if (!reader.parse_file(printer, file_name, strict)) {
+        cerr << "Error: " << reader.error() << endl;
+        return 1;
+    }
+
+    return 0;
+}
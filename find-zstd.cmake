@@ -0,0 +1,36 @@
+# Allow user to set ZSTD_ROOT_DIR to a custom libzstd installation directory
+#
+set (ZSTD_ROOT_HINTS ${ZSTD_ROOT_DIR} ENV ZSTD_ROOT_DIR)
+
+# Set ZSTD_INCLUDE_DIRS
+#
+find_path (ZSTD_INCLUDE_DIR NAMES zstd.h HINTS ${ZSTD_ROOT_HINTS} PATH_SUFFIXES include)
+set (ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+
+# Set ZSTD_VERSION
+#
+if ("${ZSTD_INCLUDE_DIR}" STREQUAL "ZSTD_INCLUDE_DIR-NOTFOUND")
+    message (STATUS "Could not find include file zstd.h")
+else()
+    file (STRINGS "${ZSTD_INCLUDE_DIR}/zstd.h" __ZSTD_VERSION_MAJOR REGEX "^#define[ \t]+ZSTD_VERSION_MAJOR[ \t]+[0-9]+.*")
+    file (STRINGS "${ZSTD_INCLUDE_DIR}/zstd.h" __ZSTD_VERSION_MINOR REGEX "^#define[ \t]+ZSTD_VERSION_MINOR[ \t]+[0-9]+.*")
+    file (STRINGS "${ZSTD_INCLUDE_DIR}/zstd.h" __ZSTD_VERSION_RELEASE REGEX "^#define[ \t]+ZSTD_VERSION_RELEASE[ \t]+[0-9]+.*")
+    string (REGEX MATCH "[0-9]+" ZSTD_VERSION_MAJOR "${__ZSTD_VERSION_MAJOR}")
+    string (REGEX MATCH "[0-9]+" ZSTD_VERSION_MINOR "${__ZSTD_VERSION_MINOR}")
+    string (REGEX MATCH "[0-9]+" ZSTD_VERSION_PATCH "${__ZSTD_VERSION_RELEASE}")
+    set (ZSTD_VERSION "${ZSTD_VERSION_MAJOR}.${ZSTD_VERSION_MINOR}.${ZSTD_VERSION_PATCH}")
+endif()
+
+# Set ZSTD_LIBRARIES
+#
+find_library (ZSTD_LIBRARY NAMES zstd HINTS ${ZSTD_ROOT_HINTS} PATH_SUFFIXES lib)
+set (ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+
+# Set ZSTD_FOUND
+#
+include (FindPackageHandleStandardArgs)
+find_package_handle_standard_args (
+    ZSTD
+    REQUIRED_VARS ZSTD_INCLUDE_DIRS ZSTD_LIBRARIES
+    VERSION_VAR ZSTD_VERSION
+    )
@@ -26,15 +26,31 @@ namespace ujson {}
 
 #include <ujson/config.hpp>
 #include <ujson/multimap_list.hpp>
+#include <ujson/flat_multimap_list.hpp>
 #include <ujson/json_type_error.hpp>
+#include <ujson/jkey.hpp>
 #include <ujson/utils.hpp>
 #include <ujson/jvalue.hpp>
+#include <ujson/jobject_builder.hpp>
+#include <ujson/jarena.hpp>
 #include <ujson/jpointer.hpp>
+#include <ujson/compiled_jpointer.hpp>
 #include <ujson/jtokenizer.hpp>
+#include <ujson/jstats.hpp>
 #include <ujson/jparser.hpp>
+#include <ujson/jparser_pool.hpp>
+#include <ujson/jcompress.hpp>
+#include <ujson/jcoroutine.hpp>
+#include <ujson/jreader.hpp>
+#include <ujson/jpointer_set.hpp>
+#include <ujson/jdiff.hpp>
+#include <ujson/jcbor.hpp>
+#include <ujson/jbind.hpp>
+#include <ujson/jtape.hpp>
 #include <ujson/invalid_schema.hpp>
 #include <ujson/jschema.hpp>
 #include <ujson/schema/validation_context.hpp>
+#include <ujson/schema/validation_profile.hpp>
 #include <ujson/schema/jvocabulary.hpp>
 #include <ujson/schema/jvocabulary_core.hpp>
 #include <ujson/schema/jvocabulary_applicator.hpp>
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/internal.hpp>
+#include <ujson/compiled_jpointer.hpp>
+#include <ujson/utils.hpp>
+
+
+namespace ujson {
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    compiled_jpointer::compiled_jpointer (const jpointer& pointer)
+    {
+        compile (pointer);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    compiled_jpointer::compiled_jpointer (const std::string& pointer_string)
+    {
+        compile (jpointer(pointer_string));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    compiled_jpointer& compiled_jpointer::operator= (const jpointer& pointer)
+    {
+        compile (pointer);
+        return *this;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    compiled_jpointer& compiled_jpointer::operator= (const std::string& pointer_string)
+    {
+        compile (jpointer(pointer_string));
+        return *this;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void compiled_jpointer::compile (const jpointer& pointer)
+    {
+        tokens_t compiled;
+        compiled.reserve (pointer.size());
+        for (auto& name : pointer) {
+            token_t token {name, 0, false};
+            token.is_index = parse_array_index (name, token.index);
+            compiled.emplace_back (std::move(token));
+        }
+        tokens = std::move (compiled);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jvalue* compiled_jpointer::find (const jvalue& instance) const noexcept
+    {
+        const jvalue* value = &instance;
+        for (auto& token : tokens) {
+            switch (value->type()) {
+            case j_object:
+                value = &(value->get(token.name));
+                if (!value->valid())
+                    return nullptr;
+                break;
+
+            case j_array:
+                {
+                    if (!token.is_index)
+                        return nullptr;
+                    auto& array = value->array ();
+                    if (token.index >= array.size())
+                        return nullptr;
+                    value = &array[token.index];
+                }
+                break;
+
+            default:
+                return nullptr;
+            }
+        }
+        return value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Walk the path with non-const accessors, the value may be changed.
+    //--------------------------------------------------------------------------
+    jvalue* compiled_jpointer::find (jvalue& instance) const
+    {
+        jvalue* value = &instance;
+        for (auto& token : tokens) {
+            switch (value->type()) {
+            case j_object:
+                value = member_to_change (*value, token.name);
+                break;
+
+            case j_array:
+                value = token.is_index ? item_to_change(*value, token.index) : nullptr;
+                break;
+
+            default:
+                value = nullptr;
+                break;
+            }
+            if (value == nullptr)
+                return nullptr;
+        }
+        return value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jpointer compiled_jpointer::pointer () const
+    {
+        jpointer ptr;
+        for (auto& token : tokens)
+            ptr.push_back (token.name);
+        return ptr;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string compiled_jpointer::str () const
+    {
+        std::string ptr;
+        for (auto& token : tokens) {
+            ptr.append ("/");
+            ptr.append (escape_pointer_token(token.name));
+        }
+        return ptr;
+    }
+
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_COMPILED_JPOINTER_HPP
+#define UJSON_COMPILED_JPOINTER_HPP
+
+#include <ujson/jvalue.hpp>
+#include <ujson/jpointer.hpp>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+namespace ujson {
+
+
+    /**
+     * A JSON pointer prepared for repeated lookups.
+     * The tokens of the pointer are unescaped and stored in a
+     * contiguous array, and tokens that are valid array indexes
+     * are converted to numbers when the pointer is created.
+     * Looking up a value doesn't allocate memory, doesn't throw
+     * exceptions, and doesn't use any shared state, so the same
+     * compiled pointer may be used by several threads at the
+     * same time.
+     * \par Exampe:
+     * \code
+     * const ujson::compiled_jpointer ptr ("/servers/0/port");
+     * ...
+     * auto* port = ptr.find (config);
+     * if (port)
+     *     std::cout << port->describe();
+     * else
+     *     std::cout << "Item not found" << std::endl;
+     * \endcode
+     */
+    class compiled_jpointer {
+    public:
+        /**
+         * A token in the JSON pointer.
+         */
+        struct token_t {
+            std::string name; /**< The unescaped token. */
+            size_t index;     /**< The array index, if <code>is_index</code> is <code>true</code>. */
+            bool is_index;    /**< <code>true</code> if the token is a valid array index. */
+        };
+        using tokens_t = std::vector<token_t>; /**< Array of tokens in the JSON pointer. */
+
+        compiled_jpointer () = default; /**< Default constructor. Create an empty JSON pointer. */
+
+        /** Compile a JSON pointer.
+            @param pointer The JSON pointer.
+         */
+        compiled_jpointer (const jpointer& pointer);
+
+        /** Compile a JSON pointer by parsing a string.
+            @throw std::invalid_argument if the pointer string isn't a valid JSON pointer.
+         */
+        compiled_jpointer (const std::string& pointer_string);
+
+        compiled_jpointer& operator= (const jpointer& pointer); /**< Assign a JSON pointer. */
+
+        /** Assign a JSON pointer by parsing a string.
+            @throw std::invalid_argument if the pointer string isn't a valid JSON pointer.
+         */
+        compiled_jpointer& operator= (const std::string& pointer_string);
+
+        /**
+         * Find a value in a JSON instance.
+         * @param instance A JSON instance.
+         * @return A pointer to the value in the JSON instance,
+         *         or <code>nullptr</code> if not found.
+         */
+        const jvalue* find (const jvalue& instance) const noexcept;
+
+        /**
+         * Find a value in a JSON instance.
+         * Same as the const version, but returns a
+         * value that may be modified by the caller.
+         * The objects and arrays on the path to the value
+         * are unshared, and their cached hash values cleared
+         * (see jvalue::share() and jvalue::cache_hash()),
+         * but their content is not modified.
+         * @param instance A JSON instance.
+         * @return A pointer to the value in the JSON instance,
+         *         or <code>nullptr</code> if not found.
+         */
+        jvalue* find (jvalue& instance) const;
+
+        jpointer pointer () const; /**< Return the JSON pointer. */
+        std::string str () const;  /**< Return a string representation of the JSON pointer. */
+
+        inline size_t size () const  {return tokens.size();} /**< Return the number of tokens in the JSON pointer. */
+        inline bool empty () const   {return tokens.empty();} /**< Return <code>true</code> if the JSON pointer is empty. */
+
+        inline tokens_t::const_iterator begin () const noexcept {return tokens.begin();} /**< Iterator to the first token. */
+        inline tokens_t::const_iterator end () const noexcept   {return tokens.end();} /**< Iterator past the last token. */
+
+
+    private:
+        void compile (const jpointer& pointer);
+        tokens_t tokens;
+    };
+
+
+}
+#endif
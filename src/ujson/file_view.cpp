@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/config.hpp>
+#include <ujson/file_view.hpp>
+#include <ujson/jcompress.hpp>
+#include <fstream>
+#include <iterator>
+#if (UJSON_HAVE_MMAP)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace ujson {
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    file_view::file_view (const std::string& file_name,
+                          bool sequential,
+                          bool decompress)
+        : buf (nullptr),
+          size (0),
+          mapped (false),
+          ok (false)
+    {
+#if (UJSON_HAVE_MMAP)
+        // Map regular files directly into memory.
+        // Pipes, character devices, empty files,
+        // etc. are read into a buffer instead.
+        int fd = open (file_name.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat sb;
+        if (fstat(fd, &sb)==0  &&  S_ISREG(sb.st_mode)  &&  sb.st_size > 0) {
+            void* addr = mmap (nullptr, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                close (fd);
+                madvise (addr, (size_t)sb.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+                buf = reinterpret_cast<const char*> (addr);
+                size = (size_t) sb.st_size;
+                mapped = true;
+                ok = true;
+                if (decompress && detect_compression(buf, size) != compression_t::none)
+                    decompress_file (file_name);
+                return;
+            }
+        }
+        close (fd);
+#endif
+        if (decompress) {
+            // Not a regular file, it can only be read once
+            decompress_file (file_name);
+            return;
+        }
+        std::ifstream in (file_name);
+        if (!in.good())
+            return;
+        buffer.assign ((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        buf = buffer.data ();
+        size = buffer.size ();
+        ok = !in.bad ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    file_view::~file_view ()
+    {
+        unmap ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void file_view::unmap ()
+    {
+#if (UJSON_HAVE_MMAP)
+        if (mapped)
+            munmap (const_cast<char*>(buf), size);
+#endif
+        mapped = false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Read the (possibly compressed) file into the buffer.
+    //--------------------------------------------------------------------------
+    void file_view::decompress_file (const std::string& file_name)
+    {
+        unmap ();
+        buf = nullptr;
+        size = 0;
+        ok = false;
+        jdecompressor in (file_name);
+        const char* data;
+        size_t len;
+        while (in.next(data, len))
+            buffer.append (data, len);
+        if (!in.error().empty()) {
+            buffer.clear ();
+            return;
+        }
+        buf = buffer.data ();
+        size = buffer.size ();
+        ok = true;
+    }
+
+
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_FILE_VIEW_HPP
+#define UJSON_FILE_VIEW_HPP
+
+#include <string>
+#include <string_view>
+
+
+namespace ujson {
+
+
+    /**
+     * Read-only view of the contents of a file.
+     * If possible, regular files are memory mapped, other
+     * files (pipes, character devices, etc.) are read into
+     * a buffer. Compressed files can optionally be
+     * decompressed into a buffer.
+     */
+    class file_view {
+    public:
+        /**
+         * Open a file.
+         * @param file_name The name of the file.
+         * @param sequential If <code>true</code>, the contents of a
+         *                   memory mapped file is expected to be read
+         *                   sequentially, otherwise in random order.
+         * @param decompress If <code>true</code>, and the file is compressed
+         *                   in a format supported by jdecompressor, the
+         *                   view is of the decompressed contents.
+         */
+        file_view (const std::string& file_name,
+                   bool sequential=true,
+                   bool decompress=false);
+
+        /**
+         * Destructor.
+         * Unmaps the file if it was memory mapped.
+         */
+        ~file_view ();
+
+        file_view (const file_view&) = delete;
+        file_view& operator= (const file_view&) = delete;
+
+        /**
+         * Return <code>true</code> if the file was successfully opened and read.
+         */
+        bool good () const {
+            return ok;
+        }
+
+        /**
+         * Return the contents of the file.
+         */
+        std::string_view data () const {
+            return std::string_view (buf, size);
+        }
+
+
+    private:
+        const char* buf;
+        size_t size;
+        bool mapped;
+        bool ok;
+        std::string buffer;
+
+        void decompress_file (const std::string& file_name);
+        void unmap ();
+    };
+
+
+}
+#endif
@@ -0,0 +1,1171 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_FLAT_MULTIMAP_LIST_HPP
+#define UJSON_FLAT_MULTIMAP_LIST_HPP
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+
+
+namespace ujson {
+
+    /**
+     * A multimap that keeps items in the order they were inserted,
+     * stored in a single contiguous array.
+     * This class has the same interface as class multimap_list and
+     * can be used instead of it. If the library is configured with
+     * cmake option <code>-DUSE_FLAT_OBJECTS=True</code>, type
+     * ujson::json_object is a flat_multimap_list.<br/>
+     * Small containers are searched linearly. For larger containers,
+     * and for the sorted iterators, an index of the items sorted by key
+     * is created when first needed. Adding items to the end of the
+     * container keeps the index up to date, other modifications drops
+     * the index until it is needed again.<br/>
+     * Unlike multimap_list, iterators and references to items are
+     * invalidated when items are added or removed, the same way as for
+     * a <code>std::vector</code>. The container is not thread safe,
+     * except for concurrent reads.
+     */
+    template<class Key, class T, class CompareKey=std::less<Key>, class CompareValue=std::less<T>>
+    class flat_multimap_list {
+    private:
+        // Items are stored with a non-const key so they can be
+        // moved when the array grows, and are accessed as
+        // value_type (with a const key).
+        using Item = std::pair<Key, T>;
+        using ItemList = std::vector<Item>;
+        using Index = std::vector<size_t>;
+
+        // Containers with at most this many items
+        // are searched without using the index.
+        static constexpr size_t linear_search_max = 8;
+
+    public:
+        using key_type = Key;                       /**< Key type. */
+        using mapped_type = T;                      /**< Mapped type. */
+        using value_type = std::pair<const Key, T>; /**< Value type. */
+        using size_type = size_t;                   /**< Size type. */
+        using difference_type = ptrdiff_t;          /**< Difference type. */
+        using key_compare = CompareKey;             /**< Key compare type. */
+        using mapped_compare = CompareValue;        /**< Mapped value compare type. */
+        using reference = value_type&;              /**< Reference type to a value. */
+        using const_reference = const value_type&;  /**< Const reference type to a value. */
+
+        /**
+         * Comparison functor that compares a key-value pair.
+         */
+        struct value_type_compare {
+            /**
+             * Return <code>true</code> is lhs is <em>less than</em> rhs (lhs < rhs).
+             */
+            bool operator() (const value_type& lhs, const value_type& rhs) {
+                if (key_compare{}(lhs.first, rhs.first))
+                    return true;
+                else if (key_compare{}(rhs.first, lhs.first))
+                    return false;
+                else
+                    return mapped_compare{}(lhs.second, rhs.second);
+            }
+        };
+
+
+        /**
+         * Default constructor.
+         * Creates an empty flat_multimap_list object.
+         */
+        flat_multimap_list () = default;
+
+
+        /**
+         * Constructor.
+         * Creates an empty container with a specific
+         * function object for key comparisons.
+         * @param comp function object to use for all comparisons of keys.
+         */
+        explicit flat_multimap_list (const key_compare& comp)
+            : key_less (comp)
+        {
+        }
+
+        /**
+         * Copy constructor.
+         * Copy the contents of another flat_multimap_list to this container.
+         * @param ml The flat_multimap_list object to copy.
+         */
+        flat_multimap_list (const flat_multimap_list& ml)
+            : items (ml.items),
+              key_less (ml.key_less)
+        {
+        }
+
+
+        /**
+         * Move constructor.
+         * Move the contents of another flat_multimap_list to this container.
+         * @param ml The flat_multimap_list object to move.
+         */
+        flat_multimap_list (flat_multimap_list&& ml) noexcept
+            : items (std::move(ml.items)),
+              key_less (ml.key_less)
+        {
+            ml.drop_index ();
+        }
+
+
+        /**
+         * Constructor.
+         * Create a flat_multimap_list objct and copy elements from a range of values.
+         * @param first The first value in the range of values to copy.
+         * @param last The position after the last value in the range of values to copy.
+         * @param comp function object to use for all comparisons of keys.
+         */
+        template<class InputIt>
+        flat_multimap_list (InputIt first,
+                            InputIt last,
+                            const key_compare& comp=key_compare())
+            : key_less (comp)
+            {
+                for (auto i=first; i!=last; ++i)
+                    push_back (*i);
+            }
+
+
+        /**
+         * Initializer list constructor.
+         * Create a flat_multimap_list and initialize the content.
+         * @param ilist An initializer list.
+         * @param comp function object to use for all comparisons of keys.
+         */
+        flat_multimap_list (std::initializer_list<value_type> ilist,
+                            const key_compare& comp=key_compare())
+            : key_less (comp)
+            {
+                items.reserve (ilist.size());
+                for (auto& entry : ilist)
+                    push_back (entry);
+            }
+
+
+        /**
+         * Destructor.
+         */
+        ~flat_multimap_list () = default;
+
+
+        /**
+         * Assignment operator.
+         * Make this object a copy of another flat_multimap_list object.
+         * @param rhs The object to copy.
+         */
+        flat_multimap_list& operator= (const flat_multimap_list& rhs)
+            {
+                if (&rhs != this) {
+                    items = rhs.items;
+                    key_less = rhs.key_less;
+                    drop_index ();
+                }
+                return *this;
+            }
+
+
+        /**
+         * Assignment operator.
+         * Assign the contents on an ilitializer list to this object.
+         * @param ilist The initializer list to copy.
+         */
+        flat_multimap_list& operator= (std::initializer_list<value_type> ilist) {
+            clear ();
+            items.reserve (ilist.size());
+            for (auto& entry : ilist)
+                push_back (entry);
+            return *this;
+        }
+
+
+        /**
+         * Move operator.
+         * Move the contents of another flat_multimap_list to this object.
+         * @param rhs The object to move to this object.
+         */
+        flat_multimap_list& operator= (flat_multimap_list&& rhs) noexcept
+            {
+                if (&rhs != this) {
+                    items = std::move (rhs.items);
+                    key_less = rhs.key_less;
+                    drop_index ();
+                    rhs.drop_index ();
+                }
+                return *this;
+            }
+
+
+        /**
+         * Check if the container is empty.
+         * @return <code>true</code> is this container is empty.
+         */
+        bool empty () const noexcept {
+            return items.empty ();
+        }
+
+
+        /**
+         * Return the number of entries in the container.
+         * @return The number of entries in the container.
+         */
+        size_type size () const noexcept {
+            return items.size ();
+        }
+
+
+        /**
+         * Increase the capacity of the container.
+         * @param new_cap The number of entries to make room for.
+         */
+        void reserve (size_type new_cap) {
+            items.reserve (new_cap);
+        }
+
+
+        /**
+         * Clear the container.
+         */
+        void clear () noexcept {
+            items.clear ();
+            drop_index ();
+        }
+
+
+        /**
+         * Add elements from a range of elements to the end of the list.
+         * The index of sorted keys is dropped and created again
+         * when it is needed, instead of being updated for each
+         * element, which is faster when many elements are added.
+         * @param first An iterator to the first element to add.
+         *              Use a <code>std::move_iterator</code> to move the
+         *              elements instead of copying them.
+         * @param last The position after the last element to add.
+         */
+        template<class InputIt>
+        void append (InputIt first, InputIt last) {
+            if (first == last)
+                return;
+            drop_index ();
+            if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                          typename std::iterator_traits<InputIt>::iterator_category>)
+            {
+                items.reserve (items.size() + std::distance(first, last));
+            }
+            for (; first!=last; ++first)
+                items.emplace_back (*first);
+        }
+
+
+    private:
+        template<class VType, class ItemPtr>
+        class iterator_impl {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = VType;
+            using difference_type = ptrdiff_t;
+            using pointer = VType*;
+            using reference = VType&;
+
+            iterator_impl () = default;
+            ~iterator_impl () = default;
+            iterator_impl (const iterator_impl& iter) = default;
+            iterator_impl& operator= (const iterator_impl& rhs) = default;
+            //----------------------------------------------------------------------
+            iterator_impl (ItemPtr item)
+                : sorted (false), i (item), si (nullptr)
+            {
+            }
+            //----------------------------------------------------------------------
+            iterator_impl (ItemPtr base, const size_t* sorted_pos)
+                : sorted (true), i (base), si (sorted_pos)
+            {
+            }
+            //----------------------------------------------------------------------
+            iterator_impl operator++ () {
+                // ++obj
+                if (sorted)
+                    ++si;
+                else
+                    ++i;
+                return *this;
+            }
+            //----------------------------------------------------------------------
+            iterator_impl operator++ (int) {
+                // obj++
+                iterator_impl retval (*this);
+                ++(*this);
+                return retval;
+            }
+            //----------------------------------------------------------------------
+            iterator_impl operator-- () {
+                // --obj
+                if (sorted)
+                    --si;
+                else
+                    --i;
+                return *this;
+            }
+            //----------------------------------------------------------------------
+            iterator_impl operator-- (int) {
+                // obj--
+                iterator_impl retval (*this);
+                --(*this);
+                return retval;
+            }
+            //----------------------------------------------------------------------
+            VType& operator*() {
+                return *item ();
+            }
+            //----------------------------------------------------------------------
+            VType* operator->() {
+                return item ();
+            }
+            //----------------------------------------------------------------------
+            bool operator== (const iterator_impl& rhs) const {
+                if (sorted != rhs.sorted) {
+                    throw std::logic_error (
+                            (sorted ?
+                             "Can't compare sorted with unsorted iterator" :
+                             "Can't compare unsorted with sorted iterator"));
+                }
+                return sorted ? si==rhs.si : i==rhs.i;
+            }
+            //----------------------------------------------------------------------
+            bool operator!= (const iterator_impl& rhs) const {
+                return ! this->operator==(rhs);
+            }
+        private:
+            friend class flat_multimap_list;
+            VType* item () const {
+                return reinterpret_cast<VType*> (sorted ? i + *si : i);
+            }
+            bool sorted;
+            ItemPtr i; // The item, or the first item if sorted
+            const size_t* si;
+        }; // class iterator_impl
+
+    public:
+        using iterator               = iterator_impl<value_type, Item*>; /**< An iterator. */
+        using const_iterator         = iterator_impl<const value_type, const Item*>; /**< A const iterator. */
+        using reverse_iterator       = std::reverse_iterator<iterator>; /**< A reverse iterator. */
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>; /**< A const reverse iterator. */
+
+
+        /**
+         * Return a reference to the first item in the container.
+         * The return value is undefined if the container is empty.
+         * @return A reference to the first item in the container.
+         */
+        reference front () {
+            return *(begin());
+        }
+
+
+        /**
+         * Return a reference to the last item in the container.
+         * The return value is undefined if the container is empty.
+         * @return A reference to the last item in the container.
+         */
+        reference back () {
+            return *(rbegin());
+        }
+
+
+        /**
+         * Add an element to the end of the list.
+         * @param key The key to add.
+         * @param value The mapped value to add.
+         */
+        void push_back (const key_type& key, const mapped_type& value) {
+            emplace_back (key, value);
+        }
+
+
+        /**
+         * Add an element to the end of the list.
+         * @param entry A key and a value to add to the list.
+         */
+        void push_back (const value_type& entry) {
+            emplace_back (entry.first, entry.second);
+        }
+
+
+        /**
+         * Add an element to the end of the list.
+         * @param entry A key and a value to add to the list.
+         */
+        void push_back (value_type&& entry) {
+            emplace_back (entry.first, std::move(entry.second));
+        }
+
+
+        /**
+         * Prepend an element to beginning of the list.
+         * @param key The key to add.
+         * @param value The mapped value to add.
+         */
+        void push_front (const key_type& key, const mapped_type& value) {
+            emplace (begin(), key, value);
+        }
+
+
+        /**
+         * Prepend an element to beginning of the list.
+         * @param entry A key and a value to add to the list.
+         */
+        void push_front (const value_type& entry) {
+            emplace (begin(), entry.first, entry.second);
+        }
+
+
+        /**
+         * Prepend an element to beginning of the list.
+         * @param entry A key and a value to add to the list.
+         */
+        void push_front (value_type&& entry) {
+            emplace (begin(), entry.first, std::move(entry.second));
+        }
+
+
+        /**
+         * Insert an element at a specified location in the container.
+         * @param pos The element will be inserted before this position.
+         * @param key The key to add.
+         * @param value The mapped value to add.
+         * @return Iterator pointing to the inserted entry.
+         */
+        iterator insert (iterator pos, const key_type& key, const mapped_type& value) {
+            return emplace (pos, key, value);
+        }
+
+
+        /**
+         * Insert an element at a specified location in the container.
+         * @param pos The element will be inserted before this position.
+         * @param entry The key-value pair to insert.
+         * @return Iterator pointing to the inserted entry.
+         */
+        iterator insert (iterator pos, const value_type& entry) {
+            return emplace (pos, entry.first, entry.second);
+        }
+
+
+        /**
+         * Insert an element at a specified location in the container.
+         * @param pos The element will be inserted before this position.
+         * @param entry The key-value pair to insert.
+         * @return Iterator pointing to the inserted entry.
+         */
+        iterator insert (iterator pos, value_type&& entry) {
+            return emplace (pos, entry.first, std::move(entry.second));
+        }
+
+
+        /**
+         * Insert elements from a range of elements.
+         * @param pos The elements will be inserted before this position.
+         * @param first An iterator to the first element to insert.
+         * @param last The position after the last element to insert.
+         * @return Iterator pointing to the first element inserted,
+         *         or <code>pos</code> if the initializer list is empty.
+         */
+        template<class InputIt>
+        iterator insert (iterator pos, InputIt first, InputIt last) {
+            if (first == last)
+                return pos;
+            ItemList new_items;
+            for (auto entry=first; entry!=last; ++entry)
+                new_items.emplace_back (entry->first, entry->second);
+            auto offset = item_pos (pos);
+            items.insert (items.begin() + offset,
+                          std::make_move_iterator(new_items.begin()),
+                          std::make_move_iterator(new_items.end()));
+            drop_index ();
+            return iterator (items.data() + offset);
+        }
+
+
+        /**
+         * Insert elements from an initializer list at a specified location.
+         * @param pos The elements will be inserted before this position.
+         * @param ilist Initializer list to insert values from.
+         * @return Iterator pointing to the first element inserted,
+         *         or <code>pos</code> if the initializer list is empty.
+         */
+        iterator insert (iterator pos, std::initializer_list<value_type> ilist) {
+            return insert (pos, ilist.begin(), ilist.end());
+        }
+
+
+        /**
+         * Create an element at a specified location in the container.
+         * The element is constructed in-place at the specified location.
+         * @param pos The element will be inserted before this position.
+         * @param args Arguments to the key-value to insert.
+         * @return Iterator pointing to the created element.
+         */
+        template<class ...Args>
+        iterator emplace (iterator pos, Args&&... args) {
+            auto offset = item_pos (pos);
+            if (offset == items.size())
+                return iterator (&emplace_back_impl(std::forward<Args>(args)...));
+            items.emplace (items.begin() + offset, std::forward<Args>(args)...);
+            drop_index ();
+            return iterator (items.data() + offset);
+        }
+
+
+        /**
+         * Create an element at the beginning of the list.
+         * @param args Arguments to the key-value to insert.
+         * @return A reference to the created element.
+         */
+        template<class ...Args>
+        reference emplace_front (Args&&... args) {
+            return *(emplace(begin(), std::forward<Args>(args)...));
+        }
+
+
+        /**
+         * Create an element at the end of the list.
+         * @param args Arguments to the key-value to insert.
+         * @return A reference to the created element.
+         */
+        template<class ...Args>
+        reference emplace_back (Args&&... args) {
+            return *reinterpret_cast<value_type*> (&emplace_back_impl(std::forward<Args>(args)...));
+        }
+
+
+        /**
+         * Erase an entry at the specified position.
+         * @param pos The position of the element to erase.
+         * @return Iterator following the removed element.
+         */
+        iterator erase (iterator pos) {
+            if ((pos.sorted && pos == send()) || (!pos.sorted && pos == end()))
+                return pos;
+            return erase_impl (pos);
+        }
+
+
+        /**
+         * Erase an entry at the specified position.
+         * @param pos The position of the element to erase.
+         * @return Iterator following the removed element.
+         */
+        const_iterator erase (const_iterator pos) {
+            if ((pos.sorted && pos == csend()) || (!pos.sorted && pos == cend()))
+                return pos;
+            return to_const (erase_impl(to_mutable(pos)));
+        }
+
+
+        /**
+         * Erase a range of entries from the container.
+         * @param first The position of the first entry to erase.
+         * @param last The position after the last entry to erase.
+         * @return Iterator following the last removed element.
+         */
+        iterator erase (iterator first, iterator last) {
+            if (first.sorted) {
+                // Erase the items one by one, from the last
+                // to the first, the index is kept up to date
+                size_t offset = first.si - get_index().data ();
+                size_t count = last.si - first.si;
+                while (count--)
+                    erase_impl (iterator(items.data(), index.data() + offset + count));
+                return iterator (items.data(), get_index().data() + offset);
+            }
+            auto offset = first.i - items.data ();
+            items.erase (items.begin() + offset, items.begin() + (last.i - items.data()));
+            drop_index ();
+            return iterator (items.data() + offset);
+        }
+
+
+        /**
+         * Erase a range of entries from the container.
+         * @param first The position of the first entry to erase.
+         * @param last The position after the last entry to erase.
+         * @return Iterator following the last removed element.
+         */
+        const_iterator erase (const_iterator first, const_iterator last) {
+            return to_const (erase(to_mutable(first), to_mutable(last)));
+        }
+
+
+        /**
+         * Erase all entries with a specific key.
+         * @param key Entries with this key will be erased.
+         * @return The number of erased elements.
+         */
+        size_type erase (const key_type& key) {
+            auto num_items = items.size ();
+            items.erase (std::remove_if(items.begin(), items.end(),
+                                        [this, &key] (const Item& item) {
+                                            return equal_keys (item.first, key);
+                                        }),
+                         items.end());
+            auto num_erased = num_items - items.size ();
+            if (num_erased)
+                drop_index ();
+            return num_erased;
+        }
+
+
+        /**
+         * Erase the first entry in the container.
+         */
+        void pop_front () {
+            if (!items.empty())
+                erase (begin());
+        }
+
+
+        /**
+         * Erase the last entry in the container.
+         */
+        void pop_back () {
+            if (!items.empty())
+                erase (--(end()));
+        }
+
+
+        /**
+         * Swap the content of two containers.
+         * @param other The other container to swap content with.
+         */
+        void swap (flat_multimap_list& other) {
+            items.swap (other.items);
+            std::swap (key_less, other.key_less);
+            drop_index ();
+            other.drop_index ();
+        }
+
+
+        /**
+         * Return the number of elements with a specific key.
+         * @return the number of elements with a specific key.
+         */
+        size_type count (const key_type& key) const {
+            if (items.size() <= linear_search_max) {
+                return std::count_if (items.begin(), items.end(),
+                                      [this, &key] (const Item& item) {
+                                          return equal_keys (item.first, key);
+                                      });
+            }
+            auto range = index_range (key);
+            return range.second - range.first;
+        }
+
+
+        /**
+         * Find the first entry with a specific key.
+         * @param key The key to search for.
+         * @return Iterator to the first entry with the key,
+         *         or end() if no entry with the specified key.
+         */
+        iterator find (const key_type& key) {
+            return iterator (items.data() + find_pos(key));
+        }
+
+
+        /**
+         * Check if there is at least one entry with a specific key.
+         * @return <code>true</code> if there is an entry with the key.
+         */
+        bool contains (const key_type& key) const {
+            return find_pos(key) != items.size();
+        }
+
+
+        /**
+         * Find all entries with a specific key.
+         * @param key The key to search for.
+         * @return A range of entries with the specific key.
+         */
+        std::pair<iterator, iterator> equal_range (const key_type& key) {
+            auto range = index_range (key);
+            return std::make_pair (iterator(items.data(), range.first),
+                                   iterator(items.data(), range.second));
+        }
+
+
+        /**
+         * Find all entries with a specific key.
+         * @param key The key to search for.
+         * @return A range of entries with the specific key.
+         */
+        std::pair<const_iterator, const_iterator> equal_range (const key_type& key) const {
+            auto range = index_range (key);
+            return std::make_pair (const_iterator(items.data(), range.first),
+                                   const_iterator(items.data(), range.second));
+        }
+
+
+        /**
+         * Return the position of the first element with
+         * a key <em>not less</em> than the pecified key.
+         * @return Iterator to an element,
+         *         or <code>send()</code> if none found.
+         */
+        iterator lower_bound (const key_type& key) {
+            return iterator (items.data(), index_range(key).first);
+        }
+
+
+        /**
+         * Return the position of the first element with
+         * a key <em>not less</em> than the pecified key.
+         * @return Iterator to an element,
+         *         or <code>send()</code> if none found.
+         */
+        const_iterator lower_bound (const key_type& key) const {
+            return const_iterator (items.data(), index_range(key).first);
+        }
+
+
+        /**
+         * Return the position of the first element
+         * with a key <em>greater</em> than the pecified key.
+         * @return Iterator to an element,
+         *         or <code>send()</code> if none found.
+         */
+        iterator upper_bound (const key_type& key) {
+            return iterator (items.data(), index_range(key).second);
+        }
+
+
+        /**
+         * Return the position of the first element
+         * with a key <em>greater</em> than the pecified key.
+         * @return Iterator to an element,
+         *         or <code>send()</code> if none found.
+         */
+        const_iterator upper_bound (const key_type& key) const {
+            return const_iterator (items.data(), index_range(key).second);
+        }
+
+
+        /**
+         * Check if two containers are equal.
+         * Two containers are equal if:<br/>
+         * <ul>
+         *   <li>They have the same number of elements.</li>
+         *   <li>All key-value elements in one container are present in the other.</li>
+         * </ul>
+         * The key-value elements need not be in the same order in the two containers.
+         * @param rhs The other container to compare with.
+         * @return <code>true</code> if the containers are equivalent.
+         */
+        bool operator== (const flat_multimap_list& rhs) const {
+            if (this == &rhs)
+                return true;
+            if (items.size() != rhs.items.size())
+                return false;
+
+            auto lhs_i = sbegin ();
+            auto rhs_i = rhs.sbegin ();
+            mapped_compare value_less;
+            while (lhs_i != send()) {
+                if ( key_less(lhs_i->first, rhs_i->first) ||
+                     key_less(rhs_i->first, lhs_i->first) ||
+                     value_less(lhs_i->second, rhs_i->second) ||
+                     value_less(rhs_i->second, lhs_i->second))
+                {
+                    return false;
+                }
+                ++lhs_i;
+                ++rhs_i;
+            }
+            return true;
+        }
+
+
+        /**
+         * Check if two containers are not equal.
+         * @param rhs The container to compare. The right-hand-side of '!='.
+         * @return <code>true</code> if the other container
+         *         is equal to this, otherwise <code>false</code>.
+         */
+        bool operator!= (const flat_multimap_list& rhs) const {
+            return ! this->operator==(rhs);
+        }
+
+
+        /**
+         * Compare the contents of two containers lexicographically.<br/>
+         * The two containers are compared using sorted keys.
+         * @param rhs The other container to compare with. The right-hand side of '<'.
+         * @return <code>true</code> if this container is lexicographically less than the other.
+         */
+        bool operator< (const flat_multimap_list& rhs) const {
+            if (this == &rhs)
+                return false;
+            return std::lexicographical_compare (sbegin(), send(),
+                                                 rhs.sbegin(), rhs.send(),
+                                                 value_type_compare{});
+        }
+
+
+        /**
+         * Return an iterator to the first entry of the list of elements.
+         */
+        iterator begin () {
+            return iterator (items.data());
+        }
+
+
+        /**
+         * Return a const iterator to the first entry of the list of elements.
+         */
+        const_iterator begin () const {
+            return const_iterator (items.data());
+        }
+
+
+        /**
+         * Return a const iterator to the first entry of the list of elements.
+         */
+        const_iterator cbegin () const {
+            return const_iterator (items.data());
+        }
+
+
+        /**
+         * Return a reverse iterator to the first entry of the reversed list of elements.
+         */
+        reverse_iterator rbegin () {
+            return std::make_reverse_iterator (end());
+        }
+
+
+        /**
+         * Return a const reverse iterator to the first entry of the reversed list of elements.
+         */
+        const_reverse_iterator rbegin () const {
+            return std::make_reverse_iterator (cend());
+        }
+
+
+        /**
+         * Return a const reverse iterator to the first entry of the reversed list of elements.
+         */
+        const_reverse_iterator crbegin () const {
+            return std::make_reverse_iterator (cend());
+        }
+
+
+        /**
+         * Return a sorted iterator to the first entry of the sorted list of elements.
+         * The iterator is sorted by key.
+         */
+        iterator sbegin () {
+            return iterator (items.data(), get_index().data());
+        }
+
+
+        /**
+         * Return a sorted const iterator to the first entry of the sorted list of elements.
+         * The iterator is sorted by key.
+         */
+        const_iterator sbegin () const {
+            return const_iterator (items.data(), get_index().data());
+        }
+
+
+        /**
+         * Return a sorted const iterator to the first entry of the sorted list of elements.
+         * The iterator is sorted by key.
+         */
+        const_iterator csbegin () const {
+            return sbegin ();
+        }
+
+
+        /**
+         * Return a reversed sorted iterator to the first entry of the reversed sorted list of elements.
+         * The iterator is sorted by key.
+         */
+        reverse_iterator rsbegin () {
+            return std::make_reverse_iterator (send());
+        }
+
+
+        /**
+         * Return a const reversed sorted iterator to the first entry of the reversed sorted list of elements.
+         * The iterator is sorted by key.
+         */
+        const_reverse_iterator rsbegin () const {
+            return std::make_reverse_iterator (csend());
+        }
+
+
+        /**
+         * Return a const reversed sorted iterator to the first entry of the reversed sorted list of elements.
+         * The iterator is sorted by key.
+         */
+        const_reverse_iterator crsbegin () const {
+            return std::make_reverse_iterator (csend());
+        }
+
+
+        /**
+         * Return an iterator to the element following the last entry of the list of elements.
+         */
+        iterator end () {
+            return iterator (items.data() + items.size());
+        }
+
+
+        /**
+         * Return a const iterator to the element following the last entry of the list of elements.
+         */
+        const_iterator end () const {
+            return const_iterator (items.data() + items.size());
+        }
+
+
+        /**
+         * Return a const iterator to the element following the last entry of the list of elements.
+         */
+        const_iterator cend () const {
+            return end ();
+        }
+
+
+        /**
+         * Return a reverse iterator to the element following the last entry of the reversed list of elements.
+         */
+        reverse_iterator rend () {
+            return std::make_reverse_iterator (begin());
+        }
+
+
+        /**
+         * Return a const reverse iterator to the element following the last entry of the reversed list of elements.
+         */
+        const_reverse_iterator rend () const {
+            return std::make_reverse_iterator (cbegin());
+        }
+
+
+        /**
+         * Return a const reverse iterator to the element following the last entry of the reversed list of elements.
+         */
+        const_reverse_iterator crend () const {
+            return std::make_reverse_iterator (cbegin());
+        }
+
+
+        /**
+         * Return a sorted iterator to the element following the last sorted element.
+         */
+        iterator send () {
+            auto& idx = get_index ();
+            return iterator (items.data(), idx.data() + idx.size());
+        }
+
+
+        /**
+         * Returns a sorted const iterator to the element following the last sorted element.
+         */
+        const_iterator send () const {
+            auto& idx = get_index ();
+            return const_iterator (items.data(), idx.data() + idx.size());
+        }
+
+
+        /**
+         * Returns a sorted const iterator to the element following the last sorted element.
+         */
+        const_iterator csend () const {
+            return send ();
+        }
+
+
+        /**
+         * Returns a reversed sorted iterator to the element following the last reversed sorted element.
+         */
+        reverse_iterator rsend () {
+            return std::make_reverse_iterator (sbegin());
+        }
+
+
+        /**
+         * Returns a reversed sorted const iterator to the element following the last reversed sorted element.
+         */
+        const_reverse_iterator rsend () const {
+            return std::make_reverse_iterator (csbegin());
+        }
+
+
+        /**
+         * Returns a reversed sorted const iterator to the element following the last reversed sorted element.
+         */
+        const_reverse_iterator crsend () const {
+            return std::make_reverse_iterator (csbegin());
+        }
+
+
+    private:
+        ItemList items;
+        key_compare key_less;
+
+        // Positions in 'items' sorted by key, and by position for
+        // equal keys. Only valid if 'index_valid' is true.
+        mutable Index index;
+        mutable std::atomic<bool> index_valid {false};
+        mutable std::mutex index_mutex;
+
+        bool equal_keys (const key_type& lhs, const key_type& rhs) const {
+            return !key_less(lhs, rhs) && !key_less(rhs, lhs);
+        }
+
+        void drop_index () noexcept {
+            index_valid.store (false, std::memory_order_relaxed);
+        }
+
+        // Return the index, create it if needed. Concurrent
+        // readers may need the index at the same time.
+        const Index& get_index () const {
+            if (!index_valid.load(std::memory_order_acquire)) {
+                std::lock_guard<std::mutex> lock (index_mutex);
+                if (!index_valid.load(std::memory_order_relaxed)) {
+                    index.resize (items.size());
+                    for (size_t i=0; i<index.size(); ++i)
+                        index[i] = i;
+                    std::stable_sort (index.begin(), index.end(),
+                                      [this] (size_t lhs, size_t rhs) {
+                                          return key_less (items[lhs].first, items[rhs].first);
+                                      });
+                    index_valid.store (true, std::memory_order_release);
+                }
+            }
+            return index;
+        }
+
+        // Return the range in the index with a specific key
+        std::pair<const size_t*, const size_t*> index_range (const key_type& key) const {
+            auto& idx = get_index ();
+            auto range = std::equal_range (idx.begin(), idx.end(), key, index_compare{this});
+            return std::make_pair (idx.data() + (range.first - idx.begin()),
+                                   idx.data() + (range.second - idx.begin()));
+        }
+
+        struct index_compare {
+            const flat_multimap_list* self;
+            bool operator() (size_t pos, const key_type& key) const {
+                return self->key_less (self->items[pos].first, key);
+            }
+            bool operator() (const key_type& key, size_t pos) const {
+                return self->key_less (key, self->items[pos].first);
+            }
+        };
+
+        // Add an item to the end, and keep the index if it is valid
+        template<class ...Args>
+        Item& emplace_back_impl (Args&&... args) {
+            auto& item = items.emplace_back (std::forward<Args>(args)...);
+            if (index_valid.load(std::memory_order_relaxed)) {
+                auto pos = std::upper_bound (index.begin(), index.end(),
+                                             item.first, index_compare{this});
+                index.insert (pos, items.size() - 1);
+            }
+            return item;
+        }
+
+        // The position of the first item with a specific key,
+        // or the number of items if not found
+        size_t find_pos (const key_type& key) const {
+            if (items.size() <= linear_search_max) {
+                for (size_t i=0; i<items.size(); ++i) {
+                    if (equal_keys(items[i].first, key))
+                        return i;
+                }
+                return items.size ();
+            }
+            auto range = index_range (key);
+            return range.first == range.second ? items.size() : *range.first;
+        }
+
+        // The position in 'items' that an iterator refers to
+        template<class Iter>
+        size_t item_pos (const Iter& iter) const {
+            if (!iter.sorted)
+                return iter.i - items.data ();
+            auto& idx = get_index ();
+            return iter.si == idx.data() + idx.size() ? items.size() : *iter.si;
+        }
+
+        // Erase one item, keep the index if it is valid
+        iterator erase_impl (iterator pos) {
+            bool sorted = pos.sorted;
+            size_t item = item_pos (pos);
+            size_t index_offset = sorted ? pos.si - index.data() : 0;
+
+            items.erase (items.begin() + item);
+
+            if (index_valid.load(std::memory_order_relaxed)) {
+                auto i = sorted ?
+                    index.begin() + index_offset :
+                    std::find (index.begin(), index.end(), item);
+                index_offset = i - index.begin ();
+                index.erase (i);
+                for (auto& p : index) {
+                    if (p > item)
+                        --p;
+                }
+            }
+            if (sorted)
+                return iterator (items.data(), get_index().data() + index_offset);
+            else
+                return iterator (items.data() + item);
+        }
+
+        iterator to_mutable (const_iterator iter) {
+            if (iter.sorted)
+                return iterator (items.data(), iter.si);
+            else
+                return iterator (items.data() + (iter.i - items.data()));
+        }
+        const_iterator to_const (iterator iter) const {
+            if (iter.sorted)
+                return const_iterator (items.data(), iter.si);
+            else
+                return const_iterator (iter.i);
+        }
+    };
+
+
+}
+
+#endif
@@ -20,11 +20,75 @@
 #define UJSON_INTERNAL_HPP
 
 #include <ujson/jvalue.hpp>
+#include <ujson/jparser.hpp>
+#include <ujson/jtokenizer.hpp>
+#include <string>
 #include <unistd.h>
 
 namespace ujson {
     // Used to return references to invalid jvalues.
     extern jvalue invalid_jvalue;
+
+    // Parse a JSON pointer token that is an array index, defined
+    // as [0]|[1-9][0-9]*. Returns false if it isn't an array index,
+    // or if the index is too large to be stored in a size_t.
+    bool parse_array_index (const std::string& token, size_t& index) noexcept;
+
+    // Find the last valid member with a name in an object, or an item
+    // in an array, that the caller may change. The object or array is
+    // unshared, and its cached hash value is cleared, by calling its
+    // non-const accessor. Unlike jvalue::get(), members that are invalid
+    // values are not erased. Returns nullptr if not found.
+    jvalue* member_to_change (jvalue& object, const std::string& name);
+    jvalue* item_to_change (jvalue& array, const size_t index);
+
+    // Unescape a JSON string and append it to 'out', see ujson::unescape().
+    // Throws std::invalid_argument on an invalid escape sequence, the
+    // content of 'out' after the original content is then unspecified.
+    void unescape_append (const std::string_view& in, std::string& out);
+
+    // Return a description of a parser error code.
+    const std::string parser_err_to_str (jparser::err error);
+
+    // Convert a tokenizer error code to a parser error code.
+    jparser::err token_error_to_parser_error (const parser::jtoken::error_t token_error);
+
+    // Store a number token in a jvalue without using an mpf_class if
+    // that can be done without losing precision, or if ujson is built
+    // without gmpxx. Returns false if the token needs the slow path.
+    bool number_from_token (const std::string_view& str, jvalue& value);
+
+    // Convert a number in JSON syntax and store it in a jvalue.
+    // Throws std::invalid_argument or std::out_of_range on failure.
+    void number_from_string (const std::string& str, jvalue& value);
+
+#if UJSON_HAVE_GMPXX
+    // Write a number given as its significant digits and a decimal
+    // exponent, value = 0.<digits> * 10^e, in the same format as
+    // numbers stored as an mpf_class are written.
+    void digits_to_str (const char* s, long slen, long e, jwriter& out);
+#endif
+
+    // Store a double in a jvalue without converting it to an mpf_class.
+    void number_from_double (const double n, jvalue& value);
+
+    // Write a JSON number as a CBOR data item, see ujson::to_cbor().
+    void number_to_cbor (const jvalue& value, jwriter& out);
+
+    // Store a JSON number in a tape record, see ujson::to_tape().
+    void number_to_tape (const jvalue& value, jtape_writer& out);
+
+    // Store a number token as text in a jvalue, see jparser::lazy_numbers().
+    void number_as_text (const std::string_view& str, jvalue& value);
+
+    // Store a string token without escape sequences in a jvalue
+    // as a view of the parsed buffer, see jparser::borrow_strings().
+    void string_as_view (const std::string_view& str, jvalue& value);
+
+#if UJSON_HAVE_GMPXX
+    // Return the precision to use for an mpf_class parsed from a string.
+    mp_bitcnt_t number_precision (const std::string& str);
+#endif
 };
 
 #endif
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jarena.hpp>
+
+
+namespace ujson {
+
+
+    // The arena, and its memory resource, used in the current thread
+    static thread_local jarena* thread_arena = nullptr;
+    static thread_local std::pmr::memory_resource* thread_resource = nullptr;
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jarena::scope::scope (jarena& arena)
+        : prev_arena {thread_arena},
+          prev_resource {thread_resource}
+    {
+        thread_resource = arena.new_resource ();
+        thread_arena = &arena;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jarena::scope::~scope ()
+    {
+        thread_arena = prev_arena;
+        thread_resource = prev_resource;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jarena::jarena (size_t block_size_arg)
+        : block_size {block_size_arg}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jarena* jarena::current ()
+    {
+        return thread_arena;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::pmr::memory_resource* jarena::resource ()
+    {
+        return thread_resource;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // A monotonic_buffer_resource isn't thread safe, so each
+    // scope allocates from a resource of its own.
+    //--------------------------------------------------------------------------
+    std::pmr::memory_resource* jarena::new_resource ()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        resources.emplace_back (block_size);
+        return &resources.back ();
+    }
+
+
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JARENA_HPP
+#define UJSON_JARENA_HPP
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <memory_resource>
+
+
+namespace ujson {
+
+
+    /**
+     * Memory arena for JSON values.
+     * While a jarena::scope is active in a thread, the data of
+     * JSON objects and arrays created in that thread is allocated
+     * from the arena instead of the heap. Strings and numbers are
+     * stored inside the jvalue itself.
+     * Memory in the arena is allocated in large blocks, and is
+     * released all at once when the arena is destroyed.
+     * This makes both creating and destroying large document
+     * trees, like the ones created by class jparser, faster.
+     * <br/>
+     * Note that only the fixed size part of each value is
+     * allocated from the arena. The characters of long strings,
+     * the digits of numbers, the elements of arrays, and so on,
+     * are still allocated from the heap.
+     * <br/>
+     * An arena must outlive all values allocated from it.
+     * Memory allocated from an arena isn't reused after the
+     * value is destroyed, so an arena is best suited for
+     * documents that are created once and then mostly read.
+     * <br/>
+     * Example:
+     * <pre>
+     * ujson::jarena arena;
+     * ujson::jvalue doc;
+     * {
+     *     ujson::jarena::scope use_arena (arena);
+     *     doc = parser.parse_file ("big.json");
+     * }
+     * // Use doc, and destroy it before the arena.
+     * </pre>
+     */
+    class jarena {
+    public:
+        /**
+         * Makes an arena used for new JSON values in the
+         * current thread until the scope is destroyed.
+         * Each scope gets its own memory from the arena, so
+         * scopes for the same arena can be active in several
+         * threads at the same time. Scopes can be nested, the
+         * previous arena is used again when a scope is destroyed.
+         */
+        class scope {
+        public:
+            /**
+             * Start using an arena in the current thread.
+             * @param arena The arena to use.
+             */
+            scope (jarena& arena);
+
+            /**
+             * Stop using the arena in the current thread.
+             */
+            ~scope ();
+
+            scope (const scope&) = delete;
+            scope& operator= (const scope&) = delete;
+
+        private:
+            jarena* prev_arena;
+            std::pmr::memory_resource* prev_resource;
+        };
+
+        /**
+         * Constructor.
+         * @param block_size The size of the first memory block
+         *                   allocated by each scope.
+         *                   Following blocks grow in size.
+         */
+        jarena (size_t block_size=64*1024);
+
+        /**
+         * Destructor.
+         * Release all memory allocated in the arena.
+         */
+        ~jarena () = default;
+
+        jarena (const jarena&) = delete;
+        jarena& operator= (const jarena&) = delete;
+
+        /**
+         * Return the arena used in the current thread.
+         * @return The arena used by the current thread,
+         *         or <code>nullptr</code> if no arena is used.
+         */
+        static jarena* current ();
+
+        /**
+         * Return the memory resource used in the current thread.
+         * @return The memory resource of the arena used in the current
+         *         thread, or <code>nullptr</code> if no arena is used.
+         */
+        static std::pmr::memory_resource* resource ();
+
+
+    private:
+        size_t block_size;
+        std::mutex mutex;
+        std::list<std::pmr::monotonic_buffer_resource> resources;
+
+        std::pmr::memory_resource* new_resource ();
+    };
+
+
+}
+#endif
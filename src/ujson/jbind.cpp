@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jbind.hpp>
+#include <ujson/jparser.hpp>
+#include <ujson/jwriter.hpp>
+#include <ujson/internal.hpp>
+#include <stdexcept>
+#include <cmath>
+
+
+namespace ujson::binding {
+
+
+    using parser::jtoken;
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static const char* token_error_to_string (jtoken::error_t err)
+    {
+        switch (err) {
+        case jtoken::err_string:
+            return "invalid string";
+        case jtoken::err_string_unterminated:
+            return "unterminated string";
+        case jtoken::err_string_escape:
+            return "invalid escape code";
+        case jtoken::err_string_utf8:
+            return "invalid UTF8 character";
+        case jtoken::err_number:
+        case jtoken::err_number_lone_minus:
+        case jtoken::err_number_no_frac:
+        case jtoken::err_number_no_exp:
+            return "invalid number";
+        case jtoken::err_unexpected_char:
+            return "unexpected character";
+        case jtoken::err_eob:
+            return "unexpected end of document";
+        default:
+            return "invalid token";
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    token_reader::token_reader (const std::string_view& json)
+        : tokenizer (json, true, false),
+          buf {json}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    token_reader::~token_reader ()
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jtoken& token_reader::next ()
+    {
+        auto token = tokenizer.next_token ();
+        if (token == nullptr) {
+            jtoken eob;
+            eob.offset = buf.size ();
+            fail (eob, "unexpected end of document");
+        }
+        if (token->type == jtoken::tk_invalid)
+            fail (*token, token_error_to_string(token->err_code));
+        return *token;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void token_reader::end ()
+    {
+        auto token = tokenizer.next_token ();
+        if (token != nullptr)
+            fail (*token, "expected end of document");
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Skip a value without recursion, counting the nesting depth.
+    //--------------------------------------------------------------------------
+    void token_reader::skip (const jtoken& first)
+    {
+        size_t depth = 0;
+        const jtoken* token = &first;
+        while (true) {
+            switch (token->type) {
+            case jtoken::tk_lcbrack:
+            case jtoken::tk_lbrack:
+                ++depth;
+                break;
+            case jtoken::tk_rcbrack:
+            case jtoken::tk_rbrack:
+                if (depth == 0)
+                    fail (*token, "unexpected token");
+                --depth;
+                break;
+            case jtoken::tk_separator:
+            case jtoken::tk_colon:
+                if (depth == 0)
+                    fail (*token, "unexpected token");
+                break;
+            default:
+                break;
+            }
+            if (depth == 0)
+                return;
+            token = &next ();
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string_view token_reader::name (const jtoken& token)
+    {
+        if (!token.has_escapes)
+            return token.data;
+        scratch.clear ();
+        try {
+            unescape_append (token.data, scratch);
+        }
+        catch (...) {
+            fail (token, "invalid string");
+        }
+        return scratch;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void token_reader::read (const jtoken& token, std::string& value)
+    {
+        if (token.type != jtoken::tk_string)
+            fail (token, "expected a string");
+        if (!token.has_escapes) {
+            value.assign (token.data);
+            return;
+        }
+        value.clear ();
+        try {
+            unescape_append (token.data, value);
+        }
+        catch (...) {
+            fail (token, "invalid string");
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Strings and literals are converted here, other
+    // values are skipped and then parsed by a jparser.
+    //--------------------------------------------------------------------------
+    void token_reader::read (const jtoken& token, jvalue& value)
+    {
+        size_t start;
+        size_t end;
+        switch (token.type) {
+        case jtoken::tk_string:
+            value = jvalue (j_string);
+            read (token, value.str());
+            return;
+        case jtoken::tk_true:
+        case jtoken::tk_false:
+            value = token.type == jtoken::tk_true;
+            return;
+        case jtoken::tk_null:
+            value = jvalue (j_null);
+            return;
+        case jtoken::tk_number:
+            start = token.offset;
+            end = start + token.data.size ();
+            break;
+        default:
+            start = token.offset;
+            skip (token);
+            end = tokenizer.offset ();
+            break;
+        }
+
+        if (!value_parser)
+            value_parser = std::make_unique<jparser> ();
+        value = value_parser->parse_buffer (buf.data()+start, end-start);
+        if (!value.valid()) {
+            jtoken at;
+            at.offset = start;
+            fail (at, "invalid value");
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void token_reader::fail (const jtoken& token, const char* what) const
+    {
+        auto pos = tokenizer.pos (token.offset);
+        throw std::invalid_argument (std::string("JSON error at line ")
+                                     + std::to_string(pos.first+1)
+                                     + ", column "
+                                     + std::to_string(pos.second+1)
+                                     + ": "
+                                     + what);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Infinity and NaN can't be written in JSON, they are written as null.
+    //--------------------------------------------------------------------------
+    void text_writer::number (double n)
+    {
+        if (!std::isfinite(n)) {
+            null ();
+            return;
+        }
+        char buf[32];
+        auto result = std::to_chars (buf, buf+sizeof(buf), n);
+        out.append (buf, result.ptr - buf);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Not widened to double, 0.1f is written as 0.1
+    // and not as 0.10000000149011612.
+    //--------------------------------------------------------------------------
+    void text_writer::number (float n)
+    {
+        if (!std::isfinite(n)) {
+            null ();
+            return;
+        }
+        char buf[32];
+        auto result = std::to_chars (buf, buf+sizeof(buf), n);
+        out.append (buf, result.ptr - buf);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void text_writer::string (const std::string_view& s)
+    {
+        out.push_back ('"');
+        if (jwriter::needs_escape(s, false)) {
+            jwriter w (out);
+            w.write_escaped (s, false);
+        }else{
+            out.append (s);
+        }
+        out.push_back ('"');
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void text_writer::value (const jvalue& v)
+    {
+        if (v.valid())
+            v.write (out);
+        else
+            null ();
+    }
+
+
+}
@@ -0,0 +1,665 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JBIND_HPP
+#define UJSON_JBIND_HPP
+
+#include <ujson/jvalue.hpp>
+#include <ujson/jtokenizer.hpp>
+#include <array>
+#include <tuple>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <utility>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+
+namespace ujson {
+
+
+    class jparser;
+
+
+    /**
+     * A member of a C++ struct bound to a JSON object member.
+     * Created by ujson::jfield().
+     */
+    template<typename T, typename M>
+    struct jfield_t {
+        std::string_view name; /**< The name of the JSON object member. */
+        M T::* member;         /**< The member of the struct. */
+    };
+
+
+    /**
+     * Bind a member of a C++ struct to a JSON object member.
+     * @param name The name of the JSON object member.
+     * @param member A pointer to the struct member.
+     * @see ujson::jbind
+     */
+    template<typename T, typename M>
+    constexpr jfield_t<T, M> jfield (std::string_view name, M T::* member)
+    {
+        return {name, member};
+    }
+
+
+    /**
+     * Describes how a C++ struct is read from and written as a JSON object.
+     * Specialize this template for a struct with a static constexpr
+     * tuple named <code>fields</code>, created by ujson::jfield(),
+     * to let ujson::from_json() and ujson::to_json() read and write
+     * the struct directly, without creating jvalue instances.
+     * <br/>
+     * Struct members can be of type <code>bool</code>, any integer or
+     * floating point type, <code>std::string</code>, ujson::jvalue,
+     * another struct with a jbind specialization, or a
+     * <code>std::vector</code> or <code>std::optional</code> of any of
+     * these types.
+     * <br/>
+     * Example:
+     * <pre>
+     * struct point {
+     *     int64_t x;
+     *     int64_t y;
+     *     std::optional&lt;std::string&gt; label;
+     * };
+     *
+     * template&lt;&gt; struct ujson::jbind&lt;point&gt; {
+     *     static constexpr auto fields = std::make_tuple (
+     *         ujson::jfield ("x", &point::x),
+     *         ujson::jfield ("y", &point::y),
+     *         ujson::jfield ("label", &point::label));
+     * };
+     *
+     * auto p = ujson::from_json&lt;point&gt; (R"({"x":1, "y":2})");
+     * auto text = ujson::to_json (p); // {"x":1,"y":2}
+     * </pre>
+     */
+    template<typename T>
+    struct jbind;
+
+
+    /**
+     * Helpers for ujson::from_json() and ujson::to_json().
+     */
+    namespace binding {
+
+
+        /**
+         * Reads tokens of a JSON document for ujson::from_json().
+         */
+        class token_reader {
+        public:
+            /**
+             * Constructor.
+             * @param json The JSON document to read.
+             */
+            token_reader (const std::string_view& json);
+
+            /**
+             * Destructor.
+             */
+            ~token_reader ();
+
+            token_reader (const token_reader&) = delete;
+            token_reader& operator= (const token_reader&) = delete;
+
+            /**
+             * Return the next token.
+             * The token is valid until next() is called again.
+             * @throw std::invalid_argument At the end of the
+             *                              document, or if the
+             *                              token is invalid.
+             */
+            const parser::jtoken& next ();
+
+            /**
+             * Check that there are no more tokens.
+             * @throw std::invalid_argument If there are more tokens.
+             */
+            void end ();
+
+            /**
+             * Skip a value.
+             * @param first The first token of the value.
+             */
+            void skip (const parser::jtoken& first);
+
+            /**
+             * Return the unescaped member name of a string token.
+             * The name is valid until next() is called.
+             */
+            std::string_view name (const parser::jtoken& token);
+
+            /**
+             * Read a string value.
+             */
+            void read (const parser::jtoken& token, std::string& value);
+
+            /**
+             * Read any JSON value.
+             */
+            void read (const parser::jtoken& token, jvalue& value);
+
+            /**
+             * Throw a std::invalid_argument describing an
+             * error at the position of a token.
+             */
+            [[noreturn]] void fail (const parser::jtoken& token, const char* what) const;
+
+        private:
+            parser::jtokenizer tokenizer;
+            std::string_view buf;
+            std::string scratch;
+            std::unique_ptr<jparser> value_parser;
+        };
+
+
+        /**
+         * Writes JSON text for ujson::to_json().
+         */
+        class text_writer {
+        public:
+            /**
+             * Constructor.
+             * @param out The string to append the output to.
+             */
+            text_writer (std::string& out_arg) : out {out_arg} {}
+
+            /**
+             * Write a character.
+             */
+            void put (char ch) {
+                out.push_back (ch);
+            }
+
+            /**
+             * Write <code>null</code>.
+             */
+            void null () {
+                out.append ("null", 4);
+            }
+
+            /**
+             * Write a boolean.
+             */
+            void boolean (bool b) {
+                if (b)
+                    out.append ("true", 4);
+                else
+                    out.append ("false", 5);
+            }
+
+            /**
+             * Write an integer.
+             */
+            template<typename I>
+            void integer (I n) {
+                char buf[24];
+                auto result = std::to_chars (buf, buf+sizeof(buf), n);
+                out.append (buf, result.ptr - buf);
+            }
+
+            /**
+             * Write a floating point number.
+             * Infinity and NaN are written as <code>null</code>.
+             */
+            void number (double n);
+
+            /**
+             * Write a single precision floating point number,
+             * with the shortest text that reads back as the
+             * same <code>float</code>.
+             * Infinity and NaN are written as <code>null</code>.
+             */
+            void number (float n);
+
+            /**
+             * Write a quoted and escaped string.
+             */
+            void string (const std::string_view& s);
+
+            /**
+             * Write a quoted member name followed by a colon.
+             */
+            void name (const std::string_view& s) {
+                string (s);
+                out.push_back (':');
+            }
+
+            /**
+             * Write any JSON value.
+             * An invalid value is written as <code>null</code>.
+             */
+            void value (const jvalue& v);
+
+        private:
+            std::string& out;
+        };
+
+
+        template<typename T> struct is_optional : std::false_type {};
+        template<typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+        template<typename T> struct is_vector : std::false_type {};
+        template<typename T, typename A> struct is_vector<std::vector<T, A>> : std::true_type {};
+
+        template<typename T, typename=void> struct is_bound : std::false_type {};
+        template<typename T> struct is_bound<T, std::void_t<decltype(jbind<T>::fields)>> : std::true_type {};
+
+        template<typename T> constexpr bool unsupported_type = false;
+
+
+        /**
+         * Hash of a member name.
+         */
+        constexpr uint32_t name_hash (std::string_view name, uint32_t seed)
+        {
+            uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+            for (char ch : name) {
+                h ^= (unsigned char) ch;
+                h *= 16777619u;
+            }
+            return h ^ (h >> 16);
+        }
+
+
+        /**
+         * Size and seed of a perfect hash table of member names.
+         */
+        struct hash_params_t {
+            size_t size;
+            uint32_t seed;
+        };
+
+
+        /**
+         * Find the smallest table size, a power of two, and a seed
+         * that give each member name its own slot in the table.
+         * The size is 0 if two members have the same name.
+         */
+        template<size_t N>
+        constexpr hash_params_t find_hash_params (const std::array<std::string_view, N>& names)
+        {
+            for (size_t i=0; i<N; ++i) {
+                for (size_t j=i+1; j<N; ++j) {
+                    if (names[i] == names[j])
+                        return {0, 0};
+                }
+            }
+            size_t size = 1;
+            while (size < 2*N)
+                size *= 2;
+            for (;; size*=2) {
+                for (uint32_t seed=0; seed<64; ++seed) {
+                    bool collision = false;
+                    for (size_t i=0; i<N && !collision; ++i) {
+                        auto slot = name_hash (names[i], seed) & (size-1);
+                        for (size_t j=i+1; j<N && !collision; ++j)
+                            collision = slot == (name_hash(names[j], seed) & (size-1));
+                    }
+                    if (!collision)
+                        return {size, seed};
+                }
+            }
+        }
+
+
+        template<typename T> void read_value (token_reader& in, const parser::jtoken& token, T& value);
+        template<typename T> void write_value (text_writer& out, const T& value);
+
+
+        /**
+         * The members of a struct bound by ujson::jbind,
+         * and a perfect hash table to find them by name.
+         */
+        template<typename T>
+        struct field_table {
+            using fields_t = std::decay_t<decltype(jbind<T>::fields)>;
+            using reader_t = void (*) (token_reader&, const parser::jtoken&, T&);
+
+            static constexpr size_t count = std::tuple_size_v<fields_t>;
+
+            template<size_t... I>
+            static constexpr std::array<std::string_view, count> make_names (std::index_sequence<I...>) {
+                return {std::get<I>(jbind<T>::fields).name...};
+            }
+            static constexpr std::array<std::string_view, count> names = make_names (std::make_index_sequence<count>());
+
+            static constexpr hash_params_t params = find_hash_params (names);
+            static_assert (params.size != 0, "Duplicate member names in ujson::jbind");
+
+            static constexpr std::array<uint32_t, params.size> make_slots () {
+                std::array<uint32_t, params.size> slots {};
+                for (auto& slot : slots)
+                    slot = count;
+                for (size_t i=0; i<count; ++i)
+                    slots[name_hash(names[i], params.seed) & (params.size-1)] = i;
+                return slots;
+            }
+            static constexpr std::array<uint32_t, params.size> slots = make_slots ();
+
+            template<size_t I>
+            static void read_field (token_reader& in, const parser::jtoken& token, T& obj) {
+                read_value (in, token, obj.*(std::get<I>(jbind<T>::fields).member));
+            }
+            template<size_t... I>
+            static constexpr std::array<reader_t, count> make_readers (std::index_sequence<I...>) {
+                return {&read_field<I>...};
+            }
+            static constexpr std::array<reader_t, count> readers = make_readers (std::make_index_sequence<count>());
+
+            /**
+             * Return the index of a member, or <code>count</code> if not found.
+             */
+            static size_t find (std::string_view name) {
+                size_t i = slots[name_hash(name, params.seed) & (params.size-1)];
+                return i<count && names[i]==name ? i : count;
+            }
+        };
+
+
+        /**
+         * Read a JSON object into a struct bound by ujson::jbind.
+         * Unknown members are skipped, and struct
+         * members not in the object are unchanged.
+         */
+        template<typename T>
+        void read_object (token_reader& in, const parser::jtoken& token, T& obj)
+        {
+            using parser::jtoken;
+            using table = field_table<T>;
+
+            if (token.type != jtoken::tk_lcbrack)
+                in.fail (token, "expected an object");
+            const jtoken* t = &in.next ();
+            if (t->type == jtoken::tk_rcbrack)
+                return;
+            while (true) {
+                if (t->type != jtoken::tk_string)
+                    in.fail (*t, "expected an object member name");
+                size_t i = table::find (in.name(*t));
+                t = &in.next ();
+                if (t->type != jtoken::tk_colon)
+                    in.fail (*t, "expected ':'");
+                t = &in.next ();
+                if (i < table::count)
+                    table::readers[i] (in, *t, obj);
+                else
+                    in.skip (*t);
+                t = &in.next ();
+                if (t->type == jtoken::tk_rcbrack)
+                    return;
+                if (t->type != jtoken::tk_separator)
+                    in.fail (*t, "expected ',' or '}'");
+                t = &in.next ();
+            }
+        }
+
+
+        /**
+         * Read a JSON value into a C++ variable.
+         * @param in The token reader.
+         * @param token The first token of the value.
+         * @param value The variable to read the value into.
+         */
+        template<typename T>
+        void read_value (token_reader& in, const parser::jtoken& token, T& value)
+        {
+            using parser::jtoken;
+
+            if constexpr (is_optional<T>::value) {
+                if (token.type == jtoken::tk_null) {
+                    value.reset ();
+                }else{
+                    if (!value)
+                        value.emplace ();
+                    read_value (in, token, *value);
+                }
+            }
+            else if constexpr (std::is_same_v<T, bool>) {
+                if (token.type == jtoken::tk_true)
+                    value = true;
+                else if (token.type == jtoken::tk_false)
+                    value = false;
+                else
+                    in.fail (token, "expected a boolean");
+            }
+            else if constexpr (std::is_arithmetic_v<T>) {
+                if (token.type != jtoken::tk_number)
+                    in.fail (token, "expected a number");
+                const char* last = token.data.data() + token.data.size();
+                auto result = std::from_chars (token.data.data(), last, value);
+                if (result.ec == std::errc::result_out_of_range)
+                    in.fail (token, "number out of range");
+                if (result.ec != std::errc() || result.ptr != last)
+                    in.fail (token, std::is_integral_v<T> ? "expected an integer" : "expected a number");
+            }
+            else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, jvalue>) {
+                in.read (token, value);
+            }
+            else if constexpr (is_vector<T>::value) {
+                if (token.type != jtoken::tk_lbrack)
+                    in.fail (token, "expected an array");
+                value.clear ();
+                const jtoken* t = &in.next ();
+                if (t->type == jtoken::tk_rbrack)
+                    return;
+                while (true) {
+                    if constexpr (std::is_same_v<typename T::value_type, bool>) {
+                        bool item;
+                        read_value (in, *t, item);
+                        value.push_back (item);
+                    }else{
+                        read_value (in, *t, value.emplace_back());
+                    }
+                    t = &in.next ();
+                    if (t->type == jtoken::tk_rbrack)
+                        return;
+                    if (t->type != jtoken::tk_separator)
+                        in.fail (*t, "expected ',' or ']'");
+                    t = &in.next ();
+                }
+            }
+            else if constexpr (is_bound<T>::value) {
+                read_object (in, token, value);
+            }
+            else {
+                static_assert (unsupported_type<T>, "Type not supported by ujson::from_json");
+            }
+        }
+
+
+        /**
+         * Write a member of a struct bound by ujson::jbind.
+         * Empty <code>std::optional</code> members are not written.
+         */
+        template<typename T, typename M>
+        void write_field (text_writer& out, const jfield_t<T, M>& field, const T& obj, bool& first)
+        {
+            const M& value = obj.*(field.member);
+            if constexpr (is_optional<M>::value) {
+                if (!value)
+                    return;
+            }
+            if (!first)
+                out.put (',');
+            first = false;
+            out.name (field.name);
+            write_value (out, value);
+        }
+
+
+        /**
+         * Write a struct bound by ujson::jbind as a JSON object.
+         */
+        template<typename T, size_t... I>
+        void write_object (text_writer& out, const T& obj, std::index_sequence<I...>)
+        {
+            bool first = true;
+            out.put ('{');
+            (write_field(out, std::get<I>(jbind<T>::fields), obj, first), ...);
+            out.put ('}');
+        }
+
+
+        /**
+         * Write a C++ variable as a JSON value.
+         */
+        template<typename T>
+        void write_value (text_writer& out, const T& value)
+        {
+            if constexpr (is_optional<T>::value) {
+                if (value)
+                    write_value (out, *value);
+                else
+                    out.null ();
+            }
+            else if constexpr (std::is_same_v<T, bool>) {
+                out.boolean (value);
+            }
+            else if constexpr (std::is_integral_v<T>) {
+                out.integer (value);
+            }
+            else if constexpr (std::is_same_v<T, float>) {
+                out.number (value);
+            }
+            else if constexpr (std::is_floating_point_v<T>) {
+                out.number (static_cast<double>(value));
+            }
+            else if constexpr (std::is_same_v<T, std::string>) {
+                out.string (value);
+            }
+            else if constexpr (std::is_same_v<T, jvalue>) {
+                out.value (value);
+            }
+            else if constexpr (is_vector<T>::value) {
+                out.put ('[');
+                bool first = true;
+                for (const auto& item : value) {
+                    if (!first)
+                        out.put (',');
+                    first = false;
+                    write_value (out, static_cast<const typename T::value_type&>(item));
+                }
+                out.put (']');
+            }
+            else if constexpr (is_bound<T>::value) {
+                using fields_t = std::decay_t<decltype(jbind<T>::fields)>;
+                write_object (out, value, std::make_index_sequence<std::tuple_size_v<fields_t>>());
+            }
+            else {
+                static_assert (unsupported_type<T>, "Type not supported by ujson::to_json");
+            }
+        }
+
+
+    }
+
+
+    /**
+     * Read a JSON document directly into a C++ variable.
+     * The tokens of the document are converted directly to the
+     * C++ types, without creating jvalue instances. Structs are read
+     * as JSON objects and must have a ujson::jbind specialization.
+     * Member names are found with a perfect hash table created at
+     * compile time. Unknown object members are skipped, and struct
+     * members that are not in the JSON object are left unchanged.
+     * A <code>null</code> value is only allowed for
+     * <code>std::optional</code> members.
+     * <br/>
+     * The document is parsed in strict mode, and integers must be
+     * written without fraction and exponent, and fit in the type of
+     * the member.
+     * @param json The JSON document.
+     * @param value The variable to read the document into.
+     * @throw std::invalid_argument If the document isn't valid JSON,
+     *                              or doesn't match the type of
+     *                              <code>value</code>.
+     * @see ujson::jbind
+     * @see ujson::to_json()
+     */
+    template<typename T>
+    void from_json (const std::string_view& json, T& value)
+    {
+        binding::token_reader in (json);
+        binding::read_value (in, in.next(), value);
+        in.end ();
+    }
+
+
+    /**
+     * Read a JSON document directly into a C++ variable.
+     * @param json The JSON document.
+     * @return The variable read from the document.
+     * @throw std::invalid_argument If the document isn't valid JSON,
+     *                              or doesn't match type <code>T</code>.
+     * @see ujson::from_json(const std::string_view&, T&)
+     */
+    template<typename T>
+    T from_json (const std::string_view& json)
+    {
+        T value {};
+        from_json (json, value);
+        return value;
+    }
+
+
+    /**
+     * Write a C++ variable as compact JSON text.
+     * Structs are written as JSON objects, and must have a
+     * ujson::jbind specialization. Empty <code>std::optional</code>
+     * struct members are not written, other empty
+     * <code>std::optional</code> values are written as <code>null</code>.
+     * @param value The variable to write.
+     * @param out The string to append the JSON text to.
+     * @see ujson::jbind
+     * @see ujson::from_json()
+     */
+    template<typename T>
+    void to_json (const T& value, std::string& out)
+    {
+        binding::text_writer w (out);
+        binding::write_value (w, value);
+    }
+
+
+    /**
+     * Write a C++ variable as compact JSON text.
+     * @param value The variable to write.
+     * @return The JSON text.
+     * @see ujson::to_json(const T&, std::string&)
+     */
+    template<typename T>
+    std::string to_json (const T& value)
+    {
+        std::string out;
+        to_json (value, out);
+        return out;
+    }
+
+
+}
+#endif
@@ -0,0 +1,1045 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jcbor.hpp>
+#include <ujson/jwriter.hpp>
+#include <ujson/internal.hpp>
+#include <stdexcept>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+
+namespace ujson {
+
+
+    // CBOR major types
+    static constexpr unsigned major_uint   = 0;
+    static constexpr unsigned major_nint   = 1;
+    static constexpr unsigned major_bytes  = 2;
+    static constexpr unsigned major_text   = 3;
+    static constexpr unsigned major_array  = 4;
+    static constexpr unsigned major_map    = 5;
+    static constexpr unsigned major_tag    = 6;
+    static constexpr unsigned major_simple = 7;
+
+    // Tags used for numbers
+    static constexpr uint64_t tag_pos_bignum  = 2;
+    static constexpr uint64_t tag_neg_bignum  = 3;
+    static constexpr uint64_t tag_decimal     = 4;
+    static constexpr uint64_t tag_bigfloat    = 5;
+
+    // Integers with more digits than this are written as decimal fractions
+    static constexpr size_t max_bignum_digits = 100;
+
+    // Initial bytes of simple values and floats
+    static constexpr unsigned char cbor_false   = 0xf4;
+    static constexpr unsigned char cbor_true    = 0xf5;
+    static constexpr unsigned char cbor_null    = 0xf6;
+    static constexpr unsigned char cbor_undef   = 0xf7;
+    static constexpr unsigned char cbor_float16 = 0xf9;
+    static constexpr unsigned char cbor_float32 = 0xfa;
+    static constexpr unsigned char cbor_float64 = 0xfb;
+    static constexpr unsigned char cbor_break   = 0xff;
+
+
+    //--------------------------------------------------------------------------
+    // Check that a text string is UTF-8 encoded, with the same checks
+    // as the JSON tokenizer does for strings.
+    //--------------------------------------------------------------------------
+    static bool utf8_is_valid (const std::string_view& str)
+    {
+        auto pos = reinterpret_cast<const unsigned char*> (str.data());
+        auto end = pos + str.size ();
+        while (pos < end) {
+            // Skip ASCII characters, eight at a time
+            while (end - pos >= 8) {
+                uint64_t chunk;
+                std::memcpy (&chunk, pos, sizeof(chunk));
+                if (chunk & 0x8080808080808080ULL)
+                    break;
+                pos += 8;
+            }
+            if (pos == end)
+                break;
+            unsigned ch = *pos++;
+            if (ch < 0x80)
+                continue;
+            int count;
+            if (ch >= 0xc2  &&  ch <= 0xdf)
+                count = 1;
+            else if (ch >= 0xe0  &&  ch <= 0xef)
+                count = 2;
+            else if (ch >= 0xf0  &&  ch <= 0xf4)
+                count = 3;
+            else
+                return false;
+            if (end - pos < count)
+                return false;
+            for (; count>0; --count) {
+                if ((*pos++ & 0xc0) != 0x80)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write the head of a data item with an argument of 24 or more.
+    //--------------------------------------------------------------------------
+    static void put_long_head (jwriter& out, unsigned major, uint64_t arg)
+    {
+        char buf[9];
+        char lead = (char) (major << 5);
+        size_t n;
+        if (arg <= 0xff) {
+            buf[0] = lead | 24;
+            n = 1;
+        }
+        else if (arg <= 0xffff) {
+            buf[0] = lead | 25;
+            n = 2;
+        }
+        else if (arg <= 0xffffffff) {
+            buf[0] = lead | 26;
+            n = 4;
+        }
+        else {
+            buf[0] = lead | 27;
+            n = 8;
+        }
+        for (size_t i=n; i>0; --i) {
+            buf[i] = (char) (arg & 0xff);
+            arg >>= 8;
+        }
+        out.write (buf, n+1);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write the head of a data item, a major type and an argument.
+    //--------------------------------------------------------------------------
+    static inline void put_head (jwriter& out, unsigned major, uint64_t arg)
+    {
+        if (arg < 24)
+            out.put ((char) ((major << 5) | arg));
+        else
+            put_long_head (out, major, arg);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write an integer with a sign and a magnitude.
+    //--------------------------------------------------------------------------
+    static void put_integer (jwriter& out, bool negative, uint64_t magnitude)
+    {
+        if (negative && magnitude)
+            put_head (out, major_nint, magnitude - 1);
+        else
+            put_head (out, major_uint, magnitude);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static void put_integer (jwriter& out, long n)
+    {
+        if (n < 0)
+            put_head (out, major_nint, (uint64_t) ~n); // -1 - n
+        else
+            put_head (out, major_uint, (uint64_t) n);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write a double as a single precision float if that is exact.
+    //--------------------------------------------------------------------------
+    static void put_double (jwriter& out, double n)
+    {
+        char buf[9];
+        if (!std::isfinite(n)) {
+            out.put ((char)cbor_null); // As in JSON text
+            return;
+        }
+        float f = (float) n;
+        if ((double)f == n) {
+            uint32_t bits;
+            std::memcpy (&bits, &f, sizeof(bits));
+            buf[0] = (char) cbor_float32;
+            for (int i=4; i>0; --i, bits>>=8)
+                buf[i] = (char) (bits & 0xff);
+            out.write (buf, 5);
+        }else{
+            uint64_t bits;
+            std::memcpy (&bits, &n, sizeof(bits));
+            buf[0] = (char) cbor_float64;
+            for (int i=8; i>0; --i, bits>>=8)
+                buf[i] = (char) (bits & 0xff);
+            out.write (buf, 9);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Convert decimal digits to a big-endian unsigned integer,
+    // optionally subtracting one from it (for negative bignums).
+    //--------------------------------------------------------------------------
+    static std::string digits_to_bignum (const std::string_view& digits, bool minus_one)
+    {
+        // Little-endian limbs of 32 bits
+        std::vector<uint32_t> limbs;
+        size_t pos = 0;
+        while (pos < digits.size()) {
+            size_t n = std::min (digits.size() - pos, (size_t)9);
+            uint64_t mul = 1;
+            uint64_t carry = 0;
+            for (size_t i=0; i<n; ++i) {
+                mul *= 10;
+                carry = carry * 10 + (digits[pos+i] - '0');
+            }
+            pos += n;
+            for (auto& limb : limbs) {
+                uint64_t t = (uint64_t)limb * mul + carry;
+                limb = (uint32_t) t;
+                carry = t >> 32;
+            }
+            if (carry)
+                limbs.push_back ((uint32_t)carry);
+        }
+        if (minus_one) {
+            for (auto& limb : limbs) {
+                if (limb-- != 0)
+                    break;
+            }
+        }
+
+        std::string bytes;
+        bytes.reserve (limbs.size() * 4);
+        for (auto i=limbs.rbegin(); i!=limbs.rend(); ++i) {
+            for (int shift=24; shift>=0; shift-=8) {
+                char byte = (char) ((*i >> shift) & 0xff);
+                if (bytes.empty() && byte == 0)
+                    continue; // Skip leading zeros
+                bytes.push_back (byte);
+            }
+        }
+        return bytes;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write a number given as the decimal digits of an integer
+    // mantissa and an exponent of 10. As an integer if possible,
+    // otherwise as a decimal fraction.
+    //--------------------------------------------------------------------------
+    static void put_decimal (jwriter& out, bool negative, std::string_view digits, long exp)
+    {
+        while (!digits.empty() && digits.front() == '0')
+            digits.remove_prefix (1);
+        if (digits.empty()) {
+            put_head (out, major_uint, 0);
+            return;
+        }
+        while (digits.back() == '0') {
+            digits.remove_suffix (1);
+            ++exp;
+        }
+
+        uint64_t mantissa = 0;
+        auto result = std::from_chars (digits.data(), digits.data()+digits.size(), mantissa);
+        bool fits = result.ec == std::errc ();
+
+        if (fits  &&  exp >= 0  &&  exp < 20) {
+            uint64_t n = mantissa;
+            long e = exp;
+            for (; e>0 && n <= std::numeric_limits<uint64_t>::max()/10; --e)
+                n *= 10;
+            if (e == 0) {
+                put_integer (out, negative, n);
+                return;
+            }
+        }
+        if (exp >= 0  &&  digits.size() + exp <= max_bignum_digits) {
+            // A large integer
+            std::string integer (digits);
+            integer.append (exp, '0');
+            auto bytes = digits_to_bignum (integer, negative);
+            put_head (out, major_tag, negative ? tag_neg_bignum : tag_pos_bignum);
+            put_head (out, major_bytes, bytes.size());
+            out.write (bytes);
+            return;
+        }
+
+        put_head (out, major_tag, tag_decimal);
+        put_head (out, major_array, 2);
+        put_integer (out, exp < 0, exp < 0 ? -(uint64_t)exp : (uint64_t)exp);
+        if (fits) {
+            put_integer (out, negative, mantissa);
+        }else{
+            auto bytes = digits_to_bignum (digits, negative);
+            put_head (out, major_tag, negative ? tag_neg_bignum : tag_pos_bignum);
+            put_head (out, major_bytes, bytes.size());
+            out.write (bytes);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write a number in JSON syntax, from jparser::lazy_numbers().
+    //--------------------------------------------------------------------------
+    static void put_number_text (jwriter& out, const std::string_view& text)
+    {
+        const char* pos = text.data ();
+        const char* end = pos + text.size ();
+        bool negative = pos<end && *pos == '-';
+        if (negative)
+            ++pos;
+
+        std::string digits;
+        long exp = 0;
+        for (; pos<end && *pos>='0' && *pos<='9'; ++pos)
+            digits.push_back (*pos);
+        if (pos<end && *pos=='.') {
+            for (++pos; pos<end && *pos>='0' && *pos<='9'; ++pos) {
+                digits.push_back (*pos);
+                --exp;
+            }
+        }
+        bool ok = true;
+        if (pos<end && (*pos=='e' || *pos=='E')) {
+            ++pos;
+            if (pos<end && *pos=='+')
+                ++pos;
+            long e;
+            auto result = std::from_chars (pos, end, e);
+            ok = result.ec == std::errc()  &&
+                e > std::numeric_limits<long>::min() / 2  &&
+                e < std::numeric_limits<long>::max() / 2;
+            pos = result.ptr;
+            exp += e;
+        }
+        if (ok && pos == end) {
+            put_decimal (out, negative, digits, exp);
+        }else{
+            // Not in JSON syntax, let the number conversion handle it
+            jvalue number;
+            number_from_string (std::string(text), number);
+            number_to_cbor (number, out);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void number_to_cbor (const jvalue& value, jwriter& out)
+    {
+        if (value.repr == jvalue::num_text) {
+            put_number_text (out, value.v.jstr);
+            return;
+        }
+#if UJSON_HAVE_GMPXX
+        switch (value.repr) {
+        case jvalue::num_long:
+            put_integer (out, value.v.jlong);
+            break;
+        case jvalue::num_dbl:
+            put_double (out, value.v.jdbl);
+            break;
+        default:
+            {
+                // The same digits as written in JSON text,
+                // the value is 0.<digits> * 10^e
+                mp_exp_t e;
+                std::string str = value.v.jnum.get_str (e);
+                std::string_view digits (str);
+                bool negative = !digits.empty() && digits.front() == '-';
+                if (negative)
+                    digits.remove_prefix (1);
+                put_decimal (out, negative, digits, (long)e - (long)digits.size());
+            }
+        }
+#else
+        double n = value.v.jnum;
+        if (std::trunc(n) == n  &&  std::abs(n) < 9007199254740992.0  &&  !std::signbit(n))
+            put_head (out, major_uint, (uint64_t) n); // Exact integer
+        else if (std::trunc(n) == n  &&  std::abs(n) < 9007199254740992.0  &&  n != 0.0)
+            put_integer (out, (long) n);
+        else
+            put_double (out, n);
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static void value_to_cbor (const jvalue& value, jwriter& out)
+    {
+        switch (value.type()) {
+        case j_object:
+            {
+                auto& members = value.obj ();
+                size_t n = 0;
+                for (auto& member : members)
+                    n += member.second.valid() ? 1 : 0;
+                put_head (out, major_map, n);
+                for (auto& member : members) {
+                    if (!member.second.valid())
+                        continue;
+                    const std::string& name = member.first;
+                    put_head (out, major_text, name.size());
+                    out.write (name);
+                    value_to_cbor (member.second, out);
+                }
+            }
+            break;
+
+        case j_array:
+            {
+                auto& items = value.array ();
+                size_t n = 0;
+                for (auto& item : items)
+                    n += item.valid() ? 1 : 0;
+                put_head (out, major_array, n);
+                for (auto& item : items) {
+                    if (item.valid())
+                        value_to_cbor (item, out);
+                }
+            }
+            break;
+
+        case j_string:
+            {
+                auto str = value.str_view ();
+                put_head (out, major_text, str.size());
+                out.write (str);
+            }
+            break;
+
+        case j_number:
+            number_to_cbor (value, out);
+            break;
+
+        case j_bool:
+            out.put ((char) (value.boolean() ? cbor_true : cbor_false));
+            break;
+
+        case j_null:
+            out.put ((char) cbor_null);
+            break;
+
+        case j_invalid:
+        default:
+            break;
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void to_cbor (const jvalue& instance, std::string& out)
+    {
+        if (instance.invalid())
+            throw std::invalid_argument ("Invalid JSON value");
+        jwriter writer (out);
+        value_to_cbor (instance, writer);
+        writer.flush ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string to_cbor (const jvalue& instance)
+    {
+        std::string out;
+        to_cbor (instance, out);
+        return out;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void to_cbor (const jvalue& instance, std::ostream& out)
+    {
+        if (instance.invalid())
+            throw std::invalid_argument ("Invalid JSON value");
+        jwriter::handler_t handler = [&out](const char* data, size_t size) {
+            out.write (data, size);
+        };
+        jwriter writer (handler);
+        value_to_cbor (instance, writer);
+        writer.flush ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Decodes one CBOR data item. Arrays and maps are decoded without
+    // recursion, so the nesting depth is only limited by memory. Each
+    // value is decoded in its place in the array or object it belongs to.
+    //--------------------------------------------------------------------------
+    class cbor_decoder {
+    public:
+        cbor_decoder (const void* data, size_t size, bool allow_duplicates)
+            : start {static_cast<const unsigned char*>(data)},
+              pos {start},
+              end {start + size},
+              allow_duplicates {allow_duplicates}
+            {
+            }
+
+        jvalue decode ();
+
+        size_t length () const {
+            return pos - start;
+        }
+
+    private:
+        // An array or map being decoded. Nothing is added to the array or
+        // object containing it until it is decoded, so the pointers are valid.
+        struct frame_t {
+            json_object* members; // nullptr for an array
+            json_array* items;
+            uint64_t left;        // Number of items, or pairs, left
+            bool indefinite;
+        };
+
+        const unsigned char* start;
+        const unsigned char* pos;
+        const unsigned char* end;
+        bool allow_duplicates;
+        std::vector<frame_t> frames;
+
+        [[noreturn]] void error (const char* what) const;
+        void need (uint64_t size) const {
+            if (size > (uint64_t)(end - pos))
+                error ("Unexpected end of data");
+        }
+        unsigned read_head (uint64_t& arg, bool& indefinite);
+        std::string_view read_chunk (unsigned major, uint64_t size);
+        void read_string (unsigned major, uint64_t arg, bool indefinite, std::string& out);
+        void read_value (jvalue& value);
+        json_key read_name (json_object& members);
+        bool frame_done (frame_t& frame);
+        void read_tagged_number (uint64_t tag, jvalue& value);
+        void read_integer (std::string& digits, bool& negative, uint64_t& bits);
+        void number_from_text (const std::string& text, jvalue& value) const;
+    };
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void cbor_decoder::error (const char* what) const
+    {
+        std::string msg ("Invalid CBOR data at offset ");
+        msg.append (std::to_string(pos - start));
+        msg.append (": ");
+        msg.append (what);
+        throw std::invalid_argument (msg);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Read the head of a data item and return its major type.
+    //--------------------------------------------------------------------------
+    unsigned cbor_decoder::read_head (uint64_t& arg, bool& indefinite)
+    {
+        need (1);
+        unsigned major = *pos >> 5;
+        unsigned info = *pos & 0x1f;
+        ++pos;
+        indefinite = false;
+        if (info < 24) {
+            arg = info;
+        }
+        else if (info <= 27) {
+            size_t n = (size_t)1 << (info - 24);
+            need (n);
+            arg = 0;
+            for (size_t i=0; i<n; ++i)
+                arg = (arg << 8) | *pos++;
+        }
+        else if (info == 31  &&  major >= major_bytes  &&  major <= major_map) {
+            indefinite = true;
+            arg = 0;
+        }
+        else {
+            --pos;
+            error (info == 31 ? "Unexpected break" : "Reserved additional information");
+        }
+        return major;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string_view cbor_decoder::read_chunk (unsigned major, uint64_t size)
+    {
+        need (size);
+        std::string_view chunk ((const char*)pos, size);
+        pos += size;
+        if (major == major_text  &&  !utf8_is_valid(chunk))
+            error ("Invalid UTF-8 in text string");
+        return chunk;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Read the content of a byte or text string.
+    //--------------------------------------------------------------------------
+    void cbor_decoder::read_string (unsigned major, uint64_t arg, bool indefinite, std::string& out)
+    {
+        if (!indefinite) {
+            out.append (read_chunk(major, arg));
+            return;
+        }
+        for (;;) {
+            need (1);
+            if (*pos == cbor_break) {
+                ++pos;
+                return;
+            }
+            bool chunk_indefinite;
+            if (read_head(arg, chunk_indefinite) != major  ||  chunk_indefinite)
+                error ("Invalid chunk in indefinite length string");
+            out.append (read_chunk(major, arg));
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void cbor_decoder::number_from_text (const std::string& text, jvalue& value) const
+    {
+        try {
+            number_from_string (text, value);
+        }
+        catch (std::out_of_range&) {
+            error ("Number out of range");
+        }
+        catch (std::invalid_argument&) {
+            error ("Invalid number");
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Read an integer or a bignum as decimal digits. 'bits' is set
+    // to an upper limit of the number of bits in the magnitude.
+    //--------------------------------------------------------------------------
+    void cbor_decoder::read_integer (std::string& digits, bool& negative, uint64_t& bits)
+    {
+        uint64_t arg;
+        bool indefinite;
+        auto major = read_head (arg, indefinite);
+        if (major == major_uint  ||  major == major_nint) {
+            negative = major == major_nint;
+            if (negative) {
+                if (arg == std::numeric_limits<uint64_t>::max())
+                    digits = "18446744073709551616";
+                else
+                    digits = std::to_string (arg + 1);
+            }else{
+                digits = std::to_string (arg);
+            }
+            bits = 64;
+            return;
+        }
+        if (major != major_tag  ||  (arg != tag_pos_bignum && arg != tag_neg_bignum))
+            error ("Expected an integer");
+        negative = arg == tag_neg_bignum;
+        major = read_head (arg, indefinite);
+        if (major != major_bytes)
+            error ("Expected a byte string in bignum");
+        std::string bytes;
+        read_string (major, arg, indefinite, bytes);
+        bits = bytes.size() * 8 + 1;
+
+        // Big-endian bytes to little-endian limbs of 32 bits
+        std::vector<uint32_t> limbs ((bytes.size() + 3) / 4, 0);
+        for (size_t i=0; i<bytes.size(); ++i) {
+            size_t n = bytes.size() - 1 - i;
+            limbs[n/4] |= (uint32_t)(unsigned char)bytes[i] << ((n % 4) * 8);
+        }
+        if (negative) {
+            // -1 - n
+            bool carry = true;
+            for (auto& limb : limbs) {
+                if (!carry)
+                    break;
+                carry = ++limb == 0;
+            }
+            if (carry)
+                limbs.push_back (1);
+        }
+
+        // Divide by 10^9 until zero
+        std::vector<uint32_t> parts; // Groups of 9 digits, least significant first
+        while (!limbs.empty() && limbs.back() == 0)
+            limbs.pop_back ();
+        while (!limbs.empty()) {
+            uint64_t rem = 0;
+            for (auto i=limbs.rbegin(); i!=limbs.rend(); ++i) {
+                uint64_t t = (rem << 32) | *i;
+                *i = (uint32_t) (t / 1000000000);
+                rem = t % 1000000000;
+            }
+            parts.push_back ((uint32_t)rem);
+            while (!limbs.empty() && limbs.back() == 0)
+                limbs.pop_back ();
+        }
+        digits.clear ();
+        if (parts.empty())
+            digits.push_back ('0');
+        for (auto i=parts.rbegin(); i!=parts.rend(); ++i) {
+            auto part = std::to_string (*i);
+            if (i != parts.rbegin())
+                digits.append (9 - part.size(), '0');
+            digits.append (part);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Decode the content of a decimal fraction or a bigfloat.
+    //--------------------------------------------------------------------------
+    void cbor_decoder::read_tagged_number (uint64_t tag, jvalue& value)
+    {
+        std::string text;
+        bool negative;
+        uint64_t bits;
+        uint64_t size;
+        bool indefinite;
+        if (read_head(size, indefinite) != major_array  ||  indefinite  ||  size != 2)
+            error ("Expected an array of two integers");
+        uint64_t arg;
+        auto major = read_head (arg, indefinite);
+        if ((major != major_uint && major != major_nint)  ||  arg > 1000000000)
+            error ("Invalid exponent");
+        long exp = major == major_uint ? (long)arg : -1 - (long)arg;
+        read_integer (text, negative, bits);
+
+        if (tag == tag_decimal) {
+#if UJSON_HAVE_GMPXX
+            // Convert it the same way as if it was written
+            // in JSON text by jvalue::describe(), to get
+            // the same precision
+            std::string_view digits (text);
+            while (!digits.empty() && digits.front() == '0')
+                digits.remove_prefix (1);
+            while (!digits.empty() && digits.back() == '0') {
+                digits.remove_suffix (1);
+                ++exp;
+            }
+            std::string number;
+            if (negative && !digits.empty())
+                number.push_back ('-');
+            jwriter out (number);
+            digits_to_str (digits.data(), digits.size(), exp + (long)digits.size(), out);
+            out.flush ();
+            number_from_text (number, value);
+#else
+            if (negative)
+                text.insert (text.begin(), '-');
+            text.push_back ('e');
+            text.append (std::to_string(exp));
+            number_from_text (text, value);
+#endif
+            return;
+        }
+
+        // Bigfloat, mantissa * 2^exp
+#if UJSON_HAVE_GMPXX
+        if (negative)
+            text.insert (text.begin(), '-');
+        mpf_class number (text, std::max(mpf_get_default_prec(), (mp_bitcnt_t)bits));
+        if (exp >= 0)
+            mpf_mul_2exp (number.get_mpf_t(), number.get_mpf_t(), (mp_bitcnt_t)exp);
+        else
+            mpf_div_2exp (number.get_mpf_t(), number.get_mpf_t(), (mp_bitcnt_t)-exp);
+        value.num (std::move(number));
+#else
+        double number = std::ldexp (std::stod(text), (int)std::clamp(exp, -100000L, 100000L));
+        if (!std::isfinite(number))
+            error ("Number out of range");
+        value.num (negative ? -number : number);
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Read a data item that isn't a map key. If it starts an
+    // array or a map, its items are read after it is pushed
+    // to 'frames'.
+    //--------------------------------------------------------------------------
+    void cbor_decoder::read_value (jvalue& value)
+    {
+        uint64_t arg;
+        bool indefinite;
+        for (;;) {
+            auto item_start = pos;
+            auto major = read_head (arg, indefinite);
+            switch (major) {
+            case major_uint:
+                if (arg <= (uint64_t)std::numeric_limits<long>::max())
+                    value.num ((long)arg);
+                else
+                    number_from_text (std::to_string(arg), value);
+                return;
+
+            case major_nint:
+                if (arg <= (uint64_t)std::numeric_limits<long>::max()) {
+                    value.num (-1 - (long)arg);
+                }else{
+                    pos = item_start;
+                    std::string digits;
+                    bool negative;
+                    uint64_t bits;
+                    read_integer (digits, negative, bits);
+                    digits.insert (digits.begin(), '-');
+                    number_from_text (digits, value);
+                }
+                return;
+
+            case major_bytes:
+                {
+                    // As base64url without padding, RFC 8949 section 6.1
+                    static constexpr const char* alphabet =
+                        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+                    std::string bytes;
+                    read_string (major, arg, indefinite, bytes);
+                    std::string str;
+                    str.reserve ((bytes.size() * 4 + 2) / 3);
+                    size_t i = 0;
+                    for (; i+2<bytes.size(); i+=3) {
+                        uint32_t n = ((uint32_t)(unsigned char)bytes[i] << 16) |
+                            ((uint32_t)(unsigned char)bytes[i+1] << 8) | (unsigned char)bytes[i+2];
+                        str.push_back (alphabet[(n >> 18) & 0x3f]);
+                        str.push_back (alphabet[(n >> 12) & 0x3f]);
+                        str.push_back (alphabet[(n >> 6) & 0x3f]);
+                        str.push_back (alphabet[n & 0x3f]);
+                    }
+                    if (i < bytes.size()) {
+                        uint32_t n = (uint32_t)(unsigned char)bytes[i] << 16;
+                        if (i+1 < bytes.size())
+                            n |= (uint32_t)(unsigned char)bytes[i+1] << 8;
+                        str.push_back (alphabet[(n >> 18) & 0x3f]);
+                        str.push_back (alphabet[(n >> 12) & 0x3f]);
+                        if (i+1 < bytes.size())
+                            str.push_back (alphabet[(n >> 6) & 0x3f]);
+                    }
+                    value = std::move (str);
+                }
+                return;
+
+            case major_text:
+                if (!indefinite) {
+                    value = std::string (read_chunk(major, arg));
+                }else{
+                    std::string str;
+                    read_string (major, arg, indefinite, str);
+                    value = std::move (str);
+                }
+                return;
+
+            case major_array:
+            case major_map:
+                {
+                    // Each item is at least one byte
+                    if (!indefinite  &&  arg > (uint64_t)(end - pos) / (major == major_map ? 2 : 1))
+                        error ("Unexpected end of data");
+                    if (major == major_array) {
+                        value.type (j_array);
+                        auto& items = value.array ();
+                        if (!indefinite)
+                            items.reserve (arg);
+                        frames.push_back ({nullptr, &items, arg, indefinite});
+                    }else{
+                        value.type (j_object);
+                        frames.push_back ({&value.obj(), nullptr, arg, indefinite});
+                    }
+                }
+                return;
+
+            case major_tag:
+                if (arg >= tag_pos_bignum  &&  arg <= tag_bigfloat) {
+                    if (arg <= tag_neg_bignum) {
+                        pos = item_start; // read_integer() reads the tag
+                        std::string digits;
+                        bool negative;
+                        uint64_t bits;
+                        read_integer (digits, negative, bits);
+                        if (negative)
+                            digits.insert (digits.begin(), '-');
+                        number_from_text (digits, value);
+                    }else{
+                        read_tagged_number (arg, value);
+                    }
+                    return;
+                }
+                continue; // Ignore other tags
+
+            case major_simple:
+            default:
+                switch (*item_start) {
+                case cbor_false:
+                    value = false;
+                    return;
+                case cbor_true:
+                    value = true;
+                    return;
+                case cbor_null:
+                case cbor_undef:
+                    value = nullptr;
+                    return;
+                case cbor_float16:
+                case cbor_float32:
+                case cbor_float64:
+                    {
+                        double n;
+                        if (*item_start == cbor_float64) {
+                            std::memcpy (&n, &arg, sizeof(n));
+                        }
+                        else if (*item_start == cbor_float32) {
+                            uint32_t bits = (uint32_t) arg;
+                            float f;
+                            std::memcpy (&f, &bits, sizeof(f));
+                            n = f;
+                        }
+                        else {
+                            unsigned exp = (arg >> 10) & 0x1f;
+                            unsigned mant = arg & 0x3ff;
+                            if (exp == 0)
+                                n = std::ldexp (mant, -24);
+                            else if (exp != 31)
+                                n = std::ldexp (mant + 1024, exp - 25);
+                            else
+                                n = mant == 0 ? INFINITY : NAN;
+                            if (arg & 0x8000)
+                                n = -n;
+                        }
+                        if (std::isfinite(n))
+                            number_from_double (n, value);
+                        else
+                            value = nullptr; // As in JSON text
+                    }
+                    return;
+                default:
+                    pos = item_start;
+                    error ("Unsupported simple value");
+                }
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    json_key cbor_decoder::read_name (json_object& members)
+    {
+        uint64_t arg;
+        bool indefinite;
+        auto item_start = pos;
+        if (read_head(arg, indefinite) != major_text) {
+            pos = item_start;
+            error ("Map key is not a text string");
+        }
+        json_key name;
+        if (!indefinite) {
+            name = json_key (read_chunk(major_text, arg));
+        }else{
+            std::string str;
+            read_string (major_text, arg, indefinite, str);
+            name = json_key (std::move(str));
+        }
+        if (!allow_duplicates  &&  members.find(name) != members.end()) {
+            pos = item_start;
+            error ("Duplicate map key");
+        }
+        return name;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Check if all items of an array or map are decoded.
+    //--------------------------------------------------------------------------
+    bool cbor_decoder::frame_done (frame_t& frame)
+    {
+        if (!frame.indefinite)
+            return frame.left == 0;
+        need (1);
+        if (*pos != cbor_break)
+            return false;
+        ++pos;
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue cbor_decoder::decode ()
+    {
+        jvalue instance;
+        read_value (instance);
+        while (!frames.empty()) {
+            auto& frame = frames.back ();
+            if (frame_done(frame)) {
+                frames.pop_back ();
+                continue;
+            }
+            if (!frame.indefinite)
+                --frame.left;
+            if (frame.members)
+                read_value (frame.members->emplace_back(read_name(*frame.members), jvalue()).second);
+            else
+                read_value (frame.items->emplace_back());
+        }
+        return instance;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue from_cbor (const void* data, size_t size, size_t& length, bool allow_duplicates)
+    {
+        cbor_decoder decoder (data, size, allow_duplicates);
+        auto instance = decoder.decode ();
+        length = decoder.length ();
+        return instance;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue from_cbor (const void* data, size_t size, bool allow_duplicates)
+    {
+        size_t length;
+        auto instance = from_cbor (data, size, length, allow_duplicates);
+        if (length != size)
+            throw std::invalid_argument ("Invalid CBOR data at offset " + std::to_string(length) +
+                                         ": Data after the end of the data item");
+        return instance;
+    }
+
+
+}
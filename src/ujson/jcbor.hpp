@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JCBOR_HPP
+#define UJSON_JCBOR_HPP
+
+#include <ujson/jvalue.hpp>
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+
+namespace ujson {
+
+
+    /**
+     * Encode a JSON instance as CBOR, as described by RFC 8949.
+     * Strings, numbers and containers are written in binary form,
+     * so no number conversion or string escaping is needed.
+     * <ul>
+     *   <li>Objects are encoded as maps with text string keys, with
+     *       the members in natural order. Arrays are encoded as arrays.
+     *       Invalid values (of type ujson::j_invalid) are omitted.</li>
+     *   <li>Integers that fit in 64 bits are encoded as CBOR integers.</li>
+     *   <li>Other numbers stored as a double are encoded as a
+     *       single or double precision float, whichever is exact.
+     *       Infinity and NaN are encoded as <code>null</code>,
+     *       as they would be in JSON text.</li>
+     *   <li>Numbers stored as an <code>mpf_class</code>, and numbers
+     *       kept as text (see jparser::lazy_numbers()), are encoded
+     *       as decimal fractions (tag 4), with the same digits as in
+     *       the JSON text. Mantissas that don't fit in 64 bits
+     *       are encoded as bignums (tag 2 and 3).</li>
+     * </ul>
+     * @param instance The JSON instance to encode.
+     * @param out The string to append the encoded data to.
+     * @see ujson::from_cbor()
+     * @see <a href=https://datatracker.ietf.org/doc/html/rfc8949 rel="noopener noreferrer" target="_blank">RFC 8949 - Concise Binary Object Representation (CBOR)</a>
+     */
+    void to_cbor (const jvalue& instance, std::string& out);
+
+    /**
+     * Encode a JSON instance as CBOR, as described by RFC 8949.
+     * @param instance The JSON instance to encode.
+     * @return A string with the encoded data.
+     * @see ujson::to_cbor(const jvalue&, std::string&)
+     */
+    std::string to_cbor (const jvalue& instance);
+
+    /**
+     * Encode a JSON instance as CBOR and write it to an output stream.
+     * The data is written in chunks of limited size while
+     * the instance is encoded.
+     * @param instance The JSON instance to encode.
+     * @param out The output stream to write to.
+     * @see ujson::to_cbor(const jvalue&, std::string&)
+     */
+    void to_cbor (const jvalue& instance, std::ostream& out);
+
+    /**
+     * Decode a JSON instance from CBOR data, as described by RFC 8949.
+     * The data must contain exactly one CBOR data item.
+     * Data items are mapped to JSON values as suggested
+     * by RFC 8949, section 6.1:
+     * <ul>
+     *   <li>Maps must have text string keys, and are
+     *       decoded as objects. Arrays are decoded as arrays.
+     *       Indefinite length items are supported.</li>
+     *   <li>Integers, floats, bignums (tag 2 and 3), decimal fractions
+     *       (tag 4) and bigfloats (tag 5) are decoded as numbers.
+     *       Integers and floats are stored natively. Infinity
+     *       and NaN are decoded as <code>null</code>.</li>
+     *   <li>Byte strings are decoded as base64url encoded strings
+     *       without padding.</li>
+     *   <li><code>undefined</code> is decoded as <code>null</code>.
+     *       Other tags are ignored, and the tagged item is decoded.</li>
+     * </ul>
+     * \par Example:
+     * \code
+     * std::string data = ujson::to_cbor (instance);
+     * auto copy = ujson::from_cbor (data.data(), data.size()); // copy == instance
+     * \endcode
+     * @param data The CBOR data.
+     * @param size The size of the CBOR data.
+     * @param allow_duplicates If <code>false</code>, maps with
+     *                         duplicate keys are not allowed.
+     * @return The decoded JSON instance.
+     * @throw std::invalid_argument If the data isn't a well-formed
+     *                              CBOR data item, or contains a
+     *                              data item that can't be decoded
+     *                              as a JSON value.
+     * @see ujson::to_cbor()
+     * @see <a href=https://datatracker.ietf.org/doc/html/rfc8949 rel="noopener noreferrer" target="_blank">RFC 8949 - Concise Binary Object Representation (CBOR)</a>
+     */
+    jvalue from_cbor (const void* data, size_t size, bool allow_duplicates=true);
+
+    /**
+     * Decode the first CBOR data item in a buffer.
+     * This is used to decode a CBOR sequence (RFC 8742),
+     * a number of CBOR data items after each other.
+     * \par Example:
+     * \code
+     * const char* pos = data.data ();
+     * size_t left = data.size ();
+     * while (left) {
+     *     size_t length;
+     *     auto instance = ujson::from_cbor (pos, left, length);
+     *     pos += length;
+     *     left -= length;
+     * }
+     * \endcode
+     * @param data The CBOR data.
+     * @param size The size of the CBOR data.
+     * @param length Set to the size of the decoded data item.
+     * @param allow_duplicates If <code>false</code>, maps with
+     *                         duplicate keys are not allowed.
+     * @return The decoded JSON instance.
+     * @throw std::invalid_argument If the data doesn't start
+     *                              with a well-formed CBOR data
+     *                              item, or it can't be decoded
+     *                              as a JSON value.
+     * @see ujson::from_cbor(const void*, size_t, bool)
+     */
+    jvalue from_cbor (const void* data, size_t size, size_t& length, bool allow_duplicates=true);
+
+
+}
+#endif
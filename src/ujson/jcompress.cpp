@@ -0,0 +1,643 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/config.hpp>
+#include <ujson/jcompress.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#if (UJSON_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if (UJSON_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+
+namespace ujson {
+
+
+    // Size of the buffers of compressed data
+    static constexpr size_t compressed_buf_size = 128 * 1024;
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool compression_supported (compression_t method)
+    {
+        switch (method) {
+        case compression_t::none:
+            return true;
+        case compression_t::gzip:
+            return UJSON_HAVE_ZLIB;
+        case compression_t::zstd:
+            return UJSON_HAVE_ZSTD;
+        }
+        return false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    compression_t detect_compression (const char* data, size_t size)
+    {
+        auto magic = reinterpret_cast<const unsigned char*> (data);
+        if (size >= 2  &&  magic[0]==0x1f && magic[1]==0x8b)
+            return compression_t::gzip;
+        if (size >= 4  &&  magic[0]==0x28 && magic[1]==0xb5 && magic[2]==0x2f && magic[3]==0xfd)
+            return compression_t::zstd;
+        return compression_t::none;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    compression_t compression_from_name (const std::string& name)
+    {
+        if (name == "none")
+            return compression_t::none;
+        else if (name == "gzip")
+            return compression_t::gzip;
+        else if (name == "zstd")
+            return compression_t::zstd;
+        throw std::invalid_argument ("Unknown compression format");
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Decompresses input into the buffers of a jdecompressor.
+    //--------------------------------------------------------------------------
+    class stream_decoder {
+    public:
+        virtual ~stream_decoder () = default;
+
+        // Decompress data from 'in' to 'in_end' and append it to 'out',
+        // that has room for 'out_size' bytes. 'in' and 'out_len' are
+        // updated. Return an error message, or nullptr on success.
+        virtual const char* decode (const char*& in,
+                                    const char* in_end,
+                                    char* out,
+                                    size_t& out_len,
+                                    size_t out_size) = 0;
+
+        // Return true if the input so far ends a compressed stream.
+        virtual bool complete () const {
+            return true;
+        }
+    };
+
+
+    //--------------------------------------------------------------------------
+    // Uncompressed input.
+    //--------------------------------------------------------------------------
+    class copy_decoder : public stream_decoder {
+    public:
+        const char* decode (const char*& in,
+                            const char* in_end,
+                            char* out,
+                            size_t& out_len,
+                            size_t out_size) override
+        {
+            size_t n = std::min ((size_t)(in_end - in), out_size - out_len);
+            memcpy (out + out_len, in, n);
+            in += n;
+            out_len += n;
+            return nullptr;
+        }
+    };
+
+
+#if (UJSON_HAVE_ZLIB)
+    //--------------------------------------------------------------------------
+    // gzip compressed input, possibly with several gzip members.
+    //--------------------------------------------------------------------------
+    class gzip_decoder : public stream_decoder {
+    public:
+        gzip_decoder () {
+            memset (&zs, 0, sizeof(zs));
+            ok = inflateInit2 (&zs, 15 + 16) == Z_OK; // 16: gzip header
+            at_end = false;
+        }
+        ~gzip_decoder () override {
+            if (ok)
+                inflateEnd (&zs);
+        }
+        const char* decode (const char*& in,
+                            const char* in_end,
+                            char* out,
+                            size_t& out_len,
+                            size_t out_size) override
+        {
+            if (!ok)
+                return "Out of memory";
+            if (at_end) {
+                if (in == in_end)
+                    return nullptr;
+                // The next gzip member
+                inflateReset (&zs);
+                at_end = false;
+            }
+            zs.next_in = (Bytef*) in;
+            zs.avail_in = (uInt) std::min ((size_t)(in_end - in), (size_t)UINT_MAX);
+            zs.next_out = (Bytef*) (out + out_len);
+            zs.avail_out = (uInt) std::min (out_size - out_len, (size_t)UINT_MAX);
+            int result = inflate (&zs, Z_NO_FLUSH);
+            in = (const char*) zs.next_in;
+            out_len = (char*) zs.next_out - out;
+            if (result == Z_STREAM_END)
+                at_end = true;
+            else if (result != Z_OK && result != Z_BUF_ERROR)
+                return zs.msg ? zs.msg : "Invalid gzip data";
+            return nullptr;
+        }
+        bool complete () const override {
+            return at_end;
+        }
+
+    private:
+        z_stream zs;
+        bool ok;
+        bool at_end;
+    };
+#endif
+
+
+#if (UJSON_HAVE_ZSTD)
+    //--------------------------------------------------------------------------
+    // zstd compressed input, possibly with several frames.
+    //--------------------------------------------------------------------------
+    class zstd_decoder : public stream_decoder {
+    public:
+        zstd_decoder () {
+            ctx = ZSTD_createDCtx ();
+            frame_end = true;
+        }
+        ~zstd_decoder () override {
+            ZSTD_freeDCtx (ctx);
+        }
+        const char* decode (const char*& in,
+                            const char* in_end,
+                            char* out,
+                            size_t& out_len,
+                            size_t out_size) override
+        {
+            if (!ctx)
+                return "Out of memory";
+            ZSTD_inBuffer input {in, (size_t)(in_end - in), 0};
+            ZSTD_outBuffer output {out, out_size, out_len};
+            size_t result = ZSTD_decompressStream (ctx, &output, &input);
+            if (ZSTD_isError(result))
+                return ZSTD_getErrorName (result);
+            if (input.pos || output.pos != out_len)
+                frame_end = result == 0;
+            in += input.pos;
+            out_len = output.pos;
+            return nullptr;
+        }
+        bool complete () const override {
+            return frame_end;
+        }
+
+    private:
+        ZSTD_DCtx* ctx;
+        bool frame_end;
+    };
+#endif
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jdecompressor::jdecompressor (int fd_arg, size_t buf_size, unsigned num_buffers)
+        : fd {fd_arg},
+          close_fd {false},
+          buffer_size {std::max(buf_size, (size_t)1)},
+          current {nullptr},
+          done {false},
+          stop {false}
+    {
+        start (num_buffers);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jdecompressor::jdecompressor (const std::string& file_name, size_t buf_size, unsigned num_buffers)
+        : fd {::open(file_name.c_str(), O_RDONLY)},
+          close_fd {true},
+          buffer_size {std::max(buf_size, (size_t)1)},
+          current {nullptr},
+          done {false},
+          stop {false}
+    {
+        if (fd < 0) {
+            error_msg = strerror (errno);
+            done = true;
+            return;
+        }
+        start (num_buffers);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jdecompressor::~jdecompressor ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            stop = true;
+        }
+        cond.notify_all ();
+        if (thread.joinable())
+            thread.join ();
+        if (close_fd && fd >= 0)
+            ::close (fd);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jdecompressor::start (unsigned num_buffers)
+    {
+        num_buffers = std::max (num_buffers, 2u);
+        for (unsigned i=0; i<num_buffers; ++i) {
+            buffers.emplace_back (new char[buffer_size]);
+            free_buffers.emplace_back (buffers.back().get());
+        }
+        thread = std::thread ([this](){ run(); });
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jdecompressor::next (const char*& data, size_t& size)
+    {
+        std::unique_lock<std::mutex> lock (mutex);
+        if (current) {
+            free_buffers.emplace_back (current);
+            current = nullptr;
+            cond.notify_all ();
+        }
+        cond.wait (lock, [this]{ return !chunks.empty() || done; });
+        if (chunks.empty())
+            return false;
+        auto& chunk = chunks.front ();
+        current = chunk.data;
+        data = chunk.data;
+        size = chunk.size;
+        chunks.pop_front ();
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Wait for a free buffer. Return nullptr if stopped.
+    //--------------------------------------------------------------------------
+    char* jdecompressor::get_buffer ()
+    {
+        std::unique_lock<std::mutex> lock (mutex);
+        cond.wait (lock, [this]{ return !free_buffers.empty() || stop; });
+        if (stop)
+            return nullptr;
+        auto buf = free_buffers.back ();
+        free_buffers.pop_back ();
+        return buf;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jdecompressor::put_chunk (char* data, size_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            if (size)
+                chunks.push_back (chunk_t{data, size});
+            else
+                free_buffers.emplace_back (data);
+        }
+        cond.notify_all ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jdecompressor::end (const std::string& error)
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            error_msg = error;
+            done = true;
+        }
+        cond.notify_all ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Read, decompress, and pass on the input in the reading thread.
+    //--------------------------------------------------------------------------
+    void jdecompressor::run ()
+    {
+        std::unique_ptr<char[]> in_buf (new char[compressed_buf_size]);
+        const char* in = in_buf.get ();
+        const char* in_end = in;
+        bool in_eof = false;
+
+        // Read more input when all is used
+        auto read_input = [&] () -> bool {
+            ssize_t result;
+            do {
+                result = ::read (fd, in_buf.get(), compressed_buf_size);
+            }while (result < 0 && errno == EINTR);
+            if (result < 0)
+                return false;
+            in = in_buf.get ();
+            in_end = in + result;
+            in_eof = result == 0;
+            return true;
+        };
+
+        // Read at least four bytes to find the compression format
+        size_t head = 0;
+        while (head < 4) {
+            ssize_t result = ::read (fd, in_buf.get()+head, compressed_buf_size-head);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0) {
+                end (strerror(errno));
+                return;
+            }
+            if (result == 0) {
+                in_eof = true;
+                break;
+            }
+            head += result;
+        }
+        in_end = in + head;
+
+        std::unique_ptr<stream_decoder> dec;
+        switch (detect_compression(in, head)) {
+        case compression_t::gzip:
+#if (UJSON_HAVE_ZLIB)
+            dec = std::make_unique<gzip_decoder> ();
+#else
+            end ("gzip compressed input is not supported");
+            return;
+#endif
+            break;
+        case compression_t::zstd:
+#if (UJSON_HAVE_ZSTD)
+            dec = std::make_unique<zstd_decoder> ();
+#else
+            end ("zstd compressed input is not supported");
+            return;
+#endif
+            break;
+        default:
+            dec = std::make_unique<copy_decoder> ();
+        }
+
+        for (;;) {
+            char* out = get_buffer ();
+            if (!out)
+                return; // Stopped
+            size_t out_len = 0;
+            bool input_done = false;
+            while (out_len < buffer_size) {
+                if (in == in_end && !in_eof) {
+                    if (!read_input()) {
+                        put_chunk (out, out_len);
+                        end (strerror(errno));
+                        return;
+                    }
+                }
+                auto prev_in = in;
+                auto prev_out_len = out_len;
+                auto error = dec->decode (in, in_end, out, out_len, buffer_size);
+                if (error) {
+                    put_chunk (out, out_len);
+                    end (error);
+                    return;
+                }
+                if (in == prev_in && out_len == prev_out_len) {
+                    if (in == in_end && in_eof) {
+                        input_done = true;
+                        break;
+                    }
+                    if (in != in_end) {
+                        put_chunk (out, out_len);
+                        end ("Invalid compressed data");
+                        return;
+                    }
+                }
+            }
+            put_chunk (out, out_len);
+            if (input_done) {
+                end (dec->complete() ? "" : "Unexpected end of compressed data");
+                return;
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Compresses output of a jcompressor.
+    //--------------------------------------------------------------------------
+    class stream_encoder {
+    public:
+        using handler_t = jcompressor::handler_t;
+
+        virtual ~stream_encoder () = default;
+
+        // Compress data and pass the output to a handler.
+        // If 'last' is true, the compressed stream is ended.
+        virtual void encode (const char* data,
+                             size_t size,
+                             bool last,
+                             const handler_t& handler) = 0;
+    };
+
+
+    //--------------------------------------------------------------------------
+    // Uncompressed output.
+    //--------------------------------------------------------------------------
+    class copy_encoder : public stream_encoder {
+    public:
+        void encode (const char* data,
+                     size_t size,
+                     bool last,
+                     const handler_t& handler) override
+        {
+            if (size)
+                handler (data, size);
+        }
+    };
+
+
+#if (UJSON_HAVE_ZLIB)
+    //--------------------------------------------------------------------------
+    // gzip compressed output.
+    //--------------------------------------------------------------------------
+    class gzip_encoder : public stream_encoder {
+    public:
+        gzip_encoder (int level)
+            : buf {new char[compressed_buf_size]}
+        {
+            memset (&zs, 0, sizeof(zs));
+            if (deflateInit2(&zs, level ? level : Z_DEFAULT_COMPRESSION,
+                             Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) // 16: gzip header
+            {
+                throw std::runtime_error ("Failed to initialize gzip compression");
+            }
+        }
+        ~gzip_encoder () override {
+            deflateEnd (&zs);
+        }
+        void encode (const char* data,
+                     size_t size,
+                     bool last,
+                     const handler_t& handler) override
+        {
+            do {
+                size_t n = std::min (size, (size_t)UINT_MAX);
+                zs.next_in = (Bytef*) data;
+                zs.avail_in = (uInt) n;
+                data += n;
+                size -= n;
+                int flush = (last && size==0) ? Z_FINISH : Z_NO_FLUSH;
+                int result;
+                do {
+                    zs.next_out = (Bytef*) buf.get ();
+                    zs.avail_out = (uInt) compressed_buf_size;
+                    result = deflate (&zs, flush);
+                    if (result == Z_STREAM_ERROR)
+                        throw std::runtime_error ("gzip compression failed");
+                    size_t out_len = compressed_buf_size - zs.avail_out;
+                    if (out_len)
+                        handler (buf.get(), out_len);
+                }while (zs.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+            }while (size);
+        }
+
+    private:
+        z_stream zs;
+        std::unique_ptr<char[]> buf;
+    };
+#endif
+
+
+#if (UJSON_HAVE_ZSTD)
+    //--------------------------------------------------------------------------
+    // zstd compressed output.
+    //--------------------------------------------------------------------------
+    class zstd_encoder : public stream_encoder {
+    public:
+        zstd_encoder (int level)
+            : ctx {ZSTD_createCCtx()},
+              buf {new char[compressed_buf_size]}
+        {
+            if (!ctx)
+                throw std::runtime_error ("Failed to initialize zstd compression");
+            ZSTD_CCtx_setParameter (ctx, ZSTD_c_compressionLevel, level ? level : ZSTD_CLEVEL_DEFAULT);
+        }
+        ~zstd_encoder () override {
+            ZSTD_freeCCtx (ctx);
+        }
+        void encode (const char* data,
+                     size_t size,
+                     bool last,
+                     const handler_t& handler) override
+        {
+            ZSTD_inBuffer input {data, size, 0};
+            auto mode = last ? ZSTD_e_end : ZSTD_e_continue;
+            bool finished;
+            do {
+                ZSTD_outBuffer output {buf.get(), compressed_buf_size, 0};
+                size_t result = ZSTD_compressStream2 (ctx, &output, &input, mode);
+                if (ZSTD_isError(result))
+                    throw std::runtime_error (ZSTD_getErrorName(result));
+                if (output.pos)
+                    handler (buf.get(), output.pos);
+                finished = last ? result == 0 : input.pos == input.size;
+            }while (!finished);
+        }
+
+    private:
+        ZSTD_CCtx* ctx;
+        std::unique_ptr<char[]> buf;
+    };
+#endif
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jcompressor::jcompressor (compression_t method,
+                              const handler_t& handler_arg,
+                              int level)
+        : handler {handler_arg}
+    {
+        switch (method) {
+        case compression_t::none:
+            enc = std::make_unique<copy_encoder> ();
+            break;
+        case compression_t::gzip:
+#if (UJSON_HAVE_ZLIB)
+            enc = std::make_unique<gzip_encoder> (level);
+            break;
+#else
+            throw std::invalid_argument ("gzip compression is not supported");
+#endif
+        case compression_t::zstd:
+#if (UJSON_HAVE_ZSTD)
+            enc = std::make_unique<zstd_encoder> (level);
+            break;
+#else
+            throw std::invalid_argument ("zstd compression is not supported");
+#endif
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jcompressor::~jcompressor ()
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jcompressor::write (const char* data, size_t size)
+    {
+        if (size)
+            enc->encode (data, size, false, handler);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jcompressor::finish ()
+    {
+        enc->encode (nullptr, 0, true, handler);
+    }
+
+
+}
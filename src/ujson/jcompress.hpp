@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JCOMPRESS_HPP
+#define UJSON_JCOMPRESS_HPP
+
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+
+namespace ujson {
+
+
+    class stream_encoder;
+
+
+    /**
+     * Compression formats of input and output.
+     * @see jdecompressor
+     * @see jcompressor
+     */
+    enum class compression_t {
+        none, /**< Not compressed. */
+        gzip, /**< gzip (RFC 1952). Supported if libujson is built with zlib. */
+        zstd, /**< Zstandard (RFC 8878). Supported if libujson is built with libzstd. */
+    };
+
+
+    /**
+     * Check if a compression format is supported.
+     * @param method A compression format.
+     * @return <code>true</code> if libujson is built with
+     *         support for the compression format.
+     */
+    bool compression_supported (compression_t method);
+
+
+    /**
+     * Find the compression format of data by its first bytes.
+     * A JSON document never starts like compressed data, so
+     * compressed and uncompressed JSON can be told apart.
+     * @param data The start of the data.
+     * @param size The number of bytes available, at least
+     *             four bytes are needed to find the format.
+     * @return The compression format, or compression_t::none
+     *         if the data isn't compressed in a known format.
+     */
+    compression_t detect_compression (const char* data, size_t size);
+
+
+    /**
+     * Return a compression format by its name.
+     * @param name "none", "gzip", or "zstd".
+     * @return The compression format.
+     * @throw std::invalid_argument If the name is unknown.
+     */
+    compression_t compression_from_name (const std::string& name);
+
+
+    /**
+     * Read input and decompress it on a separate thread.
+     * The compression format, gzip, zstd, or none, is found from
+     * the first bytes of the input. The input is read and decompressed
+     * by a thread owned by the jdecompressor, into a bounded ring of
+     * buffers that are passed in order to the reader by next(). When
+     * the reader is e.g. a jparser fed with jparser::feed(), reading
+     * and decompressing the input overlaps with parsing, and at most
+     * <code>num_buffers</code> buffers of decompressed data are kept
+     * in memory.
+     * <br/>
+     * A jdecompressor must only be read by one thread at a time.
+     * \par Example:
+     * \code
+     * ujson::jdecompressor in ("document.json.gz");
+     * const char* data;
+     * size_t size;
+     * parser.begin ();
+     * while (in.next(data, size)) {
+     *     if (!parser.feed(data, size))
+     *         break;
+     * }
+     * auto doc = parser.finish ();
+     * \endcode
+     * @see jparser::parse_fd()
+     */
+    class jdecompressor {
+    public:
+        /**
+         * The default size of the buffers of decompressed data.
+         */
+        static constexpr size_t default_buffer_size = 256 * 1024;
+
+        /**
+         * Read from an open file descriptor.
+         * The file descriptor is not closed by the jdecompressor.
+         * @param fd The file descriptor to read from.
+         * @param buffer_size The size of each buffer of decompressed data.
+         * @param num_buffers The number of buffers, at least two.
+         */
+        jdecompressor (int fd,
+                       size_t buffer_size=default_buffer_size,
+                       unsigned num_buffers=4);
+
+        /**
+         * Read from a file.
+         * @param file_name The name of the file to read.
+         * @param buffer_size The size of each buffer of decompressed data.
+         * @param num_buffers The number of buffers, at least two.
+         */
+        jdecompressor (const std::string& file_name,
+                       size_t buffer_size=default_buffer_size,
+                       unsigned num_buffers=4);
+
+        /**
+         * Destructor.
+         * Stop reading input and wait for the reading thread to end.
+         * If the thread is waiting for input from a pipe, the destructor
+         * waits until that read returns.
+         */
+        ~jdecompressor ();
+
+        jdecompressor (const jdecompressor&) = delete;
+        jdecompressor& operator= (const jdecompressor&) = delete;
+
+        /**
+         * Get the next chunk of decompressed data.
+         * Waits until the chunk is decompressed.
+         * @param data Set to the start of the chunk. The chunk is
+         *             valid until the next call to next(), or until
+         *             the jdecompressor is destroyed.
+         * @param size Set to the size of the chunk.
+         * @return <code>false</code> at the end of the input, or if
+         *         reading or decompressing the input failed.
+         * @see error()
+         */
+        bool next (const char*& data, size_t& size);
+
+        /**
+         * Return an error message if reading or decompressing the
+         * input failed, or an empty string if not. Only known after
+         * next() has returned <code>false</code>.
+         */
+        const std::string& error () const {
+            return error_msg;
+        }
+
+
+    private:
+        struct chunk_t {
+            char* data;
+            size_t size;
+        };
+
+        int fd;
+        bool close_fd;
+        size_t buffer_size;
+        std::vector<std::unique_ptr<char[]>> buffers;
+        std::vector<char*> free_buffers;
+        std::deque<chunk_t> chunks; // Decompressed chunks not yet read
+        char* current;              // The chunk last returned by next()
+        bool done;                  // No more chunks are added
+        bool stop;
+        std::string error_msg;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread thread;
+
+        void start (unsigned num_buffers);
+        void run ();
+        char* get_buffer ();
+        void put_chunk (char* data, size_t size);
+        void end (const std::string& error);
+    };
+
+
+    /**
+     * Compress output and pass it to a handler.
+     * Output written to a jcompressor is compressed and passed in
+     * chunks to a handler, like the handler of
+     * jvalue::write(const jvalue::write_handler_t&, desc_format_t, unsigned, unsigned, size_t).
+     * \par Example:
+     * \code
+     * ujson::jcompressor out (ujson::compression_t::gzip,
+     *                         [](const char* data, size_t size) {
+     *                             std::cout.write (data, size);
+     *                         });
+     * doc.write ([&out](const char* data, size_t size) {
+     *                out.write (data, size);
+     *            });
+     * out.finish ();
+     * \endcode
+     */
+    class jcompressor {
+    public:
+        /**
+         * A function receiving the compressed output.
+         */
+        using handler_t = std::function<void (const char* data, size_t size)>;
+
+        /**
+         * Constructor.
+         * @param method The compression format. With compression_t::none
+         *               the output is passed on unchanged.
+         * @param handler A function receiving the compressed output.
+         * @param level The compression level, 0 for the default level
+         *              of the compression format.
+         * @throw std::invalid_argument If the compression format isn't
+         *                              supported.
+         */
+        jcompressor (compression_t method,
+                     const handler_t& handler,
+                     int level=0);
+
+        /**
+         * Destructor.
+         * Output not ended by finish() is dropped.
+         */
+        ~jcompressor ();
+
+        jcompressor (const jcompressor&) = delete;
+        jcompressor& operator= (const jcompressor&) = delete;
+
+        /**
+         * Compress data.
+         * @param data The data to compress.
+         * @param size The number of bytes.
+         * @throw std::runtime_error If compressing fails.
+         */
+        void write (const char* data, size_t size);
+
+        /**
+         * End the compressed output.
+         * All remaining output is passed to the handler.
+         * Nothing may be written after this.
+         * @throw std::runtime_error If compressing fails.
+         */
+        void finish ();
+
+
+    private:
+        handler_t handler;
+        std::unique_ptr<stream_encoder> enc;
+    };
+
+
+}
+#endif
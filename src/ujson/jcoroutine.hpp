@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JCOROUTINE_HPP
+#define UJSON_JCOROUTINE_HPP
+
+#include <ujson/jparser.hpp>
+
+// Coroutines need C++20, the rest of libujson only C++17
+#if defined(__cpp_impl_coroutine) && (__cpp_impl_coroutine >= 201902L)
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <istream>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+namespace ujson {
+
+
+    /**
+     * A coroutine yielding a sequence of values.
+     * The values are produced one at a time, when the
+     * generator is iterated. A generator can only be
+     * iterated once.
+     * <br/>
+     * This header is only available when compiling with
+     * C++20 or later.
+     * \par Example:
+     * \code
+     * ujson::jgenerator<int> count (int n) {
+     *     for (int i=0; i<n; ++i)
+     *         co_yield i;
+     * }
+     * for (auto i : count(3))
+     *     std::cout << i << std::endl;
+     * \endcode
+     */
+    template<typename T>
+    class jgenerator {
+    public:
+        /**
+         * The promise type of the coroutine.
+         */
+        struct promise_type {
+            T* value {nullptr};
+            std::exception_ptr exception;
+
+            jgenerator get_return_object () {
+                return jgenerator (std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend () noexcept {return {};}
+            std::suspend_always final_suspend () noexcept {return {};}
+            std::suspend_always yield_value (T& v) noexcept {
+                value = std::addressof (v);
+                return {};
+            }
+            std::suspend_always yield_value (T&& v) noexcept {
+                value = std::addressof (v);
+                return {};
+            }
+            void return_void () {}
+            void unhandled_exception () {exception = std::current_exception();}
+            void await_transform () = delete;
+        };
+
+        /**
+         * Iterator over the values of a generator.
+         */
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator () = default;
+            explicit iterator (std::coroutine_handle<promise_type> h) : coro {h} {}
+
+            T& operator* () const {return *coro.promise().value;}
+            T* operator-> () const {return coro.promise().value;}
+            iterator& operator++ () {
+                coro.resume ();
+                rethrow ();
+                return *this;
+            }
+            void operator++ (int) {++*this;}
+            bool operator== (const iterator& rhs) const {return done() == rhs.done();}
+            bool operator!= (const iterator& rhs) const {return done() != rhs.done();}
+
+        private:
+            std::coroutine_handle<promise_type> coro;
+
+            bool done () const {return !coro || coro.done();}
+            void rethrow () {
+                if (coro.done() && coro.promise().exception)
+                    std::rethrow_exception (coro.promise().exception);
+            }
+            friend class jgenerator;
+        };
+
+        jgenerator (jgenerator&& g) noexcept : coro {std::exchange(g.coro, nullptr)} {}
+        jgenerator& operator= (jgenerator&& g) noexcept {
+            if (this != &g) {
+                if (coro)
+                    coro.destroy ();
+                coro = std::exchange (g.coro, nullptr);
+            }
+            return *this;
+        }
+        ~jgenerator () {
+            if (coro)
+                coro.destroy ();
+        }
+        jgenerator (const jgenerator&) = delete;
+        jgenerator& operator= (const jgenerator&) = delete;
+
+        /**
+         * Start the coroutine and return an iterator to the first value.
+         * @throw Any exception thrown by the coroutine.
+         */
+        iterator begin () {
+            iterator i (coro);
+            if (coro) {
+                coro.resume ();
+                i.rethrow ();
+            }
+            return i;
+        }
+
+        /**
+         * Return the end iterator.
+         */
+        iterator end () {
+            return iterator ();
+        }
+
+    private:
+        explicit jgenerator (std::coroutine_handle<promise_type> h) : coro {h} {}
+        std::coroutine_handle<promise_type> coro;
+    };
+
+
+    /**
+     * Parse a stream of values from an input stream.
+     * The input is read and parsed in chunks, and the values are
+     * yielded one at a time as they are parsed, so memory usage only
+     * depends on the size of each value. See jparser::begin_stream()
+     * for which values are yielded.
+     * <br/>
+     * The generator ends at the end of the input, or at a parse
+     * error. Call <code>parser.get_error()</code> afterwards to check
+     * for errors, and <code>in.bad()</code> for read errors.
+     * \par Example:
+     * \code
+     * std::ifstream in ("log.ndjson");
+     * ujson::jparser parser;
+     * for (auto& doc : ujson::stream_values(parser, in, ujson::jparser::stream_t::documents))
+     *     process (doc);
+     * if (parser.get_error().code != ujson::jparser::err::ok)
+     *     std::cerr << parser.error() << std::endl;
+     * \endcode
+     * @param parser The parser to use.
+     * @param in The input stream.
+     * @param what What values to yield.
+     * @param strict_mode if <code>true</code>, parsing is done strictly
+     *                    according to the JSON specification (RFC 8259).
+     * @param chunk_size The number of bytes read at a time.
+     * @return A generator of the parsed values.
+     */
+    inline jgenerator<jvalue> stream_values (jparser& parser,
+                                             std::istream& in,
+                                             jparser::stream_t what,
+                                             bool strict_mode=true,
+                                             size_t chunk_size=64*1024)
+    {
+        std::vector<char> chunk (chunk_size);
+        jvalue value;
+        bool ok = true;
+
+        parser.begin_stream (what, strict_mode);
+        while (ok && in) {
+            in.read (chunk.data(), chunk.size());
+            auto n = in.gcount ();
+            if (n <= 0)
+                break;
+            ok = parser.feed (chunk.data(), (size_t)n);
+            while (parser.next_value(value))
+                co_yield value;
+        }
+        if (ok)
+            parser.finish_stream ();
+        while (parser.next_value(value))
+            co_yield value;
+    }
+
+
+    /**
+     * Parse a stream of values fed by one coroutine
+     * and consumed by another.
+     * A producer coroutine, typically reading from a socket, passes
+     * each chunk of input to <code>co_await feed()</code>, and calls
+     * close() when the input ends. A consumer coroutine gets the
+     * parsed values with <code>co_await next()</code>, which suspends
+     * the consumer when the input runs out in the middle of a value.
+     * When a chunk completes a value that the consumer waits for,
+     * feed() suspends the producer and resumes the consumer, and the
+     * producer is resumed when the consumer has taken all parsed
+     * values and waits for more. This way no input is read while
+     * values are processed, and no thread is needed for the parser.
+     * See jparser::begin_stream() for which values are returned.
+     * <br/>
+     * A jstream is meant for coroutines resumed by a single thread,
+     * or strand, and is not thread safe. The consumer must keep
+     * calling next() until it returns an empty value, or the producer
+     * may be left suspended in feed().
+     * <br/>
+     * This header is only available when compiling with
+     * C++20 or later.
+     * \par Example:
+     * \code
+     * ujson::jparser parser;
+     * ujson::jstream stream (parser, ujson::jparser::stream_t::documents);
+     *
+     * // Producer coroutine
+     * while (size_t n = co_await read_some(socket, buf)) {
+     *     if (!co_await stream.feed(buf, n))
+     *         break;
+     * }
+     * stream.close ();
+     *
+     * // Consumer coroutine
+     * while (auto doc = co_await stream.next())
+     *     co_await handle_request (*doc);
+     * if (stream.get_error().code != ujson::jparser::err::ok)
+     *     std::cerr << stream.error() << std::endl;
+     * \endcode
+     */
+    class jstream {
+    public:
+        /**
+         * Awaitable returned by feed().
+         * The result of <code>co_await</code> is
+         * <code>false</code> on a parse error.
+         */
+        struct feed_awaiter {
+            jstream& stream;
+            bool ok;
+
+            bool await_ready () const noexcept {
+                return !stream.consumer || !stream.available;
+            }
+            std::coroutine_handle<> await_suspend (std::coroutine_handle<> h) noexcept {
+                stream.producer = h;
+                return std::exchange (stream.consumer, nullptr);
+            }
+            bool await_resume () const noexcept {
+                return ok;
+            }
+        };
+
+        /**
+         * Awaitable returned by next().
+         * The result of <code>co_await</code> is the next parsed
+         * value, or an empty <code>std::optional</code> when
+         * the stream is closed and all values are taken.
+         */
+        struct next_awaiter {
+            jstream& stream;
+
+            bool await_ready () noexcept {
+                return stream.take() || stream.closed;
+            }
+            std::coroutine_handle<> await_suspend (std::coroutine_handle<> h) noexcept {
+                stream.consumer = h;
+                if (stream.producer)
+                    return std::exchange (stream.producer, nullptr);
+                return std::noop_coroutine ();
+            }
+            std::optional<jvalue> await_resume () {
+                if (!stream.available && !stream.take())
+                    return std::nullopt;
+                stream.available = false;
+                return std::move (stream.value);
+            }
+        };
+
+        /**
+         * Constructor.
+         * Starts parsing a stream with jparser::begin_stream().
+         * @param p The parser to use. It must outlive the stream.
+         * @param what What values are returned by next().
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.
+         */
+        jstream (jparser& p,
+                 jparser::stream_t what,
+                 bool strict_mode=true,
+                 bool allow_duplicates_in_obj=true)
+            : parser {p}
+        {
+            parser.begin_stream (what, strict_mode, allow_duplicates_in_obj);
+        }
+
+        jstream (const jstream&) = delete;
+        jstream& operator= (const jstream&) = delete;
+
+        /**
+         * Parse the next chunk of input.
+         * The chunk is parsed before this call returns, and the
+         * buffer isn't needed after that. If a value is completed
+         * and the consumer waits for it, <code>co_await</code>
+         * resumes the consumer.
+         * @param buf The next chunk of input.
+         * @param length The length (in bytes) of the chunk.
+         * @return An awaitable with the result <code>false</code>
+         *         if a parse error is found. The producer should
+         *         then call close().
+         */
+        feed_awaiter feed (const char* buf, size_t length) {
+            bool ok = !closed && parser.feed (buf, length);
+            if (!available)
+                take ();
+            return feed_awaiter {*this, ok};
+        }
+
+        /**
+         * End the input.
+         * The remaining input is parsed, and a consumer waiting
+         * in next() is resumed to take the remaining values.
+         * @return <code>false</code> if the stream has a parse error,
+         *         or ends in the middle of a value.
+         */
+        bool close () {
+            if (closed)
+                return ok_at_close;
+            closed = true;
+            ok_at_close = parser.finish_stream ();
+            if (consumer)
+                std::exchange(consumer, nullptr).resume ();
+            return ok_at_close;
+        }
+
+        /**
+         * Get the next parsed value.
+         * Suspends the caller until a value is parsed
+         * or the stream is closed.
+         */
+        next_awaiter next () {
+            return next_awaiter {*this};
+        }
+
+        /**
+         * Get an error code and position.
+         * @see jparser::get_error()
+         */
+        const jparser::error_t get_error () const {
+            return parser.get_error ();
+        }
+
+        /**
+         * Get an error message if parsing has failed.
+         * @see jparser::error()
+         */
+        const std::string& error () const {
+            return parser.error ();
+        }
+
+    private:
+        jparser& parser;
+        jvalue value;
+        bool available {false};
+        bool closed {false};
+        bool ok_at_close {true};
+        std::coroutine_handle<> producer;
+        std::coroutine_handle<> consumer;
+
+        // Move the next parsed value, if any, to 'value'
+        bool take () {
+            if (!available)
+                available = parser.next_value (value);
+            return available;
+        }
+    };
+
+
+}
+
+#endif
+#endif
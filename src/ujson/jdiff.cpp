@@ -0,0 +1,605 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jdiff.hpp>
+#include <ujson/utils.hpp>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+namespace ujson {
+
+
+    // Limits of the O(ND) diff of arrays. It gives up when the number of
+    // changes times the number of items exceeds max_array_work, or the
+    // number of changes exceeds max_array_edits. Then the arrays are split
+    // by items that occur once in both arrays, and the parts are diffed.
+    static constexpr const long max_array_edits = 1024;
+    static constexpr const long min_array_edits = 16;
+    static constexpr const long max_array_work  = 4000000;
+
+    // Hashes of objects and arrays with at least this
+    // many values in them are kept, smaller are recalculated.
+    static constexpr const size_t min_kept_hash_size = 64;
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline uint64_t hash_mix (uint64_t h)
+    {
+        // The finalizer of splitmix64
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline uint64_t hash_combine (uint64_t seed, uint64_t h)
+    {
+        return hash_mix (seed + 0x9e3779b97f4a7c15ULL + h);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Creates the patch operations. The hash of each large object and
+    // array is calculated once, and kept while the patch is created.
+    // Large arrays also keep the hashes of their items.
+    //--------------------------------------------------------------------------
+    class diff_engine_t {
+    public:
+        diff_engine_t (json_array& patch_operations)
+            : ops (patch_operations)
+            {
+            }
+
+        void diff (const jvalue& source, const jvalue& target, std::string& path);
+
+    private:
+        enum edit_t {edit_keep, edit_remove, edit_add};
+
+        struct kept_hash_t {
+            uint64_t hash;
+            std::vector<uint64_t> items; // Hashes of the items in a large array
+        };
+
+        // Items of an array and their hashes
+        struct items_t {
+            const jvalue* value;
+            const uint64_t* hash;
+        };
+
+        uint64_t hash (const jvalue& value) {
+            size_t num_values;
+            return hash (value, num_values);
+        }
+        uint64_t hash (const jvalue& value, size_t& num_values);
+        bool equal (const jvalue& lhs, const jvalue& rhs);
+        static bool identical (const jvalue& lhs, const jvalue& rhs);
+        bool equal (const jvalue& lhs, uint64_t lhs_hash, const jvalue& rhs, uint64_t rhs_hash) {
+            // Different hashes are different values, equal hashes
+            // may be a collision and are confirmed by comparing them.
+            return lhs_hash == rhs_hash  &&  lhs == rhs;
+        }
+        void diff_objects (const jvalue& source, const jvalue& target, std::string& path);
+        void diff_arrays (const jvalue& source, const jvalue& target, std::string& path);
+        void edit_script (items_t a, size_t n, items_t b, size_t m, std::vector<edit_t>& script);
+        bool shortest_edit (items_t a, size_t n, items_t b, size_t m, std::vector<edit_t>& script);
+        bool split_edit (items_t a, size_t n, items_t b, size_t m, std::vector<edit_t>& script);
+        void add_op (const char* op, const std::string& path, const jvalue* value=nullptr);
+
+        json_array& ops;
+        std::unordered_map<const jvalue*, kept_hash_t> hashes; // Large objects and arrays
+    };
+
+
+    //--------------------------------------------------------------------------
+    // 'num_values' is set to the number of values in the value, including
+    // itself, but no more than min_kept_hash_size. Values containing a
+    // value with a kept hash are large enough to have their hash kept.
+    //--------------------------------------------------------------------------
+    uint64_t diff_engine_t::hash (const jvalue& value, size_t& num_values)
+    {
+        num_values = 1;
+        auto type = value.type ();
+        if (type != j_object  &&  type != j_array)
+            return value.hash ();
+
+        if (value.hash_cached()) {
+            num_values = min_kept_hash_size;
+            return value.hash ();
+        }
+        if (!hashes.empty()) {
+            auto entry = hashes.find (&value);
+            if (entry != hashes.end()) {
+                num_values = min_kept_hash_size;
+                return entry->second.hash;
+            }
+        }
+
+        // Same as jvalue::hash(), so cached hash values can be used
+        uint64_t h = hash_mix ((uint64_t) type + 1);
+        size_t n;
+        std::vector<uint64_t> items;
+        if (type == j_object) {
+            // Combine the members so the order doesn't matter
+            uint64_t sum = 0;
+            for (auto& member : value.obj()) {
+                sum += hash_mix (hash_combine(std::hash<json_key>()(member.first),
+                                              hash(member.second, n)));
+                num_values += n;
+            }
+            h = hash_combine (h, sum);
+        }else{
+            bool keep_items = value.size() >= min_kept_hash_size;
+            if (keep_items)
+                items.reserve (value.size());
+            for (auto& item : value.array()) {
+                auto item_hash = hash (item, n);
+                if (keep_items)
+                    items.push_back (item_hash);
+                h = hash_combine (h, item_hash);
+                num_values += n;
+            }
+        }
+        if (num_values >= min_kept_hash_size) {
+            hashes.emplace (&value, kept_hash_t{h, std::move(items)});
+            num_values = min_kept_hash_size;
+        }
+        return h;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Objects and arrays with different sizes or hashes are different,
+    // the others are compared, since equal hashes may be a collision.
+    //--------------------------------------------------------------------------
+    bool diff_engine_t::equal (const jvalue& lhs, const jvalue& rhs)
+    {
+        auto type = lhs.type ();
+        if (type != rhs.type())
+            return false;
+        if (type != j_object  &&  type != j_array)
+            return lhs == rhs;
+        return identical (lhs, rhs)  ||
+            (lhs.size() == rhs.size()  &&  hash(lhs) == hash(rhs)  &&  lhs == rhs);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Objects and arrays are identical if they are shared, see
+    // jvalue::share(). Other values are identical if they are equal.
+    //--------------------------------------------------------------------------
+    bool diff_engine_t::identical (const jvalue& lhs, const jvalue& rhs)
+    {
+        auto type = lhs.type ();
+        if (type != rhs.type())
+            return false;
+        if (type == j_object)
+            return &lhs.obj() == &rhs.obj();
+        if (type == j_array)
+            return &lhs.array() == &rhs.array();
+        return lhs == rhs;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void diff_engine_t::add_op (const char* op, const std::string& path, const jvalue* value)
+    {
+        jvalue operation (j_object);
+        operation.add ("op", jvalue(std::string(op)));
+        operation.add ("path", jvalue(path));
+        if (value)
+            operation.add ("value", *value);
+        ops.emplace_back (std::move(operation));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void diff_engine_t::diff (const jvalue& source, const jvalue& target, std::string& path)
+    {
+        // Objects and arrays are diffed without hashing them first,
+        // so values shared by both of them are not hashed.
+        if (source.type() == j_object  &&  target.type() == j_object) {
+            if (!identical(source, target))
+                diff_objects (source, target, path);
+        }
+        else if (source.type() == j_array  &&  target.type() == j_array) {
+            if (!identical(source, target))
+                diff_arrays (source, target, path);
+        }
+        else if (!equal(source, target)) {
+            add_op ("replace", path, &target);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // The members of both objects are walked in name order,
+    // so members with the same name are found side by side.
+    //--------------------------------------------------------------------------
+    void diff_engine_t::diff_objects (const jvalue& source, const jvalue& target, std::string& path)
+    {
+        using iterator = json_object::const_iterator;
+        std::less<json_key> key_less;
+        auto& src = source.obj ();
+        auto& dst = target.obj ();
+
+        // Find the end of the members with the same name as 'i'
+        auto same_name = [&key_less](iterator i, iterator end) {
+            auto j = i;
+            while (++j != end  &&  !key_less(i->first, j->first))
+                ;
+            return j;
+        };
+
+        // Members with the same name in one of the objects can't be
+        // told apart by a JSON pointer. If they differ, replace the object.
+        for (auto s=src.sbegin(), d=dst.sbegin(); s!=src.send() || d!=dst.send(); ) {
+            if (d == dst.send()  ||  (s != src.send()  &&  key_less(s->first, d->first))) {
+                s = same_name (s, src.send()); // Removed member(s)
+            }
+            else if (s == src.send()  ||  key_less(d->first, s->first)) {
+                auto d_end = same_name (d, dst.send());
+                if (std::next(d) != d_end) {
+                    add_op ("replace", path, &target);
+                    return;
+                }
+                d = d_end;
+            }
+            else {
+                auto s_end = same_name (s, src.send());
+                auto d_end = same_name (d, dst.send());
+                if (std::next(s) != s_end  ||  std::next(d) != d_end) {
+                    for (; s!=s_end && d!=d_end; ++s, ++d) {
+                        if (!equal(s->second, d->second))
+                            break;
+                    }
+                    if (s != s_end  ||  d != d_end) {
+                        add_op ("replace", path, &target);
+                        return;
+                    }
+                }
+                s = s_end;
+                d = d_end;
+            }
+        }
+
+        auto path_size = path.size ();
+        for (auto s=src.sbegin(), d=dst.sbegin(); s!=src.send() || d!=dst.send(); ) {
+            bool removed = d == dst.send()  ||  (s != src.send()  &&  key_less(s->first, d->first));
+            bool added = !removed  &&  (s == src.send()  ||  key_less(d->first, s->first));
+            const std::string& name = removed ? s->first : d->first;
+            path.push_back ('/');
+            path.append (escape_pointer_token(name));
+            if (removed) {
+                add_op ("remove", path);
+                s = same_name (s, src.send());
+            }
+            else if (added) {
+                add_op ("add", path, &d->second);
+                ++d;
+            }
+            else {
+                auto s_end = same_name (s, src.send());
+                if (std::next(s) == s_end)
+                    diff (s->second, d->second, path);
+                s = s_end;
+                d = same_name (d, dst.send());
+            }
+            path.resize (path_size);
+        }
+    }
+
+
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void diff_engine_t::diff_arrays (const jvalue& source, const jvalue& target, std::string& path)
+    {
+        auto& src = source.array ();
+        auto& dst = target.array ();
+
+        // Skip the identical start and end without hashing the items
+        size_t first = 0;
+        while (first < src.size()  &&  first < dst.size()  &&  identical(src[first], dst[first]))
+            ++first;
+        size_t last = 0;
+        while (last < src.size()-first  &&  last < dst.size()-first  &&
+               identical(src[src.size()-last-1], dst[dst.size()-last-1]))
+        {
+            ++last;
+        }
+        size_t n = src.size() - first - last;
+        size_t m = dst.size() - first - last;
+
+        // Get the hashes of the other items
+        std::vector<uint64_t> item_hashes[2];
+        const uint64_t* ha = nullptr;
+        const uint64_t* hb = nullptr;
+        for (auto i : {0, 1}) {
+            auto& array = i==0 ? src : dst;
+            auto entry = hashes.find (i==0 ? &source : &target);
+            if (entry != hashes.end()  &&  !entry->second.items.empty()) {
+                (i==0 ? ha : hb) = entry->second.items.data() + first;
+            }else{
+                item_hashes[i].reserve (i==0 ? n : m);
+                for (size_t j=first; j<array.size()-last; ++j)
+                    item_hashes[i].push_back (hash(array[j]));
+                (i==0 ? ha : hb) = item_hashes[i].data ();
+            }
+        }
+
+        std::vector<edit_t> script;
+        edit_script ({src.data()+first, ha}, n, {dst.data()+first, hb}, m, script);
+
+        // Removed and added items next to each other are treated as
+        // replaced items and diffed, the rest are removed or added.
+        // 'index' is the position in the array being patched.
+        auto path_size = path.size ();
+        size_t index = first;
+        size_t x = first;
+        size_t y = first;
+        for (size_t i=0; i<script.size(); ) {
+            if (script[i] == edit_keep) {
+                ++x;
+                ++y;
+                ++index;
+                ++i;
+                continue;
+            }
+            size_t removed = 0;
+            size_t added = 0;
+            for (; i<script.size() && script[i]!=edit_keep; ++i) {
+                if (script[i] == edit_remove)
+                    ++removed;
+                else
+                    ++added;
+            }
+            size_t replaced = std::min (removed, added);
+            for (size_t j=0; j<removed+added-replaced; ++j) {
+                path.push_back ('/');
+                path.append (std::to_string(index));
+                if (j < replaced) {
+                    diff (src[x++], dst[y++], path);
+                    ++index;
+                }
+                else if (removed > replaced) {
+                    add_op ("remove", path);
+                    ++x;
+                }
+                else {
+                    add_op ("add", path, &dst[y++]);
+                    ++index;
+                }
+                path.resize (path_size);
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Append an edit script from a[0..n) to b[0..m) to 'script'.
+    //--------------------------------------------------------------------------
+    void diff_engine_t::edit_script (items_t a, size_t n, items_t b, size_t m, std::vector<edit_t>& script)
+    {
+        // Skip the common start and end
+        size_t first = 0;
+        while (first < n  &&  first < m  &&
+               equal(a.value[first], a.hash[first], b.value[first], b.hash[first]))
+        {
+            ++first;
+        }
+        size_t last = 0;
+        while (last < n-first  &&  last < m-first  &&
+               equal(a.value[n-last-1], a.hash[n-last-1], b.value[m-last-1], b.hash[m-last-1]))
+        {
+            ++last;
+        }
+        script.insert (script.end(), first, edit_keep);
+        a = {a.value + first, a.hash + first};
+        b = {b.value + first, b.hash + first};
+        n -= first + last;
+        m -= first + last;
+
+        if (n == 0  ||  m == 0  ||
+            (!shortest_edit(a, n, b, m, script)  &&  !split_edit(a, n, b, m, script)))
+        {
+            // Compare item by item
+            script.insert (script.end(), n, edit_remove);
+            script.insert (script.end(), m, edit_add);
+        }
+        script.insert (script.end(), last, edit_keep);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Split a[0..n) and b[0..m) by items that occur only once in each of
+    // them, and are in the same order in both. The longest sequence of
+    // such items are kept, and the parts between them are diffed.
+    // Returns false if there are no such items.
+    //--------------------------------------------------------------------------
+    bool diff_engine_t::split_edit (items_t a, size_t n, items_t b, size_t m, std::vector<edit_t>& script)
+    {
+        // Positions of items that occur once in 'a' and once in 'b'
+        struct count_t {
+            size_t count_a {0};
+            size_t count_b {0};
+            size_t pos_a {0};
+            size_t pos_b {0};
+        };
+        std::unordered_map<uint64_t, count_t> counts;
+        for (size_t i=0; i<n; ++i) {
+            auto& c = counts[a.hash[i]];
+            ++c.count_a;
+            c.pos_a = i;
+        }
+        for (size_t i=0; i<m; ++i) {
+            auto entry = counts.find (b.hash[i]);
+            if (entry != counts.end()) {
+                ++entry->second.count_b;
+                entry->second.pos_b = i;
+            }
+        }
+        std::vector<size_t> pos_b (n, m); // Position in 'b' of unique items in 'a'
+        bool found = false;
+        for (auto& [h, c] : counts) {
+            if (c.count_a == 1  &&  c.count_b == 1  &&
+                equal(a.value[c.pos_a], h, b.value[c.pos_b], h))
+            {
+                pos_b[c.pos_a] = c.pos_b;
+                found = true;
+            }
+        }
+        if (!found)
+            return false;
+
+        // Longest increasing sequence of positions in 'b'
+        std::vector<size_t> tails;       // Index in 'a' of the last item of each sequence length
+        std::vector<size_t> prev (n, n); // The previous item in the sequence
+        for (size_t i=0; i<n; ++i) {
+            if (pos_b[i] == m)
+                continue;
+            auto len = std::lower_bound (tails.begin(), tails.end(), pos_b[i],
+                                         [&pos_b](size_t t, size_t pos) {return pos_b[t] < pos;});
+            if (len != tails.begin())
+                prev[i] = *(len - 1);
+            if (len == tails.end())
+                tails.push_back (i);
+            else
+                *len = i;
+        }
+        std::vector<size_t> anchors;
+        for (size_t i=tails.back(); i!=n; i=prev[i])
+            anchors.push_back (i);
+        std::reverse (anchors.begin(), anchors.end());
+
+        size_t x = 0;
+        size_t y = 0;
+        for (auto i : anchors) {
+            edit_script ({a.value+x, a.hash+x}, i-x, {b.value+y, b.hash+y}, pos_b[i]-y, script);
+            script.push_back (edit_keep);
+            x = i + 1;
+            y = pos_b[i] + 1;
+        }
+        edit_script ({a.value+x, a.hash+x}, n-x, {b.value+y, b.hash+y}, m-y, script);
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Append the shortest edit script from a[0..n) to b[0..m) to 'script',
+    // using the O(ND) algorithm by Eugene W. Myers. Returns false,
+    // without changing 'script', if it needs too many changes.
+    //--------------------------------------------------------------------------
+    bool diff_engine_t::shortest_edit (items_t a, size_t n, items_t b, size_t m, std::vector<edit_t>& script)
+    {
+        const long N = (long) n;
+        const long M = (long) m;
+        const long max_d = std::min (N + M,
+                                     std::clamp(max_array_work / (N + M),
+                                                min_array_edits,
+                                                max_array_edits));
+        auto same = [&](long x, long y) {
+            return equal (a.value[x], a.hash[x], b.value[y], b.hash[y]);
+        };
+
+        // v[k] is the furthest x on diagonal k, trace[d] is v[-d..d] before step d
+        std::vector<long> v (2 * max_d + 3, 0);
+        const long offset = max_d + 1;
+        std::vector<std::vector<long>> trace;
+        long d_end = -1;
+        for (long d=0; d<=max_d && d_end<0; ++d) {
+            trace.emplace_back (v.begin() + offset - d, v.begin() + offset + d + 1);
+            for (long k=-d; k<=d; k+=2) {
+                long x;
+                if (k == -d  ||  (k != d  &&  v[offset+k-1] < v[offset+k+1]))
+                    x = v[offset + k + 1];
+                else
+                    x = v[offset + k - 1] + 1;
+                long y = x - k;
+                while (x < N  &&  y < M  &&  same(x, y)) {
+                    ++x;
+                    ++y;
+                }
+                v[offset + k] = x;
+                if (x >= N  &&  y >= M) {
+                    d_end = d;
+                    break;
+                }
+            }
+        }
+        if (d_end < 0)
+            return false;
+
+        // Walk back from the end
+        auto script_start = script.size ();
+        long x = N;
+        long y = M;
+        for (long d=d_end; d>=0; --d) {
+            auto& vd = trace[d];
+            auto vat = [&vd, d](long k) {return vd[k + d];};
+            long k = x - y;
+            long prev_k;
+            if (k == -d  ||  (k != d  &&  vat(k-1) < vat(k+1)))
+                prev_k = k + 1;
+            else
+                prev_k = k - 1;
+            long prev_x = d>0 ? vat(prev_k) : 0;
+            long prev_y = d>0 ? prev_x - prev_k : 0;
+            while (x > prev_x  &&  y > prev_y) {
+                script.push_back (edit_keep);
+                --x;
+                --y;
+            }
+            if (d > 0) {
+                script.push_back (x == prev_x ? edit_add : edit_remove);
+                x = prev_x;
+                y = prev_y;
+            }
+        }
+        std::reverse (script.begin() + script_start, script.end());
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue diff (const jvalue& source, const jvalue& target)
+    {
+        if (source.invalid() || target.invalid())
+            throw std::invalid_argument ("Invalid JSON instance");
+
+        jvalue patch (j_array);
+        diff_engine_t engine (patch.array());
+        std::string path;
+        engine.diff (source, target, path);
+        return patch;
+    }
+
+
+}
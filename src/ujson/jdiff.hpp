@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JDIFF_HPP
+#define UJSON_JDIFF_HPP
+
+#include <ujson/jvalue.hpp>
+
+
+namespace ujson {
+
+
+    /**
+     * Create a JSON patch that transforms one JSON instance into another.
+     * The result is a JSON patch definition as described in RFC 6902,
+     * such that patching <code>source</code> with it gives a JSON
+     * instance that is equal to <code>target</code>, according to
+     * jvalue::operator==. If the instances are equal, the patch is
+     * an empty array.
+     * <br/>
+     * Both instances are hashed once, and subtrees with different
+     * hashes are treated as different without comparing them further.
+     * Subtrees with the same hash are compared with jvalue::operator==
+     * before they are treated as equal, so a hash collision doesn't
+     * give a wrong patch. The time needed, after hashing, depends on the
+     * number of changes and the size of the objects and arrays
+     * containing them, and on the size of the unchanged items in those
+     * arrays, not on the size of the rest of the instances.
+     * Objects and arrays with a cached hash value (see
+     * jvalue::cache_hash) are not hashed again, and objects and arrays
+     * shared by both instances (see jvalue::share) are skipped without
+     * being hashed. So the difference between a value and a changed
+     * copy made by jvalue::share is found without walking the parts
+     * that weren't changed.
+     * <ul>
+     *   <li>Object members are matched by name. A member that is
+     *       only in one of the objects is removed or added.
+     *       If an object has more than one member with the same
+     *       name, and they differ, the whole object is replaced.</li>
+     *   <li>Array items are matched using a longest common subsequence
+     *       of the item hashes, so inserted and removed items give
+     *       <code>add</code> and <code>remove</code> operations. An
+     *       item that is replaced by another is diffed recursively.
+     *       Arrays with a very large number of changes are compared
+     *       item by item instead.</li>
+     *   <li>The order of the members in an object isn't kept, since it
+     *       doesn't affect equality. Added members end up last.</li>
+     * </ul>
+     * \par Example:
+     * \code
+     * auto patch = ujson::diff (old_version, new_version);
+     * ujson::patch (old_version, patch); // old_version == new_version
+     * \endcode
+     * @param source The JSON instance to transform.
+     * @param target The JSON instance that the patch results in.
+     * @return An array of JSON patch operations.
+     * @throw std::invalid_argument If any parameter is an invalid JSON value
+     *                              (of type ujson::j_invalid).
+     * @see <a href=https://datatracker.ietf.org/doc/html/rfc6902 rel="noopener noreferrer" target="_blank">RFC 6902 - JavaScript Object Notation (JSON) Patch</a>
+     */
+    jvalue diff (const jvalue& source, const jvalue& target);
+
+
+}
+#endif
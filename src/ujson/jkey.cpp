@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jkey.hpp>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+
+namespace ujson {
+
+
+    // Names longer than this are never interned
+    static constexpr size_t max_interned_length = 128;
+
+    const std::string jkey::empty_string;
+
+
+    //--------------------------------------------------------------------------
+    // The table of interned keys. The strings are never freed, the
+    // table maps a view of each string to the string itself.
+    //--------------------------------------------------------------------------
+    struct intern_table_t {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, const std::string*> strings;
+        std::atomic<size_t> max_size {65536};
+    };
+    static intern_table_t& intern_table ()
+    {
+        static intern_table_t* table = new intern_table_t; // Never destroyed
+        return *table;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey::jkey (const std::string& name)
+        : key {reinterpret_cast<std::uintptr_t>(new std::string(name)) | owned}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey::jkey (std::string&& name)
+        : key {reinterpret_cast<std::uintptr_t>(new std::string(std::move(name))) | owned}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey::jkey (const char* name)
+        : key {reinterpret_cast<std::uintptr_t>(new std::string(name==nullptr?"":name)) | owned}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey::jkey (const std::string_view& name)
+        : key {reinterpret_cast<std::uintptr_t>(new std::string(name)) | owned}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey::jkey (const jkey& k)
+    {
+        if (k.interned())
+            key = k.key;
+        else
+            key = reinterpret_cast<std::uintptr_t>(new std::string(*k.ptr())) | owned;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey& jkey::operator= (const jkey& k)
+    {
+        if (this != &k) {
+            jkey tmp (k);
+            std::swap (key, tmp.key);
+        }
+        return *this;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey& jkey::operator= (jkey&& k) noexcept
+    {
+        if (this != &k) {
+            if (kind() == owned)
+                delete ptr ();
+            key = k.key;
+            k.key = reinterpret_cast<std::uintptr_t> (&empty_string);
+        }
+        return *this;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jkey jkey::intern (const std::string_view& name)
+    {
+        if (name.empty())
+            return jkey ();
+        if (name.size() > max_interned_length)
+            return jkey (name);
+
+        auto& table = intern_table ();
+        std::lock_guard<std::mutex> lock (table.mutex);
+
+        auto entry = table.strings.find (name);
+        if (entry != table.strings.end())
+            return jkey (reinterpret_cast<std::uintptr_t>(entry->second));
+
+        if (table.strings.size() >= table.max_size)
+            return jkey (name);
+
+        auto* str = new std::string (name);
+        table.strings.emplace (std::string_view(*str), str);
+        return jkey (reinterpret_cast<std::uintptr_t>(str));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    size_t jkey::max_interned ()
+    {
+        return intern_table().max_size;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jkey::max_interned (size_t max)
+    {
+        intern_table().max_size = max;
+    }
+
+
+}
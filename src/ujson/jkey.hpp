@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JKEY_HPP
+#define UJSON_JKEY_HPP
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <functional>
+#include <cstdint>
+
+
+namespace ujson {
+
+    /**
+     * The name of a JSON object member, stored as a single pointer.
+     * If the library is configured with cmake option
+     * <code>-DINTERNED_KEYS=True</code>, type ujson::json_object
+     * uses jkey instead of <code>std::string</code> as key type.<br/>
+     * A jkey is either <em>interned</em> or <em>owned</em>. An interned
+     * key points to a string in a process wide table that is never
+     * freed. All interned keys with the same name share that string,
+     * so copying an interned key is a pointer copy, and two interned
+     * keys are equal only if they point to the same string. An owned
+     * key has a string of its own.<br/>
+     * The parser interns the names of object members. A jkey created
+     * from a string is owned, unless created by jkey::intern().
+     * The table has a fixed maximum size, when it is full, or if the
+     * name is long, jkey::intern() returns an owned key instead.<br/>
+     * A jkey is implicitly converted to a <code>const std::string&</code>.
+     * Keys are ordered the same way as <code>std::string</code>.
+     */
+    class jkey {
+    public:
+        /**
+         * Create an empty key.
+         */
+        jkey () : key {reinterpret_cast<std::uintptr_t>(&empty_string)} {}
+
+        /**
+         * Create an owned key.
+         * @param name The name of the key.
+         */
+        jkey (const std::string& name);
+
+        /**
+         * Create an owned key.
+         * @param name The name of the key.
+         */
+        jkey (std::string&& name);
+
+        /**
+         * Create an owned key.
+         * @param name The name of the key, <code>nullptr</code> is
+         *             treated as an empty string.
+         */
+        jkey (const char* name);
+
+        /**
+         * Create an owned key.
+         * @param name The name of the key.
+         */
+        explicit jkey (const std::string_view& name);
+
+        /**
+         * Copy constructor.
+         * A copy of an interned key is interned,
+         * a copy of any other key is owned.
+         * @param k The key to copy.
+         */
+        jkey (const jkey& k);
+
+        /**
+         * Move constructor.
+         * @param k The key to move. It is empty after the move.
+         */
+        jkey (jkey&& k) noexcept : key {k.key} {
+            k.key = reinterpret_cast<std::uintptr_t> (&empty_string);
+        }
+
+        /**
+         * Destructor.
+         */
+        ~jkey () {
+            if (kind() == owned)
+                delete ptr ();
+        }
+
+        /**
+         * Assignment operator.
+         * @param k The key to copy.
+         * @return A reference to this key.
+         */
+        jkey& operator= (const jkey& k);
+
+        /**
+         * Move assignment operator.
+         * @param k The key to move. It is empty after the move.
+         * @return A reference to this key.
+         */
+        jkey& operator= (jkey&& k) noexcept;
+
+        /**
+         * Get an interned key.
+         * If the name is found in the table of interned keys, or the
+         * table has room for it, an interned key is returned.
+         * Otherwise an owned key is returned.
+         * This function is thread safe.
+         * @param name The name of the key.
+         * @return A key with the given name.
+         */
+        static jkey intern (const std::string_view& name);
+
+        /**
+         * Create a key that refers to a string owned by the caller.
+         * This is used to look up object members without copying
+         * the name. The string must outlive the key, a copy of the key
+         * is an owned key.
+         * @param name The name to refer to.
+         * @return A key referring to <code>name</code>.
+         */
+        static jkey ref (const std::string& name) {
+            return jkey (reinterpret_cast<std::uintptr_t>(&name) | referenced);
+        }
+
+        /**
+         * Get the maximum number of interned keys.
+         * @return The maximum number of strings in the table of interned keys.
+         */
+        static size_t max_interned ();
+
+        /**
+         * Set the maximum number of interned keys.
+         * Strings already interned are kept.
+         * @param max The maximum number of strings in the table of interned keys.
+         */
+        static void max_interned (size_t max);
+
+        /**
+         * Check if this is an interned key.
+         * @return <code>true</code> if this key is interned.
+         */
+        bool interned () const {
+            return kind() == interned_key;
+        }
+
+        /**
+         * Get the name of the key.
+         * @return A reference to the name of the key.
+         */
+        const std::string& str () const {
+            return *ptr ();
+        }
+
+        /**
+         * Get the name of the key.
+         * @return A reference to the name of the key.
+         */
+        operator const std::string& () const {
+            return *ptr ();
+        }
+
+        /**
+         * Get the name as a null terminated string.
+         * @return A pointer to the name of the key.
+         */
+        const char* c_str () const {
+            return ptr()->c_str ();
+        }
+
+        /**
+         * Get the name of the key.
+         * @return A pointer to the characters of the name.
+         */
+        const char* data () const {
+            return ptr()->data ();
+        }
+
+        /**
+         * Get the length of the name.
+         * @return The length of the name.
+         */
+        size_t size () const {
+            return ptr()->size ();
+        }
+
+        /**
+         * Get the length of the name.
+         * @return The length of the name.
+         */
+        size_t length () const {
+            return ptr()->length ();
+        }
+
+        /**
+         * Check if the name is empty.
+         * @return <code>true</code> if the name is an empty string.
+         */
+        bool empty () const {
+            return ptr()->empty ();
+        }
+
+        /**
+         * Get an iterator to the first character of the name.
+         * @return A const iterator.
+         */
+        std::string::const_iterator begin () const {
+            return ptr()->begin ();
+        }
+
+        /**
+         * Get an iterator past the last character of the name.
+         * @return A const iterator.
+         */
+        std::string::const_iterator end () const {
+            return ptr()->end ();
+        }
+
+        /**
+         * Compare two keys.
+         * Two interned keys are compared by address.
+         */
+        friend bool operator== (const jkey& lhs, const jkey& rhs) {
+            if (lhs.key == rhs.key)
+                return true;
+            if (lhs.interned() && rhs.interned())
+                return false;
+            return *lhs.ptr() == *rhs.ptr();
+        }
+
+        /**
+         * Compare two keys in the same order as <code>std::string</code>.
+         */
+        friend bool operator< (const jkey& lhs, const jkey& rhs) {
+            return lhs.key != rhs.key  &&  *lhs.ptr() < *rhs.ptr();
+        }
+
+
+    private:
+        // The low bits of 'key' tells what it points to
+        static constexpr std::uintptr_t interned_key = 0; // String in the table of interned keys
+        static constexpr std::uintptr_t owned        = 1; // String allocated by this key
+        static constexpr std::uintptr_t referenced   = 2; // String owned by someone else
+        static constexpr std::uintptr_t kind_mask    = 3;
+
+        std::uintptr_t key;
+
+        static const std::string empty_string;
+
+        explicit jkey (std::uintptr_t k) : key {k} {}
+
+        std::uintptr_t kind () const {
+            return key & kind_mask;
+        }
+        const std::string* ptr () const {
+            return reinterpret_cast<const std::string*> (key & ~kind_mask);
+        }
+    };
+
+
+    /** Compare a key with a string. */
+    inline bool operator== (const jkey& lhs, const std::string& rhs) {return lhs.str() == rhs;}
+    /** Compare a key with a string. */
+    inline bool operator== (const std::string& lhs, const jkey& rhs) {return lhs == rhs.str();}
+    /** Compare a key with a string. */
+    inline bool operator== (const jkey& lhs, const char* rhs) {return lhs.str() == rhs;}
+    /** Compare a key with a string. */
+    inline bool operator== (const char* lhs, const jkey& rhs) {return lhs == rhs.str();}
+    /** Compare two keys. */
+    inline bool operator!= (const jkey& lhs, const jkey& rhs) {return !(lhs == rhs);}
+    /** Compare a key with a string. */
+    inline bool operator!= (const jkey& lhs, const std::string& rhs) {return lhs.str() != rhs;}
+    /** Compare a key with a string. */
+    inline bool operator!= (const std::string& lhs, const jkey& rhs) {return lhs != rhs.str();}
+    /** Compare a key with a string. */
+    inline bool operator!= (const jkey& lhs, const char* rhs) {return lhs.str() != rhs;}
+    /** Compare a key with a string. */
+    inline bool operator!= (const char* lhs, const jkey& rhs) {return lhs != rhs.str();}
+    /** Compare a key with a string. */
+    inline bool operator< (const jkey& lhs, const std::string& rhs) {return lhs.str() < rhs;}
+    /** Compare a key with a string. */
+    inline bool operator< (const std::string& lhs, const jkey& rhs) {return lhs < rhs.str();}
+
+    /** Concatenate a key and a string. */
+    inline std::string operator+ (const jkey& lhs, const std::string& rhs) {return lhs.str() + rhs;}
+    /** Concatenate a string and a key. */
+    inline std::string operator+ (const std::string& lhs, const jkey& rhs) {return lhs + rhs.str();}
+    /** Concatenate a key and a string. */
+    inline std::string operator+ (const jkey& lhs, const char* rhs) {return lhs.str() + rhs;}
+    /** Concatenate a string and a key. */
+    inline std::string operator+ (const char* lhs, const jkey& rhs) {return lhs + rhs.str();}
+
+    /** Write the name of a key to an output stream. */
+    inline std::ostream& operator<< (std::ostream& out, const jkey& k) {return out << k.str();}
+
+}
+
+
+namespace std {
+    /**
+     * Hash function for ujson::jkey, the same as for the name as a <code>std::string</code>.
+     */
+    template<>
+    struct hash<ujson::jkey> {
+        size_t operator() (const ujson::jkey& k) const {
+            return std::hash<std::string>() (k.str());
+        }
+    };
+}
+
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jobject_builder.hpp>
+#include <iterator>
+
+
+namespace ujson {
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jobject_builder::jobject_builder (size_t capacity)
+    {
+        members.reserve (capacity);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue& jobject_builder::add (const std::string& name, const jvalue& value)
+    {
+        if (!value.valid())
+            throw std::invalid_argument ("Invalid JSON value");
+        return members.emplace_back(name, value).second;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue& jobject_builder::add (const std::string& name, jvalue&& value)
+    {
+        if (!value.valid())
+            throw std::invalid_argument ("Invalid JSON value");
+        return members.emplace_back(name, std::move(value)).second;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jobject_builder::build ()
+    {
+        jvalue object (j_object);
+        object.obj().append (std::make_move_iterator(members.begin()),
+                             std::make_move_iterator(members.end()));
+        members.clear ();
+        return object;
+    }
+
+
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JOBJECT_BUILDER_HPP
+#define UJSON_JOBJECT_BUILDER_HPP
+
+#include <ujson/jvalue.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+
+namespace ujson {
+
+
+    /**
+     * Build a JSON object with member names known to be unique.
+     * jvalue::add() looks for an existing member with the same name
+     * and keeps the object's index of member names up to date for
+     * each added member. A jobject_builder instead trusts the caller
+     * that all member names are unique: members are collected in an
+     * array without any checks, and the index of member names is
+     * created once, when build() returns the object.
+     * If a name is added more than once anyway, the object gets
+     * duplicate member names, like a parsed object may have.
+     * <br/>
+     * Example:
+     * <pre>
+     * ujson::jobject_builder builder (3);
+     * builder.add ("id", 17);
+     * builder.add ("name", "Foo");
+     * builder.emplace ("count", 10L);
+     * ujson::jvalue obj = builder.build ();
+     * </pre>
+     */
+    class jobject_builder {
+    public:
+        /**
+         * Constructor.
+         * @param capacity The number of members to make room for.
+         */
+        explicit jobject_builder (size_t capacity=0);
+
+        /**
+         * Make room for a number of members.
+         * @param capacity The number of members to make room for.
+         */
+        void reserve (size_t capacity) {
+            members.reserve (capacity);
+        }
+
+        /**
+         * Return the number of members added since the last call to build().
+         */
+        size_t size () const {
+            return members.size ();
+        }
+
+        /**
+         * Add a member.
+         * @param name The name of the member, which must not
+         *             be the name of an already added member.
+         * @param value The value of the member.
+         * @return A reference to the added value. It is valid
+         *         until the next member is added.
+         * @throw std::invalid_argument If parameter <code>value</code>
+         *        is an invalid JSON value (of type ujson::j_invalid).
+         */
+        jvalue& add (const std::string& name, const jvalue& value);
+
+        /**
+         * Move a member to the builder.
+         * @param name The name of the member, which must not
+         *             be the name of an already added member.
+         * @param value The value of the member.
+         * @return A reference to the added value. It is valid
+         *         until the next member is added.
+         * @throw std::invalid_argument If parameter <code>value</code>
+         *        is an invalid JSON value (of type ujson::j_invalid).
+         */
+        jvalue& add (const std::string& name, jvalue&& value);
+
+        /**
+         * Add a member with a value created in place from the
+         * arguments given to a jvalue constructor.
+         * @param name The name of the member, which must not
+         *             be the name of an already added member.
+         * @param args Arguments to the jvalue constructor.
+         * @return A reference to the added value. It is valid
+         *         until the next member is added.
+         * @throw std::invalid_argument If the created value is an
+         *        invalid JSON value (of type ujson::j_invalid).
+         */
+        template<class... Args>
+        jvalue& emplace (const std::string& name, Args&&... args) {
+            auto& value = members.emplace_back(std::piecewise_construct,
+                                               std::forward_as_tuple(name),
+                                               std::forward_as_tuple(std::forward<Args>(args)...)).second;
+            if (!value.valid()) {
+                members.pop_back ();
+                throw std::invalid_argument ("Invalid JSON value");
+            }
+            return value;
+        }
+
+        /**
+         * Return a JSON object with the added members,
+         * in the order they were added.
+         * The builder is then empty and can be used again.
+         * @return A JSON object (of type ujson::j_object).
+         */
+        jvalue build ();
+
+
+    private:
+        std::vector<std::pair<json_key, jvalue>> members;
+    };
+
+
+}
+#endif
@@ -18,16 +18,32 @@
  */
 #include <ujson/internal.hpp>
 #include <ujson/jtokenizer.hpp>
+#include <ujson/file_view.hpp>
+#include <ujson/jcompress.hpp>
 #include <ujson/jparser.hpp>
+#include <ujson/jarena.hpp>
 #include <ujson/utils.hpp>
-#include <fstream>
+#include <ujson/jpointer.hpp>
+#include <ujson/parse_machine.hpp>
 #include <algorithm>
 #include <string_view>
 #include <string>
 #include <mutex>
-#include <stack>
 #include <list>
 #include <set>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 #include <cstdlib>
 #include <cstdint>
 
@@ -44,6 +60,16 @@ using std::endl;
 
 #define CTX reinterpret_cast<parser_t*>(parse_context)
 
+// Run a statement when statistics are collected,
+// see jparser::collect_stats(). If the library is
+// built without support for statistics, this is
+// compiled to nothing.
+#if UJSON_COLLECT_STATS
+#define ON_STATS(...) do { if (collecting) { __VA_ARGS__; } } while (0)
+#else
+#define ON_STATS(...) do {} while (0)
+#endif
+
 
 using namespace ujson::parser;
 
@@ -53,7 +79,7 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static const std::string parser_err_to_str (jparser::err error)
+    const std::string parser_err_to_str (jparser::err error)
     {
         switch (error) {
         case ujson::jparser::err::ok:
@@ -134,6 +160,9 @@ namespace ujson {
         case ujson::jparser::err::max_obj_size_exceeded:
             return "Maximum number of object members exceeded.";
 
+        case ujson::jparser::err::aborted:
+            return "Parsing aborted";
+
         default:
             return "(unkown error)";
         }
@@ -141,23 +170,86 @@ namespace ujson {
 
 
     //--------------------------------------------------------------------------
-    class parser_t {
+    // A node matching token "*" is also added to all named children,
+    // and a new named child starts as a copy of 'any', so the node
+    // of a child always includes all patterns matching it.
+    //--------------------------------------------------------------------------
+    void projection_node_t::add (jpointer::tokens_t::const_iterator token,
+                                 jpointer::tokens_t::const_iterator end)
+    {
+        if (whole)
+            return;
+        if (token == end) {
+            whole = true;
+            children.clear ();
+            any.reset ();
+            return;
+        }
+        auto next = std::next (token);
+        if (*token == "*") {
+            if (!any)
+                any.reset (new projection_node_t);
+            any->add (next, end);
+            for (auto& entry : children)
+                entry.second.add (next, end);
+        }else{
+            auto entry = children.find (*token);
+            if (entry == children.end()) {
+                entry = children.emplace (*token,
+                                          any ? *any : projection_node_t()).first;
+            }
+            entry->second.add (next, end);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // An array or object being parsed.
+    //--------------------------------------------------------------------------
+    struct build_frame_t : public parse_frame_t {
+        size_t first_value {0};  // Index in 'parse_values' of the first array element
+        size_t first_member {0}; // Index in 'parse_members' of the first object member
+        jvalue object;           // The object being parsed
+        json_key name;           // Name of the currently parsed object member
+    };
+
+
+    //--------------------------------------------------------------------------
+    // Builds a jvalue tree from the events of the parse machine.
+    //--------------------------------------------------------------------------
+    class parser_t : public parse_machine<parser_t, build_frame_t> {
     public:
         parser_t () {
-            max_depth = 0;
-            max_array_size = 0;
-            max_object_size = 0;
-            strict = true;
             allow_duplicates = true;
+            lines_pos = nullptr;
+            lines_end = nullptr;
+            lines_row = 0;
+            line_num = 0;
+            num_threads = 1;
+            parallel_min_size = 0;
+            numbers_as_text = false;
+            strings_as_views = false;
+            synchronized = true;
+#if UJSON_COLLECT_STATS
+            collecting = false;
+#endif
             reset ();
         }
 
-        void limits (unsigned max_depth_arg,
-                     unsigned max_array_size_arg,
-                     unsigned max_object_size_arg);
+        void threads (unsigned num_threads_arg, size_t min_size);
+        void lazy_numbers (bool enable) {numbers_as_text = enable;}
+        void borrow_strings (bool enable) {strings_as_views = enable;}
+        void reset_stats () {
+#if UJSON_COLLECT_STATS
+            stats = jstats ();
+#endif
+        }
+        void projection (std::shared_ptr<const projection_node_t> root) {projection_root = root;}
+        const std::shared_ptr<const projection_node_t>& projection () const {return projection_root;}
+        json_key member_name (const jtoken& token);
 
         jvalue parse (const char* buffer,
-                      const unsigned buffer_size,
+                      const size_t buffer_size,
                       bool strict_parsing=false,
                       bool allow_duplicates_in_obj=true);
         jvalue parse (const std::string& buffer,
@@ -166,152 +258,223 @@ namespace ujson {
         jvalue parse_file (const std::string& file_name,
                            bool strict_parsing=false,
                            bool allow_duplicates_in_obj=true);
-
-        const jparser::err error_code () const {
-            return err_code;
-        }
-        const unsigned error_row () const {
-            return err_row;
-        }
-        const unsigned error_col () const {
-            return err_col;
+        jvalue parse_input (jdecompressor& in,
+                            bool strict_parsing,
+                            bool allow_duplicates_in_obj);
+
+        void begin (bool strict_parsing, bool allow_duplicates_in_obj);
+        bool feed (const char* buffer, const size_t buffer_size);
+        jvalue finish ();
+
+        void begin_stream (jparser::stream_t what,
+                           bool strict_parsing,
+                           bool allow_duplicates_in_obj);
+        bool next_value (jvalue& value);
+        bool finish_stream ();
+
+        void begin_lines (const char* buffer,
+                          const size_t buffer_size,
+                          bool strict_parsing,
+                          bool allow_duplicates_in_obj,
+                          unsigned first_line=0);
+        bool parse_lines (const char* buffer,
+                          const size_t buffer_size,
+                          jparser::line_handler_t& handler,
+                          bool strict_parsing,
+                          bool allow_duplicates_in_obj,
+                          unsigned num_threads,
+                          bool ordered);
+        bool parse_lines_file (const std::string& file_name,
+                               jparser::line_handler_t& handler,
+                               bool strict_parsing,
+                               bool allow_duplicates_in_obj,
+                               unsigned num_threads,
+                               bool ordered);
+        bool begin_lines_file (const std::string& file_name,
+                               bool strict_parsing,
+                               bool allow_duplicates_in_obj);
+        bool next_line (jvalue& value);
+        unsigned line () const {
+            return line_num;
         }
 
+        // Locked by the jparser methods if synchronized is true,
+        // see jparser::synchronized().
         std::mutex mutex;
+        bool synchronized;
+
+#if UJSON_COLLECT_STATS
+        // Statistics about the parsed document. They are reset by
+        // the jparser methods, not by begin(), so a worker parser
+        // in parse_parallel() collects them for all its values.
+        bool collecting;
+        jstats stats;
+#endif
 
     private:
-        unsigned max_depth;
-        unsigned max_array_size;
-        unsigned max_object_size;
+        friend class parse_machine<parser_t, build_frame_t>;
+
         unsigned row;
         unsigned col;
-        unsigned err_row;
-        unsigned err_col;
-        jparser::err err_code;
-        const char* buf_pos;
-        const char* buf_end;
 
         jtokenizer tokenizer;
-        bool strict;
         bool allow_duplicates;
 
+        // Incremental parsing:
+        // 'in_progress' is true between begin() and finish().
+        // 'pending' holds input not yet parsed, typically a token
+        // that may continue in the next chunk of input.
+        // 'base_row' and 'base_col' is the position in the
+        // document of the first byte in the current buffer.
+        bool in_progress;
+        std::string pending;
+        size_t base_row;
+        size_t base_col;
+
+        // Streaming, see jparser::begin_stream():
+        // Top level array items, or top level documents, are
+        // moved to 'streamed' as soon as they are parsed.
+        enum stream_mode_t {
+            stream_none,
+            stream_items,
+            stream_documents,
+        };
+        stream_mode_t stream_mode;
+        std::deque<jvalue> streamed;
+
+        // Newline delimited documents:
+        // The remaining lines are found in [lines_pos, lines_end).
+        // 'lines_row' is the line number of 'lines_pos', and
+        // 'line_num' is the line of the last parsed document.
+        std::unique_ptr<file_view> lines_file;
+        const char* lines_pos;
+        const char* lines_end;
+        unsigned lines_row;
+        unsigned line_num;
+
+        // Parallel parsing of a single document:
+        // Documents of at least 'parallel_min_size' bytes are
+        // parsed using 'num_threads' threads, 1 means serial parsing.
+        unsigned num_threads;
+        size_t parallel_min_size;
+
+        // Store numbers as text, converted when first used
+        bool numbers_as_text;
+
+        // Borrowed strings:
+        // If 'strings_as_views' is true, strings without escape
+        // sequences refer to the parsed buffer. This is only done
+        // while 'borrowing' is true, the buffer is then known to
+        // outlive the parsed document. 'borrowed_file' is the
+        // input of the last call to parse_file().
+        bool strings_as_views;
+        bool borrowing;
+        std::unique_ptr<file_view> borrowed_file;
+
+        // Projection:
+        // If 'projection_root' is set, only the selected parts of the
+        // document are parsed.
+        std::shared_ptr<const projection_node_t> projection_root;
+
+#if UJSON_INTERNED_KEYS
+        // Interned object member names found by this parser. The
+        // views refer to strings in the table of interned keys.
+        std::unordered_map<std::string_view, jkey> key_cache;
+#endif
+
+        bool parse_parallel (const char* buffer,
+                             const size_t buffer_size,
+                             jvalue& instance);
+
+#if UJSON_COLLECT_STATS
+        void count_string (size_t size) {
+            static const size_t sso_capacity = std::string().capacity ();
+            if (size > sso_capacity)
+                ++stats.allocations;
+        }
+        void count_value (const jvalue& value);
+        void merge_stats (const jstats& s);
+        size_t parse_tokens_with_stats (bool last_chunk);
+#endif
+
         void reset () {
+            reset_machine ();
             row = 0;
             col = 0;
-            err_row = 0;
-            err_col = 0;
-            err_code = jparser::err::ok;
-            buf_pos = nullptr;
-            buf_end = nullptr;
-            while (!parse_state.empty())
-                parse_state.pop ();
-            while (!parse_values.empty())
-                parse_values.pop ();
-            while (!parse_objects.empty())
-                parse_objects.pop ();
-            while (!parse_pairs.empty())
-                parse_pairs.pop ();
-        }
-        /*
-        void error (const jparser::err_code_t code, const std::string& msg) {
-            error (code, msg, token.row, token.col);
-        }
-        */
-        void error (const jparser::err code, unsigned row_arg, unsigned col_arg) {
-            err_row = row_arg;
-            err_col = col_arg;
-            err_code = code;
+            in_progress = false;
+            borrowing = false;
+            part_borrowed = false;
+            pending.clear ();
+            stream_mode = stream_none;
+            streamed.clear ();
+            base_row = 0;
+            base_col = 0;
+            parse_values.clear ();
+            parse_members.clear ();
         }
 
         jvalue token_to_number (const jtoken& token);
 
-        void on_parsed_value (const jtoken& token, jvalue&& value);
-        jvalue parse_tokens ();
-        jvalue post_parse_tokens (const jtoken* token);
-        void parse_value_tokens (const jtoken& token);
-        bool parse_str_value_tokens (const jtoken& token);
-        void parse_array_tokens (const jtoken& token);
-        void parse_elements_tokens (const jtoken& token);
-        void parse_object_tokens (const jtoken& token);
-        void parse_members_tokens (const jtoken& token);
-        void on_object_member_name (const jtoken& token);
-        void parse_pair_tokens (const jtoken& token);
-
-        enum parse_state_t {
-            ps_value,     // A JSON value of any type is being parsed
-            ps_str_value, // A JSON string is being parsed
-
-            ps_array,     // A JSON array is being parsed
-            ps_elements,  // Elements in a JSON array is being parsed
-
-            ps_object,    // A JSON object is being parsed
-            ps_members,   // Members (attributes) of an object is being parsed
-            ps_pair,      // A key-value pair of an object member is being parsed
-        };
-
-#if (PARSE_DEBUG)
-        static std::string parse_state_to_string (parse_state_t ps) {
-            switch (ps) {
-            case ps_value:
-                return "ps_value";
-                break;
-            case ps_str_value:
-                return "ps_str_value";
-                break;
-            case ps_array:
-                return "ps_array";
-                break;
-            case ps_elements:
-                return "ps_elements";
-                break;
-            case ps_object:
-                return "ps_object";
-                break;
-            case ps_members:
-                return "ps_members";
-                break;
-            case ps_pair:
-                return "ps_pair";
-                break;
-            default:
-                return "(unknown)";
-            }
+        void add_value (jvalue&& value);
+        void next_document ();
+        void resolve_error_pos ();
+        size_t parse_tokens (bool last_chunk);
+        jvalue post_parse_tokens ();
+
+        // Events from the parse machine
+        void on_begin_object (const jtoken& token, build_frame_t& frame);
+        void on_begin_array (const jtoken& token, build_frame_t& frame);
+        void on_member_name (const jtoken& token, build_frame_t& frame);
+        void on_member_value (build_frame_t& frame);
+        void on_end_object (const jtoken& token, build_frame_t& frame);
+        void on_end_array (const jtoken& token, build_frame_t& frame);
+        void on_null (const jtoken& token) {
+            add_value (nullptr);
         }
-#endif
-
-        struct obj_member_t {
-            obj_member_t ()
-                : has_name (false),
-                  has_colon (false)
-                {
-                }
-            void reset () {
-                has_name = false;
-                has_colon = false;
+        void on_bool (const jtoken& token, bool value) {
+            add_value (value);
+        }
+        void on_number (const jtoken& token) {
+            add_value (token_to_number(token));
+        }
+        void on_string (const jtoken& token);
+        void on_string_part (const jtoken& token, bool first);
+        void on_string_end (const jtoken& token) {
+            if (part_borrowed) {
+                part_borrowed = false;
+                jvalue value;
+                string_as_view (borrowed_part, value);
+                add_value (std::move(value));
+                return;
             }
-            std::string name;
-            bool has_name;
-            bool has_colon;
-        };
-
-        std::stack<parse_state_t> parse_state;
-
-        // The first json_array pushed to this stack is an array
-        // with only a single element: The top level instance of
-        // the parsed JSON document.
-        // After this, the top of the stack contains an array
-        // with either:
-        //   The elements of the currently parsed JSON array.
-        // or:
-        //   A single element of the currently parsed object member value.
-        std::stack<json_array> parse_values;
-
-        // The top of the stack contains the currently parsed object.
-        std::stack<jvalue> parse_objects;
+            ON_STATS (count_string(parsed_string.size()));
+            add_value (jvalue(std::move(parsed_string)));
+        }
+        void on_skipped_items (size_t n);
+        std::string_view projected_name (const build_frame_t& frame) {
+            const std::string& name = frame.name;
+            return name;
+        }
+        bool on_document_done ();
+        void on_error_at_end (jparser::err code) {
+            error (code, row, col);
+        }
 
-        // The top of the stack contains the state
-        // of the currently parsed object member.
-        std::stack<obj_member_t> parse_pairs;
+        // Parsed values not yet added to an array or object.
+        // The elements of an array are collected here until the
+        // array is done, and then moved to the array in one go.
+        // The value of an object member is added to the object
+        // as soon as it is parsed. When the document is parsed,
+        // this contains only the top level instance.
+        std::vector<jvalue> parse_values;
+
+        // Parsed object members not yet added to their object.
+        // If duplicate member names are allowed, the names don't
+        // need to be looked up while parsing. The members of an
+        // object are then collected here until the object is done,
+        // and are added to the object in one go, so that the index
+        // of member names is created once instead of for each member.
+        std::vector<std::pair<json_key, jvalue>> parse_members;
 
         // This is the currently parsed string value until
         // the complete string is parsed.
@@ -319,60 +482,55 @@ namespace ujson {
         // multiple strings divided by whitespaces and comments.
         std::string parsed_string;
 
+        // If borrowing strings, the first part of a string in relaxed
+        // mode is kept here while it is the only part, and has no
+        // escape sequences. It is copied to 'parsed_string' if
+        // another part follows.
+        std::string_view borrowed_part;
+        bool part_borrowed {false};
+
+        // Scratch buffer used to unescape strings.
+        std::string unescaped;
+
 #if (PARSE_DEBUG)
         void dump_parse_stack_sizes () {
             cerr << "Parse stack sizes:" << endl;
             cerr << "    parse_state  : " << parse_state.size() << endl;
             cerr << "    parse_values : " << parse_values.size() << endl;
-            cerr << "    parse_objects: " << parse_objects.size() << endl;
-            cerr << "    parse_pairs  : " << parse_pairs.size() << endl;
+            cerr << "    frames       : " << frames.size() << endl;
         }
 #else
         inline void dump_parse_stack_sizes () {}
 #endif
     };
 
-#if 0
-value:          str_value
-        |       NUMBER
-        |       object
-        |       array
-        |       TRUE
-        |       FALSE
-        |       NULL
-                ;
-
-str_value:	STRING
-	|	STRING str_value          // Relaxed mode
-		;
-
-array:          LBRACK RBRACK
-        |       LBRACK elements RBRACK
-                ;
-
-elements:       value SEPARATOR elements
-        |       value SEPARATOR           // Relaxed mode
-        |       value
-                ;
-
-object:         LCBRACK RCBRACK
-        |       LCBRACK members RCBRACK
-                ;
-
-members:        pair SEPARATOR members
-        |       pair SEPARATOR            // Relaxed mode
-        |       pair
-                ;
 
-pair:           STRING COLON value
-        |       IDENTIFIER COLON value    // Relaxed mode
-                ;
-#endif
+    //--------------------------------------------------------------------------
+    // Locks the mutex of a parser_t, unless the
+    // parser is used without synchronization.
+    //--------------------------------------------------------------------------
+    class context_lock {
+    public:
+        context_lock (parser_t& ctx)
+            : m (ctx.synchronized ? &ctx.mutex : nullptr)
+        {
+            if (m)
+                m->lock ();
+        }
+        ~context_lock () {
+            if (m)
+                m->unlock ();
+        }
+        context_lock (const context_lock&) = delete;
+        context_lock& operator= (const context_lock&) = delete;
+    private:
+        std::mutex* m;
+    };
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jparser::err token_error_to_parser_error (const jtoken::error_t token_error)
+    jparser::err token_error_to_parser_error (const jtoken::error_t token_error)
     {
         switch (token_error) {
         case jtoken::ok:
@@ -413,79 +571,44 @@ pair:           STRING COLON value
     }
 
 
-     //--------------------------------------------------------------------------
-     //--------------------------------------------------------------------------
-    void parser_t::limits (unsigned max_depth_arg,
-                           unsigned max_array_size_arg,
-                           unsigned max_object_size_arg)
-    {
-        max_depth = max_depth_arg;
-        max_array_size = max_array_size_arg;
-        max_object_size = max_object_size_arg;
-    }
-
-
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    bool parser_t::parse_str_value_tokens (const jtoken& token)
+    void parser_t::threads (unsigned num_threads_arg, size_t min_size)
     {
-        if (token.type != jtoken::tk_string) {
-            parse_state.pop (); // pop ps_str_value
-            on_parsed_value (token, jvalue(std::move(parsed_string)));
-            return false; // Token not consumed
-        }
-
-        try {
-            parsed_string.append (unescape(token.data));
-        }
-        catch (...) {
-            error (jparser::err::invalid_string, token.row, token.col);
-        }
-
-        return true; // Token consumed
+        num_threads = num_threads_arg;
+        parallel_min_size = min_size;
     }
 
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue parser_t::token_to_number (const jtoken& token)
     {
-        jvalue value (j_number);
+        jvalue value;
+        if (numbers_as_text) {
+            ON_STATS (count_string(token.data.size()));
+            number_as_text (token.data, value);
+            return value;
+        }
+        if (number_from_token(token.data, value))
+            return value;
+
         std::string str (token.data);
         try {
+            number_from_string (str, value);
 #if UJSON_HAVE_GMPXX
-            // Lazy way to adjust the precision to fit the number.
-            // 4 bits per decimal digit in the number string,
-            // or 4 bits times the power of ten when the format is xEpow,
-            // or mpf_get_default_prec(), whatever is higher.
-            //std::string_view str (tk.ptr, tk.size);
-            auto e_pos = str.find ("e");
-            if (e_pos == std::string::npos)
-                e_pos = str.find ("E");
-
-            size_t precision;
-            if (e_pos == std::string::npos) {
-                precision = std::max (mpf_get_default_prec(),
-                                      mp_bitcnt_t(str.size()*4));
-            }else{
-                precision = std::max (mpf_get_default_prec(),
-                                      mp_bitcnt_t(std::abs(std::stod(str.substr(e_pos+1)))*4));
-            }
-            jvalue::num_t number (str, precision);
-            value.num (std::move(number));
-#else
-            jvalue::num_t number = std::stod (str);
-            value.num (number);
+            ON_STATS (++stats.mpf_numbers; ++stats.allocations);
 #endif
         }
         catch (std::invalid_argument&) {
-            error (jparser::err::invalid_number, token.row, token.col);
+            error (jparser::err::invalid_number, token);
 #if (PARSE_DEBUG)
             cerr << "Error converting token to number, token.data: " << token.data << endl;
 #endif
             value.type (j_invalid);
         }
         catch (std::out_of_range&) {
-            error (jparser::err::number_out_of_range, token.row, token.col);
+            error (jparser::err::number_out_of_range, token);
             value.type (j_invalid);
         }
 
@@ -494,409 +617,359 @@ pair:           STRING COLON value
 
 
     //--------------------------------------------------------------------------
+    // Convert an object member name token to an object key.
+    // Throws std::invalid_argument on invalid escape sequences.
     //--------------------------------------------------------------------------
-    void parser_t::on_parsed_value (const jtoken& token, jvalue&& value)
+    json_key parser_t::member_name (const jtoken& token)
     {
-        parse_values.top().emplace_back (std::forward<jvalue>(value));
-        parse_state.pop ();
-        if (max_array_size && !parse_state.empty() && parse_state.top()==ps_elements) {
-            if (parse_values.top().size() > max_array_size) {
-                error (jparser::err::max_array_size_exceeded,
-                       token.row,
-                       token.col);
-            }
+        const std::string_view& name = token.data;
+        const bool escaped = token.type==jtoken::tk_string && token.has_escapes;
+        ON_STATS (stats.escaped_strings += escaped);
+#if UJSON_INTERNED_KEYS
+        if (escaped) {
+            unescaped.clear ();
+            unescape_append (name, unescaped);
+            return jkey::intern (unescaped);
+        }
+
+        auto entry = key_cache.find (name);
+        if (entry != key_cache.end())
+            return entry->second;
+
+        auto key = jkey::intern (name);
+        if (key.interned())
+            key_cache.emplace (std::string_view(key.str()), key);
+        return key;
+#else
+        if (!escaped) {
+            ON_STATS (count_string(name.size()));
+            return json_key (name);
         }
+        unescaped.clear ();
+        unescape_append (name, unescaped);
+        ON_STATS (count_string(unescaped.size()));
+        return unescaped;
+#endif
     }
 
+
     //--------------------------------------------------------------------------
+    // Add a parsed value to the current array, or as the value of
+    // the current object member. When streaming the items of the top
+    // level array, the items are moved out of the parser instead.
     //--------------------------------------------------------------------------
-    void parser_t::parse_value_tokens (const jtoken& token)
+    void parser_t::add_value (jvalue&& value)
     {
-        switch (token.type) {
-        case jtoken::tk_invalid:
-            error (jparser::err::invalid_token, token.row, token.col);
-            break;
-
-        case jtoken::tk_lcbrack:
-            // Start of object
-            if (max_depth  &&  parse_values.size() > max_depth)
-                error (jparser::err::max_depth_exceeded, token.row, token.col);
-            else
-                parse_state.push (ps_object);
-            break;
-
-        case jtoken::tk_rcbrack:
-            error (jparser::err::misplaced_right_curly_bracket, token.row, token.col);
-            break;
-
-        case jtoken::tk_lbrack:
-            // Start of array
-            if (max_depth  &&  parse_values.size() > max_depth)
-                error (jparser::err::max_depth_exceeded, token.row, token.col);
-            else
-                parse_state.push (ps_array);
-            break;
-
-        case jtoken::tk_rbrack:
-            if (strict) {
-                error (jparser::err::misplaced_right_bracket, token.row, token.col);
-            }else{
-                parse_state.pop ();
-                if (!parse_state.empty() && parse_state.top()==ps_elements)
-                    parse_elements_tokens (token);
-                else
-                    error (jparser::err::misplaced_right_bracket, token.row, token.col);
-            }
-            break;
-
-        case jtoken::tk_separator:
-            error (jparser::err::misplaced_separator, token.row, token.col);
-            break;
-
-        case jtoken::tk_colon:
-            error (jparser::err::misplaced_colon, token.row, token.col);
-            break;
+        if (stream_mode == stream_items  &&  frames.size() == 1  &&  in_elements()) {
+            // An item of the top level array, move it out of the parser
+            streamed.emplace_back (std::forward<jvalue>(value));
+            return;
+        }
+        parse_values.emplace_back (std::forward<jvalue>(value));
+        ON_STATS (count_value(parse_values.back()));
+    }
 
-        case jtoken::tk_null:
-            on_parsed_value (token, nullptr);
-            break;
 
-        case jtoken::tk_true:
-            on_parsed_value (token, true);
-            break;
+    //--------------------------------------------------------------------------
+    // Keep the index of the next array element by replacing
+    // skipped elements before it with null values.
+    //--------------------------------------------------------------------------
+    void parser_t::on_skipped_items (size_t n)
+    {
+        if (stream_mode == stream_items  &&  frames.size() == 1)
+            streamed.insert (streamed.end(), n, jvalue(j_null));
+        else
+            parse_values.insert (parse_values.end(), n, jvalue(j_null));
+    }
 
-        case jtoken::tk_false:
-            on_parsed_value (token, false);
-            break;
 
-        case jtoken::tk_string:
-            try {
-                if (strict) {
-                    on_parsed_value (token, unescape(token.data));
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void parser_t::on_string (const jtoken& token)
+    {
+        try {
+            if (!token.has_escapes) {
+                if (borrowing) {
+                    jvalue value;
+                    string_as_view (token.data, value);
+                    add_value (std::move(value));
                 }else{
-                    parsed_string = unescape (token.data);
-                    parse_state.push (ps_str_value);
+                    ON_STATS (count_string(token.data.size()));
+                    add_value (std::string(token.data));
                 }
+            }else{
+                ON_STATS (++stats.escaped_strings);
+                unescaped.clear ();
+                unescape_append (token.data, unescaped);
+                ON_STATS (count_string(unescaped.size()));
+                add_value (jvalue(unescaped));
             }
-            catch (...) {
-                error (jparser::err::invalid_string, token.row, token.col);
-            }
-            break;
-
-        case jtoken::tk_number:
-            on_parsed_value (token, token_to_number(token));
-            break;
-
-        case jtoken::tk_identifier:
-            error (jparser::err::invalid_token, token.row, token.col);
-            break;
-
-        case jtoken::tk_comment:
-            // Ignore comments
-            break;
+        }
+        catch (...) {
+            error (jparser::err::invalid_string, token);
         }
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void parser_t::parse_elements_tokens (const jtoken& token)
+    void parser_t::on_string_part (const jtoken& token, bool first)
     {
-        if (token.type == jtoken::tk_separator) {
-            parse_state.push (ps_value);
+        if (first) {
+            parsed_string.clear ();
+            part_borrowed = borrowing  &&  !token.has_escapes;
+            if (part_borrowed) {
+                borrowed_part = token.data;
+                return;
+            }
         }
-        else if (token.type == jtoken::tk_rbrack) {
-            // Array done !
-            jvalue array_value = std::move (parse_values.top());
-            parse_values.pop ();
-
-            parse_state.pop (); // pop ps_elements
-            parse_state.pop (); // pop ps_array
-            on_parsed_value (token, std::move(array_value));
+        else if (part_borrowed) {
+            // More than one part, the string can't be borrowed
+            part_borrowed = false;
+            parsed_string.assign (borrowed_part);
+        }
+        try {
+            if (token.has_escapes) {
+                ON_STATS (++stats.escaped_strings);
+                unescape_append (token.data, parsed_string);
+            }else{
+                parsed_string.append (token.data);
+            }
         }
-        else {
-            error (jparser::err::expected_separator_or_right_bracket, token.row, token.col);
+        catch (...) {
+            error (jparser::err::invalid_string, token);
         }
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void parser_t::parse_array_tokens (const jtoken& token)
+    void parser_t::on_begin_array (const jtoken& token, build_frame_t& frame)
     {
-        if (token.type == jtoken::tk_rbrack) {
-            // Array done - empty array
-            parse_state.pop (); // pop ps_array
-            on_parsed_value (token, jvalue(j_array));
-        }else{
-            // Start collecting array values
-            parse_values.push (json_array());
-            parse_state.push (ps_elements);
-            parse_state.push (ps_value);
+        frame.first_value = parse_values.size ();
+        ON_STATS (stats.max_depth = std::max(stats.max_depth, (unsigned)frames.size()));
+    }
 
-            parse_value_tokens (token);
-        }
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void parser_t::on_end_array (const jtoken& token, build_frame_t& frame)
+    {
+        auto first = parse_values.begin() + frame.first_value;
+        json_array elements;
+        elements.reserve (parse_values.end() - first);
+        elements.insert (elements.end(),
+                         std::make_move_iterator(first),
+                         std::make_move_iterator(parse_values.end()));
+        parse_values.erase (first, parse_values.end());
+        add_value (jvalue(std::move(elements)));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void parser_t::on_begin_object (const jtoken& token, build_frame_t& frame)
+    {
+        frame.first_value = parse_values.size ();
+        frame.first_member = parse_members.size ();
+        frame.object = jvalue (j_object);
+        ON_STATS (stats.max_depth = std::max(stats.max_depth, (unsigned)frames.size()));
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void parser_t::on_object_member_name (const jtoken& token)
+    void parser_t::on_member_name (const jtoken& token, build_frame_t& frame)
     {
         try {
-            parse_pairs.top().name = unescape (token.data);
-            parse_pairs.top().has_name = true;
+            frame.name = member_name (token);
         }
         catch (...) {
-            error (jparser::err::invalid_string, token.row, token.col);
+            error (jparser::err::invalid_string, token);
             return;
         }
 
         // Check for duplicate name
         if (allow_duplicates == false) {
-            if (parse_objects.top().has(parse_pairs.top().name)) {
-                error (jparser::err::duplicate_obj_member,
-                       token.row,
-                       token.col);
-                return;
-            }
-        }
-
-        // Check object size limit
-        auto& obj = parse_objects.top().obj ();
-        if (max_object_size  &&  obj.size()+1 > max_object_size) {
-            error (jparser::err::max_obj_size_exceeded,
-                   token.row,
-                   token.col);
-            return;
+            if (frame.object.has(frame.name))
+                error (jparser::err::duplicate_obj_member, token);
         }
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void parser_t::parse_pair_tokens (const jtoken& token)
+    void parser_t::on_member_value (build_frame_t& frame)
     {
-        if (parse_pairs.top().has_name == false) {
-            // We haven't got a member name yet
-            if (token.type == jtoken::tk_string  ||  token.type == jtoken::tk_identifier) {
-
-                on_object_member_name (token);
-
-            }else{
-                if (strict==false && token.type == jtoken::tk_rcbrack) {
-                    // Object member list ended with a ','
-                    parse_state.pop (); // ps_pair
-                    parse_members_tokens (token);
-                }else{
-                    error (jparser::err::expected_obj_member_name, token.row, token.col);
-                }
-            }
-        }
-        else if (parse_pairs.top().has_colon == false) {
-            // We haven't got a colon yet
-            if (token.type == jtoken::tk_colon) {
-                parse_pairs.top().has_colon = true;
-                // We got a colon, now we expect a value
-                parse_values.push (json_array());
-                parse_state.push (ps_value);
-            }else{
-                error (jparser::err::expected_colon, token.row, token.col);
-            }
-        }
-        else {
-            // We have a key-value pair
-            auto& obj = parse_objects.top().obj ();
-            obj.emplace_back (std::move(parse_pairs.top().name),
-                              std::move(parse_values.top()[0]));
-            parse_values.pop ();
-            parse_state.pop (); // ps_pair
-
-            parse_members_tokens (token);
+        if (allow_duplicates) {
+            parse_members.emplace_back (std::move(frame.name),
+                                        std::move(parse_values.back()));
+        }else{
+            frame.object.obj().emplace_back (std::move(frame.name),
+                                             std::move(parse_values.back()));
         }
+        parse_values.pop_back ();
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void parser_t::parse_members_tokens (const jtoken& token)
+    void parser_t::on_end_object (const jtoken& token, build_frame_t& frame)
     {
-        if (token.type == jtoken::tk_separator) {
-            // Next object member
-            parse_pairs.top().reset ();
-            parse_state.push (ps_pair);
-        }
-        else if (token.type == jtoken::tk_rcbrack) {
-            // Object done !
-            parse_state.pop (); // pop ps_members
-            parse_state.pop (); // pop ps_object
-            on_parsed_value (token, std::move(parse_objects.top()));
-
-            parse_pairs.pop ();   // Done with current temporary object pair
-            parse_objects.pop (); // Done with the current object
-        }
-        else {
-            error (jparser::err::expected_separator_or_right_curly_bracket, token.row, token.col);
+        auto first = parse_members.begin() + frame.first_member;
+        if (first != parse_members.end()) {
+            frame.object.obj().append (std::make_move_iterator(first),
+                                       std::make_move_iterator(parse_members.end()));
+            parse_members.erase (first, parse_members.end());
         }
+        add_value (std::move(frame.object));
     }
 
 
     //--------------------------------------------------------------------------
+    // When streaming documents, a parsed document
+    // is moved out of the parser, and another is expected.
     //--------------------------------------------------------------------------
-    void parser_t::parse_object_tokens (const jtoken& token)
+    bool parser_t::on_document_done ()
     {
-        if (token.type == jtoken::tk_rcbrack) {
-            // An empty object
-            parse_state.pop (); // pop ps_object
-            on_parsed_value (token, jvalue(j_object));
-        }else{
-            // Start parsing a new object member
-            parse_objects.push (jvalue(j_object));
-            parse_pairs.push (obj_member_t());
-
-            parse_state.push (ps_members);
-            parse_state.push (ps_pair);
-
-            parse_pair_tokens (token);
-        }
+        if (stream_mode != stream_documents)
+            return false;
+        next_document ();
+        return true;
     }
 
 
     //--------------------------------------------------------------------------
+    // Move a parsed document out of the parser,
+    // and expect another one, when streaming documents.
     //--------------------------------------------------------------------------
-    jvalue parser_t::parse_tokens ()
+    void parser_t::next_document ()
     {
-        const jtoken* token;
+        streamed.emplace_back (std::move(parse_values.back()));
+        parse_values.pop_back ();
+        expect_value (projection_root.get());
+    }
 
-        parse_state.push (ps_value);
-        parse_values.push (json_array());
 
-        // Fetch the first token
-        //
-        do {
-            token = tokenizer.next_token ();
-            if (!token || token->type == jtoken::tk_invalid) {
-                if (!token) {
-                    error (jparser::err::eob, 0, 0);
-                }else if (token->err_code == jtoken::ok) {
-                    // Is this even possible ?
-                    error (jparser::err::eob, tokenizer.pos().first, tokenizer.pos().second);
-                }else{
-                    error (token_error_to_parser_error(token->err_code), token->row, token->col);
-                }
-                return jvalue (j_invalid);
-            }
-        }while (token->type == jtoken::tk_comment); // Ignore comments
+    //--------------------------------------------------------------------------
+    // Parse all tokens in the tokenizer buffer.
+    // If 'last_chunk' is false, a token that reaches the end
+    // of the buffer is not parsed since it may continue in
+    // the next chunk of input.
+    // Returns the buffer offset of the first unparsed byte.
+    //--------------------------------------------------------------------------
+    size_t parser_t::parse_tokens (bool last_chunk)
+    {
+#if UJSON_COLLECT_STATS
+        if (collecting)
+            return parse_tokens_with_stats (last_chunk);
+#endif
+        auto buffer_size = tokenizer.size ();
+
+        while (err_code == jparser::err::ok) {
+            auto token_start = tokenizer.offset ();
+            auto token = tokenizer.next_token ();
+            if (token == nullptr)
+                return buffer_size;
+            if (!last_chunk && tokenizer.offset() >= buffer_size)
+                return token_start;
+            if (token->type != jtoken::tk_comment) // Ignore comments
+                parse_token (*token);
+        }
+        return tokenizer.offset ();
+    }
 
-        // Process tokens
-        //
-        do {
-            bool token_consumed = true;
 
-#if (PARSE_DEBUG)
-            cerr << "Parse token " << jtoken_type_to_string(token->type) << endl;
-#endif
-            switch (parse_state.top()) {
-            case ps_value:
-                parse_value_tokens (*token);
-                break;
-            case ps_str_value:
-                token_consumed = parse_str_value_tokens (*token);
-                break;
-            case ps_array:
-                parse_array_tokens (*token);
-                break;
-            case ps_elements:
-                parse_elements_tokens (*token);
-                break;
-            case ps_object:
-                parse_object_tokens (*token);
-                break;
-            case ps_members:
-                parse_members_tokens (*token);
+#if UJSON_COLLECT_STATS
+    //--------------------------------------------------------------------------
+    // Same as parse_tokens(), but also counts the tokens and
+    // the parsed bytes, and measures the time spent in the
+    // tokenizer and the parser.
+    //--------------------------------------------------------------------------
+    size_t parser_t::parse_tokens_with_stats (bool last_chunk)
+    {
+        using clock = std::chrono::steady_clock;
+        auto buffer_size = tokenizer.size ();
+        auto unparsed = buffer_size;
+
+        while (err_code == jparser::err::ok) {
+            auto token_start = tokenizer.offset ();
+            auto t0 = clock::now ();
+            auto token = tokenizer.next_token ();
+            auto t1 = clock::now ();
+            stats.tokenize_time += t1 - t0;
+            if (token == nullptr)
                 break;
-            case ps_pair:
-                parse_pair_tokens (*token);
+            if (!last_chunk && tokenizer.offset() >= buffer_size) {
+                unparsed = token_start;
                 break;
             }
-
-            if (token_consumed) {
-                do {
-                    token = tokenizer.next_token ();
-                }while (token && token->type == jtoken::tk_comment);
+            ++stats.tokens[token->type];
+            if (token->type != jtoken::tk_comment) { // Ignore comments
+                parse_token (*token);
+                stats.build_time += clock::now() - t1;
             }
-        }while (err_code == jparser::err::ok   &&
-                token != nullptr               &&
-                token->err_code == jtoken::ok  &&
-                parse_state.empty() == false);
-
-        return post_parse_tokens (token);
+        }
+        if (err_code != jparser::err::ok)
+            unparsed = tokenizer.offset ();
+        stats.bytes += unparsed;
+        return unparsed;
     }
 
 
     //--------------------------------------------------------------------------
+    // Update the statistics with a parsed value.
     //--------------------------------------------------------------------------
-    jvalue parser_t::post_parse_tokens (const jtoken* token)
+    void parser_t::count_value (const jvalue& value)
     {
-        jvalue value (j_invalid);
-
-        if (!parse_state.empty()  && parse_state.top()==ps_str_value) {
-            // We were parsing a string in relaxed mode, finish it
-            jtoken dummy_token;
-            parse_str_value_tokens (dummy_token);
+        if (value.type() == j_array) {
+            stats.max_array_size = std::max (stats.max_array_size, value.size());
+            stats.allocations += value.size() ? 2 : 1;
+        }
+        else if (value.type() == j_object) {
+            stats.max_object_size = std::max (stats.max_object_size, value.size());
+            stats.allocations += value.size() ? 2 : 1;
         }
+    }
 
-#if (PARSE_DEBUG)
-        if (token)
-            cerr << "Parse ended when tokens left. Next token: " << jtoken_type_to_string(token->type) << endl;
-        else
-            cerr << "No more tokens to parse" << endl;
-        dump_parse_stack_sizes ();
+
+    //--------------------------------------------------------------------------
+    // Add the statistics of a worker parser in parse_parallel().
+    //--------------------------------------------------------------------------
+    void parser_t::merge_stats (const jstats& s)
+    {
+        stats.bytes += s.bytes;
+        for (size_t i=0; i<stats.tokens.size(); ++i)
+            stats.tokens[i] += s.tokens[i];
+        stats.max_depth = std::max (stats.max_depth, s.max_depth);
+        stats.max_array_size = std::max (stats.max_array_size, s.max_array_size);
+        stats.max_object_size = std::max (stats.max_object_size, s.max_object_size);
+        stats.escaped_strings += s.escaped_strings;
+        stats.mpf_numbers += s.mpf_numbers;
+        stats.allocations += s.allocations;
+        stats.tokenize_time += s.tokenize_time;
+        stats.build_time += s.build_time;
+    }
 #endif
 
-        if (err_code != jparser::err::ok) {
-            //
-            // Syntax error while parsing
-            //
-        }
-        else if (token != nullptr) {
-            //
-            // Unexpected token(s) after successully parsing a JSON instance
-            //
-            error (jparser::err::unexpected_character, token->row, token->col );
-        }
-        else if (parse_state.empty() == false) {
-            //
-            // Parse state stack not empty
-            //
-            switch (parse_state.top()) {
-            case ps_array:
-            case ps_elements:
-                // We have an unterminated array
-                error (jparser::err::unterminated_array, row, col);
-                break;
 
-            case ps_object:
-            case ps_members:
-            case ps_pair:
-                // We have an unterminated object
-                error (jparser::err::unterminated_object, row, col);
-                break;
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue parser_t::post_parse_tokens ()
+    {
+        jvalue value (j_invalid);
+
+        finish_tokens (tokenizer.offset());
 
-            default:
 #if (PARSE_DEBUG)
-                cerr << "Internal error here: " << __LINE__ << endl;
+        dump_parse_stack_sizes ();
 #endif
-                error (jparser::err::internal, row, col);
-            }
-        }
 
         if (err_code == jparser::err::ok) {
-            value = std::move (parse_values.top().back());
-            parse_values.top().pop_back ();
-            parse_values.pop ();
+            value = std::move (parse_values.back());
+            parse_values.pop_back ();
 
-            if (parse_values.empty()==false) {
+            if (parse_values.empty()==false || frames.empty()==false) {
 #if (PARSE_DEBUG)
                 cerr << "Internal error here: " << __LINE__ << endl;
 #endif
@@ -912,53 +985,914 @@ pair:           STRING COLON value
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue parser_t::parse (const char* buffer,
-                            const unsigned buffer_size,
+                            const size_t buffer_size,
                             bool strict_parsing,
                             bool allow_duplicates_in_obj)
     {
-        strict = strict_parsing;
-        allow_duplicates = allow_duplicates_in_obj;
-        reset ();
-        tokenizer.reset (std::string_view(buffer, buffer_size), strict);
+        begin (strict_parsing, allow_duplicates_in_obj);
+        borrowing = strings_as_views;
+
+        if (num_threads != 1  &&  buffer_size >= parallel_min_size  &&  !projection_root) {
+            jvalue instance;
+            if (parse_parallel(buffer, buffer_size, instance)) {
+                in_progress = false;
+                return instance;
+            }
+            // Speculation failed, the serial parser reports any errors
+        }
 
-        return parse_tokens ();
+        tokenizer.reset (std::string_view(buffer, buffer_size), strict, false);
+
+        parse_tokens (true);
+        auto instance = post_parse_tokens ();
+        resolve_error_pos ();
+        in_progress = false;
+        return instance;
     }
 
 
     //--------------------------------------------------------------------------
+    // Calculate the row and column of the error from
+    // the buffer offset while the buffer is still valid.
     //--------------------------------------------------------------------------
-    jvalue parser_t::parse (const std::string& buffer,
-                            bool strict_parsing,
-                            bool allow_duplicates_in_obj)
+    void parser_t::resolve_error_pos ()
     {
-        return parse (buffer.c_str(),
-                      buffer.size(),
-                      strict_parsing,
-                      allow_duplicates_in_obj);
+        if (err_code!=jparser::err::ok && err_at_offset) {
+            auto pos = tokenizer.pos (err_offset);
+            err_row = base_row + pos.first;
+            err_col = pos.first ? pos.second : base_col + pos.second;
+            err_at_offset = false;
+        }
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue parser_t::parse_file (const std::string& file_name,
-                                 bool strict_parsing,
-                                 bool allow_duplicates_in_obj)
+    void parser_t::begin (bool strict_parsing, bool allow_duplicates_in_obj)
     {
-        std::ifstream in (file_name);
-        if (!in.good()) {
-            error (jparser::err::io, 0, 0);
-            return jvalue (j_invalid);
+        strict = strict_parsing;
+        allow_duplicates = allow_duplicates_in_obj;
+        reset ();
+        in_progress = true;
+        expect_value (projection_root.get());
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool parser_t::feed (const char* buffer, const size_t buffer_size)
+    {
+        if (!in_progress) {
+            reset_stats ();
+            begin (true, true);
+        }
+        if (err_code != jparser::err::ok)
+            return false;
+
+        // Parse directly from the input buffer unless
+        // we have unparsed data from the previous chunk.
+        if (!pending.empty()) {
+            pending.append (buffer, buffer_size);
+            tokenizer.reset (pending, strict, false);
+        }else{
+            tokenizer.reset (std::string_view(buffer, buffer_size), strict, false);
+        }
+
+        auto unparsed = parse_tokens (false);
+        if (err_code != jparser::err::ok) {
+            resolve_error_pos ();
+            pending.clear ();
+            return false;
+        }
+
+        // Update the document position of the unparsed data
+        auto pos = tokenizer.pos (unparsed);
+        if (pos.first) {
+            base_row += pos.first;
+            base_col = pos.second;
+        }else{
+            base_col += pos.second;
+        }
+
+        if (!pending.empty())
+            pending.erase (0, unparsed);
+        else
+            pending.assign (buffer + unparsed, buffer_size - unparsed);
+
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue parser_t::finish ()
+    {
+        if (!in_progress) {
+            reset_stats ();
+            begin (true, true);
+        }
+
+        if (err_code == jparser::err::ok) {
+            tokenizer.reset (pending, strict, false);
+            parse_tokens (true);
+        }
+        auto instance = post_parse_tokens ();
+        resolve_error_pos ();
+
+        in_progress = false;
+        pending.clear ();
+        return instance;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void parser_t::begin_stream (jparser::stream_t what,
+                                 bool strict_parsing,
+                                 bool allow_duplicates_in_obj)
+    {
+        begin (strict_parsing, allow_duplicates_in_obj);
+        if (what == jparser::stream_t::items)
+            stream_mode = stream_items;
+        else
+            stream_mode = stream_documents;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool parser_t::next_value (jvalue& value)
+    {
+        if (streamed.empty())
+            return false;
+        value = std::move (streamed.front());
+        streamed.pop_front ();
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Parse the remaining input of a stream. A top level array has
+    // already been streamed, any other top level value is streamed
+    // now. A stream of documents may end between documents.
+    //--------------------------------------------------------------------------
+    bool parser_t::finish_stream ()
+    {
+        if (!in_progress  ||  stream_mode == stream_none)
+            return err_code == jparser::err::ok;
+
+        if (err_code == jparser::err::ok) {
+            tokenizer.reset (pending, strict, false);
+            parse_tokens (true);
+        }
+        pending.clear ();
+        in_progress = false;
+
+        if (err_code == jparser::err::ok  &&  stream_mode == stream_documents  &&
+            (first_token  ||  (parse_state.size() == 1  &&
+                               parse_state.back() == ps_value  &&
+                               parse_values.empty())))
+        {
+            // No document, or nothing after the last document
+            return true;
         }
-        std::string json_doc ((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-        in.close ();
 
-        return parse (json_doc.c_str(),
-                      json_doc.size(),
+        bool top_array = !frames.empty() ||
+            (!parse_values.empty() && parse_values.front().type() == j_array);
+        auto instance = post_parse_tokens ();
+        resolve_error_pos ();
+        if (err_code != jparser::err::ok)
+            return false;
+        if (stream_mode == stream_documents  ||  !top_array)
+            streamed.emplace_back (std::move(instance));
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue parser_t::parse (const std::string& buffer,
+                            bool strict_parsing,
+                            bool allow_duplicates_in_obj)
+    {
+        return parse (buffer.c_str(),
+                      buffer.size(),
                       strict_parsing,
                       allow_duplicates_in_obj);
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue parser_t::parse_file (const std::string& file_name,
+                                 bool strict_parsing,
+                                 bool allow_duplicates_in_obj)
+    {
+        auto in = std::make_unique<file_view> (file_name);
+        if (!in.get()->good()) {
+            error (jparser::err::io, 0, 0);
+            return jvalue (j_invalid);
+        }
+        auto data = in.get()->data ();
+        if (detect_compression(data.data(), data.size()) != compression_t::none) {
+            // Decompress on a separate thread while parsing
+            in.reset ();
+            borrowed_file.reset ();
+            jdecompressor decompressor (file_name);
+            return parse_input (decompressor, strict_parsing, allow_duplicates_in_obj);
+        }
+        auto instance = parse (in.get()->data().data(),
+                               in.get()->data().size(),
+                               strict_parsing,
+                               allow_duplicates_in_obj);
+        // Borrowed strings refer to the file content
+        if (strings_as_views)
+            borrowed_file = std::move (in);
+        return instance;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Parse input incrementally, chunk by chunk, as it is decompressed.
+    //--------------------------------------------------------------------------
+    jvalue parser_t::parse_input (jdecompressor& in,
+                                  bool strict_parsing,
+                                  bool allow_duplicates_in_obj)
+    {
+        begin (strict_parsing, allow_duplicates_in_obj);
+        const char* data;
+        size_t size;
+        while (in.next(data, size)) {
+            if (!feed(data, size))
+                break;
+        }
+        if (err_code == jparser::err::ok  &&  !in.error().empty()) {
+            in_progress = false;
+            pending.clear ();
+            error (jparser::err::io, 0, 0);
+            return jvalue (j_invalid);
+        }
+        return finish ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void parser_t::begin_lines (const char* buffer,
+                                const size_t buffer_size,
+                                bool strict_parsing,
+                                bool allow_duplicates_in_obj,
+                                unsigned first_line)
+    {
+        strict = strict_parsing;
+        allow_duplicates = allow_duplicates_in_obj;
+        reset ();
+        lines_file.reset ();
+        lines_pos = buffer;
+        lines_end = buffer + buffer_size;
+        lines_row = first_line;
+        line_num = first_line;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool parser_t::begin_lines_file (const std::string& file_name,
+                                     bool strict_parsing,
+                                     bool allow_duplicates_in_obj)
+    {
+        auto in = std::make_unique<file_view> (file_name, true, true);
+        if (!in.get()->good()) {
+            begin_lines (nullptr, 0, strict_parsing, allow_duplicates_in_obj);
+            error (jparser::err::io, 0, 0);
+            return false;
+        }
+        auto data = in.get()->data ();
+        begin_lines (data.data(), data.size(), strict_parsing, allow_duplicates_in_obj);
+        lines_file = std::move (in);
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Lines with only whitespace are skipped.
+    //--------------------------------------------------------------------------
+    bool parser_t::next_line (jvalue& value)
+    {
+        while (lines_pos < lines_end) {
+            auto nl = reinterpret_cast<const char*> (memchr(lines_pos, '\n', lines_end - lines_pos));
+            const char* eol  = nl ? nl : lines_end;
+            const char* line_start = lines_pos;
+            unsigned row_num = lines_row++;
+            lines_pos = nl ? nl + 1 : lines_end;
+
+            std::string_view line (line_start, eol - line_start);
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos)
+                continue;
+
+            // Parse the line
+            begin (strict, allow_duplicates);
+            line_num = row_num;
+            row = base_row = row_num;
+            tokenizer.reset (line, strict, false);
+            parse_tokens (true);
+            value = post_parse_tokens ();
+            resolve_error_pos ();
+            in_progress = false;
+            return true;
+        }
+
+        // No more lines
+        lines_file.reset ();
+        lines_pos = lines_end = nullptr;
+        return false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // A parsed line, and a chunk of lines, used when parsing lines in parallel.
+    //--------------------------------------------------------------------------
+    struct line_result_t {
+        unsigned line;
+        jvalue value;
+        jparser::error_t err;
+    };
+    struct lines_chunk_t {
+        const char* begin;
+        const char* end;
+        unsigned first_line;
+        bool done;
+        std::deque<line_result_t> results;
+    };
+
+
+    //--------------------------------------------------------------------------
+    // The buffer is split at line breaks in chunks that are parsed by
+    // worker threads, each using its own parser_t instance. The parsed
+    // chunks are then handed to the handler in the calling thread.
+    // At most 'window' chunks are parsed or waiting to be handled at
+    // any time, so the workers can't run ahead of a slow handler.
+    //--------------------------------------------------------------------------
+    bool parser_t::parse_lines (const char* buffer,
+                                const size_t buffer_size,
+                                jparser::line_handler_t& handler,
+                                bool strict_parsing,
+                                bool allow_duplicates_in_obj,
+                                unsigned num_threads,
+                                bool ordered)
+    {
+        static constexpr size_t min_chunk_size = 16 * 1024;
+        static constexpr size_t max_chunk_size = 256 * 1024;
+
+        reset ();
+
+        if (num_threads == 0)
+            num_threads = std::max (std::thread::hardware_concurrency(), 1u);
+
+        // Split the buffer in chunks
+        //
+        std::vector<lines_chunk_t> chunks;
+        size_t chunk_size = std::clamp (buffer_size / (num_threads * 8),
+                                        min_chunk_size,
+                                        max_chunk_size);
+        const char* end = buffer + buffer_size;
+        for (const char* pos=buffer; pos<end;) {
+            const char* chunk_end = end;
+            if ((size_t)(end - pos) > chunk_size) {
+                auto nl = reinterpret_cast<const char*> (memchr(pos+chunk_size, '\n', end-pos-chunk_size));
+                if (nl)
+                    chunk_end = nl + 1;
+            }
+            chunks.push_back ({pos, chunk_end, 0, false, {}});
+            pos = chunk_end;
+        }
+        if (chunks.empty())
+            return true;
+        num_threads = std::min (num_threads, (unsigned)chunks.size());
+
+        std::mutex m;
+        std::condition_variable cv_work;
+        std::condition_variable cv_done;
+        std::deque<size_t> done_chunks;
+        std::exception_ptr worker_error;
+        std::vector<std::thread> workers;
+        size_t next_chunk = 0;
+        size_t delivered = 0;
+        size_t window = num_threads * 2;
+        bool stop = false;
+
+        auto run_workers = [&workers, num_threads] (auto&& work) {
+            for (unsigned i=0; i<num_threads; ++i)
+                workers.emplace_back (work);
+            for (auto& worker : workers)
+                worker.join ();
+            workers.clear ();
+        };
+
+        // Count the lines in each chunk to get
+        // the line number of the first line
+        //
+        run_workers ([&] () {
+                while (true) {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> lock (m);
+                        if (next_chunk >= chunks.size())
+                            return;
+                        i = next_chunk++;
+                    }
+                    chunks[i].first_line = std::count (chunks[i].begin, chunks[i].end, '\n');
+                }
+            });
+        unsigned line = 0;
+        for (auto& chunk : chunks) {
+            auto lines_in_chunk = chunk.first_line;
+            chunk.first_line = line;
+            line += lines_in_chunk;
+        }
+        next_chunk = 0;
+
+        // Parse the chunks
+        //
+        // Values parsed by the workers use the same arena as the calling thread
+        auto* arena = jarena::current ();
+        auto parse_chunks = [&] () {
+            std::optional<jarena::scope> use_arena;
+            if (arena)
+                use_arena.emplace (*arena);
+            parser_t parser;
+            parser.limits (max_depth, max_array_size, max_object_size);
+            parser.lazy_numbers (numbers_as_text);
+            parser.projection (projection_root);
+            try {
+                while (true) {
+                    size_t i;
+                    {
+                        std::unique_lock<std::mutex> lock (m);
+                        cv_work.wait (lock, [&] {
+                                return stop  ||
+                                    next_chunk >= chunks.size()  ||
+                                    next_chunk < delivered + window;
+                            });
+                        if (stop || next_chunk >= chunks.size())
+                            return;
+                        i = next_chunk++;
+                    }
+                    auto& chunk = chunks[i];
+                    parser.begin_lines (chunk.begin, chunk.end - chunk.begin,
+                                        strict_parsing, allow_duplicates_in_obj,
+                                        chunk.first_line);
+                    jvalue value;
+                    while (parser.next_line(value)) {
+                        chunk.results.push_back ({parser.line(),
+                                                  std::move(value),
+                                                  {parser.error_code(), parser.error_row(), parser.error_col()}});
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock (m);
+                        chunk.done = true;
+                        done_chunks.push_back (i);
+                    }
+                    cv_done.notify_one ();
+                }
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock (m);
+                if (!worker_error)
+                    worker_error = std::current_exception ();
+                stop = true;
+                cv_done.notify_one ();
+                cv_work.notify_all ();
+            }
+        };
+
+        auto deliver_chunks = [&] () {
+            size_t next_ordered = 0;
+            while (delivered < chunks.size()) {
+                size_t i;
+                {
+                    std::unique_lock<std::mutex> lock (m);
+                    cv_done.wait (lock, [&] {
+                            return stop  ||  (ordered ?
+                                              chunks[next_ordered].done :
+                                              !done_chunks.empty());
+                        });
+                    if (stop)
+                        return;
+                    if (ordered) {
+                        i = next_ordered++;
+                    }else{
+                        i = done_chunks.front ();
+                        done_chunks.pop_front ();
+                    }
+                }
+
+                bool proceed = true;
+                for (auto& result : chunks[i].results) {
+                    if (result.err.code != jparser::err::ok  &&  err_code == jparser::err::ok)
+                        error (result.err.code, result.err.row, result.err.col);
+                    if (!handler(result.line, result.value, result.err)) {
+                        error (jparser::err::aborted, result.line, 0);
+                        proceed = false;
+                        break;
+                    }
+                }
+                std::deque<line_result_t>().swap (chunks[i].results);
+
+                {
+                    std::lock_guard<std::mutex> lock (m);
+                    ++delivered;
+                    if (!proceed)
+                        stop = true;
+                }
+                cv_work.notify_all ();
+                if (!proceed)
+                    return;
+            }
+        };
+
+        auto stop_workers = [&] () {
+            {
+                std::lock_guard<std::mutex> lock (m);
+                stop = true;
+            }
+            cv_work.notify_all ();
+            for (auto& worker : workers)
+                worker.join ();
+        };
+
+        for (unsigned i=0; i<num_threads; ++i)
+            workers.emplace_back (parse_chunks);
+        try {
+            deliver_chunks ();
+        }
+        catch (...) {
+            stop_workers ();
+            throw;
+        }
+        stop_workers ();
+
+        if (worker_error)
+            std::rethrow_exception (worker_error);
+
+        return err_code == jparser::err::ok;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool parser_t::parse_lines_file (const std::string& file_name,
+                                     jparser::line_handler_t& handler,
+                                     bool strict_parsing,
+                                     bool allow_duplicates_in_obj,
+                                     unsigned num_threads,
+                                     bool ordered)
+    {
+        file_view in (file_name, true, true);
+        if (!in.good()) {
+            reset ();
+            error (jparser::err::io, 0, 0);
+            return false;
+        }
+        return parse_lines (in.data().data(), in.data().size(), handler,
+                            strict_parsing, allow_duplicates_in_obj,
+                            num_threads, ordered);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Skip whitespaces, and comments in relaxed mode, the same way as
+    // the tokenizer. Returns nullptr on an unterminated comment.
+    //--------------------------------------------------------------------------
+    static const char* skip_comment (const char* pos, const char* end)
+    {
+        if (pos[1] == '/') {
+            auto nl = reinterpret_cast<const char*> (memchr(pos+2, '\n', end-pos-2));
+            return nl ? nl : end;
+        }
+        // Multi line comment, note that the tokenizer
+        // doesn't find the end of the comment in "**/".
+        for (pos+=2; pos<end; ++pos) {
+            if (*pos == '*') {
+                if (++pos == end)
+                    break;
+                if (*pos == '/')
+                    return pos + 1;
+            }
+        }
+        return nullptr;
+    }
+    static const char* skip_whitespace (const char* pos, const char* end, bool strict)
+    {
+        while (pos && pos < end) {
+            switch (*pos) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                ++pos;
+                break;
+            case '/':
+                if (strict || pos+1 == end || (pos[1]!='/' && pos[1]!='*'))
+                    return pos;
+                pos = skip_comment (pos, end);
+                break;
+            default:
+                return pos;
+            }
+        }
+        return pos;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Find the elements of a top level array, or the members of a top
+    // level object, without validating them. Each span in 'spans' is
+    // the text between two separators at nesting level 1.
+    // Returns false if the buffer doesn't look like an array or object
+    // with at least two elements.
+    //--------------------------------------------------------------------------
+    using span_t = std::pair<const char*, const char*>;
+    static bool find_top_level_spans (const char* buffer,
+                                      const size_t buffer_size,
+                                      bool strict,
+                                      bool& is_object,
+                                      std::vector<span_t>& spans)
+    {
+        const char* end = buffer + buffer_size;
+        const char* pos = skip_whitespace (buffer, end, strict);
+        if (pos == nullptr || pos == end || (*pos != '[' && *pos != '{'))
+            return false;
+        is_object = *pos++ == '{';
+
+        const char* span_begin = pos;
+        unsigned depth = 1;
+        while (pos < end) {
+            switch (*pos) {
+            case '"':
+                // Skip the string, a quote preceded by
+                // an odd number of backslashes is escaped
+                for (const char* str_begin=++pos; ;) {
+                    auto quote = reinterpret_cast<const char*> (memchr(pos, '"', end-pos));
+                    if (quote == nullptr)
+                        return false;
+                    const char* bs = quote;
+                    while (bs > str_begin && bs[-1] == '\\')
+                        --bs;
+                    pos = quote + 1;
+                    if ((quote - bs) % 2 == 0)
+                        break;
+                }
+                break;
+
+            case '[':
+            case '{':
+                ++depth;
+                ++pos;
+                break;
+
+            case ']':
+            case '}':
+                if (--depth == 0) {
+                    if ((*pos == '}') != is_object)
+                        return false;
+                    if (skip_whitespace(span_begin, pos, strict) == pos) {
+                        // Empty container, or a trailing ','
+                        if (spans.empty() || strict)
+                            return false;
+                    }else{
+                        spans.emplace_back (span_begin, pos);
+                    }
+                    // Only whitespaces and comments may follow
+                    return skip_whitespace(pos+1, end, strict) == end && spans.size() > 1;
+                }
+                ++pos;
+                break;
+
+            case ',':
+                if (depth == 1) {
+                    spans.emplace_back (span_begin, pos);
+                    span_begin = pos + 1;
+                }
+                ++pos;
+                break;
+
+            case '/':
+                if (!strict && pos+1 < end && (pos[1]=='/' || pos[1]=='*')) {
+                    pos = skip_comment (pos, end);
+                    if (pos == nullptr)
+                        return false;
+                }else{
+                    ++pos;
+                }
+                break;
+
+            default:
+                ++pos;
+                break;
+            }
+        }
+        return false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Parse an object member "name : value" found by find_top_level_spans().
+    //--------------------------------------------------------------------------
+    static bool parse_object_member (parser_t& parser,
+                                     const span_t& span,
+                                     bool strict,
+                                     bool allow_duplicates,
+                                     json_key& name,
+                                     jvalue& value)
+    {
+        jtokenizer tokenizer (std::string_view(span.first, span.second-span.first), strict, false);
+        const jtoken* token;
+#if UJSON_COLLECT_STATS
+        auto count_tokens = [&parser] (const jtoken* t) {
+            if (parser.collecting && t)
+                ++parser.stats.tokens[t->type];
+            return t;
+        };
+#else
+        auto count_tokens = [] (const jtoken* t) {return t;};
+#endif
+
+        while ((token=count_tokens(tokenizer.next_token())) && token->type == jtoken::tk_comment)
+            ;
+        if (token == nullptr ||
+            (token->type != jtoken::tk_string && token->type != jtoken::tk_identifier))
+        {
+            return false;
+        }
+        try {
+            name = parser.member_name (*token);
+        }
+        catch (...) {
+            return false;
+        }
+
+        while ((token=count_tokens(tokenizer.next_token())) && token->type == jtoken::tk_comment)
+            ;
+        if (token == nullptr || token->type != jtoken::tk_colon)
+            return false;
+
+        auto offset = tokenizer.offset ();
+        value = parser.parse (span.first + offset,
+                              span.second - span.first - offset,
+                              strict,
+                              allow_duplicates);
+        return value.valid ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Speculative parallel parsing of a single document. The elements
+    // of a top level array, or the members of a top level object, are
+    // located by a quick scan of the buffer and then parsed by worker
+    // threads. If anything looks wrong, false is returned and the
+    // caller parses the document serially instead, so errors are
+    // always reported by the serial parser.
+    //--------------------------------------------------------------------------
+    bool parser_t::parse_parallel (const char* buffer,
+                                   const size_t buffer_size,
+                                   jvalue& instance)
+    {
+        unsigned workers = num_threads;
+        if (workers == 0)
+            workers = std::thread::hardware_concurrency ();
+        if (workers < 2 || max_depth == 1)
+            return false;
+
+        bool is_object;
+        std::vector<span_t> spans;
+#if UJSON_COLLECT_STATS
+        auto scan_start = std::chrono::steady_clock::now ();
+#endif
+        if (!find_top_level_spans(buffer, buffer_size, strict, is_object, spans))
+            return false;
+#if UJSON_COLLECT_STATS
+        auto scan_time = std::chrono::steady_clock::now() - scan_start;
+#endif
+
+        auto max_size = is_object ? max_object_size : max_array_size;
+        if (max_size && spans.size() > max_size)
+            return false;
+
+        // Group the spans in batches of roughly equal size
+        //
+        std::vector<size_t> batches; // Index of the first span in each batch
+        size_t batch_size = std::max (buffer_size / (workers * 8), (size_t)16*1024);
+        for (size_t i=0; i<spans.size(); ) {
+            batches.push_back (i);
+            const char* batch_end = spans[i].first + batch_size;
+            while (++i < spans.size() && spans[i].second <= batch_end)
+                ;
+        }
+        batches.push_back (spans.size());
+        workers = std::min (workers, (unsigned)batches.size()-1);
+        if (workers < 2)
+            return false;
+
+        std::vector<jvalue> values (spans.size());
+        std::vector<json_key> names (is_object ? spans.size() : 0);
+        std::atomic<size_t> next_batch (0);
+        std::atomic<bool> failed (false);
+#if UJSON_COLLECT_STATS
+        std::vector<jstats> worker_stats (workers);
+#endif
+
+        auto* arena = jarena::current ();
+        auto worker = [&] (unsigned n) {
+            std::optional<jarena::scope> use_arena;
+            if (arena)
+                use_arena.emplace (*arena);
+            try {
+                parser_t parser;
+                parser.limits (max_depth ? max_depth-1 : 0, max_array_size, max_object_size);
+                parser.lazy_numbers (numbers_as_text);
+                parser.borrow_strings (strings_as_views);
+#if UJSON_COLLECT_STATS
+                parser.collecting = collecting;
+#endif
+                size_t batch;
+                while (!failed && (batch=next_batch++) < batches.size()-1) {
+                    for (auto i=batches[batch]; i<batches[batch+1]; ++i) {
+                        bool ok;
+                        if (is_object) {
+                            ok = parse_object_member (parser, spans[i], strict,
+                                                      allow_duplicates, names[i], values[i]);
+                        }else{
+                            values[i] = parser.parse (spans[i].first,
+                                                      spans[i].second - spans[i].first,
+                                                      strict,
+                                                      allow_duplicates);
+                            ok = values[i].valid ();
+                        }
+                        if (!ok) {
+                            failed = true;
+                            break;
+                        }
+                    }
+                }
+#if UJSON_COLLECT_STATS
+                worker_stats[n] = parser.stats;
+#endif
+            }
+            catch (...) {
+                // Let the serial parser deal with it
+                failed = true;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i=1; i<workers; ++i)
+            threads.emplace_back (worker, i);
+        worker (0);
+        for (auto& t : threads)
+            t.join ();
+
+        if (failed)
+            return false;
+
+        // Stitch together the parsed elements
+        //
+        if (is_object) {
+            instance = jvalue (j_object);
+            auto& obj = instance.obj ();
+            for (size_t i=0; i<spans.size(); ++i) {
+                if (!allow_duplicates && instance.has(names[i]))
+                    return false;
+                obj.emplace_back (std::move(names[i]), std::move(values[i]));
+            }
+        }else{
+            instance = jvalue (j_array);
+            instance.array() = std::move (values);
+        }
+
+        // Add the statistics of the workers, and of the
+        // top level array or object parsed by this thread
+#if UJSON_COLLECT_STATS
+        if (collecting) {
+            for (auto& s : worker_stats)
+                merge_stats (s);
+            stats.bytes = buffer_size;
+            stats.max_depth += 1;
+            stats.tokens[is_object ? jtoken::tk_lcbrack : jtoken::tk_lbrack] += 1;
+            stats.tokens[is_object ? jtoken::tk_rcbrack : jtoken::tk_rbrack] += 1;
+            stats.tokens[jtoken::tk_separator] += spans.size() - 1;
+            if (is_object)
+                stats.max_object_size = std::max (stats.max_object_size, spans.size());
+            else
+                stats.max_array_size = std::max (stats.max_array_size, spans.size());
+            stats.allocations += 2;
+            stats.tokenize_time += scan_time;
+        }
+#endif
+        return true;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jparser::jparser ()
@@ -992,29 +1926,88 @@ pair:           STRING COLON value
                           unsigned max_array_size,
                           unsigned max_object_size)
     {
-        std::lock_guard<std::mutex> lock (CTX->mutex);
+        context_lock lock (*CTX);
         CTX->limits (max_depth, max_array_size, max_object_size);
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::threads (unsigned num_threads, size_t min_size)
+    {
+        context_lock lock (*CTX);
+        CTX->threads (num_threads, min_size);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::lazy_numbers (bool enable)
+    {
+        context_lock lock (*CTX);
+        CTX->lazy_numbers (enable);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::borrow_strings (bool enable)
+    {
+        context_lock lock (*CTX);
+        CTX->borrow_strings (enable);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::projection (const std::vector<std::string>& patterns)
+    {
+        std::shared_ptr<projection_node_t> root;
+        if (!patterns.empty()) {
+            root = std::make_shared<projection_node_t> ();
+            for (auto& pattern : patterns) {
+                jpointer pointer (pattern);
+                root->add (pointer.begin(), pointer.end());
+            }
+        }
+        context_lock lock (*CTX);
+        CTX->projection (root);
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue jparser::parse_file (const std::string& f,
                                 bool strict_mode,
                                 bool allow_duplicates_in_obj)
     {
-        std::lock_guard<std::mutex> lock (CTX->mutex);
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
         return CTX->parse_file (f, strict_mode, allow_duplicates_in_obj);
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jparser::parse_fd (int fd,
+                              bool strict_mode,
+                              bool allow_duplicates_in_obj)
+    {
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
+        jdecompressor in (fd);
+        return CTX->parse_input (in, strict_mode, allow_duplicates_in_obj);
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue jparser::parse_string (const std::string& str,
                                   bool strict_mode,
                                   bool allow_duplicates_in_obj)
     {
-        std::lock_guard<std::mutex> lock (CTX->mutex);
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
         return CTX->parse (str, strict_mode, allow_duplicates_in_obj);
     }
 
@@ -1026,16 +2019,187 @@ pair:           STRING COLON value
                                   bool strict_mode,
                                   bool allow_duplicates_in_obj)
     {
-        std::lock_guard<std::mutex> lock (CTX->mutex);
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
         return CTX->parse (buf, length, strict_mode, allow_duplicates_in_obj);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    const jparser::error_t jparser::get_error () const
+    void jparser::begin (bool strict_mode, bool allow_duplicates_in_obj)
+    {
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
+        CTX->begin (strict_mode, allow_duplicates_in_obj);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::feed (const char* buf, size_t length)
+    {
+        context_lock lock (*CTX);
+        return CTX->feed (buf, length);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jparser::finish ()
+    {
+        context_lock lock (*CTX);
+        return CTX->finish ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::begin_lines (const char* buf,
+                               size_t length,
+                               bool strict_mode,
+                               bool allow_duplicates_in_obj)
+    {
+        context_lock lock (*CTX);
+        CTX->begin_lines (buf, length, strict_mode, allow_duplicates_in_obj);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::begin_lines_file (const std::string& f,
+                                    bool strict_mode,
+                                    bool allow_duplicates_in_obj)
+    {
+        context_lock lock (*CTX);
+        return CTX->begin_lines_file (f, strict_mode, allow_duplicates_in_obj);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::next_line (jvalue& value)
+    {
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
+        return CTX->next_line (value);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::parse_lines (const char* buf,
+                               size_t length,
+                               line_handler_t handler,
+                               bool strict_mode,
+                               bool allow_duplicates_in_obj,
+                               unsigned num_threads,
+                               bool ordered)
+    {
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
+        return CTX->parse_lines (buf, length, handler,
+                                 strict_mode, allow_duplicates_in_obj,
+                                 num_threads, ordered);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::parse_lines_file (const std::string& f,
+                                    line_handler_t handler,
+                                    bool strict_mode,
+                                    bool allow_duplicates_in_obj,
+                                    unsigned num_threads,
+                                    bool ordered)
+    {
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
+        return CTX->parse_lines_file (f, handler,
+                                      strict_mode, allow_duplicates_in_obj,
+                                      num_threads, ordered);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    unsigned jparser::line () const
+    {
+        context_lock lock (*CTX);
+        return CTX->line ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::begin_stream (stream_t what,
+                                bool strict_mode,
+                                bool allow_duplicates_in_obj)
+    {
+        context_lock lock (*CTX);
+        CTX->reset_stats ();
+        CTX->begin_stream (what, strict_mode, allow_duplicates_in_obj);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::next_value (jvalue& value)
+    {
+        context_lock lock (*CTX);
+        return CTX->next_value (value);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jparser::finish_stream ()
+    {
+        context_lock lock (*CTX);
+        return CTX->finish_stream ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::synchronized (bool enable)
     {
         std::lock_guard<std::mutex> lock (CTX->mutex);
+        CTX->synchronized = enable;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser::collect_stats (bool enable)
+    {
+#if UJSON_COLLECT_STATS
+        context_lock lock (*CTX);
+        CTX->collecting = enable;
+#else
+        (void) enable;
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jstats jparser::stats () const
+    {
+#if UJSON_COLLECT_STATS
+        context_lock lock (*CTX);
+        return CTX->stats;
+#else
+        return jstats ();
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jparser::error_t jparser::get_error () const
+    {
+        context_lock lock (*CTX);
         error_t err;
         err.code = CTX->error_code ();
         err.row  = CTX->error_row ();
@@ -1048,7 +2212,7 @@ pair:           STRING COLON value
     //--------------------------------------------------------------------------
     const std::string& jparser::error () const
     {
-        std::lock_guard<std::mutex> lock (CTX->mutex);
+        context_lock lock (*CTX);
         static std::string err_str;
         auto error_code = CTX->error_code ();
 
@@ -20,7 +20,10 @@
 #define UJSON_JPARSER_HPP
 
 #include <string>
+#include <vector>
+#include <functional>
 #include <ujson/jvalue.hpp>
+#include <ujson/jstats.hpp>
 
 
 namespace ujson {
@@ -61,6 +64,7 @@ namespace ujson {
             eob,                                       /**< Unexpected end of buffer/file. */
             io,                                        /**< Error reading input file. */
             internal,                                  /**< Internal parser error. */
+            aborted,                                   /**< Parsing aborted by a jreader handler. */
         };
 
         /**
@@ -72,6 +76,19 @@ namespace ujson {
             unsigned col;      /**< Column number of the error, starting at index 0. */
         };
 
+        /**
+         * Callback for each document parsed by parse_lines()
+         * and parse_lines_file().
+         * The first argument is the line number of the document,
+         * starting at index 0. The second argument is the parsed
+         * document, which is invalid if the line failed to parse,
+         * and the third argument is the parse result of the line.
+         * Return <code>false</code> from the callback to stop parsing.
+         */
+        using line_handler_t = std::function<bool (unsigned line,
+                                                   jvalue& value,
+                                                   const error_t& err)>;
+
         /**
          * Default constructor.
          */
@@ -105,6 +122,17 @@ namespace ujson {
 
         /**
          * Parse a JSON file and return a jvalue instance.
+         * If supported by the platform, regular files are memory mapped
+         * and parsed directly from the mapped region without first being
+         * copied to a buffer. Other types of files, like pipes, are read
+         * into a buffer before being parsed.
+         * <br/>
+         * Files compressed with gzip or zstd are detected by their first
+         * bytes, if libujson is built with support for the compression
+         * format. A compressed file is decompressed on a separate thread
+         * and parsed incrementally, chunk by chunk, while it is being
+         * decompressed. The decompressed document is never held in memory
+         * as a whole.
          * @param f The name of the JSON file to parse.
          * @param strict_mode if <code>true</code>, parsing is done strictly
          *                    according to the JSON specification (RFC 8259).
@@ -133,6 +161,37 @@ namespace ujson {
                            bool strict_mode=true,
                            bool allow_duplicates_in_obj=true);
 
+        /**
+         * Read a JSON document from a file descriptor and parse it.
+         * The input is read until end of file, and can be e.g. a pipe or
+         * a socket. Reading, and decompressing gzip or zstd compressed
+         * input, is done by a separate thread, overlapping with parsing.
+         * Compressed input is detected by its first bytes.
+         * The file descriptor is not closed.
+         * @param fd The file descriptor to read from.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         *                    <br/>
+         *                    If <code>false</code>, a more relaxed JSON
+         *                    format is used, where, among other things,
+         *                    C-style comments are allowed.
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.<br/>
+         *                                If <code>false</code> and duplicate
+         *                                member names exist, only the last
+         *                                name/value pair will be present in
+         *                                the resulting parsed object.
+         * @return A jvalue representing the JSON document. If parsing fails,
+         *         the returned jvalue will be invalid (of type ujson::j_invalid).
+         *         If reading or decompressing the input fails, the error code
+         *         is jparser::err::io.
+         * @see ujson::jdecompressor
+         * @see error()
+         */
+        jvalue parse_fd (int fd,
+                         bool strict_mode=true,
+                         bool allow_duplicates_in_obj=true);
+
         /**
          * Parse a string in JSON syntax and return a jvalue instance.
          * @param str The string to parse.
@@ -195,6 +254,256 @@ namespace ujson {
                              bool strict_mode=true,
                              bool allow_duplicates_in_obj=true);
 
+        /**
+         * Start incremental parsing of a JSON document.
+         * The document is then given in chunks of arbitrary size using
+         * method feed(), and the parsed result is returned by method finish().
+         * Calling begin() discards any incremental parsing in progress.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         *                    <br/>
+         *                    If <code>false</code>, a more relaxed JSON
+         *                    format is used, where, among other things,
+         *                    C-style comments are allowed.
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.<br/>
+         *                                If <code>false</code> and duplicate
+         *                                member names exist, only the last
+         *                                name/value pair will be present in
+         *                                the resulting parsed object.
+         * @see feed()
+         * @see finish()
+         */
+        void begin (bool strict_mode=true,
+                    bool allow_duplicates_in_obj=true);
+
+        /**
+         * Parse the next chunk of a JSON document.
+         * A chunk may end anywhere in the document, also in the middle of
+         * a token. Only a token that is incomplete at the end of the chunk
+         * is copied and kept until the next call, the rest of the chunk is
+         * parsed directly and the buffer is not needed after the call.
+         * If begin() isn't called before the first chunk, parsing is done
+         * in strict mode with duplicate object member names allowed.
+         * @param buf The next chunk of the document.
+         * @param length The length (in bytes) of the chunk.
+         * @return <code>false</code> if a parse error is found, in which
+         *         case the remaining chunks can be skipped and finish()
+         *         will return an invalid jvalue.
+         * @see begin()
+         * @see finish()
+         * @see error()
+         */
+        bool feed (const char* buf, size_t length);
+
+        /**
+         * End incremental parsing and return the parsed JSON document.
+         * @return A jvalue representing the JSON document. If parsing fails,
+         *         the returned jvalue will be invalid (of type ujson::j_invalid).
+         * @see begin()
+         * @see feed()
+         * @see error()
+         */
+        jvalue finish ();
+
+        /**
+         * What is returned by next_value() when streaming.
+         * @see begin_stream()
+         */
+        enum class stream_t {
+            items,     /**< The items of a top level array. */
+            documents, /**< Each document in a sequence of documents. */
+        };
+
+        /**
+         * Start parsing a stream of values incrementally.
+         * The input is given in chunks with feed(), like with begin(),
+         * but parsed values are moved out of the parser as soon as they
+         * are complete, and are returned one by one by next_value().
+         * Memory usage then only depends on the size of each value, not
+         * on the size of the stream.
+         * <br/>
+         * With stream_t::items, the items of a top level array are
+         * returned. If the document isn't an array, the whole document
+         * is returned as the only value when the stream is finished.
+         * <br/>
+         * With stream_t::documents, the input is a sequence of JSON
+         * documents separated by whitespace, like newline delimited
+         * JSON (NDJSON), and each document is returned.
+         * <br/>
+         * When the input ends, call finish_stream() to parse what
+         * remains. After an error, feed() and finish_stream() return
+         * <code>false</code>, and values parsed before the error can
+         * still be returned by next_value().
+         * \par Example:
+         * \code
+         * parser.begin_stream (ujson::jparser::stream_t::items);
+         * while (read_chunk(buf, len)) {
+         *     if (!parser.feed(buf, len))
+         *         break;
+         *     ujson::jvalue item;
+         *     while (parser.next_value(item))
+         *         process (item);
+         * }
+         * \endcode
+         * @param what What is returned by next_value().
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.
+         * @see next_value()
+         * @see finish_stream()
+         */
+        void begin_stream (stream_t what,
+                           bool strict_mode=true,
+                           bool allow_duplicates_in_obj=true);
+
+        /**
+         * Get the next value parsed from a stream.
+         * @param value Set to the next parsed value.
+         * @return <code>false</code> if no complete
+         *         value is available.
+         * @see begin_stream()
+         */
+        bool next_value (jvalue& value);
+
+        /**
+         * End parsing a stream started by begin_stream().
+         * The remaining input is parsed, and the values found
+         * are returned by next_value().
+         * @return <code>false</code> if the stream has a parse error,
+         *         or ends in the middle of a value.
+         * @see begin_stream()
+         * @see error()
+         */
+        bool finish_stream ();
+
+        /**
+         * Start parsing a buffer of newline delimited JSON documents,
+         * also known as NDJSON or JSON Lines.
+         * Each line in the buffer is a separate JSON document, and lines
+         * containing only whitespace are ignored. The documents are then
+         * parsed one by one by calling next_line(). The same parser state
+         * is reused for all documents in the buffer.
+         * The buffer must be valid until next_line() returns <code>false</code>.
+         * @param buf The buffer to parse.
+         * @param length The length (in bytes) of the buffer.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         *                    <br/>
+         *                    If <code>false</code>, a more relaxed JSON
+         *                    format is used, where, among other things,
+         *                    C-style comments are allowed.
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.<br/>
+         *                                If <code>false</code> and duplicate
+         *                                member names exist, only the last
+         *                                name/value pair will be present in
+         *                                the resulting parsed object.
+         * @see next_line()
+         */
+        void begin_lines (const char* buf,
+                          size_t length,
+                          bool strict_mode=true,
+                          bool allow_duplicates_in_obj=true);
+
+        /**
+         * Start parsing a file of newline delimited JSON documents.
+         * The file is memory mapped if possible.
+         * A gzip or zstd compressed file is decompressed into memory.
+         * @param f The name of the file.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.
+         * @return <code>false</code> if the file can't be read.
+         * @see begin_lines()
+         * @see next_line()
+         */
+        bool begin_lines_file (const std::string& f,
+                               bool strict_mode=true,
+                               bool allow_duplicates_in_obj=true);
+
+        /**
+         * Parse the next document started with begin_lines()
+         * or begin_lines_file().
+         * @param value The parsed document. If the line fails to parse,
+         *              the value is invalid (of type ujson::j_invalid)
+         *              and the error is given by get_error() or error(),
+         *              with the row set to the line in the buffer.
+         * @return <code>true</code> if a line was parsed,
+         *         <code>false</code> if no more lines are available.
+         * @see line()
+         */
+        bool next_line (jvalue& value);
+
+        /**
+         * Parse a buffer of newline delimited JSON documents in parallel.
+         * The buffer is split at line breaks into chunks that are parsed
+         * by worker threads. The parsed documents are passed to a callback
+         * that is called in the calling thread, in line order or in the
+         * order the chunks are parsed. The number of chunks parsed ahead
+         * of the callback is limited, so a slow callback will not make
+         * the parsed documents pile up in memory.
+         * <br/>
+         * Lines with only whitespace are ignored.
+         * Parsing limits set for this parser are used by all worker threads.
+         * @param buf The buffer to parse.
+         * @param length The length (in bytes) of the buffer.
+         * @param handler Called for each parsed document, valid or not.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.
+         * @param num_threads The number of worker threads.
+         *                    If 0, the number of hardware threads is used.
+         * @param ordered If <code>true</code>, documents are passed to the
+         *                handler in line order. If <code>false</code>,
+         *                chunks of documents are passed to the handler as
+         *                soon as they are parsed.
+         * @return <code>true</code> if all lines were parsed successfully.
+         *         If any line failed, get_error() and error() describe the
+         *         first failed line passed to the handler. If the handler
+         *         stopped the parsing, the error code is jparser::err::aborted.
+         */
+        bool parse_lines (const char* buf,
+                          size_t length,
+                          line_handler_t handler,
+                          bool strict_mode=true,
+                          bool allow_duplicates_in_obj=true,
+                          unsigned num_threads=0,
+                          bool ordered=true);
+
+        /**
+         * Parse a file of newline delimited JSON documents in parallel.
+         * The file is memory mapped if possible.
+         * A gzip or zstd compressed file is decompressed into memory.
+         * @param f The name of the file.
+         * @param handler Called for each parsed document, valid or not.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         * @param allow_duplicates_in_obj If <code>true</code>, duplicate
+         *                                member names in objects are allowed.
+         * @param num_threads The number of worker threads.
+         *                    If 0, the number of hardware threads is used.
+         * @param ordered If <code>true</code>, documents are passed to the
+         *                handler in line order.
+         * @return <code>true</code> if all lines were parsed successfully.
+         * @see parse_lines()
+         */
+        bool parse_lines_file (const std::string& f,
+                               line_handler_t handler,
+                               bool strict_mode=true,
+                               bool allow_duplicates_in_obj=true,
+                               unsigned num_threads=0,
+                               bool ordered=true);
+
+        /**
+         * Get the line number of the document last parsed by next_line().
+         * @return A line number, starting at index 0.
+         */
+        unsigned line () const;
+
         /**
          * Set limits when parsing JSON documents.
          * By default no limits are imposed.
@@ -207,6 +516,149 @@ namespace ujson {
                      unsigned max_array_size,
                      unsigned max_object_size);
 
+        /**
+         * Parse large documents using multiple threads.
+         * When a document of at least <code>min_size</code> bytes is
+         * parsed by parse_buffer(), parse_string() or parse_file(),
+         * the elements of a top level array, or the members of a
+         * top level object, are parsed in parallel and then put
+         * together. If the document can't be parsed this way, it is
+         * parsed again by a single thread. Errors are always reported
+         * as if the document was parsed by a single thread.
+         * <br/>
+         * By default documents are parsed by a single thread.
+         * @param num_threads The number of threads. 0 means the number
+         *                    of hardware threads, 1 disables parallel parsing.
+         * @param min_size Smaller documents are parsed by a single thread.
+         */
+        void threads (unsigned num_threads, size_t min_size=1024*1024);
+
+        /**
+         * Keep parsed numbers as text.
+         * When enabled, JSON numbers are stored as the text they were
+         * written with, and are only converted when jvalue::num() or
+         * jvalue::mpf() is called. jvalue::describe() writes such a
+         * number exactly as it was written in the parsed document.
+         * This makes parsing and writing documents faster when most
+         * numbers are just passed through.
+         * <br/>
+         * Note that jvalue::num() converts the text each time it is
+         * called, while jvalue::mpf() converts the number once and
+         * keeps the result. Numbers too large or too small to be
+         * represented are not reported as parse errors in this mode.
+         * <br/>
+         * By default numbers are converted when parsed.
+         * @param enable <code>true</code> to keep numbers as text.
+         */
+        void lazy_numbers (bool enable);
+
+        /**
+         * Let parsed strings refer to the parsed buffer.
+         * When enabled, JSON strings without escape sequences are not
+         * copied when parsed, they refer to the text in the parsed
+         * buffer until they are modified. This means fewer memory
+         * allocations when parsing documents with a lot of strings.
+         * <br/>
+         * This applies to parse_string(), parse_buffer() and parse_file().
+         * The parsed buffer must outlive the parsed document. With
+         * parse_file(), the parser keeps the content of the file until
+         * parse_file() is called again or the parser is destroyed.
+         * Copies of a borrowed string, and strings returned by
+         * jvalue::str(), don't refer to the parsed buffer.
+         * Object member names are always copied, and so are strings
+         * in relaxed mode that are made up by more than one string.
+         * Incremental parsing, with feed() and finish(), and parsing of
+         * newline delimited documents never borrow strings.
+         * <br/>
+         * By default strings are copied when parsed.
+         * @param enable <code>true</code> to let strings refer to the parsed buffer.
+         * @see jvalue::str_view()
+         */
+        void borrow_strings (bool enable);
+
+        /**
+         * Only parse selected parts of JSON documents.
+         * Each pattern is a JSON pointer to a value that is parsed,
+         * where a token <code>"*"</code> matches any object member
+         * or array element. Values that are not selected by any
+         * pattern, and not on the way to a selected value, are
+         * skipped without being converted. Inside a skipped value,
+         * only brackets are checked to match, and duplicate member
+         * names are not detected.
+         * <br/>
+         * The parsed document contains the selected values and the
+         * arrays and objects containing them. Skipped array elements
+         * that come before a parsed element are replaced by null
+         * values, so the patterns point to the same values in the
+         * parsed document as in the original document.
+         * A selected location that isn't found is not an error.
+         * \par Exampe:
+         * \code
+         * ujson::jparser parser;
+         * parser.projection ({"/id", "/customer/name", "/items"});
+         * auto instance = parser.parse_file ("order.json");
+         * \endcode
+         * <br/>
+         * This applies to all parse methods. Documents are not parsed
+         * in parallel, as set by threads(), while a projection is used.
+         * By default whole documents are parsed.
+         * @param patterns JSON pointers to the parts of the documents
+         *                 to parse. An empty list, or the empty pointer,
+         *                 parses whole documents.
+         * @throw std::invalid_argument if a pattern isn't a valid JSON pointer.
+         */
+        void projection (const std::vector<std::string>& patterns);
+
+        /**
+         * Lock the parser in each method call.
+         * By default each method locks an internal mutex, so that
+         * a parser can be shared between threads. If the parser is
+         * only used by one thread at a time, like a parser owned by
+         * a thread or borrowed from a ujson::jparser_pool, locking
+         * the mutex is pure overhead and can be disabled.
+         * <br/>
+         * This method itself must not be called while the parser
+         * is used by another thread.
+         * @param enable <code>false</code> to use the parser
+         *               without locking the mutex.
+         */
+        void synchronized (bool enable);
+
+        /**
+         * Collect statistics about parsed documents.
+         * When enabled, the parser counts the tokens, the largest
+         * arrays and objects, the nesting depth, and more, of each
+         * parsed document, and measures the time spent finding tokens
+         * and building the parsed values. The statistics of the last
+         * document are returned by stats().
+         * <br/>
+         * Collecting statistics makes parsing slower, since each token
+         * is timed. This is only supported if libujson is built with
+         * cmake option <code>COLLECT_STATS</code>, otherwise the parser
+         * contains no code for it, and stats() returns only zeros.
+         * <br/>
+         * When a document is parsed by multiple threads, see threads(),
+         * the time is the sum of the time spent by all the threads.
+         * Documents parsed by parse_lines() and parse_lines_file()
+         * are not included.
+         * <br/>
+         * By default statistics are not collected.
+         * @param enable <code>true</code> to collect statistics.
+         * @see stats()
+         */
+        void collect_stats (bool enable);
+
+        /**
+         * Get statistics about the last parsed document.
+         * This is the document parsed by the last call to
+         * parse_file(), parse_string(), parse_buffer(), next_line(),
+         * or all chunks parsed since begin() if parsed incrementally.
+         * @return Statistics about the parsed document, all zeros if
+         *         statistics are not collected.
+         * @see collect_stats()
+         */
+        jstats stats () const;
+
         /**
          * Get an error code and position.
          * @return An error code and the position in the file/buffer where
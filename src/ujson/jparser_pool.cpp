@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jparser_pool.hpp>
+
+
+namespace ujson {
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jparser_pool::handle::handle (jparser_pool& p, std::unique_ptr<jparser>&& parser_arg)
+        : pool {&p},
+          parser {std::move(parser_arg)}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jparser_pool::handle& jparser_pool::handle::operator= (handle&& h)
+    {
+        if (this != &h) {
+            if (parser)
+                pool->release (std::move(parser));
+            pool = h.pool;
+            parser = std::move (h.parser);
+        }
+        return *this;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jparser_pool::handle::~handle ()
+    {
+        if (parser)
+            pool->release (std::move(parser));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jparser_pool::jparser_pool (std::function<void (jparser&)> setup_arg,
+                                size_t max_idle_arg)
+        : setup {setup_arg},
+          max_idle {max_idle_arg}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jparser_pool::handle jparser_pool::acquire ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            if (!parsers.empty()) {
+                handle h (*this, std::move(parsers.back()));
+                parsers.pop_back ();
+                return h;
+            }
+        }
+
+        // Create the parser without holding the lock
+        auto parser = std::make_unique<jparser> ();
+        parser->synchronized (false);
+        if (setup)
+            setup (*parser);
+        return handle (*this, std::move(parser));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    size_t jparser_pool::idle () const
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        return parsers.size ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser_pool::clear ()
+    {
+        std::vector<std::unique_ptr<jparser>> unused;
+        {
+            std::lock_guard<std::mutex> lock (mutex);
+            unused.swap (parsers);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jparser_pool::release (std::unique_ptr<jparser>&& parser)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (!max_idle || parsers.size() < max_idle)
+            parsers.emplace_back (std::move(parser));
+        else
+            parser.reset ();
+    }
+
+
+}
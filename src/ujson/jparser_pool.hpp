@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JPARSER_POOL_HPP
+#define UJSON_JPARSER_POOL_HPP
+
+#include <ujson/jparser.hpp>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace ujson {
+
+
+    /**
+     * A pool of parsers reused between threads.
+     * A thread borrows a parser with acquire() and returns it to
+     * the pool when the handle is destroyed. The parsers in the pool
+     * are not synchronized, see jparser::synchronized(), and keep their
+     * internal stacks and buffers between uses. Many small documents,
+     * like the messages of a server, can then be parsed by several
+     * threads without creating a new parser for each document, and
+     * without threads waiting for each other.
+     * <br/>
+     * Settings changed on a borrowed parser, like jparser::limits(),
+     * are kept when the parser is returned to the pool. Settings that
+     * all parsers should have are best set by the setup function.
+     * <br/>
+     * Example:
+     * <pre>
+     * ujson::jparser_pool pool ([](ujson::jparser& p){
+     *     p.limits (64, 0, 0);
+     * });
+     * ...
+     * // In any thread:
+     * auto parser = pool.acquire ();
+     * auto doc = parser->parse_string (message);
+     * if (!doc.valid())
+     *     std::cerr << parser->error() << std::endl;
+     * </pre>
+     */
+    class jparser_pool {
+    public:
+        /**
+         * A parser borrowed from a pool.
+         * The parser is returned to the pool when the handle is
+         * destroyed. The pool must outlive all its handles.
+         */
+        class handle {
+        public:
+            /**
+             * Move constructor.
+             */
+            handle (handle&& h) = default;
+
+            /**
+             * Move assignment.
+             * A parser already held by this handle is returned
+             * to the pool.
+             */
+            handle& operator= (handle&& h);
+
+            /**
+             * Return the parser to the pool.
+             */
+            ~handle ();
+
+            handle (const handle&) = delete;
+            handle& operator= (const handle&) = delete;
+
+            /**
+             * Access the borrowed parser.
+             */
+            jparser& operator* () const {return *parser;}
+
+            /**
+             * Access the borrowed parser.
+             */
+            jparser* operator-> () const {return parser.get();}
+
+        private:
+            friend class jparser_pool;
+            handle (jparser_pool& p, std::unique_ptr<jparser>&& parser_arg);
+
+            jparser_pool* pool;
+            std::unique_ptr<jparser> parser;
+        };
+
+        /**
+         * Constructor.
+         * @param setup A function called once for each new parser
+         *              created by the pool, to apply settings like
+         *              jparser::limits() or jparser::lazy_numbers().
+         * @param max_idle The maximum number of unused parsers kept
+         *                 in the pool. Parsers returned to a full pool
+         *                 are destroyed. 0 for no limit.
+         */
+        jparser_pool (std::function<void (jparser&)> setup = nullptr,
+                      size_t max_idle = 0);
+
+        /**
+         * Destructor.
+         * Destroy all unused parsers in the pool.
+         */
+        ~jparser_pool () = default;
+
+        jparser_pool (const jparser_pool&) = delete;
+        jparser_pool& operator= (const jparser_pool&) = delete;
+
+        /**
+         * Borrow a parser from the pool.
+         * If no unused parser is available, a new one is created.
+         * @return A handle to a parser used only by the caller
+         *         until the handle is destroyed.
+         */
+        handle acquire ();
+
+        /**
+         * Return the number of unused parsers in the pool.
+         * @return The number of unused parsers.
+         */
+        size_t idle () const;
+
+        /**
+         * Destroy all unused parsers in the pool.
+         * Parsers currently borrowed are not affected.
+         */
+        void clear ();
+
+
+    private:
+        std::function<void (jparser&)> setup;
+        size_t max_idle;
+        mutable std::mutex mutex;
+        std::vector<std::unique_ptr<jparser>> parsers;
+
+        void release (std::unique_ptr<jparser>&& parser);
+    };
+
+
+}
+#endif
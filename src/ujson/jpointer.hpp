@@ -71,6 +71,8 @@ namespace ujson {
 
         inline std::string& front () {return tokens.front();} /**< Access the first token. */
         inline std::string& back ()  {return tokens.back();} /**< Access the last token. */
+        inline const std::string& front () const {return tokens.front();} /**< Access the first token. */
+        inline const std::string& back () const  {return tokens.back();} /**< Access the last token. */
 
         inline void push_back (const std::string& token)  {tokens.push_back(token);} /**< Append a token.  */
         inline void emplace_back (std::string&& token)    {tokens.emplace_back(std::forward<std::string>(token));}  /**< Append a token. */
@@ -0,0 +1,423 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/internal.hpp>
+#include <ujson/jpointer_set.hpp>
+#include <stdexcept>
+
+
+namespace ujson {
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jpointer_set::jpointer_set (const std::vector<jpointer>& pointers)
+    {
+        for (auto& pointer : pointers)
+            add (pointer);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jpointer_set::jpointer_set (std::initializer_list<std::string> pointers)
+    {
+        for (auto& pointer : pointers)
+            add (jpointer(pointer));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jpointer_set::jpointer_set (const jpointer_set& pointer_set)
+    {
+        // The prefix tree is rebuilt since the
+        // nodes refer to each other by address.
+        for (auto& pointer : pointer_set.pointers)
+            add (pointer);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jpointer_set& jpointer_set::operator= (const jpointer_set& pointer_set)
+    {
+        if (&pointer_set != this) {
+            clear ();
+            for (auto& pointer : pointer_set.pointers)
+                add (pointer);
+        }
+        return *this;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    size_t jpointer_set::add (const jpointer& pointer)
+    {
+        node_t* node = &root;
+        for (auto& token : pointer) {
+            auto entry = node->children.find (token);
+            if (entry == node->children.end()) {
+                entry = node->children.emplace(token, node_t()).first;
+                size_t index;
+                if (parse_array_index(token, index))
+                    node->items.emplace (index, &entry->second);
+            }
+            node = &entry->second;
+        }
+        node->targets.emplace_back (pointers.size());
+        pointers.emplace_back (pointer);
+        return pointers.size() - 1;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jpointer_set::clear ()
+    {
+        pointers.clear ();
+        root = node_t ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::vector<const jvalue*> jpointer_set::find (const jvalue& instance) const
+    {
+        std::vector<const jvalue*> result (pointers.size(), nullptr);
+        find (root, instance, result);
+        return result;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::vector<jvalue*> jpointer_set::find (jvalue& instance) const
+    {
+        std::vector<jvalue*> result (pointers.size(), nullptr);
+        find (root, instance, result);
+        return result;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jpointer_set::find (const node_t& node,
+                             const jvalue& value,
+                             std::vector<const jvalue*>& result) const
+    {
+        for (auto target : node.targets)
+            result[target] = &value;
+
+        if (value.type() == j_object) {
+            for (auto& [name, child] : node.children) {
+                auto& member = value.get (name);
+                if (member.valid())
+                    find (child, member, result);
+            }
+        }
+        else if (value.type() == j_array) {
+            auto& array = value.array ();
+            for (auto& [index, child] : node.items) {
+                if (index >= array.size())
+                    break;
+                find (*child, array[index], result);
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Walk the paths with non-const accessors, the values may be changed.
+    //--------------------------------------------------------------------------
+    void jpointer_set::find (const node_t& node,
+                             jvalue& value,
+                             std::vector<jvalue*>& result) const
+    {
+        for (auto target : node.targets)
+            result[target] = &value;
+
+        if (value.type() == j_object) {
+            for (auto& [name, child] : node.children) {
+                auto* member = member_to_change (value, name);
+                if (member)
+                    find (child, *member, result);
+            }
+        }
+        else if (value.type() == j_array) {
+            for (auto& [index, child] : node.items) {
+                auto* item = item_to_change (value, index);
+                if (item == nullptr)
+                    break;
+                find (*child, *item, result);
+            }
+        }
+    }
+
+
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jpointer_set::extractor::extractor (const jpointer_set& pointers)
+        : set (pointers),
+          captured_node (nullptr)
+    {
+        reset ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jpointer_set::extractor::reset ()
+    {
+        values.assign (set.size(), jvalue(j_invalid));
+        frames.clear ();
+        captured_node = nullptr;
+        build_stack.clear ();
+        build_keys.clear ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Get the prefix tree node of the value about to be reported,
+    // nullptr if no JSON pointer points to it or below it.
+    //--------------------------------------------------------------------------
+    const jpointer_set::node_t* jpointer_set::extractor::begin_value ()
+    {
+        if (frames.empty())
+            return &set.root;
+
+        auto& frame = frames.back ();
+        if (frame.node == nullptr)
+            return nullptr;
+        if (!frame.is_array)
+            return frame.next;
+
+        auto entry = frame.node->items.find (frame.index++);
+        return entry == frame.node->items.end() ? nullptr : entry->second;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Add a value to the value being built.
+    //--------------------------------------------------------------------------
+    void jpointer_set::extractor::add_value (jvalue&& value)
+    {
+        if (build_stack.empty()) {
+            store_captured (std::move(value));
+            return;
+        }
+        auto& container = build_stack.back ();
+        if (container.type() == j_array) {
+            container.array().emplace_back (std::move(value));
+        }else{
+#if UJSON_INTERNED_KEYS
+            container.obj().emplace_back (jkey::intern(build_keys.back()), std::move(value));
+#else
+            container.obj().emplace_back (std::move(build_keys.back()), std::move(value));
+#endif
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jpointer_set::extractor::begin_container (jvalue&& container)
+    {
+        bool is_array = container.type() == j_array;
+        if (captured_node == nullptr) {
+            auto* node = begin_value ();
+            if (node == nullptr  ||  node->targets.empty()) {
+                // Search, or skip, the container
+                frames.push_back ({node, nullptr, 0, is_array});
+                return;
+            }
+            // Build the container
+            captured_node = node;
+        }
+        build_stack.emplace_back (std::move(container));
+        build_keys.emplace_back ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jpointer_set::extractor::end_container ()
+    {
+        if (captured_node == nullptr) {
+            frames.pop_back ();
+            return;
+        }
+        jvalue container (std::move(build_stack.back()));
+        build_stack.pop_back ();
+        build_keys.pop_back ();
+        add_value (std::move(container));
+    }
+
+
+    //--------------------------------------------------------------------------
+    // A value pointed to by at least one JSON pointer is complete.
+    // Store it, and any value inside it pointed to by other pointers.
+    //--------------------------------------------------------------------------
+    void jpointer_set::extractor::store_captured (jvalue&& value)
+    {
+        auto* node = captured_node;
+        captured_node = nullptr;
+
+        if (!node->children.empty()) {
+            std::vector<const jvalue*> found (set.size(), nullptr);
+            set.find (*node, value, found);
+            for (size_t i=0; i<found.size(); ++i) {
+                if (found[i] && found[i] != &value)
+                    values[i] = *found[i];
+            }
+        }
+        for (size_t i=1; i<node->targets.size(); ++i)
+            values[node->targets[i]] = value;
+        values[node->targets[0]] = std::move (value);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_begin_object ()
+    {
+        begin_container (jvalue(j_object));
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_key (std::string_view key)
+    {
+        if (captured_node) {
+            build_keys.back() = key;
+            return true;
+        }
+        auto& frame = frames.back ();
+        frame.next = nullptr;
+        if (frame.node) {
+            auto entry = frame.node->children.find (key);
+            if (entry != frame.node->children.end())
+                frame.next = &entry->second;
+        }
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_end_object ()
+    {
+        end_container ();
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_begin_array ()
+    {
+        begin_container (jvalue(j_array));
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_end_array ()
+    {
+        end_container ();
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_string (std::string_view str)
+    {
+        if (captured_node == nullptr) {
+            auto* node = begin_value ();
+            if (node == nullptr  ||  node->targets.empty())
+                return true;
+            captured_node = node;
+        }
+        add_value (jvalue(std::string(str)));
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_number (std::string_view number)
+    {
+        if (captured_node == nullptr) {
+            auto* node = begin_value ();
+            if (node == nullptr  ||  node->targets.empty())
+                return true;
+            captured_node = node;
+        }
+        jvalue value;
+        if (!number_from_token(number, value)) {
+            try {
+                number_from_string (std::string(number), value);
+            }
+            catch (...) {
+                // Can't convert the number, abort parsing
+                return false;
+            }
+        }
+        add_value (std::move(value));
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_bool (bool value)
+    {
+        if (captured_node == nullptr) {
+            auto* node = begin_value ();
+            if (node == nullptr  ||  node->targets.empty())
+                return true;
+            captured_node = node;
+        }
+        add_value (jvalue(value));
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jpointer_set::extractor::on_null ()
+    {
+        if (captured_node == nullptr) {
+            auto* node = begin_value ();
+            if (node == nullptr  ||  node->targets.empty())
+                return true;
+            captured_node = node;
+        }
+        add_value (jvalue(j_null));
+        return true;
+    }
+
+
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JPOINTER_SET_HPP
+#define UJSON_JPOINTER_SET_HPP
+
+#include <ujson/jvalue.hpp>
+#include <ujson/jpointer.hpp>
+#include <ujson/jreader.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <initializer_list>
+#include <cstddef>
+
+
+namespace ujson {
+
+
+    /**
+     * A set of JSON pointers that are resolved together.
+     * The pointers are stored in a prefix tree, so tokens that are
+     * shared by several pointers are only looked up once, and all
+     * pointers are resolved in a single traversal of a JSON instance.
+     * <br/>
+     * The pointers can also be resolved while a document is read by
+     * a ujson::jreader, using a jpointer_set::extractor. Then only the
+     * values pointed to are built, so memory usage depends on the
+     * size of the values found, not the size of the document.
+     * <br/>
+     * Results are returned in the same order as the pointers were given.
+     * The same pointer may be given more than once.
+     * \par Exampe:
+     * \code
+     * ujson::jpointer_set pointers ({"/name", "/address/city", "/address/zip"});
+     * auto values = pointers.find (instance);
+     * for (size_t i=0; i<values.size(); ++i) {
+     *     if (values[i])
+     *         std::cout << pointers[i].str() << ": " << values[i]->describe() << std::endl;
+     * }
+     * \endcode
+     */
+    class jpointer_set {
+    private:
+        struct node_t;
+
+    public:
+        /**
+         * Event handler that resolves a set of JSON pointers
+         * while a document is read by a ujson::jreader.
+         * Values outside of the pointed to locations are skipped,
+         * only the values pointed to are built.
+         * If an object has more than one member with the same name,
+         * the value of the last member is used, the same as
+         * jvalue::get().
+         * \par Exampe:
+         * \code
+         * ujson::jpointer_set pointers ({"/header/id", "/header/time"});
+         * ujson::jpointer_set::extractor extract (pointers);
+         * ujson::jreader reader;
+         * if (reader.parse_file(extract, "huge.json")) {
+         *     for (auto& value : extract.results())
+         *         std::cout << value.describe() << std::endl;
+         * }
+         * \endcode
+         */
+        class extractor : public jreader::handler {
+        public:
+            /**
+             * Constructor.
+             * @param pointers The JSON pointers to resolve. The object
+             *                 must outlive the extractor.
+             */
+            extractor (const jpointer_set& pointers);
+
+            /**
+             * Clear the results, to read another document.
+             */
+            void reset ();
+
+            /**
+             * Get the resolved values.
+             * @return A vector with one value for each JSON pointer,
+             *         in the same order as in the jpointer_set.
+             *         A value of type ujson::j_invalid means that
+             *         the value wasn't found.
+             */
+            std::vector<jvalue>& results () {return values;}
+
+            bool on_begin_object () override;
+            bool on_key (std::string_view key) override;
+            bool on_end_object () override;
+            bool on_begin_array () override;
+            bool on_end_array () override;
+            bool on_string (std::string_view str) override;
+            bool on_number (std::string_view number) override;
+            bool on_bool (bool value) override;
+            bool on_null () override;
+
+
+        private:
+            struct frame_t {
+                const node_t* node; // nullptr if no pointer continues below this container
+                const node_t* next; // Node of the next member value in an object
+                size_t index;       // Index of the next item in an array
+                bool is_array;
+            };
+
+            const node_t* begin_value ();
+            void add_value (jvalue&& value);
+            void begin_container (jvalue&& container);
+            void end_container ();
+            void store_captured (jvalue&& value);
+
+            const jpointer_set& set;
+            std::vector<jvalue> values;
+            std::vector<frame_t> frames;     // Containers being skipped or searched
+            const node_t* captured_node;     // Node of the value being built, if any
+            std::vector<jvalue> build_stack; // Containers of the value being built
+            std::vector<std::string> build_keys; // Pending member names of the objects being built
+        };
+
+        jpointer_set () = default; /**< Default constructor. Create an empty set. */
+
+        /**
+         * Constructor.
+         * @param pointers The JSON pointers in the set.
+         */
+        jpointer_set (const std::vector<jpointer>& pointers);
+
+        /**
+         * Constructor.
+         * @param pointers The JSON pointers in the set.
+         * @throw std::invalid_argument if a pointer string isn't a valid JSON pointer.
+         */
+        jpointer_set (std::initializer_list<std::string> pointers);
+
+        jpointer_set (const jpointer_set& pointer_set);     /**< Copy constructor. */
+        jpointer_set (jpointer_set&& pointer_set) = default; /**< Move constructor. */
+        jpointer_set& operator= (const jpointer_set& pointer_set); /**< Assignment operator. */
+        jpointer_set& operator= (jpointer_set&& pointer_set) = default; /**< Move operator. */
+
+        /**
+         * Add a JSON pointer to the set.
+         * @param pointer A JSON pointer.
+         * @return The position of the pointer in the set,
+         *         and in the vector of results.
+         */
+        size_t add (const jpointer& pointer);
+
+        /**
+         * Remove all JSON pointers from the set.
+         */
+        void clear ();
+
+        /**
+         * Find the values of all JSON pointers in a JSON instance.
+         * @param instance A JSON instance.
+         * @return A vector with one pointer to a value for each
+         *         JSON pointer in the set, in the same order
+         *         as the JSON pointers were added.
+         *         <code>nullptr</code> means that the value wasn't found.
+         */
+        std::vector<const jvalue*> find (const jvalue& instance) const;
+
+        /**
+         * Find the values of all JSON pointers in a JSON instance.
+         * Same as the const version, but returns values
+         * that may be modified by the caller. The objects
+         * and arrays on the paths to the values are unshared,
+         * and their cached hash values cleared (see
+         * jvalue::share() and jvalue::cache_hash()).
+         * @param instance A JSON instance.
+         * @return A vector with one pointer to a value for each
+         *         JSON pointer in the set.
+         */
+        std::vector<jvalue*> find (jvalue& instance) const;
+
+        inline size_t size () const {return pointers.size();}   /**< Return the number of JSON pointers in the set. */
+        inline bool empty () const  {return pointers.empty();}  /**< Return <code>true</code> if the set is empty. */
+
+        /** Return a JSON pointer in the set. */
+        inline const jpointer& operator[] (size_t n) const {return pointers[n];}
+
+
+    private:
+        struct node_t {
+            // Children are never moved once added, so they can be
+            // referenced from 'items' of the parent node.
+            std::map<std::string, node_t, std::less<>> children;
+            std::map<size_t, const node_t*> items; // Children that are valid array indexes
+            std::vector<size_t> targets; // The JSON pointers ending at this node
+        };
+
+        void find (const node_t& node, const jvalue& value, std::vector<const jvalue*>& result) const;
+        void find (const node_t& node, jvalue& value, std::vector<jvalue*>& result) const;
+
+        std::vector<jpointer> pointers;
+        node_t root;
+    };
+
+
+}
+#endif
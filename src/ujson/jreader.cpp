@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/internal.hpp>
+#include <ujson/jtokenizer.hpp>
+#include <ujson/jreader.hpp>
+#include <ujson/file_view.hpp>
+#include <ujson/utils.hpp>
+#include <ujson/parse_machine.hpp>
+#include <string_view>
+#include <string>
+#include <vector>
+
+
+#define CTX reinterpret_cast<reader_t*>(read_context)
+
+
+using namespace ujson::parser;
+
+
+namespace ujson {
+
+
+    //--------------------------------------------------------------------------
+    // Reports the events of the parse machine, that is also used by
+    // class parser_t in jparser.cpp, to a handler as soon as each
+    // value is parsed, instead of collecting the values in a tree.
+    //--------------------------------------------------------------------------
+    class reader_t : public parse_machine<reader_t> {
+    public:
+        reader_t () {
+            h = nullptr;
+        }
+
+        bool parse (jreader::handler& handler,
+                    const char* buffer,
+                    const size_t buffer_size,
+                    bool strict_parsing);
+
+        std::string err_str;
+
+
+    private:
+        friend class parse_machine<reader_t>;
+
+        jtokenizer tokenizer;
+        jreader::handler* h;
+
+        // Scratch space for unescaped strings.
+        std::string unescaped;
+
+        // This is the currently parsed string value until
+        // the complete string is parsed.
+        // In relaxed mode, a string can be made up by
+        // multiple strings divided by whitespaces and comments.
+        // If the string doesn't need to be unescaped or
+        // concatenated, it is a view of the parsed buffer.
+        std::string parsed_string;
+        std::string_view parsed_string_view;
+        bool parsed_string_in_buffer {false};
+
+        void emit (bool handler_result, const jtoken& token) {
+            if (!handler_result)
+                error (jparser::err::aborted, token);
+        }
+        bool unescape_token (const jtoken& token, std::string_view& result);
+
+        // Events from the parse machine
+        void on_begin_object (const jtoken& token, parse_frame_t& frame) {
+            emit (h->on_begin_object(), token);
+        }
+        void on_begin_array (const jtoken& token, parse_frame_t& frame) {
+            emit (h->on_begin_array(), token);
+        }
+        void on_member_name (const jtoken& token, parse_frame_t& frame) {
+            std::string_view name;
+            if (unescape_token(token, name))
+                emit (h->on_key(name), token);
+        }
+        void on_member_value (parse_frame_t& frame) {
+        }
+        void on_end_object (const jtoken& token, parse_frame_t& frame) {
+            emit (h->on_end_object(), token);
+        }
+        void on_end_array (const jtoken& token, parse_frame_t& frame) {
+            emit (h->on_end_array(), token);
+        }
+        void on_null (const jtoken& token) {
+            emit (h->on_null(), token);
+        }
+        void on_bool (const jtoken& token, bool value) {
+            emit (h->on_bool(value), token);
+        }
+        void on_number (const jtoken& token) {
+            emit (h->on_number(token.data), token);
+        }
+        void on_string (const jtoken& token) {
+            std::string_view str;
+            if (unescape_token(token, str))
+                emit (h->on_string(str), token);
+        }
+        void on_string_part (const jtoken& token, bool first);
+        void on_string_end (const jtoken& token);
+        void on_error_at_end (jparser::err code) {
+            if (first_token)
+                error (code, 0, 0); // No JSON instance found
+            else
+                error_at_offset (code, tokenizer.offset());
+        }
+    };
+
+
+    //--------------------------------------------------------------------------
+    // Only strings with escape sequences are copied.
+    //--------------------------------------------------------------------------
+    bool reader_t::unescape_token (const jtoken& token, std::string_view& result)
+    {
+        if (token.type != jtoken::tk_string  ||  !token.has_escapes) {
+            result = token.data;
+            return true;
+        }
+        try {
+            unescaped.clear ();
+            unescape_append (token.data, unescaped);
+        }
+        catch (...) {
+            error (jparser::err::invalid_string, token);
+            return false;
+        }
+        result = unescaped;
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // A string that is the only part of a string value is
+    // kept as a view of the parsed buffer if not unescaped.
+    //--------------------------------------------------------------------------
+    void reader_t::on_string_part (const jtoken& token, bool first)
+    {
+        std::string_view str;
+        if (!unescape_token(token, str))
+            return;
+
+        if (first) {
+            if (str.data() == token.data.data()) {
+                parsed_string_view = str;
+                parsed_string_in_buffer = true;
+            }else{
+                parsed_string.assign (str);
+                parsed_string_in_buffer = false;
+            }
+        }else{
+            if (parsed_string_in_buffer) {
+                parsed_string.assign (parsed_string_view);
+                parsed_string_in_buffer = false;
+            }
+            parsed_string.append (str);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void reader_t::on_string_end (const jtoken& token)
+    {
+        std::string_view str = parsed_string_in_buffer ? parsed_string_view : parsed_string;
+        emit (h->on_string(str), token);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool reader_t::parse (jreader::handler& handler,
+                          const char* buffer,
+                          const size_t buffer_size,
+                          bool strict_parsing)
+    {
+        strict = strict_parsing;
+        h = &handler;
+        reset_machine ();
+        expect_value (nullptr);
+        tokenizer.reset (std::string_view(buffer, buffer_size), strict, false);
+
+        while (err_code == jparser::err::ok) {
+            auto token = tokenizer.next_token ();
+            if (token == nullptr) {
+                finish_tokens (tokenizer.offset());
+                break;
+            }
+            if (token->type != jtoken::tk_comment) // Ignore comments
+                parse_token (*token);
+        }
+
+        if (err_code!=jparser::err::ok && err_at_offset) {
+            auto pos = tokenizer.pos (err_offset);
+            err_row = pos.first;
+            err_col = pos.second;
+        }
+        h = nullptr;
+        return err_code == jparser::err::ok;
+    }
+
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jreader::jreader ()
+    {
+        read_context = new reader_t;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jreader::jreader (unsigned max_depth,
+                      unsigned max_array_size,
+                      unsigned max_object_size)
+    {
+        read_context = new reader_t;
+        limits (max_depth, max_array_size, max_object_size);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jreader::~jreader ()
+    {
+        delete CTX;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jreader::limits (unsigned max_depth,
+                          unsigned max_array_size,
+                          unsigned max_object_size)
+    {
+        CTX->limits (max_depth, max_array_size, max_object_size);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jreader::parse_file (handler& h,
+                              const std::string& f,
+                              bool strict_mode)
+    {
+        file_view in (f, true, true);
+        if (!in.good()) {
+            CTX->error (jparser::err::io, 0, 0);
+            return false;
+        }
+        return CTX->parse (h, in.data().data(), in.data().size(), strict_mode);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jreader::parse_string (handler& h,
+                                const std::string& str,
+                                bool strict_mode)
+    {
+        return CTX->parse (h, str.data(), str.size(), strict_mode);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jreader::parse_buffer (handler& h,
+                                const char* buf,
+                                size_t length,
+                                bool strict_mode)
+    {
+        return CTX->parse (h, buf, length, strict_mode);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jparser::error_t jreader::get_error () const
+    {
+        jparser::error_t err;
+        err.code = CTX->error_code ();
+        err.row  = CTX->error_row ();
+        err.col  = CTX->error_col ();
+        return err;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const std::string& jreader::error () const
+    {
+        auto& err_str = CTX->err_str;
+        auto error_code = CTX->error_code ();
+
+        if (error_code == jparser::err::ok) {
+            err_str = "Ok.";
+        }else{
+            err_str = parser_err_to_str (error_code);
+            err_str.append (" at line ");
+            err_str.append (std::to_string(CTX->error_row()+1));
+            err_str.append (", column ");
+            err_str.append (std::to_string(CTX->error_col()));
+        }
+        return err_str;
+    }
+
+
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JREADER_HPP
+#define UJSON_JREADER_HPP
+
+#include <string>
+#include <string_view>
+#include <ujson/jparser.hpp>
+
+
+namespace ujson {
+
+
+    /**
+     * Event based JSON reader.
+     * Instead of building a jvalue tree like class jparser,
+     * a jreader scans a JSON document and reports each
+     * value to a handler object as it is found. Memory usage
+     * only depends on the nesting depth of the document,
+     * not its size.
+     *
+     * Strings and object member names are passed to the
+     * handler as unescaped string views. The views are only
+     * valid until the callback returns. Numbers are passed
+     * as the number text found in the document.
+     *
+     * Note that a jreader doesn't check for duplicate object
+     * member names, since this would require keeping all
+     * member names of all open objects in memory.
+     *
+     * A jreader is not thread safe, an instance must only
+     * be used by one thread at a time.
+     */
+    class jreader {
+    public:
+        /**
+         * Base class for objects receiving events from a jreader.
+         * Each callback returns <code>true</code> to continue parsing,
+         * or <code>false</code> to abort parsing, in which case the
+         * parse method returns <code>false</code> with error code
+         * jparser::err::aborted.
+         * All callbacks have a default implementation that
+         * does nothing and returns <code>true</code>.
+         */
+        class handler {
+        public:
+            virtual ~handler () = default;
+
+            /** The start of an object. */
+            virtual bool on_begin_object () { return true; }
+
+            /**
+             * An object member name.
+             * The member value is reported by the next event.
+             */
+            virtual bool on_key (std::string_view key) { return true; }
+
+            /** The end of an object. */
+            virtual bool on_end_object () { return true; }
+
+            /** The start of an array. */
+            virtual bool on_begin_array () { return true; }
+
+            /** The end of an array. */
+            virtual bool on_end_array () { return true; }
+
+            /** A string value. */
+            virtual bool on_string (std::string_view str) { return true; }
+
+            /** A number value, as found in the document. */
+            virtual bool on_number (std::string_view number) { return true; }
+
+            /** A boolean value. */
+            virtual bool on_bool (bool value) { return true; }
+
+            /** A null value. */
+            virtual bool on_null () { return true; }
+        };
+
+        /**
+         * Default constructor.
+         */
+        jreader ();
+
+        /**
+         * Constructor.
+         * @param max_depth Maximum nesting depth. 0 for no limit.
+         *                  The nesting depth is increased by both arrays and objects.
+         * @param max_array_size Maximum number of items allowed in an array. 0 for no limit.
+         * @param max_object_size Maximum number of object members allowed in a JSON object. 0 for no limit.
+         */
+        jreader (unsigned max_depth,
+                 unsigned max_array_size,
+                 unsigned max_object_size);
+
+        /**
+         * Destructor.
+         */
+        virtual ~jreader ();
+
+        /**
+         * Disabled copy constructor.
+         */
+        jreader (const jreader& j) = delete;
+
+        /**
+         * Disabled assignment operator.
+         */
+        jreader& operator= (const jreader& j) = delete;
+
+        /**
+         * Read a JSON file and report its contents to a handler.
+         * A gzip or zstd compressed file is decompressed into memory.
+         * @param h The handler receiving parse events.
+         * @param f The name of the JSON file to read.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         *                    <br/>
+         *                    If <code>false</code>, a more relaxed JSON
+         *                    format is used, where, among other things,
+         *                    C-style comments are allowed.
+         * @return <code>true</code> if the whole document was successfully
+         *         parsed, <code>false</code> on error.
+         * @see get_error()
+         */
+        bool parse_file (handler& h,
+                         const std::string& f,
+                         bool strict_mode=true);
+
+        /**
+         * Read a string in JSON syntax and report its contents to a handler.
+         * @param h The handler receiving parse events.
+         * @param str The string to parse.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         *                    <br/>
+         *                    If <code>false</code>, a more relaxed JSON
+         *                    format is used, where, among other things,
+         *                    C-style comments are allowed.
+         * @return <code>true</code> if the whole document was successfully
+         *         parsed, <code>false</code> on error.
+         * @see get_error()
+         */
+        bool parse_string (handler& h,
+                           const std::string& str,
+                           bool strict_mode=true);
+
+        /**
+         * Read a text buffer in JSON syntax and report its contents to a handler.
+         * @param h The handler receiving parse events.
+         * @param buf The text string to parse.
+         * @param length The length (in bytes) of the text in the buffer.
+         * @param strict_mode if <code>true</code>, parsing is done strictly
+         *                    according to the JSON specification (RFC 8259).
+         *                    <br/>
+         *                    If <code>false</code>, a more relaxed JSON
+         *                    format is used, where, among other things,
+         *                    C-style comments are allowed.
+         * @return <code>true</code> if the whole document was successfully
+         *         parsed, <code>false</code> on error.
+         * @see get_error()
+         */
+        bool parse_buffer (handler& h,
+                           const char* buf,
+                           size_t length,
+                           bool strict_mode=true);
+
+        /**
+         * Set limits when parsing JSON documents.
+         * By default no limits are imposed.
+         * @param max_depth Maximum nesting depth. 0 for no limit.
+         *                  The nesting depth is increased by both arrays and objects.
+         * @param max_array_size Maximum number of items allowed in an array. 0 for no limit.
+         * @param max_object_size Maximum number of object members allowed in a JSON object. 0 for no limit.
+         */
+        void limits (unsigned max_depth,
+                     unsigned max_array_size,
+                     unsigned max_object_size);
+
+        /**
+         * Get an error code and position.
+         * @return An error code and the position in the file/buffer where
+         *         the error was found.
+         */
+        const jparser::error_t get_error () const;
+
+        /**
+         * Get an error message if parsing has failed.
+         * @return An error string if the last parsing failed.
+         *         On successfull parsing an empty string is returned.
+         */
+        const std::string& error () const;
+
+
+    private:
+        void* read_context;
+    };
+
+
+}
+
+#endif
@@ -102,6 +102,7 @@ namespace ujson {
         ref_schemas.clear ();
         id_alias.clear ();
         load_ctx.obj().clear ();
+        have_invalid_ref_cb = false;
 
         initialize (root_arg);
     }
@@ -170,6 +171,9 @@ namespace ujson {
             add_alias = true;
         }
 
+        // References may resolve differently when the schema is added
+        dynamic_cast<schema::jvocabulary_core&>(*vocabularies.front().second).clear_ref_cache ();
+
         try {
             ref_schemas.emplace_back (std::move(ref_schema));
             load (ref_schemas.back());
@@ -199,6 +203,16 @@ namespace ujson {
     void jschema::set_invalid_ref_cb (schema::jvocabulary_core::invalid_ref_cb_t cb)
     {
         dynamic_cast<schema::jvocabulary_core&>(*vocabularies.front().second).set_invalid_ref_cb (cb);
+        have_invalid_ref_cb = static_cast<bool> (cb);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jschema::threads (unsigned num_threads_arg, size_t min_elements)
+    {
+        num_threads = num_threads_arg;
+        parallel_min_elements = min_elements;
     }
 
 
@@ -244,7 +258,7 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue jschema::validate (jvalue& instance)
+    jvalue jschema::validate (const jvalue& instance) const
     {
         return validate (instance, true);
     }
@@ -252,9 +266,31 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue jschema::validate (jvalue& instance, bool quit_on_first_error)
+    jvalue jschema::validate (const jvalue& instance, bool quit_on_first_error) const
+    {
+        return validate (instance, quit_on_first_error, nullptr);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jschema::validate (const jvalue& instance,
+                              bool quit_on_first_error,
+                              schema::validation_profile& profile) const
+    {
+        return validate (instance, quit_on_first_error, &profile);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jschema::validate (const jvalue& instance,
+                              bool quit_on_first_error,
+                              schema::validation_profile* profile) const
     {
         schema::validation_context ctx;
+        ctx.parallel = num_threads != 1  &&  !have_invalid_ref_cb;
+        ctx.profile = profile;
         validate (ctx, root, instance, quit_on_first_error);
 
         if (ctx.output_unit["valid"].boolean()) {
@@ -269,16 +305,44 @@ namespace ujson {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jschema::is_valid (const jvalue& instance) const
+    {
+        return is_valid (instance, nullptr);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jschema::is_valid (const jvalue& instance, schema::validation_profile& profile) const
+    {
+        return is_valid (instance, &profile);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jschema::is_valid (const jvalue& instance, schema::validation_profile* profile) const
+    {
+        schema::validation_context ctx (false);
+        ctx.parallel = num_threads != 1  &&  !have_invalid_ref_cb;
+        ctx.profile = profile;
+        return validate (ctx, root, instance, true);
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jschema::validate (schema::validation_context& ctx,
-                            jvalue& schema,
-                            jvalue& instance,
-                            bool quit_on_first_error)
+                            const jvalue& schema,
+                            const jvalue& instance,
+                            bool quit_on_first_error) const
     {
         // Handle boolean schemas
         if (schema.type() == j_bool) {
-            ctx.output_unit["valid"] = schema.boolean ();
+            if (ctx.build_output)
+                ctx.output_unit["valid"] = schema.boolean ();
             return schema.boolean ();
         }
 
@@ -21,6 +21,7 @@
 
 #include <ujson/invalid_schema.hpp>
 #include <ujson/schema/validation_context.hpp>
+#include <ujson/schema/validation_profile.hpp>
 #include <ujson/schema/jvocabulary.hpp>
 #include <ujson/schema/jvocabulary_core.hpp>
 #include <string>
@@ -37,6 +38,12 @@ namespace ujson {
      * This class represents a JSON schema that
      * may be used to validate JSON instances.
      * Currently, only JSON Schema version 2020-12 is supported by this class.
+     * <br/>
+     * Validation doesn't modify the schema or the instance. A loaded
+     * schema may be used by several threads to validate instances at
+     * the same time, as long as no schema definition is added, or the
+     * schema is reset, while validating. This includes schema
+     * definitions added by an invalid reference callback.
      */
     class jschema {
     public:
@@ -118,6 +125,27 @@ namespace ujson {
          */
         void set_invalid_ref_cb (schema::jvocabulary_core::invalid_ref_cb_t cb);
 
+        /**
+         * Validate the children of large arrays and objects using multiple threads.
+         * When keywords "prefixItems", "items", "contains", "properties"
+         * or "additionalProperties" are applied to an instance with at
+         * least <code>min_elements</code> children, the children are
+         * validated in parallel. The result, and the output unit, are
+         * the same as when validated by a single thread.
+         * <br/>
+         * Children of children are validated by the same thread.
+         * Parallel validation is not used while a callback for
+         * invalid references is set, since the callback may add
+         * schema definitions.
+         * <br/>
+         * By default instances are validated by a single thread.
+         * @param num_threads The number of threads. 0 means the number
+         *                    of hardware threads, 1 disables parallel validation.
+         * @param min_elements Arrays and objects with fewer children
+         *                     are validated by a single thread.
+         */
+        void threads (unsigned num_threads, size_t min_elements=1024);
+
         /**
          * Validate a JSON instance using this schema.
          * The JSON instance will be validated using the root schema definition,
@@ -138,7 +166,7 @@ namespace ujson {
          *                              definition is invalid (if, for instance,
          *                              a "$dynamicRef" can't be dereferenced).
          */
-        jvalue validate (jvalue& instance);
+        jvalue validate (const jvalue& instance) const;
 
         /**
          * Validate a JSON instance using this schema.
@@ -166,7 +194,58 @@ namespace ujson {
          *                              definition is invalid (if, for instance,
          *                              a "$dynamicRef" can't be dereferenced).
          */
-        jvalue validate (jvalue& instance, bool quit_on_first_error);
+        jvalue validate (const jvalue& instance, bool quit_on_first_error) const;
+
+        /**
+         * Check if a JSON instance is valid according to this schema.
+         * This is faster than calling <code>validate()</code> since no
+         * output unit is created, and validation stops at the first
+         * failed test. Annotations are only collected as needed by
+         * the validation itself.
+         * @param instance The JSON instance to validate.
+         * @return <code>true</code> if the instance was
+         *         successfully validated.
+         * @throw ujson::invalid_schema If the JSON Schema
+         *                              definition is invalid (if, for instance,
+         *                              a "$dynamicRef" can't be dereferenced).
+         */
+        bool is_valid (const jvalue& instance) const;
+
+        /**
+         * Validate a JSON instance and collect statistics of the validation.
+         * Same as <code>validate(instance, quit_on_first_error)</code>,
+         * but also records how many times each keyword and subschema
+         * is evaluated, the results, and the time spent, in a profile.
+         * The statistics are added to the statistics already in the profile.
+         * @param instance The JSON instance to validate.
+         * @param quit_on_first_error If <code>true</code>, quit validation on first error.
+         * @param profile Statistics of the validation are added to this object.
+         * @return A JSON Schema Output Unit.
+         * @throw ujson::invalid_schema If the JSON Schema
+         *                              definition is invalid (if, for instance,
+         *                              a "$dynamicRef" can't be dereferenced).
+         * @see ujson::schema::validation_profile
+         */
+        jvalue validate (const jvalue& instance,
+                         bool quit_on_first_error,
+                         schema::validation_profile& profile) const;
+
+        /**
+         * Check if a JSON instance is valid and collect statistics of the validation.
+         * Same as <code>is_valid(instance)</code>, but also records
+         * how many times each keyword and subschema is evaluated,
+         * the results, and the time spent, in a profile.
+         * The statistics are added to the statistics already in the profile.
+         * @param instance The JSON instance to validate.
+         * @param profile Statistics of the validation are added to this object.
+         * @return <code>true</code> if the instance was
+         *         successfully validated.
+         * @throw ujson::invalid_schema If the JSON Schema
+         *                              definition is invalid (if, for instance,
+         *                              a "$dynamicRef" can't be dereferenced).
+         * @see ujson::schema::validation_profile
+         */
+        bool is_valid (const jvalue& instance, schema::validation_profile& profile) const;
 
         /**
          * Return a pointer to a JSON Schema Vocabulary used by the schema.
@@ -184,10 +263,15 @@ namespace ujson {
         virtual void load (jvalue& schema);
         virtual void init_vocabularies ();
 
+        jvalue validate (const jvalue& instance,
+                         bool quit_on_first_error,
+                         schema::validation_profile* profile) const;
+        bool is_valid (const jvalue& instance, schema::validation_profile* profile) const;
+
         bool validate (schema::validation_context& ctx,
-                       jvalue& schema,
-                       jvalue& instance,
-                       bool quit_on_first_error);
+                       const jvalue& schema,
+                       const jvalue& instance,
+                       bool quit_on_first_error) const;
 
         multimap_list<std::string, std::shared_ptr<schema::jvocabulary>> vocabularies;
         jvalue root; // Root schema definition
@@ -196,6 +280,10 @@ namespace ujson {
 
         //          alias         id
         std::map<std::string, std::string> id_alias;
+
+        unsigned num_threads {1};
+        size_t parallel_min_elements {1024};
+        bool have_invalid_ref_cb {false};
     };
 
 
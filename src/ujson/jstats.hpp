@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JSTATS_HPP
+#define UJSON_JSTATS_HPP
+
+#include <ujson/config.hpp>
+#include <ujson/jtokenizer.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+
+namespace ujson {
+
+
+    /**
+     * Statistics about a parsed or written JSON document.
+     * The statistics of a parsed document are returned by
+     * jparser::stats(), and of a written document by
+     * jvalue::describe(desc_format_t, jstats&).
+     * <br/>
+     * Statistics are only collected if libujson is built with
+     * cmake option <code>COLLECT_STATS</code>, otherwise all
+     * values are zero (and <code>UJSON_COLLECT_STATS</code>
+     * is defined to 0 in ujson/config.hpp).
+     */
+    struct jstats {
+        /**
+         * Number of bytes parsed or written.
+         */
+        size_t bytes {0};
+
+        /**
+         * Number of tokens of each type, indexed
+         * by ujson::parser::jtoken::type_t.
+         */
+        std::array<size_t, parser::jtoken::tk_comment+1> tokens {};
+
+        /**
+         * Maximum nesting depth of arrays and objects.
+         * A document without arrays and objects has depth 0.
+         */
+        unsigned max_depth {0};
+
+        /**
+         * Number of items in the largest array.
+         */
+        size_t max_array_size {0};
+
+        /**
+         * Number of members in the largest object.
+         */
+        size_t max_object_size {0};
+
+        /**
+         * Number of strings and object member names with escape
+         * sequences. When parsing, a string split in several parts
+         * in relaxed mode counts each part with escape sequences.
+         */
+        size_t escaped_strings {0};
+
+        /**
+         * Number of numbers stored as an <code>mpf_class</code>.
+         * Always 0 if libujson is built without gmpxx.
+         */
+        size_t mpf_numbers {0};
+
+        /**
+         * Estimated number of memory allocations.
+         * When parsing, this is one for each array and object,
+         * one for the items of each non-empty array or object,
+         * one for each number stored as an <code>mpf_class</code>,
+         * and one for each string, or member name, that is too
+         * long to be stored within a <code>std::string</code>.
+         * Allocations of interned member names are not counted.
+         * <br/>
+         * When writing, this is the number of times the output
+         * string is grown, assuming its capacity is doubled
+         * each time.
+         */
+        size_t allocations {0};
+
+        /**
+         * Time spent finding tokens in the parsed text.
+         * Not used when writing.
+         */
+        std::chrono::nanoseconds tokenize_time {0};
+
+        /**
+         * Time spent building the parsed values,
+         * or writing the output.
+         */
+        std::chrono::nanoseconds build_time {0};
+    };
+
+
+}
+#endif
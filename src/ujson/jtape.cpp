@@ -0,0 +1,816 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/config.hpp>
+#include <ujson/jtape.hpp>
+#include <ujson/file_view.hpp>
+#include <ujson/json_type_error.hpp>
+#include <ujson/internal.hpp>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+
+
+namespace ujson {
+
+
+    //
+    // Tape layout:
+    //   header_t    The header, with the size of each section.
+    //   record_t[]  One record for each JSON value. Record 0 is the root value.
+    //   uint32_t[]  The member indexes of the objects.
+    //   char[]      The string pool, null terminated strings.
+    //
+    // The items of an array are stored as consecutive records. The
+    // members of an object are stored in document order, after a
+    // member index record, as consecutive pairs of records, the member
+    // name followed by the member value. The member index of an object
+    // is the numbers of its members sorted by name, members with the
+    // same name in document order, and is used for a binary search.
+    // Containers are written breadth first, so the records of the
+    // items in a container always come after the container itself.
+    //
+    static constexpr char     tape_magic[8]   = {'u','j','t','a','p','e','\0','\0'};
+    static constexpr uint32_t tape_version    = 2;
+    static constexpr uint32_t tape_byte_order = 0x01020304;
+
+    struct header_t {
+        char     magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t num_records;
+        uint64_t index_size;
+        uint64_t pool_size;
+    };
+    static_assert (sizeof(header_t) == 40);
+
+    // Record kinds
+    enum : uint8_t {
+        rec_invalid = 0,
+        rec_null,
+        rec_false,
+        rec_true,
+        rec_integer,     // value: The integer
+        rec_real,        // value: The bits of a double
+        rec_number_text, // size: Length of the number, value: Offset in the pool
+        rec_string,      // size: Length of the string, value: Offset in the pool
+        rec_array,       // size: Number of items, value: Index of the first item record
+        rec_object,      // size: Number of members, value: Index of the member index record
+        rec_member_index, // size: Number of members, value: Offset of the member index
+    };
+
+
+    struct jtape::record_t {
+        uint8_t  kind;
+        uint8_t  reserved[3];
+        uint32_t size;
+        uint64_t value;
+    };
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    [[noreturn]] static void invalid_tape (const char* what)
+    {
+        throw std::invalid_argument (std::string("Invalid tape: ") + what);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Build the records and the string pool of a tape.
+    //--------------------------------------------------------------------------
+    class jtape_writer {
+    public:
+        void write (const jvalue& instance, std::string& out);
+        void write (const jvalue& instance, std::ostream& out);
+
+        void integer (long n);
+        void real (double n);
+        void number_text (std::string_view str);
+
+    private:
+        using record_t = jtape::record_t;
+
+        void build (const jvalue& instance);
+        void add_record (const jvalue& value);
+        void add_string (uint8_t kind, std::string_view str, bool shared);
+        void add_items (record_t& r, const jvalue& value);
+        void add_members (record_t& r, const jvalue& value);
+        header_t header () const;
+
+        std::vector<record_t> records;
+        std::vector<uint32_t> index;
+        std::string pool;
+        std::unordered_map<std::string_view, uint64_t> shared_strings;
+        std::vector<std::pair<size_t, const jvalue*>> pending; // Containers to fill in
+        std::vector<std::pair<std::string_view, const jvalue*>> members;
+    };
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::integer (long n)
+    {
+        auto& r = records.back ();
+        r.kind = rec_integer;
+        r.value = (uint64_t) n;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::real (double n)
+    {
+        auto& r = records.back ();
+        r.kind = rec_real;
+        memcpy (&r.value, &n, sizeof(r.value));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::number_text (std::string_view str)
+    {
+        add_string (rec_number_text, str, false);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Store a string in the pool, and set the last record to refer to it.
+    // A shared string, a member name, is only stored once, and must be
+    // kept until the tape is written.
+    //--------------------------------------------------------------------------
+    void jtape_writer::add_string (uint8_t kind, std::string_view str, bool shared)
+    {
+        if (str.size() > std::numeric_limits<uint32_t>::max())
+            throw std::length_error ("String too large to be stored in a tape");
+
+        uint64_t offset = pool.size ();
+        if (shared) {
+            auto result = shared_strings.emplace (str, offset);
+            if (!result.second)
+                offset = result.first->second; // Already in the pool
+        }
+        if (offset == pool.size()) {
+            pool.append (str);
+            pool.push_back ('\0');
+        }
+
+        auto& r = records.back ();
+        r.kind = kind;
+        r.size = (uint32_t) str.size ();
+        r.value = offset;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Add the record of a value. The items of an array
+    // or object are added later, breadth first.
+    //--------------------------------------------------------------------------
+    void jtape_writer::add_record (const jvalue& value)
+    {
+        records.push_back (record_t{});
+        auto& r = records.back ();
+        switch (value.type()) {
+        case j_object:
+        case j_array:
+            r.kind = value.type()==j_object ? rec_object : rec_array;
+            pending.emplace_back (records.size()-1, &value);
+            break;
+        case j_string:
+            add_string (rec_string, value.str_view(), false);
+            break;
+        case j_number:
+            number_to_tape (value, *this);
+            break;
+        case j_bool:
+            r.kind = value.boolean() ? rec_true : rec_false;
+            break;
+        case j_null:
+        default:
+            r.kind = rec_null;
+            break;
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::add_items (record_t& r, const jvalue& value)
+    {
+        auto& items = value.array ();
+        size_t n = 0;
+        for (auto& item : items)
+            n += item.valid() ? 1 : 0;
+        if (n > std::numeric_limits<uint32_t>::max())
+            throw std::length_error ("Array too large to be stored in a tape");
+
+        r.size = (uint32_t) n;
+        r.value = records.size ();
+        for (auto& item : items) {
+            if (item.valid())
+                add_record (item);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::add_members (record_t& r, const jvalue& value)
+    {
+        members.clear ();
+        for (auto& member : value.obj()) {
+            if (member.second.valid()) {
+                const std::string& name = member.first;
+                members.emplace_back (name, &member.second);
+            }
+        }
+        if (members.size() > std::numeric_limits<uint32_t>::max())
+            throw std::length_error ("Object too large to be stored in a tape");
+
+        r.size = (uint32_t) members.size ();
+        r.value = records.size ();
+
+        // The member index, members with the same name in document order
+        auto& ir = records.emplace_back ();
+        ir.kind = rec_member_index;
+        ir.size = r.size;
+        ir.value = index.size ();
+        size_t first = index.size ();
+        for (uint32_t i=0; i<r.size; ++i)
+            index.push_back (i);
+        std::stable_sort (index.begin()+first, index.end(), [this](uint32_t lhs, uint32_t rhs) {
+                return members[lhs].first < members[rhs].first;
+            });
+
+        for (auto& member : members) {
+            records.push_back (record_t{});
+            add_string (rec_string, member.first, true);
+            add_record (*member.second);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::build (const jvalue& instance)
+    {
+        if (instance.invalid())
+            throw std::invalid_argument ("Invalid JSON value");
+
+        add_record (instance);
+
+        // Fill in the containers in the order they were added, so the
+        // items of a container are stored after the container itself
+        for (size_t i=0; i<pending.size(); ++i) {
+            auto [index, value] = pending[i];
+            // Copy the record, adding items may reallocate the records
+            record_t r = records[index];
+            if (value->type() == j_object)
+                add_members (r, *value);
+            else
+                add_items (r, *value);
+            records[index] = r;
+        }
+        pending.clear ();
+        pending.shrink_to_fit ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    header_t jtape_writer::header () const
+    {
+        header_t h;
+        memcpy (h.magic, tape_magic, sizeof(h.magic));
+        h.version = tape_version;
+        h.byte_order = tape_byte_order;
+        h.num_records = records.size ();
+        h.index_size = index.size ();
+        h.pool_size = pool.size ();
+        return h;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::write (const jvalue& instance, std::string& out)
+    {
+        build (instance);
+        auto h = header ();
+        out.reserve (out.size() + sizeof(h) + records.size()*sizeof(record_t)
+                     + index.size()*sizeof(uint32_t) + pool.size());
+        out.append (reinterpret_cast<const char*>(&h), sizeof(h));
+        out.append (reinterpret_cast<const char*>(records.data()), records.size()*sizeof(record_t));
+        out.append (reinterpret_cast<const char*>(index.data()), index.size()*sizeof(uint32_t));
+        out.append (pool);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtape_writer::write (const jvalue& instance, std::ostream& out)
+    {
+        build (instance);
+        auto h = header ();
+        out.write (reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write (reinterpret_cast<const char*>(records.data()), records.size()*sizeof(record_t));
+        out.write (reinterpret_cast<const char*>(index.data()), index.size()*sizeof(uint32_t));
+        out.write (pool.data(), pool.size());
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Store a JSON number in the last record of a tape.
+    //--------------------------------------------------------------------------
+    void number_to_tape (const jvalue& value, jtape_writer& out)
+    {
+        if (value.repr == jvalue::num_text) {
+            out.number_text (value.v.jstr);
+            return;
+        }
+#if UJSON_HAVE_GMPXX
+        switch (value.repr) {
+        case jvalue::num_long:
+            out.integer (value.v.jlong);
+            break;
+        case jvalue::num_dbl:
+            out.real (value.v.jdbl);
+            break;
+        default:
+            // Keep the precision of the mpf_class
+            out.number_text (value.describe());
+        }
+#else
+        out.real (value.v.jnum);
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void to_tape (const jvalue& instance, std::string& out)
+    {
+        jtape_writer writer;
+        writer.write (instance, out);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string to_tape (const jvalue& instance)
+    {
+        std::string out;
+        to_tape (instance, out);
+        return out;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void to_tape (const jvalue& instance, std::ostream& out)
+    {
+        jtape_writer writer;
+        writer.write (instance, out);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::jtape (const std::string& file_name)
+    {
+        // The tape is read in random order
+        file = std::make_shared<file_view> (file_name, false);
+        if (!file->good())
+            throw std::invalid_argument (std::string("Can't read file '") + file_name + "'");
+        buf = file->data().data ();
+        buf_size = file->data().size ();
+        open ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::jtape (const void* data, size_t size)
+        : buf (reinterpret_cast<const char*>(data)),
+          buf_size (size)
+    {
+        open ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Check the header. The records are checked when they are used.
+    //--------------------------------------------------------------------------
+    void jtape::open ()
+    {
+        header_t h;
+        if (buf_size < sizeof(h))
+            invalid_tape ("Missing header");
+        memcpy (&h, buf, sizeof(h));
+        if (memcmp(h.magic, tape_magic, sizeof(h.magic)))
+            invalid_tape ("Not a tape");
+        if (h.byte_order != tape_byte_order)
+            invalid_tape ("Wrong byte order");
+        if (h.version != tape_version)
+            invalid_tape ("Unsupported version");
+
+        size_t left = buf_size - sizeof(h);
+        if (h.num_records == 0  ||  h.num_records > left / sizeof(record_t))
+            invalid_tape ("Wrong number of records");
+        left -= h.num_records * sizeof(record_t);
+        if (h.index_size > left / sizeof(uint32_t))
+            invalid_tape ("Wrong index size");
+        left -= h.index_size * sizeof(uint32_t);
+        if (h.pool_size != left)
+            invalid_tape ("Wrong size");
+
+        num_records = h.num_records;
+        index_offset = sizeof(header_t) + num_records*sizeof(record_t);
+        index_size = h.index_size;
+        pool_offset = buf_size - h.pool_size;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::record_t jtape::record (uint64_t index) const
+    {
+        static_assert (sizeof(record_t) == 16);
+        if (index >= num_records)
+            invalid_tape ("Record out of range");
+        record_t r;
+        memcpy (&r, buf + sizeof(header_t) + index*sizeof(record_t), sizeof(r));
+        return r;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string_view jtape::text (const record_t& r) const
+    {
+        uint64_t pool_size = buf_size - pool_offset;
+        if (r.value >= pool_size  ||  r.size >= pool_size - r.value)
+            invalid_tape ("String out of range");
+        return std::string_view (buf + pool_offset + r.value, r.size);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    uint32_t jtape::member_index (uint64_t offset) const
+    {
+        if (offset >= index_size)
+            invalid_tape ("Member index out of range");
+        uint32_t n;
+        memcpy (&n, buf + index_offset + offset*sizeof(n), sizeof(n));
+        return n;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Return the index of the first record of the items in a container.
+    // Items are always stored after the container, so a damaged
+    // tape can't make a container contain itself.
+    //--------------------------------------------------------------------------
+    static uint64_t first_item (uint64_t first, uint64_t index, uint64_t num_records, uint64_t n)
+    {
+        if (first <= index  ||  first > num_records  ||  n > num_records - first)
+            invalid_tape ("Item out of range");
+        return first;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Return the index of the first member name record of an object
+    // record, and the offset of its member index in 'sorted'.
+    //--------------------------------------------------------------------------
+    uint64_t jtape::members (const record_t& r, uint64_t index, uint64_t& sorted) const
+    {
+        uint64_t first = first_item (r.value, index, num_records, 2*(uint64_t)r.size + 1);
+        auto ir = record (first);
+        if (ir.kind != rec_member_index  ||  ir.size != r.size  ||
+            ir.value > index_size  ||  ir.size > index_size - ir.value)
+        {
+            invalid_tape ("Invalid member index");
+        }
+        sorted = ir.value;
+        return first + 1;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue_type jtape::node::type () const
+    {
+        if (!tape)
+            return j_invalid;
+        switch (tape->record(index).kind) {
+        case rec_null:
+            return j_null;
+        case rec_false:
+        case rec_true:
+            return j_bool;
+        case rec_integer:
+        case rec_real:
+        case rec_number_text:
+            return j_number;
+        case rec_string:
+            return j_string;
+        case rec_array:
+            return j_array;
+        case rec_object:
+            return j_object;
+        default:
+            invalid_tape ("Unknown record");
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jtape::node::boolean () const
+    {
+        auto kind = tape ? tape->record(index).kind : rec_invalid;
+        if (kind!=rec_true && kind!=rec_false)
+            throw json_type_error ("Not a JSON boolean");
+        return kind == rec_true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    double jtape::node::num () const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        switch (r.kind) {
+        case rec_integer:
+            return (double) (long) r.value;
+        case rec_real:
+            {
+                double n;
+                memcpy (&n, &r.value, sizeof(n));
+                return n;
+            }
+        case rec_number_text:
+            return value().num ();
+        default:
+            throw json_type_error ("Not a JSON number");
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string_view jtape::node::str_view () const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        if (r.kind != rec_string)
+            throw json_type_error ("Not a JSON string");
+        return tape->text (r);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    size_t jtape::node::size () const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        if (r.kind!=rec_array && r.kind!=rec_object)
+            throw json_type_error ("Not a JSON object or array");
+        return r.size;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::node jtape::node::operator[] (const size_t n) const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        if (r.kind != rec_array)
+            throw json_type_error ("Not a JSON array");
+        if (n >= r.size)
+            throw std::out_of_range ("Index out of range");
+        return node (tape, first_item(r.value, index, tape->num_records, r.size) + n);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::node jtape::node::get (std::string_view name) const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        if (r.kind != rec_object)
+            throw json_type_error ("Not a JSON object");
+
+        // Find the last member in the member index with
+        // a name not greater than the searched name
+        uint64_t sorted;
+        uint64_t first = tape->members (r, index, sorted);
+        auto member_at = [&](uint64_t i) -> uint64_t {
+            uint32_t n = tape->member_index (sorted + i);
+            if (n >= r.size)
+                invalid_tape ("Member index out of range");
+            return first + 2*(uint64_t)n;
+        };
+        uint64_t lo = 0;
+        uint64_t hi = r.size;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (name < tape->text(tape->record(member_at(mid))))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        if (lo == 0)
+            return node ();
+        uint64_t name_index = member_at (lo - 1);
+        if (tape->text(tape->record(name_index)) != name)
+            return node ();
+        return node (tape, name_index + 1);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jtape::node::has (std::string_view name) const
+    {
+        return type()==j_object && get(name).valid();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string_view jtape::node::member_name (const size_t n) const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        if (r.kind != rec_object)
+            throw json_type_error ("Not a JSON object");
+        if (n >= r.size)
+            throw std::out_of_range ("Index out of range");
+        uint64_t sorted;
+        uint64_t first = tape->members (r, index, sorted);
+        auto name = tape->record (first + 2*n);
+        if (name.kind != rec_string)
+            invalid_tape ("Member name is not a string");
+        return tape->text (name);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::node jtape::node::member (const size_t n) const
+    {
+        record_t r {};
+        if (tape)
+            r = tape->record (index);
+        if (r.kind != rec_object)
+            throw json_type_error ("Not a JSON object");
+        if (n >= r.size)
+            throw std::out_of_range ("Index out of range");
+        uint64_t sorted;
+        return node (tape, tape->members(r, index, sorted) + 2*n + 1);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::node jtape::node::find (const jpointer& pointer) const
+    {
+        node value = *this;
+        for (auto& token : pointer) {
+            size_t i;
+            auto t = value.type ();
+            if (t == j_object)
+                value = value.get (token);
+            else if (t == j_array && parse_array_index(token, i) && i < value.size())
+                value = value[i];
+            else
+                value = node ();
+            if (value.invalid())
+                break;
+        }
+        return value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jtape::node jtape::node::find (const compiled_jpointer& pointer) const
+    {
+        node value = *this;
+        for (auto& token : pointer) {
+            auto t = value.type ();
+            if (t == j_object)
+                value = value.get (token.name);
+            else if (t == j_array && token.is_index && token.index < value.size())
+                value = value[token.index];
+            else
+                value = node ();
+            if (value.invalid())
+                break;
+        }
+        return value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jtape::node::value () const
+    {
+        jvalue result (j_invalid);
+        if (!tape)
+            return result;
+
+        auto r = tape->record (index);
+        switch (r.kind) {
+        case rec_null:
+            result.type (j_null);
+            break;
+        case rec_false:
+        case rec_true:
+            result.boolean (r.kind == rec_true);
+            break;
+        case rec_integer:
+            result.num ((long) r.value);
+            break;
+        case rec_real:
+            number_from_double (num(), result);
+            break;
+        case rec_number_text:
+            try {
+                number_from_string (std::string(tape->text(r)), result);
+            }
+            catch (std::exception&) {
+                invalid_tape ("Invalid number");
+            }
+            break;
+        case rec_string:
+            result.str (std::string(tape->text(r)));
+            break;
+        case rec_array:
+            {
+                result.type (j_array);
+                uint64_t first = first_item (r.value, index, tape->num_records, r.size);
+                auto& items = result.array ();
+                items.reserve (r.size);
+                for (uint64_t i=0; i<r.size; ++i)
+                    items.emplace_back (node(tape, first+i).value());
+            }
+            break;
+        case rec_object:
+            {
+                result.type (j_object);
+                auto& members = result.obj ();
+                uint64_t sorted;
+                uint64_t first = tape->members (r, index, sorted);
+                for (uint64_t i=0; i<r.size; ++i) {
+                    auto name = tape->record (first + 2*i);
+                    if (name.kind != rec_string)
+                        invalid_tape ("Member name is not a string");
+                    members.emplace_back (json_key(tape->text(name)),
+                                          node(tape, first+2*i+1).value());
+                }
+            }
+            break;
+        default:
+            invalid_tape ("Unknown record");
+        }
+        return result;
+    }
+
+
+}
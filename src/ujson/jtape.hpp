@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JTAPE_HPP
+#define UJSON_JTAPE_HPP
+
+#include <ujson/jvalue.hpp>
+#include <ujson/jpointer.hpp>
+#include <ujson/compiled_jpointer.hpp>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace ujson {
+
+
+    class file_view;
+
+
+    /**
+     * Write a JSON instance in tape format, see class ujson::jtape.
+     * Invalid values in objects and arrays (of type ujson::j_invalid)
+     * are omitted.
+     * @param instance The JSON instance to write.
+     * @param out The string to append the tape to.
+     * @throw std::invalid_argument If the instance is an invalid
+     *                              JSON value (of type ujson::j_invalid).
+     * @throw std::length_error If a string, an object, or an array
+     *                          is too large to be stored in a tape
+     *                          (4 GiB, or 2<sup>32</sup>-1 items).
+     */
+    void to_tape (const jvalue& instance, std::string& out);
+
+    /**
+     * Write a JSON instance in tape format, see class ujson::jtape.
+     * @param instance The JSON instance to write.
+     * @return A string with the tape.
+     * @see ujson::to_tape(const jvalue&, std::string&)
+     */
+    std::string to_tape (const jvalue& instance);
+
+    /**
+     * Write a JSON instance in tape format to an output stream,
+     * see class ujson::jtape.
+     * @param instance The JSON instance to write.
+     * @param out The output stream to write to.
+     * @see ujson::to_tape(const jvalue&, std::string&)
+     */
+    void to_tape (const jvalue& instance, std::ostream& out);
+
+
+    /**
+     * A read-only view of a JSON instance stored in tape format.
+     * A tape is written by ujson::to_tape(), and can be read
+     * directly from memory, or from a memory mapped file, without
+     * parsing or copying it. Opening a tape takes constant time,
+     * and only the parts of it that are accessed are read, so a
+     * large read-only document can be loaded in milliseconds, and
+     * the memory pages of a file are shared by all processes that
+     * map it.
+     * <br/>
+     * The tape is position independent, and consists of a header,
+     * an array of fixed size records, one for each JSON value, the
+     * member indexes of the objects, and a pool of strings. The items
+     * of an array, and the members of an object, are stored as
+     * consecutive records, so any item is found in constant time.
+     * Object members are kept in document order, and are found by
+     * name using a binary search in the member index of the object,
+     * where they are sorted by name. Member names that occur more
+     * than once are only stored once.
+     * Numbers are stored as integers or doubles when that can be
+     * done without losing precision, otherwise as text.
+     * The tape is stored in native byte order, and can't be read
+     * on a computer with a different byte order.
+     * <br/>
+     * A tape is checked when it is opened, and every record is
+     * checked when it is accessed, so a damaged tape can't make the
+     * view read outside the tape. Access to a damaged record throws
+     * std::invalid_argument.
+     * <br/>
+     * A jtape object may be copied, the copies share the same data,
+     * and it may be used by several threads at the same time.
+     * \par Example:
+     * \code
+     * // Once, when the reference data is updated
+     * std::ofstream ("data.tape") << ujson::to_tape (instance);
+     *
+     * // At startup
+     * ujson::jtape tape ("data.tape");
+     * auto port = tape.find (ujson::jpointer("/servers/0/port"));
+     * if (port.valid())
+     *     std::cout << port.num() << std::endl;
+     * \endcode
+     * @see ujson::to_tape()
+     */
+    class jtape {
+    public:
+        /**
+         * A JSON value in a tape.
+         * This is a small value type that refers to a record in the
+         * tape. It is only valid as long as the jtape object it was
+         * returned from exists. The methods have the same names, and
+         * throw the same exceptions, as the methods in class
+         * ujson::jvalue.
+         */
+        class node {
+        public:
+            /**
+             * Default constructor.
+             * Create an invalid node, of type ujson::j_invalid.
+             */
+            node () = default;
+
+            /**
+             * Return the JSON type of the value.
+             * @return The JSON type, or ujson::j_invalid
+             *         if this node doesn't refer to a value.
+             */
+            jvalue_type type () const;
+
+            /**
+             * Return <code>true</code> if this node refers to a value.
+             */
+            bool valid () const {return tape != nullptr;}
+
+            /**
+             * Return <code>true</code> if this node doesn't refer to a value.
+             */
+            bool invalid () const {return tape == nullptr;}
+
+            /**
+             * Return the JSON boolean value.
+             * @throw ujson::json_type_error If this is not a JSON boolean.
+             */
+            bool boolean () const;
+
+            /**
+             * Return the JSON number value as a <code>double</code>.
+             * Use node::value() to get a number stored as text
+             * with its full precision.
+             * @throw ujson::json_type_error If this is not a JSON number.
+             */
+            double num () const;
+
+            /**
+             * Return a view of the JSON string value.
+             * The view refers to the tape, and is null terminated.
+             * @throw ujson::json_type_error If this is not a JSON string.
+             */
+            std::string_view str_view () const;
+
+            /**
+             * Return the number of items in an array,
+             * or members in an object.
+             * @throw ujson::json_type_error If this is not
+             *                               a JSON object or array.
+             */
+            size_t size () const;
+
+            /**
+             * Return an item in a JSON array.
+             * @param n The index of the item.
+             * @throw ujson::json_type_error If this is not a JSON array.
+             * @throw std::out_of_range If the index is out of range.
+             */
+            node operator[] (const size_t n) const;
+
+            /**
+             * Return a member of a JSON object.
+             * If the object has more than one member with the name,
+             * the last of them is returned, as by jvalue::get().
+             * @param name The name of the object member.
+             * @return The member value, or an invalid node if not found.
+             * @throw ujson::json_type_error If this is not a JSON object.
+             */
+            node get (std::string_view name) const;
+
+            /**
+             * Check if this is a JSON object with a named member.
+             * @param name The name of the object member.
+             * @return <code>true</code> if this is a JSON object
+             *         with a member of the given name.
+             */
+            bool has (std::string_view name) const;
+
+            /**
+             * Return the name of a member in a JSON object.
+             * Members are in document order, this is used together
+             * with node::member() to iterate over an object.
+             * @param n The index of the member, less than node::size().
+             * @throw ujson::json_type_error If this is not a JSON object.
+             * @throw std::out_of_range If the index is out of range.
+             */
+            std::string_view member_name (const size_t n) const;
+
+            /**
+             * Return the value of a member in a JSON object.
+             * @param n The index of the member, less than node::size().
+             * @throw ujson::json_type_error If this is not a JSON object.
+             * @throw std::out_of_range If the index is out of range.
+             */
+            node member (const size_t n) const;
+
+            /**
+             * Find a value using a JSON pointer, relative to this value.
+             * @param pointer A JSON pointer.
+             * @return The value, or an invalid node if not found.
+             */
+            node find (const jpointer& pointer) const;
+
+            /**
+             * Find a value using a compiled JSON pointer,
+             * relative to this value.
+             * @param pointer A compiled JSON pointer.
+             * @return The value, or an invalid node if not found.
+             */
+            node find (const compiled_jpointer& pointer) const;
+
+            /**
+             * Copy the value, and all values in it, to a jvalue.
+             * Object members are added in document order.
+             * @return A jvalue equal to the value written to the tape,
+             *         or an invalid jvalue if this node is invalid.
+             */
+            jvalue value () const;
+
+
+        private:
+            friend class jtape;
+            node (const jtape* t, uint64_t i) : tape(t), index(i) {}
+            const jtape* tape {nullptr};
+            uint64_t index {0};
+        };
+
+
+        /**
+         * Open a tape in a file.
+         * Regular files are memory mapped, other files are
+         * read into a buffer.
+         * @param file_name The name of the file.
+         * @throw std::invalid_argument If the file can't be read,
+         *                              or isn't a tape.
+         */
+        jtape (const std::string& file_name);
+
+        /**
+         * Use a tape in memory.
+         * The data isn't copied, and must be kept
+         * as long as this object is used.
+         * @param data The tape, as written by ujson::to_tape().
+         * @param size The size of the tape.
+         * @throw std::invalid_argument If the data isn't a tape.
+         */
+        jtape (const void* data, size_t size);
+
+        /**
+         * Return the root value of the tape.
+         */
+        node root () const {return node(this, 0);}
+
+        /**
+         * Find a value using a JSON pointer.
+         * @param pointer A JSON pointer.
+         * @return The value, or an invalid node if not found.
+         */
+        node find (const jpointer& pointer) const {return root().find(pointer);}
+
+        /**
+         * Find a value using a compiled JSON pointer.
+         * @param pointer A compiled JSON pointer.
+         * @return The value, or an invalid node if not found.
+         */
+        node find (const compiled_jpointer& pointer) const {return root().find(pointer);}
+
+        /**
+         * Return the tape data.
+         */
+        std::string_view data () const {
+            return std::string_view (buf, buf_size);
+        }
+
+
+    private:
+        friend class jtape_writer;
+        struct record_t;
+        void open ();
+        record_t record (uint64_t index) const;
+        std::string_view text (const record_t& r) const;
+        uint32_t member_index (uint64_t offset) const;
+        uint64_t members (const record_t& r, uint64_t index, uint64_t& sorted) const;
+
+        std::shared_ptr<file_view> file;
+        const char* buf {nullptr};
+        size_t buf_size {0};
+        uint64_t num_records {0};
+        uint64_t index_offset {0};
+        uint64_t index_size {0};
+        uint64_t pool_offset {0};
+    };
+
+
+}
+#endif
@@ -18,6 +18,21 @@
  */
 #include <ujson/jtokenizer.hpp>
 #include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// Use SSE2 to scan blocks of 16 bytes at a time when available.
+// SSE2 is always available on x86-64.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define UJSON_SCAN_SSE2 1
+#  include <emmintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#else
+#  define UJSON_SCAN_SSE2 0
+#endif
 
 #if 1
 #include <iostream>
@@ -46,6 +61,204 @@ namespace ujson::parser {
     };
 
 
+    //--------------------------------------------------------------------------
+    // Characters allowed in a JSON string without the need of special
+    // handling, i.e. printable ASCII characters except '"' and '\\'.
+    //--------------------------------------------------------------------------
+    static inline bool is_plain_string_char (const char ch)
+    {
+        return ch==(char)0x20 ||
+            ch==(char)0x21 ||
+            (ch>=(char)0x23 && ch<=(char)0x5b) ||
+            (ch>=(char)0x5d && ch<=(char)0x7f);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Evaluated without branches, since digits and letters
+    // are mixed unpredictably.
+    //--------------------------------------------------------------------------
+    static inline bool is_hex_digit (const char ch)
+    {
+        return ((unsigned)(ch - '0') < 10) | ((unsigned)((ch|0x20) - 'a') < 6);
+    }
+
+
+#if (UJSON_SCAN_SSE2)
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline unsigned lowest_bit_index (unsigned mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward (&index, mask);
+        return (unsigned) index;
+#else
+        return (unsigned) __builtin_ctz (mask);
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline unsigned highest_bit_index (unsigned mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse (&index, mask);
+        return (unsigned) index;
+#else
+        return 31 - (unsigned) __builtin_clz (mask);
+#endif
+    }
+#endif
+
+
+    //--------------------------------------------------------------------------
+    // Return the number of characters, starting at 'pos', that are
+    // plain string characters (see is_plain_string_char).
+    //--------------------------------------------------------------------------
+    static inline size_t plain_string_chars (const char* pos, const char* const end)
+    {
+        const char* const start = pos;
+#if (UJSON_SCAN_SSE2)
+        const __m128i quote  = _mm_set1_epi8 ('"');
+        const __m128i bslash = _mm_set1_epi8 ('\\');
+        const __m128i space  = _mm_set1_epi8 (0x20);
+        while (end - pos >= 16) {
+            __m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(pos));
+            // A signed compare catches both control
+            // characters and non-ASCII bytes (>=0x80).
+            __m128i special = _mm_or_si128 (_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                         _mm_cmpeq_epi8(block, bslash)),
+                                            _mm_cmpgt_epi8(space, block));
+            unsigned mask = (unsigned) _mm_movemask_epi8 (special);
+            if (mask)
+                return (pos - start) + lowest_bit_index (mask);
+            pos += 16;
+        }
+#else
+        // Check 8 bytes at a time for any special character
+        static constexpr uint64_t ones = 0x0101010101010101ULL;
+        static constexpr uint64_t high = 0x8080808080808080ULL;
+        while (end - pos >= 8) {
+            uint64_t block;
+            memcpy (&block, pos, sizeof(block));
+            uint64_t q = block ^ (ones * '"');  // Zero byte where '"'
+            uint64_t b = block ^ (ones * '\\'); // Zero byte where '\\'
+            if (((q - ones) & ~q & high)            ||
+                ((b - ones) & ~b & high)            ||
+                ((block - ones*0x20) & ~block & high) || // Byte < 0x20
+                (block & high))                          // Byte >= 0x80
+            {
+                break;
+            }
+            pos += 8;
+        }
+#endif
+        while (pos < end && is_plain_string_char(*pos))
+            ++pos;
+        return pos - start;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Return the length of the UTF-8 encoded character at 'pos', or
+    // 0 if it isn't a complete multi-byte character within the buffer.
+    // The lead bytes and continuation bytes accepted are the same as
+    // in jtokenizer::scan_string().
+    //--------------------------------------------------------------------------
+    static inline size_t utf8_char_size (const char* pos, const char* const end)
+    {
+        const unsigned char ch = (unsigned char) *pos;
+        size_t size;
+        if (ch>=0xc2 && ch<=0xdf)
+            size = 2;
+        else if (ch>=0xe0 && ch<=0xef)
+            size = 3;
+        else if (ch>=0xf0 && ch<=0xf4)
+            size = 4;
+        else
+            return 0;
+        if ((size_t)(end - pos) < size)
+            return 0;
+        for (size_t i=1; i<size; ++i) {
+            if ((pos[i] & 0xc0) != 0x80)
+                return 0;
+        }
+        return size;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Return the number of characters, starting at 'pos', that can be
+    // skipped when scanning a string, i.e. plain string characters and
+    // complete UTF-8 encoded multi-byte characters. This stops on a
+    // character boundary at '"', '\\', control characters, and bytes
+    // that aren't valid UTF-8, to let the string scanner handle them.
+    //--------------------------------------------------------------------------
+    static inline size_t string_chars (const char* pos, const char* const end)
+    {
+        const char* const start = pos;
+        while (pos < end) {
+            pos += plain_string_chars (pos, end);
+            if (pos == end  ||  (unsigned char)*pos < 0x80)
+                break;
+#if (UJSON_SCAN_SSE2)
+            // Validate UTF-8 16 bytes at a time. Each byte is classified
+            // as a plain character, a lead byte, or a continuation byte,
+            // and the bytes before the first unclassified byte (e.g. the
+            // terminating '"') are valid if the continuation bytes are
+            // exactly the ones expected after the lead bytes.
+            const __m128i quote  = _mm_set1_epi8 ('"');
+            const __m128i bslash = _mm_set1_epi8 ('\\');
+            while (end - pos >= 16) {
+                __m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(pos));
+                __m128i plain = _mm_andnot_si128 (_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                               _mm_cmpeq_epi8(block, bslash)),
+                                                  _mm_cmpgt_epi8(block, _mm_set1_epi8(0x1f)));
+                __m128i cont  = _mm_cmplt_epi8 (block, _mm_set1_epi8((char)0xc0));
+                __m128i lead2 = _mm_and_si128 (_mm_cmpgt_epi8(block, _mm_set1_epi8((char)0xc1)),
+                                               _mm_cmplt_epi8(block, _mm_set1_epi8((char)0xe0)));
+                __m128i lead3 = _mm_and_si128 (_mm_cmpgt_epi8(block, _mm_set1_epi8((char)0xdf)),
+                                               _mm_cmplt_epi8(block, _mm_set1_epi8((char)0xf0)));
+                __m128i lead4 = _mm_and_si128 (_mm_cmpgt_epi8(block, _mm_set1_epi8((char)0xef)),
+                                               _mm_cmplt_epi8(block, _mm_set1_epi8((char)0xf5)));
+                unsigned m_cont  = (unsigned) _mm_movemask_epi8 (cont);
+                unsigned m_lead2 = (unsigned) _mm_movemask_epi8 (lead2);
+                unsigned m_lead3 = (unsigned) _mm_movemask_epi8 (lead3);
+                unsigned m_lead4 = (unsigned) _mm_movemask_epi8 (lead4);
+                unsigned other   = ~((unsigned)_mm_movemask_epi8(plain) | m_cont |
+                                     m_lead2 | m_lead3 | m_lead4) & 0xffff;
+
+                unsigned len = other ? lowest_bit_index(other) : 16;
+                unsigned in_range = (1u << len) - 1;
+                m_lead3 &= in_range;
+                m_lead4 &= in_range;
+                unsigned m_lead = (m_lead2 | m_lead3 | m_lead4) & in_range;
+                unsigned expected = (m_lead << 1) | ((m_lead3 | m_lead4) << 2) | (m_lead4 << 3);
+                if ((expected & in_range) != (m_cont & in_range))
+                    break;
+                if (expected >> len) {
+                    // The last character continues after the checked bytes
+                    pos += highest_bit_index (m_lead);
+                }else{
+                    pos += len;
+                }
+                if (len < 16)
+                    break;
+            }
+#endif
+            // Check one character at a time
+            size_t size;
+            while (pos < end  &&  (size = utf8_char_size(pos, end)) > 0)
+                pos += size;
+            if (pos == end  ||  !is_plain_string_char(*pos))
+                break;
+        }
+        return pos - start;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     std::string jtoken_type_to_string (const jtoken::type_t type)
@@ -86,31 +299,42 @@ namespace ujson::parser {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jtokenizer::jtokenizer ()
-        : buf_pos (nullptr),
+        : buf_start (nullptr),
+          buf_pos (nullptr),
           buf_end (nullptr),
+          token_pos (nullptr),
+          row_col_pos (nullptr),
           row (0),
           col (0),
-          strict (true)
+          strict (true),
+          track_pos (true)
     {
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jtokenizer::jtokenizer (const std::string_view& buffer, bool strict_mode)
+    jtokenizer::jtokenizer (const std::string_view& buffer,
+                            bool strict_mode,
+                            bool track_position)
     {
-        reset (buffer, strict_mode);
+        reset (buffer, strict_mode, track_position);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jtokenizer::reset (const std::string_view& buffer, bool strict_mode)
+    void jtokenizer::reset (const std::string_view& buffer,
+                            bool strict_mode,
+                            bool track_position)
     {
         strict = strict_mode;
-        buf_pos = buffer.data ();
+        track_pos = track_position;
+        buf_start = buffer.data ();
+        buf_pos = buf_start;
         buf_end = buf_pos + buffer.size ();
         token_pos = buf_pos;
+        row_col_pos = buf_start;
         row = 0;
         col = 0;
         token.reset ();
@@ -123,18 +347,65 @@ namespace ujson::parser {
     //--------------------------------------------------------------------------
     std::pair<size_t, size_t> jtokenizer::pos () const
     {
+        update_row_col (buf_pos);
         return std::make_pair (row, col);
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::pair<size_t, size_t> jtokenizer::pos (size_t offset) const
+    {
+        update_row_col (buf_start + std::min(offset, size_t(buf_end - buf_start)));
+        return std::make_pair (row, col);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Count rows and columns from the last known position
+    // (or from the start of the buffer) up to 'pos'.
+    //--------------------------------------------------------------------------
+    void jtokenizer::update_row_col (const char* pos) const
+    {
+        if (pos < row_col_pos) {
+            row_col_pos = buf_start;
+            row = 0;
+            col = 0;
+        }
+        while (row_col_pos < pos) {
+            auto nl = reinterpret_cast<const char*> (memchr(row_col_pos, '\n', pos - row_col_pos));
+            if (!nl) {
+                col += pos - row_col_pos;
+                row_col_pos = pos;
+            }else{
+                ++row;
+                col = 0;
+                row_col_pos = nl + 1;
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jtokenizer::set_token_pos (const char* pos)
+    {
+        token.offset = pos - buf_start;
+        if (track_pos) {
+            update_row_col (pos);
+            token.row = row;
+            token.col = col;
+        }
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     void jtokenizer::set_token_at_pos (jtoken::type_t type, size_t size, jtoken::error_t err)
     {
         token.type = type;
         token.data = std::string_view (token_pos, size);
-        token.row = row;
-        token.col = col;
+        set_token_pos (buf_pos);
         token.err_code = err;
     }
 
@@ -155,8 +426,7 @@ namespace ujson::parser {
     {
         size_t name_index = 0;
 
-        token.row = row;
-        token.col = col;
+        set_token_pos (buf_pos);
         advance_pos ();
 
         while (true) {
@@ -219,15 +489,14 @@ namespace ujson::parser {
                     set_token (jtoken::tk_string, buf_pos-token_pos);
                     return;
                 }
-                else if (ch==(char)0x20 ||
-                         ch==(char)0x21 ||
-                         (ch>=(char)0x23 && ch<=(char)0x5b) ||
-                         (ch>=(char)0x5d && ch<=(char)0x7f))
-                {
-                    ; // ASCII
-                }
                 else if (ch == '\\') {
                     str_state = ss_escape;
+                    token.has_escapes = true;
+                }
+                else if (size_t n = string_chars(buf_pos, buf_end); n > 0) {
+                    // Skip all the following plain characters
+                    // and valid UTF-8 characters at once.
+                    buf_pos += n - 1;
                 }
                 else if (ch>=(char)0xc2 && ch<=(char)0xdf) {
                     str_state = ss_uany;
@@ -241,6 +510,12 @@ namespace ujson::parser {
                     str_state = ss_uany;
                     ch_count = 3;
                 }
+                else if (ch & 0x80) {
+                    // A continuation byte, or a byte
+                    // that never starts a UTF-8 character
+                    set_token_at_pos (jtoken::tk_invalid, buf_pos-token_pos, jtoken::err_string_utf8);
+                    return;
+                }
                 else {
                     set_token_at_pos (jtoken::tk_invalid, buf_pos-token_pos, jtoken::err_string_unterminated);
                     return;
@@ -270,8 +545,17 @@ namespace ujson::parser {
                     str_state = ss_any;
                     break;
                 case 'u':
-                    str_state = ss_escape_unicode;
-                    ch_count = 4;
+                    if (buf_end - buf_pos > 4 &&
+                        (is_hex_digit(buf_pos[1]) & is_hex_digit(buf_pos[2]) &
+                         is_hex_digit(buf_pos[3]) & is_hex_digit(buf_pos[4])))
+                    {
+                        // Skip all four hex digits at once
+                        buf_pos += 4;
+                        str_state = ss_any;
+                    }else{
+                        str_state = ss_escape_unicode;
+                        ch_count = 4;
+                    }
                     break;
                 default:
                     set_token_at_pos (jtoken::tk_invalid, buf_pos-token_pos, jtoken::err_string_escape);
@@ -280,7 +564,7 @@ namespace ujson::parser {
                 break;
 
             case ss_escape_unicode:
-                if (isxdigit(ch)) {
+                if (is_hex_digit(ch)) {
                     if (--ch_count == 0)
                         str_state = ss_any;
                 }else{
@@ -400,19 +684,58 @@ namespace ujson::parser {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    const jtoken* jtokenizer::next_token ()
+    void jtokenizer::skip_whitespace ()
     {
-        // Already done scanning ?
-        if (token.type == jtoken::tk_invalid  &&  token.err_code!=jtoken::ok)
-            return nullptr;
+#if (UJSON_SCAN_SSE2)
+        // Most tokens are not preceded by whitespace at all,
+        // or by a single space, don't bother with SIMD for those.
+        if (buf_end - buf_pos < 2 || (buf_pos[1]!=' ' && buf_pos[1]!='\t' &&
+                                      buf_pos[1]!='\r' && buf_pos[1]!='\n'))
+        {
+            if (buf_pos < buf_end && (*buf_pos==' ' || *buf_pos=='\t' ||
+                                      *buf_pos=='\r' || *buf_pos=='\n'))
+            {
+                advance_pos ();
+            }
+            return;
+        }
 
-        // Ignore whitespace
+        const __m128i space   = _mm_set1_epi8 (' ');
+        const __m128i tab     = _mm_set1_epi8 ('\t');
+        const __m128i cr      = _mm_set1_epi8 ('\r');
+        const __m128i newline = _mm_set1_epi8 ('\n');
+        while (buf_end - buf_pos >= 16) {
+            __m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(buf_pos));
+            __m128i ws = _mm_or_si128 (_mm_or_si128(_mm_cmpeq_epi8(block, space),
+                                                    _mm_cmpeq_epi8(block, tab)),
+                                       _mm_or_si128(_mm_cmpeq_epi8(block, cr),
+                                                    _mm_cmpeq_epi8(block, newline)));
+            unsigned ws_mask = (unsigned) _mm_movemask_epi8 (ws);
+            unsigned len = ws_mask==0xffff ? 16 : lowest_bit_index (~ws_mask);
+            buf_pos += len;
+            if (len < 16)
+                return;
+        }
+#endif
         while (buf_pos < buf_end) {
             if (*buf_pos=='\t' || *buf_pos=='\r' || *buf_pos==' ' || *buf_pos=='\n')
                 advance_pos ();
             else
                 break;
         }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jtoken* jtokenizer::next_token ()
+    {
+        // Already done scanning ?
+        if (token.type == jtoken::tk_invalid  &&  token.err_code!=jtoken::ok)
+            return nullptr;
+
+        // Ignore whitespace
+        skip_whitespace ();
 
         // End of buffer ?
         if (buf_pos >= buf_end) {
@@ -450,8 +773,8 @@ namespace ujson::parser {
             scan_token (jtoken::tk_false, "false", 5);
             break;
         case '"':
-            token.row = row;
-            token.col = col+1;
+            set_token_pos (buf_pos+1);
+            token.has_escapes = false;
             str_state = ss_any;
             ch_count = 0;
             ++token_pos;
@@ -475,8 +798,7 @@ namespace ujson::parser {
         case '7':
         case '8':
         case '9':
-            token.row = row;
-            token.col = col;
+            set_token_pos (buf_pos);
             num_state = ns_first_digit;
             scan_number ();
             return &token;
@@ -484,8 +806,7 @@ namespace ujson::parser {
         default:
             if (!strict) {
                 if (std::isalpha(*buf_pos) || *buf_pos=='_') {
-                    token.row = row;
-                    token.col = col;
+                    set_token_pos (buf_pos);
                     do {
                         advance_pos ();
                     }while ((buf_pos < buf_end) && (std::isalnum(*buf_pos) || *buf_pos=='_'));
@@ -508,8 +829,7 @@ namespace ujson::parser {
     //--------------------------------------------------------------------------
     void jtokenizer::scan_comment ()
     {
-        token.row = row;
-        token.col = col;
+        set_token_pos (buf_pos);
 
         if (!advance_pos_and_check()) {
             set_token_at_pos (jtoken::tk_invalid, buf_pos-token_pos, jtoken::err_eob);
@@ -549,8 +869,6 @@ namespace ujson::parser {
             //
             // No comment - unexpected character
             //
-            row = token.row;
-            col = token.col;
             --buf_pos;
             set_token_at_pos (jtoken::tk_invalid, buf_pos-token_pos, jtoken::err_unexpected_char);
             return;
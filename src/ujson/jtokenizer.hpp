@@ -87,15 +87,24 @@ namespace ujson::parser {
         void reset () {
             type = tk_invalid;
             row = col = 0;
+            offset = 0;
             err_code = ok;
             data = "";
+            has_escapes = false;
         }
 
         type_t type;           /**< The type of token. */
-        size_t row;            /**< The row the token starts on. */
-        size_t col;            /**< The comulm the token start on. */
+        size_t row;            /**< The row the token starts on.
+                                    Always 0 if the tokenizer doesn't track positions. */
+        size_t col;            /**< The comulm the token start on.
+                                    Always 0 if the tokenizer doesn't track positions. */
+        size_t offset;         /**< The byte offset in the buffer of the
+                                    position described by <code>row</code>
+                                    and <code>col</code>. */
         error_t err_code;      /**< Error code. */
         std::string_view data; /**< The token data. */
+        bool has_escapes;      /**< For string tokens, <code>true</code> if
+                                    the string contains escape sequences. */
     };
 
     /**
@@ -120,23 +129,37 @@ namespace ujson::parser {
          * Constructor.
          * @param buffer The buffer to scan for JSON tokens.
          * @param strict_mode Use strict mode when scanning.
+         * @param track_position If <code>true</code>, the row and column
+         *                       of each token is set in the returned tokens.
+         *                       If <code>false</code>, only the byte offset
+         *                       of each token is set, and the row and column
+         *                       can be calculated when needed using
+         *                       method <code>pos(size_t)</code>.
          */
-        jtokenizer (const std::string_view& buffer, bool strict_mode=true);
+        jtokenizer (const std::string_view& buffer,
+                    bool strict_mode=true,
+                    bool track_position=true);
 
         /**
          * Reset the tokenizer.
          * @param buffer The buffer to scan for JSON tokens.
          */
         void reset (const std::string_view& buffer) {
-            reset (buffer, strict);
+            reset (buffer, strict, track_pos);
         }
 
         /**
          * Reset the tokenizer.
          * @param buffer The buffer to scan for JSON tokens.
          * @param strict_mode Use strict mode when scanning.
+         * @param track_position If <code>true</code>, the row and column
+         *                       of each token is set in the returned tokens.
+         *                       If <code>false</code>, only the byte offset
+         *                       of each token is set.
          */
-        void reset (const std::string_view& buffer, bool strict_mode);
+        void reset (const std::string_view& buffer,
+                    bool strict_mode,
+                    bool track_position=true);
 
         /**
          * Return the next JSON token in the buffer.
@@ -152,16 +175,42 @@ namespace ujson::parser {
          */
         std::pair<size_t, size_t> pos () const;
 
+        /**
+         * Get the position (row, column) of a byte offset in the buffer.
+         * @param offset A byte offset in the buffer, for example
+         *               the <code>offset</code> member of a jtoken.
+         */
+        std::pair<size_t, size_t> pos (size_t offset) const;
+
+        /**
+         * Get the current byte offset in the buffer.
+         */
+        size_t offset () const {
+            return buf_pos - buf_start;
+        }
+
+        /**
+         * Get the size in bytes of the buffer.
+         */
+        size_t size () const {
+            return buf_end - buf_start;
+        }
+
 
     private:
         enum str_state_t : unsigned;
         enum num_state_t : unsigned;
 
+        const char* buf_start;
         const char* buf_pos;
         const char* buf_end;
         const char* token_pos;
-        size_t row;
-        size_t col;
+
+        // Row and column of position 'row_col_pos'.
+        // Updated only when a position is requested.
+        mutable const char* row_col_pos;
+        mutable size_t row;
+        mutable size_t col;
 
         jtoken token;
         num_state_t num_state;
@@ -169,30 +218,22 @@ namespace ujson::parser {
         size_t ch_count;
 
         bool strict;
+        bool track_pos;
 
+        void update_row_col (const char* pos) const;
+        void set_token_pos (const char* pos);
         void set_token_at_pos (jtoken::type_t type, size_t size, jtoken::error_t err=jtoken::ok);
         void set_token (jtoken::type_t type, size_t size, jtoken::error_t err=jtoken::ok);
         void scan_token (jtoken::type_t type, const char* const name, size_t name_size);
         void scan_string ();
         void scan_number ();
         void scan_comment ();
+        void skip_whitespace ();
 
         inline void advance_pos () {
-            if (*buf_pos == '\n') {
-                ++row;
-                col = 0;
-            }else{
-                ++col;
-            }
             ++buf_pos;
         }
         inline bool advance_pos_and_check () {
-            if (*buf_pos == '\n') {
-                ++row;
-                col = 0;
-            }else{
-                ++col;
-            }
             ++buf_pos;
             return buf_pos < buf_end;
         }
@@ -21,12 +21,25 @@
 #include <sstream>
 #include <algorithm>
 #include <stdexcept>
-#include <regex>
 #include <iomanip>
 #include <ujson/jvalue.hpp>
+#include <ujson/jarena.hpp>
 #include <ujson/utils.hpp>
+#include <ujson/jwriter.hpp>
 #include <cstring>
 #include <cmath>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <unistd.h>
 
 
 #if (UJSON_HAS_CONSOLE_COLOR)
@@ -79,83 +92,487 @@ static constexpr const char* const array_color = "";
 namespace ujson {
 
 
+    //--------------------------------------------------------------------------
+    // An object or array on the heap is preceded by the number of
+    // jvalue instances sharing it, see jvalue::share().
+    //--------------------------------------------------------------------------
+    struct node_header_t {
+        alignas(std::max_align_t) std::atomic<size_t> refs;
+    };
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline std::atomic<size_t>& node_refs (const void* value)
+    {
+        return (reinterpret_cast<node_header_t*>(const_cast<void*>(value)) - 1)->refs;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Allocate the data of a jvalue from the arena used
+    // in the current thread, or from the heap if none.
+    //--------------------------------------------------------------------------
+    template<typename T, typename... Args>
+    static T* new_value (bool& in_arena, Args&&... args)
+    {
+        auto* resource = jarena::resource ();
+        in_arena = resource != nullptr;
+        if (!in_arena) {
+            void* mem = ::operator new (sizeof(node_header_t) + sizeof(T));
+            auto* header = new (mem) node_header_t {1};
+            try {
+                return new (header + 1) T (std::forward<Args>(args)...);
+            }
+            catch (...) {
+                ::operator delete (mem);
+                throw;
+            }
+        }
+
+        void* mem = resource->allocate (sizeof(T), alignof(T));
+        try {
+            return new (mem) T (std::forward<Args>(args)...);
+        }
+        catch (...) {
+            resource->deallocate (mem, sizeof(T), alignof(T));
+            throw;
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Free the data of a jvalue. Memory in an arena is
+    // released when the arena is destroyed. Data on
+    // the heap is freed when it is no longer shared.
+    //--------------------------------------------------------------------------
+    template<typename T>
+    static void delete_value (T* value, bool in_arena)
+    {
+        if (in_arena) {
+            value->~T ();
+            return;
+        }
+        auto* header = reinterpret_cast<node_header_t*> (value) - 1;
+        if (header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            value->~T ();
+            header->~node_header_t ();
+            ::operator delete (header);
+        }
+    }
+
+
+    // Set while an object or array is unshared, to let
+    // the copy share the objects and arrays in it.
+    static thread_local bool share_copies = false;
+
+
     jvalue invalid_jvalue (j_invalid);
+    static const jvalue const_invalid_jvalue (j_invalid);
 
 
 #if UJSON_HAVE_GMPXX
-    static void num_t_to_str (const mpf_class& n, std::stringstream& ss)
-    {
-        mp_exp_t e;
-        std::string str = n.get_str (e);
-        long slen = str.length ();
-        const char* s = str.c_str ();
+    //--------------------------------------------------------------------------
+    // A decimal number normalized as 0.<digits> * 10^exp,
+    // with no leading or trailing zeros in the digits.
+    //--------------------------------------------------------------------------
+    struct decimal_t {
+        static constexpr int max_digits = 32;
+        char digits[max_digits];
+        int  len {0};
+        long exp {0};
+        bool negative {false};
 
-        if (slen>0 && s[0]=='-') {
-            ss << '-';
-            ++s;
-            --slen;
+        bool operator== (const decimal_t& rhs) const {
+            return len == rhs.len  &&  exp == rhs.exp  &&  negative == rhs.negative  &&
+                std::memcmp (digits, rhs.digits, len) == 0;
+        }
+    };
+
+
+    //--------------------------------------------------------------------------
+    // Normalize a number in JSON syntax, or as written by std::to_chars.
+    // Returns false if the number has too many significant digits.
+    //--------------------------------------------------------------------------
+    static bool to_decimal (const char* pos, const char* end, decimal_t& dec)
+    {
+        if (pos<end && *pos=='-') {
+            dec.negative = true;
+            ++pos;
+        }
+        bool in_fraction = false;
+        for (; pos<end; ++pos) {
+            char ch = *pos;
+            if (ch == '.') {
+                in_fraction = true;
+                continue;
+            }
+            if (ch<'0' || ch>'9')
+                break;
+            if (dec.len == 0  &&  ch == '0') {
+                // Leading zero
+                if (in_fraction)
+                    --dec.exp;
+                continue;
+            }
+            if (dec.len == decimal_t::max_digits)
+                return false;
+            dec.digits[dec.len++] = ch;
+            if (!in_fraction)
+                ++dec.exp;
         }
+        if (pos<end  &&  (*pos=='e' || *pos=='E')) {
+            ++pos;
+            if (pos<end && *pos=='+')
+                ++pos;
+            long e;
+            auto result = std::from_chars (pos, end, e);
+            if (result.ec != std::errc())
+                return false;
+            dec.exp += e;
+        }
+        while (dec.len>0  &&  dec.digits[dec.len-1]=='0')
+            --dec.len;
+        if (dec.len == 0) {
+            // Zero, '-0' is written as '0'
+            dec.exp = 0;
+            dec.negative = false;
+        }
+        return true;
+    }
+
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static void exponent_to_str (long e, jwriter& out)
+    {
+        char buf[24];
+        auto result = std::to_chars (buf, buf+sizeof(buf), e);
+        out.write (buf, result.ptr - buf);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write a number given as its significant digits and a decimal
+    // exponent, value = 0.<digits> * 10^e, in the same format as
+    // mpf_class numbers are written.
+    //--------------------------------------------------------------------------
+    void digits_to_str (const char* s, long slen, long e, jwriter& out)
+    {
         if (slen == 0) {
-            ss << "0";
+            out.put ('0');
         }
         else if (e == 0) {
-            ss << "0." << s;
+            out.write ("0.", 2);
+            out.write (s, slen);
         }
-        else if (e >= (ssize_t)slen) {
+        else if (e >= slen) {
             if (e > 16) {
-                if (slen==1) {
-                    ss << s << "e+" << e-1;
-                }else{
-                    ss << s[0] << '.' << (s+1) << "e+" << e-1;
+                out.put (s[0]);
+                if (slen > 1) {
+                    out.put ('.');
+                    out.write (s+1, slen-1);
                 }
+                out.write ("e+", 2);
+                exponent_to_str (e-1, out);
             }else{
-                ss << s;
+                out.write (s, slen);
                 for (long i=0; i<(e-slen); ++i)
-                    ss << '0';
+                    out.put ('0');
             }
         }
-        else /* if (e < (ssize_t)slen) */ {
+        else /* if (e < slen) */ {
             if (e < -3) {
-                if (slen==1) {
-                    ss << s << 'e' << e-1;
-                }else{
-                    ss << s[0] << '.' << (s+1) << 'e' << e-1;
+                out.put (s[0]);
+                if (slen > 1) {
+                    out.put ('.');
+                    out.write (s+1, slen-1);
                 }
+                out.put ('e');
+                exponent_to_str (e-1, out);
             }else{
                 if (e > 0) {
-                    for (long i=0; i<e; ++i)
-                        ss << s[i];
-                    ss << '.';
-                    ss << (s+e);
+                    out.write (s, e);
+                    out.put ('.');
+                    out.write (s+e, slen-e);
                 }else{
-                    ss << "0.";
+                    out.write ("0.", 2);
                     for (long i=0; i>e; --i)
-                        ss << '0';
-                    ss << s;
+                        out.put ('0');
+                    out.write (s, slen);
                 }
             }
         }
     }
 
 
+    //--------------------------------------------------------------------------
+    // Write a number stored as a long or a double the same
+    // way as it would be written if stored as an mpf_class.
+    //--------------------------------------------------------------------------
+    template<typename T>
+    static void native_num_to_str (T n, jwriter& out)
+    {
+        char buf[32];
+        std::to_chars_result result;
+        if constexpr (std::is_floating_point_v<T>) {
+            result = std::to_chars (buf, buf+sizeof(buf), n, std::chars_format::scientific);
+        }else{
+            result = std::to_chars (buf, buf+sizeof(buf), n);
+            if (n > -10000000000000000L && n < 10000000000000000L) {
+                // At most 16 digits, written as is
+                out.write (buf, result.ptr - buf);
+                return;
+            }
+        }
+        decimal_t dec;
+        to_decimal (buf, result.ptr, dec);
+        if (dec.negative)
+            out.put ('-');
+        digits_to_str (dec.digits, dec.len, dec.exp, out);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static void num_t_to_str (const mpf_class& n, jwriter& out)
+    {
+        mp_exp_t e;
+        std::string str = n.get_str (e);
+        long slen = str.length ();
+        const char* s = str.c_str ();
+
+        if (slen>0 && s[0]=='-') {
+            out.put ('-');
+            ++s;
+            --slen;
+        }
+        digits_to_str (s, slen, e, out);
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     std::string to_string (const mpf_class& number)
     {
-        std::stringstream ss;
-        num_t_to_str (number, ss);
-        return ss.str ();
+        std::string result;
+        jwriter out (result);
+        num_t_to_str (number, out);
+        out.flush ();
+        return result;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Lazy way to adjust the precision to fit the number.
+    // 4 bits per decimal digit in the number string,
+    // or 4 bits times the power of ten when the format is xEpow,
+    // or mpf_get_default_prec(), whatever is higher.
+    //--------------------------------------------------------------------------
+    mp_bitcnt_t number_precision (const std::string& str)
+    {
+        auto e_pos = str.find ("e");
+        if (e_pos == std::string::npos)
+            e_pos = str.find ("E");
+
+        if (e_pos == std::string::npos) {
+            return std::max (mpf_get_default_prec(),
+                             mp_bitcnt_t(str.size()*4));
+        }else{
+            return std::max (mpf_get_default_prec(),
+                             mp_bitcnt_t(std::abs(std::stod(str.substr(e_pos+1)))*4));
+        }
+    }
+#endif
+
+
+    //--------------------------------------------------------------------------
+    // Store a number token as a long, or as a double if it is exactly
+    // the shortest representation of that double. Returns false if
+    // the number needs an mpf_class to keep its precision, or can't
+    // be converted. Without gmpxx, numbers are always doubles.
+    //--------------------------------------------------------------------------
+    bool number_from_token (const std::string_view& str, jvalue& value)
+    {
+        const char* first = str.data ();
+        const char* last  = first + str.size ();
+#if UJSON_HAVE_GMPXX
+        // The precision the number would get as an mpf_class,
+        // see number_precision()
+        mp_bitcnt_t precision;
+        auto e_pos = str.find_first_of ("eE");
+        if (e_pos == std::string_view::npos) {
+            precision = str.size() * 4;
+        }else{
+            const char* e_first = first + e_pos + 1;
+            if (e_first<last && *e_first=='+')
+                ++e_first;
+            long e;
+            auto result = std::from_chars (e_first, last, e);
+            if (result.ec != std::errc()  ||  e < -100000  ||  e > 100000)
+                return false;
+            precision = std::abs(e) * 4;
+        }
+        precision = std::max (mpf_get_default_prec(), precision);
+        if (precision > std::numeric_limits<uint16_t>::max())
+            return false;
+
+        if (str.find_first_of(".eE") == std::string_view::npos) {
+            long n;
+            auto result = std::from_chars (first, last, n);
+            if (result.ec == std::errc()  &&  result.ptr == last) {
+                value.num (n);
+                value.num_prec = (uint16_t) precision;
+                return true;
+            }
+        }
+
+        double n;
+        auto result = std::from_chars (first, last, n);
+        if (result.ec != std::errc()  ||  result.ptr != last)
+            return false;
+
+        if (n != 0.0  &&  !std::isnormal(n))
+            return false;
+
+        decimal_t token_dec;
+        if (!to_decimal(first, last, token_dec)  ||  token_dec.len > 17)
+            return false;
+
+        // A decimal number with at most 15 significant digits is
+        // the shortest representation of the nearest double (DBL_DIG).
+        // With 16 or 17 digits, check that the double gives the same
+        // decimal number back.
+        if (token_dec.len > std::numeric_limits<double>::digits10) {
+            char buf[32];
+            auto to_result = std::to_chars (buf, buf+sizeof(buf), n, std::chars_format::scientific);
+            decimal_t dbl_dec;
+            to_decimal (buf, to_result.ptr, dbl_dec);
+            if (!(token_dec == dbl_dec))
+                return false;
+        }
+
+        value.type (j_number);
+        value.repr = jvalue::num_dbl;
+        value.num_prec = (uint16_t) precision;
+        value.v.jdbl = n;
+        return true;
+#else
+        double n;
+        auto result = std::from_chars (first, last, n);
+        if (result.ec != std::errc()  ||  result.ptr != last)
+            return false;
+        if (n != 0.0  &&  !std::isnormal(n))
+            return false; // Let std::stod() report subnormal numbers as out of range
+        value.num (n);
+        return true;
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Convert a number in JSON syntax and store it in a jvalue.
+    // Throws std::invalid_argument or std::out_of_range on failure.
+    //--------------------------------------------------------------------------
+    void number_from_string (const std::string& str, jvalue& value)
+    {
+        if (number_from_token(str, value))
+            return;
+#if UJSON_HAVE_GMPXX
+        jvalue::num_t number (str, number_precision(str));
+        value.num (std::move(number));
+#else
+        value.num (std::stod(str));
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Store a double, with gmpxx as a native double
+    // that is converted to an mpf_class when needed.
+    //--------------------------------------------------------------------------
+    void number_from_double (const double n, jvalue& value)
+    {
+#if UJSON_HAVE_GMPXX
+        value.num (0L);
+        value.repr = jvalue::num_dbl;
+        value.v.jdbl = n;
+#else
+        value.num (n);
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Store a number token as text, it is converted when needed.
+    //--------------------------------------------------------------------------
+    void number_as_text (const std::string_view& str, jvalue& value)
+    {
+        value.reset ();
+        new (&value.v.jstr) std::string (str);
+        value.repr = jvalue::num_text;
+        value.jtype = j_number;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Store a string that refers to the parsed buffer.
+    //--------------------------------------------------------------------------
+    void string_as_view (const std::string_view& str, jvalue& value)
+    {
+        value.reset ();
+        value.v.jview = str;
+        value.repr = jvalue::str_borrowed;
+        value.jtype = j_string;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // A key used to look up an object member without copying the name.
+    //--------------------------------------------------------------------------
+#if UJSON_INTERNED_KEYS
+    static inline jkey lookup_key (const std::string& name)
+    {
+        return jkey::ref (name);
+    }
+#else
+    static inline const std::string& lookup_key (const std::string& name)
+    {
+        return name;
     }
 #endif
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue* member_to_change (jvalue& object, const std::string& name)
+    {
+        auto& members = object.obj ();
+        auto range = members.equal_range (lookup_key(name));
+        for (auto entry=range.second; entry!=range.first; ) {
+            --entry;
+            if (entry->second.valid())
+                return &entry->second;
+        }
+        return nullptr;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue* item_to_change (jvalue& array, const size_t index)
+    {
+        auto& items = array.array ();
+        return index < items.size() ? &items[index] : nullptr;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     static json_object::iterator find_last_in_jobj (const std::string& key,
                                                     json_object& jobj)
     {
-        auto range = jobj.equal_range (key);
+        auto range = jobj.equal_range (lookup_key(key));
         auto first = range.first;
         auto last  = range.second;
 
@@ -202,7 +619,7 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue::jvalue (jvalue&& jval)
+    jvalue::jvalue (jvalue&& jval) noexcept
         : jtype {j_invalid}
     {
         move (std::forward<jvalue&&>(jval));
@@ -214,7 +631,8 @@ namespace ujson {
     jvalue::jvalue (const json_object& o)
         : jtype {j_object}
     {
-        v.jobj = new json_object (o);
+        v.jc.jobj = new_value<json_object> (in_arena, o);
+        v.jc.hash_cached = false;
     }
 
 
@@ -223,7 +641,8 @@ namespace ujson {
     jvalue::jvalue (json_object&& o)
         : jtype {j_object}
     {
-        v.jobj = new json_object (std::forward<json_object&&>(o));
+        v.jc.jobj = new_value<json_object> (in_arena, std::forward<json_object&&>(o));
+        v.jc.hash_cached = false;
     }
 
 
@@ -232,7 +651,8 @@ namespace ujson {
     jvalue::jvalue (const json_array& a)
         : jtype {j_array}
     {
-        v.jarray = new json_array (a);
+        v.jc.jarray = new_value<json_array> (in_arena, a);
+        v.jc.hash_cached = false;
     }
 
 
@@ -241,7 +661,8 @@ namespace ujson {
     jvalue::jvalue (json_array&& a)
         : jtype {j_array}
     {
-        v.jarray = new json_array (std::forward<json_array&&>(a));
+        v.jc.jarray = new_value<json_array> (in_arena, std::forward<json_array&&>(a));
+        v.jc.hash_cached = false;
     }
 
 
@@ -250,7 +671,7 @@ namespace ujson {
     jvalue::jvalue (const std::string& s)
         : jtype {j_string}
     {
-        v.jstr = new std::string (s);
+        new (&v.jstr) std::string (s);
     }
 
 
@@ -259,7 +680,7 @@ namespace ujson {
     jvalue::jvalue (std::string&& s)
         : jtype {j_string}
     {
-        v.jstr = new std::string (std::forward<std::string&&>(s));
+        new (&v.jstr) std::string (std::forward<std::string&&>(s));
     }
 
 
@@ -268,7 +689,7 @@ namespace ujson {
     jvalue::jvalue (const char* s)
         : jtype {j_string}
     {
-        v.jstr = new std::string ((s==nullptr?"":s));
+        new (&v.jstr) std::string (s==nullptr?"":s);
     }
 
 
@@ -278,7 +699,7 @@ namespace ujson {
     jvalue::jvalue (const mpf_class& n)
         : jtype {j_number}
     {
-        v.jnum = new num_t (n);
+        new (&v.jnum) num_t (n);
     }
 
 
@@ -287,7 +708,7 @@ namespace ujson {
     jvalue::jvalue (mpf_class&& n)
         : jtype {j_number}
     {
-        v.jnum = new num_t (std::forward<mpf_class&&>(n));
+        new (&v.jnum) num_t (std::forward<mpf_class&&>(n));
     }
 #endif
 
@@ -300,7 +721,7 @@ namespace ujson {
 #if UJSON_HAVE_GMPXX
         std::stringstream ss;
         ss << std::setprecision(std::numeric_limits<double>::digits10 + 1) << n;
-        v.jnum = new num_t (ss.str());
+        new (&v.jnum) num_t (ss.str());
 #else
         v.jnum = n;
 #endif
@@ -313,7 +734,9 @@ namespace ujson {
         : jtype {j_number}
     {
 #if UJSON_HAVE_GMPXX
-        v.jnum = new num_t (n);
+        repr = num_long;
+        num_prec = 0;
+        v.jlong = n;
 #else
         v.jnum = static_cast<num_t> (n);
 #endif
@@ -326,7 +749,9 @@ namespace ujson {
         : jtype {j_number}
     {
 #if UJSON_HAVE_GMPXX
-        v.jnum = new num_t (n);
+        repr = num_long;
+        num_prec = 0;
+        v.jlong = n;
 #else
         v.jnum = static_cast<num_t> (n);
 #endif
@@ -370,7 +795,7 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue& jvalue::operator= (jvalue&& value)
+    jvalue& jvalue::operator= (jvalue&& value) noexcept
     {
         if (this != &value)
             move (std::forward<jvalue&&>(value));
@@ -428,20 +853,34 @@ namespace ujson {
             return false;
 
         case j_object:
-            return *v.jobj < *rval.v.jobj;
+            return *v.jc.jobj < *rval.v.jc.jobj;
 
         case j_array:
-            return std::lexicographical_compare (v.jarray->begin(), v.jarray->end(),
-                                                 rval.v.jarray->begin(), rval.v.jarray->end());
+            return std::lexicographical_compare (v.jc.jarray->begin(), v.jc.jarray->end(),
+                                                 rval.v.jc.jarray->begin(), rval.v.jc.jarray->end());
 
         case j_string:
-            return std::lexicographical_compare (v.jstr->begin(), v.jstr->end(),
-                                                 rval.v.jstr->begin(), rval.v.jstr->end());
+            {
+                auto lstr = str_view ();
+                auto rstr = rval.str_view ();
+                return std::lexicographical_compare (lstr.begin(), lstr.end(),
+                                                     rstr.begin(), rstr.end());
+            }
         case j_number:
 #if UJSON_HAVE_GMPXX
-            return *v.jnum < *rval.v.jnum;
+            if (repr == rval.repr  &&  repr != num_text) {
+                switch (repr) {
+                case num_long:
+                    return v.jlong < rval.v.jlong;
+                case num_dbl:
+                    return v.jdbl < rval.v.jdbl;
+                default:
+                    return v.jnum < rval.v.jnum;
+                }
+            }
+            return get_mpf() < rval.get_mpf();
 #else
-            return v.jnum < rval.v.jnum;
+            return num() < rval.num();
 #endif
 
         case j_bool:
@@ -469,19 +908,37 @@ namespace ujson {
             return false;
 
         case j_object:
-            return *v.jobj == *rval.v.jobj;
+            if (v.jc.jobj == rval.v.jc.jobj)
+                return true; // Shared
+            if (v.jc.hash_cached  &&  rval.v.jc.hash_cached  &&  v.jc.hash != rval.v.jc.hash)
+                return false;
+            return *v.jc.jobj == *rval.v.jc.jobj;
 
         case j_array:
-            return *v.jarray == *rval.v.jarray;
+            if (v.jc.jarray == rval.v.jc.jarray)
+                return true; // Shared
+            if (v.jc.hash_cached  &&  rval.v.jc.hash_cached  &&  v.jc.hash != rval.v.jc.hash)
+                return false;
+            return *v.jc.jarray == *rval.v.jc.jarray;
 
         case j_string:
-            return *v.jstr == *rval.v.jstr;
+            return str_view() == rval.str_view();
 
         case j_number:
 #if UJSON_HAVE_GMPXX
-            return *v.jnum == *rval.v.jnum;
+            if (repr == rval.repr  &&  repr != num_text) {
+                switch (repr) {
+                case num_long:
+                    return v.jlong == rval.v.jlong;
+                case num_dbl:
+                    return v.jdbl == rval.v.jdbl;
+                default:
+                    return v.jnum == rval.v.jnum;
+                }
+            }
+            return get_mpf() == rval.get_mpf();
 #else
-            return v.jnum == rval.v.jnum;
+            return num() == rval.num();
 #endif
 
         case j_bool:
@@ -496,108 +953,387 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    json_object& jvalue::obj ()
+    static inline uint64_t hash_mix (uint64_t h)
     {
-        if (jtype != j_object)
-            throw ujson::json_type_error ("Not a JSON object");
-        return *v.jobj;
+        // The finalizer of splitmix64
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::obj (const json_object& o)
+    static inline uint64_t hash_combine (uint64_t seed, uint64_t h)
     {
-        type (j_object);
-        *v.jobj = o;
+        return hash_mix (seed + 0x9e3779b97f4a7c15ULL + h);
     }
 
 
+#if UJSON_HAVE_GMPXX
     //--------------------------------------------------------------------------
+    // Hash a number by its value. Integers that fit in a long are hashed
+    // as a long, so they hash the same however they are stored.
     //--------------------------------------------------------------------------
-    void jvalue::obj (json_object&& o)
+    static uint64_t hash_mpf (const mpf_class& num)
     {
-        type (j_object);
-        *v.jobj = std::forward<json_object&&> (o);
+        if (mpf_integer_p(num.get_mpf_t())  &&  num.fits_slong_p())
+            return hash_mix ((uint64_t) num.get_si());
+
+        mpf_srcptr f = num.get_mpf_t ();
+        size_t n = (size_t) std::abs (f->_mp_size);
+        size_t low = 0;
+        while (low < n  &&  f->_mp_d[low] == 0)
+            ++low; // Zero limbs don't change the value
+        uint64_t h = hash_mix ((uint64_t) f->_mp_exp ^ (f->_mp_size < 0 ? 0x8000000000000000ULL : 0));
+        for (size_t i=n; i>low; --i)
+            h = hash_combine (h, (uint64_t) f->_mp_d[i-1]);
+        return h;
     }
+#endif
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    json_array& jvalue::array ()
+    size_t jvalue::hash () const
     {
-        if (jtype != j_array)
-            throw ujson::json_type_error ("Not a JSON array");
-        return *v.jarray;
+        return make_hash (false);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::array (const json_array& a)
+    size_t jvalue::cache_hash () const
     {
-        type (j_array);
-        *v.jarray = a;
+        return make_hash (true);
     }
 
 
     //--------------------------------------------------------------------------
+    // Calculate the hash value. If 'keep' is true, the hash values of
+    // this and all contained objects and arrays are cached. Values in
+    // a shared object or array may be read by other threads, so their
+    // hash values are not cached.
     //--------------------------------------------------------------------------
-    void jvalue::array (json_array&& a)
+    size_t jvalue::make_hash (bool keep) const
     {
-        type (j_array);
-        *v.jarray = std::forward<json_array&&> (a);
+        if ((jtype == j_object  ||  jtype == j_array)  &&  v.jc.hash_cached)
+            return v.jc.hash;
+        bool keep_members = keep  &&  !shared ();
+
+        uint64_t h = hash_mix ((uint64_t) jtype + 1);
+
+        switch (jtype) {
+        case j_invalid:
+        case j_null:
+            break;
+
+        case j_object:
+            {
+                // Combine the attributes so the order doesn't matter
+                uint64_t sum = 0;
+                for (auto& member : *v.jc.jobj) {
+                    uint64_t member_hash = hash_combine (std::hash<json_key>()(member.first),
+                                                         member.second.make_hash(keep_members));
+                    sum += hash_mix (member_hash);
+                }
+                h = hash_combine (h, sum);
+            }
+            break;
+
+        case j_array:
+            for (auto& element : *v.jc.jarray)
+                h = hash_combine (h, element.make_hash(keep_members));
+            break;
+
+        case j_string:
+            h = hash_combine (h, std::hash<std::string_view>()(str_view()));
+            break;
+
+        case j_number:
+            if (repr == num_text) {
+                jvalue tmp (*this);
+                tmp.text_to_num ();
+                return tmp.hash ();
+            }
+#if UJSON_HAVE_GMPXX
+            // Numbers stored differently are compared as mpf_class
+            // instances, so hash the value they have as an mpf_class.
+            // A long, or an integer with less than 53 significant bits
+            // stored as a double, has the same value as an mpf_class.
+            if (repr == num_long) {
+                h = hash_combine (h, hash_mix((uint64_t) v.jlong));
+            }
+            else if (repr == num_dbl  &&
+                     std::fabs(v.jdbl) < 9007199254740992.0  &&
+                     std::trunc(v.jdbl) == v.jdbl)
+            {
+                h = hash_combine (h, hash_mix((uint64_t)(long) v.jdbl));
+            }
+            else if (repr == num_dbl) {
+                h = hash_combine (h, hash_mpf(get_mpf()));
+            }
+            else {
+                h = hash_combine (h, hash_mpf(v.jnum));
+            }
+#else
+            if (v.jnum == 0.0) {
+                h = hash_combine (h, 0); // 0.0 == -0.0
+            }else{
+                uint64_t bits;
+                std::memcpy (&bits, &v.jnum, sizeof(bits));
+                h = hash_combine (h, bits);
+            }
+#endif
+            break;
+
+        case j_bool:
+            h = hash_combine (h, v.jbool ? 1 : 0);
+            break;
+        }
+
+        if (keep  &&  (jtype == j_object  ||  jtype == j_array)) {
+            v.jc.hash = (size_t) h;
+            v.jc.hash_cached = true;
+        }
+        return (size_t) h;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    std::string& jvalue::str ()
+    json_object& jvalue::obj ()
     {
-        if (jtype != j_string)
-            throw ujson::json_type_error ("Not a JSON string");
-        return *v.jstr;
+        if (jtype != j_object)
+            throw ujson::json_type_error ("Not a JSON object");
+        before_change ();
+        return *v.jc.jobj;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::str (const std::string& s)
+    const json_object& jvalue::obj () const
     {
-        type (j_string);
-        *v.jstr = s;
+        if (jtype != j_object)
+            throw ujson::json_type_error ("Not a JSON object");
+        return *v.jc.jobj;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::str (std::string&& s)
+    void jvalue::obj (const json_object& o)
     {
-        type (j_string);
-        *v.jstr = std::forward<std::string&&> (s);
+        if (shared())
+            reset (); // Don't change the shared object or array
+        type (j_object);
+        *v.jc.jobj = o;
+        v.jc.hash_cached = false;
     }
 
 
-#if UJSON_HAVE_GMPXX
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    mpf_class& jvalue::mpf ()
+    void jvalue::obj (json_object&& o)
     {
-        if (jtype != j_number)
+        if (shared())
+            reset (); // Don't change the shared object or array
+        type (j_object);
+        *v.jc.jobj = std::forward<json_object&&> (o);
+        v.jc.hash_cached = false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    json_array& jvalue::array ()
+    {
+        if (jtype != j_array)
+            throw ujson::json_type_error ("Not a JSON array");
+        before_change ();
+        return *v.jc.jarray;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const json_array& jvalue::array () const
+    {
+        if (jtype != j_array)
+            throw ujson::json_type_error ("Not a JSON array");
+        return *v.jc.jarray;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::array (const json_array& a)
+    {
+        if (shared())
+            reset (); // Don't change the shared object or array
+        type (j_array);
+        *v.jc.jarray = a;
+        v.jc.hash_cached = false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::array (json_array&& a)
+    {
+        if (shared())
+            reset (); // Don't change the shared object or array
+        type (j_array);
+        *v.jc.jarray = std::forward<json_array&&> (a);
+        v.jc.hash_cached = false;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string& jvalue::str ()
+    {
+        if (jtype != j_string)
+            throw ujson::json_type_error ("Not a JSON string");
+        if (repr == str_borrowed) {
+            // Copy the string from the parsed buffer
+            auto view = v.jview;
+            new (&v.jstr) std::string (view);
+            repr = num_jnum;
+        }
+        return v.jstr;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::string_view jvalue::str_view () const
+    {
+        if (jtype != j_string)
+            throw ujson::json_type_error ("Not a JSON string");
+        if (repr == str_borrowed)
+            return v.jview;
+        return v.jstr;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::str (const std::string& s)
+    {
+        if (jtype == j_string  &&  repr == str_borrowed)
+            reset ();
+        type (j_string);
+        v.jstr = s;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::str (std::string&& s)
+    {
+        if (jtype == j_string  &&  repr == str_borrowed)
+            reset ();
+        type (j_string);
+        v.jstr = std::forward<std::string&&> (s);
+    }
+
+
+#if UJSON_HAVE_GMPXX
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    mpf_class& jvalue::mpf ()
+    {
+        if (jtype != j_number)
+            throw ujson::json_type_error ("Not a JSON number");
+        if (repr == num_text)
+            text_to_num ();
+        if (repr != num_jnum)
+            num_to_mpf ();
+        return v.jnum;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Convert a number stored as a long or a double to an mpf_class,
+    // the same way as if the number was parsed as an mpf_class.
+    //--------------------------------------------------------------------------
+    void jvalue::num_to_mpf ()
+    {
+        char buf[32];
+        std::to_chars_result result;
+        if (repr == num_long)
+            result = std::to_chars (buf, buf+sizeof(buf), v.jlong);
+        else
+            result = std::to_chars (buf, buf+sizeof(buf), v.jdbl, std::chars_format::scientific);
+        std::string str (buf, result.ptr);
+        new (&v.jnum) num_t (str, std::max(mp_bitcnt_t(num_prec), mpf_get_default_prec()));
+        repr = num_jnum;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    mpf_class jvalue::get_mpf () const
+    {
+        if (jtype != j_number)
             throw ujson::json_type_error ("Not a JSON number");
-        return *v.jnum;
+        if (repr == num_jnum)
+            return v.jnum;
+        if (repr == num_long) {
+            // Exact, same as when converted from text
+            return num_t (v.jlong, std::max(mp_bitcnt_t(num_prec), mpf_get_default_prec()));
+        }
+        jvalue tmp (*this);
+        return tmp.mpf ();
     }
 #endif
 
 
+    //--------------------------------------------------------------------------
+    // Convert a number stored as text to the representation
+    // it would have got if it wasn't parsed as text.
+    //--------------------------------------------------------------------------
+    void jvalue::text_to_num ()
+    {
+        std::string text (std::move(v.jstr));
+        reset ();
+        try {
+            number_from_string (text, *this);
+        }
+        catch (...) {
+            // Only a number too large or small for a double. Note that
+            // this is reported as a parse error if not parsed as text.
+#if UJSON_HAVE_GMPXX
+            num (mpf_class(text));
+#else
+            num (std::strtod(text.c_str(), nullptr));
+#endif
+        }
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     double jvalue::num () const
     {
         if (jtype != j_number)
             throw ujson::json_type_error ("Not a JSON number");
+        if (repr == num_text) {
+            jvalue tmp (*this);
+            tmp.text_to_num ();
+            return tmp.num ();
+        }
 #if UJSON_HAVE_GMPXX
-        return v.jnum->get_d();
+        switch (repr) {
+        case num_long:
+            return (double) v.jlong;
+        case num_dbl:
+            return v.jdbl;
+        default:
+            return v.jnum.get_d();
+        }
 #else
         return v.jnum;
 #endif
@@ -609,10 +1345,17 @@ namespace ujson {
     //--------------------------------------------------------------------------
     void jvalue::num (const mpf_class& n)
     {
+        if (jtype == j_number  &&  repr == num_text)
+            reset ();
         type (j_number);
-        if (n.get_prec() > v.jnum->get_prec())
-            v.jnum->set_prec (n.get_prec());
-        *v.jnum = n;
+        if (repr != num_jnum) {
+            new (&v.jnum) num_t (n, std::max(n.get_prec(), mpf_get_default_prec()));
+            repr = num_jnum;
+            return;
+        }
+        if (n.get_prec() > v.jnum.get_prec())
+            v.jnum.set_prec (n.get_prec());
+        v.jnum = n;
     }
 
 
@@ -620,10 +1363,20 @@ namespace ujson {
     //--------------------------------------------------------------------------
     void jvalue::num (mpf_class&& n)
     {
+        if (jtype == j_number  &&  repr == num_text)
+            reset ();
         type (j_number);
-        if (n.get_prec() > v.jnum->get_prec())
-            v.jnum->set_prec (n.get_prec());
-        *v.jnum = std::forward<mpf_class&&> (n);
+        if (repr != num_jnum) {
+            if (n.get_prec() >= mpf_get_default_prec())
+                new (&v.jnum) num_t (std::forward<mpf_class&&>(n));
+            else
+                new (&v.jnum) num_t (n, mpf_get_default_prec());
+            repr = num_jnum;
+            return;
+        }
+        if (n.get_prec() > v.jnum.get_prec())
+            v.jnum.set_prec (n.get_prec());
+        v.jnum = std::forward<mpf_class&&> (n);
     }
 #endif
 
@@ -632,11 +1385,18 @@ namespace ujson {
     //--------------------------------------------------------------------------
     void jvalue::num (const double n)
     {
+        if (jtype == j_number  &&  repr == num_text)
+            reset ();
         type (j_number);
 #if UJSON_HAVE_GMPXX
         std::stringstream ss;
         ss << std::setprecision(std::numeric_limits<double>::digits10 + 1) << n;
-        *v.jnum = ss.str();
+        if (repr != num_jnum) {
+            new (&v.jnum) num_t (ss.str());
+            repr = num_jnum;
+        }else{
+            v.jnum = ss.str();
+        }
 #else
         v.jnum = n;
 #endif
@@ -647,9 +1407,15 @@ namespace ujson {
     //--------------------------------------------------------------------------
     void jvalue::num (const long n)
     {
+        if (jtype == j_number  &&  repr == num_text)
+            reset ();
         type (j_number);
 #if UJSON_HAVE_GMPXX
-        *v.jnum = n;
+        if (repr == num_jnum)
+            std::destroy_at (&v.jnum);
+        repr = num_long;
+        num_prec = 0;
+        v.jlong = n;
 #else
         v.jnum = static_cast<num_t> (n);
 #endif
@@ -691,32 +1457,37 @@ namespace ujson {
     {
         switch (jtype) {
         case j_object:
-            if (v.jobj) {
-                delete v.jobj;
-                v.jobj = nullptr;
+            if (v.jc.jobj) {
+                delete_value (v.jc.jobj, in_arena);
+                v.jc.jobj = nullptr;
             }
             break;
 
         case j_array:
-            if (v.jarray) {
-                delete v.jarray;
-                v.jarray = nullptr;
+            if (v.jc.jarray) {
+                delete_value (v.jc.jarray, in_arena);
+                v.jc.jarray = nullptr;
             }
             break;
 
         case j_string:
-            if (v.jstr) {
-                delete v.jstr;
-                v.jstr = nullptr;
-            }
+            if (repr == str_borrowed)
+                repr = num_jnum;
+            else
+                std::destroy_at (&v.jstr);
             break;
 
 #if UJSON_HAVE_GMPXX
         case j_number:
-            if (v.jnum) {
-                delete v.jnum;
-                v.jnum = nullptr;
-            }
+            if (repr == num_jnum)
+                std::destroy_at (&v.jnum);
+            else if (repr == num_text)
+                std::destroy_at (&v.jstr);
+            break;
+#else
+        case j_number:
+            if (repr == num_text)
+                std::destroy_at (&v.jstr);
             break;
 #endif
         default:
@@ -743,21 +1514,26 @@ namespace ujson {
         // Allocate and initialize resources
         switch (jtype) {
         case j_object:
-            v.jobj = new json_object;
+            v.jc.jobj = new_value<json_object> (in_arena);
+            v.jc.hash_cached = false;
             break;
 
         case j_array:
-            v.jarray = new json_array;
+            v.jc.jarray = new_value<json_array> (in_arena);
+            v.jc.hash_cached = false;
             break;
 
         case j_string:
-            v.jstr = new std::string;
+            new (&v.jstr) std::string;
             break;
 
         case j_number:
 #if UJSON_HAVE_GMPXX
-            v.jnum = new num_t (0);
+            repr = num_long;
+            num_prec = 0;
+            v.jlong = 0;
 #else
+            repr = num_jnum;
             v.jnum = 0.0;
 #endif
             break;
@@ -780,13 +1556,79 @@ namespace ujson {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue jvalue::share () const
+    {
+        jvalue value;
+        if (is_container()  &&  !in_arena)
+            value.share_from (*this);
+        else
+            value.copy (*this);
+        return value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jvalue::shared () const
+    {
+        const void* node = jtype==j_object ? (const void*) v.jc.jobj :
+                           jtype==j_array  ? (const void*) v.jc.jarray : nullptr;
+        return node  &&  !in_arena  &&  node_refs(node).load(std::memory_order_acquire) > 1;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Share the object or array in 'rval', which is not in an arena.
+    //--------------------------------------------------------------------------
+    void jvalue::share_from (const jvalue& rval)
+    {
+        reset ();
+        jtype = rval.jtype;
+        in_arena = false;
+        v.jc = rval.v.jc;
+        node_refs(jtype==j_object ? (const void*)v.jc.jobj : (const void*)v.jc.jarray)
+            .fetch_add (1, std::memory_order_relaxed);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Called by non-const methods that may change the object or array.
+    //--------------------------------------------------------------------------
+    void jvalue::before_change ()
+    {
+        v.jc.hash_cached = false;
+        if (!shared())
+            return;
+
+        // Copy the object or array. The members or items of the
+        // copy share the objects and arrays in the original.
+        struct share_copies_guard_t {
+            share_copies_guard_t () {share_copies = true;}
+            ~share_copies_guard_t () {share_copies = false;}
+        } guard;
+        bool arena;
+        if (jtype == j_object) {
+            auto* node = new_value<json_object> (arena, *v.jc.jobj);
+            delete_value (v.jc.jobj, in_arena);
+            v.jc.jobj = node;
+        }else{
+            auto* node = new_value<json_array> (arena, *v.jc.jarray);
+            delete_value (v.jc.jarray, in_arena);
+            v.jc.jarray = node;
+        }
+        in_arena = arena;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvalue::has (const std::string& name) const
     {
         bool found = false;
         if (type() == j_object) {
-            auto range = v.jobj->equal_range (name);
+            auto range = v.jc.jobj->equal_range (lookup_key(name));
             for (auto i=range.first; !found && i!=range.second; ++i) {
                 if (i->second.valid())
                     found = true;
@@ -805,8 +1647,9 @@ namespace ujson {
             throw ujson::json_type_error ("Not a JSON object");
         }
 
-        auto entry = find_last_in_jobj (name, *v.jobj);
-        if (entry != v.jobj->send())
+        before_change ();
+        auto entry = find_last_in_jobj (name, *v.jc.jobj);
+        if (entry != v.jc.jobj->send())
             return entry->second;
 
         // Name not found, return an invalid json value
@@ -815,6 +1658,28 @@ namespace ujson {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jvalue& jvalue::get (const std::string& name) const
+    {
+        if (type() != j_object) {
+            // This is not a json object
+            throw ujson::json_type_error ("Not a JSON object");
+        }
+
+        // The last valid value with the name
+        auto range = v.jc.jobj->equal_range (lookup_key(name));
+        for (auto entry=range.second; entry!=range.first; ) {
+            --entry;
+            if (entry->second.valid())
+                return entry->second;
+        }
+
+        // Name not found, return an invalid json value
+        return const_invalid_jvalue;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue& jvalue::get_unique (const std::string& name)
@@ -824,7 +1689,8 @@ namespace ujson {
             throw ujson::json_type_error ("Not a JSON object");
         }
 
-        auto items = v.jobj->equal_range (name);
+        before_change ();
+        auto items = v.jc.jobj->equal_range (lookup_key(name));
         if (items.first == items.second) {
             // Name not found, return an invalid json value
             invalid_jvalue.type (j_invalid);
@@ -849,14 +1715,15 @@ namespace ujson {
         if (type() != j_object)
             throw ujson::json_type_error ("Not a JSON object");
 
-        auto entry = find_last_in_jobj (name, *v.jobj);
-        if (entry != v.jobj->send()) {
+        before_change ();
+        auto entry = find_last_in_jobj (name, *v.jc.jobj);
+        if (entry != v.jc.jobj->send()) {
             // Found a valid json value associated with 'name'
             return entry->second;
         }else{
             // 'name' not found, create an null json
             // value associated with 'name'.
-            return v.jobj->emplace_back (name, jvalue(j_null)).second;
+            return v.jc.jobj->emplace_back (name, jvalue(j_null)).second;
         }
     }
 
@@ -868,10 +1735,25 @@ namespace ujson {
         if (type() != j_array)
             throw ujson::json_type_error ("Not a JSON array");
 
-        if (index >= v.jarray->size())
+        if (index >= v.jc.jarray->size())
             throw std::out_of_range ("Array index out of range");
 
-        return v.jarray->operator[] (index);
+        before_change ();
+        return v.jc.jarray->operator[] (index);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jvalue& jvalue::operator[] (const size_t index) const
+    {
+        if (type() != j_array)
+            throw ujson::json_type_error ("Not a JSON array");
+
+        if (index >= v.jc.jarray->size())
+            throw std::out_of_range ("Array index out of range");
+
+        return v.jc.jarray->operator[] (index);
     }
 
 
@@ -880,14 +1762,29 @@ namespace ujson {
     size_t jvalue::size () const
     {
         if (jtype == j_object)
-            return v.jobj->size ();
+            return v.jc.jobj->size ();
         else if (jtype == j_array)
-            return v.jarray->size ();
+            return v.jc.jarray->size ();
         else
             throw ujson::json_type_error ("Not a JSON object or array");
     }
 
 
+    //--------------------------------------------------------------------------
+    // Used by emplace(). Return the last attribute with a specific
+    // name, or nullptr if not found, in a JSON object about to change.
+    //--------------------------------------------------------------------------
+    jvalue* jvalue::last_member (const std::string& name)
+    {
+        if (type() != j_object)
+            throw ujson::json_type_error ("Not a JSON object");
+
+        before_change ();
+        auto entry = find_last_in_jobj (name, *v.jc.jobj);
+        return entry == v.jc.jobj->send() ? nullptr : &entry->second;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue& jvalue::add (const std::string& name,
@@ -900,9 +1797,10 @@ namespace ujson {
         if (!value.valid())
             throw std::invalid_argument ("Invalid JSON value");
 
-        auto entry = find_last_in_jobj (name, *v.jobj);
-        if (entry == v.jobj->send() || overwrite==false) {
-            return v.jobj->emplace_back(name, value).second;
+        before_change ();
+        auto entry = find_last_in_jobj (name, *v.jc.jobj);
+        if (entry == v.jc.jobj->send() || overwrite==false) {
+            return v.jc.jobj->emplace_back(name, value).second;
         }else{
             entry->second = value;
             return entry->second;
@@ -922,9 +1820,10 @@ namespace ujson {
         if (!value.valid())
             throw std::invalid_argument ("Invalid JSON value");
 
-        auto entry = find_last_in_jobj (name, *v.jobj);
-        if (entry == v.jobj->send() || overwrite==false) {
-            return v.jobj->emplace_back(name, std::forward<jvalue&&>(value)).second;
+        before_change ();
+        auto entry = find_last_in_jobj (name, *v.jc.jobj);
+        if (entry == v.jc.jobj->send() || overwrite==false) {
+            return v.jc.jobj->emplace_back(name, std::forward<jvalue&&>(value)).second;
         }else{
             entry->second = std::forward<jvalue&&> (value);
             return entry->second;
@@ -942,7 +1841,8 @@ namespace ujson {
         if (!value.valid())
             throw std::invalid_argument ("Invalid JSON value");
 
-        return v.jarray->emplace_back (value);
+        before_change ();
+        return v.jc.jarray->emplace_back (value);
     }
 
 
@@ -956,7 +1856,26 @@ namespace ujson {
         if (!value.valid())
             throw std::invalid_argument ("Invalid JSON value");
 
-        return v.jarray->emplace_back (std::forward<jvalue&&>(value));
+        before_change ();
+        return v.jc.jarray->emplace_back (std::forward<jvalue&&>(value));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::reserve (size_t capacity)
+    {
+        if (jtype == j_object) {
+            before_change ();
+            v.jc.jobj->reserve (capacity);
+        }
+        else if (jtype == j_array) {
+            before_change ();
+            v.jc.jarray->reserve (capacity);
+        }
+        else {
+            throw ujson::json_type_error ("Not a JSON object or array");
+        }
     }
 
 
@@ -964,7 +1883,10 @@ namespace ujson {
     //--------------------------------------------------------------------------
     bool jvalue::remove (const std::string& name)
     {
-        return type()==j_object && v.jobj->erase(name) > 0;
+        if (type() != j_object)
+            return false;
+        before_change ();
+        return v.jc.jobj->erase(lookup_key(name)) > 0;
     }
 
 
@@ -974,9 +1896,10 @@ namespace ujson {
     {
         bool retval = false;
         if (type() == j_array) {
-            auto i = v.jarray->begin() + n;
-            if (i != v.jarray->end()) {
-                v.jarray->erase (i);
+            before_change ();
+            auto i = v.jc.jarray->begin() + n;
+            if (i != v.jc.jarray->end()) {
+                v.jc.jarray->erase (i);
                 retval = true;
             }
         }
@@ -988,6 +1911,13 @@ namespace ujson {
     //--------------------------------------------------------------------------
     void jvalue::copy (const jvalue& rval)
     {
+        if (share_copies  &&  rval.is_container()  &&  !rval.in_arena) {
+            share_from (rval);
+            return;
+        }
+        if (shared())
+            reset (); // Don't change the shared object or array
+
         type (rval.type());
 
         switch (type()) {
@@ -995,24 +1925,68 @@ namespace ujson {
             break;
 
         case j_object:
-            v.jobj->clear ();
-            *v.jobj = *rval.v.jobj;
+            v.jc.jobj->clear ();
+            *v.jc.jobj = *rval.v.jc.jobj;
+            v.jc.hash = rval.v.jc.hash;
+            v.jc.hash_cached = rval.v.jc.hash_cached;
             break;
 
         case j_array:
-            v.jarray->clear ();
-            *v.jarray = *rval.v.jarray;
+            v.jc.jarray->clear ();
+            *v.jc.jarray = *rval.v.jc.jarray;
+            v.jc.hash = rval.v.jc.hash;
+            v.jc.hash_cached = rval.v.jc.hash_cached;
             break;
 
         case j_string:
-            *v.jstr = *rval.v.jstr;
+            // A copy of a borrowed string is not borrowed,
+            // it may outlive the parsed buffer.
+            if (repr == str_borrowed) {
+                new (&v.jstr) std::string (rval.str_view());
+                repr = num_jnum;
+            }else{
+                v.jstr = rval.str_view ();
+            }
             break;
 
         case j_number:
+            if (repr == num_text  ||  rval.repr == num_text) {
+                if (repr == num_text  &&  rval.repr == num_text) {
+                    v.jstr = rval.v.jstr;
+                    break;
+                }
+                reset ();
+                jtype = j_number;
+                if (rval.repr == num_text) {
+                    new (&v.jstr) std::string (rval.v.jstr);
+                    repr = num_text;
+                    break;
+                }
 #if UJSON_HAVE_GMPXX
-            if (rval.v.jnum->get_prec() != v.jnum->get_prec())
-                v.jnum->set_prec (rval.v.jnum->get_prec());
-            *v.jnum = *rval.v.jnum;;
+                repr = num_long;
+#else
+                repr = num_jnum;
+#endif
+            }
+#if UJSON_HAVE_GMPXX
+            if (rval.repr != num_jnum) {
+                if (repr == num_jnum)
+                    std::destroy_at (&v.jnum);
+                repr = rval.repr;
+                num_prec = rval.num_prec;
+                if (repr == num_long)
+                    v.jlong = rval.v.jlong;
+                else
+                    v.jdbl = rval.v.jdbl;
+            }
+            else if (repr != num_jnum) {
+                new (&v.jnum) num_t (rval.v.jnum);
+                repr = num_jnum;
+            }else{
+                if (rval.v.jnum.get_prec() != v.jnum.get_prec())
+                    v.jnum.set_prec (rval.v.jnum.get_prec());
+                v.jnum = rval.v.jnum;
+            }
 #else
             v.jnum = rval.v.jnum;
 #endif
@@ -1035,34 +2009,56 @@ namespace ujson {
         reset ();
 
         jtype = rval.type ();
+        in_arena = rval.in_arena;
 
         switch (jtype) {
         case j_invalid:
             break;
 
         case j_object:
-            v.jobj = rval.v.jobj;
-            rval.v.jobj = nullptr;
+            v.jc.jobj = rval.v.jc.jobj;
+            v.jc.hash = rval.v.jc.hash;
+            v.jc.hash_cached = rval.v.jc.hash_cached;
+            rval.v.jc.jobj = nullptr;
             rval.jtype = j_null;
             break;
 
         case j_array:
-            v.jarray = rval.v.jarray;
-            rval.v.jarray = nullptr;
+            v.jc.jarray = rval.v.jc.jarray;
+            v.jc.hash = rval.v.jc.hash;
+            v.jc.hash_cached = rval.v.jc.hash_cached;
+            rval.v.jc.jarray = nullptr;
             rval.jtype = j_null;
             break;
 
         case j_string:
-            v.jstr = rval.v.jstr;
-            rval.v.jstr = nullptr;
+            if (rval.repr == str_borrowed) {
+                v.jview = rval.v.jview;
+                repr = str_borrowed;
+                rval.repr = num_jnum;
+            }else{
+                new (&v.jstr) std::string (std::move(rval.v.jstr));
+                std::destroy_at (&rval.v.jstr);
+            }
             rval.jtype = j_null;
             break;
 
         case j_number:
-            v.jnum = rval.v.jnum;
+            repr = rval.repr;
+            if (repr == num_text) {
+                new (&v.jstr) std::string (std::move(rval.v.jstr));
+                std::destroy_at (&rval.v.jstr);
+                rval.jtype = j_null;
+                break;
+            }
 #if UJSON_HAVE_GMPXX
-            rval.v.jnum = nullptr;
+            // The move constructor of mpf_class allocates new limbs
+            // for the moved-from object. Relocate the mpf_t instead,
+            // the moved-from number is not destroyed.
+            num_prec = rval.num_prec;
+            std::memcpy (static_cast<void*>(&v.jnum), &rval.v.jnum, sizeof(num_t));
 #else
+            v.jnum = rval.v.jnum;
             rval.v.jnum = 0.0;
 #endif
             rval.jtype = j_null;
@@ -1083,11 +2079,113 @@ namespace ujson {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     std::string jvalue::describe (desc_format_t fmt,
-                                  unsigned starting_indent_depth) const
+                                  unsigned starting_indent_depth,
+                                  unsigned num_threads,
+                                  size_t min_elements) const
     {
-        std::stringstream ss;
-        describe (ss, fmt, starting_indent_depth);
-        return ss.str ();
+        std::string result;
+        jwriter out (result);
+        describe_parallel (out, fmt, starting_indent_depth, num_threads, min_elements);
+        out.flush ();
+        return result;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // The statistics are collected by a separate walk of the value
+    // after the output is written, so describe() isn't slowed down.
+    //--------------------------------------------------------------------------
+    std::string jvalue::describe (desc_format_t fmt, jstats& stats) const
+    {
+        stats = jstats ();
+#if UJSON_COLLECT_STATS
+        auto start = std::chrono::steady_clock::now ();
+        auto result = describe (fmt, 0);
+        stats.build_time = std::chrono::steady_clock::now() - start;
+
+        stats.bytes = result.size ();
+        for (size_t capacity=std::string().capacity(); capacity<result.size(); capacity*=2)
+            ++stats.allocations;
+        count_output (fmt, 0, stats);
+        return result;
+#else
+        return describe (fmt, 0);
+#endif
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::write (std::string& out,
+                        desc_format_t fmt,
+                        unsigned starting_indent_depth,
+                        unsigned num_threads,
+                        size_t min_elements) const
+    {
+        jwriter writer (out);
+        describe_parallel (writer, fmt, starting_indent_depth, num_threads, min_elements);
+        writer.flush ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::write (const write_handler_t& handler,
+                        desc_format_t fmt,
+                        unsigned starting_indent_depth,
+                        unsigned num_threads,
+                        size_t min_elements) const
+    {
+        jwriter out (handler);
+        describe_parallel (out, fmt, starting_indent_depth, num_threads, min_elements);
+        out.flush ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::write (std::ostream& out,
+                        desc_format_t fmt,
+                        unsigned starting_indent_depth,
+                        unsigned num_threads,
+                        size_t min_elements) const
+    {
+        write ([&out](const char* data, size_t size) {
+                   out.write (data, size);
+               },
+               fmt,
+               starting_indent_depth,
+               num_threads,
+               min_elements);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jvalue::write (int fd,
+                        desc_format_t fmt,
+                        unsigned starting_indent_depth,
+                        unsigned num_threads,
+                        size_t min_elements) const
+    {
+        bool ok = true;
+        write ([fd, &ok](const char* data, size_t size) {
+                   while (ok && size > 0) {
+                       auto result = ::write (fd, data, size);
+                       if (result >= 0) {
+                           data += result;
+                           size -= result;
+                       }
+                       else if (errno != EINTR) {
+                           ok = false;
+                       }
+                   }
+               },
+               fmt,
+               starting_indent_depth,
+               num_threads,
+               min_elements);
+        return ok;
     }
 
 
@@ -1116,72 +2214,395 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    inline static void put_indent (std::stringstream& ss,
+    inline static void put_indent (jwriter& out,
                                    desc_format_t fmt,
                                    unsigned depth)
     {
-        ss << std::endl;
-        for (unsigned n=0; n<depth; ++n) {
-            if (fmt & fmt_tabs)
-                ss << '\t';
-            else
-                ss << "    ";
+        out.write_indent (depth, fmt & fmt_tabs);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Check if an object member name can be written without
+    // quotes in relaxed mode. That is, if it is an identifier,
+    // [_a-zA-Z][_a-zA-Z0-9]*, and not a reserved name.
+    //--------------------------------------------------------------------------
+    static bool is_unquoted_name (const std::string& name)
+    {
+        if (name.empty() || (name[0]>='0' && name[0]<='9'))
+            return false;
+        for (char ch : name) {
+            if (!((ch>='a' && ch<='z') || (ch>='A' && ch<='Z') || (ch>='0' && ch<='9') || ch=='_'))
+                return false;
+        }
+        if (name.size()==4 || name.size()==5) {
+            std::string lower (name);
+            for (auto& ch : lower)
+                ch |= 0x20; // Only letters, digits and '_' here
+            if (lower=="true" || lower=="false" || lower=="null")
+                return false;
+        }
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Used by jvalue::describe_parallel() to serialize a value using
+    // multiple threads. The value is first written as usual, but the
+    // elements of large arrays and objects are collected in chunks
+    // instead of being written. The output is then a list of segments:
+    // text written while planning, and chunks that are serialized by
+    // worker threads. The segments are written in order, so the
+    // output is the same as when serialized by a single thread.
+    //--------------------------------------------------------------------------
+    class describe_plan {
+    public:
+        describe_plan (unsigned num_threads_arg, size_t min_elements_arg)
+            : num_threads {num_threads_arg},
+              min_elements {min_elements_arg}
+        {
+            segments.emplace_back ();
+        }
+
+        // Check if an array or object is split in chunks
+        bool split (size_t size) const {
+            return size >= min_elements;
+        }
+
+        // Text written while planning
+        void append (const char* data, size_t size) {
+            segments.back().text.append (data, size);
+        }
+
+        bool split_members (jwriter& out,
+                            const jvalue& obj,
+                            desc_format_t fmt,
+                            unsigned indent_depth,
+                            json_object::const_iterator i,
+                            json_object::const_iterator end);
+
+        void split_elements (jwriter& out,
+                             const jvalue& array,
+                             desc_format_t fmt,
+                             unsigned indent_depth);
+
+        void write (jwriter& out);
+
+
+    private:
+        struct segment_t {
+            std::string text;
+            const jvalue* container {nullptr}; // nullptr if text written while planning
+            desc_format_t fmt {fmt_none};
+            unsigned indent_depth {0};
+            bool first {true};
+            size_t index {0};      // Array elements
+            size_t index_end {0};
+            json_object::const_iterator member; // Object members
+            json_object::const_iterator member_end;
+            bool done {false};
+            std::exception_ptr error;
+        };
+
+        unsigned num_threads;
+        size_t min_elements;
+        std::vector<segment_t> segments;
+        std::vector<size_t> chunks; // Indexes of segments serialized by worker threads
+
+        bool split_value (const jvalue& value) const {
+            return value.is_container() && split(value.size());
         }
+        size_t chunk_size (size_t size) const {
+            return std::clamp (size / (num_threads * 8), (size_t)16, (size_t)16384);
+        }
+        void add_chunk (jwriter& out, segment_t&& chunk);
+        void serialize (segment_t& chunk);
+    };
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void describe_plan::add_chunk (jwriter& out, segment_t&& chunk)
+    {
+        out.flush (); // Text written before the chunk
+        chunks.emplace_back (segments.size());
+        segments.emplace_back (std::move(chunk));
+        segments.emplace_back ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Split object members in chunks. Members that are large
+    // arrays or objects are written, and split, while planning.
+    //--------------------------------------------------------------------------
+    bool describe_plan::split_members (jwriter& out,
+                                       const jvalue& obj,
+                                       desc_format_t fmt,
+                                       unsigned indent_depth,
+                                       json_object::const_iterator i,
+                                       json_object::const_iterator end)
+    {
+        const size_t max_items = chunk_size (obj.size());
+        bool first = true;
+        while (i != end) {
+            segment_t chunk;
+            chunk.container = &obj;
+            chunk.fmt = fmt;
+            chunk.indent_depth = indent_depth;
+            chunk.first = first;
+            chunk.member = i;
+            size_t n = 0;
+            for (; i!=end && n<max_items && !split_value(i->second); ++i, ++n) {
+                if (i->second.valid())
+                    first = false;
+            }
+            chunk.member_end = i;
+            if (n)
+                add_chunk (out, std::move(chunk));
+            if (i!=end && split_value(i->second)) {
+                auto next = std::next (i);
+                first = obj.describe_members (out, fmt, indent_depth, i, next, first, this);
+                i = next;
+            }
+        }
+        return first;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Split array elements in chunks. Elements that are large
+    // arrays or objects are written, and split, while planning.
+    //--------------------------------------------------------------------------
+    void describe_plan::split_elements (jwriter& out,
+                                        const jvalue& array,
+                                        desc_format_t fmt,
+                                        unsigned indent_depth)
+    {
+        auto& elements = *array.v.jc.jarray;
+        const size_t max_items = chunk_size (elements.size());
+        bool first = true;
+        size_t i = 0;
+        while (i < elements.size()) {
+            segment_t chunk;
+            chunk.container = &array;
+            chunk.fmt = fmt;
+            chunk.indent_depth = indent_depth;
+            chunk.first = first;
+            chunk.index = i;
+            size_t n = 0;
+            for (; i<elements.size() && n<max_items && !split_value(elements[i]); ++i, ++n) {
+                if (elements[i].valid())
+                    first = false;
+            }
+            chunk.index_end = i;
+            if (n)
+                add_chunk (out, std::move(chunk));
+            if (i<elements.size() && split_value(elements[i])) {
+                first = array.describe_elements (out, fmt, indent_depth, i, i+1, first, this);
+                ++i;
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void describe_plan::serialize (segment_t& chunk)
+    {
+        jwriter out (chunk.text);
+        if (chunk.container->type() == j_object) {
+            chunk.container->describe_members (out, chunk.fmt, chunk.indent_depth,
+                                               chunk.member, chunk.member_end,
+                                               chunk.first, nullptr);
+        }else{
+            chunk.container->describe_elements (out, chunk.fmt, chunk.indent_depth,
+                                                chunk.index, chunk.index_end,
+                                                chunk.first, nullptr);
+        }
+        out.flush ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Serialize the chunks using worker threads while the segments
+    // are written in order. To limit the memory used, a worker may
+    // not serialize a chunk too far ahead of the written output.
+    //--------------------------------------------------------------------------
+    void describe_plan::write (jwriter& out)
+    {
+        const size_t max_ahead = num_threads * 4;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::atomic<size_t> next_chunk {0};
+        size_t written_chunks = 0;
+        bool abort = false;
+
+        auto worker = [&] () {
+            size_t n;
+            while ((n = next_chunk++) < chunks.size()) {
+                {
+                    std::unique_lock<std::mutex> lock (mutex);
+                    cond.wait (lock, [&]{ return abort || n < written_chunks + max_ahead; });
+                    if (abort)
+                        return;
+                }
+                auto& chunk = segments[chunks[n]];
+                try {
+                    serialize (chunk);
+                }
+                catch (...) {
+                    chunk.error = std::current_exception ();
+                }
+                {
+                    std::lock_guard<std::mutex> lock (mutex);
+                    chunk.done = true;
+                }
+                cond.notify_all ();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        try {
+            auto num_workers = std::min ((size_t)num_threads, chunks.size());
+            for (size_t i=0; i<num_workers; ++i)
+                threads.emplace_back (worker);
+
+            for (auto& segment : segments) {
+                if (segment.container) {
+                    std::unique_lock<std::mutex> lock (mutex);
+                    cond.wait (lock, [&segment]{ return segment.done; });
+                    lock.unlock ();
+                    if (segment.error)
+                        std::rethrow_exception (segment.error);
+                    out.write (segment.text);
+                    std::string().swap (segment.text);
+                    lock.lock ();
+                    ++written_chunks;
+                    lock.unlock ();
+                    cond.notify_all ();
+                }else{
+                    out.write (segment.text);
+                }
+            }
+        }
+        catch (...) {
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                abort = true;
+            }
+            cond.notify_all ();
+            for (auto& t : threads)
+                t.join ();
+            throw;
+        }
+        for (auto& t : threads)
+            t.join ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvalue::describe_parallel (jwriter& out,
+                                    desc_format_t fmt,
+                                    unsigned indent_depth,
+                                    unsigned num_threads,
+                                    size_t min_elements) const
+    {
+        if (num_threads == 0)
+            num_threads = std::thread::hardware_concurrency ();
+        if (num_threads <= 1 || !is_container()) {
+            describe (out, fmt, indent_depth);
+            return;
+        }
+
+        describe_plan plan (num_threads, min_elements);
+        jwriter::handler_t append = [&plan](const char* data, size_t size) {
+            plan.append (data, size);
+        };
+        jwriter planner (append);
+        describe (planner, fmt, indent_depth, &plan);
+        planner.flush ();
+
+        plan.write (out);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::describe (std::stringstream& ss,
+    void jvalue::describe (jwriter& out,
                            desc_format_t fmt,
-                           unsigned indent_depth) const
+                           unsigned indent_depth,
+                           describe_plan* plan) const
     {
         switch (type()) {
         case j_object:
-            describe_object (ss, fmt, indent_depth);
+            describe_object (out, fmt, indent_depth, plan);
             break;
 
         case j_array:
-            describe_array (ss, fmt, indent_depth);
+            describe_array (out, fmt, indent_depth, plan);
             break;
 
         case j_string:
+            out.put ('"');
             if ((fmt & fmt_color) && HAS_COLOR) {
-                ss << '"';
-                ss << color_string << escape(*v.jstr, (fmt&fmt_escape_slash)) << color_normal;
-                ss << '"';
+                out.write (color_string);
+                out.write_escaped (str_view(), fmt & fmt_escape_slash);
+                out.write (color_normal);
             }else{
-                ss << '"' << escape(*v.jstr, fmt&fmt_escape_slash) << '"';
+                out.write_escaped (str_view(), fmt & fmt_escape_slash);
             }
+            out.put ('"');
             break;
 
         case j_number:
+            if (repr == num_text) {
+                out.write (v.jstr);
+                break;
+            }
 #if UJSON_HAVE_GMPXX
-            num_t_to_str (const_cast<jvalue*>(this)->mpf(), ss);
+            switch (repr) {
+            case num_long:
+                native_num_to_str (v.jlong, out);
+                break;
+            case num_dbl:
+                native_num_to_str (v.jdbl, out);
+                break;
+            default:
+                num_t_to_str (v.jnum, out);
+            }
 #else
-            if (std::isinf(num()) || std::isnan(num()))
-                ss << "null";
-            else
-                ss << std::setprecision(std::numeric_limits<num_t>::digits10 + 1) << num();
+            if (std::isinf(num()) || std::isnan(num())) {
+                out.write ("null", 4);
+            }else{
+                // Same as written to a stream with this precision
+                char buf[32];
+                auto result = std::to_chars (buf, buf+sizeof(buf), num(),
+                                             std::chars_format::general,
+                                             std::numeric_limits<num_t>::digits10 + 1);
+                out.write (buf, result.ptr - buf);
+            }
 #endif
             break;
 
         case j_bool:
             if ((fmt & fmt_color) && HAS_COLOR) {
-                if (boolean())
-                    ss << color_boolean_true << "true" << color_normal;
-                else
-                    ss << boolean_false_color << "false" << color_normal;
+                out.write (boolean() ? color_boolean_true : boolean_false_color);
+                out.write (boolean() ? "true" : "false");
+                out.write (color_normal);
             }else{
-                ss << (boolean() ? "true" : "false");
+                out.write (boolean() ? "true" : "false");
             }
             break;
 
         case j_null:
-            if ((fmt & fmt_color) && HAS_COLOR)
-                ss << null_color << "null" << color_normal;
-            else
-                ss << "null";
+            if ((fmt & fmt_color) && HAS_COLOR) {
+                out.write (null_color);
+                out.write ("null", 4);
+                out.write (color_normal);
+            }else{
+                out.write ("null", 4);
+            }
             break;
 
         case j_invalid:
@@ -1193,100 +2614,177 @@ namespace ujson {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::describe_object (std::stringstream& ss,
+    void jvalue::describe_object (jwriter& out,
                                   desc_format_t fmt,
-                                  unsigned indent_depth) const
-    {
-        static const std::regex re_identifier ("[_a-zA-Z][_a-zA-Z0-9]*",
-                                               std::regex::ECMAScript);
-        static const std::regex re_reserved ("([tT][rR][uU][eE])|"
-                                             "([fF][aA][lL][sS][eE])|"
-                                             "([nN][uU][lL][lL])",
-                                             std::regex::ECMAScript);
-        std::cmatch re_match;
+                                  unsigned indent_depth,
+                                  describe_plan* plan) const
+    {
+        bool color = (fmt & fmt_color) && HAS_COLOR;
         bool first {true};
 
-        if ((fmt & fmt_color) && HAS_COLOR)
-            ss << object_color << '{' << color_normal;
-        else
-            ss << '{';
+        if (color) {
+            out.write (object_color);
+            out.put ('{');
+            out.write (color_normal);
+        }else{
+            out.put ('{');
+        }
 
-        auto& members = *v.jobj;
+        auto& members = *v.jc.jobj;
 
         bool one_liner = members.size()==1 &&
             (members.front().second.is_container()==false || members.front().second.size()==0);
 
         if (!members.empty()) {
-            auto i = (fmt & fmt_sorted) ? members.sbegin() : members.begin();
-            auto member_end = (fmt & fmt_sorted) ? members.send() : members.end();
-            for (; i!=member_end; ++i) {
-                if (! i->second.valid())
-                    continue; // Skip invalid values
-                auto& name = i->first;
-                auto& value = i->second;
-                bool quoted_name = true;
-                if (fmt & fmt_relaxed) {
-                    // In relaxed mode, if the member name is an 'identifier',
-                    // print it without enclosing double quotes. Unless it
-                    // is a reserved name.
-                    if (std::regex_match (name.c_str(), re_match, re_identifier) &&
-                        ! std::regex_match (name.c_str(), re_match, re_reserved))
-                    {
-                        quoted_name = false;
-                    }
-                }
-                if (first)
-                    first = false;
-                else
-                    ss << ',';
-                if (fmt & fmt_pretty) {
-                    if (!one_liner)
-                        put_indent (ss, fmt, indent_depth+1); //ss << std::endl << indent;
-                }
-
-                if ((fmt & fmt_color) && HAS_COLOR) {
-                    if (quoted_name) {
-                        ss << '"' << attribute_color << escape(name, (fmt & fmt_escape_slash)) << color_normal << '"';
-                    }else{
-                        ss << attribute_color << name << color_normal;
-                    }
-                }else{
-                    if (quoted_name)
-                        ss << '"' << escape(name, (fmt & fmt_escape_slash)) << '"';
-                    else
-                        ss << name;
-                }
-
-                ss << ((fmt & fmt_pretty) ? ": " : ":");
-                value.describe (ss, fmt, indent_depth+1);
-            }
+            auto i = (fmt & fmt_sorted) ? members.csbegin() : members.cbegin();
+            auto member_end = (fmt & fmt_sorted) ? members.csend() : members.cend();
+            if (plan && plan->split(members.size()))
+                first = plan->split_members (out, *this, fmt, indent_depth, i, member_end);
+            else
+                first = describe_members (out, fmt, indent_depth, i, member_end, true, plan);
         }
         if ((fmt & fmt_pretty) && !first) {
             if (!one_liner)
-                put_indent (ss, fmt, indent_depth); //ss << std::endl << indent;
+                put_indent (out, fmt, indent_depth);
         }
-        if ((fmt & fmt_color) && HAS_COLOR)
-            ss << object_color << '}' << color_normal;
-        else
-            ss << '}';
+        if (color) {
+            out.write (object_color);
+            out.put ('}');
+            out.write (color_normal);
+        }else{
+            out.put ('}');
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write the object members from 'i' to 'end'. 'first' is true
+    // if no member is written before them. Return true if still
+    // no member is written.
+    //--------------------------------------------------------------------------
+    bool jvalue::describe_members (jwriter& out,
+                                   desc_format_t fmt,
+                                   unsigned indent_depth,
+                                   json_object::const_iterator i,
+                                   json_object::const_iterator end,
+                                   bool first,
+                                   describe_plan* plan) const
+    {
+        bool color = (fmt & fmt_color) && HAS_COLOR;
+        auto& members = *v.jc.jobj;
+
+        bool one_liner = members.size()==1 &&
+            (members.front().second.is_container()==false || members.front().second.size()==0);
+
+        for (; i!=end; ++i) {
+            if (! i->second.valid())
+                continue; // Skip invalid values
+            const std::string& name = i->first;
+            auto& value = i->second;
+            // In relaxed mode, if the member name is an 'identifier',
+            // print it without enclosing double quotes. Unless it
+            // is a reserved name.
+            bool quoted_name = !(fmt & fmt_relaxed) || !is_unquoted_name (name);
+            if (first)
+                first = false;
+            else
+                out.put (',');
+            if (fmt & fmt_pretty) {
+                if (!one_liner)
+                    put_indent (out, fmt, indent_depth+1);
+            }
+
+            if (quoted_name)
+                out.put ('"');
+            if (color)
+                out.write (attribute_color);
+            if (quoted_name)
+                out.write_escaped (name, fmt & fmt_escape_slash);
+            else
+                out.write (name);
+            if (color)
+                out.write (color_normal);
+            if (quoted_name)
+                out.put ('"');
+
+            if (fmt & fmt_pretty)
+                out.write (": ", 2);
+            else
+                out.put (':');
+            value.describe (out, fmt, indent_depth+1, plan);
+        }
+        return first;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void jvalue::describe_array (std::stringstream& ss,
+    void jvalue::describe_array (jwriter& out,
                                  desc_format_t fmt,
-                                 unsigned indent_depth) const
+                                 unsigned indent_depth,
+                                 describe_plan* plan) const
     {
-        auto& elements = *v.jarray;
+        bool color = (fmt & fmt_color) && HAS_COLOR;
+        auto& elements = *v.jc.jarray;
         if (elements.empty()) {
-            if ((fmt & fmt_color) && HAS_COLOR)
-                ss << array_color << "[]" << color_normal;
-            else
-                ss << "[]";
+            if (color) {
+                out.write (array_color);
+                out.write ("[]", 2);
+                out.write (color_normal);
+            }else{
+                out.write ("[]", 2);
+            }
             return;
         }
 
+        bool same_line = fmt & fmt_compact_array;
+
+        if (elements.size()==1 &&
+            (elements[0].is_container()==false || elements[0].size()==0))
+        {
+            same_line = true;
+        }
+
+        if (color) {
+            out.write (array_color);
+            out.put ('[');
+            out.write (color_normal);
+        }else{
+            out.put ('[');
+        }
+
+        if (plan && plan->split(elements.size()))
+            plan->split_elements (out, *this, fmt, indent_depth);
+        else
+            describe_elements (out, fmt, indent_depth, 0, elements.size(), true, plan);
+
+        if ((fmt & fmt_pretty) && !(fmt & same_line))
+            put_indent (out, fmt, indent_depth);
+        if (color) {
+            out.write (array_color);
+            out.put (']');
+            out.write (color_normal);
+        }else{
+            out.put (']');
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Write the array elements from index 'i' to 'end'. 'first' is
+    // true if no element is written before them. Return true if
+    // still no element is written.
+    //--------------------------------------------------------------------------
+    bool jvalue::describe_elements (jwriter& out,
+                                    desc_format_t fmt,
+                                    unsigned indent_depth,
+                                    size_t i,
+                                    size_t end,
+                                    bool first,
+                                    describe_plan* plan) const
+    {
+        auto& elements = *v.jc.jarray;
+
         unsigned next_indent_depth = indent_depth;
         bool same_line = fmt & fmt_compact_array;
 
@@ -1298,36 +2796,102 @@ namespace ujson {
         if (!same_line)
             ++next_indent_depth;
 
-        if ((fmt & fmt_color) && HAS_COLOR)
-            ss << array_color << '[' << color_normal;
-        else
-            ss << '[';
-
-        bool first {true};
-        for (auto& e : elements) {
+        for (; i<end; ++i) {
+            auto& e = elements[i];
             if (!e.valid())
                 continue; // Skip invalid values
             if (!first)
-                ss << ',';
+                out.put (',');
             if ((fmt & fmt_pretty)) {
                 if (fmt & same_line) {
                     if (!first)
-                        ss << ' ';
+                        out.put (' ');
                 }else{
-                    put_indent (ss, fmt, next_indent_depth);
+                    put_indent (out, fmt, next_indent_depth);
                 }
             }
             first = false;
-            e.describe (ss, fmt, next_indent_depth);
+            e.describe (out, fmt, next_indent_depth, plan);
         }
+        return first;
+    }
 
-        if ((fmt & fmt_pretty) && !(fmt & same_line))
-            put_indent (ss, fmt, indent_depth);
-        if ((fmt & fmt_color) && HAS_COLOR)
-            ss << array_color << ']' << color_normal;
-        else
-            ss << ']';
+
+#if UJSON_COLLECT_STATS
+    //--------------------------------------------------------------------------
+    // Count the tokens, nesting depth, and sizes, of the output
+    // written by describe(). Invalid values are skipped as there.
+    //--------------------------------------------------------------------------
+    void jvalue::count_output (desc_format_t fmt,
+                               unsigned depth,
+                               jstats& stats) const
+    {
+        const bool escape_slash = fmt & fmt_escape_slash;
+        size_t num_items = 0;
+
+        switch (type()) {
+        case j_object:
+            stats.max_depth = std::max (stats.max_depth, depth+1);
+            ++stats.tokens[parser::jtoken::tk_lcbrack];
+            for (auto& member : *v.jc.jobj) {
+                if (!member.second.valid())
+                    continue;
+                const std::string& name = member.first;
+                if ((fmt & fmt_relaxed) && is_unquoted_name(name)) {
+                    ++stats.tokens[parser::jtoken::tk_identifier];
+                }else{
+                    ++stats.tokens[parser::jtoken::tk_string];
+                    stats.escaped_strings += jwriter::needs_escape (name, escape_slash);
+                }
+                ++stats.tokens[parser::jtoken::tk_colon];
+                member.second.count_output (fmt, depth+1, stats);
+                ++num_items;
+            }
+            ++stats.tokens[parser::jtoken::tk_rcbrack];
+            stats.max_object_size = std::max (stats.max_object_size, num_items);
+            break;
+
+        case j_array:
+            stats.max_depth = std::max (stats.max_depth, depth+1);
+            ++stats.tokens[parser::jtoken::tk_lbrack];
+            for (auto& e : *v.jc.jarray) {
+                if (!e.valid())
+                    continue;
+                e.count_output (fmt, depth+1, stats);
+                ++num_items;
+            }
+            ++stats.tokens[parser::jtoken::tk_rbrack];
+            stats.max_array_size = std::max (stats.max_array_size, num_items);
+            break;
+
+        case j_string:
+            ++stats.tokens[parser::jtoken::tk_string];
+            stats.escaped_strings += jwriter::needs_escape (str_view(), escape_slash);
+            return;
+
+        case j_number:
+#if UJSON_HAVE_GMPXX
+            stats.mpf_numbers += repr == num_jnum;
+#endif
+            ++stats.tokens[parser::jtoken::tk_number];
+            return;
+
+        case j_bool:
+            ++stats.tokens[boolean() ? parser::jtoken::tk_true : parser::jtoken::tk_false];
+            return;
+
+        case j_null:
+            ++stats.tokens[parser::jtoken::tk_null];
+            return;
+
+        case j_invalid:
+        default:
+            return;
+        }
+        if (num_items > 1)
+            stats.tokens[parser::jtoken::tk_separator] += num_items - 1;
     }
+#endif
 
 
 }
@@ -20,14 +20,23 @@
 #define UJSON_JVALUE_HPP
 
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <ostream>
+#include <functional>
 #include <vector>
 #include <list>
 #include <memory>
 #include <cstdio>
 #include <cstdint>
+#include <utility>
+#include <tuple>
+#include <stdexcept>
 #include <ujson/multimap_list.hpp>
+#include <ujson/flat_multimap_list.hpp>
 #include <ujson/json_type_error.hpp>
+#include <ujson/jkey.hpp>
+#include <ujson/jstats.hpp>
 #include <ujson/config.hpp>
 #if UJSON_HAVE_GMPXX
 #  include <gmpxx.h>
@@ -226,8 +235,11 @@ namespace ujson {
     };
 
 
-    // Forward declaration.
+    // Forward declarations.
     class jvalue;
+    class jwriter;
+    class jtape_writer;
+    class describe_plan;
 
 
     /**
@@ -236,11 +248,29 @@ namespace ujson {
      */
     using json_pair = std::pair<std::string, jvalue>;
 
+    /**
+     * The key type of a JSON object.
+     * This is a ujson::jkey if the library is configured with cmake
+     * option <code>-DINTERNED_KEYS=True</code>, otherwise it is
+     * a <code>std::string</code>.
+     */
+#if UJSON_INTERNED_KEYS
+    using json_key = jkey;
+#else
+    using json_key = std::string;
+#endif
+
     /**
      * A representation of a JSON object.
      * A JSON object is a collection of named JSON values.
      */
-    using json_object = multimap_list<std::string, jvalue>;
+#if UJSON_FLAT_OBJECTS
+    using json_object = flat_multimap_list<json_key, jvalue>;
+#elif UJSON_UNSYNCHRONIZED_OBJECTS
+    using json_object = multimap_list<json_key, jvalue, std::less<json_key>, std::less<jvalue>, null_mutex>;
+#else
+    using json_object = multimap_list<json_key, jvalue>;
+#endif
 
     /**
      * A representation of a JSON array.
@@ -281,6 +311,8 @@ namespace ujson {
          * Copy constructor.
          * Makes a copy of another jvalue.
          * @param value The jvalue to copy.
+         * @see jvalue::share() to make a copy without copying
+         *      objects and arrays.
          */
         jvalue (const jvalue& value);
 
@@ -289,7 +321,7 @@ namespace ujson {
          * Move the content of another jvalue to this object.
          * @param value The jvalue to move.
          */
-        jvalue (jvalue&& value);
+        jvalue (jvalue&& value) noexcept;
 
         /**
          * Create a jvalue of type ujson::j_object and
@@ -444,7 +476,7 @@ namespace ujson {
          * Move the contents of another jvalue to this object.
          * @param value The jvalue to move.
          */
-        jvalue& operator= (jvalue&& value);
+        jvalue& operator= (jvalue&& value) noexcept;
 
         /**
          * Assignment operator.
@@ -636,6 +668,9 @@ namespace ujson {
          *        considered equal.
          *      - Comparing two invalid jvalues (both of type ujson::j_invalid)
          *        makes no sense and will always return <code>false</code>.
+         *      - Two objects or arrays that both have a cached hash value
+         *        (see jvalue::cache_hash) are not equal if the hash values
+         *        differ, and are compared no further.
          */
         bool operator== (const jvalue& rval) const;
 
@@ -647,6 +682,55 @@ namespace ujson {
          */
         bool operator!= (const jvalue& rval) const { return !(operator==(rval)); }
 
+        /**
+         * Return a hash value of this JSON value.
+         * The hash is calculated from the content of the value, and two
+         * values that are equal according to jvalue::operator== have the
+         * same hash value. The order of the attributes in an object, and
+         * how a number is represented internally, don't affect the hash.
+         * <br/>
+         * Objects and arrays with a cached hash value (see
+         * jvalue::cache_hash) return the cached value.
+         * @return A hash value.
+         * @see jvalue::operator==
+         */
+        size_t hash () const;
+
+        /**
+         * Calculate the hash value of this JSON value and cache it.
+         * The hash value of this object or array, and of each object and
+         * array in it, is kept in the value, so later calls to
+         * jvalue::hash are answered without walking the value, and
+         * jvalue::operator== returns <code>false</code> without walking
+         * two values if both have cached hash values that differ.
+         * This uses no extra memory, the hash is kept in the same
+         * space as the object or array.
+         * <br/>
+         * The cached hash value of an object or array is cleared when any
+         * of its non-const methods is called, and a value can't be changed
+         * without calling a non-const method on each object and array
+         * containing it. But references to values inside the object or
+         * array, that were taken before the hash was cached, must not
+         * be used to change them, since that will not clear the cached
+         * hash values of the objects and arrays containing them.
+         * <br/>
+         * This method changes the state of the value, and can't be called
+         * by more than one thread at a time for the same value.
+         * @return The hash value of this JSON value.
+         * @see jvalue::hash
+         */
+        size_t cache_hash () const;
+
+        /**
+         * Check if this is an object or array with a cached hash value.
+         * @return <code>true</code> if this is an object or array
+         *         with a cached hash value.
+         * @see jvalue::cache_hash
+         */
+        bool hash_cached () const {
+            return (jtype==j_object || jtype==j_array) && v.jc.hash_cached;
+        }
+
         /**
          * Check if this a JSON object.
          * @return <code>true</code> if this value
@@ -668,6 +752,14 @@ namespace ujson {
          */
         json_object& obj ();
 
+        /**
+         * Get a const reference to the ujson::json_object instance
+         * used by this jvalue instance to represent a JSON object.
+         * @return A const reference to a ujson::json_object.
+         * @throw ujson::json_type_error If this is not a JSON object.
+         */
+        const json_object& obj () const;
+
         /**
          * Assign a json_object to this jvalue, making this a JSON object.
          * Set the value type of this instance to ujson::j_object and
@@ -705,6 +797,14 @@ namespace ujson {
          */
         json_array& array ();
 
+        /**
+         * Get a const reference to the ujson::json_array instance
+         * used by this jvalue instance to represent a JSON array.
+         * @return A const reference to a ujson::json_array.
+         * @throw ujson::json_type_error If this is not a JSON array.
+         */
+        const json_array& array () const;
+
         /**
          * Assign a json_array to this jvalue, making this a JSON array.
          * Set the value type of this instance to ujson::j_array and
@@ -738,9 +838,23 @@ namespace ujson {
          *       jvalue instance that changes the JSON type from a string
          *       into some other JSON type, the reference returned by this
          *       method will be invalid and should not be used.
+         * @note A string parsed with jparser::borrow_strings() enabled
+         *       is copied from the parsed buffer when this method is called.
+         *       Use jvalue::str_view() to read a string without copying it.
          */
         std::string& str ();
 
+        /**
+         * Get a read-only view of the string value if this is a JSON string.
+         * Unlike jvalue::str(), this method never copies a string
+         * that refers to a buffer parsed with jparser::borrow_strings()
+         * enabled.
+         * @return A string_view of the string value. It is valid
+         *         until this jvalue instance is modified or destroyed.
+         * @throw ujson::json_type_error If this is not a JSON string.
+         */
+        std::string_view str_view () const;
+
         /**
          * Assing a string to this jvalue, making it a JSON string.
          * Set the value type of this instance to ujson::j_string and
@@ -780,6 +894,9 @@ namespace ujson {
 #if UJSON_HAVE_GMPXX
         /**
          * Return a reference a mpf_class representing the JSON number value.
+         * Numbers are stored as a <code>long</code> or a <code>double</code>
+         * when that can be done without losing precision. Such a number is
+         * converted to a mpf_class the first time this method is called.
          * @return A reference to a mpf_class instance.
          * @note The jvalue instance uses an instance of a mpf_class
          *       to represent a JSON number. If any method is called on this
@@ -795,6 +912,16 @@ namespace ujson {
          */
         mpf_class& mpf ();
 #endif
+#if UJSON_HAVE_GMPXX
+        /**
+         * Return a copy of the JSON number value as a mpf_class.
+         * Unlike jvalue::mpf(), this doesn't change how the number
+         * is stored, so it can be used on a const jvalue.
+         * @return The JSON number value.
+         * @throw ujson::json_type_error If this is not a JSON number.
+         */
+        mpf_class get_mpf () const;
+#endif
 #if UJSON_HAVE_GMPXX
         /**
          * Return the JSON number value as a <code>double</code>.
@@ -926,6 +1053,44 @@ namespace ujson {
          */
         bool is_container () const;
 
+        /**
+         * Make a copy that shares objects and arrays with this value.
+         * Instead of copying an object or array, the copy refers to the
+         * same object or array, and a counter in it is incremented.
+         * An object or array is copied first when it is about to be
+         * changed, by any non-const method, in one of the values sharing
+         * it. Only that object or array is copied, the copy shares the
+         * objects and arrays in it. So changing a value in either of the
+         * values copies the objects and arrays on the path to the value,
+         * not the whole instance. This makes it cheap to keep snapshots,
+         * or earlier versions, of a large instance.
+         * \par Example:
+         * \code
+         * auto snapshot = doc.share ();
+         * doc["config"]["timeout"] = 30; // Copies doc and doc["config"]
+         * \endcode
+         * Values sharing objects and arrays can be used in different
+         * threads, a shared object or array is never changed. But
+         * references to values inside an object or array, that were
+         * taken before it was shared, must not be used to change the
+         * values, since that will change all values sharing it.
+         * <br/>
+         * Objects and arrays allocated in a ujson::jarena are never
+         * shared, they are copied by this method.
+         * @return A copy of this value.
+         * @see jvalue::shared()
+         */
+        jvalue share () const;
+
+        /**
+         * Check if this is an object or array that is shared with
+         * another jvalue.
+         * @return <code>true</code> if this is an object or array,
+         *         and it is shared with another jvalue.
+         * @see jvalue::share()
+         */
+        bool shared () const;
+
         /**
          * Check if this is a JSON object and contains a
          * valid JSON value associated with a given name.
@@ -957,6 +1122,18 @@ namespace ujson {
          */
         jvalue& get (const std::string& name);
 
+        /**
+         * Get a JSON object attribute without modifying the object.
+         * Same as the non-const version of jvalue::get(), except an
+         * invalid jvalue is returned if not found, and that the object
+         * is left as it is.
+         * @param name The name of the object attribute we want.
+         * @return A const reference to the value mapped to the given name.
+         *         Or a reference to a static invalid jvalue if not found.
+         * @throw ujson::json_type_error If this is not a JSON object.
+         */
+        const jvalue& get (const std::string& name) const;
+
         /**
          * Get a JSON object attribute and assume there is only
          * one attribute with the specified name.
@@ -1009,6 +1186,16 @@ namespace ujson {
          */
         jvalue& operator[] (const size_t n);
 
+        /**
+         * Access a JSON array entry.
+         * Returns a const reference to the n'th value in the JSON array.
+         * @param n The index of the object in the array we want to access.
+         * @return A const reference to a jvalue in the JSON array.
+         * @throw ujson::json_type_error If this is not a JSON array.
+         * @throw std::out_of_range If the index is out of range.
+         */
+        const jvalue& operator[] (const size_t n) const;
+
         /**
          * Return the number of JSON values in an array or an object.
          * @note It is possible, but not recommended, to add invalid
@@ -1099,6 +1286,56 @@ namespace ujson {
          */
         jvalue& append (jvalue&& value);
 
+        /**
+         * Create a value at the end of a JSON array.
+         * The value is constructed in place in the array, from the
+         * arguments given to a jvalue constructor, instead of being
+         * copied or moved from a temporary jvalue. Explicit
+         * constructors can be used, as in <code>emplace_back(10L)</code>.
+         * @param args Arguments to the jvalue constructor.
+         * @return A reference to the jvalue created in the array.
+         * @throw ujson::json_type_error If this is not a JSON array
+         *        (not of type ujson::j_array).
+         * @throw std::invalid_argument If the created value is an
+         *        invalid JSON value (of type ujson::j_invalid).
+         * @see reserve()
+         */
+        template<class... Args>
+        jvalue& emplace_back (Args&&... args);
+
+        /**
+         * Add an attribute to a JSON object, with a value created
+         * in place in the object from the arguments given to a
+         * jvalue constructor.
+         * An attribute with the same name is overwritten, like by
+         * add(const std::string&, jvalue&&, const bool). The new
+         * value is then moved to the existing attribute.
+         * To build a large object with unique member names,
+         * ujson::jobject_builder is faster.
+         * @param name The name of the object attribute.
+         * @param args Arguments to the jvalue constructor.
+         * @return A reference to the attribute value in the JSON object.
+         * @throw ujson::json_type_error If this is not a JSON object
+         *        (not of type ujson::j_object).
+         * @throw std::invalid_argument If the created value is an
+         *        invalid JSON value (of type ujson::j_invalid).
+         */
+        template<class... Args>
+        jvalue& emplace (const std::string& name, Args&&... args);
+
+        /**
+         * Make room for a number of items in a JSON array, or
+         * attributes in a JSON object, to avoid reallocations
+         * while the array or object grows.
+         * For objects, this has an effect only if libujson is
+         * built with <code>ujson::flat_multimap_list</code>
+         * as <code>ujson::json_object</code>.
+         * @param capacity The number of items or attributes
+         *                 to make room for.
+         * @throw ujson::json_type_error If this is not a JSON object or array.
+         */
+        void reserve (size_t capacity);
+
         /**
          * Remove an attribute from a JSON object.
          * All attributes with the specified name are erased
@@ -1151,14 +1388,150 @@ namespace ujson {
          *                              this indentation depth.
          *                              Only relevant if flag
          *                              <code>fmt_pretty</code> is set.
+         * @param num_threads Serialize large arrays and objects using
+         *                    this number of threads. 0 means the number
+         *                    of hardware threads, 1 serializes the value
+         *                    using only the calling thread.
+         * @param min_elements Arrays and objects with at least this
+         *                     many elements are split in chunks that
+         *                     are serialized in parallel. Only used if
+         *                     <code>num_threads</code> isn't 1.
          * @return A string in JSON format defining this JSON intance.
+         *         The output is the same regardless of the number of threads.
          * @note If flag <code>fmt_color</code> is set, the resulting
          *       string can <b>NOT</b> be used as a valid JSON instance,
          *       since it may contain escape codes for console colors.
+         * @note The value must not be changed by other threads
+         *       while it is serialized.
          * @see desc_format_t
          */
         std::string describe (desc_format_t fmt,
-                              unsigned starting_indent_depth) const;
+                              unsigned starting_indent_depth,
+                              unsigned num_threads=1,
+                              size_t min_elements=1024) const;
+
+        /**
+         * Return a string representation of this JSON value,
+         * and statistics about it.
+         * The statistics are the same as collected by the parser,
+         * see ujson::jstats, but for the output. Tokens are counted
+         * as they would be found when parsing the output.
+         * Collecting statistics is only supported if libujson is
+         * built with cmake option <code>COLLECT_STATS</code>,
+         * otherwise all statistics are zero. Without statistics,
+         * describe(desc_format_t) is not affected by them.
+         * @param fmt Flags describing the format of the resulting
+         *            output string.
+         * @param stats Set to the statistics of the output.
+         * @return A string in JSON format defining this JSON intance.
+         * @see describe(desc_format_t, unsigned)
+         * @see jparser::collect_stats()
+         */
+        std::string describe (desc_format_t fmt, jstats& stats) const;
+
+        /**
+         * A function receiving the output of jvalue::write().
+         * It is called with each chunk of the output in turn.
+         * An exception thrown by the function aborts the output
+         * and is passed on to the caller of jvalue::write().
+         */
+        using write_handler_t = std::function<void (const char* data, size_t size)>;
+
+        /**
+         * Write this JSON value to an output stream.
+         * The output is the same as from jvalue::describe(),
+         * but it is written in chunks of limited size while
+         * the value is serialized instead of being built in
+         * a string. This uses much less memory for large values.
+         * @param out The output stream to write to.
+         * @param fmt Flags describing the format of the output.
+         * @param starting_indent_depth Start the output with
+         *                              this indentation depth.
+         *                              Only relevant if flag
+         *                              <code>fmt_pretty</code> is set.
+         * @param num_threads The number of threads serializing large
+         *                    arrays and objects, see describe(desc_format_t, unsigned, unsigned, size_t).
+         * @param min_elements The minimum size of arrays and objects
+         *                     serialized in parallel.
+         * @see describe(desc_format_t, unsigned)
+         */
+        void write (std::ostream& out,
+                    desc_format_t fmt=fmt_none,
+                    unsigned starting_indent_depth=0,
+                    unsigned num_threads=1,
+                    size_t min_elements=1024) const;
+
+        /**
+         * Append this JSON value to a string.
+         * The output is the same as from jvalue::describe().
+         * Reusing the same string for many values avoids
+         * allocating a new string for each of them.
+         * @param out The string to append the output to.
+         * @param fmt Flags describing the format of the output.
+         * @param starting_indent_depth Start the output with
+         *                              this indentation depth.
+         *                              Only relevant if flag
+         *                              <code>fmt_pretty</code> is set.
+         * @param num_threads The number of threads serializing large
+         *                    arrays and objects, see describe(desc_format_t, unsigned, unsigned, size_t).
+         * @param min_elements The minimum size of arrays and objects
+         *                     serialized in parallel.
+         * @see describe(desc_format_t, unsigned)
+         */
+        void write (std::string& out,
+                    desc_format_t fmt=fmt_none,
+                    unsigned starting_indent_depth=0,
+                    unsigned num_threads=1,
+                    size_t min_elements=1024) const;
+
+        /**
+         * Write this JSON value to a handler function.
+         * The output is the same as from jvalue::describe(),
+         * but it is passed to the handler in chunks of limited
+         * size while the value is serialized.
+         * @param handler A function called with each chunk of output.
+         * @param fmt Flags describing the format of the output.
+         * @param starting_indent_depth Start the output with
+         *                              this indentation depth.
+         *                              Only relevant if flag
+         *                              <code>fmt_pretty</code> is set.
+         * @param num_threads The number of threads serializing large
+         *                    arrays and objects, see describe(desc_format_t, unsigned, unsigned, size_t).
+         * @param min_elements The minimum size of arrays and objects
+         *                     serialized in parallel.
+         * @see describe(desc_format_t, unsigned)
+         */
+        void write (const write_handler_t& handler,
+                    desc_format_t fmt=fmt_none,
+                    unsigned starting_indent_depth=0,
+                    unsigned num_threads=1,
+                    size_t min_elements=1024) const;
+
+        /**
+         * Write this JSON value to a file descriptor.
+         * The output is the same as from jvalue::describe(),
+         * but it is written in chunks of limited size while
+         * the value is serialized.
+         * @param fd An open file descriptor to write to.
+         * @param fmt Flags describing the format of the output.
+         * @param starting_indent_depth Start the output with
+         *                              this indentation depth.
+         *                              Only relevant if flag
+         *                              <code>fmt_pretty</code> is set.
+         * @param num_threads The number of threads serializing large
+         *                    arrays and objects, see describe(desc_format_t, unsigned, unsigned, size_t).
+         * @param min_elements The minimum size of arrays and objects
+         *                     serialized in parallel.
+         * @return <code>true</code> on success. <code>false</code>
+         *         if writing to the file descriptor failed,
+         *         <code>errno</code> is then set by the failing write.
+         * @see describe(desc_format_t, unsigned)
+         */
+        bool write (int fd,
+                    desc_format_t fmt=fmt_none,
+                    unsigned starting_indent_depth=0,
+                    unsigned num_threads=1,
+                    size_t min_elements=1024) const;
 
         /**
          * Return a string representation of this JSON value.
@@ -1215,33 +1588,167 @@ namespace ujson {
 
     private:
         jvalue_type jtype;
-        union {
-            json_object* jobj;
-            json_array*  jarray;
-            std::string* jstr;
+        bool in_arena {false}; // The object or array is allocated from a jarena
+        // How a JSON number or string is stored. With gmpxx, numbers
+        // that fit in a long, and parsed numbers that are exactly
+        // represented by a double, are stored natively. They are
+        // converted to an mpf_class when jvalue::mpf() is called.
+        // Numbers parsed with jparser::lazy_numbers() enabled are stored
+        // as text. Strings parsed with jparser::borrow_strings() enabled
+        // refer to the parsed buffer until they are modified.
+        enum repr_t : unsigned char {
+            num_jnum,     // v.jnum
+            num_long,     // v.jlong
+            num_dbl,      // v.jdbl
+            num_text,     // v.jstr
+            str_borrowed, // v.jview, any other value means v.jstr
+        };
+        repr_t repr {num_jnum};
 #if UJSON_HAVE_GMPXX
-            num_t*       jnum; // mpf_class*
+        uint16_t num_prec {0}; // Precision of the mpf_class when converted,
+                               // 0 means mpf_get_default_prec().
+#endif
+        union value_t {
+            struct {
+                union {
+                    json_object* jobj;
+                    json_array*  jarray;
+                };
+                mutable size_t hash; // Cached hash value, see cache_hash()
+                mutable bool   hash_cached;
+            } jc;
+            std::string  jstr;  // Short strings need no heap allocation
+            std::string_view jview;
+#if UJSON_HAVE_GMPXX
+            num_t        jnum; // mpf_class
+            long         jlong;
+            double       jdbl;
 #else
             num_t        jnum; // double
 #endif
             bool         jbool;
+            value_t () {}  // The active member is constructed by jvalue
+            ~value_t () {} // and destroyed by jvalue::reset()
         } v;
 
         void reset ();
         void copy (const jvalue& jvalue);
         void move (jvalue&& jvalue);
+        void text_to_num ();
+#if UJSON_HAVE_GMPXX
+        void num_to_mpf ();
+#endif
+        size_t make_hash (bool keep) const;
+        void share_from (const jvalue& rval);
+        void before_change ();
+        jvalue* last_member (const std::string& name);
 
-        void describe (std::stringstream& ss,
+        friend bool number_from_token (const std::string_view& str, jvalue& value);
+        friend void number_as_text (const std::string_view& str, jvalue& value);
+        friend void string_as_view (const std::string_view& str, jvalue& value);
+        friend void number_from_double (const double n, jvalue& value);
+        friend void number_to_cbor (const jvalue& value, jwriter& out);
+        friend void number_to_tape (const jvalue& value, jtape_writer& out);
+
+        friend class describe_plan;
+
+        void describe (jwriter& out,
                        desc_format_t fmt,
-                       unsigned indent_depth) const;
-        void describe_object (std::stringstream& ss,
+                       unsigned indent_depth,
+                       describe_plan* plan=nullptr) const;
+        void describe_object (jwriter& out,
                               desc_format_t fmt,
-                              unsigned indent_depth) const;
-        void describe_array (std::stringstream& ss,
+                              unsigned indent_depth,
+                              describe_plan* plan) const;
+        void describe_array (jwriter& out,
                              desc_format_t fmt,
-                             unsigned indent_depth) const;
+                             unsigned indent_depth,
+                             describe_plan* plan) const;
+        bool describe_members (jwriter& out,
+                               desc_format_t fmt,
+                               unsigned indent_depth,
+                               json_object::const_iterator i,
+                               json_object::const_iterator end,
+                               bool first,
+                               describe_plan* plan) const;
+        bool describe_elements (jwriter& out,
+                                desc_format_t fmt,
+                                unsigned indent_depth,
+                                size_t i,
+                                size_t end,
+                                bool first,
+                                describe_plan* plan) const;
+        void describe_parallel (jwriter& out,
+                                desc_format_t fmt,
+                                unsigned indent_depth,
+                                unsigned num_threads,
+                                size_t min_elements) const;
+#if UJSON_COLLECT_STATS
+        void count_output (desc_format_t fmt,
+                           unsigned depth,
+                           jstats& stats) const;
+#endif
     };
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class... Args>
+    jvalue& jvalue::emplace_back (Args&&... args)
+    {
+        if (type() != j_array)
+            throw ujson::json_type_error ("Not a JSON array");
+
+        before_change ();
+        auto& value = v.jc.jarray->emplace_back (std::forward<Args>(args)...);
+        if (!value.valid()) {
+            v.jc.jarray->pop_back ();
+            throw std::invalid_argument ("Invalid JSON value");
+        }
+        return value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class... Args>
+    jvalue& jvalue::emplace (const std::string& name, Args&&... args)
+    {
+        auto* member = last_member (name);
+        if (member) {
+            jvalue value (std::forward<Args>(args)...);
+            if (!value.valid())
+                throw std::invalid_argument ("Invalid JSON value");
+            *member = std::move (value);
+            return *member;
+        }
+
+        auto& value = v.jc.jobj->emplace_back(std::piecewise_construct,
+                                              std::forward_as_tuple(name),
+                                              std::forward_as_tuple(std::forward<Args>(args)...)).second;
+        if (!value.valid()) {
+            v.jc.jobj->pop_back ();
+            throw std::invalid_argument ("Invalid JSON value");
+        }
+        return value;
+    }
+
+
 }
+
+
+namespace std {
+    /**
+     * Hash function for ujson::jvalue.
+     * @see ujson::jvalue::hash()
+     */
+    template<>
+    struct hash<ujson::jvalue> {
+        size_t operator() (const ujson::jvalue& value) const {
+            return value.hash ();
+        }
+    };
+}
+
+
 #endif
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/jwriter.hpp>
+#include <algorithm>
+#include <cstdint>
+
+// Use SSE2 to scan blocks of 16 bytes at a time when available.
+// SSE2 is always available on x86-64.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define UJSON_SCAN_SSE2 1
+#  include <emmintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#else
+#  define UJSON_SCAN_SSE2 0
+#endif
+
+
+namespace ujson {
+
+
+    // Escape sequences of the control characters
+    static const char* const control_escapes[0x20] = {
+        "\\u0000", "\\u0001", "\\u0002", "\\u0003",
+        "\\u0004", "\\u0005", "\\u0006", "\\u0007",
+        "\\b",     "\\t",     "\\n",     "\\u000b",
+        "\\f",     "\\r",     "\\u000e", "\\u000f",
+        "\\u0010", "\\u0011", "\\u0012", "\\u0013",
+        "\\u0014", "\\u0015", "\\u0016", "\\u0017",
+        "\\u0018", "\\u0019", "\\u001a", "\\u001b",
+        "\\u001c", "\\u001d", "\\u001e", "\\u001f",
+    };
+
+    // Used for indentation
+    static constexpr size_t indent_chunk = 64;
+    static const char spaces[indent_chunk+1] = "                                                                ";
+    static const char tabs[indent_chunk+1] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t"
+                                             "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+
+
+#if (UJSON_SCAN_SSE2)
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline unsigned lowest_bit_index (unsigned mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward (&index, mask);
+        return (unsigned) index;
+#else
+        return (unsigned) __builtin_ctz (mask);
+#endif
+    }
+#endif
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    static inline bool needs_escape (unsigned char ch, bool escape_slash)
+    {
+        return ch<0x20 || ch=='"' || ch=='\\' || (escape_slash && ch=='/');
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Return the number of characters, starting at 'pos',
+    // that are written as they are in a JSON string.
+    //--------------------------------------------------------------------------
+    static inline size_t plain_chars (const char* pos, const char* const end, bool escape_slash)
+    {
+        const char* const start = pos;
+#if (UJSON_SCAN_SSE2)
+        const __m128i quote   = _mm_set1_epi8 ('"');
+        const __m128i bslash  = _mm_set1_epi8 ('\\');
+        const __m128i slash   = _mm_set1_epi8 (escape_slash ? '/' : '"');
+        const __m128i control = _mm_set1_epi8 (0x1f);
+        while (end - pos >= 16) {
+            __m128i block = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(pos));
+            // An unsigned compare, max(block, 0x1f) == 0x1f, catches
+            // control characters but not non-ASCII bytes (>=0x80).
+            __m128i special = _mm_or_si128 (_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                         _mm_cmpeq_epi8(block, bslash)),
+                                            _mm_or_si128(_mm_cmpeq_epi8(block, slash),
+                                                         _mm_cmpeq_epi8(_mm_max_epu8(block, control),
+                                                                        control)));
+            unsigned mask = (unsigned) _mm_movemask_epi8 (special);
+            if (mask)
+                return (pos - start) + lowest_bit_index (mask);
+            pos += 16;
+        }
+#else
+        // Check 8 bytes at a time for any special character
+        static constexpr uint64_t ones = 0x0101010101010101ULL;
+        static constexpr uint64_t high = 0x8080808080808080ULL;
+        const uint64_t slash = ones * (escape_slash ? '/' : '"');
+        while (end - pos >= 8) {
+            uint64_t block;
+            memcpy (&block, pos, sizeof(block));
+            uint64_t q = block ^ (ones * '"');  // Zero byte where '"'
+            uint64_t b = block ^ (ones * '\\'); // Zero byte where '\\'
+            uint64_t s = block ^ slash;         // Zero byte where '/'
+            if (((q - ones) & ~q & high)            ||
+                ((b - ones) & ~b & high)            ||
+                ((s - ones) & ~s & high)            ||
+                ((block - ones*0x20) & ~block & high))   // Byte < 0x20
+            {
+                break;
+            }
+            pos += 8;
+        }
+#endif
+        while (pos < end && !needs_escape(*pos, escape_slash))
+            ++pos;
+        return pos - start;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jwriter::jwriter (std::string& out)
+        : str {&out},
+          handler {nullptr},
+          pos {out.data() + out.size()},
+          end {pos}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jwriter::jwriter (const handler_t& output_handler)
+        : str {nullptr},
+          handler {&output_handler},
+          buf {new char[buf_size]},
+          pos {buf.get()},
+          end {buf.get() + buf_size}
+    {
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jwriter::~jwriter ()
+    {
+        if (str)
+            str->resize (pos - str->data());
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jwriter::flush ()
+    {
+        if (str) {
+            str->resize (pos - str->data());
+            pos = end = str->data() + str->size();
+        }else{
+            size_t size = pos - buf.get();
+            pos = buf.get ();
+            if (size)
+                (*handler) (buf.get(), size);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jwriter::make_room (size_t n)
+    {
+        if (str) {
+            size_t used = pos - str->data ();
+            str->resize (std::max({used + n, str->size() * 2, (size_t)64}));
+            pos = str->data() + used;
+            end = str->data() + str->size();
+        }else{
+            flush ();
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jwriter::write_slow (const char* s, size_t n)
+    {
+        if (!str) {
+            flush ();
+            if (n >= buf_size) {
+                (*handler) (s, n);
+                return;
+            }
+        }else{
+            make_room (n);
+        }
+        std::memcpy (pos, s, n);
+        pos += n;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jwriter::write_escaped (const std::string_view& s, bool escape_slash)
+    {
+        const char* p = s.data ();
+        const char* const p_end = p + s.size ();
+        while (p < p_end) {
+            size_t n = plain_chars (p, p_end, escape_slash);
+            write (p, n);
+            p += n;
+            if (p == p_end)
+                break;
+            unsigned char ch = *p++;
+            switch (ch) {
+            case '"':
+                write ("\\\"", 2);
+                break;
+            case '\\':
+                write ("\\\\", 2);
+                break;
+            case '/':
+                write ("\\/", 2);
+                break;
+            default:
+                write (control_escapes[ch]);
+            }
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jwriter::needs_escape (const std::string_view& s, bool escape_slash)
+    {
+        return plain_chars (s.data(), s.data()+s.size(), escape_slash) != s.size ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jwriter::write_indent (unsigned depth, bool use_tabs)
+    {
+        put ('\n');
+        const char* chars = use_tabs ? tabs : spaces;
+        size_t n = use_tabs ? depth : depth * 4;
+        while (n > indent_chunk) {
+            write (chars, indent_chunk);
+            n -= indent_chunk;
+        }
+        write (chars, n);
+    }
+
+
+}
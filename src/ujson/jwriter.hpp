@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_JWRITER_HPP
+#define UJSON_JWRITER_HPP
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <memory>
+#include <cstring>
+
+
+namespace ujson {
+
+
+    /**
+     * Output buffer used when serializing JSON values.
+     * The output is either appended to a string, that grows as
+     * needed, or collected in a buffer of a fixed size that is
+     * passed to a handler each time it is full.
+     */
+    class jwriter {
+    public:
+        /**
+         * A function receiving the output.
+         */
+        using handler_t = std::function<void (const char* data, size_t size)>;
+
+        /**
+         * Append the output to a string.
+         * The string is resized to the written data by
+         * jwriter::flush() and by the destructor.
+         * @param out The string to append the output to.
+         */
+        explicit jwriter (std::string& out);
+
+        /**
+         * Pass the output to a handler.
+         * The handler is called each time the buffer is full,
+         * and by jwriter::flush().
+         * @param handler The function receiving the output.
+         */
+        explicit jwriter (const handler_t& handler);
+
+        /**
+         * Destructor.
+         * Output not yet passed to a handler is dropped.
+         */
+        ~jwriter ();
+
+        jwriter (const jwriter&) = delete;
+        jwriter& operator= (const jwriter&) = delete;
+
+        /**
+         * Write a character.
+         */
+        void put (char ch) {
+            if (pos == end)
+                make_room (1);
+            *pos++ = ch;
+        }
+
+        /**
+         * Write a number of characters.
+         */
+        void write (const char* s, size_t n) {
+            if ((size_t)(end - pos) >= n) {
+                std::memcpy (pos, s, n);
+                pos += n;
+            }else{
+                write_slow (s, n);
+            }
+        }
+
+        /**
+         * Write a string.
+         */
+        void write (const std::string_view& s) {
+            write (s.data(), s.size());
+        }
+
+        /**
+         * Write a null terminated string.
+         */
+        void write (const char* s) {
+            write (s, std::strlen(s));
+        }
+
+        /**
+         * Write a string with characters escaped as in a JSON string.
+         * @param s The string to write.
+         * @param escape_slash If <code>true</code>, also escape
+         *                     the forward slash character.
+         * @see ujson::escape()
+         */
+        void write_escaped (const std::string_view& s, bool escape_slash);
+
+        /**
+         * Check if a string has characters that are
+         * escaped when written by write_escaped().
+         * @param s The string to check.
+         * @param escape_slash If <code>true</code>, the forward
+         *                     slash character is also escaped.
+         */
+        static bool needs_escape (const std::string_view& s, bool escape_slash);
+
+        /**
+         * Write a newline followed by indentation.
+         * @param depth The indentation depth.
+         * @param use_tabs If <code>true</code>, indent by one tab
+         *             per level, otherwise four spaces.
+         */
+        void write_indent (unsigned depth, bool use_tabs);
+
+        /**
+         * Pass buffered output to the handler,
+         * or resize the string to the written data.
+         */
+        void flush ();
+
+
+    private:
+        static constexpr size_t buf_size = 64 * 1024;
+
+        std::string* str;
+        const handler_t* handler;
+        std::unique_ptr<char[]> buf;
+        char* pos;
+        char* end;
+
+        void make_room (size_t n);
+        void write_slow (const char* s, size_t n);
+    };
+
+
+}
+#endif
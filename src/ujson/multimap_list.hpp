@@ -23,12 +23,28 @@
 #include <list>
 #include <mutex>
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <stdexcept>
 #include <functional>
 
 
 namespace ujson {
 
+    /**
+     * A mutex type that does no locking at all.
+     * Used as the <code>Mutex</code> template parameter of a
+     * multimap_list when the container is never accessed from more
+     * than one thread at a time, or when access is synchronized
+     * by the owner of the container.
+     */
+    struct null_mutex {
+        void lock () noexcept {}               /**< Does nothing. */
+        void unlock () noexcept {}             /**< Does nothing. */
+        bool try_lock () noexcept {return true;} /**< Does nothing, always returns <code>true</code>. */
+    };
+
+
     /**
      * A multimap that keeps items in the order they were inserted.
      * When using an iterator, items are iterated the same order as they were added to the map.
@@ -54,14 +70,22 @@ namespace ujson {
      *    - <b>rsend()</b>    Iterator to the end. Used with iterator <b>rsbegin()</b>.
      *    - <b>crsbegin()</b> Same as <b>rbegin()</b> but the iterated items are read-only.
      *    - <b>crsend()</b>   Const Iterator to the end. Used with iterator <b>crsbegin()</b>.
+     *
+     * All member functions lock an internal mutex of type <code>Mutex</code>.
+     * Use ujson::null_mutex as <code>Mutex</code> for a container with
+     * no internal synchronization.
      */
-    template<class Key, class T, class CompareKey=std::less<Key>, class CompareValue=std::less<T>>
+    template<class Key, class T, class CompareKey=std::less<Key>, class CompareValue=std::less<T>, class Mutex=std::mutex>
     class multimap_list {
     private:
         using ItemList = std::list<std::pair<const Key, T>>;
         using KeyRef = std::reference_wrapper<const Key>;
         using KeyRefMap = std::multimap<KeyRef, typename ItemList::iterator, CompareKey>;
 
+        // Elements added by append() have their keys
+        // sorted if more than this many are added.
+        static constexpr size_t sorted_append_min = 16;
+
     public:
         using key_type = Key;                       /**< Key type. */
         using mapped_type = T;                      /**< Mapped type. */
@@ -116,8 +140,8 @@ namespace ujson {
          */
         multimap_list (const multimap_list& ml) {
             std::lock (mutex, ml.mutex);
-            std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> lg2 (ml.mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg2 (ml.mutex, std::adopt_lock);
             for (auto& item : ml.items)
                 push_back_impl (item.first, item.second);
         }
@@ -130,8 +154,8 @@ namespace ujson {
          */
         multimap_list (multimap_list&& ml) {
             std::lock (mutex, ml.mutex);
-            std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> lg2 (ml.mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg2 (ml.mutex, std::adopt_lock);
             items = std::move (ml.items);
             keys  = std::move (ml.keys);
         }
@@ -185,8 +209,8 @@ namespace ujson {
             {
                 if (&rhs != this) {
                     std::lock (mutex, rhs.mutex);
-                    std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-                    std::lock_guard<std::mutex> lg2 (rhs.mutex, std::adopt_lock);
+                    std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+                    std::lock_guard<Mutex> lg2 (rhs.mutex, std::adopt_lock);
                     items.clear ();
                     keys.clear ();
                     for (auto& item : rhs.items)
@@ -202,7 +226,7 @@ namespace ujson {
          * @param ilist The initializer list to copy.
          */
         multimap_list& operator= (std::initializer_list<value_type> ilist) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             items.clear ();
             keys.clear ();
             for (auto& entry : ilist)
@@ -220,8 +244,8 @@ namespace ujson {
             {
                 if (&rhs != this) {
                     std::lock (mutex, rhs.mutex);
-                    std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-                    std::lock_guard<std::mutex> lg2 (rhs.mutex, std::adopt_lock);
+                    std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+                    std::lock_guard<Mutex> lg2 (rhs.mutex, std::adopt_lock);
                     items.clear ();
                     keys.clear ();
                     items = std::move (rhs.items);
@@ -236,7 +260,7 @@ namespace ujson {
          * @return <code>true</code> is this container is empty.
          */
         bool empty () const noexcept {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return items.empty ();
         }
 
@@ -246,21 +270,82 @@ namespace ujson {
          * @return The number of entries in the container.
          */
         size_type size () const noexcept {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return items.size ();
         }
 
 
+        /**
+         * Increase the capacity of the container.
+         * Does nothing, entries are allocated one by one.
+         * Exists to have the same interface as ujson::flat_multimap_list.
+         * @param new_cap The number of entries to make room for.
+         */
+        void reserve (size_type new_cap) {
+        }
+
+
         /**
          * Clear the container.
          */
         void clear () noexcept {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             items.clear ();
             keys.clear ();
         }
 
 
+        /**
+         * Add elements from a range of elements to the end of the list.
+         * The keys of the added elements are sorted and then inserted in
+         * the key index in order, which is faster than adding the elements
+         * one by one when many elements are added.
+         * Elements with equal keys are kept in the same order as in the
+         * list, like when they are added by push_back().
+         * @param first An iterator to the first element to add.
+         *              Use a <code>std::move_iterator</code> to move the
+         *              elements instead of copying them.
+         * @param last The position after the last element to add.
+         */
+        template<class InputIt>
+        void append (InputIt first, InputIt last) {
+            if (first == last)
+                return;
+            std::lock_guard<Mutex> lock (mutex);
+            auto first_added = items.end ();
+            size_t num_added = 0;
+            for (; first!=last; ++first) {
+                items.emplace_back (*first);
+                if (num_added++ == 0)
+                    first_added = std::prev (items.end());
+            }
+            if (num_added <= sorted_append_min) {
+                // Few elements, not worth sorting
+                for (auto i=first_added; i!=items.end(); ++i)
+                    keys.emplace (std::cref(i->first), i);
+                return;
+            }
+            std::vector<typename ItemList::iterator> added;
+            added.reserve (num_added);
+            for (auto i=first_added; i!=items.end(); ++i)
+                added.emplace_back (i);
+            auto key_less = keys.key_comp ();
+            std::stable_sort (added.begin(), added.end(),
+                              [&key_less](const typename ItemList::iterator& lhs,
+                                          const typename ItemList::iterator& rhs)
+                              {
+                                  return key_less (lhs->first, rhs->first);
+                              });
+            // Each key is inserted after existing equal keys
+            auto hint = keys.upper_bound (added.front()->first);
+            for (auto& i : added) {
+                while (hint != keys.end()  &&  !key_less(i->first, hint->first))
+                    ++hint;
+                keys.emplace_hint (hint, std::cref(i->first), i);
+            }
+        }
+
+
     private:
         template<class VType, class ItemListIter, class KeyRefMapIter>
         class iterator_impl {
@@ -392,7 +477,7 @@ namespace ujson {
          * @return A reference to the first item in the container.
          */
         reference front () {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return *(begin());
         }
 
@@ -403,7 +488,7 @@ namespace ujson {
          * @return A reference to the last item in the container.
          */
         reference back () {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return *(rbegin());
         }
 
@@ -423,7 +508,7 @@ namespace ujson {
          * @param value The mapped value to add.
          */
         void push_back (const key_type& key, const mapped_type& value) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             push_back_impl (std::forward<const key_type&>(key),
                             std::forward<const mapped_type&>(value));
         }
@@ -443,7 +528,7 @@ namespace ujson {
          * @param entry A key and a value to add to the list.
          */
         void push_back (value_type&& entry) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             items.push_back (std::forward<value_type&&>(entry));
             auto i = (++items.rbegin()).base ();
             keys.emplace_hint (keys.end(), std::cref(i->first), i);
@@ -456,7 +541,7 @@ namespace ujson {
          * @param value The mapped value to add.
          */
         void push_front (const key_type& key, const mapped_type& value) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             items.push_front (std::make_pair(key, value));
             auto i = items.begin ();
             keys.emplace_hint (keys.begin(), std::cref(i->first), i);
@@ -468,7 +553,7 @@ namespace ujson {
          * @param entry A key and a value to add to the list.
          */
         void push_front (const value_type& entry) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             items.push_front (entry);
             auto i = items.begin ();
             keys.emplace_hint (keys.begin(), std::cref(i->first), i);
@@ -480,7 +565,7 @@ namespace ujson {
          * @param entry A key and a value to add to the list.
          */
         void push_front (value_type&& entry) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             items.push_front (std::forward<value_type&&>(entry));
             auto i = items.begin ();
             keys.emplace_hint (keys.begin(), std::cref(i->first), i);
@@ -512,7 +597,7 @@ namespace ujson {
          * @return Iterator pointing to the inserted entry.
          */
         iterator insert (iterator pos, const key_type& key, const mapped_type& value) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             typename ItemList::iterator i_pos = pos.sorted ? pos.si->second : pos.i;
             auto i = items.insert (i_pos, std::make_pair(key, value));
             keys.emplace_hint (get_key_pos_hint(i->first, i_pos),
@@ -528,7 +613,7 @@ namespace ujson {
          * @return Iterator pointing to the inserted entry.
          */
         iterator insert (iterator pos, const value_type& entry) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             typename ItemList::iterator i_pos = pos.sorted ? pos.si->second : pos.i;
             auto i = items.insert (i_pos, entry);
             keys.emplace_hint (get_key_pos_hint(i->first, i_pos),
@@ -544,7 +629,7 @@ namespace ujson {
          * @return Iterator pointing to the inserted entry.
          */
         iterator insert (iterator pos, value_type&& entry) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             typename ItemList::iterator i_pos = pos.sorted ? pos.si->second : pos.i;
             auto i = items.insert (i_pos, std::forward<value_type&&>(entry));
             keys.emplace_hint (get_key_pos_hint(i->first, i_pos),
@@ -565,7 +650,7 @@ namespace ujson {
         iterator insert (iterator pos, InputIt first, InputIt last) {
             if (first == last)
                 return pos;
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             typename ItemList::iterator i_pos = pos.sorted ? pos.si->second : pos.i;
             auto i = items.insert (i_pos, *first);
             auto retval = iterator (i);
@@ -599,7 +684,7 @@ namespace ujson {
         template<class ...Args>
         iterator emplace_impl (iterator pos, Args&&... args) {
             typename ItemList::iterator i_pos = pos.sorted ? pos.si->second : pos.i;
-            auto i = items.emplace (i_pos, std::make_pair(std::forward<Args&&>(args)...));
+            auto i = items.emplace (i_pos, std::forward<Args&&>(args)...);
             keys.emplace_hint (get_key_pos_hint(i->first, i_pos),
                                std::cref(i->first), i);
             return iterator (i);
@@ -616,7 +701,7 @@ namespace ujson {
          */
         template<class ...Args>
         iterator emplace (iterator pos, Args&&... args) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return emplace_impl (pos, std::forward<Args&&>(args)...);
         }
 
@@ -628,7 +713,7 @@ namespace ujson {
          */
         template<class ...Args>
         reference emplace_front (Args&&... args) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return *(emplace_impl(begin(), std::forward<Args&&>(args)...));
         }
 
@@ -640,7 +725,7 @@ namespace ujson {
          */
         template<class ...Args>
         reference emplace_back (Args&&... args) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return *(emplace_impl(end(), std::forward<Args&&>(args)...));
         }
 
@@ -689,7 +774,7 @@ namespace ujson {
          * @return Iterator following the removed element.
          */
         iterator erase (iterator pos) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             if (pos.sorted && pos == send()) {
                 return send ();
             }
@@ -706,7 +791,7 @@ namespace ujson {
          * @return Iterator following the removed element.
          */
         const_iterator erase (const_iterator pos) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             if (pos.sorted && pos == csend()) {
                 return csend ();
             }
@@ -724,7 +809,7 @@ namespace ujson {
          * @return Iterator following the last removed element.
          */
         iterator erase (iterator first, iterator last) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return erase_impl (first, last);
         }
 
@@ -736,7 +821,7 @@ namespace ujson {
          * @return Iterator following the last removed element.
          */
         const_iterator erase (const_iterator first, const_iterator last) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return erase_impl (first, last);
         }
 
@@ -747,7 +832,7 @@ namespace ujson {
          * @return The number of erased elements.
          */
         size_type erase (const key_type& key) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             auto range = keys.equal_range (key);
             size_type num_erased = 0;
             for (auto si=range.first; si!=range.second; ) {
@@ -763,7 +848,7 @@ namespace ujson {
          * Erase the first entry in the container.
          */
         void pop_front () {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             if (!items.empty())
                 erase_impl (begin());
         }
@@ -773,7 +858,7 @@ namespace ujson {
          * Erase the last entry in the container.
          */
         void pop_back () {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             if (!items.empty())
                 erase_impl (--(end()));
         }
@@ -785,8 +870,8 @@ namespace ujson {
          */
         void swap (multimap_list& other) {
             std::lock (mutex, other.mutex);
-            std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> lg2 (other.mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg2 (other.mutex, std::adopt_lock);
             items.swap (other.items);
             keys.swap (other.keys);
         }
@@ -797,7 +882,7 @@ namespace ujson {
          * @return the number of elements with a specific key.
          */
         size_type count (const key_type& key) const {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return keys.count (key);
         }
 
@@ -809,7 +894,7 @@ namespace ujson {
          *         or end() if no entry with the specified key.
          */
         iterator find (const key_type& key) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             auto si = keys.find (key);
             if (si == keys.end())
                 return end ();
@@ -823,7 +908,7 @@ namespace ujson {
          * @return <code>true</code> if there is an entry with the key.
          */
         bool contains (const key_type& key) const {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return keys.find(key) != keys.end();
         }
 
@@ -834,7 +919,7 @@ namespace ujson {
          * @return A range of entries with the specific key.
          */
         std::pair<iterator, iterator> equal_range (const key_type& key) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             auto range = keys.equal_range (key);
             return std::make_pair (iterator(range.first), iterator(range.second));
         }
@@ -846,7 +931,7 @@ namespace ujson {
          * @return A range of entries with the specific key.
          */
         std::pair<const_iterator, const_iterator> equal_range (const key_type& key) const {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             auto range = keys.equal_range (key);
             return std::make_pair (const_iterator(range.first), const_iterator(range.second));
         }
@@ -859,7 +944,7 @@ namespace ujson {
          *         or <code>send()</code> if none found.
          */
         iterator lower_bound (const key_type& key) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return iterator (keys.lower_bound(key));
         }
 
@@ -871,7 +956,7 @@ namespace ujson {
          *         or <code>send()</code> if none found.
          */
         const_iterator lower_bound (const key_type& key) const {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return const_iterator (keys.lower_bound(key));
         }
 
@@ -883,7 +968,7 @@ namespace ujson {
          *         or <code>send()</code> if none found.
          */
         iterator upper_bound (const key_type& key) {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return iterator (keys.upper_bound(key));
         }
 
@@ -895,7 +980,7 @@ namespace ujson {
          *         or <code>send()</code> if none found.
          */
         const_iterator upper_bound (const key_type& key) const {
-            std::lock_guard<std::mutex> lock (mutex);
+            std::lock_guard<Mutex> lock (mutex);
             return const_iterator (keys.upper_bound(key));
         }
 
@@ -915,8 +1000,8 @@ namespace ujson {
             if (this == &rhs)
                 return true;
             std::lock (mutex, rhs.mutex);
-            std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> lg2 (rhs.mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg2 (rhs.mutex, std::adopt_lock);
             if (items.size() != rhs.items.size())
                 return false;
 
@@ -960,8 +1045,8 @@ namespace ujson {
             if (this == &rhs)
                 return false;
             std::lock (mutex, rhs.mutex);
-            std::lock_guard<std::mutex> lg1 (mutex, std::adopt_lock);
-            std::lock_guard<std::mutex> lg2 (rhs.mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg1 (mutex, std::adopt_lock);
+            std::lock_guard<Mutex> lg2 (rhs.mutex, std::adopt_lock);
             return std::lexicographical_compare (sbegin(), send(),
                                                  rhs.sbegin(), rhs.send(),
                                                  value_type_compare{});
@@ -1169,7 +1254,7 @@ namespace ujson {
     private:
         ItemList items;
         KeyRefMap keys;
-        mutable std::mutex mutex;
+        mutable Mutex mutex;
     };
 
 
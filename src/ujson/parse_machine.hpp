@@ -0,0 +1,970 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_PARSE_MACHINE_HPP
+#define UJSON_PARSE_MACHINE_HPP
+
+#include <ujson/internal.hpp>
+#include <ujson/jparser.hpp>
+#include <ujson/jpointer.hpp>
+#include <ujson/jtokenizer.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <charconv>
+
+
+namespace ujson::parser {
+
+
+    //--------------------------------------------------------------------------
+    // A projection of the parsed document, see jparser::projection().
+    // A node is a location in the document. If 'whole' is true,
+    // the value at this location is parsed. Otherwise only the
+    // children of the value found in 'children', or all children if
+    // 'any' is set, are parsed. Other values are skipped.
+    //--------------------------------------------------------------------------
+    struct projection_node_t {
+        projection_node_t () = default;
+        projection_node_t (const projection_node_t& node)
+            : children (node.children),
+              any (node.any ? new projection_node_t(*node.any) : nullptr),
+              whole (node.whole)
+            {
+            }
+
+        void add (jpointer::tokens_t::const_iterator token,
+                  jpointer::tokens_t::const_iterator end);
+
+        // The node of a child value, or nullptr if the child is skipped.
+        const projection_node_t* child (std::string_view name) const {
+            auto entry = children.find (name);
+            if (entry != children.end())
+                return &entry->second;
+            return any.get ();
+        }
+
+        std::map<std::string, projection_node_t, std::less<>> children;
+        std::unique_ptr<projection_node_t> any; // Token "*"
+        bool whole {false};
+    };
+
+
+    //--------------------------------------------------------------------------
+    // The parse state of an array or object in a parse_machine.
+    // A consumer of parse events may extend it with its own data.
+    //--------------------------------------------------------------------------
+    struct parse_frame_t {
+        size_t index {0};         // Number of array items, or parsed object members, so far
+        bool has_name {false};    // The name of the current object member is parsed
+        bool has_colon {false};   // The colon after the name is parsed
+
+        // Projection
+        const projection_node_t* proj {nullptr}; // nullptr if all children are parsed
+        size_t skipped {0};       // Skipped array items after the last parsed one
+        bool skip_member {false}; // The value of the current object member is skipped
+    };
+
+
+    //--------------------------------------------------------------------------
+    // The JSON grammar and parse states, shared by the tree builder
+    // in jparser.cpp and the event reader in jreader.cpp. Tokens are
+    // fed one at a time to parse_token(), and the parsed values are
+    // reported to class Derived (CRTP), that implements:
+    //
+    //   void on_begin_object (const jtoken& token, Frame& frame);
+    //   void on_begin_array (const jtoken& token, Frame& frame);
+    //   void on_member_name (const jtoken& token, Frame& frame);
+    //   void on_member_value (Frame& frame);
+    //   void on_end_object (const jtoken& token, Frame& frame);
+    //   void on_end_array (const jtoken& token, Frame& frame);
+    //   void on_null (const jtoken& token);
+    //   void on_bool (const jtoken& token, bool value);
+    //   void on_number (const jtoken& token);
+    //   void on_string (const jtoken& token);
+    //   void on_string_part (const jtoken& token, bool first);
+    //   void on_string_end (const jtoken& token);
+    //   void on_error_at_end (jparser::err code);
+    //
+    // on_string() is called for strings in strict mode. In relaxed
+    // mode, a string can be made up by multiple strings divided by
+    // whitespaces and comments, each is reported by on_string_part(),
+    // and on_string_end() is called when the string is complete.
+    // on_member_value() is called when the value of an object member
+    // is parsed, after the events of the value itself. Values outside
+    // of the projection of a frame are skipped without any events.
+    // When an array or object is done, its frame is popped from the
+    // frame stack before on_end_array() or on_end_object() is called.
+    // A handler stops parsing by setting an error.
+    //
+    // Derived may also hide the default implementations of
+    // projected_name(), on_skipped_items(), and on_document_done().
+    // Frame is parse_frame_t, or a class derived from it.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame=parse_frame_t>
+    class parse_machine {
+    public:
+        void limits (unsigned max_depth_arg,
+                     unsigned max_array_size_arg,
+                     unsigned max_object_size_arg)
+        {
+            max_depth = max_depth_arg;
+            max_array_size = max_array_size_arg;
+            max_object_size = max_object_size_arg;
+        }
+
+        const jparser::err error_code () const {
+            return err_code;
+        }
+        const unsigned error_row () const {
+            return err_row;
+        }
+        const unsigned error_col () const {
+            return err_col;
+        }
+
+        void error (const jparser::err code, unsigned row_arg, unsigned col_arg) {
+            err_row = row_arg;
+            err_col = col_arg;
+            err_at_offset = false;
+            err_code = code;
+        }
+
+
+    protected:
+        enum parse_state_t {
+            ps_value,     // A JSON value of any type is being parsed
+            ps_str_value, // A JSON string is being parsed
+
+            ps_array,     // A JSON array is being parsed
+            ps_elements,  // Elements in a JSON array is being parsed
+
+            ps_object,    // A JSON object is being parsed
+            ps_members,   // Members (attributes) of an object is being parsed
+            ps_pair,      // A key-value pair of an object member is being parsed
+
+            ps_skip,      // A JSON value outside of the projection is being skipped
+        };
+
+        unsigned max_depth {0};
+        unsigned max_array_size {0};
+        unsigned max_object_size {0};
+        bool strict {true};
+
+        unsigned err_row {0};
+        unsigned err_col {0};
+        size_t err_offset {0};
+        bool err_at_offset {false};
+        jparser::err err_code {jparser::err::ok};
+        bool first_token {true};
+
+        std::vector<parse_state_t> parse_state;
+
+        // The currently parsed arrays and objects, with the
+        // innermost one at the back.
+        std::vector<Frame> frames;
+
+        // Projection:
+        // 'next_proj' is the projection node of the value about to be
+        // parsed, nullptr if the whole value is parsed, and 'next_skip'
+        // is true if the value is skipped. While a value is skipped,
+        // 'skip_brackets' holds the open brackets, and 'skip_string'
+        // is true after a skipped string in relaxed mode, since it
+        // may be followed by more strings.
+        const projection_node_t* next_proj {nullptr};
+        bool next_skip {false};
+        std::vector<char> skip_brackets;
+        bool skip_string {false};
+
+        void reset_machine () {
+            err_row = 0;
+            err_col = 0;
+            err_offset = 0;
+            err_at_offset = false;
+            err_code = jparser::err::ok;
+            first_token = true;
+            parse_state.clear ();
+            frames.clear ();
+            next_proj = nullptr;
+            next_skip = false;
+            skip_brackets.clear ();
+            skip_string = false;
+        }
+
+        // Expect a top level value.
+        void expect_value (const projection_node_t* root) {
+            parse_state.push_back (ps_value);
+            next_proj = root && !root->whole ? root : nullptr;
+        }
+
+        // The row and column of the error is calculated
+        // from the buffer offset when parsing is done.
+        void error_at_offset (const jparser::err code, size_t offset) {
+            err_offset = offset;
+            err_at_offset = true;
+            err_code = code;
+        }
+        void error (const jparser::err code, const jtoken& token) {
+            error_at_offset (code, token.offset);
+        }
+
+        // A value is parsed and is an item of an array.
+        bool in_elements () const {
+            return !parse_state.empty()  &&  parse_state.back() == ps_elements;
+        }
+
+        void parse_token (const jtoken& token);
+        void finish_tokens (size_t end_offset);
+
+        // Default implementations of optional event handlers.
+        std::string_view projected_name (const Frame& frame) {
+            return std::string_view ();
+        }
+        void on_skipped_items (size_t n) {
+        }
+        bool on_document_done () {
+            return false;
+        }
+
+
+    private:
+        Derived& derived () {
+            return static_cast<Derived&> (*this);
+        }
+
+        void on_value_done (const jtoken& token);
+        void on_value_start ();
+        void on_skipped_value (const jtoken& token);
+        void push_value (const projection_node_t* parent, std::string_view name);
+        void push_element_value ();
+        void push_member_value ();
+        void end_array (const jtoken& token);
+        void end_object (const jtoken& token);
+        void parse_value_or_skip_tokens (const jtoken& token);
+        bool parse_skip_tokens (const jtoken& token);
+        void parse_value_tokens (const jtoken& token);
+        bool parse_str_value_tokens (const jtoken& token);
+        void parse_array_tokens (const jtoken& token);
+        void parse_elements_tokens (const jtoken& token);
+        void parse_object_tokens (const jtoken& token);
+        void parse_members_tokens (const jtoken& token);
+        void on_object_member_name (const jtoken& token);
+        void parse_pair_tokens (const jtoken& token);
+    };
+
+
+#if 0
+value:          str_value
+        |       NUMBER
+        |       object
+        |       array
+        |       TRUE
+        |       FALSE
+        |       NULL
+                ;
+
+str_value:	STRING
+	|	STRING str_value          // Relaxed mode
+		;
+
+array:          LBRACK RBRACK
+        |       LBRACK elements RBRACK
+                ;
+
+elements:       value SEPARATOR elements
+        |       value SEPARATOR           // Relaxed mode
+        |       value
+                ;
+
+object:         LCBRACK RCBRACK
+        |       LCBRACK members RCBRACK
+                ;
+
+members:        pair SEPARATOR members
+        |       pair SEPARATOR            // Relaxed mode
+        |       pair
+                ;
+
+pair:           STRING COLON value
+        |       IDENTIFIER COLON value    // Relaxed mode
+                ;
+#endif
+
+
+    //--------------------------------------------------------------------------
+    // Called when a value is parsed, after its ps_value state is popped.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::on_value_done (const jtoken& token)
+    {
+        if (max_array_size  &&  err_code == jparser::err::ok  &&  in_elements()) {
+            if (frames.back().index > max_array_size)
+                error (jparser::err::max_array_size_exceeded, token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Called when a value that isn't skipped starts. Skipped array
+    // items before it are replaced by null values to keep its index.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::on_value_start ()
+    {
+        if (frames.empty())
+            return;
+        auto& frame = frames.back ();
+        if (frame.skipped  &&  parse_state.size() >= 2  &&
+            parse_state[parse_state.size()-2] == ps_elements)
+        {
+            auto n = frame.skipped;
+            frame.skipped = 0;
+            derived().on_skipped_items (n);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::on_skipped_value (const jtoken& token)
+    {
+        parse_state.pop_back (); // pop ps_skip
+        skip_string = false;
+        if (parse_state.empty())
+            return;
+
+        auto& frame = frames.back ();
+        if (parse_state.back() == ps_elements) {
+            ++frame.skipped;
+            if (max_array_size  &&  frame.index > max_array_size)
+                error (jparser::err::max_array_size_exceeded, token);
+        }else{
+            frame.skip_member = true;
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Expect a value, and find out if it is parsed or skipped.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::push_value (const projection_node_t* parent,
+                                                    std::string_view name)
+    {
+        parse_state.push_back (ps_value);
+        next_proj = nullptr;
+        next_skip = false;
+        if (parent) {
+            auto* node = parent->child (name);
+            if (node == nullptr)
+                next_skip = true;
+            else if (!node->whole)
+                next_proj = node;
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::push_element_value ()
+    {
+        auto& frame = frames.back ();
+        auto index = frame.index++;
+        if (frame.proj == nullptr) {
+            parse_state.push_back (ps_value);
+            next_proj = nullptr;
+            next_skip = false;
+        }else{
+            char name[24];
+            auto result = std::to_chars (name, name+sizeof(name), index);
+            push_value (frame.proj, std::string_view(name, result.ptr-name));
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::push_member_value ()
+    {
+        auto& frame = frames.back ();
+        if (frame.proj == nullptr) {
+            parse_state.push_back (ps_value);
+            next_proj = nullptr;
+            next_skip = false;
+        }else{
+            push_value (frame.proj, derived().projected_name(frame));
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Parse a value, or start skipping it. A scalar value is also
+    // skipped if the projection selects something inside of it.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_value_or_skip_tokens (const jtoken& token)
+    {
+        if (next_skip || next_proj) {
+            bool skip = next_skip;
+            if (!skip && !frames.empty()) {
+                switch (token.type) {
+                case jtoken::tk_null:
+                case jtoken::tk_true:
+                case jtoken::tk_false:
+                case jtoken::tk_string:
+                case jtoken::tk_number:
+                    skip = true;
+                    break;
+                default:
+                    break;
+                }
+            }
+            if (skip) {
+                next_skip = false;
+                parse_state.pop_back (); // pop ps_value
+                parse_state.push_back (ps_skip);
+                skip_brackets.clear ();
+                skip_string = false;
+                parse_skip_tokens (token);
+                return;
+            }
+        }
+        parse_value_tokens (token);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Skip a value. Only brackets are matched, values
+    // inside the skipped value are not checked.
+    // Returns false if the token wasn't consumed.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    bool parse_machine<Derived, Frame>::parse_skip_tokens (const jtoken& token)
+    {
+        if (skip_string) {
+            // Relaxed mode, a string may be followed by more strings
+            if (token.type == jtoken::tk_string)
+                return true;
+            on_skipped_value (token);
+            return false; // Token not consumed
+        }
+
+        bool not_a_value = false;
+        switch (token.type) {
+        case jtoken::tk_lcbrack:
+        case jtoken::tk_lbrack:
+            if (max_depth  &&  frames.size()+skip_brackets.size() >= max_depth) {
+                error (jparser::err::max_depth_exceeded, token);
+                break;
+            }
+            skip_brackets.push_back (token.type==jtoken::tk_lcbrack ? '{' : '[');
+            break;
+
+        case jtoken::tk_rcbrack:
+        case jtoken::tk_rbrack:
+            if (skip_brackets.empty()) {
+                not_a_value = true;
+            }
+            else if (skip_brackets.back() != (token.type==jtoken::tk_rcbrack ? '{' : '[')) {
+                error (token.type==jtoken::tk_rcbrack ?
+                       jparser::err::misplaced_right_curly_bracket :
+                       jparser::err::misplaced_right_bracket,
+                       token);
+            }else{
+                skip_brackets.pop_back ();
+                if (skip_brackets.empty())
+                    on_skipped_value (token);
+            }
+            break;
+
+        case jtoken::tk_null:
+        case jtoken::tk_true:
+        case jtoken::tk_false:
+        case jtoken::tk_number:
+            if (skip_brackets.empty())
+                on_skipped_value (token);
+            break;
+
+        case jtoken::tk_string:
+            if (skip_brackets.empty()) {
+                if (strict)
+                    on_skipped_value (token);
+                else
+                    skip_string = true;
+            }
+            break;
+
+        case jtoken::tk_invalid:
+            error (jparser::err::invalid_token, token);
+            break;
+
+        case jtoken::tk_comment:
+            // Ignore comments
+            break;
+
+        default:
+            // Separators, colons, and identifiers
+            if (skip_brackets.empty())
+                not_a_value = true;
+            break;
+        }
+
+        if (not_a_value) {
+            // Let the value parser handle, or report, the token
+            parse_state.pop_back ();  // pop ps_skip
+            parse_state.push_back (ps_value);
+            parse_value_tokens (token);
+        }
+        return true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_value_tokens (const jtoken& token)
+    {
+        switch (token.type) {
+        case jtoken::tk_invalid:
+            error (jparser::err::invalid_token, token);
+            break;
+
+        case jtoken::tk_lcbrack:
+            // Start of object
+            if (max_depth  &&  frames.size() >= max_depth) {
+                error (jparser::err::max_depth_exceeded, token);
+            }else{
+                on_value_start ();
+                parse_state.push_back (ps_object);
+                frames.emplace_back ();
+                frames.back().proj = next_proj;
+                derived().on_begin_object (token, frames.back());
+            }
+            break;
+
+        case jtoken::tk_rcbrack:
+            error (jparser::err::misplaced_right_curly_bracket, token);
+            break;
+
+        case jtoken::tk_lbrack:
+            // Start of array
+            if (max_depth  &&  frames.size() >= max_depth) {
+                error (jparser::err::max_depth_exceeded, token);
+            }else{
+                on_value_start ();
+                parse_state.push_back (ps_array);
+                frames.emplace_back ();
+                frames.back().proj = next_proj;
+                derived().on_begin_array (token, frames.back());
+            }
+            break;
+
+        case jtoken::tk_rbrack:
+            if (strict) {
+                error (jparser::err::misplaced_right_bracket, token);
+            }else{
+                parse_state.pop_back ();
+                if (in_elements())
+                    parse_elements_tokens (token);
+                else
+                    error (jparser::err::misplaced_right_bracket, token);
+            }
+            break;
+
+        case jtoken::tk_separator:
+            error (jparser::err::misplaced_separator, token);
+            break;
+
+        case jtoken::tk_colon:
+            error (jparser::err::misplaced_colon, token);
+            break;
+
+        case jtoken::tk_null:
+            on_value_start ();
+            parse_state.pop_back ();
+            derived().on_null (token);
+            on_value_done (token);
+            break;
+
+        case jtoken::tk_true:
+        case jtoken::tk_false:
+            on_value_start ();
+            parse_state.pop_back ();
+            derived().on_bool (token, token.type == jtoken::tk_true);
+            on_value_done (token);
+            break;
+
+        case jtoken::tk_string:
+            on_value_start ();
+            if (strict) {
+                parse_state.pop_back ();
+                derived().on_string (token);
+                on_value_done (token);
+            }else{
+                derived().on_string_part (token, true);
+                parse_state.push_back (ps_str_value);
+            }
+            break;
+
+        case jtoken::tk_number:
+            on_value_start ();
+            parse_state.pop_back ();
+            derived().on_number (token);
+            on_value_done (token);
+            break;
+
+        case jtoken::tk_identifier:
+            error (jparser::err::invalid_token, token);
+            break;
+
+        case jtoken::tk_comment:
+            // Ignore comments
+            break;
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    bool parse_machine<Derived, Frame>::parse_str_value_tokens (const jtoken& token)
+    {
+        if (token.type != jtoken::tk_string) {
+            parse_state.pop_back (); // pop ps_str_value
+            parse_state.pop_back (); // pop ps_value
+            derived().on_string_end (token);
+            on_value_done (token);
+            return false; // Token not consumed
+        }
+
+        derived().on_string_part (token, false);
+        return true; // Token consumed
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::end_array (const jtoken& token)
+    {
+        parse_state.pop_back (); // pop ps_array
+        parse_state.pop_back (); // pop ps_value
+        Frame frame = std::move (frames.back());
+        frames.pop_back ();
+        derived().on_end_array (token, frame);
+        on_value_done (token);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_elements_tokens (const jtoken& token)
+    {
+        if (token.type == jtoken::tk_separator) {
+            push_element_value ();
+        }
+        else if (token.type == jtoken::tk_rbrack) {
+            // Array done !
+            parse_state.pop_back (); // pop ps_elements
+            end_array (token);
+        }
+        else {
+            error (jparser::err::expected_separator_or_right_bracket, token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_array_tokens (const jtoken& token)
+    {
+        if (token.type == jtoken::tk_rbrack) {
+            // Array done - empty array
+            end_array (token);
+        }else{
+            // Start collecting array values
+            parse_state.push_back (ps_elements);
+            push_element_value ();
+
+            parse_value_or_skip_tokens (token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::on_object_member_name (const jtoken& token)
+    {
+        auto& frame = frames.back ();
+
+        // Check object size limit
+        if (max_object_size  &&  frame.index+1 > max_object_size) {
+            error (jparser::err::max_obj_size_exceeded, token);
+            return;
+        }
+
+        derived().on_member_name (token, frame);
+        frame.has_name = true;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_pair_tokens (const jtoken& token)
+    {
+        auto& frame = frames.back ();
+        if (frame.has_name == false) {
+            // We haven't got a member name yet
+            if (token.type == jtoken::tk_string  ||  token.type == jtoken::tk_identifier) {
+
+                on_object_member_name (token);
+
+            }else{
+                if (strict==false && token.type == jtoken::tk_rcbrack) {
+                    // Object member list ended with a ','
+                    parse_state.pop_back (); // ps_pair
+                    parse_members_tokens (token);
+                }else{
+                    error (jparser::err::expected_obj_member_name, token);
+                }
+            }
+        }
+        else if (frame.has_colon == false) {
+            // We haven't got a colon yet
+            if (token.type == jtoken::tk_colon) {
+                frame.has_colon = true;
+                // We got a colon, now we expect a value
+                push_member_value ();
+            }else{
+                error (jparser::err::expected_colon, token);
+            }
+        }
+        else {
+            // We have a key-value pair
+            if (frame.skip_member) {
+                frame.skip_member = false;
+            }else{
+                ++frame.index;
+                derived().on_member_value (frame);
+            }
+            parse_state.pop_back (); // ps_pair
+
+            parse_members_tokens (token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::end_object (const jtoken& token)
+    {
+        parse_state.pop_back (); // pop ps_object
+        parse_state.pop_back (); // pop ps_value
+        Frame frame = std::move (frames.back());
+        frames.pop_back ();
+        derived().on_end_object (token, frame);
+        on_value_done (token);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_members_tokens (const jtoken& token)
+    {
+        if (token.type == jtoken::tk_separator) {
+            // Next object member
+            frames.back().has_name = false;
+            frames.back().has_colon = false;
+            parse_state.push_back (ps_pair);
+        }
+        else if (token.type == jtoken::tk_rcbrack) {
+            // Object done !
+            parse_state.pop_back (); // pop ps_members
+            end_object (token);
+        }
+        else {
+            error (jparser::err::expected_separator_or_right_curly_bracket, token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_object_tokens (const jtoken& token)
+    {
+        if (token.type == jtoken::tk_rcbrack) {
+            // An empty object
+            end_object (token);
+        }else{
+            // Start parsing a new object member
+            parse_state.push_back (ps_members);
+            parse_state.push_back (ps_pair);
+
+            parse_pair_tokens (token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Parse a token that isn't a comment.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::parse_token (const jtoken& token)
+    {
+        if (first_token) {
+            if (token.type == jtoken::tk_invalid) {
+                if (token.err_code == jtoken::ok)
+                    error (jparser::err::eob, token);
+                else
+                    error (token_error_to_parser_error(token.err_code), token);
+                return;
+            }
+            first_token = false;
+        }
+
+        if (parse_state.empty() || token.err_code != jtoken::ok) {
+            //
+            // Unexpected token(s) after successully parsing a JSON instance,
+            // or an invalid token.
+            //
+            error (jparser::err::unexpected_character, token);
+            return;
+        }
+
+        bool token_consumed;
+        do {
+            token_consumed = true;
+            switch (parse_state.back()) {
+            case ps_value:
+                parse_value_or_skip_tokens (token);
+                break;
+            case ps_str_value:
+                token_consumed = parse_str_value_tokens (token);
+                break;
+            case ps_array:
+                parse_array_tokens (token);
+                break;
+            case ps_elements:
+                parse_elements_tokens (token);
+                break;
+            case ps_object:
+                parse_object_tokens (token);
+                break;
+            case ps_members:
+                parse_members_tokens (token);
+                break;
+            case ps_pair:
+                parse_pair_tokens (token);
+                break;
+            case ps_skip:
+                token_consumed = parse_skip_tokens (token);
+                break;
+            }
+        }while (!token_consumed                 &&
+                err_code == jparser::err::ok    &&
+                parse_state.empty() == false);
+
+        if (parse_state.empty()  &&
+            err_code == jparser::err::ok  &&
+            derived().on_document_done())
+        {
+            // A document is done, and another one is expected
+            if (!token_consumed)
+                parse_token (token);
+            return;
+        }
+
+        if (!token_consumed  &&  err_code == jparser::err::ok) {
+            // Unexpected token(s) after successully parsing a JSON instance
+            error (jparser::err::unexpected_character, token);
+        }
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Called when there are no more tokens. Finish a string in relaxed
+    // mode, and check for unterminated arrays and objects.
+    // 'end_offset' is the buffer offset of the end of the input.
+    //--------------------------------------------------------------------------
+    template<class Derived, class Frame>
+    void parse_machine<Derived, Frame>::finish_tokens (size_t end_offset)
+    {
+        if (err_code == jparser::err::ok  &&  first_token) {
+            // No JSON instance found
+            derived().on_error_at_end (jparser::err::eob);
+            return;
+        }
+
+        jtoken end_token;
+        end_token.offset = end_offset;
+        if (err_code == jparser::err::ok  &&
+            !parse_state.empty()  &&
+            parse_state.back() == ps_str_value)
+        {
+            // We were parsing a string in relaxed mode, finish it
+            parse_str_value_tokens (end_token);
+        }
+        if (err_code == jparser::err::ok  &&
+            !parse_state.empty()  &&
+            parse_state.back() == ps_skip  &&
+            skip_string)
+        {
+            // We were skipping a string in relaxed mode
+            parse_skip_tokens (end_token);
+        }
+
+        if (err_code != jparser::err::ok  ||  parse_state.empty())
+            return;
+
+        //
+        // Unterminated array or object ?
+        //
+        if (parse_state.back() == ps_skip  &&  !skip_brackets.empty()) {
+            derived().on_error_at_end (skip_brackets.back() == '[' ?
+                                       jparser::err::unterminated_array :
+                                       jparser::err::unterminated_object);
+            return;
+        }
+        for (auto i=parse_state.rbegin(); i!=parse_state.rend(); ++i) {
+            if (*i==ps_array || *i==ps_elements) {
+                derived().on_error_at_end (jparser::err::unterminated_array);
+                return;
+            }
+            else if (*i==ps_object || *i==ps_members || *i==ps_pair) {
+                derived().on_error_at_end (jparser::err::unterminated_object);
+                return;
+            }
+        }
+        derived().on_error_at_end (jparser::err::eob);
+    }
+
+
+}
+#endif
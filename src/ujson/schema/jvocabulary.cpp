@@ -17,8 +17,15 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 #include <ujson/schema/jvocabulary.hpp>
+#include <ujson/schema/validation_profile.hpp>
 #include <ujson/jschema.hpp>
+#include <ujson/jarena.hpp>
 #include <memory>
+#include <optional>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
 #include <regex>
 #include <string_view>
 
@@ -41,15 +48,6 @@ namespace ujson::schema {
     static const std::regex uri_regex ("^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\\?([^#]*))?(#(.*))?", std::regex::awk);
 
 
-    // Functor used when we create a std::shared_ptr<validation_context>
-    // but we don't want it to delete the pointer when it's done.
-    struct nulldeleter {
-        void operator() (validation_context*) {
-            ; // Do nothing here
-        }
-    };
-
-
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvocabulary::jvocabulary (jschema& root_schema_arg)
@@ -86,21 +84,24 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvocabulary::validate_subschema (validation_context& ctx,
-                                          jvalue& sub_schema,
-                                          jvalue& instance,
+                                          const jvalue& sub_schema,
+                                          const jvalue& instance,
                                           const bool quit_on_first_error,
                                           const bool create_subcontext,
                                           const bool ignore_annotations,
-                                          const bool invalidate_parent_if_invalid)
+                                          const bool invalidate_parent_if_invalid) const
     {
-        std::shared_ptr<validation_context> sub_ctx;
-        if (create_subcontext)
-            sub_ctx.reset (new validation_context(ctx));
-        else
-            sub_ctx.reset (&ctx, nulldeleter()); // Don't actually delete anything
+        std::optional<validation_context> new_ctx;
+        validation_context* sub_ctx = &ctx;
+        if (create_subcontext) {
+            new_ctx.emplace (ctx);
+            sub_ctx = &new_ctx.value ();
+        }
 
         // Validate the subschema
+        validation_profile::timer prof (*sub_ctx, false);
         bool is_valid = root_schema.validate (*sub_ctx, sub_schema, instance, quit_on_first_error);
+        prof.stop (is_valid);
         sub_ctx->set_valid (is_valid);
 
         if (sub_ctx->parent) {
@@ -122,6 +123,126 @@ namespace ujson::schema {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    bool jvocabulary::validate_children (validation_context& ctx,
+                                         const size_t num_children,
+                                         const bool quit_on_first_error,
+                                         const child_validator_t& validate_child,
+                                         std::vector<char>* valid) const
+    {
+        unsigned workers = 1;
+        if (ctx.parallel  &&  num_children >= root_schema.parallel_min_elements) {
+            workers = root_schema.num_threads;
+            if (workers == 0)
+                workers = std::thread::hardware_concurrency ();
+        }
+        if (valid)
+            valid->clear ();
+
+        if (workers < 2) {
+            bool all_valid = true;
+            for (size_t i=0; i<num_children; ++i) {
+                bool child_valid = validate_child (ctx, i);
+                if (valid)
+                    valid->push_back (child_valid);
+                if (!child_valid) {
+                    all_valid = false;
+                    if (quit_on_first_error)
+                        break;
+                }
+            }
+            return all_valid;
+        }
+
+        // Split the children in batches of consecutive children.
+        // Each batch is validated in its own context, with its own
+        // copy of the paths, and no further parallel validation.
+        //
+        size_t batch_size = std::max (num_children / (workers * 8), (size_t)16);
+        size_t num_batches = (num_children + batch_size - 1) / batch_size;
+        workers = std::min (workers, (unsigned)num_batches);
+
+        std::vector<std::unique_ptr<validation_context>> batch_ctx (num_batches);
+        for (auto& bctx : batch_ctx) {
+            bctx.reset (new validation_context(ctx));
+            bctx->parallel = false;
+            bctx->detach_paths ();
+        }
+        std::vector<std::exception_ptr> errors (num_batches);
+        std::vector<char> results (num_children, 0);
+
+        // The index of the first child that failed validation
+        // (when quitting on the first error), or threw an exception.
+        // Children after it are not validated.
+        std::atomic<size_t> stop_at (num_children);
+        auto stop = [&stop_at] (size_t i) {
+            size_t current = stop_at;
+            while (i < current  &&  !stop_at.compare_exchange_weak(current, i))
+                ;
+        };
+
+        std::atomic<size_t> next_batch (0);
+        auto* arena = jarena::current ();
+        auto worker = [&] () {
+            std::optional<jarena::scope> use_arena;
+            if (arena)
+                use_arena.emplace (*arena);
+            size_t batch;
+            while ((batch=next_batch++) < num_batches) {
+                size_t i = batch * batch_size;
+                size_t end = std::min (i + batch_size, num_children);
+                try {
+                    for (; i<end && i<stop_at; ++i) {
+                        results[i] = validate_child (*batch_ctx[batch], i);
+                        if (!results[i] && quit_on_first_error) {
+                            stop (i);
+                            break;
+                        }
+                    }
+                }
+                catch (...) {
+                    errors[batch] = std::current_exception ();
+                    stop (i);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i=1; i<workers; ++i)
+            threads.emplace_back (worker);
+        worker ();
+        for (auto& t : threads)
+            t.join ();
+
+        // Merge the batches in order, up to the child where validation stopped
+        //
+        size_t num_validated = std::min ((size_t)stop_at + 1, num_children);
+        for (size_t batch=0; batch<num_batches && batch*batch_size < num_validated; ++batch) {
+            if (errors[batch])
+                std::rethrow_exception (errors[batch]);
+            auto& bctx = *batch_ctx[batch];
+            if (ctx.build_output) {
+                for (auto& member : bctx.output_unit.obj()) {
+                    const std::string& name = member.first;
+                    if (name != "annotations"  &&  name != "errors")
+                        continue;
+                    auto where = name=="annotations" ? validation_context::place_annotation
+                                                     : validation_context::place_error;
+                    for (auto& sub_output_unit : member.second.array())
+                        ctx.add_output_unit (std::move(sub_output_unit), where);
+                }
+            }
+            ctx.collect_annotations (bctx);
+        }
+
+        if (valid)
+            valid->assign (results.begin(), results.begin()+num_validated);
+        return std::find(results.begin(), results.begin()+num_validated, 0)
+            == results.begin()+num_validated;
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     void jvocabulary::push_load_ctx_path (jvalue& load_ctx, const std::string& entry)
@@ -144,7 +265,7 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    std::map<std::string, std::string>& jvocabulary::id_aliases ()
+    const std::map<std::string, std::string>& jvocabulary::id_aliases () const
     {
         return root_schema.id_alias;
     }
@@ -183,6 +304,34 @@ namespace ujson::schema {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::shared_ptr<const std::regex> jvocabulary::compiled_regex (const jvalue& schema_node,
+                                                                   const std::string_view& pattern) const
+    {
+        {
+            std::lock_guard<std::mutex> lock (regex_mutex);
+            auto entry = regex_cache.find (&schema_node);
+            if (entry != regex_cache.end()  &&  entry->second.first == pattern)
+                return entry->second.second;
+        }
+
+        // Not compiled yet, or the schema value has
+        // changed since the pattern was compiled
+        auto re = std::make_shared<const std::regex> (pattern.begin(), pattern.end(), std::regex::ECMAScript);
+        std::lock_guard<std::mutex> lock (regex_mutex);
+        auto& cached = regex_cache[&schema_node];
+        if (cached.second  &&  cached.first == pattern) {
+            // Compiled by another thread in the meantime
+            return cached.second;
+        }
+        // Callers still using a replaced regex keep their own reference to it
+        cached.first = pattern;
+        cached.second = std::move (re);
+        return cached.second;
+    }
+
+
     //------------------------------------------------------------------------------
     //------------------------------------------------------------------------------
     int jvocabulary::split_uri (const std::string& full_uri,
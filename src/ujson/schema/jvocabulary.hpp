@@ -23,6 +23,12 @@
 #include <ujson/schema/validation_context.hpp>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <regex>
 
 
 // Forward declarations
@@ -80,9 +86,9 @@ namespace ujson::schema {
          *         <code>false</code> if not.
          */
         virtual bool validate (validation_context& ctx,
-                               jvalue& schema,
-                               jvalue& instance,
-                               const bool quit_on_first_error) = 0;
+                               const jvalue& schema,
+                               const jvalue& instance,
+                               const bool quit_on_first_error) const = 0;
 
         /**
          * Return the JSON vocabulary id.
@@ -105,18 +111,72 @@ namespace ujson::schema {
         void load_subschema (jvalue& sub_schema);
 
         bool validate_subschema (validation_context& ctx,
-                                 jvalue& sub_schema,
-                                 jvalue& instance,
+                                 const jvalue& sub_schema,
+                                 const jvalue& instance,
                                  const bool quit_on_first_error,
                                  const bool create_subcontext=true,
                                  const bool ignore_annotations=false,
-                                 const bool invalidate_parent_if_invalid=false);
+                                 const bool invalidate_parent_if_invalid=false) const;
+
+        /**
+         * Validate a child instance.
+         * @param ctx The context to validate in. The function must
+         *            push and pop any path entries it uses.
+         * @param index The index of the child.
+         * @return <code>true</code> if the child is valid.
+         */
+        using child_validator_t = std::function<bool (validation_context& ctx, size_t index)>;
+
+        /**
+         * Validate the child instances of an array or object.
+         * If parallel validation is enabled in the jschema object, and
+         * there are enough children, they are validated in batches by
+         * a number of threads. Output units and annotations are then
+         * merged into <code>ctx</code> in the order of the children,
+         * so the result is the same as when validated serially.
+         * @param ctx The validation context.
+         * @param num_children The number of children.
+         * @param quit_on_first_error Stop validating after the first invalid child.
+         * @param validate_child Function validating a child.
+         * @param valid If not <code>nullptr</code>, the result of each validated
+         *              child. When stopping after an invalid child, later
+         *              children are not included.
+         * @return <code>true</code> if all validated children are valid.
+         */
+        bool validate_children (validation_context& ctx,
+                                const size_t num_children,
+                                const bool quit_on_first_error,
+                                const child_validator_t& validate_child,
+                                std::vector<char>* valid=nullptr) const;
 
         void push_load_ctx_path (jvalue& load_ctx, const std::string& entry);
         void pop_load_ctx_path (jvalue& load_ctx);
 
         //          alias         id
-        std::map<std::string, std::string>& id_aliases ();
+        const std::map<std::string, std::string>& id_aliases () const;
+
+        /**
+         * Return a compiled regular expression for a pattern in the schema.
+         * The regular expression is compiled the first time it is
+         * requested and then kept for as long as this vocabulary exists.
+         * The returned regular expression stays valid for as long as the
+         * caller holds on to it, even if the cached entry is replaced
+         * by another thread because the pattern in the schema changed.
+         * @param schema_node The schema value the pattern belongs to.
+         * @param pattern An ECMAScript regular expression.
+         * @return A compiled regular expression.
+         * @throw std::regex_error If the pattern is not a valid regular expression.
+         */
+        std::shared_ptr<const std::regex> compiled_regex (const jvalue& schema_node,
+                                                          const std::string_view& pattern) const;
+
+
+    private:
+        // Compiled regular expressions, keyed on the schema value
+        // they belong to. The pattern is kept to detect changes.
+        mutable std::unordered_map<const jvalue*,
+                                   std::pair<std::string, std::shared_ptr<const std::regex>>> regex_cache;
+        mutable std::mutex regex_mutex;
     };
 
 
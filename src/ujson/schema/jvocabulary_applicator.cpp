@@ -23,6 +23,7 @@
 #include <functional>
 #include <regex>
 #include <set>
+#include <vector>
 
 #define DEVEL_DEBUG 0
 
@@ -82,7 +83,7 @@ namespace ujson::schema {
                         j_object, nullptr,
                         j_object,  &jvocabulary_applicator::validate_properties)},
             {"patternProperties", std::make_tuple(
-                        j_object, nullptr,
+                        j_object, &jvocabulary_applicator::load_patternProperties,
                         j_object,  &jvocabulary_applicator::validate_patternProperties)},
             {"additionalProperties", std::make_tuple(
                         j_invalid, nullptr,
@@ -150,6 +151,42 @@ namespace ujson::schema {
 
             pop_load_ctx_path (load_ctx);
         }
+
+        compile (schema, compiled_schemas[&schema]);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Return a pointer to a schema keyword value, or nullptr if not found
+    //--------------------------------------------------------------------------
+    static const jvalue* keyword_value (const jvalue& schema, const std::string& keyword)
+    {
+        auto& value = schema.get (keyword);
+        return value.valid() ? &value : nullptr;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvocabulary_applicator::compile (const jvalue& schema, compiled_schema_t& compiled)
+    {
+        compiled.keywords.clear ();
+        for (auto& member : schema.obj()) {
+            auto entry = keywords.find (member.first);
+            if (entry == keywords.end())
+                continue;
+            auto kw_validator = std::get<3> (entry->second);
+            if (kw_validator || entry->first == "if") {
+                compiled.keywords.push_back ({&entry->first,
+                                              &member.second,
+                                              std::get<2> (entry->second),
+                                              kw_validator});
+            }
+        }
+        compiled.kw_then = keyword_value (schema, "then");
+        compiled.kw_else = keyword_value (schema, "else");
+        compiled.kw_items = keyword_value (schema, "items");
+        compiled.kw_additionalProperties = keyword_value (schema, "additionalProperties");
     }
 
 
@@ -229,65 +266,97 @@ namespace ujson::schema {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvocabulary_applicator::load_patternProperties (jvalue& schema_value, jvalue& load_ctx)
+    {
+        if (schema_value.type() != j_object)
+            return;
+
+        for (auto& sub_schema : schema_value.obj()) {
+            push_load_ctx_path (load_ctx, sub_schema.first);
+            load_subschema (sub_schema.second);
+            pop_load_ctx_path (load_ctx);
+            try {
+                // Compile the pattern now instead of at each validation.
+                // An invalid pattern is reported when validating.
+                const std::string& pattern = sub_schema.first;
+                compiled_regex (sub_schema.second, pattern);
+            }
+            catch (std::regex_error&) {
+            }
+        }
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate (validation_context& ctx,
-                                           jvalue& schema,
-                                           jvalue& instance,
-                                           const bool quit_on_first_error)
+                                           const jvalue& schema,
+                                           const jvalue& instance,
+                                           const bool quit_on_first_error) const
     {
         auto instance_type = instance.type ();
         bool keyword_if_handled = false;
         bool is_if_true = false;
         bool valid = true;
 
-        for (auto& member : schema.obj()) {
+        // Schemas that weren't loaded, like a '$ref' to a location
+        // that is not a subschema, are compiled when validated.
+        compiled_schema_t not_loaded;
+        auto entry = compiled_schemas.find (&schema);
+        if (entry == compiled_schemas.end())
+            compile (schema, not_loaded);
+        auto& compiled = entry==compiled_schemas.end() ? not_loaded : entry->second;
+
+        for (auto& kw : compiled.keywords) {
 
             if (quit_on_first_error && valid==false)
                 break;
 
-            const std::string& schema_keyword = member.first;
-            ujson::jvalue& schema_value = member.second;
-
-            // Find a validator for this keyword
-            auto entry = keywords.find (schema_keyword);
-            if (entry != keywords.end()) {
-                auto kw_validator = std::get<3> (entry->second);
-                if (kw_validator) {
-                    // Check if the keyword handles this type of instance
-                    auto kw_jtype = std::get<2> (entry->second);
-                    if (kw_jtype==instance_type || kw_jtype==j_invalid) {
-                        std::string error_msg;
-                        ctx.push_schema_path (schema_keyword);
-                        if ((this->*kw_validator)(ctx, schema, schema_value, instance, quit_on_first_error) == false)
-                            valid = false;
-                        ctx.pop_schema_path ();
-                        continue;
-                    }
+            if (kw.validator) {
+                // Check if the keyword handles this type of instance
+                if (kw.instance_type==instance_type || kw.instance_type==j_invalid) {
+                    ctx.push_schema_path (*kw.keyword);
+                    validation_profile::timer prof (ctx);
+                    bool kw_valid = (this->*kw.validator)(ctx, schema, *kw.value, instance, quit_on_first_error);
+                    prof.stop (kw_valid);
+                    if (kw_valid == false)
+                        valid = false;
+                    ctx.pop_schema_path ();
                 }
+                continue;
             }
 
             // Handle if-then-else
             //
-            if (!keyword_if_handled && schema_keyword == "if") {
+            if (!keyword_if_handled) {
                 keyword_if_handled = true;
                 ctx.push_schema_path ("if");
-                is_if_true = validate_if (ctx, schema, schema_value, instance, quit_on_first_error);
+                {
+                    validation_profile::timer prof (ctx);
+                    is_if_true = validate_if (ctx, schema, *kw.value, instance, quit_on_first_error);
+                    prof.stop (is_if_true);
+                }
                 ctx.pop_schema_path ();
 
                 if (is_if_true) {
-                    auto& schema_value = schema.get ("then");
-                    if (schema_value.valid()) {
+                    if (compiled.kw_then) {
                         ctx.push_schema_path ("then");
-                        if (validate_then(ctx, schema, schema_value, instance, quit_on_first_error) == false)
+                        validation_profile::timer prof (ctx);
+                        bool kw_valid = validate_then (ctx, schema, *compiled.kw_then, instance, quit_on_first_error);
+                        prof.stop (kw_valid);
+                        if (kw_valid == false)
                             valid = false;
                         ctx.pop_schema_path ();
                     }
                 }else{
-                    auto& schema_value = schema.get ("else");
-                    if (schema_value.valid()) {
+                    if (compiled.kw_else) {
                         ctx.push_schema_path ("else");
-                        if (validate_else(ctx, schema, schema_value, instance, quit_on_first_error) == false)
+                        validation_profile::timer prof (ctx);
+                        bool kw_valid = validate_else (ctx, schema, *compiled.kw_else, instance, quit_on_first_error);
+                        prof.stop (kw_valid);
+                        if (kw_valid == false)
                             valid = false;
                         ctx.pop_schema_path ();
                     }
@@ -301,10 +370,12 @@ namespace ujson::schema {
         if (instance_type == j_array) {
             // Handle 'items' after other array-keywords
             // items depends on 'prefixItems'
-            auto& schema_value = schema.get ("items");
-            if (schema_value.valid()) {
+            if (compiled.kw_items) {
                 ctx.push_schema_path ("items");
-                if (validate_items(ctx, schema, schema_value, instance, quit_on_first_error) == false)
+                validation_profile::timer prof (ctx);
+                bool kw_valid = validate_items (ctx, schema, *compiled.kw_items, instance, quit_on_first_error);
+                prof.stop (kw_valid);
+                if (kw_valid == false)
                     valid = false;
                 ctx.pop_schema_path ();
             }
@@ -312,10 +383,13 @@ namespace ujson::schema {
         else if (instance_type == j_object) {
             // Handle 'additionalProperties' after other property-keywords
             // additionalProperties depends on 'properties' and 'patternProperties'
-            auto& schema_value = schema.get ("additionalProperties");
-            if (schema_value.valid()) {
+            if (compiled.kw_additionalProperties) {
                 ctx.push_schema_path ("additionalProperties");
-                if (validate_additionalProperties(ctx, schema, schema_value, instance, quit_on_first_error) == false)
+                validation_profile::timer prof (ctx);
+                bool kw_valid = validate_additionalProperties (ctx, schema, *compiled.kw_additionalProperties,
+                                                               instance, quit_on_first_error);
+                prof.stop (kw_valid);
+                if (kw_valid == false)
                     valid = false;
                 ctx.pop_schema_path ();
             }
@@ -331,10 +405,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_allOf (validation_context& ctx,
-                                                 jvalue& schema,
-                                                 jvalue& schema_value,
-                                                 jvalue& instance,
-                                                 const bool quit_on_first_error)
+                                                 const jvalue& schema,
+                                                 const jvalue& schema_value,
+                                                 const jvalue& instance,
+                                                 const bool quit_on_first_error) const
     {
         bool all_valid = true;
         validation_context ctx_allOf (ctx);
@@ -368,10 +442,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_anyOf (validation_context& ctx,
-                                                 jvalue& schema,
-                                                 jvalue& schema_value,
-                                                 jvalue& instance,
-                                                 const bool quit_on_first_error)
+                                                 const jvalue& schema,
+                                                 const jvalue& schema_value,
+                                                 const jvalue& instance,
+                                                 const bool quit_on_first_error) const
     {
         bool some_valid = false;
         validation_context ctx_anyOf (ctx);
@@ -402,10 +476,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_oneOf (validation_context& ctx,
-                                                 jvalue& schema,
-                                                 jvalue& schema_value,
-                                                 jvalue& instance,
-                                                 const bool quit_on_first_error)
+                                                 const jvalue& schema,
+                                                 const jvalue& schema_value,
+                                                 const jvalue& instance,
+                                                 const bool quit_on_first_error) const
     {
         size_t num_valid = 0;
         size_t num_subschemas = 0;
@@ -450,10 +524,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_not (validation_context& ctx,
-                                               jvalue& schema,
-                                               jvalue& schema_value,
-                                               jvalue& instance,
-                                               const bool quit_on_first_error)
+                                               const jvalue& schema,
+                                               const jvalue& schema_value,
+                                               const jvalue& instance,
+                                               const bool quit_on_first_error) const
     {
         validation_context sub_ctx (ctx);
 
@@ -475,10 +549,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_if (validation_context& ctx,
-                                              jvalue& schema,
-                                              jvalue& schema_value,
-                                              jvalue& instance,
-                                              const bool quit_on_first_error)
+                                              const jvalue& schema,
+                                              const jvalue& schema_value,
+                                              const jvalue& instance,
+                                              const bool quit_on_first_error) const
     {
         return validate_subschema (ctx, schema_value, instance, quit_on_first_error);
     }
@@ -490,10 +564,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_then (validation_context& ctx,
-                                                jvalue& schema,
-                                                jvalue& schema_value,
-                                                jvalue& instance,
-                                                const bool quit_on_first_error)
+                                                const jvalue& schema,
+                                                const jvalue& schema_value,
+                                                const jvalue& instance,
+                                                const bool quit_on_first_error) const
     {
         return validate_subschema (ctx, schema_value, instance, quit_on_first_error, true, false, true);
     }
@@ -505,10 +579,10 @@ namespace ujson::schema {
     // Applicator keywords for any instance
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_else (validation_context& ctx,
-                                                jvalue& schema,
-                                                jvalue& schema_value,
-                                                jvalue& instance,
-                                                const bool quit_on_first_error)
+                                                const jvalue& schema,
+                                                const jvalue& schema_value,
+                                                const jvalue& instance,
+                                                const bool quit_on_first_error) const
     {
         return validate_subschema (ctx, schema_value, instance, quit_on_first_error, true, false, true);
     }
@@ -520,10 +594,10 @@ namespace ujson::schema {
     // Applicator keywords for objects
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_dependentSchemas (validation_context& ctx,
-                                                            jvalue& schema,
-                                                            jvalue& schema_value,
-                                                            jvalue& instance,
-                                                            const bool quit_on_first_error)
+                                                            const jvalue& schema,
+                                                            const jvalue& schema_value,
+                                                            const jvalue& instance,
+                                                            const bool quit_on_first_error) const
     {
         bool all_valid = true;
         validation_context ctx_ds (ctx);
@@ -533,7 +607,7 @@ namespace ujson::schema {
             if (! instance.has(property_name))
                 continue;
 
-            jvalue& subschema = schema_property.second;
+            const jvalue& subschema = schema_property.second;
 
             ctx_ds.push_schema_path (property_name);
             if (validate_subschema(ctx_ds, subschema, instance, quit_on_first_error) == false)
@@ -563,10 +637,10 @@ namespace ujson::schema {
     // Applicator keywords for arrays
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_prefixItems (validation_context& ctx,
-                                                       jvalue& schema,
-                                                       jvalue& schema_value,
-                                                       jvalue& instance,
-                                                       const bool quit_on_first_error)
+                                                       const jvalue& schema,
+                                                       const jvalue& schema_value,
+                                                       const jvalue& instance,
+                                                       const bool quit_on_first_error) const
     {
         bool all_valid = true;
         size_t items_in_schema_array = schema_value.size ();
@@ -575,23 +649,21 @@ namespace ujson::schema {
 
         validation_context ctx_pi (ctx);
 
-        for (size_t i=0; i<items_to_test; ++i) {
-            jvalue& sub_schema = schema_value[i];
-            jvalue& sub_instance = instance[i];
-            auto index_str = std::to_string(i);
+        all_valid = validate_children (ctx_pi, items_to_test, quit_on_first_error,
+                                       [&] (validation_context& child_ctx, size_t i) {
+                const jvalue& sub_schema = schema_value[i];
+                const jvalue& sub_instance = instance[i];
+                auto index_str = std::to_string(i);
 
-            ctx_pi.push_schema_path (index_str);
-            ctx_pi.push_instance_path (index_str);
+                child_ctx.push_schema_path (index_str);
+                child_ctx.push_instance_path (index_str);
 
-            if (validate_subschema(ctx_pi, sub_schema, sub_instance, quit_on_first_error) == false)
-                all_valid = false;
+                bool valid = validate_subschema (child_ctx, sub_schema, sub_instance, quit_on_first_error);
 
-            ctx_pi.pop_schema_path ();
-            ctx_pi.pop_instance_path ();
-
-            if (quit_on_first_error && all_valid==false)
-                break;
-        }
+                child_ctx.pop_schema_path ();
+                child_ctx.pop_instance_path ();
+                return valid;
+            });
 
         ctx_pi.set_valid (all_valid);
         if (!all_valid) {
@@ -600,11 +672,11 @@ namespace ujson::schema {
         }
 
         if (items_to_test >= items_in_instance) {
-            ctx.annotate (jvalue(true));
-            ctx_pi.output_unit["annotation"] = true;
+            ctx.annotate (validation_context::ann_prefixItems, instance, jvalue(true));
+            ctx_pi.set_output_annotation (jvalue(true));
         }else{
-            ctx.annotate (jvalue((long int)items_to_test-1));
-            ctx_pi.output_unit["annotation"] = (long) (items_to_test-1);
+            ctx.annotate (validation_context::ann_prefixItems, instance, jvalue((long int)items_to_test-1));
+            ctx_pi.set_output_annotation (jvalue((long) (items_to_test-1)));
         }
 
         ctx.add_output_unit (std::move(ctx_pi.output_unit));
@@ -619,15 +691,15 @@ namespace ujson::schema {
     // Applicator keywords for arrays
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_items (validation_context& ctx,
-                                                 jvalue& schema,
-                                                 jvalue& schema_value,
-                                                 jvalue& instance,
-                                                 const bool quit_on_first_error)
+                                                 const jvalue& schema,
+                                                 const jvalue& schema_value,
+                                                 const jvalue& instance,
+                                                 const bool quit_on_first_error) const
     {
         bool all_valid = true;
 
         jvalue* annotation = nullptr;
-        annotation = ctx.annotation ("prefixItems", ctx.instance_path().str());
+        annotation = ctx.annotation (validation_context::ann_prefixItems, instance);
 
         size_t i = 0;
         if (annotation) {
@@ -638,19 +710,20 @@ namespace ujson::schema {
             ++i;
         }
         size_t num_items_in_instance = instance.size ();
-        bool schema_applied = false;
+        bool schema_applied = i < num_items_in_instance;
+        size_t first_item = i;
 
         validation_context ctx_items (ctx);
 
-        for (; i<num_items_in_instance; ++i) {
-            schema_applied = true;
-            ctx_items.push_instance_path (std::to_string(i));
-            if (validate_subschema(ctx_items, schema_value, instance[i], quit_on_first_error) == false)
-                all_valid = false;
-            ctx_items.pop_instance_path ();
-
-            if (quit_on_first_error && all_valid==false)
-                break;
+        if (schema_applied) {
+            all_valid = validate_children (ctx_items, num_items_in_instance-first_item, quit_on_first_error,
+                                           [&] (validation_context& child_ctx, size_t index) {
+                    size_t n = first_item + index;
+                    child_ctx.push_instance_path (std::to_string(n));
+                    bool valid = validate_subschema (child_ctx, schema_value, instance[n], quit_on_first_error);
+                    child_ctx.pop_instance_path ();
+                    return valid;
+                });
         }
 
         ctx_items.set_valid (all_valid);
@@ -660,8 +733,8 @@ namespace ujson::schema {
         }
 
         if (schema_applied) {
-            ctx.annotate (jvalue(true));
-            ctx_items.output_unit["annotation"] = true;
+            ctx.annotate (validation_context::ann_items, instance, jvalue(true));
+            ctx_items.set_output_annotation (jvalue(true));
         }
         ctx.add_output_unit (std::move(ctx_items.output_unit));
 
@@ -675,10 +748,10 @@ namespace ujson::schema {
     // Applicator keywords for arrays
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_contains (validation_context& ctx,
-                                                    jvalue& schema,
-                                                    jvalue& schema_value,
-                                                    jvalue& instance,
-                                                    const bool quit_on_first_error)
+                                                    const jvalue& schema,
+                                                    const jvalue& schema_value,
+                                                    const jvalue& instance,
+                                                    const bool quit_on_first_error) const
     {
         jvalue annotation_value (j_array);
         bool all_valid = true;
@@ -701,19 +774,27 @@ namespace ujson::schema {
                 all_valid = false;
                 some_valid = false;
             }else{
-                for (size_t i=0; i<items_in_instance; ++i) {
-                    ctx_contains.push_instance_path (std::to_string(i));
-                    validation_context sub_ctx (ctx_contains);
-
-                    if (validate_subschema(sub_ctx, schema_value, instance[i], quit_on_first_error, false, true)) {
+                std::vector<char> valid;
+                validate_children (ctx_contains, items_in_instance, false,
+                                   [&] (validation_context& child_ctx, size_t i) {
+                        child_ctx.push_instance_path (std::to_string(i));
+                        validation_context sub_ctx (child_ctx);
+
+                        bool item_valid = validate_subschema (sub_ctx, schema_value, instance[i],
+                                                              quit_on_first_error, false, true);
+
+                        child_ctx.add_output_unit (std::move(sub_ctx.output_unit));
+                        child_ctx.pop_instance_path ();
+                        return item_valid;
+                    }, &valid);
+
+                for (size_t i=0; i<valid.size(); ++i) {
+                    if (valid[i]) {
                         some_valid = true;
                         annotation_value.append ((int)i);
                     }else{
                         all_valid = false;
                     }
-
-                    ctx_contains.add_output_unit (std::move(sub_ctx.output_unit));
-                    ctx_contains.pop_instance_path ();
                 }
             }
         }
@@ -727,8 +808,8 @@ namespace ujson::schema {
             ctx.set_valid (false);
         }
 
-        ctx.annotate (annotation_value);
-        ctx_contains.output_unit["annotation"] = annotation_value;
+        ctx_contains.set_output_annotation (annotation_value);
+        ctx.annotate (validation_context::ann_contains, instance, std::move(annotation_value));
         ctx.add_output_unit (std::move(ctx_contains.output_unit));
 
         return some_valid || all_valid;
@@ -741,57 +822,59 @@ namespace ujson::schema {
     // Applicator keywords for objects
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_properties (validation_context& ctx,
-                                                      jvalue& schema,
-                                                      jvalue& schema_value,
-                                                      jvalue& instance,
-                                                      const bool quit_on_first_error)
+                                                      const jvalue& schema,
+                                                      const jvalue& schema_value,
+                                                      const jvalue& instance,
+                                                      const bool quit_on_first_error) const
     {
         bool all_valid = true;
-        std::string ctx_instance_path = ctx.instance_path().str ();
         jvalue annotation (j_array);
 
-        validation_context ctx_props (ctx);
-
+        // The properties of the schema that are present in the instance
+        struct property_t {
+            const std::string& name;
+            const jvalue& sub_schema;
+            const jvalue& sub_instance;
+        };
+        std::vector<property_t> properties;
         for (auto& property : schema_value.obj()) {
+            const std::string& property_name = property.first;
+            auto& sub_instance = instance.get (property_name);
+            if (sub_instance.valid())
+                properties.push_back (property_t{property_name, property.second, sub_instance});
+        }
 
-            if (quit_on_first_error && all_valid==false)
-                break;
+        validation_context ctx_props (ctx);
 
-            auto& property_name = property.first;
-            auto& sub_schema = property.second;
-            auto& sub_instance = instance.get (property_name);
-            if (sub_instance.invalid())
-                continue;
+        std::vector<char> valid;
+        all_valid = validate_children (ctx_props, properties.size(), quit_on_first_error,
+                                       [&] (validation_context& child_ctx, size_t i) {
+                auto& property = properties[i];
+                child_ctx.push_schema_path (property.name);
+                child_ctx.push_instance_path (property.name);
 
-            ctx_props.push_schema_path (property_name);
-            ctx_props.push_instance_path (property_name);
+                bool property_valid = validate_subschema (child_ctx, property.sub_schema,
+                                                          property.sub_instance, quit_on_first_error);
 
-            /*
-            if (validate_subschema(ctx_props, sub_schema, sub_instance, quit_on_first_error))
-                annotation.append (property_name);
-            else
-                all_valid = false;
-            */
-            if (!validate_subschema(ctx_props, sub_schema, sub_instance, quit_on_first_error))
-                all_valid = false;
-            annotation.append (property_name);
+                child_ctx.pop_schema_path ();
+                child_ctx.pop_instance_path ();
+                return property_valid;
+            }, &valid);
 
-            ctx_props.pop_schema_path ();
-            ctx_props.pop_instance_path ();
-        }
+        // All evaluated properties are annotated, valid or not
+        for (size_t i=0; i<valid.size(); ++i)
+            annotation.append (properties[i].name);
 
         ctx_props.set_valid (all_valid);
 
-        ctx.annotate (annotation);
-
         if (all_valid) {
             ctx.collect_annotations (ctx_props);
-            //ctx.annotate (annotation);
-            ctx_props.output_unit["annotation"] = annotation;
+            ctx_props.set_output_annotation (annotation);
         }else{
             ctx.set_valid (false);
             ctx_props.set_error ("Not all properties evaluated true.");
         }
+        ctx.annotate (validation_context::ann_properties, instance, std::move(annotation));
         ctx.add_output_unit (std::move(ctx_props.output_unit));
 
         return all_valid;
@@ -804,14 +887,13 @@ namespace ujson::schema {
     // Applicator keywords for objects
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_patternProperties (validation_context& ctx,
-                                                             jvalue& schema,
-                                                             jvalue& schema_value,
-                                                             jvalue& instance,
-                                                             const bool quit_on_first_error)
+                                                             const jvalue& schema,
+                                                             const jvalue& schema_value,
+                                                             const jvalue& instance,
+                                                             const bool quit_on_first_error) const
     {
         std::cmatch cm;
         bool all_valid = true;
-        std::string ctx_instance_path = ctx.instance_path().str ();
         jvalue annotation (j_array);
 
         validation_context ctx_props (ctx);
@@ -820,16 +902,16 @@ namespace ujson::schema {
             if (quit_on_first_error && all_valid==false)
                 break;
 
-            auto& property_pattern = schema_property.first;
+            const std::string& property_pattern = schema_property.first;
             auto& sub_schema = schema_property.second;
 
-            std::regex re (property_pattern, std::regex::ECMAScript);
+            auto re = compiled_regex (sub_schema, property_pattern);
 
             for (auto& instance_property : instance.obj()) {
                 if (quit_on_first_error && all_valid==false)
                     break;
-                auto& property_name = instance_property.first;
-                if (! std::regex_search(property_name.c_str(), cm, re))
+                const std::string& property_name = instance_property.first;
+                if (! std::regex_search(property_name.c_str(), cm, *re))
                     continue;
 
                 ctx_props.push_schema_path (property_pattern);
@@ -853,16 +935,14 @@ namespace ujson::schema {
 
         ctx_props.set_valid (all_valid);
 
-        ctx.annotate (annotation);
-
         if (all_valid) {
             ctx.collect_annotations (ctx_props);
-            //ctx.annotate (annotation);
-            ctx_props.output_unit["annotation"] = annotation;
+            ctx_props.set_output_annotation (annotation);
         }else{
             ctx.set_valid (false);
             ctx_props.set_error ("Not all properties evaluated true.");
         }
+        ctx.annotate (validation_context::ann_patternProperties, instance, std::move(annotation));
         ctx.add_output_unit (std::move(ctx_props.output_unit));
 
         return all_valid;
@@ -875,35 +955,27 @@ namespace ujson::schema {
     // Applicator keywords for objects
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_additionalProperties (validation_context& ctx,
-                                                                jvalue& schema,
-                                                                jvalue& schema_value,
-                                                                jvalue& instance,
-                                                                const bool quit_on_first_error)
+                                                                const jvalue& schema,
+                                                                const jvalue& schema_value,
+                                                                const jvalue& instance,
+                                                                const bool quit_on_first_error) const
     {
         bool all_valid = true;
-        std::string ctx_instance_path = ctx.instance_path().str ();
         jvalue annotation (j_array);
 
         bool all_checked = false;
         std::set<std::string> checked_props;
-        auto props_pos = ctx.annotations.find (std::make_pair("properties", ctx_instance_path));
-        if (props_pos != ctx.annotations.end()) {
-            if (props_pos->second.type() == j_bool) {
-                all_checked = true;
-            }
-            else if (props_pos->second.type() == j_array) {
-                for (auto item : props_pos->second.array()) {
-                    checked_props.emplace (item.str());
-                }
-            }
-        }
-        auto pprops_pos = ctx.annotations.find (std::make_pair("patternProperties", ctx_instance_path));
-        if (pprops_pos != ctx.annotations.end()) {
-            if (pprops_pos->second.type() == j_bool) {
+        for (auto keyword : {validation_context::ann_properties,
+                             validation_context::ann_patternProperties})
+        {
+            auto* props = ctx.annotation (keyword, instance);
+            if (props == nullptr)
+                continue;
+            if (props->type() == j_bool) {
                 all_checked = true;
             }
-            else if (pprops_pos->second.type() == j_array) {
-                for (auto item : pprops_pos->second.array()) {
+            else if (props->type() == j_array) {
+                for (auto& item : props->array()) {
                     checked_props.emplace (item.str());
                 }
             }
@@ -912,40 +984,38 @@ namespace ujson::schema {
         if (all_checked)
             return true;
 
-        validation_context ctx_props (ctx);
-        unsigned num_checked = 0;
-
+        // The instance properties not checked by "properties" or "patternProperties"
+        std::vector<std::pair<const std::string*, const jvalue*>> unchecked;
         for (auto& property : instance.obj()) {
+            const std::string& property_name = property.first;
+            if (checked_props.find(property_name) == checked_props.end())
+                unchecked.emplace_back (&property_name, &property.second);
+        }
+        if (unchecked.empty())
+            return true;
 
-            if (quit_on_first_error && all_valid==false)
-                break;
-
-            auto& property_name = property.first;
-            auto& sub_instance = property.second;
-
-            auto pos = checked_props.find (property_name);
-            if (pos != checked_props.end())
-                continue;
-
-            ++num_checked;
-            ctx_props.push_instance_path (property_name);
-
-            if (validate_subschema(ctx_props, schema_value, sub_instance, quit_on_first_error))
-                annotation.append (property_name);
-            else
-                all_valid = false;
+        validation_context ctx_props (ctx);
 
-            ctx_props.pop_instance_path ();
+        std::vector<char> valid;
+        all_valid = validate_children (ctx_props, unchecked.size(), quit_on_first_error,
+                                       [&] (validation_context& child_ctx, size_t i) {
+                child_ctx.push_instance_path (*unchecked[i].first);
+                bool property_valid = validate_subschema (child_ctx, schema_value,
+                                                          *unchecked[i].second, quit_on_first_error);
+                child_ctx.pop_instance_path ();
+                return property_valid;
+            }, &valid);
+
+        for (size_t i=0; i<valid.size(); ++i) {
+            if (valid[i])
+                annotation.append (*unchecked[i].first);
         }
 
-        if (num_checked == 0)
-            return true;
-
         ctx_props.set_valid (all_valid);
         if (all_valid) {
             ctx.collect_annotations (ctx_props);
-            ctx.annotate (annotation);
-            ctx_props.output_unit["annotation"] = annotation;
+            ctx_props.set_output_annotation (annotation);
+            ctx.annotate (validation_context::ann_additionalProperties, instance, std::move(annotation));
         }else{
             ctx.set_valid (false);
             ctx_props.set_error ("Not all properties evaluated true.");
@@ -962,10 +1032,10 @@ namespace ujson::schema {
     // Applicator keywords for objects
     //--------------------------------------------------------------------------
     bool jvocabulary_applicator::validate_propertyNames (validation_context& ctx,
-                                                         jvalue& schema,
-                                                         jvalue& schema_value,
-                                                         jvalue& instance,
-                                                         const bool quit_on_first_error)
+                                                         const jvalue& schema,
+                                                         const jvalue& schema_value,
+                                                         const jvalue& instance,
+                                                         const bool quit_on_first_error) const
     {
         bool all_valid = true;
 
@@ -976,7 +1046,7 @@ namespace ujson::schema {
             if (quit_on_first_error && all_valid==false)
                 break;
 
-            auto& property_name = entry.first;
+            const std::string& property_name = entry.first;
             jvalue name_instance (property_name);
 
             ctx_props.push_instance_path (property_name);
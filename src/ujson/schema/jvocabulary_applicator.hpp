@@ -21,6 +21,8 @@
 
 #include <ujson/schema/jvocabulary.hpp>
 #include <string>
+#include <vector>
+#include <unordered_map>
 
 
 namespace ujson::schema {
@@ -35,9 +37,9 @@ namespace ujson::schema {
 
         virtual void load (jvalue& schema, jvalue& load_ctx);
         virtual bool validate (validation_context& ctx,
-                               jvalue& schema,
-                               jvalue& instance,
-                               const bool quit_on_first_error);
+                               const jvalue& schema,
+                               const jvalue& instance,
+                               const bool quit_on_first_error) const;
 
 
     private:
@@ -45,56 +47,78 @@ namespace ujson::schema {
         void load_anyOf (jvalue& schema_value, jvalue& load_ctx);
         void load_oneOf (jvalue& schema_value, jvalue& load_ctx);
         void load_prefixItems (jvalue& schema_value, jvalue& load_ctx);
+        void load_patternProperties (jvalue& schema_value, jvalue& load_ctx);
 
         // 10.2. Keywords for Applying Subschemas in Place
         //     Applicator keywords for any instance
-        bool validate_allOf (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                             jvalue& instance, const bool quit_on_first_error);
-        bool validate_anyOf (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                             jvalue& instance, const bool quit_on_first_error);
-        bool validate_oneOf (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                             jvalue& instance, const bool quit_on_first_error);
-        bool validate_not (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                           jvalue& instance, const bool quit_on_first_error);
-        bool validate_if (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                          jvalue& instance, const bool quit_on_first_error);
-        bool validate_then (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                            jvalue& instance, const bool quit_on_first_error);
-        bool validate_else (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                            jvalue& instance, const bool quit_on_first_error);
+        bool validate_allOf (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                             const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_anyOf (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                             const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_oneOf (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                             const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_not (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                           const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_if (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                          const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_then (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                            const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_else (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                            const jvalue& instance, const bool quit_on_first_error) const;
 
         //     Applicator keywords for objects
-        bool validate_dependentSchemas (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                        jvalue& instance, const bool quit_on_first_error);
+        bool validate_dependentSchemas (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                        const jvalue& instance, const bool quit_on_first_error) const;
 
         //
         // 10.3. Keywords for Applying Subschemas to Child Instances
         //     Applicator keywords for arrays
-        bool validate_prefixItems (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                   jvalue& instance, const bool quit_on_first_error);
-        bool validate_items (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                             jvalue& instance, const bool quit_on_first_error);
-        bool validate_contains (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                jvalue& instance, const bool quit_on_first_error);
+        bool validate_prefixItems (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                   const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_items (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                             const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_contains (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                const jvalue& instance, const bool quit_on_first_error) const;
 
         //     Applicator keywords for objects
-        bool validate_properties (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                  jvalue& instance, const bool quit_on_first_error);
-        bool validate_patternProperties (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                         jvalue& instance, const bool quit_on_first_error);
-        bool validate_additionalProperties (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                            jvalue& instance, const bool quit_on_first_error);
-        bool validate_propertyNames (validation_context& ctx, jvalue& schema, jvalue& schema_value,
-                                     jvalue& instance, const bool quit_on_first_error);
+        bool validate_properties (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                  const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_patternProperties (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                         const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_additionalProperties (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                            const jvalue& instance, const bool quit_on_first_error) const;
+        bool validate_propertyNames (validation_context& ctx, const jvalue& schema, const jvalue& schema_value,
+                                     const jvalue& instance, const bool quit_on_first_error) const;
 
         using kw_loader_t = void (jvocabulary_applicator::*) (jvalue&, jvalue&);
         using kw_validator_t = bool (jvocabulary_applicator::*) (validation_context&,
-                                                                 jvalue&,
-                                                                 jvalue&,
-                                                                 jvalue&,
-                                                                 const bool);
+                                                                 const jvalue&,
+                                                                 const jvalue&,
+                                                                 const jvalue&,
+                                                                 const bool) const;
         using keywords_t = std::map<std::string, std::tuple<jvalue_type, kw_loader_t, jvalue_type, kw_validator_t>>;
         static const keywords_t keywords;
+
+        // A keyword of a loaded schema and its validator.
+        // Keyword 'if' has no validator.
+        struct compiled_keyword_t {
+            const std::string* keyword;
+            const jvalue* value;
+            jvalue_type instance_type;
+            kw_validator_t validator;
+        };
+        struct compiled_schema_t {
+            std::vector<compiled_keyword_t> keywords; // In schema order
+            const jvalue* kw_then {nullptr};
+            const jvalue* kw_else {nullptr};
+            const jvalue* kw_items {nullptr};
+            const jvalue* kw_additionalProperties {nullptr};
+        };
+
+        static void compile (const jvalue& schema, compiled_schema_t& compiled);
+
+        // The keywords of each loaded (sub)schema
+        std::unordered_map<const jvalue*, compiled_schema_t> compiled_schemas;
     };
 
 
@@ -43,6 +43,10 @@ namespace ujson::schema {
 #define get_tuple_schema(tuple) std::get<2>(tuple).get()
 
 
+    // Valid values of '$anchor' and '$dynamicAnchor'
+    static const std::regex anchor_regex ("^[A-Za-z_][-A-Za-z0-9._]*$", std::regex::ECMAScript);
+
+
 
     const jvocabulary_core::keyword_loaders_t jvocabulary_core::keyword_loaders = {{
             // Any instance type
@@ -131,38 +135,65 @@ namespace ujson::schema {
                 (this->*keyword_loader) (schema, schema_value, load_ctx);
             }
         }
+
+        compile (schema, compiled_schemas[&schema]);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvocabulary_core::compile (const jvalue& schema, compiled_schema_t& compiled)
+    {
+        auto& id_value = schema.get ("$id");
+        auto& ref_value = schema.get ("$ref");
+        auto& dynref_value = schema.get ("$dynamicRef");
+        compiled.kw_id = id_value.valid() ? &id_value : nullptr;
+        compiled.kw_ref = ref_value.valid() ? &ref_value : nullptr;
+        compiled.kw_dynamicRef = dynref_value.valid() ? &dynref_value : nullptr;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvocabulary_core::validate (validation_context& ctx,
-                                     jvalue& schema,
-                                     jvalue& instance,
-                                     const bool quit_on_first_error)
+                                     const jvalue& schema,
+                                     const jvalue& instance,
+                                     const bool quit_on_first_error) const
     {
         bool is_valid = true;
 
-        auto& id_value = schema.get ("$id");
-        if (id_value.valid()) {
-            validate_id (ctx, id_value, instance);
+        // Schemas that weren't loaded, like a '$ref' to a location
+        // that is not a subschema, are compiled when validated.
+        compiled_schema_t compiled;
+        auto entry = compiled_schemas.find (&schema);
+        if (entry != compiled_schemas.end())
+            compiled = entry->second;
+        else
+            compile (schema, compiled);
+
+        if (compiled.kw_id) {
+            validate_id (ctx, *compiled.kw_id, instance);
         }else{
             if (ctx.base_uri.empty())
                 ctx.base_uri = jschema::default_base_uri;
         }
 
-        auto& ref_value = schema.get ("$ref");
-        if (ref_value.valid()) {
+        if (compiled.kw_ref) {
             ctx.push_schema_path ("$ref");
-            if (!validate_ref (ctx, schema, ref_value, instance, quit_on_first_error))
+            validation_profile::timer prof (ctx);
+            bool kw_valid = validate_ref (ctx, schema, *compiled.kw_ref, instance, quit_on_first_error);
+            prof.stop (kw_valid);
+            if (!kw_valid)
                 is_valid = false;
             ctx.pop_schema_path ();
         }
 
-        auto& dynref_value = schema.get ("$dynamicRef");
-        if (dynref_value.valid()) {
+        if (compiled.kw_dynamicRef) {
             ctx.push_schema_path ("$dynamicRef");
-            if (!validate_dynamicRef (ctx, schema, dynref_value, instance, quit_on_first_error))
+            validation_profile::timer prof (ctx);
+            bool kw_valid = validate_dynamicRef (ctx, schema, *compiled.kw_dynamicRef, instance, quit_on_first_error);
+            prof.stop (kw_valid);
+            if (!kw_valid)
                 is_valid = false;
             ctx.pop_schema_path ();
         }
@@ -182,20 +213,21 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    bool jvocabulary_core::validate_id (validation_context& ctx, jvalue& schema_value, jvalue& instance)
+    bool jvocabulary_core::validate_id (validation_context& ctx, const jvalue& schema_value, const jvalue& instance) const
     {
         ctx.push_schema_path ("$id");
 
         std::string uri_error;
+        const std::string id (schema_value.str_view());
         if (ctx.base_uri.empty()) {
-            ctx.base_uri = resolve_id ("", schema_value.str(), uri_error);
+            ctx.base_uri = resolve_id ("", id, uri_error);
         }else{
             if (ctx.parent) {
                 std::string& base_uri = ctx.parent->base_uri;
-                ctx.base_uri = resolve_id (base_uri, schema_value.str(), uri_error);
+                ctx.base_uri = resolve_id (base_uri, id, uri_error);
             }else{
                 std::string& base_uri = ctx.base_uri;
-                ctx.base_uri = resolve_id (base_uri, schema_value.str(), uri_error);
+                ctx.base_uri = resolve_id (base_uri, id, uri_error);
             }
         }
         ctx.abs_keyword_path.clear (); // New abs_keyword_path relative to the new $id
@@ -207,9 +239,45 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue* jvocabulary_core::resolve_ref (validation_context& ctx,
-                                           jvalue& schema,
-                                           std::string& ref)
+    void jvocabulary_core::clear_ref_cache ()
+    {
+        std::lock_guard<std::mutex> lock (ref_cache_mutex);
+        ref_cache.clear ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Resolve a reference, and remember the result. The target
+    // of a reference only depends on the current base URI.
+    //--------------------------------------------------------------------------
+    const jvalue* jvocabulary_core::resolve_ref (validation_context& ctx,
+                                                 const jvalue& schema,
+                                                 const std::string& ref) const
+    {
+        std::lock_guard<std::mutex> lock (ref_cache_mutex);
+        auto& cache = ref_cache[ctx.base_uri];
+        auto entry = cache.find (ref);
+        if (entry != cache.end()) {
+            ctx.base_uri = entry->second.base_uri;
+            ctx.abs_keyword_path = entry->second.abs_keyword_path;
+            return entry->second.schema;
+        }
+
+        auto* target = find_ref_target (ctx, schema, ref);
+        if (target) {
+            // Failures are not cached, an invalid reference
+            // callback may add the missing schema.
+            cache.emplace (ref, ref_target_t{target, ctx.base_uri, ctx.abs_keyword_path});
+        }
+        return target;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jvalue* jvocabulary_core::find_ref_target (validation_context& ctx,
+                                                     const jvalue& schema,
+                                                     const std::string& ref) const
     {
         try {
             std::string err_msg;
@@ -252,7 +320,8 @@ namespace ujson::schema {
             if (id_entry == ids.end())
                 return nullptr;
 
-            auto& subschema = find_jvalue (id_entry->second.get(), fragment);
+            const jvalue& id_schema = id_entry->second.get ();
+            auto& subschema = find_jvalue (id_schema, fragment);
             if (subschema.invalid())
                 return nullptr;
 
@@ -262,11 +331,11 @@ namespace ujson::schema {
             size_t tmp_ptr_size = tmp_ptr.size ();
             if (tmp_ptr_size > 1) {
                 while (tmp_ptr_size--) {
-                    auto& jval = find_jvalue (id_entry->second.get(), tmp_ptr);
+                    auto& jval = find_jvalue (id_schema, tmp_ptr);
                     if (jval.type() == j_object) {
                         auto& id = jval.get ("$id");
                         if (id.type() == j_string) {
-                            ctx.base_uri = resolve_id (uri_without_fragment, id.str(), err_msg);
+                            ctx.base_uri = resolve_id (uri_without_fragment, std::string(id.str_view()), err_msg);
                             ctx.abs_keyword_path = result_ptr;
                             return &subschema;
                         }
@@ -290,11 +359,12 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    bool jvocabulary_core::validate_ref (validation_context& ctx, jvalue& schema,
-                                         jvalue& schema_value, jvalue& instance,
-                                         const bool quit_on_first_error)
+    bool jvocabulary_core::validate_ref (validation_context& ctx, const jvalue& schema,
+                                         const jvalue& schema_value, const jvalue& instance,
+                                         const bool quit_on_first_error) const
     {
-        jvalue* target_schema = nullptr;
+        const jvalue* target_schema = nullptr;
+        const std::string ref (schema_value.type()==j_string ? schema_value.str_view() : "");
         bool new_ref_schema_loaded = false;
         bool valid = true;
 
@@ -304,7 +374,7 @@ namespace ujson::schema {
             if (schema_value.type() == j_string)
                 target_schema = resolve_ref (sub_ctx,
                                              schema,
-                                             schema_value.str());
+                                             ref);
             if (target_schema) {
                 new_ref_schema_loaded = false;
 
@@ -320,7 +390,7 @@ namespace ujson::schema {
                 if (invalid_ref_cb && !new_ref_schema_loaded) {
                     new_ref_schema_loaded = invalid_ref_cb (root_schema,
                                                             ctx.base_uri,
-                                                            schema_value.str());
+                                                            ref);
                     if (!new_ref_schema_loaded) {
                         sub_ctx.set_error ("Invalid reference");
                         ctx.set_valid (false);
@@ -340,11 +410,11 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue* jvocabulary_core::resolve_dynref (validation_context& ctx,
-                                              jvalue& schema,
-                                              std::string& dynref)
+    const jvalue* jvocabulary_core::resolve_dynref (validation_context& ctx,
+                                                    const jvalue& schema,
+                                                    const std::string& dynref) const
     {
-        jvalue* retval = nullptr;
+        const jvalue* retval = nullptr;
         std::string err_msg;
 
         std::string uri = resolve_id (ctx.base_uri, dynref, err_msg, true);
@@ -380,11 +450,12 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    bool jvocabulary_core::validate_dynamicRef (validation_context& ctx, jvalue& schema,
-                                                jvalue& schema_value, jvalue& instance,
-                                                const bool quit_on_first_error)
+    bool jvocabulary_core::validate_dynamicRef (validation_context& ctx, const jvalue& schema,
+                                                const jvalue& schema_value, const jvalue& instance,
+                                                const bool quit_on_first_error) const
     {
-        jvalue* target_schema = nullptr;
+        const jvalue* target_schema = nullptr;
+        const std::string dynref (schema_value.type()==j_string ? schema_value.str_view() : "");
         validation_context sub_ctx (ctx);
         bool new_ref_schema_loaded = false;
         bool valid = true;
@@ -393,7 +464,7 @@ namespace ujson::schema {
             if (schema_value.type() == j_string)
                 target_schema = resolve_dynref (sub_ctx,
                                                 schema,
-                                                schema_value.str());
+                                                dynref);
             if (target_schema) {
                 /*
                   if (target_schema == &schema) {
@@ -409,7 +480,7 @@ namespace ujson::schema {
                 if (invalid_ref_cb && !new_ref_schema_loaded) {
                     new_ref_schema_loaded = invalid_ref_cb (root_schema,
                                                             ctx.base_uri,
-                                                            schema_value.str());
+                                                            dynref);
                     if (!new_ref_schema_loaded) {
                         sub_ctx.set_error ("Invalid reference");
                         ctx.set_valid (false);
@@ -430,8 +501,8 @@ namespace ujson::schema {
 /*
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    bool jvocabulary_core::validate_comment (validation_context& ctx, jvalue& schema,
-                                             jvalue& schema_value, jvalue& instance)
+    bool jvocabulary_core::validate_comment (validation_context& ctx, const jvalue& schema,
+                                             const jvalue& schema_value, const jvalue& instance) const
     {
         validation_context sub_ctx (ctx);
         sub_ctx.output_unit["annotation"] = schema_value;
@@ -506,9 +577,8 @@ namespace ujson::schema {
     {
         push_load_ctx_path (load_ctx, "$anchor");
 
-        std::regex re ("^[A-Za-z_][-A-Za-z0-9._]*$", std::regex::ECMAScript);
         std::cmatch cm;
-        if (!std::regex_match (schema_value.str().c_str(), cm, re))
+        if (!std::regex_match (schema_value.str().c_str(), cm, anchor_regex))
             throw invalid_schema ("Invalid '$anchor' value.");
 
         std::string abs_path;
@@ -545,9 +615,8 @@ namespace ujson::schema {
     {
         push_load_ctx_path (load_ctx, "$dynamicAnchor");
 
-        std::regex re ("^[A-Za-z_][-A-Za-z0-9._]*$", std::regex::ECMAScript);
         std::cmatch cm;
-        if (!std::regex_match (schema_value.str().c_str(), cm, re))
+        if (!std::regex_match (schema_value.str().c_str(), cm, anchor_regex))
             throw invalid_schema ("Invalid '$dynamicAnchor' value.");
 
         std::string abs_path;
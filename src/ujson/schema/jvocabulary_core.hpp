@@ -22,9 +22,11 @@
 #include <ujson/schema/jvocabulary.hpp>
 #include <functional>
 #include <ostream>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <map>
+#include <unordered_map>
 
 
 namespace ujson::schema {
@@ -49,11 +51,17 @@ namespace ujson::schema {
 
         virtual void load (jvalue& schema, jvalue& load_ctx);
         virtual bool validate (validation_context& ctx,
-                               jvalue& schema,
-                               jvalue& instance,
-                               const bool quit_on_first_error);
+                               const jvalue& schema,
+                               const jvalue& instance,
+                               const bool quit_on_first_error) const;
 
         void set_invalid_ref_cb (invalid_ref_cb_t cb);
+
+        /**
+         * Forget all resolved "$ref" and "$dynamicRef" values.
+         * Called when a schema definition is added.
+         */
+        void clear_ref_cache ();
         void print_maps (std::ostream& out);
 
 
@@ -65,30 +73,50 @@ namespace ujson::schema {
         void load_dynamicAnchor (jvalue& schema, jvalue& schema_value, jvalue& load_ctx);
         //void load_comment (jvalue& schema, jvalue& schema_value, jvalue& load_ctx);
 
-        bool validate_id (validation_context& ctx, jvalue& schema_value, jvalue& instance);
+        bool validate_id (validation_context& ctx, const jvalue& schema_value, const jvalue& instance) const;
         bool validate_ref (validation_context& ctx,
-                           jvalue& schema,
-                           jvalue& schema_value,
-                           jvalue& instance,
-                           const bool quit_on_first_error);
+                           const jvalue& schema,
+                           const jvalue& schema_value,
+                           const jvalue& instance,
+                           const bool quit_on_first_error) const;
         bool validate_dynamicRef (validation_context& ctx,
-                                  jvalue& schema,
-                                  jvalue& schema_value,
-                                  jvalue& instance,
-                                  const bool quit_on_first_error);
+                                  const jvalue& schema,
+                                  const jvalue& schema_value,
+                                  const jvalue& instance,
+                                  const bool quit_on_first_error) const;
         //bool validate_comment (validation_context& ctx, jvalue& schema, jvalue& schema_value, jvalue& instance);
 
-        jvalue* resolve_ref (validation_context& ctx, jvalue& schema, std::string& ref);
-        jvalue* resolve_dynref (validation_context& ctx, jvalue& schema, std::string& dynref);
+        const jvalue* resolve_ref (validation_context& ctx, const jvalue& schema, const std::string& ref) const;
+        const jvalue* find_ref_target (validation_context& ctx, const jvalue& schema, const std::string& ref) const;
+        const jvalue* resolve_dynref (validation_context& ctx, const jvalue& schema, const std::string& dynref) const;
 
         using ids_t = std::map<std::string, std::reference_wrapper<jvalue>>;
-        using ids_iter_t = ids_t::iterator;
+        using ids_iter_t = ids_t::const_iterator;
         ids_t ids;
         std::map<std::string, std::tuple<std::string, std::string, std::reference_wrapper<jvalue>>> anchors;
         std::map<std::string, std::tuple<std::string, std::string, std::reference_wrapper<jvalue>>> dyn_anchors;
 
         invalid_ref_cb_t invalid_ref_cb;
 
+        // A resolved reference
+        struct ref_target_t {
+            const jvalue* schema;
+            std::string base_uri;
+            jpointer abs_keyword_path;
+        };
+        //       base_uri              ref
+        mutable std::map<std::string, std::map<std::string, ref_target_t>> ref_cache;
+        mutable std::mutex ref_cache_mutex;
+
+        // The core keywords used when validating a loaded (sub)schema
+        struct compiled_schema_t {
+            const jvalue* kw_id {nullptr};
+            const jvalue* kw_ref {nullptr};
+            const jvalue* kw_dynamicRef {nullptr};
+        };
+        static void compile (const jvalue& schema, compiled_schema_t& compiled);
+        std::unordered_map<const jvalue*, compiled_schema_t> compiled_schemas;
+
 
         using keyword_loader_t = void (jvocabulary_core::*) (jvalue&, jvalue&, jvalue&);
         using keyword_loaders_t = std::map<std::string, keyword_loader_t>;
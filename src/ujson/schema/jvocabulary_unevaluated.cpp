@@ -70,24 +70,27 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvocabulary_unevaluated::validate (validation_context& ctx,
-                                            jvalue& schema,
-                                            jvalue& instance,
-                                            const bool quit_on_first_error)
+                                            const jvalue& schema,
+                                            const jvalue& instance,
+                                            const bool quit_on_first_error) const
     {
         bool valid = true;
         if (instance.type() == j_array) {
             auto& schema_value = schema.get ("unevaluatedItems");
             if (schema_value.valid()) {
                 ctx.push_schema_path ("unevaluatedItems");
+                validation_profile::timer prof (ctx);
                 auto indexes = collect_unevaluatedItems_annotations (ctx, instance);
+                bool kw_valid = true;
                 if (indexes.empty() == false) {
-                    if (validate_unevaluatedItems (ctx, indexes, schema, schema_value,
-                                                   instance, quit_on_first_error) == false)
-                    {
+                    kw_valid = validate_unevaluatedItems (ctx, indexes, schema, schema_value,
+                                                          instance, quit_on_first_error);
+                    if (kw_valid == false) {
                         ctx.set_valid (false);
                         valid = false;
                     }
                 }
+                prof.stop (kw_valid);
                 ctx.pop_schema_path ();
             }
         }
@@ -95,9 +98,11 @@ namespace ujson::schema {
             auto& schema_value = schema.get ("unevaluatedProperties");
             if (schema_value.valid()) {
                 ctx.push_schema_path ("unevaluatedProperties");
-                if (validate_unevaluatedProperties (ctx, schema, schema_value, instance,
-                                                    quit_on_first_error) == false)
-                {
+                validation_profile::timer prof (ctx);
+                bool kw_valid = validate_unevaluatedProperties (ctx, schema, schema_value, instance,
+                                                                quit_on_first_error);
+                prof.stop (kw_valid);
+                if (kw_valid == false) {
                     ctx.set_valid (false);
                     valid = false;
                 }
@@ -111,16 +116,19 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue jvocabulary_unevaluated::get_unevaluatedItems_annotation (validation_context& ctx,
-                                                                     const std::string& instance_path)
+                                                                     const jvalue& instance) const
     {
-        jvalue* a = ctx.annotation ("unevaluatedItems", instance_path);
+        jvalue* a = ctx.annotation (validation_context::ann_unevaluatedItems, instance);
         if (a && a->is_boolean())
             return jvalue (true);
 
-        for (auto& annotations : ctx.in_place_annotations) {
-            auto entry = annotations.find (std::make_pair("unevaluatedItems", instance_path));
-            if (entry != annotations.end()  &&  entry->second.is_boolean())
+        for (auto& entry : ctx.in_place_annotations) {
+            if (entry.keyword == validation_context::ann_unevaluatedItems  &&
+                entry.instance == &instance  &&
+                entry.value.is_boolean())
+            {
                 return jvalue (true);
+            }
         }
         return jvalue (j_invalid);
     }
@@ -129,12 +137,12 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue jvocabulary_unevaluated::get_prefixItems_annotation (validation_context& ctx,
-                                                                const std::string& instance_path)
+                                                                const jvalue& instance) const
     {
         size_t max_index = (ssize_t)-1;
         bool have_max_index = false;
 
-        jvalue* a = ctx.annotation ("prefixItems", instance_path);
+        jvalue* a = ctx.annotation (validation_context::ann_prefixItems, instance);
         if (a) {
             if (a->is_boolean())
                 return jvalue (true);
@@ -142,17 +150,16 @@ namespace ujson::schema {
             have_max_index = true;
         }
 
-        for (auto& annotations : ctx.in_place_annotations) {
-            auto entry = annotations.find (std::make_pair("prefixItems", instance_path));
-            if (entry != annotations.end()) {
-                if (entry->second.is_boolean()) {
+        for (auto& entry : ctx.in_place_annotations) {
+            if (entry.keyword == validation_context::ann_prefixItems  &&  entry.instance == &instance) {
+                if (entry.value.is_boolean()) {
                     return jvalue (true);
                 }
                 if (have_max_index) {
-                    if (entry->second.num() > max_index)
-                        max_index = entry->second.num();
+                    if (entry.value.num() > max_index)
+                        max_index = entry.value.num();
                 }else{
-                    max_index = entry->second.num();
+                    max_index = entry.value.num();
                 }
                 have_max_index = true;
             }
@@ -165,16 +172,19 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue jvocabulary_unevaluated::get_items_annotation (validation_context& ctx,
-                                                          const std::string& instance_path)
+                                                          const jvalue& instance) const
     {
-        jvalue* a = ctx.annotation ("items", instance_path);
+        jvalue* a = ctx.annotation (validation_context::ann_items, instance);
         if (a && a->is_boolean())
             return jvalue (true);
 
-        for (auto& annotations : ctx.in_place_annotations) {
-            auto entry = annotations.find (std::make_pair("items", instance_path));
-            if (entry != annotations.end()  &&  entry->second.is_boolean())
+        for (auto& entry : ctx.in_place_annotations) {
+            if (entry.keyword == validation_context::ann_items  &&
+                entry.instance == &instance  &&
+                entry.value.is_boolean())
+            {
                 return jvalue (true);
+            }
         }
 
         return jvalue (j_invalid);
@@ -184,11 +194,11 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvalue jvocabulary_unevaluated::get_contains_annotation (validation_context& ctx,
-                                                             const std::string& instance_path)
+                                                             const jvalue& instance) const
     {
         std::set<size_t> indexes;
 
-        jvalue* a = ctx.annotation ("contains", instance_path);
+        jvalue* a = ctx.annotation (validation_context::ann_contains, instance);
         if (a) {
             if (a->is_boolean()) {
                 return jvalue (true);
@@ -199,13 +209,12 @@ namespace ujson::schema {
         }
 
 
-        for (auto& annotations : ctx.in_place_annotations) {
-            auto entry = annotations.find (std::make_pair("contains", instance_path));
-            if (entry != annotations.end()) {
-                if (entry->second.is_boolean()) {
+        for (auto& entry : ctx.in_place_annotations) {
+            if (entry.keyword == validation_context::ann_contains  &&  entry.instance == &instance) {
+                if (entry.value.is_boolean()) {
                     return jvalue (true);
                 }else{
-                    for (auto& val : entry->second.array())
+                    for (auto& val : entry.value.array())
                         indexes.emplace ((size_t)val.num());
                 }
             }
@@ -221,20 +230,19 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     std::set<size_t> jvocabulary_unevaluated::collect_unevaluatedItems_annotations (
-            validation_context& ctx, jvalue& instance)
+            validation_context& ctx, const jvalue& instance) const
     {
         std::set<size_t> indexes;
-        std::string instance_path = ctx.instance_path().str ();
         size_t max_index = (ssize_t)-1;
 
         // Check annotation result of "unevaluatedItems"
         //
-        if (get_unevaluatedItems_annotation(ctx, instance_path).is_boolean())
+        if (get_unevaluatedItems_annotation(ctx, instance).is_boolean())
             return indexes;
 
         // Check annotation result of "prefixItems"
         //
-        auto prefixItems = get_prefixItems_annotation (ctx, instance_path);
+        auto prefixItems = get_prefixItems_annotation (ctx, instance);
         if (prefixItems.valid()) {
             if (prefixItems.is_boolean())
                 return indexes;
@@ -244,12 +252,12 @@ namespace ujson::schema {
 
         // Check annotation result of "items"
         //
-        if (get_items_annotation(ctx, instance_path).is_boolean())
+        if (get_items_annotation(ctx, instance).is_boolean())
             return indexes;
 
         // Check annotation result of "contains"
         //
-        auto contains = get_contains_annotation (ctx, instance_path);
+        auto contains = get_contains_annotation (ctx, instance);
         if (contains.is_boolean())
             return indexes;
 
@@ -271,10 +279,10 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     bool jvocabulary_unevaluated::validate_unevaluatedItems (validation_context& ctx,
                                                              std::set<size_t>& indexes,
-                                                             jvalue& schema,
-                                                             jvalue& schema_value,
-                                                             jvalue& instance,
-                                                             const bool quit_on_first_error)
+                                                             const jvalue& schema,
+                                                             const jvalue& schema_value,
+                                                             const jvalue& instance,
+                                                             const bool quit_on_first_error) const
     {
         validation_context sub_ctx (ctx);
 
@@ -292,12 +300,12 @@ namespace ujson::schema {
         sub_ctx.set_valid (all_valid);
         if (all_valid) {
             ctx.collect_annotations (sub_ctx);
-            sub_ctx.output_unit["annotation"] = true;
+            sub_ctx.set_output_annotation (jvalue(true));
         }else{
             ctx.set_valid (false);
         }
 
-        ctx.annotate (jvalue(true));
+        ctx.annotate (validation_context::ann_unevaluatedItems, instance, jvalue(true));
         ctx.add_output_unit (std::move(sub_ctx.output_unit));
 
         return all_valid;
@@ -307,20 +315,19 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     void jvocabulary_unevaluated::get_properties_annotations (validation_context& ctx,
-                                                              const std::string& instance_path,
-                                                              const std::string& keyword,
-                                                              std::set<std::string>& names)
+                                                              const jvalue& instance,
+                                                              validation_context::annotation_keyword_t keyword,
+                                                              std::set<std::string>& names) const
     {
-        jvalue* a = ctx.annotation (keyword, instance_path);
+        jvalue* a = ctx.annotation (keyword, instance);
         if (a) {
             for (auto& name : a->array())
                 names.emplace (name.str());
         }
 
-        for (auto& annotations : ctx.in_place_annotations) {
-            auto entry = annotations.find (std::make_pair(keyword, instance_path));
-            if (entry != annotations.end()) {
-                for (auto& name : entry->second.array())
+        for (auto& entry : ctx.in_place_annotations) {
+            if (entry.keyword == keyword  &&  entry.instance == &instance) {
+                for (auto& name : entry.value.array())
                     names.emplace (name.str());
             }
         }
@@ -330,15 +337,14 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     std::set<std::string> jvocabulary_unevaluated::collect_unevaluatedProperties_annotations (
-            validation_context& ctx)
+            validation_context& ctx, const jvalue& instance) const
     {
         std::set<std::string> names;
-        std::string instance_path = ctx.instance_path().str ();
 
-        get_properties_annotations (ctx, instance_path, "properties", names);
-        get_properties_annotations (ctx, instance_path, "patternProperties", names);
-        get_properties_annotations (ctx, instance_path, "additionalProperties", names);
-        get_properties_annotations (ctx, instance_path, "unevaluatedProperties", names);
+        get_properties_annotations (ctx, instance, validation_context::ann_properties, names);
+        get_properties_annotations (ctx, instance, validation_context::ann_patternProperties, names);
+        get_properties_annotations (ctx, instance, validation_context::ann_additionalProperties, names);
+        get_properties_annotations (ctx, instance, validation_context::ann_unevaluatedProperties, names);
 
         return names;
     }
@@ -347,19 +353,18 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvocabulary_unevaluated::validate_unevaluatedProperties (validation_context& ctx,
-                                                                  jvalue& schema,
-                                                                  jvalue& schema_value,
-                                                                  jvalue& instance,
-                                                                  const bool quit_on_first_error)
+                                                                  const jvalue& schema,
+                                                                  const jvalue& schema_value,
+                                                                  const jvalue& instance,
+                                                                  const bool quit_on_first_error) const
     {
         if (instance.obj().empty())
             return true;
 
         bool none_evaluated = true;
         bool all_valid = true;
-        auto evaluated_names = collect_unevaluatedProperties_annotations (ctx);
+        auto evaluated_names = collect_unevaluatedProperties_annotations (ctx, instance);
 
-        std::string ctx_instance_path = ctx.instance_path().str ();
         jvalue annotation (j_array);
         validation_context sub_ctx (ctx);
 
@@ -368,7 +373,7 @@ namespace ujson::schema {
             if (quit_on_first_error && all_valid==false)
                 break;
 
-            auto& property_name = property.first;
+            const std::string& property_name = property.first;
             auto& sub_instance = property.second;
 
             // Skip property names already evaluated
@@ -390,8 +395,8 @@ namespace ujson::schema {
 
         sub_ctx.set_valid (all_valid);
         if (all_valid) {
-            sub_ctx.output_unit["annotation"] = annotation;
-            ctx.annotate (annotation);
+            sub_ctx.set_output_annotation (annotation);
+            ctx.annotate (validation_context::ann_unevaluatedProperties, instance, std::move(annotation));
             ctx.collect_annotations (sub_ctx);
         }else{
             ctx.set_valid (false);
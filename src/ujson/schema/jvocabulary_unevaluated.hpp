@@ -36,46 +36,47 @@ namespace ujson::schema {
 
         virtual void load (jvalue& schema, jvalue& load_ctx);
         virtual bool validate (validation_context& ctx,
-                               jvalue& schema,
-                               jvalue& instance,
-                               const bool quit_on_first_error);
+                               const jvalue& schema,
+                               const jvalue& instance,
+                               const bool quit_on_first_error) const;
 
 
     private:
         bool validate_unevaluatedItems (validation_context& ctx,
                                         std::set<size_t>& indexes,
-                                        jvalue& schema,
-                                        jvalue& schema_value,
-                                        jvalue& instance,
-                                        const bool quit_on_first_error);
+                                        const jvalue& schema,
+                                        const jvalue& schema_value,
+                                        const jvalue& instance,
+                                        const bool quit_on_first_error) const;
         bool validate_unevaluatedProperties (validation_context& ctx,
-                                             jvalue& schema,
-                                             jvalue& schema_value,
-                                             jvalue& instance,
-                                             const bool quit_on_first_error);
+                                             const jvalue& schema,
+                                             const jvalue& schema_value,
+                                             const jvalue& instance,
+                                             const bool quit_on_first_error) const;
 
 
 
 
         jvalue get_unevaluatedItems_annotation (validation_context& ctx,
-                                                const std::string& instance_path);
+                                                const jvalue& instance) const;
         jvalue get_items_annotation (validation_context& ctx,
-                                     const std::string& instance_path);
+                                     const jvalue& instance) const;
         jvalue get_prefixItems_annotation (validation_context& ctx,
-                                           const std::string& instance_path);
+                                           const jvalue& instance) const;
         jvalue get_contains_annotation (validation_context& ctx,
-                                        const std::string& instance_path);
+                                        const jvalue& instance) const;
 
         std::set<size_t> collect_unevaluatedItems_annotations (validation_context& ctx,
-                                                               jvalue& instance);
+                                                               const jvalue& instance) const;
 
 
 
         void get_properties_annotations (validation_context& ctx,
-                                         const std::string& instance_path,
-                                         const std::string& keyword,
-                                         std::set<std::string>& names);
-        std::set<std::string> collect_unevaluatedProperties_annotations (validation_context& ctx);
+                                         const jvalue& instance,
+                                         validation_context::annotation_keyword_t keyword,
+                                         std::set<std::string>& names) const;
+        std::set<std::string> collect_unevaluatedProperties_annotations (validation_context& ctx,
+                                                                         const jvalue& instance) const;
     };
 
 
@@ -160,10 +160,10 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static bool is_integer (jvalue& instance)
+    static bool is_integer (const jvalue& instance)
     {
 #if UJSON_HAVE_GMPXX
-        return instance.type()==j_number && is_integer(instance.mpf());
+        return instance.type()==j_number && is_integer(instance.get_mpf());
 #else
         return instance.type()==j_number && is_integer(instance.num());
 #endif
@@ -184,6 +184,24 @@ namespace ujson::schema {
     }
 
 
+    // Keyword 'enum' with more elements than this compares hash values first
+    static constexpr size_t enum_hash_min_size = 8;
+
+
+    //--------------------------------------------------------------------------
+    // Convert a number in a schema to the representation used by the
+    // validators, so it isn't converted again at each validation.
+    //--------------------------------------------------------------------------
+    static void preparse_number (jvalue& value)
+    {
+#if UJSON_HAVE_GMPXX
+        value.mpf ();
+#else
+        value.num (value.num());
+#endif
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     jvocabulary_validation::jvocabulary_validation (jschema& schema_arg)
@@ -211,6 +229,25 @@ namespace ujson::schema {
                 }
             }
         }
+
+        compile (schema, compiled_schemas[&schema]);
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void jvocabulary_validation::compile (const jvalue& schema, compiled_schema_t& compiled)
+    {
+        compiled.clear ();
+        for (auto& member : schema.obj()) {
+            auto entry = keywords.find (member.first);
+            if (entry == keywords.end())
+                continue;
+            compiled.push_back ({&entry->first,
+                                 &member.second,
+                                 std::get<0> (entry->second),
+                                 std::get<2> (entry->second)});
+        }
     }
 
 
@@ -226,6 +263,7 @@ namespace ujson::schema {
             what.append ("' not a number.");
             throw invalid_schema (what);
         }
+        preparse_number (schema_value);
     }
 
 
@@ -241,6 +279,7 @@ namespace ujson::schema {
             what.append ("' not a non-negative integer.");
             throw invalid_schema (what);
         }
+        preparse_number (schema_value);
     }
 
 
@@ -297,6 +336,14 @@ namespace ujson::schema {
         if (schema_value.array().empty()) {
             throw invalid_schema ("Schema keyword 'enum' is an empty array.");
         }
+
+        // Compare hash values first when there are many elements
+        if (schema_value.array().size() > enum_hash_min_size) {
+            auto& hashes = enum_hashes[&schema_value];
+            hashes.clear ();
+            for (auto& element : schema_value.array())
+                hashes.push_back (element.hash());
+        }
     }
 
 
@@ -319,6 +366,7 @@ namespace ujson::schema {
         // 6.2.1. The value of "multipleOf" MUST be a number, strictly greater than 0.
         if (value_num <= 0)
             throw invalid_schema ("Schema keyword 'multipleOf' not greater than 0.");
+        preparse_number (schema_value);
     }
 
 
@@ -333,7 +381,7 @@ namespace ujson::schema {
             if (schema_value.type() != j_string)
                 throw invalid_schema ("Schema keyword 'pattern' not a string.");
 
-            std::regex re (schema_value.str(), std::regex::ECMAScript);
+            compiled_regex (schema_value, schema_value.str());
         }
         catch (std::regex_error& re) {
             throw invalid_schema ("Schema keyword 'pattern' not a valid regular expression.");
@@ -413,33 +461,34 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate (validation_context& ctx,
-                                           jvalue& schema,
-                                           jvalue& instance,
-                                           const bool quit_on_first_error)
+                                           const jvalue& schema,
+                                           const jvalue& instance,
+                                           const bool quit_on_first_error) const
     {
         bool valid = true;
 
-        for (auto& member : schema.obj()) {
-
-            const std::string& schema_keyword = member.first;
-            ujson::jvalue& schema_value = member.second;
-
-            // Find a validator for this keyword
-            auto entry = keywords.find (schema_keyword);
-            if (entry == keywords.end())
-                continue;
+        // Schemas that weren't loaded, like a '$ref' to a location
+        // that is not a subschema, are compiled when validated.
+        compiled_schema_t not_loaded;
+        auto entry = compiled_schemas.find (&schema);
+        if (entry == compiled_schemas.end())
+            compile (schema, not_loaded);
+        auto& compiled = entry==compiled_schemas.end() ? not_loaded : entry->second;
 
+        auto instance_type = instance.type ();
+        for (auto& kw : compiled) {
             // Check if the keyword handles this type of instance
-            auto keyword_type = std::get<0> (entry->second);
-            if (keyword_type==instance.type() || keyword_type==j_invalid) {
+            if (kw.instance_type==instance_type || kw.instance_type==j_invalid) {
                 std::string error_msg;
-                auto kw_validator = std::get<2> (entry->second);
 
-                ctx.push_schema_path (schema_keyword);
-                if ((this->*kw_validator)(ctx, schema, schema_value, instance, error_msg)) {
+                ctx.push_schema_path (*kw.keyword);
+                validation_profile::timer prof (ctx);
+                if ((this->*kw.validator)(ctx, schema, *kw.value, instance, error_msg)) {
+                    prof.stop (true);
                     ctx.append_sub_ou ();
                 }else{
                     if (error_msg.empty() == false) {
+                        prof.stop (false);
                         valid = false;
                         ctx.set_valid (false);
                         ctx.append_error (error_msg);
@@ -459,11 +508,11 @@ namespace ujson::schema {
     // Any instance type
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_type_impl (validation_context& ctx,
-                                                     jvalue& schema,
-                                                     std::string& type_name,
-                                                     jvalue& instance,
+                                                     const jvalue& schema,
+                                                     const std::string& type_name,
+                                                     const jvalue& instance,
                                                      std::string& error_msg,
-                                                     bool set_error_msg)
+                                                     bool set_error_msg) const
     {
         bool valid = true;
 
@@ -487,17 +536,18 @@ namespace ujson::schema {
     // Any instance type
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_type (validation_context& ctx,
-                                                jvalue& schema,
-                                                jvalue& schema_value,
-                                                jvalue& instance,
-                                                std::string& error_msg)
+                                                const jvalue& schema,
+                                                const jvalue& schema_value,
+                                                const jvalue& instance,
+                                                std::string& error_msg) const
     {
         if (schema_value.type() == j_string) {
-            return validate_type_impl (ctx, schema, schema_value.str(), instance, error_msg);
+            return validate_type_impl (ctx, schema, std::string(schema_value.str_view()),
+                                       instance, error_msg);
         }
         else if (schema_value.type() == j_array) {
             for (auto& sv : schema_value.array()) {
-                if (validate_type_impl(ctx, schema, sv.str(), instance, error_msg, false))
+                if (validate_type_impl(ctx, schema, std::string(sv.str_view()), instance, error_msg, false))
                     return true;
             }
         }
@@ -511,14 +561,24 @@ namespace ujson::schema {
     // Any instance type
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_enum (validation_context& ctx,
-                                                jvalue& schema,
-                                                jvalue& schema_value,
-                                                jvalue& instance,
-                                                std::string& error_msg)
-    {
-        for (auto& element : schema_value.array()) {
-            if (element == instance)
-                return true;
+                                                const jvalue& schema,
+                                                const jvalue& schema_value,
+                                                const jvalue& instance,
+                                                std::string& error_msg) const
+    {
+        auto& a = schema_value.array ();
+        auto entry = enum_hashes.find (&schema_value);
+        if (entry != enum_hashes.end()  &&  entry->second.size() == a.size()) {
+            size_t h = instance.hash ();
+            for (size_t i=0; i<a.size(); ++i) {
+                if (entry->second[i] == h  &&  a[i] == instance)
+                    return true;
+            }
+        }else{
+            for (auto& element : a) {
+                if (element == instance)
+                    return true;
+            }
         }
 
         error_msg = "Value not one of the allowed values in enum.";
@@ -530,10 +590,10 @@ namespace ujson::schema {
     // Any instance type
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_const (validation_context& ctx,
-                                                 jvalue& schema,
-                                                 jvalue& schema_value,
-                                                 jvalue& instance,
-                                                 std::string& error_msg)
+                                                 const jvalue& schema,
+                                                 const jvalue& schema_value,
+                                                 const jvalue& instance,
+                                                 std::string& error_msg) const
     {
         bool valid = schema_value == instance;
         if (!valid)
@@ -546,14 +606,14 @@ namespace ujson::schema {
     // Numeric instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_multipleOf (validation_context& ctx,
-                                                      jvalue& schema,
-                                                      jvalue& schema_value,
-                                                      jvalue& instance,
-                                                      std::string& error_msg)
+                                                      const jvalue& schema,
+                                                      const jvalue& schema_value,
+                                                      const jvalue& instance,
+                                                      std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        auto& vdata_num = instance.mpf ();
-        auto& value_num = schema_value.mpf ();
+        auto vdata_num = instance.get_mpf ();
+        auto value_num = schema_value.get_mpf ();
 #else
         auto vdata_num = instance.num ();
         auto value_num = schema_value.num ();
@@ -569,13 +629,13 @@ namespace ujson::schema {
     // Numeric instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_maximum (validation_context& ctx,
-                                                   jvalue& schema,
-                                                   jvalue& schema_value,
-                                                   jvalue& instance,
-                                                   std::string& error_msg)
+                                                   const jvalue& schema,
+                                                   const jvalue& schema_value,
+                                                   const jvalue& instance,
+                                                   std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        bool valid = instance.mpf() <= schema_value.mpf();
+        bool valid = instance.get_mpf() <= schema_value.get_mpf();
 #else
         bool valid = instance.num() <= schema_value.num ();
 #endif
@@ -589,13 +649,13 @@ namespace ujson::schema {
     // Numeric instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_exclusiveMaximum (validation_context& ctx,
-                                                            jvalue& schema,
-                                                            jvalue& schema_value,
-                                                            jvalue& instance,
-                                                            std::string& error_msg)
+                                                            const jvalue& schema,
+                                                            const jvalue& schema_value,
+                                                            const jvalue& instance,
+                                                            std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        bool valid = instance.mpf() < schema_value.mpf();
+        bool valid = instance.get_mpf() < schema_value.get_mpf();
 #else
         bool valid = instance.num() < schema_value.num ();
 #endif
@@ -609,13 +669,13 @@ namespace ujson::schema {
     // Numeric instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_minimum (validation_context& ctx,
-                                                   jvalue& schema,
-                                                   jvalue& schema_value,
-                                                   jvalue& instance,
-                                                   std::string& error_msg)
+                                                   const jvalue& schema,
+                                                   const jvalue& schema_value,
+                                                   const jvalue& instance,
+                                                   std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        bool valid = instance.mpf() >= schema_value.mpf();
+        bool valid = instance.get_mpf() >= schema_value.get_mpf();
 #else
         bool valid = instance.num() >= schema_value.num ();
 #endif
@@ -629,13 +689,13 @@ namespace ujson::schema {
     // Numeric instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_exclusiveMinimum (validation_context& ctx,
-                                                            jvalue& schema,
-                                                            jvalue& schema_value,
-                                                            jvalue& instance,
-                                                            std::string& error_msg)
+                                                            const jvalue& schema,
+                                                            const jvalue& schema_value,
+                                                            const jvalue& instance,
+                                                            std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        bool valid = instance.mpf() > schema_value.mpf();
+        bool valid = instance.get_mpf() > schema_value.get_mpf();
 #else
         bool valid = instance.num() > schema_value.num ();
 #endif
@@ -647,7 +707,7 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static size_t simple_utf8_len (const std::string& str)
+    static size_t simple_utf8_len (const std::string_view& str)
     {
         size_t retval = 0;
         for (size_t i=0; i<str.length(); ++i)
@@ -661,17 +721,17 @@ namespace ujson::schema {
     // String instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_maxLength (validation_context& ctx,
-                                                     jvalue& schema,
-                                                     jvalue& schema_value,
-                                                     jvalue& instance,
-                                                     std::string& error_msg)
+                                                     const jvalue& schema,
+                                                     const jvalue& schema_value,
+                                                     const jvalue& instance,
+                                                     std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        size_t max_len = (size_t) schema_value.mpf().get_ui ();
+        size_t max_len = (size_t) schema_value.get_mpf().get_ui ();
 #else
         size_t max_len = (size_t) schema_value.num ();
 #endif
-        bool valid = simple_utf8_len(instance.str()) <= max_len;
+        bool valid = simple_utf8_len(instance.str_view()) <= max_len;
         if (!valid)
             error_msg = "String too long.";
         return valid;
@@ -682,17 +742,17 @@ namespace ujson::schema {
     // String instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_minLength (validation_context& ctx,
-                                                     jvalue& schema,
-                                                     jvalue& schema_value,
-                                                     jvalue& instance,
-                                                     std::string& error_msg)
+                                                     const jvalue& schema,
+                                                     const jvalue& schema_value,
+                                                     const jvalue& instance,
+                                                     std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        size_t min_len = (size_t) schema_value.mpf().get_ui ();
+        size_t min_len = (size_t) schema_value.get_mpf().get_ui ();
 #else
         size_t min_len = (size_t) schema_value.num ();
 #endif
-        bool valid = simple_utf8_len(instance.str()) >= min_len;
+        bool valid = simple_utf8_len(instance.str_view()) >= min_len;
         if (!valid)
             error_msg = "String too short.";
         return valid;
@@ -703,15 +763,16 @@ namespace ujson::schema {
     // String instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_pattern (validation_context& ctx,
-                                                   jvalue& schema,
-                                                   jvalue& schema_value,
-                                                   jvalue& instance,
-                                                   std::string& error_msg)
+                                                   const jvalue& schema,
+                                                   const jvalue& schema_value,
+                                                   const jvalue& instance,
+                                                   std::string& error_msg) const
     {
         bool valid = true;
-        std::regex re (schema_value.str(), std::regex::ECMAScript);
+        auto re = compiled_regex (schema_value, schema_value.str_view());
+        auto str = instance.str_view ();
         std::cmatch cm;
-        valid = (bool) std::regex_search (instance.str().c_str(), cm, re);
+        valid = (bool) std::regex_search (str.data(), str.data()+str.size(), cm, *re);
         if (!valid)
             error_msg = "String failed regular expression check.";
 
@@ -723,13 +784,13 @@ namespace ujson::schema {
     // Array instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_maxItems (validation_context& ctx,
-                                                    jvalue& schema,
-                                                    jvalue& schema_value,
-                                                    jvalue& instance,
-                                                    std::string& error_msg)
+                                                    const jvalue& schema,
+                                                    const jvalue& schema_value,
+                                                    const jvalue& instance,
+                                                    std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        bool valid = instance.size() <= (size_t)schema_value.mpf().get_ui();
+        bool valid = instance.size() <= (size_t)schema_value.get_mpf().get_ui();
 #else
         bool valid = instance.size() <= (size_t)schema_value.num();
 #endif
@@ -743,13 +804,13 @@ namespace ujson::schema {
     // Array instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_minItems (validation_context& ctx,
-                                                    jvalue& schema,
-                                                    jvalue& schema_value,
-                                                    jvalue& instance,
-                                                    std::string& error_msg)
+                                                    const jvalue& schema,
+                                                    const jvalue& schema_value,
+                                                    const jvalue& instance,
+                                                    std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        bool valid = instance.size() >= (size_t)schema_value.mpf().get_ui();
+        bool valid = instance.size() >= (size_t)schema_value.get_mpf().get_ui();
 #else
         bool valid = instance.size() >= (size_t)schema_value.num();
 #endif
@@ -763,22 +824,30 @@ namespace ujson::schema {
     // Array instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_uniqueItems (validation_context& ctx,
-                                                       jvalue& schema,
-                                                       jvalue& schema_value,
-                                                       jvalue& instance,
-                                                       std::string& error_msg)
+                                                       const jvalue& schema,
+                                                       const jvalue& schema_value,
+                                                       const jvalue& instance,
+                                                       std::string& error_msg) const
     {
         if (schema_value == false)
             return true;
 
         bool valid = true;
         if (schema_value.boolean()) {
+            // Only items with the same hash value need to be compared
             auto& a = instance.array ();
+            std::unordered_multimap<size_t, const jvalue*> items;
+            items.reserve (a.size());
             for (size_t i=0; i<a.size() && valid; ++i) {
-                for (size_t j=i+1; j<a.size() && valid; ++j) {
-                    if (a[i] == a[j])
+                size_t h = a[i].hash ();
+                auto range = items.equal_range (h);
+                for (auto entry=range.first; entry!=range.second; ++entry) {
+                    if (*entry->second == a[i]) {
                         valid = false;
+                        break;
+                    }
                 }
+                items.emplace (h, &a[i]);
             }
         }
         if (!valid)
@@ -791,13 +860,13 @@ namespace ujson::schema {
     // Array instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_maxContains (validation_context& ctx,
-                                                       jvalue& schema,
-                                                       jvalue& schema_value,
-                                                       jvalue& instance,
-                                                       std::string& error_msg)
+                                                       const jvalue& schema,
+                                                       const jvalue& schema_value,
+                                                       const jvalue& instance,
+                                                       std::string& error_msg) const
     {
         jvalue* annotation = nullptr;
-        annotation = ctx.annotation ("contains", ctx.instance_path().str());
+        annotation = ctx.annotation (validation_context::ann_contains, instance);
         if (!annotation) {
             // 6.4.4.
             //     If "contains" is not present within the same schema object,
@@ -826,17 +895,17 @@ namespace ujson::schema {
     // Array instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_minContains (validation_context& ctx,
-                                                       jvalue& schema,
-                                                       jvalue& schema_value,
-                                                       jvalue& instance,
-                                                       std::string& error_msg)
+                                                       const jvalue& schema,
+                                                       const jvalue& schema_value,
+                                                       const jvalue& instance,
+                                                       std::string& error_msg) const
     {
         if (schema_value == 0)
             return true;
 
         bool valid = true;
         jvalue* annotation = nullptr;
-        annotation = ctx.annotation ("contains", ctx.instance_path().str());
+        annotation = ctx.annotation (validation_context::ann_contains, instance);
         if (!annotation) {
             // 6.4.5.
             //     If "contains" is not present within the same schema object,
@@ -864,13 +933,13 @@ namespace ujson::schema {
     // Object instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_maxProperties (validation_context& ctx,
-                                                         jvalue& schema,
-                                                         jvalue& schema_value,
-                                                         jvalue& instance,
-                                                         std::string& error_msg)
+                                                         const jvalue& schema,
+                                                         const jvalue& schema_value,
+                                                         const jvalue& instance,
+                                                         std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        size_t max_properties = (size_t) schema_value.mpf().get_ui ();
+        size_t max_properties = (size_t) schema_value.get_mpf().get_ui ();
 #else
         size_t max_properties = (size_t) schema_value.num ();
 #endif
@@ -885,13 +954,13 @@ namespace ujson::schema {
     // Object instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_minProperties (validation_context& ctx,
-                                                         jvalue& schema,
-                                                         jvalue& schema_value,
-                                                         jvalue& instance,
-                                                         std::string& error_msg)
+                                                         const jvalue& schema,
+                                                         const jvalue& schema_value,
+                                                         const jvalue& instance,
+                                                         std::string& error_msg) const
     {
 #if UJSON_HAVE_GMPXX
-        size_t min_properties = (size_t) schema_value.mpf().get_ui ();
+        size_t min_properties = (size_t) schema_value.get_mpf().get_ui ();
 #else
         size_t min_properties = (size_t) schema_value.num ();
 #endif
@@ -906,16 +975,17 @@ namespace ujson::schema {
     // Object instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_required (validation_context& ctx,
-                                                    jvalue& schema,
-                                                    jvalue& schema_value,
-                                                    jvalue& instance,
-                                                    std::string& error_msg)
+                                                    const jvalue& schema,
+                                                    const jvalue& schema_value,
+                                                    const jvalue& instance,
+                                                    std::string& error_msg) const
     {
         bool valid = true;
-        for (auto& name : schema_value.array()) {
-            if (instance.has(name.str()) == false) {
+        for (auto& name_value : schema_value.array()) {
+            const std::string name (name_value.str_view());
+            if (instance.has(name) == false) {
                 valid = false;
-                error_msg = std::string("Object missing property '") + name.str() + std::string("'.");
+                error_msg = std::string("Object missing property '") + name + std::string("'.");
                 break;
             }
         }
@@ -927,18 +997,19 @@ namespace ujson::schema {
     // Object instances
     //--------------------------------------------------------------------------
     bool jvocabulary_validation::validate_dependentRequired (validation_context& ctx,
-                                                             jvalue& schema,
-                                                             jvalue& schema_value,
-                                                             jvalue& instance,
-                                                             std::string& error_msg)
+                                                             const jvalue& schema,
+                                                             const jvalue& schema_value,
+                                                             const jvalue& instance,
+                                                             std::string& error_msg) const
     {
         for (auto& member : schema_value.obj()) {
             if (instance.has(member.first) == false)
                 continue;
-            for (auto& name : member.second.array()) {
-                if (instance.has(name.str()) == false) {
+            for (auto& name_value : member.second.array()) {
+                const std::string name (name_value.str_view());
+                if (instance.has(name) == false) {
                     error_msg = std::string("Object has property '") + member.first
-                        + std::string("', but missing property '") + name.str() + std::string("'.");
+                        + std::string("', but missing property '") + name + std::string("'.");
                     return false;
                 }
             }
@@ -22,7 +22,9 @@
 #include <ujson/schema/jvocabulary.hpp>
 #include <string>
 #include <tuple>
+#include <vector>
 #include <map>
+#include <unordered_map>
 
 
 namespace ujson::schema {
@@ -37,9 +39,9 @@ namespace ujson::schema {
 
         virtual void load (jvalue& schema, jvalue& load_ctx);
         virtual bool validate (validation_context& ctx,
-                               jvalue& schema,
-                               jvalue& instance,
-                               const bool quit_on_first_error);
+                               const jvalue& schema,
+                               const jvalue& instance,
+                               const bool quit_on_first_error) const;
 
 
     private:
@@ -56,87 +58,104 @@ namespace ujson::schema {
 
         // Validation keywords for any instance
         bool validate_type (validation_context& ctx,
-                            jvalue& schema, jvalue& schema_value,
-                            jvalue& instance, std::string& error_msg);
+                            const jvalue& schema, const jvalue& schema_value,
+                            const jvalue& instance, std::string& error_msg) const;
         bool validate_type_impl (validation_context& ctx,
-                                 jvalue& schema, std::string& type_name,
-                                 jvalue& instance, std::string& error_msg,
-                                 bool set_error_msg=true);
+                                 const jvalue& schema, const std::string& type_name,
+                                 const jvalue& instance, std::string& error_msg,
+                                 bool set_error_msg=true) const;
         bool validate_enum (validation_context& ctx,
-                            jvalue& schema, jvalue& schema_value,
-                            jvalue& instance, std::string& error_msg);
+                            const jvalue& schema, const jvalue& schema_value,
+                            const jvalue& instance, std::string& error_msg) const;
         bool validate_const (validation_context& ctx,
-                             jvalue& schema, jvalue& schema_value,
-                             jvalue& instance, std::string& error_msg);
+                             const jvalue& schema, const jvalue& schema_value,
+                             const jvalue& instance, std::string& error_msg) const;
 
         // Validation keywords for numeric instances
         bool validate_multipleOf (validation_context& ctx,
-                                  jvalue& schema, jvalue& schema_value,
-                                  jvalue& instance, std::string& error_msg);
+                                  const jvalue& schema, const jvalue& schema_value,
+                                  const jvalue& instance, std::string& error_msg) const;
         bool validate_maximum (validation_context& ctx,
-                               jvalue& schema, jvalue& schema_value,
-                               jvalue& instance, std::string& error_msg);
+                               const jvalue& schema, const jvalue& schema_value,
+                               const jvalue& instance, std::string& error_msg) const;
         bool validate_exclusiveMaximum (validation_context& ctx,
-                                        jvalue& schema, jvalue& schema_value,
-                                        jvalue& instance, std::string& error_msg);
+                                        const jvalue& schema, const jvalue& schema_value,
+                                        const jvalue& instance, std::string& error_msg) const;
         bool validate_minimum (validation_context& ctx,
-                               jvalue& schema, jvalue& schema_value,
-                               jvalue& instance, std::string& error_msg);
+                               const jvalue& schema, const jvalue& schema_value,
+                               const jvalue& instance, std::string& error_msg) const;
         bool validate_exclusiveMinimum (validation_context& ctx,
-                                        jvalue& schema, jvalue& schema_value,
-                                        jvalue& instance, std::string& error_msg);
+                                        const jvalue& schema, const jvalue& schema_value,
+                                        const jvalue& instance, std::string& error_msg) const;
 
         // Validation keywords for strings
         bool validate_maxLength (validation_context& ctx,
-                                 jvalue& schema, jvalue& schema_value,
-                                 jvalue& instance, std::string& error_msg);
+                                 const jvalue& schema, const jvalue& schema_value,
+                                 const jvalue& instance, std::string& error_msg) const;
         bool validate_minLength (validation_context& ctx,
-                                 jvalue& schema, jvalue& schema_value,
-                                 jvalue& instance, std::string& error_msg);
+                                 const jvalue& schema, const jvalue& schema_value,
+                                 const jvalue& instance, std::string& error_msg) const;
         bool validate_pattern (validation_context& ctx,
-                               jvalue& schema, jvalue& schema_value,
-                               jvalue& instance, std::string& error_msg);
+                               const jvalue& schema, const jvalue& schema_value,
+                               const jvalue& instance, std::string& error_msg) const;
 
         // Validation keywords for arrays
         bool validate_maxItems (validation_context& ctx,
-                                jvalue& schema, jvalue& schema_value,
-                                jvalue& instance, std::string& error_msg);
+                                const jvalue& schema, const jvalue& schema_value,
+                                const jvalue& instance, std::string& error_msg) const;
         bool validate_minItems (validation_context& ctx,
-                                jvalue& schema, jvalue& schema_value,
-                                jvalue& instance, std::string& error_msg);
+                                const jvalue& schema, const jvalue& schema_value,
+                                const jvalue& instance, std::string& error_msg) const;
         bool validate_uniqueItems (validation_context& ctx,
-                                   jvalue& schema, jvalue& schema_value,
-                                   jvalue& instance, std::string& error_msg);
+                                   const jvalue& schema, const jvalue& schema_value,
+                                   const jvalue& instance, std::string& error_msg) const;
         bool validate_maxContains (validation_context& ctx,
-                                   jvalue& schema, jvalue& schema_value,
-                                   jvalue& instance, std::string& error_msg);
+                                   const jvalue& schema, const jvalue& schema_value,
+                                   const jvalue& instance, std::string& error_msg) const;
         bool validate_minContains (validation_context& ctx,
-                                   jvalue& schema, jvalue& schema_value,
-                                   jvalue& instance, std::string& error_msg);
+                                   const jvalue& schema, const jvalue& schema_value,
+                                   const jvalue& instance, std::string& error_msg) const;
 
         // Validation keywords for objects
         bool validate_maxProperties (validation_context& ctx,
-                                     jvalue& schema, jvalue& schema_value,
-                                     jvalue& instance, std::string& error_msg);
+                                     const jvalue& schema, const jvalue& schema_value,
+                                     const jvalue& instance, std::string& error_msg) const;
         bool validate_minProperties (validation_context& ctx,
-                                     jvalue& schema, jvalue& schema_value,
-                                     jvalue& instance, std::string& error_msg);
+                                     const jvalue& schema, const jvalue& schema_value,
+                                     const jvalue& instance, std::string& error_msg) const;
         bool validate_required (validation_context& ctx,
-                                jvalue& schema, jvalue& schema_value,
-                                jvalue& instance, std::string& error_msg);
+                                const jvalue& schema, const jvalue& schema_value,
+                                const jvalue& instance, std::string& error_msg) const;
         bool validate_dependentRequired (validation_context& ctx,
-                                         jvalue& schema, jvalue& schema_value,
-                                         jvalue& instance, std::string& error_msg);
+                                         const jvalue& schema, const jvalue& schema_value,
+                                         const jvalue& instance, std::string& error_msg) const;
 
         using kw_validator_t = bool (jvocabulary_validation::*) (validation_context&,
-                                                                      jvalue&,
-                                                                      jvalue&,
-                                                                      jvalue&,
-                                                                      std::string&);
+                                                                      const jvalue&,
+                                                                      const jvalue&,
+                                                                      const jvalue&,
+                                                                      std::string&) const;
         using kw_loader_t = void (jvocabulary_validation::*) (const std::string&, jvalue&, jvalue&);
 
         using keywords_t = std::map<std::string, std::tuple<jvalue_type, kw_loader_t, kw_validator_t>>;
         static const keywords_t keywords;
+
+        // A keyword of a loaded schema and its validator
+        struct compiled_keyword_t {
+            const std::string* keyword;
+            const jvalue* value;
+            jvalue_type instance_type;
+            kw_validator_t validator;
+        };
+        using compiled_schema_t = std::vector<compiled_keyword_t>;
+
+        static void compile (const jvalue& schema, compiled_schema_t& compiled);
+
+        // The keywords of each loaded (sub)schema, in schema order
+        std::unordered_map<const jvalue*, compiled_schema_t> compiled_schemas;
+
+        // Hash values of the elements in larger 'enum' arrays
+        std::unordered_map<const jvalue*, std::vector<size_t>> enum_hashes;
     };
 
 
@@ -35,13 +35,20 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    validation_context::validation_context ()
+    validation_context::validation_context (bool build_output_arg)
         : parent (nullptr),
-          output_unit (j_object)
+          build_output (build_output_arg),
+          parallel (false),
+          profile (nullptr),
+          profiled_depth ((size_t)-1),
+          output_unit (build_output_arg ? j_object : j_null)
     {
         validation_path_ptr.reset (new jpointer);
         instance_path_ptr.reset (new jpointer);
 
+        if (!build_output)
+            return;
+
         // Always assume the validation is
         // ok until it explicitly fails.
         output_unit["valid"] = true;
@@ -54,17 +61,24 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     validation_context::validation_context (validation_context& parent_arg)
         : parent (&parent_arg),
-          output_unit (j_object),
+          build_output (parent_arg.build_output),
+          parallel (parent_arg.parallel),
+          profile (parent_arg.profile),
+          profiled_depth (parent_arg.profiled_depth),
+          output_unit (parent_arg.build_output ? j_object : j_null),
           validation_path_ptr (parent_arg.validation_path_ptr),
           instance_path_ptr (parent_arg.instance_path_ptr)
     {
+        base_uri = parent_arg.base_uri;
+        abs_keyword_path = parent_arg.abs_keyword_path;
+
+        if (!build_output)
+            return;
+
         // Always assume the validation is
         // ok until it explicitly fails.
         output_unit["valid"] = true;
 
-        base_uri = parent_arg.base_uri;
-        abs_keyword_path = parent_arg.abs_keyword_path;
-
         // Initialize the output unit
         output_unit["instanceLocation"] = instance_path().str ();
         output_unit["keywordLocation"] = validation_path().str ();
@@ -80,6 +94,15 @@ namespace ujson::schema {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void validation_context::detach_paths ()
+    {
+        validation_path_ptr = std::make_shared<jpointer> (*validation_path_ptr);
+        instance_path_ptr = std::make_shared<jpointer> (*instance_path_ptr);
+    }
+
+
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
     void validation_context::push_schema_path (const std::string& entry)
@@ -122,6 +145,9 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     void validation_context::set_error (const std::string& err_msg)
     {
+        if (!build_output)
+            return;
+
         set_valid (false);
 
         auto& ou = output_unit.obj ();
@@ -143,6 +169,9 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     void validation_context::append_error (const std::string& err_msg)
     {
+        if (!build_output)
+            return;
+
         //set_valid (false);
 
         validation_context sub_ctx (*this);
@@ -155,6 +184,9 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     void validation_context::append_sub_ou ()
     {
+        if (!build_output)
+            return;
+
         validation_context sub_ctx (*this);
         add_output_unit (std::move(sub_ctx.output_unit));
     }
@@ -162,7 +194,7 @@ namespace ujson::schema {
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    void validation_context::annotate (const jvalue& value)
+    void validation_context::annotate (annotation_keyword_t keyword, const jvalue& instance, jvalue value)
     {
         // Store annotation for later usage
         //
@@ -172,22 +204,29 @@ namespace ujson::schema {
              << instance_path().str() << "): "
              << value.describe(fmt_color) << endl;
 #endif
-        annotations.emplace (
-                std::make_pair(validation_path().empty() ? "" : validation_path().back(),
-                               instance_path().str()),
-                value);
+        if (annotation(keyword, instance) == nullptr)
+            annotations.emplace_back (annotation_t{keyword, &instance, std::move(value)});
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    jvalue* validation_context::annotation (const std::string& keyword, const std::string& instance_path)
+    void validation_context::set_output_annotation (const jvalue& value)
     {
-        auto entry = annotations.find (std::make_pair(keyword, instance_path));
-        if (entry != annotations.end())
-            return &entry->second;
-        else
-            return nullptr;
+        if (build_output)
+            output_unit["annotation"] = value;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue* validation_context::annotation (annotation_keyword_t keyword, const jvalue& instance)
+    {
+        for (auto& a : annotations) {
+            if (a.keyword == keyword  &&  a.instance == &instance)
+                return &a.value;
+        }
+        return nullptr;
     }
 
 
@@ -195,10 +234,8 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     void validation_context::collect_annotations (validation_context& sub_ctx)
     {
-        if (sub_ctx.annotations.empty() == false)
-            in_place_annotations.emplace_back (std::move(sub_ctx.annotations));
-        for (auto& annotations : sub_ctx.in_place_annotations)
-            in_place_annotations.emplace_back (std::move(annotations));
+        in_place_annotations.splice (in_place_annotations.end(), sub_ctx.annotations);
+        in_place_annotations.splice (in_place_annotations.end(), sub_ctx.in_place_annotations);
     }
 
 
@@ -227,7 +264,7 @@ namespace ujson::schema {
                 }else{
                     cerr << "                       ";
                 }
-                cerr << a.first.first << ", " << a.first.second << ": " << a.second.describe() << endl;
+                cerr << a.keyword << ", " << a.instance << ": " << a.value.describe() << endl;
             }
         }
     }
@@ -244,15 +281,13 @@ namespace ujson::schema {
 
         for (auto& a : annotations) {
             cerr << __FUNCTION__ << ": Annotation - ";
-            cerr << "<\"" << a.first.first << "\", \"" << a.first.second << "\">: ";
-            cerr << a.second.describe() << endl;
+            cerr << "<" << a.keyword << ", " << a.instance << ">: ";
+            cerr << a.value.describe() << endl;
         }
-        for (auto& list : in_place_annotations) {
-            for (auto& a : list) {
-                cerr << __FUNCTION__ << ": In-place   - ";
-                cerr << "<\"" << a.first.first << "\", \"" << a.first.second << "\">: ";
-                cerr << a.second.describe() << endl;
-            }
+        for (auto& a : in_place_annotations) {
+            cerr << __FUNCTION__ << ": In-place   - ";
+            cerr << "<" << a.keyword << ", " << a.instance << ">: ";
+            cerr << a.value.describe() << endl;
         }
 
     }
@@ -263,6 +298,9 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     void validation_context::set_valid (const bool is_valid)
     {
+        if (!build_output)
+            return;
+
         output_unit["valid"] = is_valid;
 
         if (is_valid) {
@@ -279,6 +317,9 @@ namespace ujson::schema {
     //--------------------------------------------------------------------------
     void validation_context::add_output_unit (jvalue&& sub_output_unit, output_unit_placement_t where)
     {
+        if (!build_output)
+            return;
+
         if (where == place_automatic)
             where = sub_output_unit["valid"].boolean() ? place_annotation : place_error;
 
@@ -25,13 +25,15 @@
 #include <string>
 #include <memory>
 #include <list>
-#include <map>
 
 /**
  * JSON schema implementation classes.
  */
 namespace ujson::schema {
 
+    // Forward declaration
+    class validation_profile;
+
     /**
      * Schema validation context.
      */
@@ -43,7 +45,39 @@ namespace ujson::schema {
             place_error
         };
 
-        validation_context ();
+        /**
+         * Keywords that produce annotations.
+         */
+        enum annotation_keyword_t {
+            ann_prefixItems,
+            ann_items,
+            ann_contains,
+            ann_properties,
+            ann_patternProperties,
+            ann_additionalProperties,
+            ann_unevaluatedItems,
+            ann_unevaluatedProperties
+        };
+
+        /**
+         * An annotation.
+         * The instance location is identified by the address
+         * of the instance, instances are not moved during validation.
+         */
+        struct annotation_t {
+            annotation_keyword_t keyword;
+            const jvalue* instance;
+            jvalue value;
+        };
+        using annotations_t = std::list<annotation_t>;
+
+        /**
+         * Constructor.
+         * @param build_output_arg If <code>false</code>, no output units
+         *                         are built. Only the result of the
+         *                         validation, and the annotations, are kept.
+         */
+        validation_context (bool build_output_arg=true);
         validation_context (validation_context& parent_arg);
 
         void push_schema_path (const std::string& entry);
@@ -55,8 +89,9 @@ namespace ujson::schema {
         void set_error (const std::string& err_msg);
         void append_error (const std::string& err_msg);
         void append_sub_ou ();
-        void annotate (const jvalue& value);
-        jvalue* annotation (const std::string& keyword, const std::string& instance_path);
+        void annotate (annotation_keyword_t keyword, const jvalue& instance, jvalue value);
+        void set_output_annotation (const jvalue& value);
+        jvalue* annotation (annotation_keyword_t keyword, const jvalue& instance);
 
         void collect_annotations (validation_context& sub_ctx);
 
@@ -75,20 +110,28 @@ namespace ujson::schema {
             return *instance_path_ptr;
         }
 
+        /**
+         * Give this context its own copy of the validation path
+         * and the instance path, they are otherwise shared with
+         * the parent context. This lets the context, and its sub
+         * contexts, be used in another thread than the parent.
+         */
+        void detach_paths ();
+
 
         validation_context* parent;
+        const bool build_output; // Build output units
+        bool parallel; // Child instances may be validated in parallel
+        validation_profile* profile; // Collect statistics if not nullptr
+        size_t profiled_depth; // Validation path size of the keyword being profiled
 
         std::string base_uri;
         jpointer abs_keyword_path;
 
         jvalue output_unit; // Created with: output_unit["valid"] = true
 
-
-        //                                       keyword      instance_path   annotation_value
-        using annotations_t = std::map<std::pair<std::string, std::string>,   jvalue>;
-
-        annotations_t annotations;
-        std::list<annotations_t> in_place_annotations;
+        annotations_t annotations;          // Annotations of this schema object
+        annotations_t in_place_annotations; // Annotations collected from subschemas
 
     private:
         std::shared_ptr<jpointer> validation_path_ptr;
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson/schema/validation_profile.hpp>
+
+
+namespace ujson::schema {
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void validation_profile::timer::stop (bool valid)
+    {
+        if (!active)
+            return;
+        active = false;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ctx.profile->record (ctx.validation_path().str(),
+                             valid,
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void validation_profile::clear ()
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        stats.clear ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    void validation_profile::record (const std::string& keyword_location,
+                                     bool valid,
+                                     std::chrono::nanoseconds time)
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        auto& entry = stats[keyword_location];
+        ++entry.evaluations;
+        if (valid)
+            ++entry.valid;
+        else
+            ++entry.invalid;
+        entry.time += time;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::map<std::string, validation_profile::entry_t> validation_profile::entries () const
+    {
+        std::lock_guard<std::mutex> lock (mutex);
+        return stats;
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    jvalue validation_profile::report () const
+    {
+        jvalue result (j_object);
+        for (auto& [location, entry] : entries()) {
+            jvalue& value = result[location];
+            value.type (j_object);
+            value["evaluations"] = static_cast<long> (entry.evaluations);
+            value["valid"] = static_cast<long> (entry.valid);
+            value["invalid"] = static_cast<long> (entry.invalid);
+            value["time"] = std::chrono::duration<double>(entry.time).count ();
+        }
+        return result;
+    }
+
+
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2024 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef UJSON_SCHEMA_VALIDATION_PROFILE_HPP
+#define UJSON_SCHEMA_VALIDATION_PROFILE_HPP
+
+#include <ujson/jvalue.hpp>
+#include <ujson/schema/validation_context.hpp>
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+
+namespace ujson::schema {
+
+
+    /**
+     * Statistics collected while validating JSON instances.
+     * A profile records, per keyword location, how many times
+     * the keyword, or the subschema, was evaluated, how many
+     * of the evaluations that were successful, and the total time
+     * spent evaluating it. The time includes the time spent
+     * evaluating the keywords and subschemas within it.
+     * <br/>
+     * Keyword locations are the same as in the output units,
+     * paths relative to the root schema, following any
+     * "$ref" or "$dynamicRef" keywords.
+     * <br/>
+     * A profile may be used by several threads at the same time,
+     * and may be used in more than one validation to accumulate
+     * statistics from many JSON instances.
+     * @see ujson::jschema::validate(const jvalue&, bool, validation_profile&) const
+     * @see ujson::jschema::is_valid(const jvalue&, validation_profile&) const
+     */
+    class validation_profile {
+    public:
+        /**
+         * Statistics of a keyword location.
+         */
+        struct entry_t {
+            size_t evaluations {0};         /**< Number of evaluations. */
+            size_t valid {0};               /**< Number of successful evaluations. */
+            size_t invalid {0};             /**< Number of failed evaluations. */
+            std::chrono::nanoseconds time {0}; /**< Total time spent in the evaluations. */
+        };
+
+        /**
+         * Times a single evaluation of a keyword, or a subschema,
+         * in a validation context that is being profiled.
+         * Has no effect if the validation context isn't profiled.
+         */
+        class timer {
+        public:
+            /**
+             * Start timing an evaluation at the current keyword location.
+             * @param ctx A validation context.
+             * @param keyword <code>true</code> if this is the evaluation
+             *                of a keyword. <code>false</code> if it is
+             *                the evaluation of a subschema, a subschema
+             *                at the same location as the keyword that
+             *                applies it is not recorded separately.
+             */
+            timer (validation_context& ctx, bool keyword=true);
+
+            /**
+             * Destructor.
+             * If stop() wasn't called, nothing is recorded.
+             */
+            ~timer ();
+
+            /**
+             * Stop the timer and record the evaluation.
+             * @param valid The result of the evaluation.
+             */
+            void stop (bool valid);
+
+        private:
+            validation_context& ctx;
+            bool active;
+            bool keyword;
+            size_t saved_depth;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        /**
+         * Remove all collected statistics.
+         */
+        void clear ();
+
+        /**
+         * Record an evaluation of a keyword location.
+         * @param keyword_location The keyword location.
+         * @param valid The result of the evaluation.
+         * @param time The time spent in the evaluation.
+         */
+        void record (const std::string& keyword_location,
+                     bool valid,
+                     std::chrono::nanoseconds time);
+
+        /**
+         * Return a copy of the collected statistics.
+         * @return A map of statistics, keyed on keyword location.
+         */
+        std::map<std::string, entry_t> entries () const;
+
+        /**
+         * Return the collected statistics as a JSON object.
+         * Each member name in the object is a keyword location,
+         * and the value is an object with the following members:
+         * <ul>
+         *   <li><code>"evaluations"</code> - Number of evaluations.</li>
+         *   <li><code>"valid"</code> - Number of successful evaluations.</li>
+         *   <li><code>"invalid"</code> - Number of failed evaluations.</li>
+         *   <li><code>"time"</code> - Total time in seconds.</li>
+         * </ul>
+         * @return A JSON object.
+         */
+        jvalue report () const;
+
+
+    private:
+        mutable std::mutex mutex;
+        std::map<std::string, entry_t> stats;
+    };
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    inline validation_profile::timer::timer (validation_context& ctx_arg, bool keyword_arg)
+        : ctx (ctx_arg),
+          active (false),
+          keyword (keyword_arg),
+          saved_depth (ctx_arg.profiled_depth)
+    {
+        if (ctx.profile == nullptr)
+            return;
+        size_t depth = ctx.validation_path().size ();
+        if (keyword) {
+            ctx.profiled_depth = depth;
+        }else if (depth == ctx.profiled_depth) {
+            return;
+        }
+        active = true;
+        start = std::chrono::steady_clock::now ();
+    }
+
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    inline validation_profile::timer::~timer ()
+    {
+        if (keyword)
+            ctx.profiled_depth = saved_depth;
+    }
+
+
+}
+#endif
@@ -18,14 +18,17 @@
  */
 #include <ujson/internal.hpp>
 #include <algorithm>
+#include <array>
 #include <string>
 #include <sstream>
 #include <stdexcept>
-#include <regex>
 #include <cstdio>
+#include <cstring>
+#include <limits>
 #include <ujson/utils.hpp>
 #include <ujson/jparser.hpp>
 #include <ujson/jpointer.hpp>
+#include <ujson/jwriter.hpp>
 
 
 namespace ujson {
@@ -172,11 +175,21 @@ namespace ujson {
     //--------------------------------------------------------------------------
     // Check if valid array index, defined as [0]|[1-9][0-9]*
     //--------------------------------------------------------------------------
-    static bool is_array_index (const std::string& str)
+    bool parse_array_index (const std::string& token, size_t& index) noexcept
     {
-        static std::regex re ("[0]|[1-9][0-9]*", std::regex::ECMAScript);
-        std::cmatch cm;
-        return std::regex_match (str.c_str(), cm, re);
+        if (token.empty() || (token[0]=='0' && token.size()>1))
+            return false;
+        size_t n = 0;
+        for (auto ch : token) {
+            if (ch < '0' || ch > '9')
+                return false;
+            size_t digit = ch - '0';
+            if (n > (std::numeric_limits<size_t>::max() - digit) / 10)
+                return false; // Overflow
+            n = n * 10 + digit;
+        }
+        index = n;
+        return true;
     }
 
 
@@ -184,90 +197,71 @@ namespace ujson {
     //--------------------------------------------------------------------------
     jvalue& find_jvalue (jvalue& instance, const jpointer& pointer)
     {
-        if (pointer.empty()) {
-            // An empty pointer points to the root of the instance
-            return instance;
+        // Each thread has its own invalid value to return
+        // so that other threads can't reset it while in use.
+        thread_local jvalue not_found (j_invalid);
+
+        // Walk the path with non-const accessors, the value may be changed
+        jvalue* value = &instance;
+        for (auto& token : pointer) {
+            size_t index;
+            if (value->type() == j_object)
+                value = member_to_change (*value, token);
+            else if (value->type() == j_array && parse_array_index(token, index))
+                value = item_to_change (*value, index);
+            else
+                value = nullptr;
+            if (value == nullptr) {
+                not_found.type (j_invalid);
+                return not_found;
+            }
         }
+        return *value;
+    }
 
-        try {
-            jvalue* value = &instance;
-            for (auto& token : pointer) {
-                jvalue* tmp = &invalid_jvalue;
-                if (value->type() == j_object) {
-                    tmp = &(value->get(token));
-                }else if (value->type() == j_array && is_array_index(token)) {
-                    tmp = &((*value)[stol(token)]);
-                }
-                value = tmp;
-                if (!value->valid()) {
-                    invalid_jvalue.type (j_invalid);
-                    break;
-                }
+
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    const jvalue& find_jvalue (const jvalue& instance, const jpointer& pointer)
+    {
+        static const jvalue not_found (j_invalid);
+
+        const jvalue* value = &instance;
+        for (auto& token : pointer) {
+            size_t index;
+            if (value->type() == j_object) {
+                value = &(value->get(token));
+            }else if (value->type() == j_array && parse_array_index(token, index)) {
+                auto& array = value->array ();
+                if (index >= array.size())
+                    return not_found;
+                value = &array[index];
+            }else{
+                return not_found;
             }
-            return *value;
-        }catch (...) {
-            invalid_jvalue.type (j_invalid);
-            return invalid_jvalue;
+            if (!value->valid())
+                return not_found;
         }
+        return *value;
     }
 
 
     //--------------------------------------------------------------------------
-    // Assumes ch is in range [0-9a-zA-Z]
     //--------------------------------------------------------------------------
-    static unsigned char ch_to_hex (unsigned char ch)
+    std::string escape (const std::string& in, bool escape_slash)
     {
-        if (ch <= '9')
-            return ch - '0';
-        else
-            return (ch|0x20) - 'W'; // Set lowercase and subtract ('a'-10)
+        return escape (std::string_view(in.c_str(), in.size()), escape_slash);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    std::string escape (const std::string& in, bool escape_slash)
+    std::string escape (const std::string_view& in, bool escape_slash)
     {
-        static const char* hex = "0123456789abcdef";
         std::string result;
-        for (unsigned char ch : in) {
-            if (ch<0x20 || ch=='"' || (escape_slash?ch=='/':false) || ch=='\\') {
-                switch (ch) {
-                case 0x08: // backspace
-                    result.append ("\\b");
-                    break;
-                case 0x09: // tab
-                    result.append ("\\t");
-                    break;
-                case 0x0a: // newline
-                    result.append ("\\n");
-                    break;
-                case 0x0c: // formfeed
-                    result.append ("\\f");
-                    break;
-                case 0x0d: // return
-                    result.append ("\\r");
-                    break;
-                case 0x22: // double quote
-                    result.append ("\\\"");
-                    break;
-                case 0x2f: // slash
-                    result.append ("\\/");
-                    break;
-                case 0x5c: // backslash
-                    result.append ("\\\\");
-                    break;
-                default:
-                    if (ch < 0x10)
-                        result.append ("\\u000");
-                    else
-                        result.append ("\\u001");
-                    result.push_back (hex[ch & 0x0f]);
-                }
-            }else{
-                result.push_back (ch);
-            }
-        }
+        jwriter out (result);
+        out.write_escaped (in, escape_slash);
+        out.flush ();
         return result;
     }
 
@@ -301,460 +295,694 @@ namespace ujson {
     std::string unescape (const std::string_view& in)
     {
         std::string result;
-        std::u16string u16_str;
+        unescape_append (in, result);
+        return result;
+    }
+
 
-        auto pos = std::find (in.begin(), in.end(), '\\');
-        if (pos == in.end())
-            return std::string (in);
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    [[noreturn]] static void invalid_escape ()
+    {
+        throw std::invalid_argument ("Invalid JSON escape sequence");
+    }
 
-        result.insert (result.end(), in.begin(), pos);
 
-        // Check if string ends with a '\\'
-        if (pos++ != in.end()  &&  pos == in.end())
-            throw std::invalid_argument ("Invalid JSON escape sequence");
+    //--------------------------------------------------------------------------
+    // The value of each hexadecimal digit, or -1 if not a digit.
+    // A table avoids unpredictable branches on digits and letters.
+    //--------------------------------------------------------------------------
+    static constexpr std::array<signed char, 256> hex_table = [] () {
+        std::array<signed char, 256> table {};
+        for (auto& value : table)
+            value = -1;
+        for (int i=0; i<10; ++i)
+            table['0' + i] = (signed char) i;
+        for (int i=0; i<6; ++i)
+            table['a' + i] = table['A' + i] = (signed char) (10 + i);
+        return table;
+    } ();
+
+
+    //--------------------------------------------------------------------------
+    // Read the four hexadecimal digits of a \uXXXX escape sequence.
+    //--------------------------------------------------------------------------
+    static inline char32_t read_u16 (const char*& pos, const char* const end)
+    {
+        if (end - pos < 4)
+            invalid_escape ();
+        int d0 = hex_table[(unsigned char)pos[0]];
+        int d1 = hex_table[(unsigned char)pos[1]];
+        int d2 = hex_table[(unsigned char)pos[2]];
+        int d3 = hex_table[(unsigned char)pos[3]];
+        if ((d0 | d1 | d2 | d3) < 0)
+            invalid_escape ();
+        pos += 4;
+        return (char32_t) ((d0 << 12) | (d1 << 8) | (d2 << 4) | d3);
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Decode a \uXXXX escape sequence, or a surrogate pair of two
+    // of them, and write the character as UTF-8 to 'dst'.
+    // 'pos' is the position after the 'u'.
+    //--------------------------------------------------------------------------
+    static inline void unescape_u16 (const char*& pos, const char* const end, char*& dst)
+    {
+        char32_t code_point = read_u16 (pos, end);
+        if (code_point >= 0xD800  &&  code_point <= 0xDFFF) {
+            // Must be a high surrogate followed by a low surrogate
+            if (code_point > 0xDBFF  ||  end - pos < 2  ||  pos[0] != '\\'  ||  pos[1] != 'u')
+                invalid_escape ();
+            pos += 2;
+            char32_t low = read_u16 (pos, end);
+            if (low < 0xDC00  ||  low > 0xDFFF)
+                invalid_escape ();
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+        }
+
+        if (code_point <= 0x7F) {
+            *dst++ = (char) code_point;
+        }
+        else if (code_point <= 0x07FF) {
+            *dst++ = (char) (0xC0 | (code_point >> 6));
+            *dst++ = (char) (0x80 | (code_point & 0x3F));
+        }
+        else if (code_point <= 0xFFFF) {
+            *dst++ = (char) (0xE0 | (code_point >> 12));
+            *dst++ = (char) (0x80 | ((code_point >> 6) & 0x3F));
+            *dst++ = (char) (0x80 | (code_point & 0x3F));
+        }
+        else {
+            *dst++ = (char) (0xF0 | (code_point >> 18));
+            *dst++ = (char) (0x80 | ((code_point >> 12) & 0x3F));
+            *dst++ = (char) (0x80 | ((code_point >> 6) & 0x3F));
+            *dst++ = (char) (0x80 | (code_point & 0x3F));
+        }
+    }
 
-        while (pos != in.end()) {
-            switch (*pos) {
+
+    //--------------------------------------------------------------------------
+    // Unescape a string in one pass. An unescaped string is never
+    // longer than the escaped string, so room for the input is made
+    // in 'out', and the unused part is removed when done. Characters
+    // between escape sequences are copied in one piece.
+    //--------------------------------------------------------------------------
+    void unescape_append (const std::string_view& in, std::string& out)
+    {
+        const char* pos = in.data ();
+        const char* const end = pos + in.size ();
+
+        const size_t start = out.size ();
+        out.resize (start + in.size());
+        char* const dst_start = out.data ();
+        char* dst = dst_start + start;
+
+        while (pos < end) {
+            if (*pos != '\\') {
+                auto next = reinterpret_cast<const char*> (memchr(pos, '\\', end - pos));
+                if (!next)
+                    next = end;
+                memcpy (dst, pos, next - pos);
+                dst += next - pos;
+                if (next == end)
+                    break;
+                pos = next;
+            }
+
+            if (++pos == end)
+                invalid_escape ();
+
+            switch (*pos++) {
             case '"':
-                result.push_back ('"');
-                ++pos;
+                *dst++ = '"';
                 break;
-
             case '\\':
-                result.push_back ('\\');
-                ++pos;
+                *dst++ = '\\';
                 break;
-
             case '/':
-                result.push_back ('/');
-                ++pos;
+                *dst++ = '/';
                 break;
-
             case 'b':
-                result.push_back ('\b');
-                ++pos;
+                *dst++ = '\b';
                 break;
-
             case 'f':
-                result.push_back ('\f');
-                ++pos;
+                *dst++ = '\f';
                 break;
-
             case 'n':
-                result.push_back ('\n');
-                ++pos;
+                *dst++ = '\n';
                 break;
-
             case 'r':
-                result.push_back ('\r');
-                ++pos;
+                *dst++ = '\r';
                 break;
-
             case 't':
-                result.push_back ('\t');
-                ++pos;
+                *dst++ = '\t';
                 break;
-
             case 'u':
-                // Handle all consecutive \uxxxx as one UTF-16 string and convert it to UTF-8
-                //
-                u16_str.clear ();
-                while (pos!=in.end()  &&  *pos == 'u') {
-                    ++pos;
-                    char16_t u16 = 0;
-                    int num_digits;
-
-                    for (num_digits=0; num_digits<4 && pos!=in.end(); ++num_digits, ++pos) {
-                        u16 <<= 4;
-                        u16 |= ch_to_hex (*pos);
-                    }
-                    if (num_digits >= 4) {
-                        u16_str.push_back (u16);
-                    }else{
-                        throw std::invalid_argument ("Invalid JSON escape sequence");
-                    }
-                    if (pos!=in.end()  &&  *pos == '\\') {
-                        auto next = pos + 1;
-                        if (*next == 'u')
-                            ++pos;
-                    }
-                }
-                try {
-                    result.append (utf16_to_utf8(u16_str));
-                }catch (...) {
-                    throw std::invalid_argument ("Invalid JSON escape sequence");
-                }
+                unescape_u16 (pos, end, dst);
                 break;
-
             default:
-                throw std::invalid_argument ("Invalid JSON escape sequence");
-                break;
+                invalid_escape ();
             }
-
-            if (pos == in.end())
-                break;
-            auto next = std::find (pos, in.end(), '\\');
-            result.insert (result.end(), pos, next);
-            if (next == in.end())
-                break;
-            pos = next;
-            // Check if string ends with a '\\'
-            if (pos++ != in.end()  &&  pos == in.end())
-                throw std::invalid_argument ("Invalid JSON escape sequence");
         }
-        return result;
+        out.resize (dst - dst_start);
     }
 
 
     //--------------------------------------------------------------------------
+    // Applies JSON patch operations to an instance.
+    // Each pointer in an operation is parsed once, and the containers
+    // on the path of the last resolved pointer are kept, so that
+    // operations on values in the same container, or in containers
+    // sharing a path, don't walk the instance from the root again.
+    //
+    // If created as atomic, the walker keeps an undo log with an entry
+    // for each change made to the instance. Values replaced or removed
+    // are moved to the log, not copied, and the changes can be undone
+    // in reverse order by rollback().
     //--------------------------------------------------------------------------
-    struct pointer_info_t {
-        jvalue* instance;  // Instance containing the item pointed to
-        jvalue* container; // Conainter of the item ponted to. If nullptr: root instance, or invalid pointer
-        jvalue* item;      // Item pointed io. If nullptr, no such item
-        std::string path;  // Path to the container of the item.
-        std::string name;  // Name of the item pointed to.
-        ssize_t index;     // Index of the item pointed to, if container is an array, else -1
-        bool added;        // An item was added.
-        pointer_info_t () {
-            reset ();
-        }
-        void reset () {
-            instance = container = item = nullptr;
-            path = name = "";
-            index = -1;
-            added = false;
-        }
+    class patch_walker {
+    public:
+        patch_walker (jvalue& instance, const bool atomic=false)
+            : values {&instance},
+              recording {atomic}
+            {
+            }
+
+        jpatch_result apply (jvalue& op);
+        void rollback () {rollback(0);}
+
+    private:
+        // The location of a value pointed to by a JSON pointer
+        struct location_t {
+            jvalue* parent {nullptr}; // nullptr: the root
+            jvalue* item {nullptr};   // nullptr: no such value
+            std::string_view name;    // Last token of the pointer
+            size_t index {0};         // Index of the item if the parent is an array
+            bool is_index {false};    // The last token is an array index, or "-"
+        };
+
+        // An entry in the undo log
+        struct undo_t {
+            enum action_t {
+                undo_root,   // Put back the root value
+                undo_set,    // Put back a replaced value
+                undo_erase,  // Erase an added value
+                undo_insert, // Insert a removed value, at member position 'index' in an object
+            };
+            action_t action;
+            std::vector<std::string> parent; // Path to the modified container
+            std::string name;                // Member name if the container is an object
+            size_t index;                    // Array index, or object member position
+            jvalue value;                    // The replaced or removed value
+            bool moved;                      // undo_insert: The value was moved elsewhere in
+                                             // the instance, and is taken back by the next
+                                             // entry that is undone.
+        };
+
+        jvalue* find_parent (const jpointer& pointer);
+        bool locate (const jpointer& pointer, location_t& loc);
+
+        jpatch_result add (const jpointer& pointer, jvalue& value);
+        jpatch_result remove (const jpointer& pointer);
+        jpatch_result replace (const jpointer& pointer, const jvalue& value);
+        jpatch_result move (const jpointer& from, const jpointer& pointer);
+        jpatch_result copy (const jpointer& from, const jpointer& pointer);
+        jpatch_result test (const jpointer& pointer, const jvalue& value);
+
+        void record (const undo_t::action_t action,
+                     const std::string_view name,
+                     const size_t index,
+                     jvalue&& value = jvalue(),
+                     const bool moved = false);
+        void remove_members (jvalue& parent, const std::string& name, const jvalue* moved);
+        void rollback (const size_t mark);
+
+        // values[i] is the value pointed to by the first i tokens
+        // in 'tokens', values[0] is the root of the instance.
+        std::vector<jvalue*> values;
+        std::vector<std::string> tokens;
+
+        bool recording;
+        std::vector<undo_t> undo_log;
+        jvalue carry; // The value taken out by the last undone entry
     };
-    static jpatch_result get_pointer_info (pointer_info_t& pi,
-                                           jvalue& instance,
-                                           const std::string& pointer,
-                                           bool add=false)
-    {
-        pi.reset ();
-        pi.instance = &instance;
-        jpatch_result retval = patch_ok;
 
-        if (pointer.empty()) {
-            pi.item = pi.instance;
-            return patch_ok;
+
+    //--------------------------------------------------------------------------
+    // Get a member of an object or an item in an array, nullptr if not found.
+    //--------------------------------------------------------------------------
+    static jvalue* find_child (jvalue* value, const std::string& token)
+    {
+        if (value->type() == j_object) {
+            return member_to_change (*value, token);
         }
-        if (pointer[0] != '/') {
-            pi.reset ();
-            return patch_invalid;
+        else if (value->type() == j_array) {
+            size_t index;
+            if (parse_array_index(token, index))
+                return item_to_change (*value, index);
         }
+        return nullptr;
+    }
 
-        auto last_sep_pos = pointer.find_last_of ("/");
-        pi.path = pointer.substr (0, last_sep_pos);
-        pi.name = pointer.substr (last_sep_pos+1);
-
-        pi.container = &find_jvalue (instance, pi.path);
-        if (pi.container->invalid()) {
-            pi.reset ();
-            return patch_noent;
-        }
 
-        pi.item = &find_jvalue (instance, pointer);
-        if (!pi.item->valid()) {
-            pi.item = nullptr;
-            retval = patch_noent;
-            if (pi.container->type() == j_array) {
-                if (pi.name=="-") {
-                    retval = patch_ok;
-                    pi.index = pi.container->size ();
-                    if (add) {
-                        pi.item = &pi.container->append(jvalue(j_null));
-                        pi.added = true;
-                        retval = patch_ok;
-                    }
-                }else if (add) {
-                    if (is_array_index(pi.name)) {
-                        ssize_t i = stol (pi.name);
-                        if (i == (ssize_t)pi.container->size()) {
-                            pi.index = i;
-                            pi.name.clear ();
-                            pi.item = &pi.container->append(jvalue(j_null));
-                            pi.added = true;
-                            retval = patch_ok;
-                        }
-                    }
-                }
-            }else if (add) {
-                // j_object
-                pi.item = &pi.container->add(pi.name, jvalue(j_null));
-                pi.added = true;
-                retval = patch_ok;
-            }
+    //--------------------------------------------------------------------------
+    // Find the container of the value pointed to by a non-empty pointer.
+    //--------------------------------------------------------------------------
+    jvalue* patch_walker::find_parent (const jpointer& pointer)
+    {
+        // Keep the values on the common path of the previous pointer
+        size_t depth = 0;
+        auto token = pointer.begin ();
+        auto parent_size = pointer.size() - 1;
+        while (depth < parent_size  &&  depth < tokens.size()  &&  *token == tokens[depth]) {
+            ++depth;
+            ++token;
         }
-        else if (pi.container->type() == j_array) {
-            pi.index = stol (pi.name);
-            pi.name.clear ();
+        values.resize (depth + 1);
+        tokens.resize (depth);
+
+        // Walk the rest of the path
+        for (; depth < parent_size; ++depth, ++token) {
+            jvalue* child = find_child (values.back(), *token);
+            if (child == nullptr)
+                return nullptr;
+            tokens.push_back (*token);
+            values.push_back (child);
         }
-
-        if (retval != patch_ok)
-            pi.reset ();
-
-        return retval;
+        return values.back ();
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_add_impl (jvalue& instance,
-                                                   const std::string& pointer,
-                                                   jvalue& value)
+    bool patch_walker::locate (const jpointer& pointer, location_t& loc)
     {
+        loc = location_t ();
         if (pointer.empty()) {
-            instance = value;
-            return patch_ok;
+            // The root may be modified, forget the path
+            values.resize (1);
+            tokens.clear ();
+            loc.item = values.front ();
+            return true;
         }
+        loc.parent = find_parent (pointer);
+        if (loc.parent == nullptr)
+            return false;
 
-        pointer_info_t pi;
-        auto retval = get_pointer_info (pi, instance, pointer, true);
-        if (retval == patch_ok) {
-            if (pi.container->type()==j_array && pi.added==false) {
-                auto& a = pi.container->array ();
-                a.insert (a.begin() + pi.index, value);
+        loc.name = pointer.back ();
+        if (loc.parent->type() == j_object) {
+            loc.item = member_to_change (*loc.parent, pointer.back());
+        }
+        else if (loc.parent->type() == j_array) {
+            if (loc.name == "-") {
+                loc.is_index = true;
+                loc.index = loc.parent->size ();
             }else{
-                *pi.item = value;
+                loc.is_index = parse_array_index (pointer.back(), loc.index);
+                if (loc.is_index  &&  loc.index < loc.parent->size())
+                    loc.item = &loc.parent->array()[loc.index];
             }
         }
-        return retval;
+        return true;
     }
 
 
     //--------------------------------------------------------------------------
+    // Add an entry to the undo log, for a change in
+    // the container last located, or in the root.
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_add (jvalue& instance,
-                                              const std::string& pointer,
-                                              jvalue& op)
+    void patch_walker::record (const undo_t::action_t action,
+                               const std::string_view name,
+                               const size_t index,
+                               jvalue&& value,
+                               const bool moved)
     {
-        auto& value = op.get_unique ("value");
-        if (value.valid())
-            return patch_operation_add_impl (instance, pointer, value);
-        else
-            return patch_invalid;
+        undo_log.push_back ({action,
+                             action==undo_t::undo_root ? std::vector<std::string>() : tokens,
+                             std::string(name),
+                             index,
+                             std::move(value),
+                             moved});
     }
 
 
     //--------------------------------------------------------------------------
+    // Remove all members with a specific name from an object. If recording
+    // changes, the members are logged with their positions, the last first,
+    // so they are inserted in the same order when undone. 'moved' is the
+    // member value that has already been moved elsewhere, if any.
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_remove (jvalue& instance,
-                                                 const std::string& pointer,
-                                                 jvalue& op)
+    void patch_walker::remove_members (jvalue& parent, const std::string& name, const jvalue* moved)
     {
-        if (pointer.empty()) {
-            instance.type (j_null);
-            return patch_ok;
+        if (!recording) {
+            parent.remove (name);
+            return;
         }
 
-        pointer_info_t pi;
-        jpatch_result retval = get_pointer_info (pi, instance, pointer);
-        if (retval != patch_ok)
-            return retval;
-
-        retval = patch_noent;
-        if (pi.item) {
-            if (pi.container->type() == j_object)
-                pi.container->remove (pi.name);
+        auto& obj = parent.obj ();
+        std::vector<std::pair<json_object::iterator, size_t>> members;
+        size_t pos = 0;
+        for (auto i=obj.begin(); i!=obj.end(); ++i, ++pos) {
+            if (i->first == name)
+                members.emplace_back (i, pos);
+        }
+        for (auto m=members.rbegin(); m!=members.rend(); ++m) {
+            if (&m->first->second == moved)
+                record (undo_t::undo_insert, name, m->second, jvalue(), true);
             else
-                pi.container->remove (pi.index);
-            retval = patch_ok;
+                record (undo_t::undo_insert, name, m->second, std::move(m->first->second));
+            obj.erase (m->first);
         }
-        else if (pi.container &&
-                 pi.container->type() == j_array &&
-                 pi.name == "-")
-        {
-            if (pi.container->size() > 0) {
-                pi.container->array().pop_back ();
-                retval = patch_ok;
+    }
+
+
+    //--------------------------------------------------------------------------
+    // Undo the changes in the undo log, back to a specific entry.
+    //--------------------------------------------------------------------------
+    void patch_walker::rollback (const size_t mark)
+    {
+        // The entries are undone in reverse order, so each entry sees
+        // the instance as it was right after the change was made.
+        values.resize (1);
+        tokens.clear ();
+        while (undo_log.size() > mark) {
+            auto& entry = undo_log.back ();
+
+            jvalue* parent = values.front ();
+            for (auto& token : entry.parent)
+                parent = find_child (parent, token);
+
+            switch (entry.action) {
+            case undo_t::undo_root:
+                carry = std::move (*parent);
+                *parent = std::move (entry.value);
+                break;
+
+            case undo_t::undo_set:
+                if (parent->type() == j_object) {
+                    auto& member = parent->get (entry.name);
+                    carry = std::move (member);
+                    member = std::move (entry.value);
+                }else{
+                    auto& item = parent->array()[entry.index];
+                    carry = std::move (item);
+                    item = std::move (entry.value);
+                }
+                break;
+
+            case undo_t::undo_erase:
+                if (parent->type() == j_object) {
+                    carry = std::move (parent->get(entry.name));
+                    parent->remove (entry.name);
+                }else{
+                    auto& a = parent->array ();
+                    carry = std::move (a[entry.index]);
+                    a.erase (a.begin() + entry.index);
+                }
+                break;
+
+            case undo_t::undo_insert:
+                {
+                    jvalue value (std::move(entry.moved ? carry : entry.value));
+                    if (parent->type() == j_object) {
+                        auto& obj = parent->obj ();
+                        auto pos = obj.begin ();
+                        std::advance (pos, entry.index);
+#if UJSON_INTERNED_KEYS
+                        obj.emplace (pos, jkey::intern(entry.name), std::move(value));
+#else
+                        obj.emplace (pos, entry.name, std::move(value));
+#endif
+                    }else{
+                        auto& a = parent->array ();
+                        a.insert (a.begin() + entry.index, std::move(value));
+                    }
+                }
+                break;
             }
+            undo_log.pop_back ();
         }
-
-        return retval;
+        carry.type (j_invalid);
     }
 
 
     //--------------------------------------------------------------------------
+    // The value is moved to the instance on success.
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_replace (jvalue& instance,
-                                                  const std::string& pointer,
-                                                  jvalue& op)
+    jpatch_result patch_walker::add (const jpointer& pointer, jvalue& value)
     {
-        auto& value = op.get_unique ("value");
-        if (!value.valid())
-            return patch_invalid;
-
-        pointer_info_t pi;
-        auto retval = get_pointer_info (pi, instance, pointer);
-        if (retval != patch_ok)
-            return retval;
+        location_t loc;
+        if (!locate(pointer, loc))
+            return patch_noent;
 
-        if (pi.item) {
-            *pi.item = value;
+        if (loc.parent == nullptr) {
+            if (recording)
+                record (undo_t::undo_root, {}, 0, std::move(*loc.item));
+            *loc.item = std::move (value);
         }
-        else if (pi.container->type() == j_array) {
-            if (pi.container->size() > 0) {
-                (*pi.container)[pi.container->size()-1] = value;
-            }else{
-                retval = patch_noent;
+        else if (loc.parent->type() == j_object) {
+            if (recording) {
+                if (loc.item)
+                    record (undo_t::undo_set, loc.name, 0, std::move(*loc.item));
+                else
+                    record (undo_t::undo_erase, loc.name, 0);
             }
+            if (loc.item)
+                *loc.item = std::move (value);
+            else
+                loc.parent->add (pointer.back(), std::move(value));
+        }
+        else if (loc.parent->type() != j_array) {
+            // Not a container
+            return patch_invalid;
         }
         else {
-            *pi.container = value;
+            if (!loc.is_index  ||  loc.index > loc.parent->size())
+                return patch_noent;
+            if (recording)
+                record (undo_t::undo_erase, {}, loc.index);
+            auto& a = loc.parent->array ();
+            a.insert (a.begin() + loc.index, std::move(value));
         }
-        return retval;
+        return patch_ok;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_replace (jvalue& instance,
-                                                  const std::string& pointer,
-                                                  jvalue&& value)
+    jpatch_result patch_walker::remove (const jpointer& pointer)
     {
-        pointer_info_t pi;
-        auto retval = get_pointer_info (pi, instance, pointer);
-        if (retval != patch_ok)
-            return retval;
+        location_t loc;
+        if (!locate(pointer, loc))
+            return patch_noent;
 
-        if (pi.item) {
-            *pi.item = std::forward<jvalue&&> (value);
+        if (loc.parent == nullptr) {
+            if (recording)
+                record (undo_t::undo_root, {}, 0, std::move(*loc.item));
+            loc.item->type (j_null);
         }
-        else if (pi.container->type() == j_array) {
-            if (pi.container->size() > 0) {
-                (*pi.container)[pi.container->size()-1] = std::forward<jvalue&&> (value);
-            }else{
-                retval = patch_noent;
-            }
+        else if (loc.parent->type() == j_object) {
+            if (!loc.item)
+                return patch_noent;
+            remove_members (*loc.parent, pointer.back(), nullptr);
+        }
+        else if (loc.parent->type() != j_array) {
+            return patch_noent;
         }
         else {
-            *pi.container = std::forward<jvalue&&> (value);
+            if (!loc.item) {
+                if (loc.name != "-"  ||  loc.parent->size() == 0)
+                    return patch_noent;
+                loc.index = loc.parent->size() - 1;
+            }
+            auto& a = loc.parent->array ();
+            if (recording)
+                record (undo_t::undo_insert, {}, loc.index, std::move(a[loc.index]));
+            a.erase (a.begin() + loc.index);
         }
-        return retval;
+        return patch_ok;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_move (jvalue& instance,
-                                               const std::string& dst_pointer,
-                                               jvalue& op)
+    jpatch_result patch_walker::replace (const jpointer& pointer, const jvalue& value)
     {
-        auto& from = op.get_unique ("from");
-        if (from.type() != j_string) {
-            return patch_invalid;
+        location_t loc;
+        if (!locate(pointer, loc))
+            return patch_noent;
+
+        if (!loc.item) {
+            if (loc.name != "-"  ||  loc.parent->type() != j_array  ||  loc.parent->size() == 0)
+                return patch_noent;
+            loc.index = loc.parent->size() - 1;
+            loc.item = &loc.parent->array().back ();
+        }
+        if (recording) {
+            if (loc.parent == nullptr)
+                record (undo_t::undo_root, {}, 0, std::move(*loc.item));
+            else
+                record (undo_t::undo_set, loc.name, loc.index, std::move(*loc.item));
         }
-        auto& src_pointer = from.str ();
+        *loc.item = value;
+        return patch_ok;
+    }
 
-        if (dst_pointer.find(src_pointer)==0) {
-            if (src_pointer.size() == dst_pointer.size()) {
-                return patch_ok;
+
+    //--------------------------------------------------------------------------
+    // The value is moved, not copied. If it can't be added, it is put
+    // back where it was found. The removal is always recorded, also when
+    // not atomic, so the removed members are put back at their positions.
+    //--------------------------------------------------------------------------
+    jpatch_result patch_walker::move (const jpointer& from, const jpointer& pointer)
+    {
+        // Check if 'from' is a prefix of 'pointer'
+        if (from.size() <= pointer.size()  &&
+            std::equal(from.begin(), from.end(), pointer.begin()))
+        {
+            if (from.size() == pointer.size()) {
+                location_t loc;
+                return locate(from, loc) && loc.item ? patch_ok : patch_noent;
             }
-            // Error - Move a contaner into one of its child entries
+            // Error - Move a container into one of its child entries
             return patch_invalid;
         }
 
+        // Check the destination before the value is taken out
+        auto dst_result = patch_ok;
+        if (!pointer.empty()) {
+            auto* dst_parent = find_parent (pointer);
+            if (dst_parent == nullptr)
+                dst_result = patch_noent;
+            else if (dst_parent->type() != j_object  &&  dst_parent->type() != j_array)
+                dst_result = patch_invalid;
+        }
 
-        pointer_info_t src_pi;
-        pointer_info_t dst_pi;
-        jpatch_result retval = patch_ok;
-        retval = get_pointer_info (src_pi, instance, src_pointer);
-        if (retval != patch_ok)
-            return retval;
-        retval = get_pointer_info (dst_pi, instance, dst_pointer, true);
-        if (retval != patch_ok)
-            return retval;
-
-        if (dst_pi.added)
-            retval = get_pointer_info (src_pi, instance, src_pointer);
-        if (retval != patch_ok)
-            return retval;
+        location_t src;
+        if (!locate(from, src) || !src.item)
+            return patch_noent;
+        if (dst_result != patch_ok)
+            return dst_result;
 
+        auto mark = undo_log.size ();
+        bool atomic = recording;
+        recording = true;
 
-        jvalue tmp (std::move(*src_pi.item));
-        src_pi.item->type (j_null);
+        jvalue value (std::move(*src.item));
+        if (src.parent->type() == j_object) {
+            remove_members (*src.parent, from.back(), src.item);
+        }else{
+            record (undo_t::undo_insert, {}, src.index, jvalue(), true);
+            src.parent->remove (src.index);
+        }
 
-        retval = patch_operation_remove (instance, src_pointer, op);
-        if (retval == patch_ok)
-            retval = patch_operation_replace (instance, dst_pointer, std::move(tmp));
+        auto retval = add (pointer, value);
+        if (retval != patch_ok) {
+            // Put the value back
+            carry = std::move (value);
+            rollback (mark);
+        }
+        else if (!atomic) {
+            undo_log.resize (mark);
+        }
+        recording = atomic;
         return retval;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_copy (jvalue& instance,
-                                               const std::string& dst_pointer,
-                                               jvalue& op)
+    jpatch_result patch_walker::copy (const jpointer& from, const jpointer& pointer)
     {
-        auto& from = op.get_unique ("from");
-        if (from.type() != j_string)
-            return patch_invalid;
-
-        const auto& src_pointer = from.str ();
-
-        pointer_info_t src_pi;
-        auto retval = get_pointer_info (src_pi, instance, src_pointer);
-        if (retval == patch_ok) {
-            jvalue copy (src_pi.item ? *src_pi.item : *src_pi.container);
-            retval = patch_operation_add_impl (instance, dst_pointer, copy);
-        }
-        return retval;
+        location_t src;
+        if (!locate(from, src) || !src.item)
+            return patch_noent;
+        jvalue value (*src.item);
+        return add (pointer, value);
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation_test (jvalue& instance,
-                                               const std::string& path,
-                                               jvalue& op)
+    jpatch_result patch_walker::test (const jpointer& pointer, const jvalue& value)
     {
-        auto& test_value = op.get_unique ("value");
-        if (!test_value.valid())
-            return patch_invalid;
-
-        jpatch_result retval = patch_ok;
-        auto& value = find_jvalue (instance, path);
-        if (!value.valid()) {
-            retval = patch_noent;
-        }else{
-            retval = value == test_value ? patch_ok : patch_fail;
-        }
-        return retval;
+        location_t loc;
+        if (!locate(pointer, loc) || !loc.item)
+            return patch_noent;
+        return *loc.item == value ? patch_ok : patch_fail;
     }
 
 
     //--------------------------------------------------------------------------
     //--------------------------------------------------------------------------
-    static jpatch_result patch_operation (jvalue& instance, jvalue& op)
+    jpatch_result patch_walker::apply (jvalue& op)
     {
-        using patch_op_cb = jpatch_result (*) (jvalue&, const std::string&, jvalue&);
-        static const std::map<const std::string, const patch_op_cb> patch_ops {{
-                {"add",     patch_operation_add},
-                {"copy",    patch_operation_copy},
-                {"move",    patch_operation_move},
-                {"remove",  patch_operation_remove},
-                {"replace", patch_operation_replace},
-                {"test",    patch_operation_test},
+        enum op_t {op_add, op_copy, op_move, op_remove, op_replace, op_test};
+        static const std::map<std::string, op_t, std::less<>> patch_ops {{
+                {"add",     op_add},
+                {"copy",    op_copy},
+                {"move",    op_move},
+                {"remove",  op_remove},
+                {"replace", op_replace},
+                {"test",    op_test},
             }};
 
         jpatch_result retval = patch_ok;
         try {
             // Get the patch operation and path
-            auto& op_type = op.get_unique("op").str ();
-            auto& path = op.get_unique("path").str ();
+            auto entry = patch_ops.find (op.get_unique("op").str());
+            if (entry == patch_ops.end())
+                return patch_invalid;
+            jpointer path (op.get_unique("path").str());
+
+            switch (entry->second) {
+            case op_add:
+            case op_replace:
+            case op_test:
+                {
+                    auto& value = op.get_unique ("value");
+                    if (!value.valid())
+                        return patch_invalid;
+                    if (entry->second == op_add) {
+                        jvalue copy (value);
+                        retval = add (path, copy);
+                    }
+                    else if (entry->second == op_replace) {
+                        retval = replace (path, value);
+                    }
+                    else {
+                        retval = test (path, value);
+                    }
+                }
+                break;
 
-            auto entry = patch_ops.find (op_type);
-            if (entry != patch_ops.end()) {
-                retval = entry->second (instance, path, op);
-            }else{
-                retval = patch_invalid;
+            case op_remove:
+                retval = remove (path);
+                break;
+
+            case op_move:
+            case op_copy:
+                {
+                    auto& from = op.get_unique ("from");
+                    if (from.type() != j_string)
+                        return patch_invalid;
+                    jpointer from_path (from.str());
+                    if (entry->second == op_move)
+                        retval = move (from_path, path);
+                    else
+                        retval = copy (from_path, path);
+                }
+                break;
             }
         }
         catch (json_type_error&) {
             retval = patch_invalid;
         }
+        catch (std::invalid_argument&) {
+            // Invalid JSON pointer
+            retval = patch_invalid;
+        }
         catch (...) {
             retval = patch_noent;
         }
@@ -787,16 +1015,16 @@ namespace ujson {
         std::pair<bool, std::vector<jpatch_result>> retval;
         retval.first = true;
 
-        //int successful_operations = 0;
+        patch_walker walker (instance);
         if (json_patch.type() == j_array) {
             for (auto& operation : json_patch.array()) {
-                auto result = patch_operation (instance, operation);
+                auto result = walker.apply (operation);
                 if (result != patch_ok)
                     retval.first = false;
                 retval.second.emplace_back (result);
             }
         }else{
-            auto result = patch_operation (instance, json_patch);
+            auto result = walker.apply (json_patch);
             if (result != patch_ok)
                 retval.first = false;
             retval.second.emplace_back (result);
@@ -806,4 +1034,39 @@ namespace ujson {
     }
 
 
+    //--------------------------------------------------------------------------
+    //--------------------------------------------------------------------------
+    std::pair<bool, std::vector<jpatch_result>> patch_atomic (jvalue& instance,
+                                                              jvalue& json_patch)
+    {
+        if (instance.invalid() || json_patch.invalid())
+            throw std::invalid_argument ("Invalid JSON instance");
+
+        std::pair<bool, std::vector<jpatch_result>> retval;
+        retval.first = true;
+
+        patch_walker walker (instance, true);
+        if (json_patch.type() == j_array) {
+            for (auto& operation : json_patch.array()) {
+                auto result = walker.apply (operation);
+                retval.second.emplace_back (result);
+                if (result != patch_ok) {
+                    retval.first = false;
+                    break;
+                }
+            }
+        }else{
+            auto result = walker.apply (json_patch);
+            retval.second.emplace_back (result);
+            if (result != patch_ok)
+                retval.first = false;
+        }
+
+        if (!retval.first)
+            walker.rollback ();
+
+        return retval;
+    }
+
+
 }
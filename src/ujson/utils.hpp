@@ -109,10 +109,15 @@ namespace ujson {
      * @return A reference to a ujson::jvalue in the JSON instance
      *         if the value was found by the JSON pointer.<br/>
      *         If the value can't be found, a reference
-     *         to a static invalid jvalue is returned
+     *         to a thread local invalid jvalue is returned
      *         (a jvalue of type ujson::j_invalid). Do not
      *         modify this value since it will be reset to
-     *         an invalid state at any time by libujson.
+     *         an invalid state by the next failed lookup
+     *         in the same thread.<br/>
+     *         The objects and arrays on the path to the value
+     *         are unshared, and their cached hash values cleared
+     *         (see jvalue::share() and jvalue::cache_hash()),
+     *         so the value may be changed.
      * \par Exampe:
      * \code
      * auto& item = ujson::find_jvalue (instance, "/pointer/to/value");
@@ -122,9 +127,23 @@ namespace ujson {
      *     std::cout << "Item not found" << std::endl;
      * \endcode
      * @see <a href=https://datatracker.ietf.org/doc/html/rfc6901 rel="noopener noreferrer" target="_blank">RFC 6901 - JavaScript Object Notation (JSON) Pointer</a>
+     * @see ujson::compiled_jpointer for repeated lookups of the same pointer.
      */
     jvalue& find_jvalue (jvalue& instance, const jpointer& pointer);
 
+    /**
+     * Find a specific value in a const JSON instance using a JSON pointer.
+     * Same as the non-const version, except that the JSON
+     * instance is not modified in any way.
+     * @param instance A JSON instance.
+     * @param pointer A JSON pointer.
+     * @return A const reference to a ujson::jvalue in the JSON instance
+     *         if the value was found by the JSON pointer.<br/>
+     *         If the value can't be found, a reference
+     *         to a static invalid jvalue is returned.
+     */
+    const jvalue& find_jvalue (const jvalue& instance, const jpointer& pointer);
+
     /**
      * Convert a string to a JSON escaped string.
      * Backslash(0x5c) \  is translated to: \\\\<br>
@@ -147,6 +166,16 @@ namespace ujson {
      */
     std::string escape (const std::string& in, bool escape_slash=false);
 
+    /**
+     * Convert a string to a JSON escaped string.
+     * @param in A string to be JSON escaped.
+     * @param escape_slash Set this parameter to \c true to
+     *                     also esacpe '/' characters.
+     * @return A JSON escaped string.
+     * @see escape(const std::string&, bool)
+     */
+    std::string escape (const std::string_view& in, bool escape_slash=false);
+
     /**
      * Convert a JSON escaped string to an unescaped string.
      * @param in An escaped string.
@@ -252,6 +281,34 @@ namespace ujson {
                                                        jvalue& json_patch);
 
 
+    /**
+     * Patch a JSON instance in place, all or nothing.
+     * The patch operations are applied in order until one of them fails.
+     * If an operation fails, all operations already applied are undone,
+     * and the instance is left as it was before the call.
+     * <br/>
+     * Instead of copying the instance before patching it, an undo log
+     * is kept while the patch is applied. Values that are replaced or
+     * removed by the patch are moved to the log, not copied, so the extra
+     * memory needed depends on the size of the patch, not on the size of
+     * the instance.
+     * @param instance A JSON instance to patch.
+     * @param json_patch A JSON patch definition as described in RFC 6902.
+     * @return A pair where the first entry is a boolean that is
+     *         <code>true</code> if <em>all</em> patches where
+     *         successfully applied. And the second entry is a
+     *         vector with a result for each patch operation that was
+     *         applied. If not successful, the last result is that of
+     *         the failed operation, and the operations after it are
+     *         not tried.
+     * @throw std::invalid_argument If any parameter is an invalid JSON value
+     *                              (of type ujson::j_invalid).
+     * @see <a href=https://datatracker.ietf.org/doc/html/rfc6902 rel="noopener noreferrer" target="_blank">RFC 6902 - JavaScript Object Notation (JSON) Patch</a>
+     */
+    std::pair<bool, std::vector<jpatch_result>> patch_atomic (jvalue& instance,
+                                                              jvalue& json_patch);
+
+
 }
 
 #endif
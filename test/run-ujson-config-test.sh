@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+#
+# This file is part of ujson.
+#
+# ujson is free software; you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published
+# by the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <http://www.gnu.org/licenses/>.
+#
+
+SRC_DIR=$(dirname $(dirname $(readlink -f "$0")))
+BUILD_BASE_DIR=`pwd`/build-config-test
+
+#
+# Each configuration is a name followed by its cmake options.
+# The storage of JSON objects changes when references to object
+# members are invalidated, so all tests are run in each of them.
+#
+CONFIGURATIONS="
+default:
+flat-objects:-DUSE_FLAT_OBJECTS=ON
+interned-keys:-DINTERNED_KEYS=ON
+flat-objects-interned-keys:-DUSE_FLAT_OBJECTS=ON -DINTERNED_KEYS=ON
+unsynchronized-objects:-DUNSYNCHRONIZED_OBJECTS=ON
+"
+
+if [ "$1" = "-c" -o "$1" = "--clean" ]; then
+    echo "# "
+    echo "# Removing build directory $BUILD_BASE_DIR"
+    echo "# "
+    rm -rf $BUILD_BASE_DIR
+    exit 0
+elif [ "$1" = "-h" -o "$1" = "--help" ]; then
+    echo ""
+    echo "Usage: `basename $0` [OPTION]"
+    echo "    Build libujson and its test applications in each configuration of"
+    echo "    JSON object storage, and run the local tests with ctest in each build."
+    echo "    Source directory is '$SRC_DIR'."
+    echo "    Builds are made in directory '$BUILD_BASE_DIR'."
+    echo ""
+    echo "    Configurations:"
+    echo "$CONFIGURATIONS" | sed -e '/^$/d' -e 's/^\([^:]*\):\(.*\)/        \1  \2/'
+    echo ""
+    echo "    Options:"
+    echo "        -c,--clean  Erase the build directory and exit"
+    echo "        -h,--help   Print this help and exit"
+    echo ""
+    exit 0
+fi
+
+JOBS=`nproc 2>/dev/null || echo 1`
+FAILED=""
+
+for CONFIG in $(echo "$CONFIGURATIONS" | sed -e '/^$/d' -e 's/:.*//'); do
+    OPTIONS=$(echo "$CONFIGURATIONS" | sed -n "s/^$CONFIG://p")
+    BUILD_DIR=$BUILD_BASE_DIR/$CONFIG
+
+    echo "# "
+    echo "# Configuration '$CONFIG': $OPTIONS"
+    echo "# "
+    if ! cmake -S $SRC_DIR -B $BUILD_DIR -DBUILD_TESTS=ON -DBUILD_UTILS=OFF -DBUILD_DOC=OFF $OPTIONS >/dev/null  ||
+       ! cmake --build $BUILD_DIR -j$JOBS  ||
+       ! ctest --test-dir $BUILD_DIR --output-on-failure
+    then
+        FAILED="$FAILED $CONFIG"
+    fi
+done
+
+if [ -n "$FAILED" ]; then
+    echo "# "
+    echo "# Error: Tests failed in configuration(s):$FAILED"
+    echo "# "
+    exit 1
+fi
+echo "# "
+echo "# All tests passed in all configurations"
+echo "# "
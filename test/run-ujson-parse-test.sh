@@ -110,6 +110,19 @@ if ! python3 run_tests.py $TEST_ARGS; then
 fi
 cd ../..
 
+#
+# Round trips of the accepted documents through binary formats
+#
+echo "# "
+echo "# Running: ${BASE_DIR}ujson-binary-test --skip-invalid $TEST_DATA_DIR/test_parsing/*.json" >&2
+echo "# "
+if ! ${BASE_DIR}ujson-binary-test --skip-invalid $TEST_DATA_DIR/test_parsing/*.json; then
+    echo "# "
+    echo "# Error: Binary format test failed"
+    echo "# "
+    exit 1
+fi
+
 mkdir -p $TEST_RESULT_DIR
 cp $TEST_DATA_DIR/results/* $TEST_RESULT_DIR/
 echo "# "
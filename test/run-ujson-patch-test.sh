@@ -46,6 +46,18 @@ FAILED_FILE=$TEST_RESULT_DIR/failed.json
 DISABLED_FILE=$TEST_RESULT_DIR/disabled.json
 INVALID_FILE=$TEST_RESULT_DIR/invalid.json
 
+DIFF_TEST_FILE=${BASE_DIR}ujson-diff-tests.json
+DIFF_PASSED_FILE=$TEST_RESULT_DIR/diff-passed.json
+DIFF_FAILED_FILE=$TEST_RESULT_DIR/diff-failed.json
+DIFF_DISABLED_FILE=$TEST_RESULT_DIR/diff-disabled.json
+DIFF_INVALID_FILE=$TEST_RESULT_DIR/diff-invalid.json
+
+LOCAL_TEST_FILE=${BASE_DIR}ujson-patch-tests.json
+LOCAL_PASSED_FILE=$TEST_RESULT_DIR/local-passed.json
+LOCAL_FAILED_FILE=$TEST_RESULT_DIR/local-failed.json
+LOCAL_DISABLED_FILE=$TEST_RESULT_DIR/local-disabled.json
+LOCAL_INVALID_FILE=$TEST_RESULT_DIR/local-invalid.json
+
 CLONE_URL=https://github.com/json-patch/json-patch-tests.git
 
 #
@@ -70,6 +82,8 @@ elif [ "$1" = "-h" -o "$1" = "--help" ]; then
     echo "    and installed in directory '$TEST_DATA_DIR'"
     echo ""
     echo "    Patch test file and result files are stored in directory '$TEST_RESULT_DIR'"
+    echo "    The local test files '$DIFF_TEST_FILE' and"
+    echo "    '$LOCAL_TEST_FILE' are run as well."
     echo ""
     echo "    Options:"
     echo "        -a,--allow-disabled    Perform a patch test even if it is marked as disabled."
@@ -125,3 +139,31 @@ if ! $TEST_APP -o -s $PASSED_FILE -f $FAILED_FILE -d $DISABLED_FILE -i $INVALID_
     echo "# "
     exit 1
 fi
+
+#
+# Run test application on the local tests of diff and patch round trips
+#
+echo "# "
+echo "# Run JSON diff and patch test application:"
+echo "# $TEST_APP -o -s $DIFF_PASSED_FILE -f $DIFF_FAILED_FILE -d $DIFF_DISABLED_FILE -i $DIFF_INVALID_FILE $DIFF_TEST_FILE"
+echo "# "
+if ! $TEST_APP -o -s $DIFF_PASSED_FILE -f $DIFF_FAILED_FILE -d $DIFF_DISABLED_FILE -i $DIFF_INVALID_FILE $DIFF_TEST_FILE; then
+    echo "# "
+    echo "# Error: $TEST_APP_NAME exited with error"
+    echo "# "
+    exit 1
+fi
+
+#
+# Run test application on the local patch tests
+#
+echo "# "
+echo "# Run local JSON patch test application:"
+echo "# $TEST_APP -o -s $LOCAL_PASSED_FILE -f $LOCAL_FAILED_FILE -d $LOCAL_DISABLED_FILE -i $LOCAL_INVALID_FILE $LOCAL_TEST_FILE"
+echo "# "
+if ! $TEST_APP -o -s $LOCAL_PASSED_FILE -f $LOCAL_FAILED_FILE -d $LOCAL_DISABLED_FILE -i $LOCAL_INVALID_FILE $LOCAL_TEST_FILE; then
+    echo "# "
+    echo "# Error: $TEST_APP_NAME exited with error"
+    echo "# "
+    exit 1
+fi
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <cstdlib>
+#include <ujson.hpp>
+#include "../utils/option-parser.hpp"
+
+
+using namespace std;
+namespace uj = ujson;
+
+static constexpr const char* prog_name = "ujson-binary-test";
+
+// Exit codes, combined if more than one kind of failure
+static constexpr int exit_not_parsed = 1;
+static constexpr int exit_cbor_failed = 2;
+static constexpr int exit_tape_failed = 4;
+
+// At most this many truncated or damaged copies
+// of encoded data are checked for each document.
+static constexpr size_t max_damaged = 512;
+
+
+struct appdata_t {
+    vector<string> filenames;
+    bool relaxed {false};
+    bool skip_invalid {false};
+    bool verbose {false};
+};
+
+
+static bool test_damaged (const string& filename,
+                          const char* format,
+                          const string& data,
+                          bool trailing_byte,
+                          initializer_list<unsigned char> bad_bytes,
+                          const function<void(const string&)>& decode);
+static bool test_cbor (const string& filename, const uj::jvalue& instance);
+static bool test_tape (const string& filename, const uj::jvalue& instance);
+static void print_usage_and_exit (ostream& out, int exit_code);
+static void parse_args (int argc, char* argv[], appdata_t& app);
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int main (int argc, char* argv[])
+{
+    appdata_t app;
+    parse_args (argc, argv, app);
+
+    int exit_code = 0;
+    size_t tested = 0;
+    uj::jparser parser;
+    for (auto& filename : app.filenames) {
+        auto instance = parser.parse_file (filename, !app.relaxed);
+        if (!instance.valid()) {
+            if (!app.skip_invalid) {
+                cerr << "Error: " << filename << ": " << parser.error() << endl;
+                exit_code |= exit_not_parsed;
+            }
+            continue;
+        }
+        ++tested;
+        if (!test_cbor(filename, instance))
+            exit_code |= exit_cbor_failed;
+        if (!test_tape(filename, instance))
+            exit_code |= exit_tape_failed;
+        if (app.verbose)
+            cout << filename << ": done" << endl;
+    }
+
+    cout << "Tested documents : " << tested << endl;
+    cout << "CBOR             : " << (exit_code & exit_cbor_failed ? "failed" : "ok") << endl;
+    cout << "Tape             : " << (exit_code & exit_tape_failed ? "failed" : "ok") << endl;
+    return exit_code;
+}
+
+
+//------------------------------------------------------------------------------
+// Check that truncated and damaged copies of encoded data are either
+// rejected by 'decode' with std::invalid_argument, or decoded.
+// Truncated data must always be rejected, and if 'trailing_byte' is
+// true, so must the data with a byte appended. Damaged copies have
+// each of 'bad_bytes' written at a number of positions in the data.
+//------------------------------------------------------------------------------
+static bool test_damaged (const string& filename,
+                          const char* format,
+                          const string& data,
+                          bool trailing_byte,
+                          initializer_list<unsigned char> bad_bytes,
+                          const function<void(const string&)>& decode)
+{
+    auto step = data.size() / max_damaged + 1;
+
+    vector<string> truncated;
+    for (size_t size=0; size<data.size(); size+=step)
+        truncated.emplace_back (data.substr(0, size));
+    if (trailing_byte)
+        truncated.emplace_back (data + '\0');
+    for (auto& input : truncated) {
+        try {
+            decode (input);
+            cerr << "Error: " << filename << ": " << format
+                 << " data of size " << input.size() << " accepted, expected "
+                 << data.size() << " bytes" << endl;
+            return false;
+        }
+        catch (invalid_argument&) {
+        }
+        catch (exception& e) {
+            cerr << "Error: " << filename << ": " << format
+                 << " data of size " << input.size() << ": " << e.what() << endl;
+            return false;
+        }
+    }
+
+    for (size_t pos=0; pos<data.size(); pos+=step) {
+        for (auto byte : bad_bytes) {
+            auto damaged = data;
+            damaged[pos] = (char)byte;
+            try {
+                decode (damaged);
+            }
+            catch (invalid_argument&) {
+            }
+            catch (exception& e) {
+                cerr << "Error: " << filename << ": Damaged " << format
+                     << " data at offset " << pos << ": " << e.what() << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Check that a parsed document is unchanged by a round trip through
+// CBOR, and that truncated or damaged CBOR data is handled.
+//------------------------------------------------------------------------------
+static bool test_cbor (const string& filename, const uj::jvalue& instance)
+{
+    auto data = uj::to_cbor (instance);
+    try {
+        if (uj::from_cbor(data.data(), data.size()) != instance) {
+            cerr << "Error: " << filename << ": Document changed by a CBOR round trip" << endl;
+            return false;
+        }
+    }
+    catch (exception& e) {
+        cerr << "Error: " << filename << ": Unable to decode CBOR: " << e.what() << endl;
+        return false;
+    }
+
+    // Reserved values, a break code, and huge lengths
+    return test_damaged (filename, "CBOR", data, true,
+                         {0x1c, 0xff, 0x5b, 0x7f, 0x9b, 0xbb},
+                         [](const string& input) {
+                             uj::from_cbor (input.data(), input.size());
+                         });
+}
+
+
+//------------------------------------------------------------------------------
+// Check that a parsed document is unchanged by a round trip through
+// the tape format, that the members of a top level object are found
+// by name, and that a truncated or damaged tape is handled.
+//------------------------------------------------------------------------------
+static bool test_tape (const string& filename, const uj::jvalue& instance)
+{
+    auto data = uj::to_tape (instance);
+    try {
+        uj::jtape tape (data.data(), data.size());
+        auto root = tape.root ();
+        if (root.value() != instance) {
+            cerr << "Error: " << filename << ": Document changed by a tape round trip" << endl;
+            return false;
+        }
+        if (instance.type() == uj::j_object) {
+            for (auto& member : instance.obj()) {
+                const string& name = member.first;
+                if (root.get(name).value() != instance.get(name)) {
+                    cerr << "Error: " << filename << ": Wrong value of member \""
+                         << name << "\" in tape" << endl;
+                    return false;
+                }
+            }
+        }
+    }
+    catch (exception& e) {
+        cerr << "Error: " << filename << ": Unable to read tape: " << e.what() << endl;
+        return false;
+    }
+
+    // Damaged records, indexes and strings. A truncated
+    // tape doesn't match the sizes in its header.
+    return test_damaged (filename, "Tape", data, false,
+                         {0x00, 0x01, 0x7f, 0xff},
+                         [](const string& input) {
+                             uj::jtape tape (input.data(), input.size());
+                             tape.root().value ();
+                         });
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void print_usage_and_exit (ostream& out, int exit_code)
+{
+    out << endl;
+    out << "Usage: " << prog_name << " [OPTION] <json-file>..." << endl;
+    out << "    Parse JSON documents, and check that each of them is unchanged by a round" << endl;
+    out << "    trip through CBOR and through the tape format. Also check that truncated" << endl;
+    out << "    and damaged CBOR data and tapes are rejected with std::invalid_argument," << endl;
+    out << "    or decoded." << endl;
+    out << "    Exit code is 0 if all checks pass. Otherwise it is the sum of:" << endl;
+    out << "        " << exit_not_parsed  << "  A document couldn't be parsed." << endl;
+    out << "        " << exit_cbor_failed << "  A CBOR check failed." << endl;
+    out << "        " << exit_tape_failed << "  A tape check failed." << endl;
+    out << endl;
+    out << "    Options:" << endl;
+    out << "        -r,--relaxed       Parse documents in relaxed mode." << endl;
+    out << "        -s,--skip-invalid  Skip documents that can't be parsed." << endl;
+    out << "        -V,--verbose       Print the name of each tested document." << endl;
+    out << "        -v,--version       Print version and exit." << endl;
+    out << "        -h,--help          Print this help and exit." << endl;
+    out << endl;
+
+    exit (exit_code);
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void parse_args (int argc, char* argv[], appdata_t& app)
+{
+    optlist_t options = {
+        {'r', "relaxed",      opt_t::none, 0},
+        {'s', "skip-invalid", opt_t::none, 0},
+        {'V', "verbose",      opt_t::none, 0},
+        {'v', "version",      opt_t::none, 0},
+        {'h', "help",         opt_t::none, 0},
+    };
+
+    option_parser opt (argc, argv);
+    while (int id=opt(options)) {
+        switch (id) {
+        case 'r':
+            app.relaxed = true;
+            break;
+
+        case 's':
+            app.skip_invalid = true;
+            break;
+
+        case 'V':
+            app.verbose = true;
+            break;
+
+        case 'v':
+            std::cout << prog_name << ' ' << UJSON_VERSION_STRING << std::endl;
+            exit (0);
+            break;
+
+        case 'h':
+            print_usage_and_exit (std::cout, 0);
+            break;
+
+        case -1:
+            cerr << "Unknown option: '" << opt.opt() << "'" << endl;
+            exit (1);
+            break;
+
+        case -2:
+            cerr << "Missing argument to option '" << opt.opt() << "'" << endl;
+            exit (1);
+            break;
+        }
+    }
+
+    app.filenames = opt.arguments ();
+    if (app.filenames.empty()) {
+        cerr << "Missing argument (--help for help)" << endl;
+        exit (1);
+    }
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2026 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <ujson.hpp>
+#include <ujson/jcoroutine.hpp>
+
+
+using namespace std;
+namespace uj = ujson;
+
+
+// A top level array with items that span many chunks when
+// read a few bytes at a time: escapes, UTF-8 and numbers.
+static const string items_input =
+    "[1, \"a\\u00e5\\\"b\", \"r\xc3\xa4ksm\xc3\xb6rg\xc3\xa5s\", "
+    "{\"x\": [true, null, false]}, -1.5e3, [], {}, 123456789]";
+
+// A sequence of documents, separated by whitespace in the input.
+// The last one is a number that only ends at the end of the input.
+static const vector<string> documents = {
+    "{\"a\": 1}", "[2, [3]]", "\"four\"", "5.5", "null", "true", "{\"b\": \"\\n\"}", "42"
+};
+
+// Two items before a trailing comma
+static const string error_input = "[1, \"two\", ]";
+
+
+static bool test_generator ();
+static bool test_stream (const char* name,
+                         const string& input,
+                         uj::jparser::stream_t what,
+                         const vector<uj::jvalue>& expected,
+                         bool expect_error);
+
+
+//------------------------------------------------------------------------------
+// A generator counting from 0 to n-1.
+//------------------------------------------------------------------------------
+static uj::jgenerator<int> count_to (int n)
+{
+    for (int i=0; i<n; ++i)
+        co_yield i;
+}
+
+
+//------------------------------------------------------------------------------
+// A generator that throws after two values.
+//------------------------------------------------------------------------------
+static uj::jgenerator<int> throw_after_two ()
+{
+    co_yield 1;
+    co_yield 2;
+    throw runtime_error ("thrown by generator");
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int main ()
+{
+    bool ok = test_generator ();
+
+    uj::jparser parser;
+    auto items = parser.parse_string (items_input);
+    ok = test_stream ("items", items_input, uj::jparser::stream_t::items,
+                      items.array(), false) && ok;
+
+    string documents_input;
+    vector<uj::jvalue> parsed_documents;
+    for (auto& doc : documents) {
+        documents_input += documents_input.empty() ? "" : (doc.size() % 2 ? "\n" : " \n  ");
+        documents_input += doc;
+        parsed_documents.emplace_back (parser.parse_string(doc));
+    }
+    ok = test_stream ("documents", documents_input, uj::jparser::stream_t::documents,
+                      parsed_documents, false) && ok;
+
+    ok = test_stream ("error", error_input, uj::jparser::stream_t::items,
+                      {uj::jvalue(1), uj::jvalue("two")}, true) && ok;
+
+    cout << "Coroutines : " << (ok ? "ok" : "failed") << endl;
+    return ok ? 0 : 1;
+}
+
+
+//------------------------------------------------------------------------------
+// Check that a generator yields its values in order, that an
+// exception thrown by the coroutine reaches the caller, and that
+// a moved or unfinished generator is destroyed.
+//------------------------------------------------------------------------------
+static bool test_generator ()
+{
+    int expected = 0;
+    for (auto i : count_to(5)) {
+        if (i != expected++) {
+            cerr << "Error: Generator yielded " << i << ", expected " << expected-1 << endl;
+            return false;
+        }
+    }
+    if (expected != 5) {
+        cerr << "Error: Generator yielded " << expected << " values, expected 5" << endl;
+        return false;
+    }
+
+    auto gen = count_to (3);
+    gen = count_to (2);
+    size_t n = 0;
+    for (auto i=gen.begin(); i!=gen.end(); ++i)
+        ++n;
+    if (n != 2) {
+        cerr << "Error: Move assigned generator yielded " << n << " values, expected 2" << endl;
+        return false;
+    }
+
+    auto unfinished = count_to (10);
+    if (*unfinished.begin() != 0) {
+        cerr << "Error: Unfinished generator didn't start at 0" << endl;
+        return false;
+    }
+
+    n = 0;
+    try {
+        for ([[maybe_unused]] auto i : throw_after_two())
+            ++n;
+        cerr << "Error: Exception from generator not thrown" << endl;
+        return false;
+    }
+    catch (runtime_error&) {
+    }
+    if (n != 2) {
+        cerr << "Error: Generator yielded " << n << " values before throwing, expected 2" << endl;
+        return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Read 'input' with stream_values() using every chunk size from one
+// byte to the whole input, and check that the expected values are
+// yielded each time, so values and tokens split between chunks are
+// parsed as if they were read at once.
+//------------------------------------------------------------------------------
+static bool test_stream (const char* name,
+                         const string& input,
+                         uj::jparser::stream_t what,
+                         const vector<uj::jvalue>& expected,
+                         bool expect_error)
+{
+    for (size_t chunk_size=1; chunk_size<=input.size(); ++chunk_size) {
+        uj::jparser parser;
+        istringstream in (input);
+        size_t n = 0;
+        for (auto& value : uj::stream_values(parser, in, what, true, chunk_size)) {
+            if (n >= expected.size() || value != expected[n]) {
+                cerr << "Error: Stream '" << name << "', chunk size " << chunk_size
+                     << ": Unexpected value " << n << ": " << value.describe() << endl;
+                return false;
+            }
+            ++n;
+        }
+        if (n != expected.size()) {
+            cerr << "Error: Stream '" << name << "', chunk size " << chunk_size
+                 << ": Got " << n << " values, expected " << expected.size() << endl;
+            return false;
+        }
+        bool error = parser.get_error().code != uj::jparser::err::ok;
+        if (error != expect_error) {
+            cerr << "Error: Stream '" << name << "', chunk size " << chunk_size << ": "
+                 << (error ? parser.error() : string("Parse error not found")) << endl;
+            return false;
+        }
+    }
+    return true;
+}
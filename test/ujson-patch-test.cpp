@@ -54,6 +54,9 @@ struct appdata_t {
 
 
 static void run_test (appdata_t& app);
+static bool diff_round_trip (uj::jvalue& doc, uj::jvalue& expected, uj::jvalue& result);
+static bool atomic_patch (uj::jvalue& doc, uj::jvalue& patch, bool patched, uj::jvalue& result);
+static bool identical (const uj::jvalue& a, const uj::jvalue& b);
 static int handle_result (appdata_t& app);
 static void print_usage_and_exit (ostream& out, int exit_code);
 static void parse_args (int argc, char* argv[], appdata_t& app);
@@ -242,6 +245,10 @@ static void run_test (appdata_t& app)
         //
         auto patch_result = uj::patch (doc, result["patch_test_result"], patch);
 
+        // Apply the test patch(es) atomically, it must give the same result
+        //
+        bool atomic_ok = atomic_patch (doc, patch, patch_result.first, result);
+
         // Analyze the result
         //
         if (expected_result.valid()) {
@@ -249,7 +256,9 @@ static void run_test (appdata_t& app)
             // We expect a successful patch
             //
             if (patch_result.first == true  && // All patches applied (and ok on 'test' operations)
-                (only_test_patch || result["patch_test_result"] == expected_result)) // Result as expected
+                atomic_ok  && // Atomic patch gives the same result
+                (only_test_patch || result["patch_test_result"] == expected_result) && // Result as expected
+                (only_test_patch || diff_round_trip(doc, expected_result, result))) // Diff gives the same result
             {
                 // Patch successful
                 app.results["passed"].append (result);
@@ -262,7 +271,12 @@ static void run_test (appdata_t& app)
             //
             // We expect a failed patch
             //
-            if (patch_result.first == false) {
+            // A single failed operation must leave the document unchanged
+            //
+            bool unchanged = patch.type() != uj::j_array  ||  patch.size() != 1  ||
+                identical (result["patch_test_result"], doc);
+
+            if (patch_result.first == false  &&  unchanged  &&  atomic_ok) {
                 // Patch failed - just as we expected
                 app.results["passed"].append (result);
             }else{
@@ -274,7 +288,7 @@ static void run_test (appdata_t& app)
             //
             // A test case with no "expected" or "error" attribute, and only "test" operations
             //
-            if (patch_result.first == true) {
+            if (patch_result.first == true  &&  atomic_ok) {
                 // Patch passed the tests
                 app.results["passed"].append (result);
             }else{
@@ -291,6 +305,75 @@ static void run_test (appdata_t& app)
 }
 
 
+//------------------------------------------------------------------------------
+// Create a patch from the document to the expected result using
+// ujson::diff(), and check that applying it gives the expected result.
+//------------------------------------------------------------------------------
+static bool diff_round_trip (uj::jvalue& doc, uj::jvalue& expected, uj::jvalue& result)
+{
+    // Don't hold references to members of 'result' while adding
+    // other members to it, they may be invalidated by the insertion.
+    uj::jvalue diff = uj::diff (doc, expected);
+    uj::jvalue diff_result;
+    auto patch_result = uj::patch (doc, diff_result, diff);
+    bool ok = patch_result.first  &&  diff_result == expected;
+
+    result["diff"] = std::move (diff);
+    result["diff_test_result"] = std::move (diff_result);
+    return ok;
+}
+
+
+//------------------------------------------------------------------------------
+// Apply the patch to a copy of the document using ujson::patch_atomic().
+// If the patch fails, the copy must be left exactly as the document,
+// including the order of object members. If not, it must be the same
+// as the result of the non-atomic patch.
+//------------------------------------------------------------------------------
+static bool atomic_patch (uj::jvalue& doc, uj::jvalue& patch, bool patched, uj::jvalue& result)
+{
+    uj::jvalue instance (doc);
+    auto patch_result = uj::patch_atomic (instance, patch);
+    bool ok = patch_result.first == patched  &&
+        identical (instance, patched ? result["patch_test_result"] : doc);
+
+    result["atomic_test_result"] = std::move (instance);
+    return ok;
+}
+
+
+//------------------------------------------------------------------------------
+// Compare two values, including the order of object members.
+//------------------------------------------------------------------------------
+static bool identical (const uj::jvalue& a, const uj::jvalue& b)
+{
+    if (a != b)
+        return false;
+
+    if (a.type() == uj::j_object) {
+        auto& a_obj = a.obj ();
+        auto& b_obj = b.obj ();
+        if (a_obj.size() != b_obj.size())
+            return false;
+        auto b_member = b_obj.begin ();
+        for (auto& a_member : a_obj) {
+            if (a_member.first != b_member->first  ||  !identical(a_member.second, b_member->second))
+                return false;
+            ++b_member;
+        }
+    }
+    else if (a.type() == uj::j_array) {
+        auto& a_array = a.array ();
+        auto& b_array = b.array ();
+        for (size_t i=0; i<a_array.size(); ++i) {
+            if (!identical(a_array[i], b_array[i]))
+                return false;
+        }
+    }
+    return true;
+}
+
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 static void print_usage_and_exit (ostream& out, int exit_code)
@@ -101,6 +101,9 @@ const std::string parser_err_to_str (ujson::jparser::err error)
     case ujson::jparser::err::max_obj_size_exceeded:
         return "Maximum number of object members exceeded.";
 
+    case ujson::jparser::err::aborted:
+        return "Parsing aborted.";
+
     default:
         return "(unkown error)";
     }
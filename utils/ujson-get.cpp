@@ -18,10 +18,10 @@
  */
 #include <ujson.hpp>
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <string>
 #include <algorithm>
+#include <memory>
 #include <unistd.h>
 #include "option-parser.hpp"
 
@@ -33,12 +33,16 @@ static constexpr const char* prog_name = "ujson-get";
 
 struct appargs_t {
     string filename;
-    ujson::jpointer pointer;
+    ujson::jpointer_set pointers;
     ujson::jvalue_type jtype;
     ujson::desc_format_t fmt;
     bool strict;
     bool allow_duplicates;
     bool unescape;
+    bool mmap;
+    bool lines;
+    bool stream;
+    bool tape;
 
     appargs_t () {
         jtype = ujson::j_invalid;
@@ -46,6 +50,10 @@ struct appargs_t {
         strict = false;
         allow_duplicates = true;
         unescape = false;
+        mmap = false;
+        lines = false;
+        stream = false;
+        tape = false;
     }
 };
 
@@ -58,15 +66,20 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
     out << "Print a value from a JSON document." << endl;
     out << endl;
     out << "Usage: " << prog_name << " [OPTIONS] [FILE] POINTER" << endl;
+    out << "       " << prog_name << " [OPTIONS] -p POINTER [-p POINTER ...] [FILE]" << endl;
     out << endl;
     out << "A POINTER is a JSON pointer as described in RFC 6901." << endl;
-    out << "If the value pointed to is not found in the JSON document," << endl;
+    out << "If more than one pointer is given, the values are printed" << endl;
+    out << "in the same order as the pointers." << endl;
+    out << "If a value pointed to is not found in the JSON document," << endl;
     out << "or the pointer is not a valid JSON pointer, or on a parse error," << endl;
     out << prog_name << " exits with code 1." << endl;
     out << endl;
     out << "In no file name is given, a JSON document is read from standard input." << endl;
     out << endl;
     out << "Options:" <<endl;
+    out << "  -p, --pointer=POINTER Print the value pointed to by POINTER. May be used more than once." << endl;
+    out << "                       If this option is used, the only argument is the optional file name." << endl;
     out << "  -c, --compact        If the JSON value is an object or an array, print it without whitespace." << endl;
     out << "  -t, --type=TYPE      Require the value to be of a specific type." << endl;
     out << "                       TYPE is one of the following: boolean, number, string, null, object, or array." << endl;
@@ -75,6 +88,18 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
     out << "                       print it as an unescaped string witout enclosing double quotes." << endl;
     out << "  -s, --strict         Parse the JSON document in strict mode." << endl;
     out << "  -n, --no-duplicates  Don't allow objects with duplicate member names." << endl;
+    out << "  -l, --lines          Each line in the input is a separate JSON document (NDJSON/JSON Lines)." << endl;
+    out << "                       The value is printed for each line, and " << prog_name << " exits" << endl;
+    out << "                       with code 1 if any line fails." << endl;
+    out << "      --mmap           Memory map the input file instead of reading it into a buffer." << endl;
+    out << "                       Standard input and non-regular files are always read into a buffer." << endl;
+    out << "      --stream         Don't build the whole JSON document in memory, only the values" << endl;
+    out << "                       pointed to. A file is memory mapped. Option -n is ignored," << endl;
+    out << "                       and this option can't be used together with option -l." << endl;
+    out << "      --tape           The input is a JSON document in tape format, written by 'ujson-print --write-tape'." << endl;
+    out << "                       The values are found without parsing the document. A file is memory mapped." << endl;
+    out << "                       Options -s and -n are ignored, and this option can't be used together" << endl;
+    out << "                       with option -l or --stream." << endl;
 #if (UJSON_HAS_CONSOLE_COLOR)
     out << "  -o, --color          Print in color if the output is to a tty." << endl;
 #endif
@@ -90,20 +115,36 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
 static void parse_args (int argc, char* argv[], appargs_t& args)
 {
     optlist_t options = {
+        {'p', "pointer",       opt_t::required, 0},
         {'c', "compact",       opt_t::none,     0},
         {'t', "type",          opt_t::required, 0},
         {'u', "unescape",      opt_t::none,     0},
         {'r', "relaxed",       opt_t::none,     0},
         {'s', "strict",        opt_t::none,     0},
         {'n', "no-duplicates", opt_t::none,     0},
+        {'l', "lines",         opt_t::none,     0},
+        {'\0', "mmap",         opt_t::none,  1000},
+        {'\0', "stream",       opt_t::none,  1001},
+        {'\0', "tape",         opt_t::none,  1002},
         {'o', "color",         opt_t::none,     0},
         {'v', "version",       opt_t::none,     0},
         {'h', "help",          opt_t::none,     0},
     };
 
+    bool have_pointer_opt = false;
     option_parser opt (argc, argv);
     while (int id=opt(options)) {
         switch (id) {
+        case 'p':
+            try {
+                args.pointers.add (ujson::jpointer(opt.optarg()));
+                have_pointer_opt = true;
+            }
+            catch (std::invalid_argument& ia) {
+                cerr << "Error: " << ia.what() << ": " << opt.optarg() << endl;
+                exit (1);
+            }
+            break;
         case 'c':
             args.fmt = ujson::fmt_none;
             break;
@@ -126,6 +167,18 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         case 'n':
             args.allow_duplicates = false;
             break;
+        case 'l':
+            args.lines = true;
+            break;
+        case 1000: // --mmap
+            args.mmap = true;
+            break;
+        case 1001: // --stream
+            args.stream = true;
+            break;
+        case 1002: // --tape
+            args.tape = true;
+            break;
         case 'o':
 #if (UJSON_HAS_CONSOLE_COLOR)
             if (isatty(fileno(stdout)))
@@ -150,7 +203,26 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         }
     }
 
+    if (args.stream && args.lines) {
+        cerr << "Option --stream can't be used together with option --lines" << endl;
+        exit (1);
+    }
+    if (args.tape && (args.stream || args.lines)) {
+        cerr << "Option --tape can't be used together with option --stream or --lines" << endl;
+        exit (1);
+    }
+
     auto& arguments = opt.arguments ();
+    if (have_pointer_opt) {
+        if (arguments.size() > 1) {
+            cerr << "Too many arguments" << endl;
+            exit (1);
+        }
+        if (!arguments.empty())
+            args.filename = arguments[0];
+        return;
+    }
+
     switch (arguments.size()) {
     case 0:
         cerr << "Too few arguments" << endl;
@@ -158,13 +230,13 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         break;
 
     case 1:
-        args.pointer = arguments[0];
+        args.pointers.add (ujson::jpointer(arguments[0]));
         break;
 
     case 2:
         try {
             args.filename = arguments[0];
-            args.pointer  = arguments[1];
+            args.pointers.add (ujson::jpointer(arguments[1]));
         }
         catch (std::invalid_argument& ia) {
             cerr << "Error: " << ia.what() << endl;
@@ -180,60 +252,208 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
 
 
 //------------------------------------------------------------------------------
+// Print a value found by a JSON pointer.
+// Return 0 on success, 1 if not found or of the wrong type.
 //------------------------------------------------------------------------------
-int main (int argc, char* argv[])
+static int print_value (const ujson::jvalue* value,
+                        const ujson::jpointer& pointer,
+                        const appargs_t& opt)
+{
+    if (value==nullptr || !value->valid()) {
+        std::cerr << "Value at location \"" << (std::string)pointer << "\" not found" << endl;
+        return 1;
+    }
+
+    if (opt.jtype != ujson::j_invalid  &&  value->type() != opt.jtype) {
+        // The value is not of the type we required
+        std::cerr << "Type mismatch, value at \"" << (std::string)pointer
+                  << "\" is of type \"" << jtype_to_str(value->type())
+                  << "\"" << std::endl;
+        return 1;
+    }
+
+    if (opt.unescape && value->is_string()) {
+        cout << value->str_view() << endl;
+    }else{
+        value->write (cout, opt.fmt);
+        cout << endl;
+    }
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Find and print the values in a JSON instance.
+// Return 0 on success, 1 if any value is not found or of the wrong type.
+//------------------------------------------------------------------------------
+static int print_values (const ujson::jvalue& instance, const appargs_t& opt)
 {
-    appargs_t opt;
     int retval = 0;
+    auto values = opt.pointers.find (instance);
+    for (size_t i=0; i<values.size(); ++i) {
+        if (print_value(values[i], opt.pointers[i], opt))
+            retval = 1;
+    }
+    return retval;
+}
 
-    try {
-        parse_args (argc, argv, opt);
 
-        // Read json file or standard input
-        //
-        ifstream ifs;
-        ifs.exceptions (std::ifstream::failbit);
-        if (!opt.filename.empty())
-            ifs.open (opt.filename);
-        istream& in = opt.filename.empty() ? cin : ifs;
-        string json_desc ((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-
-        // Parse json document
+//------------------------------------------------------------------------------
+// Read a JSON file or standard input. Compressed input is decompressed.
+//------------------------------------------------------------------------------
+static string read_input (const appargs_t& opt)
+{
+    std::unique_ptr<ujson::jdecompressor> in;
+    if (opt.filename.empty())
+        in = std::make_unique<ujson::jdecompressor> (STDIN_FILENO);
+    else
+        in = std::make_unique<ujson::jdecompressor> (opt.filename);
+
+    string json_desc;
+    const char* data;
+    size_t size;
+    while (in->next(data, size))
+        json_desc.append (data, size);
+    if (!in->error().empty()) {
+        if (opt.filename.empty())
+            cerr << "Error reading input: " << in->error() << endl;
+        else
+            cerr << "Error reading file '" << opt.filename << "': " << in->error() << endl;
+        exit (1);
+    }
+    return json_desc;
+}
+
+
+//------------------------------------------------------------------------------
+// Print the value from each line in the input.
+//------------------------------------------------------------------------------
+static int print_lines (ujson::jparser& parser, const appargs_t& opt)
+{
+    string json_desc;
+    if (opt.mmap && !opt.filename.empty()) {
+        // Let the parser memory map the json file
         //
-        ujson::jparser parser;
-        auto instance = parser.parse_string (json_desc, opt.strict, opt.allow_duplicates);
+        if (!parser.begin_lines_file(opt.filename, opt.strict, opt.allow_duplicates)) {
+            cerr << "Error reading file '" << opt.filename << "'" << endl;
+            exit (1);
+        }
+    }else{
+        json_desc = read_input (opt);
+        parser.begin_lines (json_desc.data(), json_desc.size(), opt.strict, opt.allow_duplicates);
+    }
+
+    int retval = 0;
+    ujson::jvalue instance;
+    while (parser.next_line(instance)) {
         if (!instance.valid()) {
             cerr << "Parse error: " << parser.error() << endl;
-            exit (1);
+            retval = 1;
+        }
+        else if (print_values(instance, opt)) {
+            retval = 1;
         }
+    }
+    return retval;
+}
 
-        // Get the value
-        //
-        auto& value = ujson::find_jvalue (instance, opt.pointer);
-        bool type_mismatch = false;
 
-        // Print the result
-        //
-        if (opt.jtype != ujson::j_invalid  &&  value.type() != opt.jtype) {
-            // The value is not of the type we required
-            type_mismatch = true;
-            std::cerr << "Type mismatch, value at \"" << (std::string)opt.pointer
-                      << "\" is of type \"" << jtype_to_str(value.type())
-                      << "\"" << std::endl;
-            value.type (ujson::j_invalid);
-        }
+//------------------------------------------------------------------------------
+// Print the values from a JSON document in tape format,
+// only the values found are copied from the tape.
+//------------------------------------------------------------------------------
+static int print_from_tape (const appargs_t& opt)
+{
+    string buffer;
+    unique_ptr<ujson::jtape> tape;
+    if (opt.filename.empty()) {
+        buffer = read_input (opt);
+        tape = make_unique<ujson::jtape> (buffer.data(), buffer.size());
+    }else{
+        tape = make_unique<ujson::jtape> (opt.filename);
+    }
 
-        if (value.valid()) {
-            if (opt.unescape && value.is_string())
-                cout << value.str() << endl;
-            else
-                cout << value.describe(opt.fmt) << endl;
-        }else{
+    int retval = 0;
+    for (size_t i=0; i<opt.pointers.size(); ++i) {
+        auto value = tape->find(opt.pointers[i]).value ();
+        if (print_value(&value, opt.pointers[i], opt))
             retval = 1;
+    }
+    return retval;
+}
+
+
+//------------------------------------------------------------------------------
+// Print the values without building the whole JSON document.
+//------------------------------------------------------------------------------
+static int print_streamed (const appargs_t& opt)
+{
+    ujson::jreader reader;
+    ujson::jpointer_set::extractor extract (opt.pointers);
+
+    bool ok;
+    if (opt.filename.empty())
+        ok = reader.parse_string (extract, read_input(opt), opt.strict);
+    else
+        ok = reader.parse_file (extract, opt.filename, opt.strict);
+
+    if (!ok) {
+        if (reader.get_error().code == ujson::jparser::err::io)
+            cerr << "Error reading file '" << opt.filename << "'" << endl;
+        else
+            cerr << "Parse error: " << reader.error() << endl;
+        return 1;
+    }
+
+    int retval = 0;
+    auto& values = extract.results ();
+    for (size_t i=0; i<values.size(); ++i) {
+        if (print_value(&values[i], opt.pointers[i], opt))
+            retval = 1;
+    }
+    return retval;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int main (int argc, char* argv[])
+{
+    appargs_t opt;
+    int retval = 0;
+
+    try {
+        parse_args (argc, argv, opt);
+
+        ujson::jparser parser;
+        ujson::jvalue instance;
+
+        if (opt.lines)
+            return print_lines (parser, opt);
+        if (opt.stream)
+            return print_streamed (opt);
+        if (opt.tape)
+            return print_from_tape (opt);
+
+        if (opt.mmap && !opt.filename.empty()) {
+            // Let the parser memory map the json file
+            //
+            instance = parser.parse_file (opt.filename, opt.strict, opt.allow_duplicates);
+            if (instance.invalid() && parser.get_error().code==ujson::jparser::err::io) {
+                cerr << "Error reading file '" << opt.filename << "'" << endl;
+                exit (1);
+            }
+        }else{
+            // Read json file or standard input, and parse the json document
+            //
+            instance = parser.parse_string (read_input(opt), opt.strict, opt.allow_duplicates);
+        }
+        if (!instance.valid()) {
+            cerr << "Parse error: " << parser.error() << endl;
+            exit (1);
         }
 
-        if (retval && !type_mismatch)
-            std::cerr << "Value at location \"" << (std::string)opt.pointer << "\" not found" << endl;
+        retval = print_values (instance, opt);
     }
     catch (std::ios_base::failure& io_error) {
         if (opt.filename.empty())
@@ -36,6 +36,7 @@ struct appargs_t {
     bool strict;
     bool allow_duplicates;
     bool quiet;
+    bool atomic;
     std::string document_filename;
     std::string patch_filename;
 
@@ -44,6 +45,7 @@ struct appargs_t {
         strict = false;
         allow_duplicates = true;
         quiet = false;
+        atomic = false;
     }
 };
 
@@ -73,6 +75,9 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
     out << "                       written to standard output. If the patch definition" << endl;
     out << "                       contains operations other than 'test', the resulting" << endl;
     out << "                       JSON document is still printed to standard output." << endl;
+    out << "  -a, --atomic         Apply all patch operations, or none. The patch operations" << endl;
+    out << "                       after a failed operation are not tried, and the JSON" << endl;
+    out << "                       document is printed unchanged." << endl;
     out << "  -v, --version        Print version and exit." << endl;
     out << "  -h, --help           Print this help message and exit." << endl;
     out << endl;
@@ -91,6 +96,7 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         {'s', "strict",        opt_t::none, 0},
         {'n', "no-duplicates", opt_t::none, 0},
         {'q', "quiet",         opt_t::none, 0},
+        {'a', "atomic",        opt_t::none, 0},
         {'v', "version",       opt_t::none, 0},
         {'h', "help",          opt_t::none, 0},
     };
@@ -113,6 +119,9 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         case 'q':
             args.quiet = true;
             break;
+        case 'a':
+            args.atomic = true;
+            break;
         case 'v':
             std::cout << prog_name << ' ' << UJSON_VERSION_STRING << std::endl;
             exit (0);
@@ -204,12 +213,14 @@ int main (int argc, char* argv[])
         exit (1);
     }
 
-    auto result = ujson::patch (instance, patch);
+    auto result = opt.atomic ?
+        ujson::patch_atomic (instance, patch) :
+        ujson::patch (instance, patch);
     bool only_test_ops = false;
 
     if (opt.quiet != true) {
-        auto num_patches = result.second.size ();
-        for (unsigned i=0; i<num_patches; ++i) {
+        auto num_patches = patch.is_array() ? patch.size() : 1;
+        for (unsigned i=0; i<result.second.size(); ++i) {
             switch (result.second[i]) {
             case ujson::patch_ok:
                 break;
@@ -254,8 +265,10 @@ int main (int argc, char* argv[])
 
     // Print the patched json instance
     //
-    if (!opt.quiet || !only_test_ops)
-        cout << instance.describe(opt.fmt) << endl;
+    if (!opt.quiet || !only_test_ops) {
+        instance.write (cout, opt.fmt);
+        cout << endl;
+    }
 
     return result.first ? 0 : 1;
 }
@@ -18,8 +18,10 @@
  */
 #include <ujson.hpp>
 #include <iostream>
-#include <fstream>
 #include <string>
+#include <memory>
+#include <cstdlib>
+#include <stdexcept>
 #include <cstdio>
 #include <unistd.h>
 #include "option-parser.hpp"
@@ -36,6 +38,13 @@ struct appargs_t {
     bool parse_strict;
     bool allow_duplicates;
     bool multi_doc;
+    bool mmap;
+    bool keep_numbers;
+    bool binary;
+    bool write_binary;
+    bool write_tape;
+    ujson::compression_t compress;
+    unsigned jobs;
     string filename;
 
     appargs_t () {
@@ -43,6 +52,13 @@ struct appargs_t {
         parse_strict = false;
         allow_duplicates = true;
         multi_doc = false;
+        mmap = false;
+        keep_numbers = false;
+        binary = false;
+        write_binary = false;
+        write_tape = false;
+        compress = ujson::compression_t::none;
+        jobs = 1;
     }
 };
 
@@ -73,6 +89,27 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
     out << "  -m, --multi-doc       Parse multiple JSON instances." << endl;
     out << "                        The input is treated as a stream of JSON " << endl;
     out << "                        instances, separated by line breaks." << endl;
+    out << "                        Lines with only whitespace are ignored." << endl;
+    out << "  -l, --lines           Same as '-m,--multi-doc' (NDJSON/JSON Lines)." << endl;
+    out << "  -j, --jobs=N          Parse and print using N threads. The elements of large arrays and" << endl;
+    out << "                        objects are parsed and printed in parallel. The output is the same" << endl;
+    out << "                        as when using a single thread." << endl;
+    out << "                        If N is 0, use the number of available CPU cores. Default is 1." << endl;
+    out << "      --mmap            Memory map the input file instead of reading it into a buffer." << endl;
+    out << "                        Standard input and non-regular files are always read into a buffer." << endl;
+    out << "      --keep-numbers    Print numbers exactly as they are written in the input," << endl;
+    out << "                        instead of converting them and printing them in a normalized form." << endl;
+    out << "      --binary          The input is CBOR (RFC 8949) instead of JSON text." << endl;
+    out << "                        With option '-m,--multi-doc', the input is a CBOR sequence (RFC 8742)." << endl;
+    out << "                        Options '-s,--strict', '--mmap' and '--keep-numbers' are ignored." << endl;
+    out << "      --write-binary    Write CBOR (RFC 8949) instead of JSON text." << endl;
+    out << "                        With option '-m,--multi-doc', the output is a CBOR sequence (RFC 8742)." << endl;
+    out << "                        Formatting options are ignored." << endl;
+    out << "      --write-tape      Write the JSON document in tape format, a format that can be read" << endl;
+    out << "                        without parsing it. See ujson-get option '--tape'." << endl;
+    out << "                        Formatting options are ignored, and option '-m,--multi-doc' can't be used." << endl;
+    out << "      --compress=FORMAT Compress the output. FORMAT is 'gzip' or 'zstd'." << endl;
+    out << "                        Compressed input is always detected and decompressed." << endl;
 #if (UJSON_HAS_CONSOLE_COLOR)
     out << "  -o, --color           Print in color if the output is to a tty." << endl;
 #endif
@@ -97,6 +134,14 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         { 's', "strict",       opt_t::none, 0},
         { 'n', "no-duplicates",opt_t::none, 0},
         { 'm', "multi-doc",    opt_t::none, 0},
+        { 'l', "lines",        opt_t::none, 0},
+        { 'j', "jobs",         opt_t::required, 0},
+        {'\0', "mmap",         opt_t::none, 1000},
+        {'\0', "keep-numbers", opt_t::none, 1001},
+        {'\0', "binary",       opt_t::none, 1002},
+        {'\0', "write-binary", opt_t::none, 1003},
+        {'\0', "write-tape",   opt_t::none, 1004},
+        {'\0', "compress",     opt_t::required, 1005},
         { 'o', "color",        opt_t::none, 0},
         { 'v', "version",      opt_t::none, 0},
         { 'h', "help",         opt_t::none, 0},
@@ -130,8 +175,40 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
             args.allow_duplicates = false;
             break;
         case 'm':
+        case 'l':
             args.multi_doc = true;
             break;
+        case 'j':
+            args.jobs = atoi (opt.optarg().c_str());
+            break;
+        case 1000: // --mmap
+            args.mmap = true;
+            break;
+        case 1001: // --keep-numbers
+            args.keep_numbers = true;
+            break;
+        case 1002: // --binary
+            args.binary = true;
+            break;
+        case 1003: // --write-binary
+            args.write_binary = true;
+            break;
+        case 1004: // --write-tape
+            args.write_tape = true;
+            break;
+        case 1005: // --compress
+            try {
+                args.compress = ujson::compression_from_name (opt.optarg());
+            }
+            catch (std::invalid_argument& e) {
+                cerr << "Unknown compression format: '" << opt.optarg() << "'" << endl;
+                exit (1);
+            }
+            if (!ujson::compression_supported(args.compress)) {
+                cerr << "Compression format '" << opt.optarg() << "' is not supported" << endl;
+                exit (1);
+            }
+            break;
         case 'o':
 #if (UJSON_HAS_CONSOLE_COLOR)
             if (isatty(fileno(stdout)))
@@ -164,24 +241,148 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
             exit (1);
         }
     }
+    if (args.write_tape && args.multi_doc) {
+        cerr << "Option '--write-tape' can't be used together with option '-m,--multi-doc'" << endl;
+        exit (1);
+    }
 }
 
 
 //------------------------------------------------------------------------------
+// Compresses everything written to an output stream while it exists.
 //------------------------------------------------------------------------------
-static int parse_multiple_instances (istream& in,appargs_t& opt)
+class compressed_output : public std::streambuf {
+public:
+    compressed_output (ujson::compression_t method, ostream& out_arg)
+        : out {out_arg},
+          dest {out_arg.rdbuf()},
+          compressor {method, [this](const char* data, size_t size) {
+                                  if (dest->sputn(data, (streamsize)size) != (streamsize)size)
+                                      throw std::runtime_error ("Error writing output");
+                              }}
+    {
+        setp (buf, buf + sizeof(buf));
+        out.rdbuf (this);
+    }
+    ~compressed_output () override {
+        out.flush ();
+        out.rdbuf (dest);
+        try {
+            compressor.finish ();
+        }
+        catch (std::exception& e) {
+            cerr << "Error: " << e.what() << endl;
+        }
+        out.flush ();
+    }
+
+protected:
+    int overflow (int c) override {
+        if (sync() != 0)
+            return traits_type::eof ();
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof (c);
+        *pptr() = traits_type::to_char_type (c);
+        pbump (1);
+        return c;
+    }
+    int sync () override {
+        compressor.write (pbase(), pptr() - pbase());
+        setp (buf, buf + sizeof(buf));
+        return 0;
+    }
+
+private:
+    ostream& out;
+    std::streambuf* dest;
+    ujson::jcompressor compressor;
+    char buf[64*1024];
+};
+
+
+//------------------------------------------------------------------------------
+// Read a JSON document, or CBOR data, from a file or standard input.
+// Compressed input is decompressed.
+//------------------------------------------------------------------------------
+static string read_input (const appargs_t& opt)
 {
-    ujson::jparser parser;
-    std::string line;
+    std::unique_ptr<ujson::jdecompressor> in;
+    if (opt.filename.empty())
+        in = std::make_unique<ujson::jdecompressor> (STDIN_FILENO);
+    else
+        in = std::make_unique<ujson::jdecompressor> (opt.filename);
 
-    while (getline(in, line)) {
-        auto instance = parser.parse_string (line, opt.parse_strict, opt.allow_duplicates);
-        if (instance.valid())
-            cout << instance.describe(opt.fmt) << endl;
+    string buffer;
+    const char* data;
+    size_t size;
+    while (in->next(data, size))
+        buffer.append (data, size);
+    if (!in->error().empty()) {
+        if (opt.filename.empty())
+            cerr << "Error reading input: " << in->error() << endl;
         else
+            cerr << "Error reading file '" << opt.filename << "': " << in->error() << endl;
+        exit (1);
+    }
+    return buffer;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void print_instance (const ujson::jvalue& instance, appargs_t& opt)
+{
+    if (opt.write_tape) {
+        ujson::to_tape (instance, cout);
+    }else if (opt.write_binary) {
+        ujson::to_cbor (instance, cout);
+    }else{
+        instance.write (cout, opt.fmt, 0, opt.jobs);
+        cout << endl;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static int parse_multiple_instances (ujson::jparser& parser, appargs_t& opt)
+{
+    int retval = 0;
+    ujson::jvalue instance;
+
+    while (parser.next_line(instance)) {
+        if (instance.valid()) {
+            print_instance (instance, opt);
+        }else{
             cerr << "Error: " << parser.error() << endl;
+            retval = 1;
+        }
+    }
+    return retval;
+}
+
+
+//------------------------------------------------------------------------------
+// Decode and print CBOR data, a single data item or a CBOR sequence.
+//------------------------------------------------------------------------------
+static int decode_binary (const string& buffer, appargs_t& opt)
+{
+    try {
+        if (!opt.multi_doc) {
+            print_instance (ujson::from_cbor(buffer.data(), buffer.size(), opt.allow_duplicates), opt);
+            return 0;
+        }
+        for (size_t pos=0, length=0; pos<buffer.size(); pos+=length) {
+            print_instance (ujson::from_cbor(buffer.data()+pos, buffer.size()-pos,
+                                             length, opt.allow_duplicates),
+                            opt);
+        }
     }
-    return in.fail() ? 1 : 0;
+    catch (std::invalid_argument& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
 }
 
 
@@ -192,44 +393,66 @@ int main (int argc, char* argv[])
     appargs_t opt;
     parse_args (argc, argv, opt);
 
-    try {
-        // Open json document
+    std::unique_ptr<compressed_output> compressed;
+    if (opt.compress != ujson::compression_t::none)
+        compressed = std::make_unique<compressed_output> (opt.compress, cout);
+
+    ujson::jparser parser;
+    parser.lazy_numbers (opt.keep_numbers);
+    parser.threads (opt.jobs);
+    parser.borrow_strings (true); // The input outlives the parsed instance
+
+    if (opt.mmap && opt.multi_doc && !opt.binary && !opt.filename.empty()) {
+        // Let the parser memory map the file of JSON instances
         //
-        ifstream ifs;
-        ifs.exceptions (std::ifstream::failbit);
-        if (!opt.filename.empty())
-            ifs.open (opt.filename);
-        istream& in = opt.filename.empty() ? cin : ifs;
-        in.exceptions (std::ifstream::failbit);
-
-        if (opt.multi_doc) {
-            // Treat the input as a stream of
-            // JSON instances separated by line breaks.
-            return parse_multiple_instances (in, opt);
+        if (!parser.begin_lines_file(opt.filename, opt.parse_strict, opt.allow_duplicates)) {
+            cerr << "Error reading file '" << opt.filename << "'" << endl;
+            exit (1);
         }
+        return parse_multiple_instances (parser, opt);
+    }
 
-        // Read and parse json document
+    if (opt.mmap && !opt.binary && !opt.filename.empty()) {
+        // Let the parser memory map the json document
         //
-        string buffer ((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-        ujson::jparser parser;
-        auto instance = parser.parse_string (buffer, opt.parse_strict, opt.allow_duplicates);
+        auto instance = parser.parse_file (opt.filename, opt.parse_strict, opt.allow_duplicates);
         if (!instance.valid()) {
             auto err = parser.get_error ();
-            cerr << "Parse error at " << (err.row+1) << ", " << err.col
-                 << ": " << parser_err_to_str(err.code) << endl;
+            if (err.code == ujson::jparser::err::io)
+                cerr << "Error reading file '" << opt.filename << "'" << endl;
+            else
+                cerr << "Parse error at " << (err.row+1) << ", " << err.col
+                     << ": " << parser_err_to_str(err.code) << endl;
             exit (1);
         }
-
-        // Print the parsed json instance
-        //
-        cout << instance.describe(opt.fmt) << endl;
+        print_instance (instance, opt);
         return 0;
     }
-    catch (std::ios_base::failure& io_error) {
-        if (opt.filename.empty())
-            cerr << "Error reading input: " << io_error.code().message() << endl;
-        else
-            cerr << "Error reading file '" << opt.filename << "': " << io_error.code().message() << endl;
+
+    // Read and parse json document
+    //
+    string buffer = read_input (opt);
+
+    if (opt.binary)
+        return decode_binary (buffer, opt);
+
+    if (opt.multi_doc) {
+        // Treat the input as a stream of
+        // JSON instances separated by line breaks.
+        parser.begin_lines (buffer.data(), buffer.size(), opt.parse_strict, opt.allow_duplicates);
+        return parse_multiple_instances (parser, opt);
+    }
+
+    auto instance = parser.parse_string (buffer, opt.parse_strict, opt.allow_duplicates);
+    if (!instance.valid()) {
+        auto err = parser.get_error ();
+        cerr << "Parse error at " << (err.row+1) << ", " << err.col
+             << ": " << parser_err_to_str(err.code) << endl;
         exit (1);
     }
+
+    // Print the parsed json instance
+    //
+    print_instance (instance, opt);
+    return 0;
 }
@@ -0,0 +1,1100 @@
+/*
+ * Copyright (C) 2024 Dan Arrhenius <dan@ultramarin.se>
+ *
+ * This file is part of ujson.
+ *
+ * ujson is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <ujson.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include "option-parser.hpp"
+#include "parser-errors.hpp"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+
+static constexpr const char* prog_name = "ujson-schemac";
+
+struct appargs_t {
+    string schema_file;
+    string output;
+    string name_space;
+    string function;
+    bool strict;
+
+    appargs_t () {
+        name_space = "schema_validator";
+        function = "validate";
+        strict = false;
+    }
+};
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void print_usage_and_exit (std::ostream& out, int exit_code)
+{
+    out << endl
+        << "Generate C++ code that validates JSON instances using a JSON schema." << endl
+        << endl
+        << "Usage: " << prog_name << " [OPTIONS] SCHEMA_FILE" << endl
+        << endl
+        << "The generated code is a header file with inline functions, in a namespace," << endl
+        << "that validates ujson::jvalue instances without interpreting the schema." << endl
+        << "The main function is declared as:" << endl
+        << "  bool NAMESPACE::FUNCTION (const ujson::jvalue& instance);" << endl
+        << endl
+        << "Options:" <<endl
+        << "  -o, --output=FILE       Write the generated code to a file instead of standard output." << endl
+        << "  -n, --namespace=NAME    The namespace of the generated code. Default is 'schema_validator'." << endl
+        << "  -f, --function=NAME     The name of the validating function. Default is 'validate'." << endl
+        << "  -s, --strict            Parse the schema file in strict mode." << endl
+        << "  -v, --version           Print version and exit." << endl
+        << "  -h, --help              Print this help message and exit." << endl
+        << endl;
+        exit (exit_code);
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static bool is_identifier (const string& name)
+{
+    if (name.empty() || std::isdigit(name[0]))
+        return false;
+    for (auto ch : name) {
+        if (!std::isalnum(ch) && ch!='_')
+            return false;
+    }
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void parse_args (int argc, char* argv[], appargs_t& args)
+{
+    optlist_t options = {
+        { 'o', "output",    opt_t::required, 0},
+        { 'n', "namespace", opt_t::required, 0},
+        { 'f', "function",  opt_t::required, 0},
+        { 'r', "relaxed",   opt_t::none,     0},
+        { 's', "strict",    opt_t::none,     0},
+        { 'v', "version",   opt_t::none,     0},
+        { 'h', "help",      opt_t::none,     0},
+    };
+
+    option_parser opt (argc, argv);
+    while (int id=opt(options)) {
+        switch (id) {
+        case 'o':
+            args.output = opt.optarg ();
+            break;
+        case 'n':
+            args.name_space = opt.optarg ();
+            break;
+        case 'f':
+            args.function = opt.optarg ();
+            break;
+        case 'r':
+            args.strict = false;
+            break;
+        case 's':
+            args.strict = true;
+            break;
+        case 'v':
+            std::cout << prog_name << ' ' << UJSON_VERSION_STRING << std::endl;
+            exit (0);
+            break;
+        case 'h':
+            print_usage_and_exit (std::cout, 0);
+            break;
+        default:
+            cerr << "Unknown option: '" << opt.opt() << "'" << endl;
+            exit (1);
+            break;
+        }
+    }
+
+    auto& arguments = opt.arguments ();
+    if (arguments.size() != 1) {
+        cerr << "Error: Missing schema file (use option -h for help)" << endl;
+        exit (1);
+    }
+    args.schema_file = arguments.front ();
+
+    // Nested namespaces are separated by '::'
+    string ns = args.name_space;
+    for (size_t pos; (pos=ns.find("::")) != string::npos; )
+        ns.replace (pos, 2, "_");
+    if (!is_identifier(ns)) {
+        cerr << "Error: Invalid namespace '" << args.name_space << "'" << endl;
+        exit (1);
+    }
+    if (!is_identifier(args.function)) {
+        cerr << "Error: Invalid function name '" << args.function << "'" << endl;
+        exit (1);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Return a string as a C++ string literal.
+// Octal escapes are used since they are at most three digits.
+//------------------------------------------------------------------------------
+static string cpp_string (const std::string_view& str)
+{
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char ch : str) {
+        if (ch=='"' || ch=='\\') {
+            out << '\\' << ch;
+        }
+        else if (ch=='?') {
+            out << "\\?"; // Avoid trigraphs
+        }
+        else if (ch < 0x20 || ch >= 0x7f) {
+            out << '\\' << std::oct << std::setw(3) << std::setfill('0') << (unsigned)ch
+                << std::dec;
+        }else{
+            out << ch;
+        }
+    }
+    out << '"';
+    return out.str ();
+}
+
+
+//------------------------------------------------------------------------------
+// Return a number as a C++ floating point literal.
+//------------------------------------------------------------------------------
+static string cpp_number (const ujson::jvalue& value)
+{
+    double number = value.num ();
+    if (std::isinf(number))
+        return number < 0 ? "(-HUGE_VAL)" : "HUGE_VAL";
+
+    std::ostringstream out;
+    out << std::setprecision(std::numeric_limits<double>::max_digits10) << number;
+    string literal = out.str ();
+    if (literal.find_first_of(".e") == string::npos)
+        literal.append (".0");
+    return literal;
+}
+
+
+//------------------------------------------------------------------------------
+// Decode %XX sequences in an URI fragment.
+//------------------------------------------------------------------------------
+static string uri_decode (const string& str)
+{
+    string result;
+    for (size_t i=0; i<str.size(); ++i) {
+        if (str[i]=='%' && i+2 < str.size() &&
+            std::isxdigit(str[i+1]) && std::isxdigit(str[i+2]))
+        {
+            result.push_back ((char)std::stoi(str.substr(i+1, 2), nullptr, 16));
+            i += 2;
+        }else{
+            result.push_back (str[i]);
+        }
+    }
+    return result;
+}
+
+
+//------------------------------------------------------------------------------
+// Generates validator functions from a schema.
+// Each subschema that isn't a boolean schema is a function.
+//------------------------------------------------------------------------------
+class generator {
+public:
+    generator (const ujson::jvalue& root_arg, const appargs_t& args_arg);
+    void generate (std::ostream& out);
+
+private:
+    void collect_anchors (const ujson::jvalue& schema, const ujson::jpointer& location);
+    const ujson::jvalue& resolve_ref (const string& ref, const ujson::jpointer& location);
+
+    string call (const ujson::jvalue& schema, const string& arg, const ujson::jpointer& location);
+    string regex (const string& pattern);
+    string value (const ujson::jvalue& v);
+    string equals (const ujson::jvalue& v);
+
+    void gen_function (size_t index, std::ostream& out);
+    void gen_type (const ujson::jvalue& schema_value, std::ostream& out);
+    void gen_numbers (const ujson::jvalue& schema, std::ostream& out);
+    void gen_strings (const ujson::jvalue& schema, std::ostream& out);
+    void gen_arrays (const ujson::jvalue& schema, const ujson::jpointer& location, std::ostream& out);
+    void gen_objects (const ujson::jvalue& schema, const ujson::jpointer& location, std::ostream& out);
+
+    const ujson::jvalue& root;
+    const appargs_t& args;
+    string root_id;
+
+    // Subschemas with a generated function
+    std::map<const ujson::jvalue*, size_t> function_index;
+    std::vector<std::pair<const ujson::jvalue*, ujson::jpointer>> functions;
+
+    std::vector<string> patterns; // Regular expressions
+    std::vector<string> values;   // JSON values used by 'const' and 'enum'
+    std::map<string, const ujson::jvalue*> anchors;
+};
+
+
+// Keywords that can't be evaluated without annotations or dynamic scopes
+static const std::set<string> unsupported_keywords = {
+    "unevaluatedItems",
+    "unevaluatedProperties",
+    "$dynamicRef",
+    "$recursiveRef",
+};
+
+// Keywords with values that are not schemas
+static const std::set<string> value_keywords = {
+    "const",
+    "enum",
+    "default",
+    "examples",
+};
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+generator::generator (const ujson::jvalue& root_arg, const appargs_t& args_arg)
+    : root (root_arg),
+      args (args_arg)
+{
+    if (root.type() == ujson::j_object) {
+        auto& id = root.get ("$id");
+        if (id.type() == ujson::j_string)
+            root_id = id.str_view ();
+    }
+    collect_anchors (root, ujson::jpointer());
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::collect_anchors (const ujson::jvalue& schema, const ujson::jpointer& location)
+{
+    if (schema.type() == ujson::j_array) {
+        for (size_t i=0; i<schema.size(); ++i) {
+            ujson::jpointer sub_location (location);
+            sub_location.push_back (std::to_string(i));
+            collect_anchors (schema[i], sub_location);
+        }
+    }
+    if (schema.type() != ujson::j_object)
+        return;
+
+    for (auto& member : schema.obj()) {
+        const string& name = member.first;
+        if (name == "$id" && !location.empty()) {
+            throw std::runtime_error (string("Subschema with keyword '$id' at '")
+                                      + location.str() + "' is not supported");
+        }
+        if (name == "$anchor" && member.second.type()==ujson::j_string)
+            anchors[string(member.second.str_view())] = &schema;
+        if (value_keywords.find(name) != value_keywords.end())
+            continue;
+        ujson::jpointer sub_location (location);
+        sub_location.push_back (name);
+        collect_anchors (member.second, sub_location);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+const ujson::jvalue& generator::resolve_ref (const string& ref, const ujson::jpointer& location)
+{
+    string fragment = ref;
+    if (!root_id.empty() && fragment.compare(0, root_id.size(), root_id) == 0)
+        fragment.erase (0, root_id.size());
+
+    if (fragment.empty() || fragment[0] != '#') {
+        throw std::runtime_error (string("Reference '") + ref + "' at '" + location.str()
+                                  + "' is not a reference within the schema");
+    }
+    fragment = uri_decode (fragment.substr(1));
+
+    if (fragment.empty())
+        return root;
+
+    if (fragment[0] == '/') {
+        auto& target = ujson::find_jvalue (root, ujson::jpointer(fragment));
+        if (target.valid())
+            return target;
+    }else{
+        auto entry = anchors.find (fragment);
+        if (entry != anchors.end())
+            return *entry->second;
+    }
+    throw std::runtime_error (string("Can't resolve reference '") + ref
+                              + "' at '" + location.str() + "'");
+}
+
+
+//------------------------------------------------------------------------------
+// Return an expression validating 'arg' using a subschema.
+//------------------------------------------------------------------------------
+string generator::call (const ujson::jvalue& schema, const string& arg, const ujson::jpointer& location)
+{
+    if (schema.type() == ujson::j_bool)
+        return schema.boolean() ? "true" : "false";
+
+    size_t index;
+    auto entry = function_index.find (&schema);
+    if (entry == function_index.end()) {
+        index = functions.size ();
+        function_index.emplace (&schema, index);
+        functions.emplace_back (&schema, location);
+    }else{
+        index = entry->second;
+    }
+    return string("schema_") + std::to_string(index) + " (" + arg + ")";
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+string generator::regex (const string& pattern)
+{
+    for (size_t i=0; i<patterns.size(); ++i) {
+        if (patterns[i] == pattern)
+            return string("regex_") + std::to_string(i);
+    }
+    patterns.emplace_back (pattern);
+    return string("regex_") + std::to_string(patterns.size()-1);
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+string generator::value (const ujson::jvalue& v)
+{
+    string json = v.describe ();
+    for (size_t i=0; i<values.size(); ++i) {
+        if (values[i] == json)
+            return string("value_") + std::to_string(i);
+    }
+    values.emplace_back (std::move(json));
+    return string("value_") + std::to_string(values.size()-1);
+}
+
+
+//------------------------------------------------------------------------------
+// Return an expression comparing the instance with a value.
+//------------------------------------------------------------------------------
+string generator::equals (const ujson::jvalue& v)
+{
+    switch (v.type()) {
+    case ujson::j_string:
+        return string("(type == ujson::j_string && instance.str_view() == ")
+            + cpp_string(v.str_view()) + ")";
+    case ujson::j_number:
+        return string("(type == ujson::j_number && instance.num() == ") + cpp_number(v) + ")";
+    case ujson::j_bool:
+        return string("(type == ujson::j_bool && instance.boolean() == ")
+            + (v.boolean() ? "true" : "false") + ")";
+    case ujson::j_null:
+        return "(type == ujson::j_null)";
+    default:
+        return string("(instance == ") + value(v) + ")";
+    }
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::gen_type (const ujson::jvalue& schema_value, std::ostream& out)
+{
+    std::vector<ujson::jvalue> names;
+    if (schema_value.type() == ujson::j_array)
+        names = schema_value.array ();
+    else
+        names.emplace_back (schema_value);
+
+    string condition;
+    for (auto& name : names) {
+        if (!condition.empty())
+            condition.append (" || ");
+        if (name.str_view() == "integer")
+            condition.append ("detail::is_integer (instance)");
+        else
+            condition.append (string("type == ujson::j_") + (name.str_view()=="boolean"
+                                                              ? string("bool")
+                                                              : string(name.str_view())));
+    }
+    out << "            if (!(" << condition << "))" << endl
+        << "                return false;" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::gen_numbers (const ujson::jvalue& schema, std::ostream& out)
+{
+    static const std::vector<std::pair<string, string>> bounds = {
+        {"minimum", ">="},
+        {"maximum", "<="},
+        {"exclusiveMinimum", ">"},
+        {"exclusiveMaximum", "<"},
+    };
+
+    std::ostringstream code;
+    for (auto& [keyword, op] : bounds) {
+        auto& bound = schema.get (keyword);
+        if (bound.type() == ujson::j_number) {
+            code << "                if (!(number " << op << ' ' << cpp_number(bound) << "))" << endl
+                 << "                    return false;" << endl;
+        }
+    }
+    auto& multiple_of = schema.get ("multipleOf");
+    if (multiple_of.type() == ujson::j_number) {
+        code << "                if (!detail::is_multiple_of (number, " << cpp_number(multiple_of) << "))" << endl
+             << "                    return false;" << endl;
+    }
+
+    if (code.str().empty())
+        return;
+    out << "            if (type == ujson::j_number) {" << endl
+        << "                double number = instance.num ();" << endl
+        << code.str()
+        << "            }" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::gen_strings (const ujson::jvalue& schema, std::ostream& out)
+{
+    auto& min_length = schema.get ("minLength");
+    auto& max_length = schema.get ("maxLength");
+    auto& pattern = schema.get ("pattern");
+    bool have_length = min_length.valid() || max_length.valid();
+
+    if (!have_length && !pattern.valid())
+        return;
+
+    out << "            if (type == ujson::j_string) {" << endl
+        << "                auto str = instance.str_view ();" << endl;
+    if (have_length)
+        out << "                size_t length = detail::utf8_length (str);" << endl;
+    if (min_length.valid()) {
+        out << "                if (length < " << (size_t)min_length.num() << "U)" << endl
+            << "                    return false;" << endl;
+    }
+    if (max_length.valid()) {
+        out << "                if (length > " << (size_t)max_length.num() << "U)" << endl
+            << "                    return false;" << endl;
+    }
+    if (pattern.valid()) {
+        out << "                if (!std::regex_search (str.begin(), str.end(), "
+            << regex(string(pattern.str_view())) << "))" << endl
+            << "                    return false;" << endl;
+    }
+    out << "            }" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::gen_arrays (const ujson::jvalue& schema, const ujson::jpointer& location, std::ostream& out)
+{
+    auto& min_items = schema.get ("minItems");
+    auto& max_items = schema.get ("maxItems");
+    auto& unique_items = schema.get ("uniqueItems");
+    auto& prefix_items = schema.get ("prefixItems");
+    auto& items = schema.get ("items");
+    auto& contains = schema.get ("contains");
+
+    std::ostringstream code;
+    if (min_items.valid()) {
+        code << "                if (array.size() < " << (size_t)min_items.num() << "U)" << endl
+             << "                    return false;" << endl;
+    }
+    if (max_items.valid()) {
+        code << "                if (array.size() > " << (size_t)max_items.num() << "U)" << endl
+             << "                    return false;" << endl;
+    }
+    if (unique_items.type()==ujson::j_bool && unique_items.boolean()) {
+        code << "                if (!detail::unique_items (array))" << endl
+             << "                    return false;" << endl;
+    }
+
+    size_t num_prefix_items = 0;
+    if (prefix_items.type() == ujson::j_array) {
+        num_prefix_items = prefix_items.size ();
+        for (size_t i=0; i<num_prefix_items; ++i) {
+            ujson::jpointer sub_location (location);
+            sub_location.push_back ("prefixItems");
+            sub_location.push_back (std::to_string(i));
+            string expr = call (prefix_items[i], string("array[") + std::to_string(i) + "]", sub_location);
+            if (expr == "true")
+                continue;
+            code << "                if (array.size() > " << i << "U && !(" << expr << "))" << endl
+                 << "                    return false;" << endl;
+        }
+    }
+
+    if (items.valid()) {
+        ujson::jpointer sub_location (location);
+        sub_location.push_back ("items");
+        string expr = call (items, "array[i]", sub_location);
+        if (expr == "false") {
+            code << "                if (array.size() > " << num_prefix_items << "U)" << endl
+                 << "                    return false;" << endl;
+        }
+        else if (expr != "true") {
+            code << "                for (size_t i=" << num_prefix_items << "; i<array.size(); ++i) {" << endl
+                 << "                    if (!(" << expr << "))" << endl
+                 << "                        return false;" << endl
+                 << "                }" << endl;
+        }
+    }
+
+    if (contains.valid()) {
+        auto& min_contains = schema.get ("minContains");
+        auto& max_contains = schema.get ("maxContains");
+        size_t min = min_contains.valid() ? (size_t)min_contains.num() : 1;
+
+        ujson::jpointer sub_location (location);
+        sub_location.push_back ("contains");
+        string expr = call (contains, "item", sub_location);
+
+        if (min > 0 || max_contains.valid()) {
+            code << "                {" << endl
+                 << "                    size_t matches = 0;" << endl
+                 << "                    for (auto& item : array) {" << endl
+                 << "                        if (" << expr << ") {" << endl
+                 << "                            ++matches;" << endl;
+            if (!max_contains.valid()) {
+                code << "                            if (matches >= " << min << "U)" << endl
+                     << "                                break;" << endl;
+            }
+            code << "                        }" << endl
+                 << "                    }" << endl;
+            if (min > 0) {
+                code << "                    if (matches < " << min << "U)" << endl
+                     << "                        return false;" << endl;
+            }
+            if (max_contains.valid()) {
+                code << "                    if (matches > " << (size_t)max_contains.num() << "U)" << endl
+                     << "                        return false;" << endl;
+            }
+            code << "                }" << endl;
+        }
+    }
+
+    if (code.str().empty())
+        return;
+    out << "            if (type == ujson::j_array) {" << endl
+        << "                auto& array = instance.array ();" << endl
+        << code.str()
+        << "            }" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::gen_objects (const ujson::jvalue& schema, const ujson::jpointer& location, std::ostream& out)
+{
+    auto& min_properties = schema.get ("minProperties");
+    auto& max_properties = schema.get ("maxProperties");
+    auto& required = schema.get ("required");
+    auto& dependent_required = schema.get ("dependentRequired");
+    auto& dependent_schemas = schema.get ("dependentSchemas");
+    auto& properties = schema.get ("properties");
+    auto& pattern_properties = schema.get ("patternProperties");
+    auto& additional_properties = schema.get ("additionalProperties");
+    auto& property_names = schema.get ("propertyNames");
+
+    auto sub_location = [&location] (const string& keyword, const string& name) {
+        ujson::jpointer ptr (location);
+        ptr.push_back (keyword);
+        if (!name.empty())
+            ptr.push_back (name);
+        return ptr;
+    };
+
+    std::ostringstream code;
+    if (min_properties.valid()) {
+        code << "                if (object.size() < " << (size_t)min_properties.num() << "U)" << endl
+             << "                    return false;" << endl;
+    }
+    if (max_properties.valid()) {
+        code << "                if (object.size() > " << (size_t)max_properties.num() << "U)" << endl
+             << "                    return false;" << endl;
+    }
+    if (required.type() == ujson::j_array) {
+        for (auto& name : required.array()) {
+            code << "                if (!instance.has (" << cpp_string(name.str_view()) << "))" << endl
+                 << "                    return false;" << endl;
+        }
+    }
+    if (dependent_required.type() == ujson::j_object) {
+        for (auto& member : dependent_required.obj()) {
+            const string& name = member.first;
+            if (member.second.array().empty())
+                continue;
+            code << "                if (instance.has (" << cpp_string(name) << ")) {" << endl;
+            for (auto& dependency : member.second.array()) {
+                code << "                    if (!instance.has (" << cpp_string(dependency.str_view()) << "))" << endl
+                     << "                        return false;" << endl;
+            }
+            code << "                }" << endl;
+        }
+    }
+    if (dependent_schemas.type() == ujson::j_object) {
+        for (auto& member : dependent_schemas.obj()) {
+            const string& name = member.first;
+            string expr = call (member.second, "instance", sub_location("dependentSchemas", name));
+            if (expr == "true")
+                continue;
+            code << "                if (instance.has (" << cpp_string(name) << ") && !(" << expr << "))" << endl
+                 << "                    return false;" << endl;
+        }
+    }
+
+    if (!pattern_properties.valid() && !additional_properties.valid()) {
+        // Look up each property by name
+        if (properties.type() == ujson::j_object) {
+            for (auto& member : properties.obj()) {
+                const string& name = member.first;
+                string expr = call (member.second, "value", sub_location("properties", name));
+                if (expr == "true")
+                    continue;
+                code << "                {" << endl
+                     << "                    auto& value = instance.get (" << cpp_string(name) << ");" << endl
+                     << "                    if (value.valid() && !(" << expr << "))" << endl
+                     << "                        return false;" << endl
+                     << "                }" << endl;
+            }
+        }
+    }
+
+    // Check all members in one pass when the schema of a member
+    // depends on patterns, or on the properties not listed
+    //
+    std::ostringstream member_code;
+    if (property_names.valid()) {
+        string expr = call (property_names, "ujson::jvalue (name)", sub_location("propertyNames", ""));
+        if (expr != "true") {
+            member_code << "                    if (!(" << expr << "))" << endl
+                        << "                        return false;" << endl;
+        }
+    }
+    if (pattern_properties.valid() || additional_properties.valid()) {
+        bool need_evaluated = additional_properties.valid();
+        if (need_evaluated)
+            member_code << "                    bool evaluated = false;" << endl;
+
+        if (properties.type() == ujson::j_object) {
+            bool first = true;
+            for (auto& member : properties.obj()) {
+                const string& name = member.first;
+                string expr = call (member.second, "value", sub_location("properties", name));
+                member_code << "                    " << (first ? "if" : "else if")
+                            << " (name == " << cpp_string(name) << ") {" << endl;
+                if (need_evaluated)
+                    member_code << "                        evaluated = true;" << endl;
+                if (expr != "true") {
+                    member_code << "                        if (!(" << expr << "))" << endl
+                                << "                            return false;" << endl;
+                }
+                member_code << "                    }" << endl;
+                first = false;
+            }
+        }
+        if (pattern_properties.type() == ujson::j_object) {
+            for (auto& member : pattern_properties.obj()) {
+                const string& pattern = member.first;
+                string expr = call (member.second, "value", sub_location("patternProperties", pattern));
+                member_code << "                    if (std::regex_search (name, " << regex(pattern) << ")) {" << endl;
+                if (need_evaluated)
+                    member_code << "                        evaluated = true;" << endl;
+                if (expr != "true") {
+                    member_code << "                        if (!(" << expr << "))" << endl
+                                << "                            return false;" << endl;
+                }
+                member_code << "                    }" << endl;
+            }
+        }
+        if (additional_properties.valid()) {
+            string expr = call (additional_properties, "value", sub_location("additionalProperties", ""));
+            if (expr != "true") {
+                member_code << "                    if (!evaluated && !(" << expr << "))" << endl
+                            << "                        return false;" << endl;
+            }
+        }
+    }
+    if (!member_code.str().empty()) {
+        code << "                for (auto& member : object) {" << endl
+             << "                    const std::string& name = member.first;" << endl
+             << "                    const ujson::jvalue& value = member.second;" << endl
+             << "                    (void) value;" << endl
+             << member_code.str()
+             << "                }" << endl;
+    }
+
+    if (code.str().empty())
+        return;
+    out << "            if (type == ujson::j_object) {" << endl
+        << "                auto& object = instance.obj ();" << endl
+        << "                (void) object;" << endl
+        << code.str()
+        << "            }" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::gen_function (size_t index, std::ostream& out)
+{
+    // Copy, 'functions' may grow while generating code
+    const ujson::jvalue& schema = *functions[index].first;
+    const ujson::jpointer location = functions[index].second;
+
+    out << "        // " << (location.empty() ? string("Root schema") : location.str()) << endl
+        << "        inline bool schema_" << index << " (const ujson::jvalue& instance)" << endl
+        << "        {" << endl;
+
+    if (schema.type() != ujson::j_object) {
+        out << "            return " << (schema.boolean() ? "true" : "false") << ';' << endl
+            << "        }" << endl;
+        return;
+    }
+
+    for (auto& member : schema.obj()) {
+        const string& name = member.first;
+        if (unsupported_keywords.find(name) != unsupported_keywords.end()) {
+            ujson::jpointer ptr (location);
+            ptr.push_back (name);
+            throw std::runtime_error (string("Keyword '") + name + "' at '"
+                                      + ptr.str() + "' is not supported");
+        }
+    }
+
+    auto sub_location = [&location] (const string& keyword, size_t i=(size_t)-1) {
+        ujson::jpointer ptr (location);
+        ptr.push_back (keyword);
+        if (i != (size_t)-1)
+            ptr.push_back (std::to_string(i));
+        return ptr;
+    };
+
+    out << "            auto type = instance.type ();" << endl
+        << "            (void) type;" << endl;
+
+    auto& type = schema.get ("type");
+    if (type.valid())
+        gen_type (type, out);
+
+    auto& const_value = schema.get ("const");
+    if (const_value.valid()) {
+        out << "            if (!" << equals(const_value) << ")" << endl
+            << "                return false;" << endl;
+    }
+
+    auto& enum_value = schema.get ("enum");
+    if (enum_value.type() == ujson::j_array) {
+        string condition;
+        for (auto& v : enum_value.array()) {
+            if (!condition.empty())
+                condition.append ("\n                  || ");
+            condition.append (equals(v));
+        }
+        out << "            if (!(" << condition << "))" << endl
+            << "                return false;" << endl;
+    }
+
+    auto& ref = schema.get ("$ref");
+    if (ref.type() == ujson::j_string) {
+        auto& target = resolve_ref (string(ref.str_view()), location);
+        string expr = call (target, "instance", sub_location("$ref"));
+        out << "            if (!(" << expr << "))" << endl
+            << "                return false;" << endl;
+    }
+
+    auto& all_of = schema.get ("allOf");
+    if (all_of.type() == ujson::j_array) {
+        for (size_t i=0; i<all_of.size(); ++i) {
+            out << "            if (!(" << call(all_of[i], "instance", sub_location("allOf", i)) << "))" << endl
+                << "                return false;" << endl;
+        }
+    }
+
+    auto& any_of = schema.get ("anyOf");
+    if (any_of.type() == ujson::j_array) {
+        string condition;
+        for (size_t i=0; i<any_of.size(); ++i) {
+            if (!condition.empty())
+                condition.append ("\n                  || ");
+            condition.append (call(any_of[i], "instance", sub_location("anyOf", i)));
+        }
+        out << "            if (!(" << condition << "))" << endl
+            << "                return false;" << endl;
+    }
+
+    auto& one_of = schema.get ("oneOf");
+    if (one_of.type() == ujson::j_array) {
+        out << "            {" << endl
+            << "                unsigned matches = 0;" << endl;
+        for (size_t i=0; i<one_of.size(); ++i) {
+            out << "                if (" << call(one_of[i], "instance", sub_location("oneOf", i))
+                << " && ++matches > 1)" << endl
+                << "                    return false;" << endl;
+        }
+        out << "                if (matches != 1)" << endl
+            << "                    return false;" << endl
+            << "            }" << endl;
+    }
+
+    auto& not_value = schema.get ("not");
+    if (not_value.valid()) {
+        out << "            if (" << call(not_value, "instance", sub_location("not")) << ")" << endl
+            << "                return false;" << endl;
+    }
+
+    auto& if_value = schema.get ("if");
+    if (if_value.valid()) {
+        auto& then_value = schema.get ("then");
+        auto& else_value = schema.get ("else");
+        if (then_value.valid() || else_value.valid()) {
+            string then_expr = "true";
+            string else_expr = "true";
+            string if_expr = call (if_value, "instance", sub_location("if"));
+            if (then_value.valid())
+                then_expr = call (then_value, "instance", sub_location("then"));
+            if (else_value.valid())
+                else_expr = call (else_value, "instance", sub_location("else"));
+            out << "            if (" << if_expr << ") {" << endl
+                << "                if (!(" << then_expr << "))" << endl
+                << "                    return false;" << endl
+                << "            }else{" << endl
+                << "                if (!(" << else_expr << "))" << endl
+                << "                    return false;" << endl
+                << "            }" << endl;
+        }
+    }
+
+    gen_numbers (schema, out);
+    gen_strings (schema, out);
+    gen_arrays (schema, location, out);
+    gen_objects (schema, location, out);
+
+    out << "            return true;" << endl
+        << "        }" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void generator::generate (std::ostream& out)
+{
+    // Generate all functions first, this collects
+    // the regular expressions and values used
+    //
+    call (root, "instance", ujson::jpointer());
+    std::vector<string> bodies;
+    for (size_t i=0; i<functions.size(); ++i) {
+        std::ostringstream body;
+        gen_function (i, body);
+        bodies.emplace_back (body.str());
+    }
+
+    string guard = args.name_space;
+    for (size_t pos; (pos=guard.find("::")) != string::npos; )
+        guard.replace (pos, 2, "_");
+    for (auto& ch : guard)
+        ch = std::toupper (ch);
+    guard.append ("_HPP");
+
+    string root_call = root.type()==ujson::j_bool
+        ? (root.boolean() ? string("true") : string("false"))
+        : string("detail::schema_0 (instance)");
+
+    out << "/*" << endl
+        << " * Generated by " << prog_name << ' ' << UJSON_VERSION_STRING
+        << " from '" << args.schema_file << "'. Do not edit." << endl
+        << " */" << endl
+        << "#ifndef " << guard << endl
+        << "#define " << guard << endl
+        << endl
+        << "#include <ujson.hpp>" << endl
+        << "#include <string>" << endl
+        << "#include <string_view>" << endl
+        << "#include <regex>" << endl
+        << "#include <unordered_map>" << endl
+        << "#include <cmath>" << endl
+        << endl
+        << endl
+        << "namespace " << args.name_space << " {" << endl
+        << endl
+        << "    namespace detail {" << endl
+        << endl
+        << "        inline size_t utf8_length (std::string_view str)" << endl
+        << "        {" << endl
+        << "            size_t length = 0;" << endl
+        << "            for (unsigned char ch : str) {" << endl
+        << "                if ((ch & 0xc0) != 0x80)" << endl
+        << "                    ++length;" << endl
+        << "            }" << endl
+        << "            return length;" << endl
+        << "        }" << endl
+        << endl
+        << "        inline bool is_integer (const ujson::jvalue& instance)" << endl
+        << "        {" << endl
+        << "            if (instance.type() != ujson::j_number)" << endl
+        << "                return false;" << endl
+        << "            double number = instance.num ();" << endl
+        << "            return std::isfinite(number) && number == std::floor(number);" << endl
+        << "        }" << endl
+        << endl
+        << "        inline bool is_multiple_of (double number, double divisor)" << endl
+        << "        {" << endl
+        << "            double quotient = number / divisor;" << endl
+        << "            return std::isfinite(quotient) && quotient == std::floor(quotient);" << endl
+        << "        }" << endl
+        << endl
+        << "        inline bool unique_items (const ujson::json_array& array)" << endl
+        << "        {" << endl
+        << "            std::unordered_multimap<size_t, const ujson::jvalue*> seen;" << endl
+        << "            for (auto& item : array) {" << endl
+        << "                auto hash = item.hash ();" << endl
+        << "                auto range = seen.equal_range (hash);" << endl
+        << "                for (auto i=range.first; i!=range.second; ++i) {" << endl
+        << "                    if (*i->second == item)" << endl
+        << "                        return false;" << endl
+        << "                }" << endl
+        << "                seen.emplace (hash, &item);" << endl
+        << "            }" << endl
+        << "            return true;" << endl
+        << "        }" << endl
+        << endl
+        << "        inline ujson::jvalue parse (const char* json)" << endl
+        << "        {" << endl
+        << "            ujson::jparser parser;" << endl
+        << "            return parser.parse_string (json, true);" << endl
+        << "        }" << endl
+        << endl;
+
+    // Regular expressions and values are created when the program starts
+    //
+    for (size_t i=0; i<patterns.size(); ++i) {
+        out << "        inline const std::regex regex_" << i << " (" << cpp_string(patterns[i])
+            << ", std::regex::ECMAScript);" << endl;
+    }
+    for (size_t i=0; i<values.size(); ++i)
+        out << "        inline const ujson::jvalue value_" << i << " = parse (" << cpp_string(values[i]) << ");" << endl;
+    if (!patterns.empty() || !values.empty())
+        out << endl;
+
+    for (size_t i=0; i<functions.size(); ++i)
+        out << "        inline bool schema_" << i << " (const ujson::jvalue& instance);" << endl;
+    out << endl;
+
+    for (auto& body : bodies)
+        out << endl << body;
+
+    out << "    }" << endl
+        << endl
+        << endl
+        << "    /**" << endl
+        << "     * Validate a JSON instance." << endl
+        << "     * @param instance The JSON instance to validate." << endl
+        << "     * @return <code>true</code> if the instance was successfully validated." << endl
+        << "     */" << endl
+        << "    inline bool " << args.function << " (const ujson::jvalue& instance)" << endl
+        << "    {" << endl
+        << "        return " << root_call << ';' << endl
+        << "    }" << endl
+        << endl
+        << endl
+        << "}" << endl
+        << "#endif" << endl;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+int main (int argc, char* argv[])
+{
+    appargs_t args;
+    parse_args (argc, argv, args);
+
+    ujson::jparser parser;
+    auto schema_def = parser.parse_file (args.schema_file, args.strict);
+    if (schema_def.invalid()) {
+        auto err = parser.get_error ();
+        if (err.code == ujson::jparser::err::io) {
+            cerr << "Error: Can't read schema file '" << args.schema_file << "'" << endl;
+        }else{
+            cerr << "Error: Parse error in schema file '" << args.schema_file << "' at "
+                 << (err.row+1) << ", " << err.col << ": " << parser_err_to_str(err.code) << endl;
+        }
+        exit (1);
+    }
+
+    // Check that it is a valid schema
+    try {
+        ujson::jschema schema (schema_def);
+    }
+    catch (ujson::invalid_schema& is) {
+        cerr << "Error: Schema file '" << args.schema_file << "' is not a valid schema: "
+             << is.what() << endl;
+        exit (1);
+    }
+
+    std::ostringstream code;
+    try {
+        generator gen (schema_def, args);
+        gen.generate (code);
+    }
+    catch (std::exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        exit (1);
+    }
+
+    if (args.output.empty()) {
+        cout << code.str ();
+    }else{
+        std::ofstream ofs (args.output);
+        ofs << code.str ();
+        ofs.close ();
+        if (!ofs) {
+            cerr << "Error: Can't write file '" << args.output << "'" << endl;
+            exit (1);
+        }
+    }
+
+    return 0;
+}
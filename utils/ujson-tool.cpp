@@ -37,6 +37,7 @@ static constexpr const int opt_id_sort      = 1001;
 static constexpr const int opt_id_max_depth = 1002;
 static constexpr const int opt_id_max_asize = 1003;
 static constexpr const int opt_id_max_osize = 1004;
+static constexpr const int opt_id_atomic    = 1005;
 static const char* fmt_normal = "";
 static const char* fmt_bold = "";
 
@@ -56,6 +57,7 @@ struct appargs_t {
     bool quiet;
     bool debug;
     bool full_validation;
+    bool atomic_patch;
     unsigned max_depth;
     unsigned max_asize;
     unsigned max_osize;
@@ -71,6 +73,7 @@ struct appargs_t {
         quiet = false;
         debug = false;
         full_validation = false;
+        atomic_patch = false;
         max_depth = 0;
         max_asize = 0;
         max_osize = 0;
@@ -168,6 +171,9 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
     out << "      -q, --quiet  Don't print failed patch operations to standard error, only return 1." << endl;
     out << "                   Also, if all patch operations are of type 'test', don't print the" << endl;
     out << "                   resulting JSON document to standard output." << endl;
+    out << "      --atomic     Apply all patch operations, or none. The patch operations after" << endl;
+    out << "                   a failed operation are not tried, and the JSON document is printed" << endl;
+    out << "                   unchanged." << endl;
     out << endl;
     out << fmt_bold << "  verify [OPTIONS] [JSON_DOCUMENT]" << fmt_normal << endl;
     out << "    Verify the syntax of the JSON document." << endl;
@@ -219,6 +225,7 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         { '\0', "max-depth",      opt_t::required, opt_id_max_depth},
         { '\0', "max-asize",      opt_t::required, opt_id_max_asize},
         { '\0', "max-osize",      opt_t::required, opt_id_max_osize},
+        { '\0', "atomic",         opt_t::none,     opt_id_atomic},
         { 'v',  "version",        opt_t::none,     0},
         { 'h',  "help",           opt_t::none,     0},
     };
@@ -319,6 +326,10 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
             args.max_osize = atoi (opt.optarg().c_str());
             break;
 
+        case opt_id_atomic:
+            args.atomic_patch = true;
+            break;
+
         case 'v':
             std::cout << prog_name << ' ' << UJSON_VERSION_STRING << std::endl;
             exit (0);
@@ -391,7 +402,8 @@ static ujson::jvalue get_instance (appargs_t& opt, const bool quiet=false)
             cerr << "Pointer error: No such item" << endl;
         return ujson::jvalue (ujson::j_invalid);
     }
-    return instance;
+    // The rest of the document isn't used, move the instance out of it
+    return std::move (instance);
 }
 
 
@@ -414,10 +426,12 @@ static int cmd_view (appargs_t& opt)
         return 1;
     }
 
-    if (instance.is_string() && opt.print_unescaped_string)
+    if (instance.is_string() && opt.print_unescaped_string) {
         cout << instance.str() << endl;
-    else
-        cout << instance.describe(opt.fmt) << endl;
+    }else{
+        instance.write (cout, opt.fmt);
+        cout << endl;
+    }
 
     return 0;
 }
@@ -613,13 +627,14 @@ static int cmd_members (appargs_t& opt)
     auto attrib     = (opt.fmt & fmt::fmt_sorted) ? jobj.sbegin() : jobj.begin();
     auto attrib_end = (opt.fmt & fmt::fmt_sorted) ? jobj.send()   : jobj.end();
     for (; attrib!=attrib_end; ++attrib) {
+        const std::string& name = attrib->first;
         if (opt.members_as_json_array) {
-            result_array.append (attrib->first);
+            result_array.append (name);
         }else{
             if (opt.members_escape)
-                cout << "\"" << ujson::escape(attrib->first) << "\"" << endl;
+                cout << "\"" << ujson::escape(name) << "\"" << endl;
             else
-                cout << attrib->first << endl;
+                cout << name << endl;
         }
     }
 
@@ -670,12 +685,14 @@ static int cmd_patch (appargs_t& opt)
 
     // Patch the instance
     //
-    auto result = ujson::patch (instance, patch);
+    auto result = opt.atomic_patch ?
+        ujson::patch_atomic (instance, patch) :
+        ujson::patch (instance, patch);
 
     bool only_test_ops = false;
     if (opt.quiet != true) {
-        auto num_patches = result.second.size ();
-        for (unsigned i=0; i<num_patches; ++i) {
+        auto num_patches = patch.is_array() ? patch.size() : 1;
+        for (unsigned i=0; i<result.second.size(); ++i) {
             if (result.second[i] == ujson::patch_ok)
                 continue;
             cerr << "Patch " << (i+1) << " of " << num_patches << " - ";
@@ -715,8 +732,10 @@ static int cmd_patch (appargs_t& opt)
 
     // Print the patched json instance
     //
-    if (!opt.quiet || !only_test_ops)
-        cout << instance.describe(opt.fmt) << endl;
+    if (!opt.quiet || !only_test_ops) {
+        instance.write (cout, opt.fmt);
+        cout << endl;
+    }
 
     return result.first ? 0 : 1;
 }
@@ -18,9 +18,15 @@
  */
 #include <ujson.hpp>
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+#include <system_error>
 #include <stdexcept>
 #include <cstdlib>
 #include <cstdint>
@@ -39,6 +45,9 @@ using std::string;
 
 static constexpr const char* prog_name = "ujson-verify";
 
+// Validation statistics, with option --profile
+static ujson::schema::validation_profile profile;
+
 struct appargs_t {
     std::vector<string> files;
     std::vector<string> schema_files;
@@ -50,6 +59,12 @@ struct appargs_t {
     bool quiet;
     bool verbose;
     bool full_validation;
+    bool mmap;
+    bool lines;
+    bool profile;
+    bool binary;
+    bool batch;
+    unsigned jobs;
 
     appargs_t() {
         max_depth = max_array_size = max_obj_size = 0;
@@ -58,6 +73,12 @@ struct appargs_t {
         quiet = false;
         verbose = false;
         full_validation = false;
+        mmap = false;
+        lines = false;
+        profile = false;
+        binary = false;
+        batch = false;
+        jobs = 1;
     }
 };
 
@@ -83,9 +104,37 @@ static void print_usage_and_exit (std::ostream& out, int exit_code)
         << "                            show all failed validation tests, not only the first." << endl
         << "  -s, --strict              Parse JSON documents in strict mode." << endl
         << "  -n, --no-duplicates       Don't allow objects with duplicate member names." << endl
+        << "  -l, --lines               Each line in the input is a separate JSON document (NDJSON/JSON Lines)." << endl
+        << "                            Errors are reported for each failing line, and 'ok' is printed" << endl
+        << "                            once if all lines are successfully verified." << endl
+        << "  -j, --jobs=N              Parse using N threads. With option '-b,--batch', N files are" << endl
+        << "                            verified in parallel. With option '-l,--lines', the lines are" << endl
+        << "                            parsed in parallel. Otherwise the elements of large top level" << endl
+        << "                            arrays and objects are parsed in parallel. With a JSON schema," << endl
+        << "                            the elements of large arrays and objects are also validated" << endl
+        << "                            in parallel." << endl
+        << "                            If N is 0, use the number of available CPU cores. Default is 1." << endl
         << "      --max-depth=DEPTH     Set maximum nesting depth." << endl
         << "      --max-asize=ITEMS     Set the maximum allowed number of elements in a single JSON array." << endl
         << "      --max-osize=ITEMS     Set the maximum allowed number of members in a single JSON object." << endl
+        << "      --mmap                Memory map input files instead of reading them into a buffer." << endl
+        << "                            Standard input and non-regular files are always read into a buffer." << endl
+        << "      --binary              The documents are CBOR (RFC 8949) data items instead of JSON text." << endl
+        << "                            With option '-l,--lines', the input is a CBOR sequence (RFC 8742)," << endl
+        << "                            and each data item is a separate document. Options '-s,--strict'," << endl
+        << "                            '--max-depth', '--max-asize', '--max-osize' and '--mmap' are ignored." << endl
+        << "  -b, --batch               Verify many files using a pool of worker threads, see option" << endl
+        << "                            '-j,--jobs'. The schema is loaded once and shared by the workers." << endl
+        << "                            Directories given as FILE are searched recursively for files." << endl
+        << "                            If no FILE is given, the file names are read from standard input," << endl
+        << "                            one per line. The result of each file is printed as a JSON object" << endl
+        << "                            on a separate line (NDJSON), in the order the files are verified." << endl
+        << "                            This option can't be used together with option '-l,--lines'." << endl
+        << "      --profile             When a JSON schema is used, print a JSON object with statistics" << endl
+        << "                            of the validation when all documents are verified. For each" << endl
+        << "                            keyword location in the schema, the number of evaluations," << endl
+        << "                            successful and failed evaluations, and the total time in seconds." << endl
+        << "                            The statistics are printed also in silent mode." << endl
         << "  -v, --version             Print version and exit." << endl
         << "  -h, --help                Print this help message and exit." << endl
         << endl;
@@ -105,9 +154,15 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         { 'r',  "relaxed",       opt_t::none,        0},
         { 's',  "strict",        opt_t::none,        0},
         { 'n',  "no-duplicates", opt_t::none,        0},
+        { 'l',  "lines",         opt_t::none,        0},
+        { 'j',  "jobs",          opt_t::required,    0},
+        { 'b',  "batch",         opt_t::none,        0},
         { '\0', "max-depth",     opt_t::required, 1000},
         { '\0', "max-asize",     opt_t::required, 1001},
         { '\0', "max-osize",     opt_t::required, 1002},
+        { '\0', "mmap",          opt_t::none,     1003},
+        { '\0', "profile",       opt_t::none,     1004},
+        { '\0', "binary",        opt_t::none,     1005},
         { 'v',  "version",       opt_t::none,        0},
         { 'h',  "help",          opt_t::none,        0},
     };
@@ -136,6 +191,15 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         case 'n':
             args.allow_duplicates = false;
             break;
+        case 'l':
+            args.lines = true;
+            break;
+        case 'j':
+            args.jobs = atoi (opt.optarg().c_str());
+            break;
+        case 'b':
+            args.batch = true;
+            break;
         case 1000: // --max-depth
             args.max_depth = atoi (opt.optarg().c_str());
             break;
@@ -145,6 +209,15 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         case 1002: // --max-object-size
             args.max_obj_size = atoi (opt.optarg().c_str());
             break;
+        case 1003: // --mmap
+            args.mmap = true;
+            break;
+        case 1004: // --profile
+            args.profile = true;
+            break;
+        case 1005: // --binary
+            args.binary = true;
+            break;
         case 'v':
             std::cout << prog_name << ' ' << UJSON_VERSION_STRING << std::endl;
             exit (0);
@@ -162,6 +235,217 @@ static void parse_args (int argc, char* argv[], appargs_t& args)
         if (argument.empty() == false)
             args.files.emplace_back (argument);
     }
+    if (args.batch && args.lines) {
+        cerr << "Option '-b,--batch' can't be used together with option '-l,--lines'" << endl;
+        exit (1);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Read a file or standard input. Compressed input is decompressed.
+//------------------------------------------------------------------------------
+static string read_document (const std::string& filename)
+{
+    std::unique_ptr<ujson::jdecompressor> in;
+    if (filename.empty())
+        in = std::make_unique<ujson::jdecompressor> (STDIN_FILENO);
+    else
+        in = std::make_unique<ujson::jdecompressor> (filename);
+
+    string json_document;
+    const char* data;
+    size_t size;
+    while (in->next(data, size))
+        json_document.append (data, size);
+    if (!in->error().empty()) {
+        if (filename.empty())
+            cerr << "Error reading input: " << in->error() << endl;
+        else
+            cerr << "Error reading file '" << filename << "': " << in->error() << endl;
+        exit (1);
+    }
+    return json_document;
+}
+
+
+//------------------------------------------------------------------------------
+// Validate a parsed instance using a schema and print an error
+// message on failure. Return 0 if successfully validated.
+//------------------------------------------------------------------------------
+static int validate_instance (ujson::jvalue& instance,
+                              const std::string& log_prefix,
+                              ujson::jschema& schema,
+                              ujson::jvalue& result,
+                              const appargs_t& args)
+{
+    try {
+        bool valid;
+        if (args.verbose) {
+            // Create an output unit to print
+            if (args.profile)
+                result = schema.validate (instance, !args.full_validation, profile);
+            else
+                result = schema.validate (instance, !args.full_validation);
+            valid = result["valid"].boolean ();
+        }else{
+            valid = args.profile ? schema.is_valid(instance, profile) : schema.is_valid(instance);
+        }
+        if (!valid) {
+            if (args.quiet)
+                return 1;
+
+            if (!args.verbose) {
+                cout << log_prefix << "Schema not successfully validated" << endl;
+            }else{
+                cout << log_prefix << "Validation error: " << endl;
+#if (UJSON_HAS_CONSOLE_COLOR)
+                if (isatty(fileno(stdout)))
+                    cout << result.describe(ujson::fmt_pretty | ujson::fmt_color) << endl;
+                else
+#endif
+                    cout << result.describe(ujson::fmt_pretty) << endl;
+                cout << endl;
+            }
+            return 1;
+        }
+    }
+    catch (ujson::invalid_schema& is) {
+        cerr << "Schema error   : " << is.what() << endl;
+        if (args.verbose) {
+            if (!is.base_uri.empty())
+                cerr << "Base URI: " << is.base_uri << endl;
+            if (!is.pointer.empty())
+                cerr << "Pointer : " << is.pointer << endl;
+        }
+        exit (1);
+    }
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+static void print_parse_error (const std::string& log_prefix,
+                               const ujson::jparser::error_t& err,
+                               const appargs_t& args)
+{
+    if (!args.quiet) {
+        cout << log_prefix << "Error at line " << (err.row+1) << ", column " << err.col
+             << ": " << parser_err_to_str(err.code) << endl;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Verify each line in the input as a separate JSON document.
+//------------------------------------------------------------------------------
+static int verify_lines (const std::string& filename,
+                         const std::string& log_filename,
+                         ujson::jparser& parser,
+                         ujson::jschema& schema,
+                         bool use_schema,
+                         const appargs_t& args)
+{
+    int retval = 0;
+    ujson::jvalue result;
+
+    auto verify_line = [&] (unsigned line, ujson::jvalue& instance, const ujson::jparser::error_t& err) {
+        if (err.code != ujson::jparser::err::ok) {
+            print_parse_error (log_filename, err, args);
+            retval = 1;
+        }
+        else if (use_schema) {
+            std::string log_prefix = log_filename;
+            log_prefix.append ("line ");
+            log_prefix.append (std::to_string(line+1));
+            log_prefix.append (": ");
+            if (validate_instance(instance, log_prefix, schema, result, args))
+                retval = 1;
+        }
+        return true;
+    };
+
+    // Let the parser memory map the file, or read it into a buffer
+    bool mapped = args.mmap && !filename.empty();
+    std::string buffer;
+    if (!mapped)
+        buffer = read_document (filename);
+
+    bool io_error = false;
+    if (args.jobs != 1) {
+        // Parse the lines in parallel, and verify them in line order
+        if (mapped) {
+            parser.parse_lines_file (filename, verify_line,
+                                     args.strict, args.allow_duplicates, args.jobs);
+            io_error = parser.get_error().code == ujson::jparser::err::io;
+        }else{
+            parser.parse_lines (buffer.data(), buffer.size(), verify_line,
+                                args.strict, args.allow_duplicates, args.jobs);
+        }
+    }else{
+        if (mapped)
+            io_error = !parser.begin_lines_file (filename, args.strict, args.allow_duplicates);
+        else
+            parser.begin_lines (buffer.data(), buffer.size(), args.strict, args.allow_duplicates);
+
+        ujson::jvalue instance;
+        while (!io_error && parser.next_line(instance))
+            verify_line (parser.line(), instance, parser.get_error());
+    }
+    if (io_error) {
+        cerr << "Error reading file '" << filename << "'" << endl;
+        exit (1);
+    }
+
+    if (!retval && !args.quiet)
+        cout << log_filename << "ok" << endl;
+
+    return retval;
+}
+
+
+//------------------------------------------------------------------------------
+// Verify each data item in a CBOR sequence as a separate JSON document.
+//------------------------------------------------------------------------------
+static int verify_cbor_sequence (const std::string& filename,
+                                 const std::string& log_filename,
+                                 ujson::jschema& schema,
+                                 bool use_schema,
+                                 const appargs_t& args)
+{
+    int retval = 0;
+    ujson::jvalue result;
+    auto buffer = read_document (filename);
+
+    size_t pos = 0;
+    for (unsigned item=0; pos<buffer.size(); ++item) {
+        std::string log_prefix = log_filename;
+        log_prefix.append ("item ");
+        log_prefix.append (std::to_string(item+1));
+        log_prefix.append (": ");
+
+        ujson::jvalue instance;
+        try {
+            size_t length;
+            instance = ujson::from_cbor (buffer.data()+pos, buffer.size()-pos,
+                                         length, args.allow_duplicates);
+            pos += length;
+        }
+        catch (std::invalid_argument& e) {
+            // The rest of the sequence can't be decoded
+            if (!args.quiet)
+                cout << log_prefix << e.what() << endl;
+            return 1;
+        }
+        if (use_schema  &&  validate_instance(instance, log_prefix, schema, result, args))
+            retval = 1;
+    }
+
+    if (!retval && !args.quiet)
+        cout << log_filename << "ok" << endl;
+
+    return retval;
 }
 
 
@@ -179,74 +463,43 @@ static int verify_document (const std::string& filename,
         log_filename.append (": ");
     }
 
-    // Read json file
-    //
-    string json_document;
-    try {
-        std::ifstream ifs;
-        ifs.exceptions (std::ifstream::failbit);
-        if (!filename.empty())
-            ifs.open (filename);
-        std::istream& in = filename.empty() ? std::cin : ifs;
-        in.exceptions (std::ifstream::failbit);
-        json_document = string ((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-    }
-    catch (std::ios_base::failure& io_error) {
-        if (filename.empty())
-            cerr << "Error reading input: " << io_error.code().message() << endl;
-        else
-            cerr << "Error reading file '" << filename << "': " << io_error.code().message() << endl;
-        exit (1);
-    }
+    if (args.lines && args.binary)
+        return verify_cbor_sequence (filename, log_filename, schema, use_schema, args);
+    if (args.lines)
+        return verify_lines (filename, log_filename, parser, schema, use_schema, args);
 
     // Parse file and check result
-    auto instance = parser.parse_string (json_document, args.strict, args.allow_duplicates);
-    if (!instance.valid()) {
-        if (!args.quiet) {
-            auto err = parser.get_error ();
-            cout << log_filename << "Error at line " << (err.row+1) << ", column " << err.col
-                 << ": " << parser_err_to_str(err.code) << endl;
+    ujson::jvalue instance;
+    if (args.binary) {
+        try {
+            auto buffer = read_document (filename);
+            instance = ujson::from_cbor (buffer.data(), buffer.size(), args.allow_duplicates);
+        }
+        catch (std::invalid_argument& e) {
+            if (!args.quiet)
+                cout << log_filename << e.what() << endl;
+            return 1;
         }
+    }else if (args.mmap && !filename.empty()) {
+        // Let the parser memory map the file
+        instance = parser.parse_file (filename, args.strict, args.allow_duplicates);
+        if (instance.invalid() && parser.get_error().code==ujson::jparser::err::io) {
+            cerr << "Error reading file '" << filename << "'" << endl;
+            exit (1);
+        }
+    }else{
+        instance = parser.parse_string (read_document(filename), args.strict, args.allow_duplicates);
+    }
+    if (!instance.valid()) {
+        print_parse_error (log_filename, parser.get_error(), args);
         return 1;
     }
 
     ujson::jvalue result;
 
     if (use_schema) {
-        try {
-            bool fast_validation = true;
-            if (args.verbose && args.full_validation)
-                fast_validation = false;
-            result = schema.validate (instance, fast_validation);
-            if (result["valid"] == false) {
-                if (args.quiet)
-                    return 1;
-
-                if (!args.verbose) {
-                    cout << log_filename << "Schema not successfully validated" << endl;
-                }else{
-                    cout << log_filename << "Validation error: " << endl;
-#if (UJSON_HAS_CONSOLE_COLOR)
-                    if (isatty(fileno(stdout)))
-                        cout << result.describe(ujson::fmt_pretty | ujson::fmt_color) << endl;
-                    else
-#endif
-                        cout << result.describe(ujson::fmt_pretty) << endl;
-                    cout << endl;
-                }
-                return 1;
-            }
-        }
-        catch (ujson::invalid_schema& is) {
-            cerr << "Schema error   : " << is.what() << endl;
-            if (args.verbose) {
-                if (!is.base_uri.empty())
-                    cerr << "Base URI: " << is.base_uri << endl;
-                if (!is.pointer.empty())
-                    cerr << "Pointer : " << is.pointer << endl;
-            }
-            exit (1);
-        }
+        if (validate_instance(instance, log_filename, schema, result, args))
+            return 1;
     }
 
     if (!args.quiet) {
@@ -312,6 +565,174 @@ static bool load_schema (ujson::jparser& parser, ujson::jschema& schema, const a
 }
 
 
+//------------------------------------------------------------------------------
+// Find the files to verify in batch mode. Directories are searched
+// recursively, and without files the names are read from stdin.
+//------------------------------------------------------------------------------
+static std::vector<string> find_batch_files (const appargs_t& args)
+{
+    namespace fs = std::filesystem;
+    std::vector<string> files;
+
+    if (args.files.empty()) {
+        string line;
+        while (std::getline(std::cin, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back ();
+            if (!line.empty())
+                files.emplace_back (std::move(line));
+        }
+        return files;
+    }
+
+    for (auto& name : args.files) {
+        std::error_code ec;
+        if (!fs::is_directory(name, ec)) {
+            files.emplace_back (name);
+            continue;
+        }
+        std::vector<string> dir_files;
+        fs::recursive_directory_iterator i (name, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && i!=fs::recursive_directory_iterator(); i.increment(ec)) {
+            if (i->is_regular_file(ec))
+                dir_files.emplace_back (i->path().string());
+        }
+        if (ec) {
+            cerr << "Error reading directory '" << name << "': " << ec.message() << endl;
+            exit (1);
+        }
+        std::sort (dir_files.begin(), dir_files.end());
+        files.insert (files.end(), dir_files.begin(), dir_files.end());
+    }
+    return files;
+}
+
+
+//------------------------------------------------------------------------------
+// Verify a file in batch mode and return the result as a JSON object.
+//------------------------------------------------------------------------------
+static ujson::jvalue verify_batch_file (const std::string& filename,
+                                        ujson::jparser& parser,
+                                        ujson::jschema& schema,
+                                        bool use_schema,
+                                        const appargs_t& args)
+{
+    ujson::jvalue result (ujson::j_object);
+    result["file"] = filename;
+    result["valid"] = false;
+
+    ujson::jvalue instance;
+    if (args.binary) {
+        ujson::jdecompressor in (filename);
+        string buffer;
+        const char* data;
+        size_t size;
+        while (in.next(data, size))
+            buffer.append (data, size);
+        if (!in.error().empty()) {
+            result["error"] = "Error reading file";
+            return result;
+        }
+        try {
+            instance = ujson::from_cbor (buffer.data(), buffer.size(), args.allow_duplicates);
+        }
+        catch (std::invalid_argument& e) {
+            result["error"] = e.what ();
+            return result;
+        }
+    }else{
+        instance = parser.parse_file (filename, args.strict, args.allow_duplicates);
+        if (instance.invalid()) {
+            auto err = parser.get_error ();
+            if (err.code == ujson::jparser::err::io) {
+                result["error"] = "Error reading file";
+            }else{
+                result["error"] = parser_err_to_str (err.code);
+                result["line"] = (long) err.row + 1;
+                result["column"] = (long) err.col;
+            }
+            return result;
+        }
+    }
+
+    if (use_schema) {
+        try {
+            if (args.verbose) {
+                auto output = args.profile ?
+                    schema.validate (instance, !args.full_validation, profile) :
+                    schema.validate (instance, !args.full_validation);
+                if (!output["valid"].boolean()) {
+                    result["error"] = "Schema not successfully validated";
+                    result["validation"] = std::move (output);
+                    return result;
+                }
+            }else{
+                bool valid = args.profile ? schema.is_valid(instance, profile) : schema.is_valid(instance);
+                if (!valid) {
+                    result["error"] = "Schema not successfully validated";
+                    return result;
+                }
+            }
+        }
+        catch (ujson::invalid_schema& is) {
+            result["error"] = string("Schema error: ") + is.what();
+            return result;
+        }
+    }
+
+    result["valid"] = true;
+    return result;
+}
+
+
+//------------------------------------------------------------------------------
+// Verify many files using a pool of worker threads. Each worker has
+// its own parser, and all workers share the loaded schema.
+//------------------------------------------------------------------------------
+static int verify_batch (ujson::jschema& schema, bool use_schema, const appargs_t& args)
+{
+    auto files = find_batch_files (args);
+
+    unsigned num_workers = args.jobs ? args.jobs : std::thread::hardware_concurrency ();
+    num_workers = std::max (1u, std::min(num_workers, (unsigned)files.size()));
+
+    std::atomic<size_t> next_file (0);
+    std::atomic<bool> failed (false);
+    std::mutex out_mutex;
+
+    auto worker = [&] () {
+        ujson::jparser parser (args.max_depth,
+                               args.max_array_size,
+                               args.max_obj_size);
+        parser.synchronized (false);
+        string line;
+        size_t i;
+        while ((i=next_file++) < files.size()) {
+            auto result = verify_batch_file (files[i], parser, schema, use_schema, args);
+            if (!result["valid"].boolean())
+                failed = true;
+            if (args.quiet)
+                continue;
+            line.clear ();
+            result.write (line);
+            line.push_back ('\n');
+            std::lock_guard<std::mutex> lock (out_mutex);
+            cout.write (line.data(), line.size());
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i=1; i<num_workers; ++i)
+        threads.emplace_back (worker);
+    worker ();
+    for (auto& t : threads)
+        t.join ();
+    cout.flush ();
+
+    return failed ? 1 : 0;
+}
+
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 int main (int argc, char* argv[])
@@ -323,18 +744,36 @@ int main (int argc, char* argv[])
                            args.max_array_size,
                            args.max_obj_size);
     ujson::jschema schema;
+    if (!args.batch) {
+        // In batch mode the files are verified in parallel instead
+        parser.threads (args.jobs);
+        schema.threads (args.jobs);
+    }
 
-    if (args.files.empty())
+    if (args.files.empty() && !args.batch)
         args.files.emplace_back (""); // Parse standard input
 
     bool use_schema = load_schema (parser, schema, args);
 
     int retval = 0;
-    for (auto& filename : args.files) {
-        if (verify_document(filename, parser, schema, use_schema, args)) {
-            retval = 1;
+    if (args.batch) {
+        retval = verify_batch (schema, use_schema, args);
+    }else{
+        for (auto& filename : args.files) {
+            if (verify_document(filename, parser, schema, use_schema, args)) {
+                retval = 1;
+            }
         }
     }
 
+    if (args.profile && use_schema) {
+#if (UJSON_HAS_CONSOLE_COLOR)
+        if (isatty(fileno(stdout)))
+            cout << profile.report().describe(ujson::fmt_pretty | ujson::fmt_color) << endl;
+        else
+#endif
+            cout << profile.report().describe(ujson::fmt_pretty) << endl;
+    }
+
     return retval;
 }